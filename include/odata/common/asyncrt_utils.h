@@ -120,6 +120,65 @@ namespace conversions
     /// </summary>
     ODATACPP_API std::vector<unsigned char> __cdecl from_base64(const utility::string_t& str);
 
+    /// <summary>
+    /// Encode the given bytes as base64 and append the text to output
+    /// </summary>
+    ODATACPP_API void __cdecl to_base64(const unsigned char* data, size_t size, utility::string_t& output);
+
+    /// <summary>
+    /// Decode the given base64 text into output, which must have room for size / 4 * 3 bytes; returns the number of bytes written
+    /// </summary>
+    ODATACPP_API size_t __cdecl from_base64(const utility::char_t* text, size_t size, unsigned char* output);
+
+    /// <summary>
+    /// Encodes bytes that arrive in chunks, appending base64 text to a string as it goes.
+    /// The text does not depend on how the bytes were split; finish writes the padding.
+    /// </summary>
+    class base64_encoder
+    {
+    public:
+        base64_encoder(utility::string_t& output) : m_output(output), m_pending_size(0)
+        {
+        }
+
+        ODATACPP_API void write(const unsigned char* data, size_t size);
+        ODATACPP_API void finish();
+
+    private:
+        base64_encoder(const base64_encoder&);
+        base64_encoder& operator=(const base64_encoder&);
+
+        utility::string_t& m_output;
+        unsigned char m_pending[2];
+        size_t m_pending_size;
+    };
+
+    /// <summary>
+    /// Decodes base64 text that arrives in chunks, appending the bytes to a vector as it goes.
+    /// Invalid text throws std::runtime_error as soon as it is seen; finish checks that the text ended on a whole group.
+    /// </summary>
+    class base64_decoder
+    {
+    public:
+        base64_decoder(std::vector<unsigned char>& output) : m_output(output), m_pending_size(0), m_padded(false)
+        {
+        }
+
+        ODATACPP_API void write(const utility::char_t* text, size_t size);
+        ODATACPP_API void finish();
+
+    private:
+        base64_decoder(const base64_decoder&);
+        base64_decoder& operator=(const base64_decoder&);
+
+        void decode(const utility::char_t* text, size_t size);
+
+        std::vector<unsigned char>& m_output;
+        utility::char_t m_pending[4];
+        size_t m_pending_size;
+        bool m_padded;
+    };
+
     template <typename Source>
     utility::string_t print_string(const Source &val)
     {
@@ -19,22 +19,28 @@
 namespace odata { namespace utility {
     namespace details
     {
-        struct _uri_components
+        /// <summary>
+        /// Where the components of a uri lie in its text. Each component runs from its begin to its end offset,
+        /// delimiters excluded; the scheme starts at offset zero and the fragment runs to the end of the text.
+        /// </summary>
+        struct _uri_offsets
         {
-            _uri_components()
+            _uri_offsets()
+                : m_scheme_end(0), m_user_info_begin(0), m_user_info_end(0), m_host_begin(0), m_host_end(0),
+                m_path_begin(0), m_path_end(1), m_query_begin(1), m_query_end(1), m_fragment_begin(1), m_port(-1)
             {
-                m_path = _XPLATSTR("/");
-                m_port = -1;
             }
 
-            ODATACPP_API utility::string_t join();
-
-            utility::string_t m_scheme;
-            utility::string_t m_host;
-            utility::string_t m_user_info;
-            utility::string_t m_path;
-            utility::string_t m_query;
-            utility::string_t m_fragment;
+            uint32_t m_scheme_end;
+            uint32_t m_user_info_begin;
+            uint32_t m_user_info_end;
+            uint32_t m_host_begin;
+            uint32_t m_host_end;
+            uint32_t m_path_begin;
+            uint32_t m_path_end;
+            uint32_t m_query_begin;
+            uint32_t m_query_end;
+            uint32_t m_fragment_begin;
             int m_port;
         };
     }
@@ -77,6 +83,10 @@ namespace odata { namespace utility {
     /// extra capability for validating and canonicalizing a uri according to scheme, and would 
     /// introduce a layer of type-safety for uris of differing schemes, and thus differing semantics.
     ///
+    /// A uri keeps its canonical text in a single string and locates the components by offset, so constructing
+    /// one from canonical text costs a single allocation, and none when the text is moved in. The component
+    /// accessors return copies.
+    ///
     /// One issue with implementing a scheme-independent uri facility is that of comparing for equality.
     /// For instance, these uris are considered equal 'http://msn.com', 'http://msn.com:80'. That is --
     /// the 'default' port can be either omitted or explicit. Since we don't have a way to map a scheme
@@ -168,7 +178,7 @@ namespace odata { namespace utility {
         /// <summary>
         /// Creates an empty uri
         /// </summary>
-        uri() { m_uri = _XPLATSTR("/");};
+        uri() : m_uri(_XPLATSTR("/")) {}
 
         /// <summary>
         /// Creates a uri from the given encoded string. This will throw an exception if the string 
@@ -184,6 +194,13 @@ namespace odata { namespace utility {
         /// <param name="uri_string">An encoded uri string to create the URI instance.</param>
         ODATACPP_API uri(const utility::string_t &uri_string);
 
+        /// <summary>
+        /// Creates a uri from the given encoded string, taking over its buffer. This will throw an exception if the
+        /// string does not contain a valid uri.
+        /// </summary>
+        /// <param name="uri_string">An encoded uri string to create the URI instance.</param>
+        ODATACPP_API uri(utility::string_t &&uri_string);
+
 #pragma endregion
 
 #pragma region accessors
@@ -192,43 +209,43 @@ namespace odata { namespace utility {
         /// Get the scheme component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI scheme as a string.</returns>
-        const utility::string_t &scheme() const { return m_components.m_scheme; }
+        utility::string_t scheme() const { return component(0, m_offsets.m_scheme_end); }
 
         /// <summary>
         /// Get the user information component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI user information as a string.</returns>
-        const utility::string_t &user_info() const { return m_components.m_user_info; }
+        utility::string_t user_info() const { return component(m_offsets.m_user_info_begin, m_offsets.m_user_info_end); }
 
         /// <summary>
         /// Get the host component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI host as a string.</returns>
-        const utility::string_t &host() const { return m_components.m_host; }
+        utility::string_t host() const { return component(m_offsets.m_host_begin, m_offsets.m_host_end); }
 
         /// <summary>
         /// Get the port component of the URI. Returns -1 if no port is specified.
         /// </summary>
         /// <returns>The URI port as an integer.</returns>
-        int port() const { return m_components.m_port; }
+        int port() const { return m_offsets.m_port; }
 
         /// <summary>
         /// Get the path component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI path as a string.</returns>
-        const utility::string_t &path() const { return m_components.m_path; }
+        utility::string_t path() const { return component(m_offsets.m_path_begin, m_offsets.m_path_end); }
 
         /// <summary>
         /// Get the query component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI query as a string.</returns>
-        const utility::string_t &query() const { return m_components.m_query; }
+        utility::string_t query() const { return component(m_offsets.m_query_begin, m_offsets.m_query_end); }
 
         /// <summary>
         /// Get the fragment component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI fragment as a string.</returns>
-        const utility::string_t &fragment() const { return m_components.m_fragment; }
+        utility::string_t fragment() const { return component(m_offsets.m_fragment_begin, (uint32_t)m_uri.size()); }
 
         /// <summary>
         /// Creates a new uri object with the same authority portion as this one, omitting the resource and query portions.
@@ -263,7 +280,8 @@ namespace odata { namespace utility {
         /// <returns><c>true</c> if this URI references the local host, <c>false</c> otherwise.</returns>
         bool is_host_loopback() const
         {
-            return !is_empty() && ((host() == _XPLATSTR("localhost")) || (host().size() > 4 && host().substr(0,4) == _XPLATSTR("127.")));
+            auto host_name = host();
+            return !is_empty() && ((host_name == _XPLATSTR("localhost")) || (host_name.size() > 4 && host_name.compare(0, 4, _XPLATSTR("127.")) == 0));
         }
 
         /// <summary>
@@ -274,7 +292,8 @@ namespace odata { namespace utility {
         /// </example>
         bool is_host_wildcard() const
         {
-            return !is_empty() && (this->host() == _XPLATSTR("*") || this->host() == _XPLATSTR("+"));
+            auto host_name = host();
+            return !is_empty() && (host_name == _XPLATSTR("*") || host_name == _XPLATSTR("+"));
         }
 
         /// <summary>
@@ -325,7 +344,8 @@ namespace odata { namespace utility {
         /// <returns><c>true</c> if the path portion of this uri is empty, <c>false</c> otherwise.</returns>
         bool is_path_empty() const
         {
-            return path().empty() || path() == _XPLATSTR("/");
+            auto length = m_offsets.m_path_end - m_offsets.m_path_begin;
+            return length == 0 || (length == 1 && m_uri[m_offsets.m_path_begin] == _XPLATSTR('/'));
         }
 
 #pragma endregion
@@ -335,8 +355,8 @@ namespace odata { namespace utility {
         /// <summary>
         /// Returns the full (encoded) uri as a string.
         /// </summary>
-         /// <returns>The full encoded uri string.</returns>
-        utility::string_t to_string() const
+        /// <returns>The full encoded uri string.</returns>
+        const utility::string_t &to_string() const
         {
             return m_uri;
         }
@@ -362,11 +382,20 @@ namespace odata { namespace utility {
     private:
         friend class uri_builder;
 
-        // Encodes all characters not in given set determined by given function.
-        static utility::string_t encode_impl(const utility::string_t &raw, const std::function<bool(int)>& should_encode);
+        // Encodes all characters for which the predicate returns true.
+        template <typename Predicate>
+        static utility::string_t encode_impl(const utility::string_t &raw, Predicate should_encode);
+
+        // Parses m_uri and brings it into canonical form, throwing uri_exception when it is not a valid uri.
+        void parse();
+
+        utility::string_t component(uint32_t begin, uint32_t end) const
+        {
+            return m_uri.substr(begin, end - begin);
+        }
 
         utility::string_t m_uri;
-        details::_uri_components m_components;
+        details::_uri_offsets m_offsets;
     };
 
 } // namespace web
@@ -726,6 +726,12 @@ public:
     /// <summary>
     /// A JSON object represented as a C++ class.
     /// </summary>
+    /// <remarks>
+    /// Unless the object keeps the order of its fields, the fields are sorted by key and looked up by binary search.
+    /// An object that keeps the order is scanned while it is small; past object::index_threshold fields it builds
+    /// an open-addressing hash index over the keys, so that lookups stay constant time while serialization still
+    /// sees the fields in insertion order.
+    /// </remarks>
     class object
     {
         typedef std::vector<std::pair<utility::string_t, json::value>> storage_type;
@@ -738,12 +744,13 @@ public:
         typedef storage_type::size_type size_type;
 
     private:
-        object(bool keep_order = false) : m_elements(), m_keep_order(keep_order) { }
-        object(storage_type elements, bool keep_order = false) : m_elements(std::move(elements)), m_keep_order(keep_order)
+        object(bool keep_order = false) : m_keep_order(keep_order), m_elements() { }
+        object(storage_type elements, bool keep_order = false) : m_keep_order(keep_order), m_elements(std::move(elements))
         {
             if (!keep_order) {
                 sort(m_elements.begin(), m_elements.end(), compare_pairs);
             }
+            index_fields();
         }
         object(const object& obj); // non copyable
         object& operator=(const object& obj); // non copyable
@@ -897,7 +904,12 @@ public:
             auto iter = find_by_key(key);
 
             if (iter == m_elements.end() || key != (iter->first))
-                return m_elements.insert(iter, std::pair<utility::string_t, value>(key, value()))->second;
+            {
+                // a new field goes to the end of an object that keeps the order, so indexing it is all it takes
+                iter = m_elements.insert(iter, std::pair<utility::string_t, value>(key, value()));
+                index_fields();
+                return iter->second;
+            }
 
             return iter->second;
         }
@@ -939,6 +951,12 @@ public:
         {
             return m_elements.empty();
         }
+
+        /// <summary>
+        /// The number of fields above which an object that keeps the order of its fields indexes them.
+        /// </summary>
+        enum { index_threshold = 16 };
+
     private:
 
         static bool compare_pairs(const std::pair<utility::string_t, value>& p1, const std::pair<utility::string_t, value>& p2)
@@ -950,9 +968,72 @@ public:
             return p1.first < key;
         }
 
+        // Brings the index up to date after fields were appended, growing it to keep it at most half full.
+        void index_fields()
+        {
+            if (!m_keep_order || m_elements.size() <= index_threshold)
+            {
+                return;
+            }
+
+            if (!m_index)
+            {
+                m_index.reset(new index());
+            }
+
+            auto& slots = m_index->m_slots;
+            if (m_elements.size() * 2 > slots.size())
+            {
+                size_t capacity = 64;
+                while (capacity < m_elements.size() * 4)
+                {
+                    capacity *= 2;
+                }
+                slots.assign(capacity, 0);
+                m_index->m_indexed = 0;
+            }
+
+            size_t mask = slots.size() - 1;
+            for (size_t& position = m_index->m_indexed; position < m_elements.size(); position++)
+            {
+                size_t slot = std::hash<utility::string_t>()(m_elements[position].first) & mask;
+                for (; slots[slot] != 0; slot = (slot + 1) & mask)
+                {
+                    if (m_elements[slots[slot] - 1].first == m_elements[position].first)
+                    {
+                        // a repeated key keeps finding its first occurrence, as a scan would
+                        break;
+                    }
+                }
+
+                if (slots[slot] == 0)
+                {
+                    slots[slot] = (uint32_t)(position + 1);
+                }
+            }
+        }
+
+        size_type find_indexed(const utility::string_t& key) const
+        {
+            const auto& slots = m_index->m_slots;
+            size_t mask = slots.size() - 1;
+            for (size_t slot = std::hash<utility::string_t>()(key) & mask; slots[slot] != 0; slot = (slot + 1) & mask)
+            {
+                if (m_elements[slots[slot] - 1].first == key)
+                {
+                    return slots[slot] - 1;
+                }
+            }
+            return m_elements.size();
+        }
+
         storage_type::const_iterator find_by_key(const utility::string_t& key) const
         {
-            if (m_keep_order)
+            if (m_index)
+            {
+                return m_elements.begin() + find_indexed(key);
+            }
+            else if (m_keep_order)
             {
                 return std::find_if(m_elements.begin(), m_elements.end(),
                     [&key](const std::pair<utility::string_t, value>& p) {
@@ -967,7 +1048,11 @@ public:
 
         storage_type::iterator find_by_key(const utility::string_t& key)
         {
-            if (m_keep_order)
+            if (m_index)
+            {
+                return m_elements.begin() + find_indexed(key);
+            }
+            else if (m_keep_order)
             {
                 return std::find_if(m_elements.begin(), m_elements.end(),
                     [&key](const std::pair<utility::string_t, value>& p) {
@@ -1012,6 +1097,18 @@ public:
 
         const bool m_keep_order;
         storage_type m_elements;
+        struct index
+        {
+            index() : m_indexed(0) { }
+
+            // The position of a field plus one, zero marks a free slot.
+            std::vector<uint32_t> m_slots;
+            // The fields before this position are in the index.
+            size_t m_indexed;
+        };
+
+        // Null while the object is scanned or sorted.
+        std::unique_ptr<index> m_index;
         friend class details::_Object;
 
         template<typename CharType> friend class json::details::JSON_Parser;
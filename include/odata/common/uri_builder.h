@@ -18,6 +18,10 @@ namespace odata { namespace utility
     /// <summary>
     /// Builder for constructing URIs incrementally.
     /// </summary>
+    /// <remarks>
+    /// The components are kept back to back in one buffer, so appending a path or query segment extends the
+    /// buffer in place and a builder that is cleared and reused stops allocating once the buffer is large enough.
+    /// </remarks>
     class uri_builder
     {
     public:
@@ -26,13 +30,13 @@ namespace odata { namespace utility
         /// <summary>
         /// Creates a builder with an initially empty URI.
         /// </summary>
-        uri_builder() {}
+        uri_builder() { clear(); }
 
         /// <summary>
         /// Creates a builder with a existing URI object.
         /// </summary>
         /// <param name="uri_str">Encoded string containing the URI.</param>
-        uri_builder(const uri &uri_str): m_uri(uri_str.m_components) {}
+        ODATACPP_API uri_builder(const uri &uri_str);
 
 #pragma endregion
 
@@ -42,43 +46,43 @@ namespace odata { namespace utility
         /// Get the scheme component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI scheme as a string.</returns>
-        const utility::string_t &scheme() const { return m_uri.m_scheme; }
+        utility::string_t scheme() const { return get_part(scheme_part); }
 
         /// <summary>
         /// Get the user information component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI user information as a string.</returns>
-        const utility::string_t &user_info() const { return m_uri.m_user_info; }
+        utility::string_t user_info() const { return get_part(user_info_part); }
 
         /// <summary>
         /// Get the host component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI host as a string.</returns>
-        const utility::string_t &host() const { return m_uri.m_host; }
+        utility::string_t host() const { return get_part(host_part); }
 
         /// <summary>
         /// Get the port component of the URI. Returns -1 if no port is specified.
         /// </summary>
         /// <returns>The URI port as an integer.</returns>
-        int port() const { return m_uri.m_port; }
+        int port() const { return m_port; }
 
         /// <summary>
         /// Get the path component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI path as a string.</returns>
-        const utility::string_t &path() const { return m_uri.m_path; }
+        utility::string_t path() const { return get_part(path_part); }
 
         /// <summary>
         /// Get the query component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI query as a string.</returns>
-        const utility::string_t &query() const { return m_uri.m_query; }
+        utility::string_t query() const { return get_part(query_part); }
 
         /// <summary>
         /// Get the fragment component of the URI as an encoded string.
         /// </summary>
         /// <returns>The URI fragment as a string.</returns>
-        const utility::string_t &fragment() const { return m_uri.m_fragment; }
+        utility::string_t fragment() const { return get_part(fragment_part); }
 
 #pragma endregion
 
@@ -91,7 +95,7 @@ namespace odata { namespace utility
         /// <returns>A reference to this <c>uri_builder</c> to support chaining.</returns>
         uri_builder & set_scheme(const utility::string_t &scheme) 
         {
-            m_uri.m_scheme = scheme;
+            set_part(scheme_part, scheme);
             return *this;
         }
 
@@ -103,7 +107,7 @@ namespace odata { namespace utility
         /// <returns>A reference to this <c>uri_builder</c> to support chaining.</returns>
         uri_builder & set_user_info(const utility::string_t &user_info, bool do_encoding = false) 
         { 
-            m_uri.m_user_info = do_encoding ? uri::encode_uri(user_info, uri::components::user_info) : user_info;
+            set_part(user_info_part, do_encoding ? uri::encode_uri(user_info, uri::components::user_info) : user_info);
             return *this;
         }
 
@@ -115,7 +119,7 @@ namespace odata { namespace utility
         /// <returns>A reference to this <c>uri_builder</c> to support chaining.</returns>
         uri_builder & set_host(const utility::string_t &host, bool do_encoding = false)
         { 
-            m_uri.m_host = do_encoding ? uri::encode_uri(host, uri::components::host) : host;
+            set_part(host_part, do_encoding ? uri::encode_uri(host, uri::components::host) : host);
             return *this;
         }
 
@@ -126,7 +130,7 @@ namespace odata { namespace utility
         /// <returns>A reference to this <c>uri_builder</c> to support chaining.</returns>
         uri_builder & set_port(int port) 
         { 
-            m_uri.m_port = port; 
+            m_port = port;
             return *this;
         }
 
@@ -145,7 +149,7 @@ namespace odata { namespace utility
             {
                 throw std::invalid_argument("invalid port argument, must be non empty string containing integer value");
             }
-            m_uri.m_port = port_tmp;
+            m_port = port_tmp;
             return *this;
         }
 
@@ -157,7 +161,7 @@ namespace odata { namespace utility
         /// <returns>A reference to this <c>uri_builder</c> to support chaining.</returns>
         uri_builder & set_path(const utility::string_t &path, bool do_encoding = false) 
         {
-            m_uri.m_path = do_encoding ? uri::encode_uri(path, uri::components::path) : path;
+            set_part(path_part, do_encoding ? uri::encode_uri(path, uri::components::path) : path);
             return *this;
         }
 
@@ -170,7 +174,7 @@ namespace odata { namespace utility
         /// <returns>A reference to this <c>uri_builder</c> to support chaining.</returns>
         uri_builder & set_query(const utility::string_t &query, bool do_encoding = false)
         { 
-            m_uri.m_query = do_encoding ? uri::encode_uri(query, uri::components::query) : query;
+            set_part(query_part, do_encoding ? uri::encode_uri(query, uri::components::query) : query);
             return *this;
         }
 
@@ -182,16 +186,19 @@ namespace odata { namespace utility
         /// <returns>A reference to this <c>uri_builder</c> to support chaining.</returns>
         uri_builder & set_fragment(const utility::string_t &fragment, bool do_encoding = false)
         { 
-            m_uri.m_fragment = do_encoding ? uri::encode_uri(fragment, uri::components::fragment) : fragment;
+            set_part(fragment_part, do_encoding ? uri::encode_uri(fragment, uri::components::fragment) : fragment);
             return *this;
         }
 
         /// <summary>
-        /// Clears all components of the underlying URI in this uri_builder.
+        /// Clears all components of the underlying URI in this uri_builder, keeping the buffer for reuse.
         /// </summary>
         void clear()
         {
-            m_uri = details::_uri_components();
+            m_buffer.assign(1, _XPLATSTR('/'));
+            m_ends[scheme_part] = m_ends[user_info_part] = m_ends[host_part] = 0;
+            m_ends[path_part] = m_ends[query_part] = m_ends[fragment_part] = 1;
+            m_port = -1;
         }
 
 #pragma endregion
@@ -258,7 +265,39 @@ namespace odata { namespace utility
 #pragma endregion
 
     private:
-        details::_uri_components m_uri;
+        enum part { scheme_part, user_info_part, host_part, path_part, query_part, fragment_part, part_count };
+
+        size_t part_begin(int part) const
+        {
+            return part == scheme_part ? 0 : m_ends[part - 1];
+        }
+
+        utility::string_t get_part(int part) const
+        {
+            return m_buffer.substr(part_begin(part), m_ends[part] - part_begin(part));
+        }
+
+        // Replaces count characters at position, which lies within the part, and moves the following parts.
+        void splice(int part, size_t position, size_t count, const utility::char_t *text, size_t length)
+        {
+            m_buffer.replace(position, count, text, length);
+            for (int i = part; i < part_count; i++)
+            {
+                m_ends[i] = m_ends[i] - count + length;
+            }
+        }
+
+        void set_part(int part, const utility::string_t &value)
+        {
+            splice(part, part_begin(part), m_ends[part] - part_begin(part), value.data(), value.size());
+        }
+
+        // Writes the components with their delimiters in the form uri expects.
+        utility::string_t join() const;
+
+        utility::string_t m_buffer;
+        size_t m_ends[part_count];
+        int m_port;
     };
 } // namespace web
 }
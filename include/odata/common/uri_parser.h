@@ -25,15 +25,20 @@ namespace details
         bool validate(const utility::string_t &encoded_string) const;
 
         /// <summary>
-        /// Parses the uri, setting each provided string to the value of that component. Components
-        /// that are not part of the provided text are set to the empty string. Component strings
-        /// DO NOT contain their beginning or ending delimiters.
+        /// Parses the uri, setting the offsets of each component within the provided text. Components
+        /// that are not part of the text are set to empty ranges. Component ranges DO NOT contain their
+        /// beginning or ending delimiters.
+        ///
+        /// canonical is cleared when the text differs from the canonical form of the uri in more than the
+        /// case of the scheme and host: when it has an empty authority, a port that is empty, zero or not
+        /// in shortest form, no path, or an empty query or fragment after its delimiter.
         ///
         /// This function accepts both uris ('http://msn.com') and uri relative-references ('path1/path2?query')
         /// </summary>
         bool parse(
             const utility::string_t &encoded_string,
-            _uri_components &components) const;
+            _uri_offsets &offsets,
+            bool &canonical) const;
 
         /// <summary>
         /// Unreserved characters are those that are allowed in a URI but do not have a reserved purpose. They include:
@@ -195,7 +200,7 @@ namespace details
             const utility::char_t **scheme_begin, const utility::char_t **scheme_end,
             const utility::char_t **uinfo_begin, const utility::char_t **uinfo_end,
             const utility::char_t **host_begin, const utility::char_t **host_end,
-            _Out_ int *port,
+            const utility::char_t **port_begin, const utility::char_t **port_end,
             const utility::char_t **path_begin, const utility::char_t **path_end,
             const utility::char_t **query_begin, const utility::char_t **query_end,
             const utility::char_t **fragment_begin, const utility::char_t **fragment_end) const;
@@ -0,0 +1,206 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_apply_clause.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/common/utility.h"
+
+namespace odata { namespace core
+{
+
+class odata_query_node;
+
+namespace odata_apply_transformation_kind {
+enum {
+	None,
+	Aggregate,
+	GroupBy,
+	Filter,
+	Compute,
+	TopCount,
+	BottomCount,
+};
+}
+
+namespace odata_aggregate_method {
+enum {
+	None,
+	Sum,
+	Min,
+	Max,
+	Average,
+	CountDistinct,
+	// The virtual property $count, the expression is null.
+	Count,
+};
+}
+
+class odata_aggregate_expression
+{
+public:
+	odata_aggregate_expression(
+		std::shared_ptr<::odata::core::odata_query_node> expression,
+		int method,
+		const ::odata::utility::string_t &alias)
+		: m_expression(expression),
+		m_method(method),
+		m_alias(alias) {}
+	~odata_aggregate_expression() {}
+
+	std::shared_ptr<::odata::core::odata_query_node> expression() const { return m_expression; }
+	int method() const { return m_method; }
+	const ::odata::utility::string_t &alias() const { return m_alias; }
+
+private:
+	std::shared_ptr<::odata::core::odata_query_node> m_expression;
+	int m_method;
+	::odata::utility::string_t m_alias;
+};
+
+class odata_compute_expression
+{
+public:
+	odata_compute_expression(
+		std::shared_ptr<::odata::core::odata_query_node> expression,
+		const ::odata::utility::string_t &alias)
+		: m_expression(expression),
+		m_alias(alias) {}
+	~odata_compute_expression() {}
+
+	std::shared_ptr<::odata::core::odata_query_node> expression() const { return m_expression; }
+	const ::odata::utility::string_t &alias() const { return m_alias; }
+
+private:
+	std::shared_ptr<::odata::core::odata_query_node> m_expression;
+	::odata::utility::string_t m_alias;
+};
+
+class odata_apply_transformation : public std::enable_shared_from_this<odata_apply_transformation>
+{
+public:
+	odata_apply_transformation(int transformation_kind)
+		: m_transformation_kind(transformation_kind) {}
+	virtual ~odata_apply_transformation() {}
+
+	int transformation_kind() const { return m_transformation_kind; }
+
+	template <typename T>
+	std::shared_ptr<T> as()
+	{
+		return std::static_pointer_cast<T>(shared_from_this());
+	}
+
+private:
+	int m_transformation_kind;
+};
+
+class odata_aggregate_transformation : public odata_apply_transformation
+{
+public:
+	odata_aggregate_transformation(std::vector<std::shared_ptr<::odata::core::odata_aggregate_expression>> &&expressions)
+		: odata_apply_transformation(odata_apply_transformation_kind::Aggregate),
+		m_expressions(expressions) {}
+	~odata_aggregate_transformation() {}
+
+	const std::vector<std::shared_ptr<::odata::core::odata_aggregate_expression>> &expressions() const
+	{ return m_expressions; }
+
+private:
+	std::vector<std::shared_ptr<::odata::core::odata_aggregate_expression>> m_expressions;
+};
+
+class odata_groupby_transformation : public odata_apply_transformation
+{
+public:
+	odata_groupby_transformation(
+		std::vector<std::shared_ptr<::odata::core::odata_query_node>> &&group_properties,
+		std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>> &&transformations)
+		: odata_apply_transformation(odata_apply_transformation_kind::GroupBy),
+		m_group_properties(group_properties),
+		m_transformations(transformations) {}
+	~odata_groupby_transformation() {}
+
+	const std::vector<std::shared_ptr<::odata::core::odata_query_node>> &group_properties() const
+	{ return m_group_properties; }
+
+	/// <summary>
+	/// Transformations applied to the rows of each group; empty when groupby has no second parameter.
+	/// </summary>
+	const std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>> &transformations() const
+	{ return m_transformations; }
+
+private:
+	std::vector<std::shared_ptr<::odata::core::odata_query_node>> m_group_properties;
+	std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>> m_transformations;
+};
+
+class odata_filter_transformation : public odata_apply_transformation
+{
+public:
+	odata_filter_transformation(std::shared_ptr<::odata::core::odata_query_node> expression)
+		: odata_apply_transformation(odata_apply_transformation_kind::Filter),
+		m_expression(expression) {}
+	~odata_filter_transformation() {}
+
+	std::shared_ptr<::odata::core::odata_query_node> expression() const { return m_expression; }
+
+private:
+	std::shared_ptr<::odata::core::odata_query_node> m_expression;
+};
+
+class odata_compute_transformation : public odata_apply_transformation
+{
+public:
+	odata_compute_transformation(std::vector<std::shared_ptr<::odata::core::odata_compute_expression>> &&expressions)
+		: odata_apply_transformation(odata_apply_transformation_kind::Compute),
+		m_expressions(expressions) {}
+	~odata_compute_transformation() {}
+
+	const std::vector<std::shared_ptr<::odata::core::odata_compute_expression>> &expressions() const
+	{ return m_expressions; }
+
+private:
+	std::vector<std::shared_ptr<::odata::core::odata_compute_expression>> m_expressions;
+};
+
+class odata_topcount_transformation : public odata_apply_transformation
+{
+public:
+	odata_topcount_transformation(
+		bool is_top,
+		int64_t count,
+		std::shared_ptr<::odata::core::odata_query_node> expression)
+		: odata_apply_transformation(is_top ? odata_apply_transformation_kind::TopCount : odata_apply_transformation_kind::BottomCount),
+		m_count(count),
+		m_expression(expression) {}
+	~odata_topcount_transformation() {}
+
+	bool is_top() const { return transformation_kind() == odata_apply_transformation_kind::TopCount; }
+	int64_t count() const { return m_count; }
+	std::shared_ptr<::odata::core::odata_query_node> expression() const { return m_expression; }
+
+private:
+	int64_t m_count;
+	std::shared_ptr<::odata::core::odata_query_node> m_expression;
+};
+
+class odata_apply_clause
+{
+public:
+	odata_apply_clause(std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>> &&transformations)
+		: m_transformations(transformations) {}
+	~odata_apply_clause() {}
+
+	const std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>> &transformations() const
+	{ return m_transformations; }
+	std::shared_ptr<::odata::core::odata_apply_transformation> transformation_at(::size_t i) const
+	{ return m_transformations[i]; }
+
+private:
+	std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>> m_transformations;
+};
+
+}}
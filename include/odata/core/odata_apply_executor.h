@@ -0,0 +1,57 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_apply_executor.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/common/utility.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/core/odata_entity_value.h"
+#include "odata/core/odata_apply_clause.h"
+#include "odata/core/odata_filter_evaluator.h"
+
+namespace odata { namespace core
+{
+
+/// <summary>
+/// Executes a parsed $apply over in-memory entities. groupby and aggregate are evaluated with a single pass hash
+/// aggregation; the aggregated values and computed properties are added to the result entities as dynamic properties
+/// so that they are serialized by the regular writers.
+/// </summary>
+class odata_apply_executor
+{
+public:
+	odata_apply_executor()
+		: m_evaluator(std::make_shared<odata_filter_evaluator>()) {}
+	~odata_apply_executor() {}
+
+	ODATACPP_API std::vector<std::shared_ptr<::odata::core::odata_entity_value>> execute(
+		std::shared_ptr<::odata::core::odata_apply_clause> apply_clause,
+		const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& entities);
+
+private:
+	std::vector<std::shared_ptr<::odata::core::odata_entity_value>> execute(
+		const std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>>& transformations,
+		std::vector<std::shared_ptr<::odata::core::odata_entity_value>> rows,
+		std::shared_ptr<::odata::edm::edm_entity_type> result_type);
+
+	std::vector<std::shared_ptr<::odata::core::odata_entity_value>> group_by(
+		const std::vector<std::shared_ptr<::odata::core::odata_query_node>>& group_properties,
+		const std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>>& transformations,
+		const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& rows,
+		std::shared_ptr<::odata::edm::edm_entity_type> result_type);
+
+	std::vector<std::shared_ptr<::odata::core::odata_entity_value>> compute(
+		std::shared_ptr<::odata::core::odata_compute_transformation> transformation,
+		const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& rows);
+
+	std::vector<std::shared_ptr<::odata::core::odata_entity_value>> top_count(
+		std::shared_ptr<::odata::core::odata_topcount_transformation> transformation,
+		const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& rows);
+
+	std::shared_ptr<odata_filter_evaluator> m_evaluator;
+};
+
+}}
@@ -0,0 +1,187 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_async_operation.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "odata/common/utility.h"
+#include "odata/common/uri.h"
+#include "odata/core/odata_value.h"
+#include "odata/core/odata_message_writer.h"
+
+namespace odata { namespace core
+{
+
+enum odata_async_status_t
+{
+	// Queued, waiting for a worker.
+	AsyncPending,
+	AsyncRunning,
+	// The job returned, its value is the result.
+	AsyncCompleted,
+	// The job threw, the message of the exception is kept.
+	AsyncFailed,
+	// Cancelled through the status monitor before it completed.
+	AsyncCancelled
+};
+
+/// <summary>
+/// A request accepted for asynchronous processing, tracked by its status monitor.
+/// </summary>
+class odata_async_operation
+{
+public:
+	odata_async_operation(::odata::utility::string_t id) : m_id(std::move(id)), m_status(AsyncPending) {}
+
+	const ::odata::utility::string_t& id() const { return m_id; }
+
+	odata_async_status_t status() const { return (odata_async_status_t)m_status.load(std::memory_order_acquire); }
+
+	bool is_done() const { return status() >= AsyncCompleted; }
+
+	/// <summary>Long jobs should check this now and then and give up once it is set.</summary>
+	bool is_cancelled() const { return status() == AsyncCancelled; }
+
+	/// <summary>The value returned by the job, null until it completed or when it returned none.</summary>
+	std::shared_ptr<odata_value> result() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_result;
+	}
+
+	::odata::utility::string_t error_message() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_error_message;
+	}
+
+private:
+	friend class odata_async_operation_manager;
+
+	odata_async_operation(const odata_async_operation&);
+	odata_async_operation& operator=(const odata_async_operation&);
+
+	const ::odata::utility::string_t m_id;
+	std::atomic<int> m_status;
+	std::function<std::shared_ptr<odata_value>(const odata_async_operation&)> m_job;
+	std::chrono::steady_clock::time_point m_done_at;
+
+	mutable std::mutex m_mutex;
+	std::shared_ptr<odata_value> m_result;
+	::odata::utility::string_t m_error_message;
+};
+
+/// <summary>
+/// The status line, headers and body a service sends back for an asynchronous request or a status monitor poll.
+/// </summary>
+struct odata_async_response
+{
+	int16_t status_code;
+	::odata::utility::string_t status_message;
+	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t> headers;
+	::odata::utility::string_t body;
+};
+
+/// <summary>
+/// Runs requests sent with Prefer: respond-async on a pool of worker threads and keeps their status monitors.
+/// </summary>
+/// <remarks>
+/// The service answers such a request with accepted(), 202 with the monitor URL in Location, and hands the work to
+/// submit(). Polling the monitor with poll() returns 202 until the job is done, then 200 with the final response
+/// embedded as application/http, framed by odata_message_writer::write_asynchronous_odata_value.
+/// The queue is bounded: when it is full submit() returns null and the service can process the request synchronously
+/// or answer 503. Monitors of finished operations are evicted once the time to live has passed since they finished;
+/// eviction happens lazily on submit(), find() and poll().
+/// </remarks>
+class odata_async_operation_manager
+{
+public:
+	/// <param name="monitor_root">The URL under which monitors live, a monitor is monitor_root/id.</param>
+	ODATACPP_API odata_async_operation_manager(
+		::odata::utility::uri monitor_root,
+		size_t worker_count = 2,
+		size_t queue_capacity = 64,
+		std::chrono::milliseconds time_to_live = std::chrono::minutes(10));
+
+	/// <summary>Stops the workers after their current job, operations still queued are cancelled.</summary>
+	ODATACPP_API ~odata_async_operation_manager();
+
+	/// <summary>Whether a Prefer header value asks for respond-async.</summary>
+	ODATACPP_API static bool prefers_respond_async(const ::odata::utility::string_t& prefer_header);
+
+	/// <summary>Queues a job, returns null when the queue is full.</summary>
+	ODATACPP_API std::shared_ptr<odata_async_operation> submit(std::function<std::shared_ptr<odata_value>(const odata_async_operation&)> job);
+
+	/// <summary>The operation of a monitor id, null when unknown or evicted.</summary>
+	ODATACPP_API std::shared_ptr<odata_async_operation> find(const ::odata::utility::string_t& id);
+
+	/// <summary>Cancels an operation and removes its monitor, as for DELETE on the monitor. False when unknown.</summary>
+	ODATACPP_API bool cancel(const ::odata::utility::string_t& id);
+
+	ODATACPP_API ::odata::utility::uri monitor_url(const std::shared_ptr<odata_async_operation>& operation) const;
+
+	/// <summary>The 202 Accepted response to the original request.</summary>
+	ODATACPP_API odata_async_response accepted(const std::shared_ptr<odata_async_operation>& operation) const;
+
+	/// <summary>
+	/// The response to a poll of the monitor: 202 while the job is pending or running, 200 with the embedded final
+	/// response once it is done (204 when it returned no value, 500 with an OData error when it threw) and 404 for
+	/// unknown, evicted or cancelled operations.
+	/// </summary>
+	ODATACPP_API odata_async_response poll(const ::odata::utility::string_t& id, odata_message_writer& writer);
+
+	/// <summary>Drops the monitors whose time to live has passed and returns how many were dropped.</summary>
+	ODATACPP_API size_t evict_expired();
+
+	/// <summary>Blocks until no job is queued or running.</summary>
+	ODATACPP_API void wait_idle();
+
+	size_t queued_count() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_queue.size();
+	}
+
+	size_t monitor_count() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_operations.size();
+	}
+
+	void set_retry_after(std::chrono::seconds retry_after) { m_retry_after = retry_after; }
+
+private:
+	odata_async_operation_manager(const odata_async_operation_manager&);
+	odata_async_operation_manager& operator=(const odata_async_operation_manager&);
+
+	void work();
+	void finish(const std::shared_ptr<odata_async_operation>& operation, odata_async_status_t status);
+	size_t evict_expired_locked(std::chrono::steady_clock::time_point now);
+	::odata::utility::string_t new_id();
+
+	const ::odata::utility::uri m_monitor_root;
+	const size_t m_queue_capacity;
+	const std::chrono::milliseconds m_time_to_live;
+	std::chrono::seconds m_retry_after;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_work_available;
+	std::condition_variable m_idle;
+	std::deque<std::shared_ptr<odata_async_operation>> m_queue;
+	std::unordered_map<::odata::utility::string_t, std::shared_ptr<odata_async_operation>> m_operations;
+	size_t m_running;
+	bool m_stopping;
+	uint64_t m_id_state;
+	std::vector<std::thread> m_workers;
+};
+
+}}
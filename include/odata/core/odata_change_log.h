@@ -0,0 +1,108 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_change_log.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include "odata/common/utility.h"
+#include "odata/common/uri.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/core/odata_delta_value.h"
+
+namespace odata { namespace core
+{
+
+/// <summary>
+/// Issues $deltatoken values for entity sets and resolves them into the changes made since.
+/// </summary>
+/// <remarks>
+/// A service hands out a delta link with the first full response and answers each later request of that link
+/// with a delta payload, so clients only download what changed. Implementations must be thread-safe.
+/// </remarks>
+class odata_change_log
+{
+public:
+	virtual ~odata_change_log() {}
+
+	/// <summary>Issues a token that stands for the current state of the entity set.</summary>
+	virtual ::odata::utility::string_t issue_token(const std::shared_ptr<::odata::edm::edm_entity_set>& entity_set) = 0;
+
+	/// <summary>
+	/// Collects the changes made to the entity set after the token was issued and issues the token that follows them.
+	/// Returns null when the token is unknown or has expired, the client then has to read the whole set again.
+	/// </summary>
+	virtual std::shared_ptr<odata_delta_value> read_changes(
+		const std::shared_ptr<::odata::edm::edm_entity_set>& entity_set,
+		const ::odata::utility::string_t& token,
+		::odata::utility::string_t& next_token) = 0;
+
+	/// <summary>Builds the delta link of an entity set, service-root/EntitySet?$deltatoken=token.</summary>
+	ODATACPP_API static ::odata::utility::uri delta_link(
+		const ::odata::utility::uri& service_root,
+		const ::odata::utility::string_t& entity_set_name,
+		const ::odata::utility::string_t& token);
+};
+
+/// <summary>
+/// A change log kept in memory. Tokens are sequence numbers of the log.
+/// </summary>
+/// <remarks>
+/// Changes to the same entity or link since a token are folded into the last one, so an entity updated ten times is
+/// sent once with its latest values and an entity added and then deleted is only reported as deleted.
+/// Recorded entities are kept by reference, not copied. With a capacity the oldest changes are dropped once it is
+/// exceeded and the tokens issued before them expire.
+/// </remarks>
+class odata_in_memory_change_log : public odata_change_log
+{
+public:
+	odata_in_memory_change_log(size_t capacity = 0) : m_capacity(capacity), m_sequence(0), m_expired_through(0) {}
+
+	/// <summary>Records that an entity was added to the set or changed.</summary>
+	ODATACPP_API void record_changed(const std::shared_ptr<::odata::edm::edm_entity_set>& entity_set, const std::shared_ptr<odata_entity_value>& entity);
+
+	/// <summary>Records that an entity left the set, its id is the set name followed by its key.</summary>
+	ODATACPP_API void record_deleted(const std::shared_ptr<::odata::edm::edm_entity_set>& entity_set, const std::shared_ptr<odata_entity_value>& entity, odata_deleted_reason_t reason = DeletedReasonDeleted);
+	ODATACPP_API void record_deleted(const std::shared_ptr<::odata::edm::edm_entity_set>& entity_set, const ::odata::utility::uri& id, odata_deleted_reason_t reason = DeletedReasonDeleted);
+
+	ODATACPP_API void record_link(const std::shared_ptr<::odata::edm::edm_entity_set>& entity_set, const ::odata::utility::uri& source, const ::odata::utility::string_t& relationship, const ::odata::utility::uri& target);
+	ODATACPP_API void record_deleted_link(const std::shared_ptr<::odata::edm::edm_entity_set>& entity_set, const ::odata::utility::uri& source, const ::odata::utility::string_t& relationship, const ::odata::utility::uri& target);
+
+	ODATACPP_API ::odata::utility::string_t issue_token(const std::shared_ptr<::odata::edm::edm_entity_set>& entity_set);
+
+	ODATACPP_API std::shared_ptr<odata_delta_value> read_changes(
+		const std::shared_ptr<::odata::edm::edm_entity_set>& entity_set,
+		const ::odata::utility::string_t& token,
+		::odata::utility::string_t& next_token);
+
+	/// <summary>The number of changes currently kept.</summary>
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_changes.size();
+	}
+
+private:
+	struct change
+	{
+		uint64_t sequence;
+		::odata::utility::string_t entity_set;
+		// Identifies what the change is about, later changes with the same key supersede it.
+		::odata::utility::string_t key;
+		std::shared_ptr<odata_delta_entry> entry;
+	};
+
+	void record(const std::shared_ptr<::odata::edm::edm_entity_set>& entity_set, ::odata::utility::string_t key, std::shared_ptr<odata_delta_entry> entry);
+
+	size_t m_capacity;
+	uint64_t m_sequence;
+	// Tokens below this sequence no longer have all of their changes.
+	uint64_t m_expired_through;
+	std::deque<change> m_changes;
+	mutable std::mutex m_mutex;
+};
+
+}}
@@ -0,0 +1,151 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_delta_value.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/common/utility.h"
+#include "odata/common/uri.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/core/odata_entity_value.h"
+
+namespace odata { namespace core
+{
+
+enum odata_delta_entry_kind_t
+{
+	// An entity that was added or changed, carried with its current values.
+	DeltaChangedEntity,
+	// An entity that left the set, written with @odata.removed.
+	DeltaDeletedEntity,
+	// A relationship that was added between two entities.
+	DeltaAddedLink,
+	// A relationship that was removed.
+	DeltaDeletedLink
+};
+
+enum odata_deleted_reason_t
+{
+	// The entity was deleted.
+	DeletedReasonDeleted,
+	// The entity still exists but no longer belongs to the results, for instance because it no longer passes the filter.
+	DeletedReasonChanged
+};
+
+/// <summary>
+/// One entry of a delta payload: a changed entity, a removed entity, an added link or a deleted link.
+/// </summary>
+class odata_delta_entry
+{
+public:
+	static std::shared_ptr<odata_delta_entry> changed_entity(std::shared_ptr<odata_entity_value> entity)
+	{
+		auto entry = std::make_shared<odata_delta_entry>(DeltaChangedEntity);
+		entry->m_entity = std::move(entity);
+		return entry;
+	}
+
+	static std::shared_ptr<odata_delta_entry> deleted_entity(::odata::utility::uri id, odata_deleted_reason_t reason = DeletedReasonDeleted)
+	{
+		auto entry = std::make_shared<odata_delta_entry>(DeltaDeletedEntity);
+		entry->m_id = std::move(id);
+		entry->m_reason = reason;
+		return entry;
+	}
+
+	static std::shared_ptr<odata_delta_entry> link(odata_delta_entry_kind_t kind, ::odata::utility::uri source, ::odata::utility::string_t relationship, ::odata::utility::uri target)
+	{
+		auto entry = std::make_shared<odata_delta_entry>(kind);
+		entry->m_id = std::move(source);
+		entry->m_relationship = std::move(relationship);
+		entry->m_target = std::move(target);
+		return entry;
+	}
+
+	odata_delta_entry(odata_delta_entry_kind_t kind) : m_kind(kind), m_reason(DeletedReasonDeleted) {}
+
+	odata_delta_entry_kind_t kind() const { return m_kind; }
+
+	/// <summary>The changed entity, null for the other kinds.</summary>
+	const std::shared_ptr<odata_entity_value>& entity() const { return m_entity; }
+
+	/// <summary>The id of a deleted entity.</summary>
+	const ::odata::utility::uri& id() const { return m_id; }
+	odata_deleted_reason_t reason() const { return m_reason; }
+
+	/// <summary>The source, navigation property and target of a link.</summary>
+	const ::odata::utility::uri& source() const { return m_id; }
+	const ::odata::utility::string_t& relationship() const { return m_relationship; }
+	const ::odata::utility::uri& target() const { return m_target; }
+
+private:
+	odata_delta_entry_kind_t m_kind;
+	std::shared_ptr<odata_entity_value> m_entity;
+	::odata::utility::uri m_id;
+	odata_deleted_reason_t m_reason;
+	::odata::utility::string_t m_relationship;
+	::odata::utility::uri m_target;
+};
+
+/// <summary>
+/// The changes to an entity set since a delta token was issued, in the order they are to be applied.
+/// </summary>
+class odata_delta_value
+{
+public:
+	odata_delta_value(std::shared_ptr<::odata::edm::edm_entity_set> entity_set) : m_entity_set(entity_set) {}
+
+	const std::shared_ptr<::odata::edm::edm_entity_set>& get_entity_set() const { return m_entity_set; }
+
+	void add_entry(std::shared_ptr<odata_delta_entry> entry)
+	{
+		m_entries.push_back(std::move(entry));
+	}
+
+	void add_changed_entity(std::shared_ptr<odata_entity_value> entity)
+	{
+		add_entry(odata_delta_entry::changed_entity(std::move(entity)));
+	}
+
+	void add_deleted_entity(::odata::utility::uri id, odata_deleted_reason_t reason = DeletedReasonDeleted)
+	{
+		add_entry(odata_delta_entry::deleted_entity(std::move(id), reason));
+	}
+
+	void add_link(::odata::utility::uri source, ::odata::utility::string_t relationship, ::odata::utility::uri target)
+	{
+		add_entry(odata_delta_entry::link(DeltaAddedLink, std::move(source), std::move(relationship), std::move(target)));
+	}
+
+	void add_deleted_link(::odata::utility::uri source, ::odata::utility::string_t relationship, ::odata::utility::uri target)
+	{
+		add_entry(odata_delta_entry::link(DeltaDeletedLink, std::move(source), std::move(relationship), std::move(target)));
+	}
+
+	const std::vector<std::shared_ptr<odata_delta_entry>>& get_entries() const { return m_entries; }
+
+	std::vector<std::shared_ptr<odata_delta_entry>>::const_iterator cbegin() const { return m_entries.cbegin(); }
+	std::vector<std::shared_ptr<odata_delta_entry>>::const_iterator cend() const { return m_entries.cend(); }
+	size_t size() const { return m_entries.size(); }
+
+	void set_context_url(::odata::utility::uri value) { m_context_url = value; }
+	const ::odata::utility::uri& get_context_url() const { return m_context_url; }
+
+	void set_next_link(::odata::utility::uri value) { m_next_link = value; }
+	const ::odata::utility::uri& get_next_link() const { return m_next_link; }
+
+	/// <summary>The link that returns the changes made after this payload, it carries the next $deltatoken.</summary>
+	void set_delta_link(::odata::utility::uri value) { m_delta_link = value; }
+	const ::odata::utility::uri& get_delta_link() const { return m_delta_link; }
+
+private:
+	std::shared_ptr<::odata::edm::edm_entity_set> m_entity_set;
+	std::vector<std::shared_ptr<odata_delta_entry>> m_entries;
+	::odata::utility::uri m_context_url;
+	::odata::utility::uri m_next_link;
+	::odata::utility::uri m_delta_link;
+};
+
+}}
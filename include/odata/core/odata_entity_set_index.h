@@ -0,0 +1,160 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_entity_set_index.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include <map>
+#include "odata/common/utility.h"
+#include "odata/core/odata_entity_value.h"
+#include "odata/core/odata_filter_clause.h"
+#include "odata/core/odata_query_node.h"
+#include "odata/core/odata_filter_evaluator.h"
+
+namespace odata { namespace core
+{
+
+namespace odata_index_kind {
+enum {
+	Hash = 0,
+	Ordered,
+};
+}
+
+struct odata_primitive_value_less
+{
+	bool operator()(const std::shared_ptr<::odata::core::odata_primitive_value>& left, const std::shared_ptr<::odata::core::odata_primitive_value>& right) const
+	{
+		return odata_filter_evaluator::compare(left, right) < 0;
+	}
+};
+
+/// <summary>
+/// A secondary index on one property of an in-memory entity set.
+/// Hash indexes answer equality lookups, ordered indexes answer both equality and range lookups.
+/// Entities whose indexed property is missing or null are not indexed.
+/// </summary>
+class odata_entity_set_index
+{
+public:
+	odata_entity_set_index(const ::odata::utility::string_t& property_name, int index_kind)
+		: m_property_name(property_name), m_index_kind(index_kind) {}
+	~odata_entity_set_index() {}
+
+	const ::odata::utility::string_t& property_name() const { return m_property_name; }
+	int index_kind() const { return m_index_kind; }
+	size_t size() const { return m_row_keys.size(); }
+
+	ODATACPP_API void insert(size_t row, std::shared_ptr<::odata::core::odata_entity_value> entity);
+	ODATACPP_API void remove(size_t row);
+
+	ODATACPP_API void find_equal(
+		const std::shared_ptr<::odata::core::odata_primitive_value>& key,
+		std::vector<size_t>& rows) const;
+
+	/// <summary>
+	/// Collects the rows whose key lies between the bounds, a null bound is unbounded. Only valid on ordered indexes.
+	/// </summary>
+	ODATACPP_API void find_range(
+		const std::shared_ptr<::odata::core::odata_primitive_value>& lower, bool lower_inclusive,
+		const std::shared_ptr<::odata::core::odata_primitive_value>& upper, bool upper_inclusive,
+		std::vector<size_t>& rows) const;
+
+	ODATACPP_API static ::odata::utility::string_t hash_key(const std::shared_ptr<::odata::core::odata_primitive_value>& key);
+
+private:
+	::odata::utility::string_t m_property_name;
+	int m_index_kind;
+	std::unordered_map<size_t, std::shared_ptr<::odata::core::odata_primitive_value>> m_row_keys;
+	std::unordered_map<::odata::utility::string_t, std::vector<size_t>> m_hash;
+	std::multimap<std::shared_ptr<::odata::core::odata_primitive_value>, size_t, odata_primitive_value_less> m_ordered;
+};
+
+namespace odata_index_plan_kind {
+enum {
+	FullScan = 0,
+	Equal,
+	In,
+	Range,
+};
+}
+
+/// <summary>
+/// The access path chosen for a filter expression: an index probe (if any) plus the residual predicate
+/// that still has to be evaluated against every candidate.
+/// </summary>
+class odata_index_plan
+{
+public:
+	odata_index_plan()
+		: m_plan_kind(odata_index_plan_kind::FullScan), m_lower_inclusive(false), m_upper_inclusive(false) {}
+
+	int plan_kind() const { return m_plan_kind; }
+	std::shared_ptr<odata_entity_set_index> index() const { return m_index; }
+	const std::vector<std::shared_ptr<::odata::core::odata_primitive_value>>& values() const { return m_values; }
+	std::shared_ptr<::odata::core::odata_primitive_value> lower() const { return m_lower; }
+	bool lower_inclusive() const { return m_lower_inclusive; }
+	std::shared_ptr<::odata::core::odata_primitive_value> upper() const { return m_upper; }
+	bool upper_inclusive() const { return m_upper_inclusive; }
+	std::shared_ptr<::odata::core::odata_query_node> residual() const { return m_residual; }
+
+private:
+	friend class odata_indexed_entity_set;
+
+	int m_plan_kind;
+	std::shared_ptr<odata_entity_set_index> m_index;
+	std::vector<std::shared_ptr<::odata::core::odata_primitive_value>> m_values;
+	std::shared_ptr<::odata::core::odata_primitive_value> m_lower;
+	bool m_lower_inclusive;
+	std::shared_ptr<::odata::core::odata_primitive_value> m_upper;
+	bool m_upper_inclusive;
+	std::shared_ptr<::odata::core::odata_query_node> m_residual;
+};
+
+/// <summary>
+/// An in-memory entity set with declarable secondary indexes that are maintained on insert/update/remove
+/// and picked automatically when evaluating $filter.
+/// Rows are addressed by a stable row number; removed rows leave a hole that is never reused.
+/// </summary>
+class odata_indexed_entity_set
+{
+public:
+	odata_indexed_entity_set() : m_count(0) {}
+	~odata_indexed_entity_set() {}
+
+	/// <summary>
+	/// Declares an index on a top level property and builds it from the rows already stored.
+	/// </summary>
+	ODATACPP_API std::shared_ptr<odata_entity_set_index> create_index(const ::odata::utility::string_t& property_name, int index_kind);
+	ODATACPP_API bool drop_index(const ::odata::utility::string_t& property_name);
+	ODATACPP_API std::shared_ptr<odata_entity_set_index> find_index(const ::odata::utility::string_t& property_name) const;
+
+	ODATACPP_API size_t insert(std::shared_ptr<::odata::core::odata_entity_value> entity);
+
+	/// <summary>
+	/// Replaces the entity stored at row, also call this after changing an indexed property of a stored entity in place.
+	/// </summary>
+	ODATACPP_API void update(size_t row, std::shared_ptr<::odata::core::odata_entity_value> entity);
+	ODATACPP_API bool remove(size_t row);
+
+	std::shared_ptr<::odata::core::odata_entity_value> get(size_t row) const
+	{
+		return row < m_rows.size() ? m_rows[row] : nullptr;
+	}
+
+	size_t size() const { return m_count; }
+
+	ODATACPP_API std::shared_ptr<odata_index_plan> plan(std::shared_ptr<::odata::core::odata_query_node> expression) const;
+
+	ODATACPP_API std::vector<std::shared_ptr<::odata::core::odata_entity_value>> filter(std::shared_ptr<::odata::core::odata_query_node> expression) const;
+	ODATACPP_API std::vector<std::shared_ptr<::odata::core::odata_entity_value>> filter(std::shared_ptr<::odata::core::odata_filter_clause> filter_clause) const;
+
+private:
+	std::vector<std::shared_ptr<::odata::core::odata_entity_value>> m_rows;
+	size_t m_count;
+	std::unordered_map<::odata::utility::string_t, std::shared_ptr<odata_entity_set_index>> m_indexes;
+};
+
+}}
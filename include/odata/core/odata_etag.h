@@ -0,0 +1,131 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_etag.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/common/utility.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/core/odata_entity_value.h"
+#include "odata/core/odata_collection_value.h"
+
+namespace odata { namespace core
+{
+
+/// <summary>
+/// Where the ETag of an entity comes from.
+/// </summary>
+enum odata_etag_source_t
+{
+	// The values of the concurrency properties declared on the navigation source, no ETag when there are none.
+	EtagFromConcurrencyProperties,
+	// A hash of the primitive and enum values of the entity, including those nested in complex values and collections.
+	EtagFromContentHash,
+	// The concurrency properties when the navigation source declares any, the content hash otherwise.
+	EtagFromConcurrencyPropertiesOrContentHash
+};
+
+/// <summary>
+/// The outcome of evaluating the preconditions of a request.
+/// </summary>
+enum odata_precondition_result_t
+{
+	// The request may be handled.
+	PreconditionProceed,
+	// A read whose If-None-Match matched, answered with 304 Not Modified.
+	PreconditionNotModified,
+	// Answered with 412 Precondition Failed.
+	PreconditionFailed
+};
+
+/// <summary>
+/// Evaluates If-Match and If-None-Match header values against an ETag, following RFC 7232.
+/// </summary>
+/// <remarks>
+/// An empty header value stands for an absent header and an empty ETag for a resource without one.
+/// If-None-Match uses the weak comparison, If-Match requires both tags to be identical including the weak prefix,
+/// which is how OData clients echo the weak ETags they were given.
+/// </remarks>
+class odata_preconditions
+{
+public:
+	/// <summary>Whether the If-Match condition holds; "*" holds for any existing resource.</summary>
+	ODATACPP_API static bool if_match(const ::odata::utility::string_t& header, const ::odata::utility::string_t& etag, bool exists = true);
+
+	/// <summary>Whether the If-None-Match condition holds, that is none of the listed tags matches.</summary>
+	ODATACPP_API static bool if_none_match(const ::odata::utility::string_t& header, const ::odata::utility::string_t& etag, bool exists = true);
+
+	/// <summary>
+	/// Evaluates If-Match first and If-None-Match second. A failed If-None-Match gives NotModified for reads
+	/// (GET and HEAD) and PreconditionFailed for anything else.
+	/// </summary>
+	ODATACPP_API static odata_precondition_result_t evaluate(
+		const ::odata::utility::string_t& if_match_header,
+		const ::odata::utility::string_t& if_none_match_header,
+		const ::odata::utility::string_t& etag,
+		bool is_read,
+		bool exists = true);
+};
+
+/// <summary>
+/// Computes weak ETags for entities and collections so preconditions can be decided before anything is serialized.
+/// </summary>
+/// <remarks>
+/// Concurrency ETags list the property values in declaration order, W/"'Milk',2.5", with string and enum values
+/// quoted as in URL literals and characters that are not allowed in an entity tag percent-encoded.
+/// Content hash ETags are W/"" around 16 hex digits; properties are hashed in name order so the result does not depend
+/// on the order they were set in. Navigation properties and nested entities never take part.
+/// </remarks>
+class odata_etag_generator
+{
+public:
+	odata_etag_generator(odata_etag_source_t source = EtagFromConcurrencyPropertiesOrContentHash) : m_source(source) {}
+
+	odata_etag_source_t source() const { return m_source; }
+
+	/// <summary>Computes the ETag of an entity of the navigation source, empty when the configured source gives none.</summary>
+	ODATACPP_API ::odata::utility::string_t generate(
+		const std::shared_ptr<odata_entity_value>& entity,
+		const std::shared_ptr<::odata::edm::edm_navigation_source>& navigation_source) const;
+
+	/// <summary>
+	/// Computes the ETag of a collection of entities from the ETags of its members, in order.
+	/// Empty when any member has no ETag.
+	/// </summary>
+	ODATACPP_API ::odata::utility::string_t generate(
+		const std::shared_ptr<odata_collection_value>& collection,
+		const std::shared_ptr<::odata::edm::edm_navigation_source>& navigation_source) const;
+
+	/// <summary>
+	/// Evaluates the preconditions against an entity, a null entity is a missing resource.
+	/// An ETag already set on the entity is used as is.
+	/// </summary>
+	ODATACPP_API odata_precondition_result_t evaluate(
+		const ::odata::utility::string_t& if_match_header,
+		const ::odata::utility::string_t& if_none_match_header,
+		const std::shared_ptr<odata_entity_value>& entity,
+		const std::shared_ptr<::odata::edm::edm_navigation_source>& navigation_source,
+		bool is_read) const;
+
+	ODATACPP_API odata_precondition_result_t evaluate(
+		const ::odata::utility::string_t& if_match_header,
+		const ::odata::utility::string_t& if_none_match_header,
+		const std::shared_ptr<odata_collection_value>& collection,
+		const std::shared_ptr<::odata::edm::edm_navigation_source>& navigation_source,
+		bool is_read) const;
+
+	/// <summary>The concurrency ETag of an entity from the given property paths, segments separated by '/'.</summary>
+	ODATACPP_API static ::odata::utility::string_t concurrency_etag(
+		const std::shared_ptr<odata_structured_value>& value,
+		const std::vector<::odata::utility::string_t>& property_paths);
+
+	/// <summary>The content hash ETag of an entity or complex value.</summary>
+	ODATACPP_API static ::odata::utility::string_t content_hash_etag(const std::shared_ptr<odata_structured_value>& value);
+
+private:
+	odata_etag_source_t m_source;
+};
+
+}}
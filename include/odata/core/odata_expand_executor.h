@@ -0,0 +1,85 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_expand_executor.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/common/utility.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/core/odata_entity_value.h"
+#include "odata/core/odata_collection_value.h"
+#include "odata/core/odata_select_expand_clause.h"
+#include "odata/core/odata_uri_parser.h"
+#include "odata/core/odata_filter_evaluator.h"
+
+namespace odata { namespace core
+{
+
+/// <summary>
+/// Backend used by odata_expand_executor to load the targets of a navigation property.
+/// </summary>
+class odata_expand_data_source
+{
+public:
+	virtual ~odata_expand_data_source() {}
+
+	/// <summary>
+	/// Loads the related entities of one navigation property for a whole batch of parents in a single round trip.
+	/// </summary>
+	/// <param name="navigation_property">The navigation property being expanded.</param>
+	/// <param name="parents">The distinct parents of this level, read their keys or foreign keys to build one lookup.</param>
+	/// <param name="related">Filled with the targets of each parent, keyed by odata_entity_value::get_entity_key_string() of the parent.</param>
+	virtual void load_related(
+		std::shared_ptr<::odata::edm::edm_property_type> navigation_property,
+		const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& parents,
+		std::unordered_map<::odata::utility::string_t, std::vector<std::shared_ptr<::odata::core::odata_entity_value>>>& related) = 0;
+};
+
+/// <summary>
+/// Executes $expand level by level: all parents of a level are expanded through one batched data source call per
+/// navigation property, and the results are stitched back into the parent entities. Nested $filter, $orderby, $skip,
+/// $top and $count of an expand item are applied per parent.
+/// </summary>
+class odata_expand_executor
+{
+public:
+	odata_expand_executor(std::shared_ptr<odata_expand_data_source> data_source)
+		: m_data_source(data_source), m_round_trips(0) {}
+	~odata_expand_executor() {}
+
+	ODATACPP_API void expand(
+		const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& parents,
+		std::shared_ptr<::odata::core::odata_select_expand_clause> select_expand_clause);
+
+	ODATACPP_API void expand(
+		std::shared_ptr<::odata::core::odata_entity_value> parent,
+		std::shared_ptr<::odata::core::odata_select_expand_clause> select_expand_clause);
+
+	/// <summary>
+	/// Number of data source calls issued so far.
+	/// </summary>
+	size_t round_trips() const { return m_round_trips; }
+
+private:
+	void expand_item(
+		const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& parents,
+		std::shared_ptr<::odata::core::odata_expand_item> item);
+
+	std::vector<std::shared_ptr<::odata::core::odata_entity_value>> expand_navigation(
+		const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& parents,
+		const ::odata::utility::string_t& navigation_property_name,
+		std::shared_ptr<::odata::core::odata_expand_item> options);
+
+	void apply_options(
+		std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& targets,
+		std::shared_ptr<::odata::core::odata_expand_item> options,
+		std::shared_ptr<::odata::core::odata_collection_value> collection);
+
+	std::shared_ptr<odata_expand_data_source> m_data_source;
+	std::shared_ptr<odata_filter_evaluator> m_evaluator;
+	size_t m_round_trips;
+};
+
+}}
@@ -0,0 +1,87 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_filter_evaluator.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/common/utility.h"
+#include "odata/core/odata_query_node.h"
+#include "odata/core/odata_query_node_visitor.h"
+#include "odata/core/odata_primitive_value.h"
+#include "odata/core/odata_structured_value.h"
+
+namespace odata { namespace core
+{
+
+/// <summary>
+/// Evaluates a filter expression against in-memory structured values.
+/// Boolean results are returned as Edm.Boolean primitive values, a null result means the expression evaluated to null.
+/// </summary>
+class odata_filter_evaluator : public odata_query_node_visitor<std::shared_ptr<::odata::core::odata_primitive_value>>
+{
+public:
+	odata_filter_evaluator() {}
+	~odata_filter_evaluator() {}
+
+	/// <summary>
+	/// Evaluates a boolean expression against the given instance, null is treated as false.
+	/// </summary>
+	ODATACPP_API bool evaluate(
+		std::shared_ptr<::odata::core::odata_query_node> expression,
+		std::shared_ptr<::odata::core::odata_structured_value> instance);
+
+	/// <summary>
+	/// Evaluates an expression against the given instance and returns its primitive value.
+	/// </summary>
+	ODATACPP_API std::shared_ptr<::odata::core::odata_primitive_value> evaluate_value(
+		std::shared_ptr<::odata::core::odata_query_node> expression,
+		std::shared_ptr<::odata::core::odata_structured_value> instance);
+
+	/// <summary>
+	/// Resolves a property path (property access, range variable or type cast) to the value it points to.
+	/// </summary>
+	ODATACPP_API std::shared_ptr<::odata::core::odata_value> resolve_value(std::shared_ptr<::odata::core::odata_query_node> node);
+
+	ODATACPP_API std::shared_ptr<::odata::core::odata_primitive_value> visit(std::shared_ptr<::odata::core::odata_constant_node> node);
+	ODATACPP_API std::shared_ptr<::odata::core::odata_primitive_value> visit(std::shared_ptr<::odata::core::odata_binary_operator_node> node);
+	ODATACPP_API std::shared_ptr<::odata::core::odata_primitive_value> visit(std::shared_ptr<::odata::core::odata_unary_operator_node> node);
+	ODATACPP_API std::shared_ptr<::odata::core::odata_primitive_value> visit(std::shared_ptr<::odata::core::odata_parameter_alias_node> node);
+	ODATACPP_API std::shared_ptr<::odata::core::odata_primitive_value> visit(std::shared_ptr<::odata::core::odata_property_access_node> node);
+	ODATACPP_API std::shared_ptr<::odata::core::odata_primitive_value> visit(std::shared_ptr<::odata::core::odata_type_cast_node> node);
+	ODATACPP_API std::shared_ptr<::odata::core::odata_primitive_value> visit(std::shared_ptr<::odata::core::odata_lambda_node> node);
+	ODATACPP_API std::shared_ptr<::odata::core::odata_primitive_value> visit(std::shared_ptr<::odata::core::odata_range_variable_node> node);
+	ODATACPP_API std::shared_ptr<::odata::core::odata_primitive_value> visit(std::shared_ptr<::odata::core::odata_function_call_node> node);
+	ODATACPP_API std::shared_ptr<::odata::core::odata_primitive_value> visit_any(std::shared_ptr<::odata::core::odata_query_node> node);
+
+	/// <summary>
+	/// Compares two non-null primitive values, numerically when both are numeric, as instants or time spans
+	/// when both are DateTimeOffset or both are Duration, case-insensitively when both are Guid and ordinally otherwise.
+	/// Returns a negative value, zero or a positive value.
+	/// </summary>
+	ODATACPP_API static int compare(
+		const std::shared_ptr<::odata::core::odata_primitive_value>& left,
+		const std::shared_ptr<::odata::core::odata_primitive_value>& right);
+
+	/// <summary>
+	/// Returns the text of a non-null DateTimeOffset, Duration or Guid value in a form that two values of the
+	/// same type share exactly when compare finds them equal; other values are returned as they are.
+	/// </summary>
+	ODATACPP_API static ::odata::utility::string_t canonical_text(const std::shared_ptr<::odata::core::odata_primitive_value>& value);
+
+	ODATACPP_API static bool is_numeric(const std::shared_ptr<::odata::core::odata_primitive_value>& value);
+	ODATACPP_API static bool is_true(const std::shared_ptr<::odata::core::odata_primitive_value>& value);
+
+private:
+	std::shared_ptr<::odata::core::odata_primitive_value> eval(std::shared_ptr<::odata::core::odata_query_node> node);
+	std::shared_ptr<::odata::core::odata_primitive_value> arithmetic(
+		int operator_kind,
+		const std::shared_ptr<::odata::core::odata_primitive_value>& left,
+		const std::shared_ptr<::odata::core::odata_primitive_value>& right);
+
+	std::shared_ptr<::odata::core::odata_structured_value> m_instance;
+	std::unordered_map<::odata::utility::string_t, std::shared_ptr<::odata::core::odata_value>> m_range_variables;
+};
+
+}}
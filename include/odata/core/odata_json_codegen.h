@@ -0,0 +1,928 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_json_codegen.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/common/utility.h"
+#include "odata/common/nullable.h"
+#include "odata/core/odata_exception.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Support for the code that odata-csdl-codegen generates from a CSDL document. Generated types are plain structs
+// that are written to and read from JSON by overloads of write_json and read_json resolved at compile time, without
+// odata_value, odata_property_map or any virtual call on the way.
+
+namespace odata { namespace core
+{
+
+/// <summary>
+/// Describes a property of a generated type; generated types list their properties, inherited ones first.
+/// </summary>
+struct odata_codegen_property
+{
+	const ::odata::utility::char_t* name;
+	const ::odata::utility::char_t* edm_type;
+	bool is_key;
+	bool is_nullable;
+};
+
+/// <summary>
+/// Maps a property name to its position in the property table of a generated type; generated tables are sorted by name.
+/// </summary>
+struct odata_codegen_property_index
+{
+	const ::odata::utility::char_t* name;
+	size_t index;
+};
+
+/// <summary>
+/// Describes a member of a generated enum type.
+/// </summary>
+struct odata_codegen_enum_member
+{
+	const ::odata::utility::char_t* name;
+	int64_t value;
+};
+
+/// <summary>
+/// Finds a property in a name-sorted index; returns count if there is no property with that name.
+/// </summary>
+inline size_t odata_codegen_find_property(const odata_codegen_property_index* indexes, size_t count, const ::odata::utility::string_t& name)
+{
+	size_t low = 0;
+	size_t high = count;
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+		int order = name.compare(indexes[middle].name);
+		if (order == 0)
+		{
+			return indexes[middle].index;
+		}
+
+		if (order < 0)
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle + 1;
+		}
+	}
+
+	return count;
+}
+
+/// <summary>
+/// Reads JSON text for generated read_json functions. The text must outlive the reader.
+/// Malformed JSON and values of the wrong type throw odata_exception.
+/// </summary>
+class odata_json_codegen_reader
+{
+public:
+	odata_json_codegen_reader(const ::odata::utility::string_t& json) : m_begin(json.data()), m_current(json.data()), m_end(json.data() + json.size())
+	{
+	}
+
+	odata_json_codegen_reader(const ::odata::utility::char_t* begin, const ::odata::utility::char_t* end) : m_begin(begin), m_current(begin), m_end(end)
+	{
+	}
+
+	void begin_object()
+	{
+		expect(U('{'));
+	}
+
+	/// <summary>
+	/// Reads the name of the next member of the current object; returns false and consumes the closing brace at its end.
+	/// </summary>
+	bool next_member(::odata::utility::string_t& name, bool first)
+	{
+		if (peek() == U('}'))
+		{
+			m_current++;
+			return false;
+		}
+
+		if (!first)
+		{
+			expect(U(','));
+		}
+		read_string(name);
+		expect(U(':'));
+		return true;
+	}
+
+	void begin_array()
+	{
+		expect(U('['));
+	}
+
+	/// <summary>
+	/// Moves to the next element of the current array; returns false and consumes the closing bracket at its end.
+	/// </summary>
+	bool next_element(bool first)
+	{
+		if (peek() == U(']'))
+		{
+			m_current++;
+			return false;
+		}
+
+		if (!first)
+		{
+			expect(U(','));
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Consumes a JSON null if that is what comes next.
+	/// </summary>
+	bool read_null()
+	{
+		if (peek() == U('n'))
+		{
+			expect_literal(U("null"));
+			return true;
+		}
+		return false;
+	}
+
+	bool read_bool()
+	{
+		if (peek() == U('t'))
+		{
+			expect_literal(U("true"));
+			return true;
+		}
+
+		expect_literal(U("false"));
+		return false;
+	}
+
+	int64_t read_integer()
+	{
+		char buffer[32];
+		size_t length = read_number_token(buffer, sizeof(buffer));
+		char* end = nullptr;
+		errno = 0;
+		long long value = std::strtoll(buffer, &end, 10);
+		if (end != buffer + length || errno == ERANGE)
+		{
+			fail(U("integer expected"));
+		}
+		return (int64_t)value;
+	}
+
+	long double read_floating()
+	{
+		// Infinity and NaN are written as strings by OData.
+		if (peek() == U('"'))
+		{
+			::odata::utility::string_t text;
+			read_string(text);
+			if (text == U("NaN"))
+			{
+				return std::numeric_limits<long double>::quiet_NaN();
+			}
+			if (text == U("INF"))
+			{
+				return std::numeric_limits<long double>::infinity();
+			}
+			if (text == U("-INF"))
+			{
+				return -std::numeric_limits<long double>::infinity();
+			}
+			fail(U("number expected"));
+		}
+
+		char buffer[64];
+		size_t length = read_number_token(buffer, sizeof(buffer));
+		char* end = nullptr;
+		long double value = std::strtold(buffer, &end);
+		if (end != buffer + length)
+		{
+			fail(U("number expected"));
+		}
+		return value;
+	}
+
+	void read_string(::odata::utility::string_t& value)
+	{
+		expect(U('"'));
+		value.clear();
+		for (;;)
+		{
+			const ::odata::utility::char_t* run = m_current;
+			while (m_current != m_end && *m_current != U('"') && *m_current != U('\\'))
+			{
+				m_current++;
+			}
+			value.append(run, m_current);
+
+			if (m_current == m_end)
+			{
+				fail(U("unterminated string"));
+			}
+
+			if (*m_current++ == U('"'))
+			{
+				return;
+			}
+
+			if (m_current == m_end)
+			{
+				fail(U("unterminated string"));
+			}
+
+			switch (*m_current++)
+			{
+			case U('"'): value += U('"'); break;
+			case U('\\'): value += U('\\'); break;
+			case U('/'): value += U('/'); break;
+			case U('b'): value += U('\b'); break;
+			case U('f'): value += U('\f'); break;
+			case U('n'): value += U('\n'); break;
+			case U('r'): value += U('\r'); break;
+			case U('t'): value += U('\t'); break;
+			case U('u'): append_code_point(value, read_escaped_code_point()); break;
+			default: fail(U("invalid escape sequence"));
+			}
+		}
+	}
+
+	/// <summary>
+	/// Reads a string of base64 text and decodes it straight from the JSON text into value.
+	/// </summary>
+	void read_base64(std::vector<unsigned char>& value)
+	{
+		expect(U('"'));
+		const ::odata::utility::char_t* run = m_current;
+		while (m_current != m_end && *m_current != U('"') && *m_current != U('\\'))
+		{
+			m_current++;
+		}
+
+		if (m_current == m_end || *m_current != U('"'))
+		{
+			// Base64 has no need for escape sequences, but they are valid JSON; take the general path.
+			m_current = run - 1;
+			::odata::utility::string_t text;
+			read_string(text);
+			value = ::odata::utility::conversions::from_base64(text);
+			return;
+		}
+
+		size_t size = (size_t)(m_current - run);
+		value.clear();
+		value.resize(size / 4 * 3);
+		value.resize(::odata::utility::conversions::from_base64(run, size, value.data()));
+		m_current++;
+	}
+
+	/// <summary>
+	/// Skips the next value, whatever it is.
+	/// </summary>
+	void skip_value()
+	{
+		switch (peek())
+		{
+		case U('{'):
+			{
+				begin_object();
+				::odata::utility::string_t name;
+				for (bool first = true; next_member(name, first); first = false)
+				{
+					skip_value();
+				}
+			}
+			break;
+		case U('['):
+			begin_array();
+			for (bool first = true; next_element(first); first = false)
+			{
+				skip_value();
+			}
+			break;
+		case U('"'):
+			{
+				::odata::utility::string_t ignored;
+				read_string(ignored);
+			}
+			break;
+		case U('t'):
+		case U('f'):
+			read_bool();
+			break;
+		case U('n'):
+			read_null();
+			break;
+		default:
+			{
+				char buffer[64];
+				read_number_token(buffer, sizeof(buffer));
+			}
+			break;
+		}
+	}
+
+	/// <summary>
+	/// Checks that nothing but whitespace is left.
+	/// </summary>
+	void end()
+	{
+		if (peek() != 0)
+		{
+			fail(U("unexpected content after the value"));
+		}
+	}
+
+	void fail(const ::odata::utility::char_t* message) const
+	{
+		throw odata_exception(U("Invalid JSON at offset ") + ::odata::utility::conversions::print_string(m_current - m_begin) + U(": ") + message + U("."));
+	}
+
+private:
+	::odata::utility::char_t peek()
+	{
+		while (m_current != m_end && (*m_current == U(' ') || *m_current == U('\t') || *m_current == U('\n') || *m_current == U('\r')))
+		{
+			m_current++;
+		}
+		return m_current == m_end ? 0 : *m_current;
+	}
+
+	void expect(::odata::utility::char_t c)
+	{
+		if (peek() != c)
+		{
+			fail(U("unexpected character"));
+		}
+		m_current++;
+	}
+
+	void expect_literal(const ::odata::utility::char_t* literal)
+	{
+		peek();
+		for (; *literal; literal++, m_current++)
+		{
+			if (m_current == m_end || *m_current != *literal)
+			{
+				fail(U("unexpected literal"));
+			}
+		}
+	}
+
+	size_t read_number_token(char* buffer, size_t size)
+	{
+		peek();
+		size_t length = 0;
+		while (m_current != m_end && ((*m_current >= U('0') && *m_current <= U('9')) || *m_current == U('-') || *m_current == U('+')
+			|| *m_current == U('.') || *m_current == U('e') || *m_current == U('E')))
+		{
+			if (length + 1 == size)
+			{
+				fail(U("number too long"));
+			}
+			buffer[length++] = (char)*m_current++;
+		}
+		buffer[length] = 0;
+
+		if (length == 0)
+		{
+			fail(U("value expected"));
+		}
+		return length;
+	}
+
+	uint32_t read_hex4()
+	{
+		uint32_t value = 0;
+		for (int i = 0; i < 4; i++, m_current++)
+		{
+			if (m_current == m_end)
+			{
+				fail(U("unterminated escape sequence"));
+			}
+
+			::odata::utility::char_t c = *m_current;
+			value <<= 4;
+			if (c >= U('0') && c <= U('9'))
+			{
+				value |= (uint32_t)(c - U('0'));
+			}
+			else if (c >= U('a') && c <= U('f'))
+			{
+				value |= (uint32_t)(c - U('a') + 10);
+			}
+			else if (c >= U('A') && c <= U('F'))
+			{
+				value |= (uint32_t)(c - U('A') + 10);
+			}
+			else
+			{
+				fail(U("invalid escape sequence"));
+			}
+		}
+		return value;
+	}
+
+	uint32_t read_escaped_code_point()
+	{
+		uint32_t code_point = read_hex4();
+		if (code_point >= 0xD800 && code_point <= 0xDBFF && m_end - m_current >= 6 && m_current[0] == U('\\') && m_current[1] == U('u'))
+		{
+			m_current += 2;
+			uint32_t low = read_hex4();
+			if (low < 0xDC00 || low > 0xDFFF)
+			{
+				fail(U("invalid surrogate pair"));
+			}
+			code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+		}
+		return code_point;
+	}
+
+	static void append_code_point(::odata::utility::string_t& value, uint32_t code_point)
+	{
+#ifdef _UTF16_STRINGS
+		if (code_point >= 0x10000)
+		{
+			code_point -= 0x10000;
+			value += (wchar_t)(0xD800 + (code_point >> 10));
+			value += (wchar_t)(0xDC00 + (code_point & 0x3FF));
+		}
+		else
+		{
+			value += (wchar_t)code_point;
+		}
+#else
+		if (code_point < 0x80)
+		{
+			value += (char)code_point;
+		}
+		else if (code_point < 0x800)
+		{
+			value += (char)(0xC0 | (code_point >> 6));
+			value += (char)(0x80 | (code_point & 0x3F));
+		}
+		else if (code_point < 0x10000)
+		{
+			value += (char)(0xE0 | (code_point >> 12));
+			value += (char)(0x80 | ((code_point >> 6) & 0x3F));
+			value += (char)(0x80 | (code_point & 0x3F));
+		}
+		else
+		{
+			value += (char)(0xF0 | (code_point >> 18));
+			value += (char)(0x80 | ((code_point >> 12) & 0x3F));
+			value += (char)(0x80 | ((code_point >> 6) & 0x3F));
+			value += (char)(0x80 | (code_point & 0x3F));
+		}
+#endif
+	}
+
+	const ::odata::utility::char_t* m_begin;
+	const ::odata::utility::char_t* m_current;
+	const ::odata::utility::char_t* m_end;
+};
+
+inline void odata_codegen_write_integer(::odata::utility::string_t& out, int64_t value)
+{
+	::odata::utility::char_t buffer[24];
+	::odata::utility::char_t* end = buffer + sizeof(buffer) / sizeof(buffer[0]);
+	::odata::utility::char_t* start = end;
+	uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+	do
+	{
+		*--start = (::odata::utility::char_t)(U('0') + magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude);
+
+	if (value < 0)
+	{
+		*--start = U('-');
+	}
+	out.append(start, end);
+}
+
+/// <summary>
+/// Writes the shortest decimal form that reads back as the same value.
+/// </summary>
+template <typename T>
+void odata_codegen_write_floating(::odata::utility::string_t& out, T value)
+{
+	if (std::isnan(value))
+	{
+		out += U("\"NaN\"");
+		return;
+	}
+
+	if (std::isinf(value))
+	{
+		out += value > 0 ? U("\"INF\"") : U("\"-INF\"");
+		return;
+	}
+
+	char buffer[64];
+	int length = 0;
+	for (int digits = std::numeric_limits<T>::digits10; digits <= std::numeric_limits<T>::max_digits10; digits++)
+	{
+		length = std::snprintf(buffer, sizeof(buffer), "%.*Lg", digits, (long double)value);
+		if ((T)std::strtold(buffer, nullptr) == value)
+		{
+			break;
+		}
+	}
+	out.append(buffer, buffer + length);
+}
+
+inline void write_json(::odata::utility::string_t& out, bool value)
+{
+	out += value ? U("true") : U("false");
+}
+
+inline void write_json(::odata::utility::string_t& out, int8_t value)
+{
+	odata_codegen_write_integer(out, value);
+}
+
+inline void write_json(::odata::utility::string_t& out, uint8_t value)
+{
+	odata_codegen_write_integer(out, value);
+}
+
+inline void write_json(::odata::utility::string_t& out, int16_t value)
+{
+	odata_codegen_write_integer(out, value);
+}
+
+inline void write_json(::odata::utility::string_t& out, int32_t value)
+{
+	odata_codegen_write_integer(out, value);
+}
+
+inline void write_json(::odata::utility::string_t& out, int64_t value)
+{
+	odata_codegen_write_integer(out, value);
+}
+
+inline void write_json(::odata::utility::string_t& out, float value)
+{
+	odata_codegen_write_floating(out, value);
+}
+
+inline void write_json(::odata::utility::string_t& out, double value)
+{
+	odata_codegen_write_floating(out, value);
+}
+
+inline void write_json(::odata::utility::string_t& out, long double value)
+{
+	odata_codegen_write_floating(out, value);
+}
+
+inline void write_json(::odata::utility::string_t& out, const ::odata::utility::string_t& value)
+{
+	static const ::odata::utility::char_t hex[] = U("0123456789abcdef");
+
+	out += U('"');
+	const ::odata::utility::char_t* run = value.data();
+	const ::odata::utility::char_t* end = run + value.size();
+	for (const ::odata::utility::char_t* current = run; current != end; ++current)
+	{
+		::odata::utility::char_t c = *current;
+		if (c != U('"') && c != U('\\') && (c < 0 || c >= 0x20))
+		{
+			continue;
+		}
+
+		out.append(run, current);
+		run = current + 1;
+		switch (c)
+		{
+		case U('"'): out += U("\\\""); break;
+		case U('\\'): out += U("\\\\"); break;
+		case U('\b'): out += U("\\b"); break;
+		case U('\f'): out += U("\\f"); break;
+		case U('\n'): out += U("\\n"); break;
+		case U('\r'): out += U("\\r"); break;
+		case U('\t'): out += U("\\t"); break;
+		default:
+			out += U("\\u00");
+			out += hex[(c >> 4) & 0xF];
+			out += hex[c & 0xF];
+			break;
+		}
+	}
+	out.append(run, end);
+	out += U('"');
+}
+
+inline void write_json(::odata::utility::string_t& out, const ::odata::utility::datetime& value)
+{
+	write_json(out, value.to_string(::odata::utility::datetime::ISO_8601));
+}
+
+inline void write_json(::odata::utility::string_t& out, const ::odata::utility::seconds& value)
+{
+	write_json(out, ::odata::utility::timespan::seconds_to_xml_duration(value));
+}
+
+inline void write_json(::odata::utility::string_t& out, const std::vector<unsigned char>& value)
+{
+	// The base64 alphabet never needs escaping.
+	out += U('"');
+	::odata::utility::conversions::to_base64(value.data(), value.size(), out);
+	out += U('"');
+}
+
+template <typename T>
+void write_json(::odata::utility::string_t& out, const std::vector<T>& values)
+{
+	out += U('[');
+	for (auto iter = values.cbegin(); iter != values.cend(); ++iter)
+	{
+		if (iter != values.cbegin())
+		{
+			out += U(',');
+		}
+		write_json(out, *iter);
+	}
+	out += U(']');
+}
+
+template <typename T>
+void write_json(::odata::utility::string_t& out, const ::odata::common::nullable<T>& value)
+{
+	if (value.has_value())
+	{
+		write_json(out, value.value());
+	}
+	else
+	{
+		out += U("null");
+	}
+}
+
+template <typename T>
+void write_json(::odata::utility::string_t& out, const std::shared_ptr<T>& value)
+{
+	if (value)
+	{
+		write_json(out, *value);
+	}
+	else
+	{
+		out += U("null");
+	}
+}
+
+template <typename T>
+T odata_codegen_narrow_integer(odata_json_codegen_reader& reader)
+{
+	int64_t value = reader.read_integer();
+	if (value < (int64_t)std::numeric_limits<T>::min() || value > (int64_t)std::numeric_limits<T>::max())
+	{
+		reader.fail(U("integer out of range"));
+	}
+	return (T)value;
+}
+
+inline void read_json(odata_json_codegen_reader& reader, bool& value)
+{
+	value = reader.read_bool();
+}
+
+inline void read_json(odata_json_codegen_reader& reader, int8_t& value)
+{
+	value = odata_codegen_narrow_integer<int8_t>(reader);
+}
+
+inline void read_json(odata_json_codegen_reader& reader, uint8_t& value)
+{
+	value = odata_codegen_narrow_integer<uint8_t>(reader);
+}
+
+inline void read_json(odata_json_codegen_reader& reader, int16_t& value)
+{
+	value = odata_codegen_narrow_integer<int16_t>(reader);
+}
+
+inline void read_json(odata_json_codegen_reader& reader, int32_t& value)
+{
+	value = odata_codegen_narrow_integer<int32_t>(reader);
+}
+
+inline void read_json(odata_json_codegen_reader& reader, int64_t& value)
+{
+	value = reader.read_integer();
+}
+
+inline void read_json(odata_json_codegen_reader& reader, float& value)
+{
+	value = (float)reader.read_floating();
+}
+
+inline void read_json(odata_json_codegen_reader& reader, double& value)
+{
+	value = (double)reader.read_floating();
+}
+
+inline void read_json(odata_json_codegen_reader& reader, long double& value)
+{
+	value = reader.read_floating();
+}
+
+/// <summary>
+/// Reads a string; null reads as an empty string, as generated types do not track nulls of non-POD values.
+/// </summary>
+inline void read_json(odata_json_codegen_reader& reader, ::odata::utility::string_t& value)
+{
+	if (reader.read_null())
+	{
+		value.clear();
+		return;
+	}
+	reader.read_string(value);
+}
+
+inline void read_json(odata_json_codegen_reader& reader, ::odata::utility::datetime& value)
+{
+	::odata::utility::string_t text;
+	read_json(reader, text);
+	value = text.empty() ? ::odata::utility::datetime() : ::odata::utility::datetime::from_string(text, ::odata::utility::datetime::ISO_8601);
+}
+
+inline void read_json(odata_json_codegen_reader& reader, ::odata::utility::seconds& value)
+{
+	::odata::utility::string_t text;
+	read_json(reader, text);
+	value = text.empty() ? ::odata::utility::seconds() : ::odata::utility::timespan::xml_duration_to_seconds(text);
+}
+
+inline void read_json(odata_json_codegen_reader& reader, std::vector<unsigned char>& value)
+{
+	if (reader.read_null())
+	{
+		value.clear();
+		return;
+	}
+	reader.read_base64(value);
+}
+
+template <typename T>
+void read_json(odata_json_codegen_reader& reader, std::vector<T>& values)
+{
+	values.clear();
+	if (reader.read_null())
+	{
+		return;
+	}
+
+	reader.begin_array();
+	for (bool first = true; reader.next_element(first); first = false)
+	{
+		values.push_back(T());
+		read_json(reader, values.back());
+	}
+}
+
+template <typename T>
+void read_json(odata_json_codegen_reader& reader, ::odata::common::nullable<T>& value)
+{
+	if (reader.read_null())
+	{
+		value = null_value;
+		return;
+	}
+
+	T element;
+	read_json(reader, element);
+	value = element;
+}
+
+template <typename T>
+void read_json(odata_json_codegen_reader& reader, std::shared_ptr<T>& value)
+{
+	if (reader.read_null())
+	{
+		value.reset();
+		return;
+	}
+
+	value = std::make_shared<T>();
+	read_json(reader, *value);
+}
+
+/// <summary>
+/// Writes an enum value by member name; values of flags enums that match no member are written as a comma-separated list.
+/// </summary>
+inline void odata_codegen_write_enum(::odata::utility::string_t& out, int64_t value, const odata_codegen_enum_member* members, size_t count, bool is_flags)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		if (members[i].value == value)
+		{
+			write_json(out, ::odata::utility::string_t(members[i].name));
+			return;
+		}
+	}
+
+	::odata::utility::string_t names;
+	int64_t remaining = value;
+	for (size_t i = 0; is_flags && i < count; i++)
+	{
+		if (members[i].value != 0 && (value & members[i].value) == members[i].value)
+		{
+			if (!names.empty())
+			{
+				names += U(',');
+			}
+			names += members[i].name;
+			remaining &= ~members[i].value;
+		}
+	}
+
+	if (names.empty() || remaining != 0)
+	{
+		throw odata_exception(U("The value ") + ::odata::utility::conversions::print_string(value) + U(" is not a member of the enum type."));
+	}
+	write_json(out, names);
+}
+
+inline int64_t odata_codegen_read_enum(odata_json_codegen_reader& reader, const odata_codegen_enum_member* members, size_t count, bool is_flags)
+{
+	::odata::utility::string_t text;
+	reader.read_string(text);
+
+	int64_t value = 0;
+	size_t start = 0;
+	do
+	{
+		size_t comma = is_flags ? text.find(U(','), start) : ::odata::utility::string_t::npos;
+		size_t length = (comma == ::odata::utility::string_t::npos ? text.size() : comma) - start;
+
+		size_t i = 0;
+		while (i < count && text.compare(start, length, members[i].name) != 0)
+		{
+			i++;
+		}
+		if (i == count)
+		{
+			reader.fail(U("unknown enum member"));
+		}
+		value |= members[i].value;
+
+		start = comma == ::odata::utility::string_t::npos ? text.size() : comma + 1;
+	} while (start < text.size());
+
+	return value;
+}
+
+/// <summary>
+/// Serializes a generated type, or a collection of them, to JSON.
+/// </summary>
+template <typename T>
+::odata::utility::string_t odata_codegen_to_json(const T& value)
+{
+	::odata::utility::string_t out;
+	write_json(out, value);
+	return out;
+}
+
+/// <summary>
+/// Writes an entity set response: the context URL followed by the entities in a "value" array.
+/// </summary>
+template <typename T>
+void odata_codegen_write_entity_set(::odata::utility::string_t& out, const ::odata::utility::string_t& context_url, const std::vector<T>& entities)
+{
+	out += U("{\"@odata.context\":");
+	write_json(out, context_url);
+	out += U(",\"value\":");
+	write_json(out, entities);
+	out += U('}');
+}
+
+/// <summary>
+/// Reads a generated type, or a collection of them, from JSON; members the type does not declare are skipped.
+/// </summary>
+template <typename T>
+void odata_codegen_from_json(const ::odata::utility::string_t& json, T& value)
+{
+	odata_json_codegen_reader reader(json);
+	read_json(reader, value);
+	reader.end();
+}
+
+}}
@@ -9,6 +9,7 @@
 #include "odata/common/json.h"
 #include "odata/common/utility.h"
 #include "odata/core/odata_core.h"
+#include "odata/core/odata_delta_value.h"
 #include "odata/edm/odata_edm.h"
 
 namespace odata { namespace core
@@ -29,6 +30,12 @@ public:
 	ODATACPP_API std::shared_ptr<odata_collection_value> deserilize_entity_collection(const odata::utility::json::value& content, std::shared_ptr<::odata::edm::edm_entity_set> entity_set);
 	
 	ODATACPP_API std::shared_ptr<odata_value> deserilize_property(const odata::utility::json::value& content, std::shared_ptr<::odata::edm::edm_named_type> edm_type);
+
+	/// <summary>
+	/// Reads a delta payload of the entity set, which is taken from the $delta context URL when null.
+	/// Removed entities are recognized in both the OData 4.01 (@odata.removed) and 4.0 ($deletedEntity) formats.
+	/// </summary>
+	ODATACPP_API std::shared_ptr<odata_delta_value> deserilize_delta_value(const odata::utility::json::value& content, std::shared_ptr<::odata::edm::edm_entity_set> entity_set);
    
 private:
 	std::shared_ptr<odata_entity_value> handle_extract_entity_property(const odata::utility::json::value& value, std::shared_ptr<::odata::edm::edm_entity_type>& entity_type);
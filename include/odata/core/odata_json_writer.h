@@ -14,6 +14,7 @@
 #include "odata/core/odata_error.h"
 #include "odata/core/odata_entity_reference.h"
 #include "odata/core/odata_entity_reference_collection.h"
+#include "odata/core/odata_delta_value.h"
 
 namespace odata { namespace core
 {
@@ -27,10 +28,18 @@ namespace odata { namespace core
 #define ANNOTATION_ODATA_NEXT_LINK U("@odata.nextLink")
 #define ANNOTATION_ODATA_DELTA_LINK U("@odata.deltaLink")
 #define ANNOTATION_ODATA_TYPE U("@odata.type")
+#define ANNOTATION_ODATA_REMOVED U("@odata.removed")
 #define JSON_VALUE U("value")
 #define JSON_NAME U("name")
 #define JSON_KIND U("kind")
 #define JSON_URI U("uri")
+#define JSON_REASON U("reason")
+#define JSON_SOURCE U("source")
+#define JSON_RELATIONSHIP U("relationship")
+#define JSON_TARGET U("target")
+#define CONTEXT_DELTA U("/$delta")
+#define CONTEXT_LINK U("/$link")
+#define CONTEXT_DELETED_LINK U("/$deletedLink")
 
 #define JSON_ENTITYSET U("EntitySet");
 #define JSON_SINGLETON U("Singleton");
@@ -61,13 +70,20 @@ public:
 
     ODATACPP_API ::odata::utility::json::value serialize(std::shared_ptr<odata_entity_reference_collection> entity_reference_collection);
 
+	/// <summary>
+	/// Writes a delta payload in the OData 4.01 JSON format: changed entities as entities, removed entities with
+	/// @odata.removed and links with a $link or $deletedLink context.
+	/// </summary>
+	ODATACPP_API ::odata::utility::json::value serialize(std::shared_ptr<odata_delta_value> delta_value);
+
 private:
-	odata::utility::json::value serialize_odata_value(const std::shared_ptr<::odata::edm::edm_named_type>& property_type, const std::shared_ptr<odata_value>& property_value);
+	// Value types are passed as raw pointers: copying the shared pointer of a primitive type would contend on its reference count.
+	odata::utility::json::value serialize_odata_value(const ::odata::edm::edm_named_type* property_type, const std::shared_ptr<odata_value>& property_value);
     odata::utility::json::value seriliaze_structured_value(const std::shared_ptr<odata_structured_value>& p_value);
-	odata::utility::json::value serialize_primitive_value(const std::shared_ptr<::odata::edm::edm_primitive_type>& p_primitive_type, const std::shared_ptr<odata_primitive_value>& p_value);
+	odata::utility::json::value serialize_primitive_value(const ::odata::edm::edm_primitive_type* p_primitive_type, const std::shared_ptr<odata_primitive_value>& p_value);
 	odata::utility::json::value serialize_enum_value(const std::shared_ptr<odata_enum_value>& p_value);
     odata::utility::json::value serialize_collection_value(const std::shared_ptr<odata_collection_value>& p_value);
-	bool is_type_serializable(const std::shared_ptr<::odata::edm::edm_named_type>& property_type);
+	bool is_type_serializable(const ::odata::edm::edm_named_type* property_type);
     odata::utility::json::value serialize(std::shared_ptr<odata_service_document_element> service_document_element);
 	std::shared_ptr<::odata::edm::edm_model> m_model;
     ::odata::utility::uri m_service_root;
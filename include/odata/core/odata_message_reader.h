@@ -9,6 +9,7 @@
 #include "odata/common/utility.h"
 #include "odata/edm/odata_edm.h"
 #include "odata/core/odata_value.h"
+#include "odata/core/odata_delta_value.h"
 #include "odata/common/json.h"
 #include "odata/common/uri.h"
 
@@ -18,7 +19,7 @@ class odata_message_reader
 {
 public:
 	odata_message_reader(std::shared_ptr<::odata::edm::edm_model> model, ::odata::utility::uri base_uri, ::odata::utility::string_t message_body, bool is_response_message) 
-		: m_model(model), m_base_uri(base_uri), m_message_body(message_body), m_is_response_message(is_response_message)
+		: m_model(model), m_base_uri(base_uri), m_is_response_message(is_response_message), m_message_body(message_body)
 	{
 	}
 
@@ -33,9 +34,14 @@ public:
 	ODATACPP_API std::shared_ptr<::odata::core::odata_value> read_property(std::shared_ptr<::odata::edm::edm_named_type> edm_type);
 	ODATACPP_API std::shared_ptr<::odata::core::odata_value> read_property();
 
+	/// <summary>Reads a delta payload, the entity set is taken from the context URL when null.</summary>
+	ODATACPP_API std::shared_ptr<::odata::core::odata_delta_value> read_delta_value(std::shared_ptr<::odata::edm::edm_entity_set> entity_set = nullptr);
+
 	//ODATACPP_API std::shared_ptr<::odata::core::odata_batch_value> read_batch_value();
 
 private:
+	::odata::utility::json::value parse_message_body() const;
+
 	std::shared_ptr<::odata::edm::edm_model> m_model;
 	::odata::utility::uri m_base_uri;
 	bool m_is_response_message;
@@ -9,6 +9,7 @@
 #include "odata/common/utility.h"
 #include "odata/edm/odata_edm.h"
 #include "odata/edm/edm_model_writer.h"
+#include "odata/edm/edm_csdl_writer.h"
 #include "odata/core/odata_value.h"
 #include "odata/core/odata_json_writer.h"
 #include "odata/core/odata_service_document.h"
@@ -16,6 +17,7 @@
 #include "odata/core/odata_batch_part_value.h"
 #include "odata/core/odata_entity_reference.h"
 #include "odata/core/odata_entity_reference_collection.h"
+#include "odata/core/odata_delta_value.h"
 #include "odata/core/odata_error.h"
 #include "odata/common/json.h"
 #include "odata/common/uri.h"
@@ -33,12 +35,20 @@ public:
 
 	ODATACPP_API ::odata::utility::string_t write_service_document(std::shared_ptr<odata_service_document> service_document);
 
-	ODATACPP_API ::odata::utility::string_t write_metadata_document();
+	/// <summary>
+	/// Writes the $metadata document of the model, as CSDL XML unless CSDL JSON is requested.
+	/// </summary>
+	ODATACPP_API ::odata::utility::string_t write_metadata_document(::odata::edm::edm_csdl_format_t format = ::odata::edm::edm_csdl_format_t::Xml);
 
     ODATACPP_API ::odata::utility::string_t write_odata_value(std::shared_ptr<::odata::core::odata_value> value);
 
     ODATACPP_API ::odata::utility::string_t write_asynchronous_odata_value(std::shared_ptr<::odata::core::odata_value> value, int16_t status_code, ::odata::utility::string_t status_message, std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t> headers);
 
+    /// <summary>
+    /// Frames an error as the embedded application/http response of an asynchronous request.
+    /// </summary>
+    ODATACPP_API ::odata::utility::string_t write_asynchronous_odata_error(std::shared_ptr<::odata::core::odata_error> error, int16_t status_code, ::odata::utility::string_t status_message, std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t> headers);
+
     ODATACPP_API ::odata::utility::string_t write_odata_batch_value(std::shared_ptr<::odata::core::odata_batch_value> batch_value);
 
     ODATACPP_API ::odata::utility::string_t write_odata_error(std::shared_ptr<::odata::core::odata_error> error);
@@ -47,6 +57,11 @@ public:
 
     ODATACPP_API ::odata::utility::string_t write_odata_entity_reference_collection(std::shared_ptr<::odata::core::odata_entity_reference_collection> entity_reference_collection);
 
+    /// <summary>
+    /// Writes a delta payload, its context URL defaults to the $delta context of its entity set.
+    /// </summary>
+    ODATACPP_API ::odata::utility::string_t write_odata_delta_value(std::shared_ptr<::odata::core::odata_delta_value> delta_value);
+
 private:
 	std::shared_ptr<::odata::edm::edm_model> m_model;
 	::odata::utility::uri m_service_root;
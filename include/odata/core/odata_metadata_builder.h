@@ -40,9 +40,9 @@ public:
     {
         ::odata::utility::uri_builder builder(m_service_root);
         builder.append_path(entity_set->get_name() + entity_value->get_entity_key_string());
-        if (entity_value->get_value_type()->get_full_name() != entity_set->get_entity_type()->get_full_name())
+        if (entity_value->get_value_type_pointer()->get_full_name() != entity_set->get_entity_type()->get_full_name())
         {
-            builder.append_path(entity_value->get_value_type()->get_full_name());
+            builder.append_path(entity_value->get_value_type_pointer()->get_full_name());
         }
 
         return builder.to_uri();
@@ -0,0 +1,249 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_metrics.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include "odata/common/utility.h"
+
+namespace odata { namespace core
+{
+
+class odata_value;
+
+/// <summary>
+/// The stages of handling a request that report their duration to the metrics sink.
+/// </summary>
+enum odata_metrics_stage_t
+{
+	// Splitting the query of a request URI into options and decoding them.
+	UriSplit,
+	// Binding the resource path of a URI against the model.
+	PathBind,
+	// Parsing and binding $select, $expand, $filter, $orderby, $search and $apply.
+	ExpressionParse,
+	// Parsing payload text into a JSON value.
+	JsonParse,
+	// Building OData values from a JSON value, guided by the model.
+	Deserialize,
+	// Building the JSON value of an OData value.
+	Serialize,
+	// Writing the $metadata document.
+	MetadataRender,
+	StageCount
+};
+
+/// <summary>
+/// The quantities the library adds up in the metrics sink.
+/// </summary>
+enum odata_metrics_counter_t
+{
+	PayloadBytesRead,
+	PayloadBytesWritten,
+	EntitiesRead,
+	EntitiesWritten,
+	CounterCount
+};
+
+/// <summary>
+/// Receives the stage durations and counters reported by the library.
+/// </summary>
+/// <remarks>
+/// Sinks are called on whichever thread does the work, concurrently when requests are handled in parallel,
+/// and must be thread-safe. Durations are measured with std::chrono::steady_clock.
+/// </remarks>
+class odata_metrics_sink
+{
+public:
+	virtual ~odata_metrics_sink() {}
+
+	virtual void on_stage(odata_metrics_stage_t stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::duration duration) = 0;
+	virtual void on_counter(odata_metrics_counter_t counter, uint64_t value) = 0;
+};
+
+/// <summary>
+/// The process-wide metrics sink the library reports to.
+/// </summary>
+/// <remarks>
+/// Without a sink every instrumented stage costs one relaxed atomic load; nothing is timed or counted.
+/// </remarks>
+class odata_metrics
+{
+public:
+	/// <summary>
+	/// Installs the sink, or removes it when sink is null. Stages already running may still report to the previous sink.
+	/// </summary>
+	ODATACPP_API static void set_sink(std::shared_ptr<odata_metrics_sink> sink);
+	ODATACPP_API static std::shared_ptr<odata_metrics_sink> get_sink();
+
+	static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+	ODATACPP_API static const char* stage_name(odata_metrics_stage_t stage);
+	ODATACPP_API static const char* counter_name(odata_metrics_counter_t counter);
+
+	static void count(odata_metrics_counter_t counter, uint64_t value)
+	{
+		if (enabled())
+		{
+			report_counter(counter, value);
+		}
+	}
+
+	/// <summary>
+	/// Counts value as one entity, a collection of entities as its size and anything else as none.
+	/// </summary>
+	static void count_entities(odata_metrics_counter_t counter, const std::shared_ptr<odata_value>& value)
+	{
+		if (enabled())
+		{
+			report_entities(counter, value);
+		}
+	}
+
+	ODATACPP_API static void report_stage(odata_metrics_stage_t stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::duration duration);
+	ODATACPP_API static void report_counter(odata_metrics_counter_t counter, uint64_t value);
+
+private:
+	ODATACPP_API static void report_entities(odata_metrics_counter_t counter, const std::shared_ptr<odata_value>& value);
+
+	ODATACPP_API static std::atomic<bool> s_enabled;
+};
+
+/// <summary>
+/// Reports the time from its construction to its destruction as one run of a stage.
+/// </summary>
+class odata_stage_timer
+{
+public:
+	explicit odata_stage_timer(odata_metrics_stage_t stage) : m_stage(stage), m_enabled(odata_metrics::enabled())
+	{
+		if (m_enabled)
+		{
+			m_start = std::chrono::steady_clock::now();
+		}
+	}
+
+	~odata_stage_timer()
+	{
+		stop();
+	}
+
+	/// <summary>
+	/// Ends the run early; the timer reports nothing more.
+	/// </summary>
+	void stop()
+	{
+		if (m_enabled)
+		{
+			m_enabled = false;
+			odata_metrics::report_stage(m_stage, m_start, std::chrono::steady_clock::now() - m_start);
+		}
+	}
+
+private:
+	odata_stage_timer(const odata_stage_timer&);
+	odata_stage_timer& operator=(const odata_stage_timer&);
+
+	odata_metrics_stage_t m_stage;
+	bool m_enabled;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+/// <summary>
+/// Keeps a log2 histogram of the durations of every stage and the totals of every counter.
+/// </summary>
+/// <remarks>
+/// Recording is lock-free. Bucket i holds the runs that took [2^i, 2^(i+1)) nanoseconds, so percentiles are
+/// accurate to within a factor of two.
+/// </remarks>
+class odata_histogram_metrics_sink : public odata_metrics_sink
+{
+public:
+	static const size_t bucket_count = 48;
+
+	ODATACPP_API odata_histogram_metrics_sink();
+
+	ODATACPP_API void on_stage(odata_metrics_stage_t stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::duration duration);
+	ODATACPP_API void on_counter(odata_metrics_counter_t counter, uint64_t value);
+
+	uint64_t stage_count(odata_metrics_stage_t stage) const { return m_stages[stage].count.load(std::memory_order_relaxed); }
+	uint64_t stage_total_ns(odata_metrics_stage_t stage) const { return m_stages[stage].total_ns.load(std::memory_order_relaxed); }
+	uint64_t stage_max_ns(odata_metrics_stage_t stage) const { return m_stages[stage].max_ns.load(std::memory_order_relaxed); }
+	uint64_t bucket(odata_metrics_stage_t stage, size_t index) const { return m_stages[stage].buckets[index].load(std::memory_order_relaxed); }
+	uint64_t counter(odata_metrics_counter_t counter) const { return m_counters[counter].load(std::memory_order_relaxed); }
+
+	/// <summary>
+	/// Gets the upper bound, in nanoseconds, of the bucket holding the given percentile (0 to 100) of a stage's runs.
+	/// </summary>
+	ODATACPP_API uint64_t stage_percentile_ns(odata_metrics_stage_t stage, double percentile) const;
+
+	ODATACPP_API void reset();
+
+	/// <summary>
+	/// Writes one line per stage that ran (count, total, p50, p99, max) and one per non-zero counter.
+	/// </summary>
+	ODATACPP_API void write_summary(std::ostream& stream) const;
+
+private:
+	struct stage_histogram
+	{
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> total_ns;
+		std::atomic<uint64_t> max_ns;
+		std::atomic<uint64_t> buckets[bucket_count];
+	};
+
+	stage_histogram m_stages[StageCount];
+	std::atomic<uint64_t> m_counters[CounterCount];
+};
+
+/// <summary>
+/// Records every stage run and counter as an event of the Chrome trace event format.
+/// </summary>
+/// <remarks>
+/// The written document loads into chrome://tracing or Perfetto. Stage runs become complete ("X") events
+/// on the thread that ran them, counters become counter ("C") events holding the running total.
+/// Events are kept in memory until written or cleared; at most max_events are kept.
+/// </remarks>
+class odata_trace_event_metrics_sink : public odata_metrics_sink
+{
+public:
+	ODATACPP_API odata_trace_event_metrics_sink(size_t max_events = 1000000);
+
+	ODATACPP_API void on_stage(odata_metrics_stage_t stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::duration duration);
+	ODATACPP_API void on_counter(odata_metrics_counter_t counter, uint64_t value);
+
+	ODATACPP_API size_t event_count() const;
+	ODATACPP_API void clear();
+
+	/// <summary>
+	/// Writes the recorded events as a JSON trace document.
+	/// </summary>
+	ODATACPP_API void write(std::ostream& stream) const;
+
+private:
+	struct trace_event
+	{
+		// A stage, or StageCount plus a counter.
+		int kind;
+		uint64_t thread;
+		std::chrono::steady_clock::time_point start;
+		// The duration of a stage in nanoseconds or the total of a counter.
+		uint64_t value;
+	};
+
+	std::chrono::steady_clock::time_point m_origin;
+	size_t m_max_events;
+	mutable std::mutex m_mutex;
+	std::vector<trace_event> m_events;
+	uint64_t m_counter_totals[CounterCount];
+};
+
+}}
@@ -0,0 +1,167 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_model_registry.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include "odata/common/utility.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/edm/edm_csdl_writer.h"
+#include "odata/core/odata_uri_parser.h"
+
+namespace odata { namespace core
+{
+
+/// <summary>
+/// One published, frozen version of a service model together with everything derived from it.
+/// </summary>
+/// <remarks>
+/// A version is immutable once published. Whoever holds it keeps the model, its URI parser and its caches alive,
+/// so a request that pins a version at its start sees the same model to its end even if a newer version is
+/// published meanwhile. Derived data lives and dies with the version it was computed from and never has to be
+/// invalidated.
+/// </remarks>
+class odata_model_version
+{
+public:
+	ODATACPP_API ~odata_model_version();
+
+	uint64_t version() const { return m_version; }
+	std::shared_ptr<::odata::edm::edm_model> model() const { return m_model; }
+	const odata_uri_parser& uri_parser() const { return m_uri_parser; }
+
+	/// <summary>
+	/// Parses a URI against this version, reusing the result of an earlier parse of the same URI.
+	/// </summary>
+	ODATACPP_API std::shared_ptr<odata_uri> parse_uri(const ::odata::utility::uri& uri) const;
+
+	/// <summary>
+	/// Gets the $metadata document of this version in CSDL XML or CSDL JSON; each is written on first use only.
+	/// </summary>
+	ODATACPP_API const ::odata::utility::string_t& metadata_document(::odata::edm::edm_csdl_format_t format = ::odata::edm::edm_csdl_format_t::Xml) const;
+
+	/// <summary>
+	/// Gets data derived from this version, such as serialization plans, computing it on first use.
+	/// The key identifies the data and must always be used with the same type.
+	/// </summary>
+	template <typename T>
+	std::shared_ptr<T> get_or_create(const ::odata::utility::string_t& key, const std::function<std::shared_ptr<T>(const odata_model_version&)>& factory) const
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_cache_mutex);
+			auto found = m_derived.find(key);
+			if (found != m_derived.end())
+			{
+				return std::static_pointer_cast<T>(found->second);
+			}
+		}
+
+		// Computed outside the lock; if two threads race, the first one to finish wins.
+		std::shared_ptr<T> created = factory(*this);
+		std::lock_guard<std::mutex> lock(m_cache_mutex);
+		auto inserted = m_derived.insert(std::make_pair(key, std::static_pointer_cast<void>(created)));
+		return std::static_pointer_cast<T>(inserted.first->second);
+	}
+
+	size_t parsed_uri_count() const
+	{
+		std::lock_guard<std::mutex> lock(m_cache_mutex);
+		return m_parsed_uris.size();
+	}
+
+private:
+	friend class odata_model_registry;
+
+	odata_model_version(uint64_t version, std::shared_ptr<::odata::edm::edm_model> model, size_t uri_cache_capacity, std::function<void(uint64_t)> on_retired)
+		: m_version(version), m_model(model), m_uri_parser(model), m_uri_cache_capacity(uri_cache_capacity), m_on_retired(on_retired)
+	{
+	}
+
+	odata_model_version(const odata_model_version&);
+	odata_model_version& operator=(const odata_model_version&);
+
+	const uint64_t m_version;
+	const std::shared_ptr<::odata::edm::edm_model> m_model;
+	const odata_uri_parser m_uri_parser;
+	const size_t m_uri_cache_capacity;
+	const std::function<void(uint64_t)> m_on_retired;
+
+	mutable std::mutex m_cache_mutex;
+	mutable std::unordered_map<::odata::utility::string_t, std::shared_ptr<odata_uri>> m_parsed_uris;
+	mutable std::unordered_map<::odata::utility::string_t, std::shared_ptr<void>> m_derived;
+	mutable std::once_flag m_metadata_once[2];
+	mutable ::odata::utility::string_t m_metadata_document[2];
+};
+
+/// <summary>
+/// Publishes model versions to request handlers and replaces them while requests are in flight.
+/// </summary>
+/// <remarks>
+/// Readers call current() once per request and use the returned version throughout; this is a single atomic load
+/// and never waits for a writer. Writers publish a new version with an atomic pointer swap, RCU style: requests
+/// that already pinned the previous version finish on it, and the previous version, with its caches, is destroyed
+/// when the last of them lets go of it. Publishing freezes the model, so a published model is never changed in
+/// place; update() applies changes to a copy instead.
+/// </remarks>
+class odata_model_registry
+{
+public:
+	/// <param name="uri_cache_capacity">The number of parsed URIs each version keeps; 0 disables the cache.</param>
+	odata_model_registry(size_t uri_cache_capacity = 1024)
+		: m_uri_cache_capacity(uri_cache_capacity), m_last_version(0)
+	{
+	}
+
+	/// <summary>
+	/// Gets the current version, or null if nothing has been published yet.
+	/// </summary>
+	std::shared_ptr<const odata_model_version> current() const
+	{
+		return std::atomic_load(&m_current);
+	}
+
+	/// <summary>
+	/// Freezes a resolved model and makes it the current version.
+	/// </summary>
+	ODATACPP_API std::shared_ptr<const odata_model_version> publish(std::shared_ptr<::odata::edm::edm_model> model);
+
+	/// <summary>
+	/// Publishes a copy of the current model with the given changes applied, such as added entity sets.
+	/// Concurrent updates are applied one after the other and none of them is lost.
+	/// </summary>
+	ODATACPP_API std::shared_ptr<const odata_model_version> update(const std::function<void(std::shared_ptr<::odata::edm::edm_model>)>& change);
+
+	/// <summary>
+	/// Sets a callback run with the version number whenever a version published afterwards is destroyed.
+	/// The callback runs on the thread that released the version last and must not call back into the registry.
+	/// </summary>
+	void set_retired_callback(const std::function<void(uint64_t)>& on_retired)
+	{
+		std::lock_guard<std::mutex> lock(m_writer_mutex);
+		m_on_retired = on_retired;
+	}
+
+	/// <summary>
+	/// Gets the number of published versions still alive, the current one included.
+	/// </summary>
+	ODATACPP_API size_t live_version_count() const;
+
+private:
+	odata_model_registry(const odata_model_registry&);
+	odata_model_registry& operator=(const odata_model_registry&);
+
+	std::shared_ptr<const odata_model_version> publish_locked(std::shared_ptr<::odata::edm::edm_model> model);
+
+	std::shared_ptr<const odata_model_version> m_current;
+	const size_t m_uri_cache_capacity;
+	mutable std::mutex m_writer_mutex;
+	uint64_t m_last_version;
+	std::function<void(uint64_t)> m_on_retired;
+	mutable std::vector<std::weak_ptr<const odata_model_version>> m_published;
+};
+
+}}
@@ -15,7 +15,13 @@ namespace odata { namespace core
 class odata_primitive_value : public odata_value
 {
 public:
-    odata_primitive_value(std::shared_ptr<::odata::edm::edm_named_type>type, const ::odata::utility::string_t& stringRep) : odata_value(type), m_string_rep(stringRep)
+    odata_primitive_value(std::shared_ptr<::odata::edm::edm_named_type>type, const ::odata::utility::string_t& stringRep) : odata_value(std::move(type)), m_string_rep(stringRep)
+    {
+    }
+
+	template <typename T, typename = typename std::enable_if<std::is_base_of<::odata::edm::edm_named_type, T>::value
+		&& !std::is_same<::odata::edm::edm_named_type, T>::value>::type>
+    odata_primitive_value(const std::shared_ptr<T>& type, const ::odata::utility::string_t& stringRep) : odata_value(type), m_string_rep(stringRep)
     {
     }
 
@@ -0,0 +1,235 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_sql_translator.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/common/utility.h"
+#include "odata/core/odata_query_node.h"
+#include "odata/core/odata_query_node_visitor.h"
+#include "odata/core/odata_primitive_value.h"
+#include "odata/core/odata_uri.h"
+
+namespace odata { namespace core
+{
+
+/// <summary>
+/// SQL flavor used by odata_sql_translator: identifier quoting, parameter placeholders, null-safe comparison,
+/// paging and the templates of the canonical functions. Templates refer to their arguments as {0}, {1}, ...
+/// </summary>
+class odata_sql_dialect
+{
+public:
+	~odata_sql_dialect() {}
+
+	ODATACPP_API static std::shared_ptr<odata_sql_dialect> create_sqlite_dialect();
+	ODATACPP_API static std::shared_ptr<odata_sql_dialect> create_postgresql_dialect();
+	ODATACPP_API static std::shared_ptr<odata_sql_dialect> create_sql_server_dialect();
+
+	ODATACPP_API ::odata::utility::string_t quote_identifier(const ::odata::utility::string_t& name) const;
+
+	/// <summary>
+	/// Placeholder of the parameter with the given 1-based index; placeholders are numbered so that an argument
+	/// repeated by a template binds to the same value.
+	/// </summary>
+	::odata::utility::string_t parameter(::size_t index) const
+	{ return m_parameter_prefix + ::odata::utility::conversions::print_string(index); }
+
+	ODATACPP_API ::odata::utility::string_t function_call(
+		const ::odata::utility::string_t& name,
+		const std::vector<::odata::utility::string_t>& arguments) const;
+
+	/// <summary>
+	/// Registers or replaces the template of a function with the given number of arguments.
+	/// </summary>
+	ODATACPP_API void set_function_template(
+		const ::odata::utility::string_t& name,
+		::size_t arity,
+		const ::odata::utility::string_t& sql_template);
+
+	ODATACPP_API ::odata::utility::string_t not_distinct(const ::odata::utility::string_t& left, const ::odata::utility::string_t& right) const;
+	ODATACPP_API ::odata::utility::string_t distinct(const ::odata::utility::string_t& left, const ::odata::utility::string_t& right) const;
+
+	/// <summary>
+	/// Turns a boolean valued column or expression into a predicate.
+	/// </summary>
+	ODATACPP_API ::odata::utility::string_t is_true(const ::odata::utility::string_t& value) const;
+	ODATACPP_API ::odata::utility::string_t is_false(const ::odata::utility::string_t& value) const;
+
+	/// <summary>
+	/// Appends the paging clause; top or skip is empty when absent.
+	/// </summary>
+	ODATACPP_API void append_paging(
+		::odata::utility::string_t& sql,
+		const ::odata::utility::string_t& top,
+		const ::odata::utility::string_t& skip,
+		bool has_orderby) const;
+
+	ODATACPP_API static ::odata::utility::string_t render(
+		const ::odata::utility::string_t& sql_template,
+		const std::vector<::odata::utility::string_t>& arguments);
+
+private:
+	odata_sql_dialect() : m_offset_fetch(false) {}
+
+	::odata::utility::string_t m_quote_open;
+	::odata::utility::string_t m_quote_close;
+	::odata::utility::string_t m_parameter_prefix;
+	::odata::utility::string_t m_true_literal;
+	::odata::utility::string_t m_false_literal;
+	::odata::utility::string_t m_not_distinct_template;
+	::odata::utility::string_t m_distinct_template;
+	// LIMIT used when only $skip is given, empty when OFFSET may stand alone.
+	::odata::utility::string_t m_unbounded_limit;
+	bool m_offset_fetch;
+	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t> m_functions;
+};
+
+/// <summary>
+/// Maps an entity set onto a table: property paths onto columns and navigation properties onto joins.
+/// Unmapped property paths use the path with '/' replaced by '_' as column name.
+/// </summary>
+class odata_sql_table_mapping
+{
+public:
+	odata_sql_table_mapping(const ::odata::utility::string_t& table_name)
+		: m_table_name(table_name) {}
+	~odata_sql_table_mapping() {}
+
+	const ::odata::utility::string_t& table_name() const { return m_table_name; }
+
+	void map_property(const ::odata::utility::string_t& property_path, const ::odata::utility::string_t& column)
+	{ m_columns[property_path] = column; }
+
+	ODATACPP_API ::odata::utility::string_t column(const ::odata::utility::string_t& property_path) const;
+
+	/// <summary>
+	/// Maps a navigation property: rows of the target table whose target_column equals source_column of this table.
+	/// The target is held weakly so that mappings may refer to each other; the caller owns all mappings.
+	/// </summary>
+	ODATACPP_API void map_navigation(
+		const ::odata::utility::string_t& navigation_property,
+		std::shared_ptr<odata_sql_table_mapping> target,
+		const ::odata::utility::string_t& source_column,
+		const ::odata::utility::string_t& target_column,
+		bool is_collection);
+
+	struct navigation
+	{
+		std::weak_ptr<odata_sql_table_mapping> target;
+		::odata::utility::string_t source_column;
+		::odata::utility::string_t target_column;
+		bool is_collection;
+	};
+
+	const navigation *find_navigation(const ::odata::utility::string_t& navigation_property) const
+	{
+		auto found = m_navigations.find(navigation_property);
+		return found != m_navigations.end() ? &found->second : nullptr;
+	}
+
+private:
+	::odata::utility::string_t m_table_name;
+	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t> m_columns;
+	std::unordered_map<::odata::utility::string_t, navigation> m_navigations;
+};
+
+class odata_sql_statement
+{
+public:
+	odata_sql_statement(
+		const ::odata::utility::string_t& sql,
+		std::vector<std::shared_ptr<::odata::core::odata_primitive_value>> &&parameters)
+		: m_sql(sql),
+		m_parameters(parameters) {}
+	~odata_sql_statement() {}
+
+	const ::odata::utility::string_t& sql() const { return m_sql; }
+
+	/// <summary>
+	/// Values of the placeholders, parameters()[i] binds to placeholder i + 1.
+	/// </summary>
+	const std::vector<std::shared_ptr<::odata::core::odata_primitive_value>>& parameters() const { return m_parameters; }
+
+private:
+	::odata::utility::string_t m_sql;
+	std::vector<std::shared_ptr<::odata::core::odata_primitive_value>> m_parameters;
+};
+
+/// <summary>
+/// Translates $filter, $orderby, $top, $skip and $select into one parameterized SELECT so that the database does the
+/// filtering, sorting and paging. Literals are always bound as parameters. Null semantics follow OData: eq and ne are
+/// null-safe, and comparisons with null are false, so "not" of a comparison holds for null operands.
+/// any/all become correlated EXISTS subqueries and single-valued navigations become correlated scalar subqueries.
+/// has masks the integer value of an enum column with the flags and compares the result with the flags; the expression
+/// parser does not resolve enum literals, so the flags are given as their integer value, e.g. UserAccess has 3.
+/// </summary>
+class odata_sql_translator : public odata_query_node_visitor<::odata::utility::string_t>
+{
+public:
+	odata_sql_translator(
+		std::shared_ptr<odata_sql_dialect> dialect,
+		std::shared_ptr<odata_sql_table_mapping> mapping)
+		: m_dialect(dialect),
+		m_mapping(mapping),
+		m_alias_count(0) {}
+	~odata_sql_translator() {}
+
+	ODATACPP_API std::shared_ptr<odata_sql_statement> translate(std::shared_ptr<::odata::core::odata_uri> uri);
+
+	/// <summary>
+	/// SELECT COUNT(*) honoring $filter only, for $count.
+	/// </summary>
+	ODATACPP_API std::shared_ptr<odata_sql_statement> translate_count(std::shared_ptr<::odata::core::odata_uri> uri);
+
+	/// <summary>
+	/// Translates a filter expression to a predicate on the root table aliased t0.
+	/// </summary>
+	ODATACPP_API std::shared_ptr<odata_sql_statement> translate_filter(std::shared_ptr<::odata::core::odata_query_node> expression);
+
+	ODATACPP_API ::odata::utility::string_t visit(std::shared_ptr<::odata::core::odata_constant_node> node);
+	ODATACPP_API ::odata::utility::string_t visit(std::shared_ptr<::odata::core::odata_binary_operator_node> node);
+	ODATACPP_API ::odata::utility::string_t visit(std::shared_ptr<::odata::core::odata_unary_operator_node> node);
+	ODATACPP_API ::odata::utility::string_t visit(std::shared_ptr<::odata::core::odata_parameter_alias_node> node);
+	ODATACPP_API ::odata::utility::string_t visit(std::shared_ptr<::odata::core::odata_property_access_node> node);
+	ODATACPP_API ::odata::utility::string_t visit(std::shared_ptr<::odata::core::odata_type_cast_node> node);
+	ODATACPP_API ::odata::utility::string_t visit(std::shared_ptr<::odata::core::odata_lambda_node> node);
+	ODATACPP_API ::odata::utility::string_t visit(std::shared_ptr<::odata::core::odata_range_variable_node> node);
+	ODATACPP_API ::odata::utility::string_t visit(std::shared_ptr<::odata::core::odata_function_call_node> node);
+	ODATACPP_API ::odata::utility::string_t visit_any(std::shared_ptr<::odata::core::odata_query_node> node);
+
+private:
+	struct scope
+	{
+		::odata::utility::string_t range_variable;
+		::odata::utility::string_t alias;
+		std::shared_ptr<odata_sql_table_mapping> mapping;
+	};
+
+	void reset();
+	::odata::utility::string_t new_alias();
+	::odata::utility::string_t add_parameter(std::shared_ptr<::odata::core::odata_primitive_value> value);
+	::odata::utility::string_t translate_value(std::shared_ptr<::odata::core::odata_query_node> node);
+	::odata::utility::string_t translate_predicate(std::shared_ptr<::odata::core::odata_query_node> node);
+	::odata::utility::string_t translate_where(std::shared_ptr<::odata::core::odata_uri> uri);
+
+	// Walks a property path from its scope, collecting the joins of the navigations it crosses; returns the scope
+	// the remaining segments (from index next) are read from.
+	scope resolve_path(
+		std::shared_ptr<::odata::core::odata_query_node> node,
+		std::vector<::odata::utility::string_t>& segments,
+		::size_t& next,
+		bool stop_before_collection,
+		std::vector<::odata::utility::string_t>& from,
+		std::vector<::odata::utility::string_t>& conditions);
+
+	std::shared_ptr<odata_sql_dialect> m_dialect;
+	std::shared_ptr<odata_sql_table_mapping> m_mapping;
+	std::vector<scope> m_scopes;
+	std::vector<std::shared_ptr<::odata::core::odata_primitive_value>> m_parameters;
+	::size_t m_alias_count;
+};
+
+}}
@@ -12,6 +12,7 @@
 #include "odata/core/odata_select_expand_clause.h"
 #include "odata/core/odata_orderby_clause.h"
 #include "odata/core/odata_search_clause.h"
+#include "odata/core/odata_apply_clause.h"
 #include "odata/common/nullable.h"
 
 namespace odata { namespace core
@@ -28,7 +29,8 @@ public:
 		std::shared_ptr<::odata::core::odata_search_clause> search_clause,
 		::odata::common::nullable<int64_t> top,
 		::odata::common::nullable<int64_t> skip,
-		::odata::common::nullable<bool> count)
+		::odata::common::nullable<bool> count,
+		std::shared_ptr<::odata::core::odata_apply_clause> apply_clause = nullptr)
 		: m_path(path),
 		m_select_expand_clause(select_expand_clause),
 		m_filter_clause(filter_clause),
@@ -36,7 +38,8 @@ public:
 		m_search_clause(search_clause),
 		m_top(top),
 		m_skip(skip),
-		m_count(count) {}
+		m_count(count),
+		m_apply_clause(apply_clause) {}
 	~odata_uri() {}
 
 	static std::shared_ptr<odata_uri> create_uri(
@@ -47,7 +50,8 @@ public:
 		std::shared_ptr<::odata::core::odata_search_clause> search_clause,
 		::odata::common::nullable<int64_t> top,
 		::odata::common::nullable<int64_t> skip,
-		::odata::common::nullable<bool> count);
+		::odata::common::nullable<bool> count,
+		std::shared_ptr<::odata::core::odata_apply_clause> apply_clause = nullptr);
 
 	std::shared_ptr<::odata::core::odata_path> path() const { return m_path; }
 
@@ -65,6 +69,13 @@ public:
 
 	::odata::common::nullable<bool> count() const { return m_count; }
 
+	std::shared_ptr<::odata::core::odata_apply_clause> apply_clause() const { return m_apply_clause; }
+
+	/// <summary>The $deltatoken of a delta link, empty when absent.</summary>
+	const ::odata::utility::string_t& delta_token() const { return m_delta_token; }
+
+	void set_delta_token(::odata::utility::string_t delta_token) { m_delta_token = std::move(delta_token); }
+
 	bool is_service_document() const { return m_path->empty(); }
 
 	bool is_metadata_document() const { return m_path->single(::odata::core::odata_path_segment_type::Metadata); }
@@ -79,6 +90,10 @@ private:
 	::odata::common::nullable<int64_t> m_top;
 	::odata::common::nullable<int64_t> m_skip;
 	::odata::common::nullable<bool> m_count;
+
+	std::shared_ptr<::odata::core::odata_apply_clause> m_apply_clause;
+
+	::odata::utility::string_t m_delta_token;
 };
 
 }}
\ No newline at end of file
@@ -16,6 +16,7 @@
 #include "odata/core/odata_filter_clause.h"
 #include "odata/core/odata_orderby_clause.h"
 #include "odata/core/odata_search_clause.h"
+#include "odata/core/odata_apply_clause.h"
 #include "odata/core/odata_uri.h"
 #include "odata/core/odata_exception.h"
 #include "odata/core/odata_query_node.h"
@@ -53,14 +54,18 @@ private:
 	void bind_first_segment(const ::odata::utility::string_t &segment_str);
 	void bind_next_segment(const ::odata::utility::string_t &segment_str);
 
-	bool try_bind_as_navigation_source(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &key_exp);
-	bool try_bind_as_operation_import(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &parameters_exp);
+	bool try_bind_as_navigation_source(const ::odata::edm::edm_container_symbol &symbol, const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &key_exp);
+	bool try_bind_as_operation_import(const ::odata::edm::edm_container_symbol &symbol, const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &parameters_exp);
     bool try_bind_as_value(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &empty_exp);
 	bool try_bind_as_count(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &empty_exp);
 	bool try_bind_as_ref(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &empty_exp);
     bool try_bind_as_declared_property(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &key_exp);
     bool try_bind_as_type(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &empty_exp);
     bool try_bind_as_operation(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &parameters_exp);
+
+    void bind_as_declared_property(const std::shared_ptr<::odata::edm::edm_structured_type> &owning_type, const std::shared_ptr<::odata::edm::edm_property_type> &property,
+        const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &key_exp);
+    void bind_as_operation(const std::shared_ptr<::odata::edm::edm_operation_type> &operation, const ::odata::utility::string_t &parameters_exp);
     
     void bind_as_key(const ::odata::utility::string_t &key_exp);
     void bind_as_dynamic_property(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &empty_exp);
@@ -211,6 +216,8 @@ private:
     ::odata::common::nullable<bool> m_count;
 };
 
+class odata_expression_lexer;
+
 class odata_query_option_parser
 {
 public:
@@ -237,6 +244,7 @@ public:
 	::odata::common::nullable<int64_t> parse_top(const ::odata::utility::string_t& top_query);
 	::odata::common::nullable<int64_t> parse_skip(const ::odata::utility::string_t& skip_query);
 	::odata::common::nullable<bool> parse_count(const ::odata::utility::string_t& count_query);
+	std::shared_ptr<::odata::core::odata_apply_clause> parse_apply(const ::odata::utility::string_t& apply_query);
 
 private:
     odata_query_option_parser(const odata_query_option_parser &);
@@ -248,6 +256,13 @@ private:
     std::vector<std::shared_ptr<::odata::core::odata_select_item>> parse_select(const ::odata::utility::string_t& select_query);
     std::vector<std::shared_ptr<::odata::core::odata_expand_item>> parse_expand(const ::odata::utility::string_t& expand_query);
 
+	std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>> parse_apply_transformations(
+		std::shared_ptr<odata_expression_lexer> lexer);
+	std::shared_ptr<::odata::core::odata_apply_transformation> parse_apply_transformation(
+		std::shared_ptr<odata_expression_lexer> lexer);
+	std::shared_ptr<::odata::core::odata_aggregate_expression> parse_aggregate_expression(
+		std::shared_ptr<odata_expression_lexer> lexer);
+
 private:
 	std::weak_ptr<::odata::edm::edm_model> m_model;
     std::shared_ptr<::odata::edm::edm_named_type> m_target_type;
@@ -440,6 +455,14 @@ private:
 	int m_parser_subject;
 };
 
+/// <summary>
+/// Parses request URIs against a model. The parser holds no per-request state: every call binds the path and the
+/// query options with its own short-lived odata_path_parser and odata_query_option_parser, so one instance can be
+/// shared by any number of threads without locking as long as the model is not modified while parsing.
+/// The standalone parse_* methods for query options bind without a target type, so $select, $expand, $filter,
+/// $orderby and $apply throw an odata_exception on non-empty input; use parse_uri or the overloads taking the target
+/// type and navigation source (e.g. those of a parsed path) to bind them.
+/// </summary>
 class odata_uri_parser
 {
 public:
@@ -447,20 +470,38 @@ public:
 		: m_model(model) {}
 	~odata_uri_parser() {}
 
-	ODATACPP_API std::shared_ptr<::odata::core::odata_path> parse_path(const ::odata::utility::string_t& path);
+	ODATACPP_API std::shared_ptr<::odata::core::odata_path> parse_path(const ::odata::utility::string_t& path) const;
 	ODATACPP_API std::shared_ptr<::odata::core::odata_select_expand_clause> parse_select_and_expand(
         const ::odata::utility::string_t& select_query,
-        const ::odata::utility::string_t& expand_query);
+        const ::odata::utility::string_t& expand_query) const;
+	ODATACPP_API std::shared_ptr<::odata::core::odata_select_expand_clause> parse_select_and_expand(
+        const ::odata::utility::string_t& select_query,
+        const ::odata::utility::string_t& expand_query,
+        std::shared_ptr<::odata::edm::edm_named_type> target_type,
+        std::shared_ptr<::odata::edm::edm_navigation_source> target_navigation_source) const;
+	ODATACPP_API std::shared_ptr<::odata::core::odata_filter_clause> parse_filter(
+        const ::odata::utility::string_t& filter_query) const;
 	ODATACPP_API std::shared_ptr<::odata::core::odata_filter_clause> parse_filter(
-        const ::odata::utility::string_t& filter_query);
+        const ::odata::utility::string_t& filter_query,
+        std::shared_ptr<::odata::edm::edm_named_type> target_type,
+        std::shared_ptr<::odata::edm::edm_navigation_source> target_navigation_source) const;
 	ODATACPP_API std::shared_ptr<::odata::core::odata_orderby_clause> parse_orderby(
-        const ::odata::utility::string_t& orderby_query);
+        const ::odata::utility::string_t& orderby_query) const;
+	ODATACPP_API std::shared_ptr<::odata::core::odata_orderby_clause> parse_orderby(
+        const ::odata::utility::string_t& orderby_query,
+        std::shared_ptr<::odata::edm::edm_named_type> target_type,
+        std::shared_ptr<::odata::edm::edm_navigation_source> target_navigation_source) const;
 	ODATACPP_API std::shared_ptr<::odata::core::odata_search_clause> parse_search(
-        const ::odata::utility::string_t& search_query);
-	ODATACPP_API ::odata::common::nullable<int64_t> parse_top(const ::odata::utility::string_t& top_query);
-	ODATACPP_API ::odata::common::nullable<int64_t> parse_skip(const ::odata::utility::string_t& skip_query);
-	ODATACPP_API ::odata::common::nullable<bool> parse_count(const ::odata::utility::string_t& count_query);
-	ODATACPP_API std::shared_ptr<::odata::core::odata_uri> parse_uri(const ::odata::utility::uri &uri);
+        const ::odata::utility::string_t& search_query) const;
+	ODATACPP_API ::odata::common::nullable<int64_t> parse_top(const ::odata::utility::string_t& top_query) const;
+	ODATACPP_API ::odata::common::nullable<int64_t> parse_skip(const ::odata::utility::string_t& skip_query) const;
+	ODATACPP_API ::odata::common::nullable<bool> parse_count(const ::odata::utility::string_t& count_query) const;
+	ODATACPP_API std::shared_ptr<::odata::core::odata_apply_clause> parse_apply(const ::odata::utility::string_t& apply_query) const;
+	ODATACPP_API std::shared_ptr<::odata::core::odata_apply_clause> parse_apply(
+        const ::odata::utility::string_t& apply_query,
+        std::shared_ptr<::odata::edm::edm_named_type> target_type,
+        std::shared_ptr<::odata::edm::edm_navigation_source> target_navigation_source) const;
+	ODATACPP_API std::shared_ptr<::odata::core::odata_uri> parse_uri(const ::odata::utility::uri &uri) const;
     
     std::shared_ptr<::odata::edm::edm_model> model() const { return m_model.lock(); }
 
@@ -470,16 +511,13 @@ private:
     odata_uri_parser(const odata_uri_parser &);
     odata_uri_parser &operator=(const odata_uri_parser &);
     
-    std::shared_ptr<odata_path_parser> path_parser();
-	std::shared_ptr<odata_query_option_parser> query_option_parser();
+	std::shared_ptr<odata_query_option_parser> unbound_query_option_parser() const;
 
 	static ::size_t advance_through_string_literal(const ::odata::utility::string_t &query, ::size_t start);
 	static ::size_t advance_through_balanced_parenthesis(const ::odata::utility::string_t &query, ::size_t start);
 
 private:
-    std::weak_ptr<::odata::edm::edm_model> m_model;
-	std::shared_ptr<odata_path_parser> m_path_parser;
-	std::shared_ptr<odata_query_option_parser> m_query_option_parser;
+    const std::weak_ptr<::odata::edm::edm_model> m_model;
 };
 
 }}
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <type_traits>
 #include "odata/edm/odata_edm.h"
 #include "odata/core/odata_property_map.h"
 #include "odata/core/odata_operation.h"
@@ -19,20 +20,42 @@ class odata_value
 {
 public:
     /// <summary>Default constructor</summary>
-    odata_value() : m_property_type(std::make_shared<::odata::edm::edm_named_type>()), m_is_null_value(), m_is_top_level(){}
+    odata_value() : m_static_type(nullptr), m_property_type(std::make_shared<::odata::edm::edm_named_type>()), m_is_null_value(), m_is_top_level(){}
 
     odata_value(std::shared_ptr<::odata::edm::edm_named_type>type, bool is_null_value = false) 
-		: m_property_type(type), m_is_null_value(is_null_value), m_is_top_level()
+		: m_static_type(::odata::edm::edm_named_type::find_static_owner(type.get())), m_is_null_value(is_null_value), m_is_top_level()
 	{
+		if (!m_static_type)
+		{
+			m_property_type = std::move(type);
+		}
+	}
+
+	/// <summary>Constructs a value of a derived type, e.g. a primitive type, without copying the pointer that owns the type.
+	/// Only shared pointers of a derived type deduce here, so odata_value(nullptr) still resolves to the constructor above.</summary>
+	template <typename T, typename = typename std::enable_if<std::is_base_of<::odata::edm::edm_named_type, T>::value
+		&& !std::is_same<::odata::edm::edm_named_type, T>::value>::type>
+    odata_value(const std::shared_ptr<T>& type, bool is_null_value = false) 
+		: m_static_type(::odata::edm::edm_named_type::find_static_owner(type.get())), m_is_null_value(is_null_value), m_is_top_level()
+	{
+		if (!m_static_type)
+		{
+			m_property_type = type;
+		}
 	}
 
     virtual ~odata_value(){};
 
-    std::shared_ptr<::odata::edm::edm_named_type> get_value_type() const { return m_property_type; }
+    std::shared_ptr<::odata::edm::edm_named_type> get_value_type() const { return m_static_type ? *m_static_type : m_property_type; }
+
+	/// <summary>The value type without taking a reference on it, for hot paths that only inspect the type.
+	/// The pointer is valid while this value is alive and until set_value_type is called.</summary>
+	const ::odata::edm::edm_named_type* get_value_type_pointer() const { return m_static_type ? m_static_type->get() : m_property_type.get(); }
 
 	void set_value_type(std::shared_ptr<::odata::edm::edm_named_type> property_type)
 	{
-		m_property_type = property_type;
+		m_static_type = ::odata::edm::edm_named_type::find_static_owner(property_type.get());
+		m_property_type = m_static_type ? nullptr : std::move(property_type);
 	}
 
     void set_is_top_level(bool is_top_level)
@@ -112,6 +135,9 @@ private:
     friend class entity;
     friend class odata_property_map;
 
+    // Process-wide types such as the primitive types are referenced through their permanent owner, so creating,
+    // copying and destroying values of those types never touches a shared reference count.
+    const std::shared_ptr<::odata::edm::edm_named_type>* m_static_type;
     std::shared_ptr<::odata::edm::edm_named_type> m_property_type;
 	bool m_is_null_value;
     bool m_is_top_level;
@@ -0,0 +1,122 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_csdl_writer.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/edm/odata_edm.h"
+#include <cstring>
+
+namespace odata { namespace edm
+{
+
+/// <summary>
+/// The representation edm_csdl_writer emits a model in.
+/// </summary>
+enum edm_csdl_format_t
+{
+	// The CSDL XML document served as $metadata.
+	Xml,
+	// The CSDL JSON document defined by OData 4.01.
+	Json
+};
+
+/// <summary>
+/// Writes the $metadata document of a model straight to a stream or a string.
+/// </summary>
+/// <remarks>
+/// Unlike edm_model_writer, which builds the document through libxml2 and hands it over as one string, this writer
+/// escapes and formats in place into a small buffer that is flushed to the output as it fills. The XML output is
+/// byte-identical to edm_model_writer's; the JSON output describes the same elements with the CSDL JSON members
+/// ($Kind, $Type, $Collection, $Nullable and so on), where structured and enum types are namespace-qualified.
+/// </remarks>
+class edm_csdl_writer
+{
+public:
+	edm_csdl_writer(std::ostream& stream, edm_csdl_format_t format = edm_csdl_format_t::Xml)
+		: m_stream(&stream), m_output(nullptr), m_format(format), m_used(0), m_start_tag_open(false), m_need_comma(false)
+	{
+	}
+
+	edm_csdl_writer(std::string& output, edm_csdl_format_t format = edm_csdl_format_t::Xml)
+		: m_stream(nullptr), m_output(&output), m_format(format), m_used(0), m_start_tag_open(false), m_need_comma(false)
+	{
+	}
+
+	ODATACPP_API void write_model(std::shared_ptr<edm_model> model);
+
+	/// <summary>
+	/// Writes the model into a new string_t.
+	/// </summary>
+	ODATACPP_API static ::odata::utility::string_t write_model_to_string(std::shared_ptr<edm_model> model, edm_csdl_format_t format = edm_csdl_format_t::Xml);
+
+private:
+	edm_csdl_writer(const edm_csdl_writer&);
+	edm_csdl_writer& operator=(const edm_csdl_writer&);
+
+	void put(char c)
+	{
+		if (m_used == sizeof(m_buffer))
+		{
+			flush();
+		}
+		m_buffer[m_used++] = c;
+	}
+
+	void put(const char* data, size_t size);
+	void put(const char* text) { put(text, std::strlen(text)); }
+	void put_escaped(const ::odata::utility::string_t& text);
+	void put_number(uint64_t value);
+	void flush();
+
+	void start_element(const char* name);
+	void attribute(const char* name, const ::odata::utility::string_t& value);
+	void attribute(const char* name, const char* value);
+	void attribute(const char* name, uint64_t value);
+	void text(const ::odata::utility::string_t& value);
+	void end_element();
+
+	void write_xml_schema(const std::shared_ptr<edm_schema>& schema);
+	void write_xml_property(const std::shared_ptr<edm_property_type>& property, bool write_facets);
+	void write_xml_entity_type(const std::shared_ptr<edm_entity_type>& entity_type);
+	void write_xml_operation(const std::shared_ptr<edm_operation_type>& operation);
+	void write_xml_navigation_source(const char* element, const std::shared_ptr<edm_navigation_source>& navigation_source, const ::odata::utility::string_t& entity_type_name);
+	void write_xml_entity_container(const std::shared_ptr<edm_entity_container>& entity_container);
+
+	void begin_object();
+	void end_object();
+	void begin_array();
+	void end_array();
+	void member(const char* name);
+	void member(const ::odata::utility::string_t& name);
+	void kind(const char* kind);
+	void value(const ::odata::utility::string_t& text);
+	void value(bool flag);
+	void value(uint64_t number);
+	void json_type(const std::shared_ptr<edm_named_type>& type);
+
+	void write_json_schema(const std::shared_ptr<edm_schema>& schema);
+	void write_json_property(const std::shared_ptr<edm_property_type>& property);
+	void write_json_entity_type(const std::shared_ptr<edm_entity_type>& entity_type);
+	void write_json_operation(const std::shared_ptr<edm_operation_type>& operation);
+	void write_json_navigation_source(const std::shared_ptr<edm_navigation_source>& navigation_source, const ::odata::utility::string_t& entity_type_name, bool collection);
+	void write_json_entity_container(const std::shared_ptr<edm_entity_container>& entity_container);
+
+	std::ostream* m_stream;
+	std::string* m_output;
+	edm_csdl_format_t m_format;
+	char m_buffer[4096];
+	size_t m_used;
+	// XML: names of the open elements, and whether the innermost start tag still waits for its '>'.
+	std::vector<const char*> m_elements;
+	bool m_start_tag_open;
+	// XML: non-key properties of the entity type being written, reused across types.
+	std::vector<const std::shared_ptr<edm_property_type>*> m_deferred_properties;
+	std::vector<const std::shared_ptr<edm_property_type>*> m_deferred_navigation_properties;
+	// JSON: whether the next member or array element needs a separating comma.
+	bool m_need_comma;
+};
+
+}}
@@ -14,6 +14,19 @@
 namespace odata { namespace edm
 {
 
+/// <summary>
+/// What the first segment of a URL path refers to; see edm_entity_container::find_symbol.
+/// </summary>
+/// <remarks>
+/// Names are unique within a container, so at most one member is set for a valid model.
+/// </remarks>
+struct edm_container_symbol
+{
+	std::shared_ptr<edm_entity_set> entity_set;
+	std::shared_ptr<edm_singleton> singleton;
+	std::shared_ptr<edm_operation_import> operation_import;
+};
+
 /// <summary>
 /// Represents a container of entities
 /// </summary>
@@ -25,7 +38,7 @@ public:
     /// </summary>
     /// <param name="name">The name of the entity container.</param>
     edm_entity_container(::odata::utility::string_t name, bool is_default) : 
-        m_name(name), m_is_default(is_default)
+        m_name(name), m_is_default(is_default), m_frozen(false)
     {
     }
 
@@ -59,10 +72,12 @@ public:
     /// </summary>
     void add_entity_set(std::shared_ptr<edm_entity_set> et)
     {
+		throw_if_frozen(m_frozen);
 		if (et)
 		{
 		    m_entity_sets[et->get_name()] = et;
             m_entity_set_vector.push_back(et);
+			m_symbols[et->get_name()].entity_set = et;
 		}
     }
 
@@ -71,10 +86,12 @@ public:
     /// </summary>
 	void add_singleton(std::shared_ptr<edm_singleton> sg)
 	{
+		throw_if_frozen(m_frozen);
 		if (sg)
 		{
 			m_singletons[sg->get_name()] = sg;
             m_singleton_vector.push_back(sg);
+			m_symbols[sg->get_name()].singleton = sg;
 		}
 	}
 
@@ -111,10 +128,12 @@ public:
     /// </summary>
 	void add_operation_import(std::shared_ptr<edm_operation_import> op)
 	{
+		throw_if_frozen(m_frozen);
 		if (op)
 		{
 		    m_operation_imports[op->get_name()] = op;
             m_operation_import_vector.push_back(op);
+			m_symbols[op->get_name()].operation_import = op;
 		}
 	}
 
@@ -155,10 +174,23 @@ public:
     /// <returns>A pointer to the type if found, an empty pointer otherwise.</returns>
     ODATACPP_API std::shared_ptr<edm_operation_import> find_operation_import(::odata::utility::string_t name) const;
 
+    /// <summary>
+    /// Looks up the entity set, singleton or operation import of the given name with a single probe.
+    /// </summary>
+    /// <param name="name">The unqualified name.</param>
+    /// <returns>The symbol if found, nullptr otherwise.</returns>
+    const edm_container_symbol* find_symbol(const ::odata::utility::string_t& name) const
+	{
+		auto find_iter = m_symbols.find(name);
+		return find_iter == m_symbols.end() ? nullptr : &find_iter->second;
+	}
+
 private:
     friend class edm_schema;
+    friend class edm_model;
 
     bool m_is_default;
+    bool m_frozen;
     ::odata::utility::string_t m_name;
 	::odata::utility::string_t m_extends;
 	std::unordered_map<::odata::utility::string_t, std::shared_ptr<edm_entity_set>> m_entity_sets;
@@ -167,7 +199,7 @@ private:
     std::vector<std::shared_ptr<edm_entity_set>> m_entity_set_vector;
 	std::vector<std::shared_ptr<edm_singleton>> m_singleton_vector;
 	std::vector<std::shared_ptr<edm_operation_import>> m_operation_import_vector;
-
+	std::unordered_map<::odata::utility::string_t, edm_container_symbol> m_symbols;
 };
 
 }}
\ No newline at end of file
@@ -12,9 +12,34 @@
 namespace odata { namespace edm
 {
 
+/// <summary>
+/// How the type references of a freshly parsed model are resolved.
+/// </summary>
+enum edm_type_resolution_t
+{
+	// Resolve everything on the calling thread before parsing returns.
+	Eager,
+	// Resolve the properties of structured types and operations on a pool of threads; the result is the same as Eager.
+	Parallel,
+	// Resolve the properties of each structured type the first time they are accessed.
+	Lazy
+};
+
+/// <summary>
+/// Represents an entity data model made of one or more schemas.
+/// </summary>
+/// <remarks>
+/// A resolved model can be frozen with freeze(): it then rejects further changes and numbers its declared
+/// types, properties, navigation properties, entity sets and singletons, and operations with dense identifiers
+/// that index the vectors returned by get_types(), get_properties() and the like. A frozen model is only ever
+/// read and can be shared across threads without locking.
+/// </remarks>
 class edm_model
 {
 public:
+    edm_model() : m_frozen(false)
+    {
+    }
 
 #ifdef _MS_WINDOWS_DEBUG
 	~edm_model()
@@ -37,6 +62,7 @@ public:
     
     std::shared_ptr<edm_schema> add_schema(const ::odata::utility::string_t& name, const ::odata::utility::string_t& alias)
     {
+        throw_if_frozen(m_frozen);
         auto val = std::make_shared<edm_schema>(name, alias);
         m_schemata.push_back(val);
         return val;
@@ -54,9 +80,66 @@ public:
 
 	void set_version(const ::odata::utility::string_t& version)
 	{
+		throw_if_frozen(m_frozen);
 		m_version = version;
 	}
 
+    /// <summary>
+    /// Makes the model read-only and assigns the dense identifiers; types must already be resolved.
+    /// </summary>
+    /// <remarks>
+    /// Types are numbered schema by schema (enum, complex, entity and operation types, each sorted by name),
+    /// properties in the declaration order of their types, and entity sets before singletons of each container.
+    /// Freezing also builds the symbol tables that URL path binding probes: edm_structured_type::find_symbol and
+    /// the name index behind find_structured_type. Freezing a frozen model does nothing. Must not run concurrently with any other use of the model.
+    /// </remarks>
+    ODATACPP_API void freeze();
+
+    bool is_frozen() const
+    {
+        return m_frozen;
+    }
+
+    /// <summary>
+    /// Gets the declared types of a frozen model, indexed by edm_named_type::get_id().
+    /// </summary>
+    const std::vector<std::shared_ptr<edm_named_type>>& get_types() const
+    {
+        return m_types;
+    }
+
+    /// <summary>
+    /// Gets the properties of a frozen model, indexed by edm_property_type::get_id().
+    /// </summary>
+    const std::vector<std::shared_ptr<edm_property_type>>& get_properties() const
+    {
+        return m_properties;
+    }
+
+    /// <summary>
+    /// Gets the navigation properties of a frozen model, indexed by edm_property_type::get_navigation_id().
+    /// </summary>
+    const std::vector<std::shared_ptr<edm_property_type>>& get_navigation_properties() const
+    {
+        return m_navigation_properties;
+    }
+
+    /// <summary>
+    /// Gets the entity sets and singletons of a frozen model, indexed by edm_navigation_source::get_id().
+    /// </summary>
+    const std::vector<std::shared_ptr<edm_navigation_source>>& get_navigation_sources() const
+    {
+        return m_navigation_sources;
+    }
+
+    /// <summary>
+    /// Gets the operations of a frozen model, indexed by edm_operation_type::get_operation_id().
+    /// </summary>
+    const std::vector<std::shared_ptr<edm_operation_type>>& get_operations() const
+    {
+        return m_operations;
+    }
+
     /// <summary>
     /// Looks up an entity type of the schema by name.
     /// </summary>
@@ -71,6 +154,13 @@ public:
     /// <returns>A pointer to the type if found, an empty pointer otherwise.</returns>
     ODATACPP_API std::shared_ptr<edm_complex_type> find_complex_type(::odata::utility::string_t name) const;
 
+    /// <summary>
+    /// Looks up an entity type, or failing that a complex type, by name; a frozen model answers with a single probe.
+    /// </summary>
+    /// <param name="name">The qualified or unqualified name of the type.</param>
+    /// <returns>A pointer to the type if found, an empty pointer otherwise.</returns>
+    ODATACPP_API std::shared_ptr<edm_structured_type> find_structured_type(const ::odata::utility::string_t& name) const;
+
 	/// <summary>
     /// Looks up an enum type of the schema by name.
     /// </summary>
@@ -93,8 +183,20 @@ public:
     ODATACPP_API std::shared_ptr<edm_entity_container> find_container(::odata::utility::string_t name = U("")) const;
 
 private:
+    void freeze_structured_type(const std::shared_ptr<edm_structured_type>& structured_type);
+    void build_symbol_tables();
+
     std::vector<std::shared_ptr<edm_schema>> m_schemata;
 	::odata::utility::string_t  m_version;
+
+	bool m_frozen;
+	std::vector<std::shared_ptr<edm_named_type>> m_types;
+	std::vector<std::shared_ptr<edm_property_type>> m_properties;
+	std::vector<std::shared_ptr<edm_property_type>> m_navigation_properties;
+	std::vector<std::shared_ptr<edm_navigation_source>> m_navigation_sources;
+	std::vector<std::shared_ptr<edm_operation_type>> m_operations;
+	std::unordered_map<::odata::utility::string_t, std::shared_ptr<edm_structured_type>> m_structured_types_by_name;
+	std::shared_ptr<edm_entity_container> m_default_container;
 };
 
 }}
@@ -0,0 +1,70 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_model_code_generator.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/edm/odata_edm.h"
+
+namespace odata { namespace edm
+{
+
+/// <summary>
+/// Generates a C++ header with strongly typed structs, property tables and JSON serializers for a resolved model.
+/// </summary>
+/// <remarks>
+/// Every enum type becomes an enum class and every complex and entity type a struct deriving from the struct of its
+/// base type, nested in root_namespace and then in one namespace per part of the schema namespace. Each struct lists
+/// its properties, inherited ones first, in a static table and comes with write_json and read_json overloads built on
+/// odata/core/odata_json_codegen.h that read and write the members directly.
+/// Structural properties map to the types given by edm_model_utility::get_strong_type_name_from_edm_type_name;
+/// nullable numbers, booleans and enums use ::odata::common::nullable and nullable complex values std::shared_ptr,
+/// while other nullable values read null as their default value. Navigation properties and properties of types
+/// without a C++ counterpart, such as the geography types, are left out and skipped when reading.
+/// The output depends only on the model, so regenerating an unchanged model gives an identical header.
+/// </remarks>
+class edm_model_code_generator
+{
+public:
+	edm_model_code_generator(std::ostream& stream, const std::string& root_namespace = "odata_model")
+		: m_stream(stream), m_root_namespace(root_namespace)
+	{
+	}
+
+	ODATACPP_API void write_model(std::shared_ptr<edm_model> model);
+
+private:
+	edm_model_code_generator(const edm_model_code_generator&);
+	edm_model_code_generator& operator=(const edm_model_code_generator&);
+
+	struct generated_member
+	{
+		std::shared_ptr<edm_property_type> property;
+		std::string identifier;
+		std::string cpp_type;
+	};
+
+	void collect(std::shared_ptr<edm_model> model);
+	void order_structured_type(edm_structured_type* structured_type, std::unordered_map<const edm_structured_type*, int>& states);
+	std::string cpp_type_of(const std::shared_ptr<edm_named_type>& type, bool is_nullable, std::vector<edm_structured_type*>* dependencies) const;
+	std::vector<generated_member> members_of(const std::vector<std::shared_ptr<edm_property_type>>& properties, const std::string& owner) const;
+
+	void open_namespace(const edm_named_type* type);
+	void close_namespace();
+	void write_enum_type(const std::shared_ptr<edm_enum_type>& enum_type);
+	void write_structured_type(edm_structured_type* structured_type);
+	void write_enum_functions(const std::shared_ptr<edm_enum_type>& enum_type);
+	void write_structured_functions(edm_structured_type* structured_type);
+
+	std::ostream& m_stream;
+	std::string m_root_namespace;
+	std::string m_open_namespace;
+	std::vector<std::shared_ptr<edm_enum_type>> m_enum_types;
+	std::vector<edm_structured_type*> m_structured_types;
+	std::unordered_map<const edm_named_type*, std::string> m_schema_namespaces;
+	std::unordered_map<const edm_named_type*, std::string> m_identifiers;
+};
+
+}}
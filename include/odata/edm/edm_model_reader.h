@@ -15,8 +15,8 @@ namespace odata { namespace edm
 class edm_model_reader : public ::odata::edm::xml_reader
 {
 public:
-    edm_model_reader(std::istream& stream) : 
-		xml_reader(stream), m_parsing_key(false), m_model(std::make_shared<edm_model>()), 
+    edm_model_reader(std::istream& stream, edm_type_resolution_t resolution = edm_type_resolution_t::Eager) : 
+		xml_reader(stream), m_parsing_key(false), m_parsing_concurrency(false), m_resolution(resolution), m_model(std::make_shared<edm_model>()), 
 		m_current_st(nullptr), m_current_enum(nullptr), m_current_operation(nullptr)
     {
     }
@@ -43,6 +43,8 @@ private:
 	void _process_navigation_property_binding();
 
     bool m_parsing_key;
+	bool m_parsing_concurrency;
+	edm_type_resolution_t m_resolution;
 
     // These variables are used to cache values for each entity
     std::shared_ptr<edm_model> m_model;
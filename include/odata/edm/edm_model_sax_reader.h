@@ -0,0 +1,95 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_model_sax_reader.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/edm/odata_edm.h"
+#include <exception>
+#ifndef WIN32
+#include <libxml/parser.h>
+#endif
+
+namespace odata { namespace edm
+{
+
+/// <summary>
+/// Builds an edm_model from CSDL pushed in arbitrary chunks, using a SAX parser instead of a pull reader.
+/// </summary>
+/// <remarks>
+/// Element and attribute names are mapped to identifiers once per distinct name through the parser's name
+/// dictionary, attribute values are only copied when they become part of the model, and every reference to
+/// the same type name shares one type placeholder until resolution. The resulting model is the same as the
+/// one built by edm_model_reader. Malformed XML throws std::runtime_error.
+/// </remarks>
+class edm_model_sax_reader
+{
+public:
+	ODATACPP_API explicit edm_model_sax_reader(edm_type_resolution_t resolution = edm_type_resolution_t::Eager);
+	ODATACPP_API ~edm_model_sax_reader();
+
+	/// <summary>
+	/// Feeds the next chunk of the document; chunks may split the document anywhere.
+	/// </summary>
+	ODATACPP_API void parse_chunk(const char* data, size_t size);
+
+	/// <summary>
+	/// Ends the document, resolves the type references and returns the model.
+	/// </summary>
+	ODATACPP_API std::shared_ptr<edm_model> finish();
+
+	/// <summary>
+	/// Reads the whole stream in chunks of the given size and returns the resolved model.
+	/// </summary>
+	ODATACPP_API static std::shared_ptr<edm_model> parse(std::istream& stream, size_t chunk_size = 64 * 1024, edm_type_resolution_t resolution = edm_type_resolution_t::Eager);
+
+private:
+	edm_model_sax_reader(const edm_model_sax_reader&);
+	edm_model_sax_reader& operator=(const edm_model_sax_reader&);
+
+#ifdef WIN32
+	std::string m_buffer;
+#else
+	static void on_start_element(void* context, const xmlChar* local_name, const xmlChar* prefix, const xmlChar* uri,
+		int namespace_count, const xmlChar** namespaces, int attribute_count, int defaulted_count, const xmlChar** attributes);
+	static void on_end_element(void* context, const xmlChar* local_name, const xmlChar* prefix, const xmlChar* uri);
+	static void on_characters(void* context, const xmlChar* text, int length);
+
+	void start_element(int element, int attribute_count, const xmlChar** attributes);
+	void end_element(int element);
+	int lookup_name(const xmlChar* name);
+	std::shared_ptr<edm_named_type> type_reference(const xmlChar** attribute, bool resolve_primitive);
+	void check_result(int result);
+
+	void process_property(int attribute_count, const xmlChar** attributes);
+	void process_enum_member(int attribute_count, const xmlChar** attributes);
+	void process_navigation_property(int attribute_count, const xmlChar** attributes);
+	void process_navigation_property_binding(int attribute_count, const xmlChar** attributes);
+	void process_operation_parameter(int attribute_count, const xmlChar** attributes);
+	void process_operation_return_type(int attribute_count, const xmlChar** attributes);
+
+	xmlParserCtxtPtr m_context;
+	std::exception_ptr m_error;
+	std::unordered_map<const xmlChar*, int> m_names;
+	std::unordered_map<const xmlChar*, std::shared_ptr<edm_named_type>> m_type_placeholders;
+	std::unordered_map<const xmlChar*, std::shared_ptr<edm_named_type>> m_property_types;
+
+	bool m_parsing_key;
+	bool m_parsing_concurrency;
+	bool m_parsing_property_path;
+	std::string m_text;
+	std::shared_ptr<edm_schema> m_current_schema;
+	std::shared_ptr<edm_entity_container> m_current_container;
+	std::shared_ptr<edm_entity_set> m_current_entity_set;
+	std::shared_ptr<edm_singleton> m_current_singleton;
+	std::shared_ptr<edm_structured_type> m_current_st;
+	std::shared_ptr<edm_enum_type> m_current_enum;
+	std::shared_ptr<edm_operation_type> m_current_operation;
+#endif
+	edm_type_resolution_t m_resolution;
+	std::shared_ptr<edm_model> m_model;
+};
+
+}}
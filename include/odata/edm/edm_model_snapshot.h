@@ -0,0 +1,115 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_model_snapshot.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "odata/edm/odata_edm.h"
+
+namespace odata { namespace edm
+{
+
+/// <summary>
+/// Version of the binary model snapshot layout; readers reject snapshots written with any other version.
+/// </summary>
+#define EDM_MODEL_SNAPSHOT_FORMAT_VERSION 2
+
+/// <summary>
+/// Writes a resolved edm_model as a binary snapshot.
+/// </summary>
+/// <remarks>
+/// The snapshot starts with a 20 byte header (the magic "ODMS", the format version, reserved flags and the size of the
+/// body) followed by a deduplicated UTF-8 string table and the model itself. Types, containers and navigation sources
+/// refer to each other by index, so loading a snapshot never looks anything up by name or resolves a type name.
+/// All integers are little-endian regardless of the platform that wrote the snapshot.
+/// </remarks>
+class edm_model_snapshot_writer
+{
+public:
+	edm_model_snapshot_writer(std::ostream& stream) : m_stream(stream)
+	{
+	}
+
+	ODATACPP_API void write_model(std::shared_ptr<edm_model> model);
+
+private:
+	edm_model_snapshot_writer(const edm_model_snapshot_writer&);
+	edm_model_snapshot_writer& operator=(const edm_model_snapshot_writer&);
+
+	void collect(std::shared_ptr<edm_model> model);
+
+	uint32_t intern(const ::odata::utility::string_t& value);
+	void write_u8(uint8_t value);
+	void write_u32(uint32_t value);
+	void write_u64(uint64_t value);
+	void write_string(const ::odata::utility::string_t& value);
+	void write_type_reference(std::shared_ptr<edm_named_type> type);
+	void write_navigation_source_reference(std::shared_ptr<edm_navigation_source> navigation_source);
+
+	void write_structured_type(std::shared_ptr<edm_structured_type> structured_type);
+	void write_navigation_source_bindings(std::shared_ptr<edm_navigation_source> navigation_source);
+
+	std::ostream& m_stream;
+	std::vector<unsigned char> m_body;
+	std::vector<::odata::utility::string_t> m_strings;
+	std::unordered_map<::odata::utility::string_t, uint32_t> m_string_ids;
+	std::vector<std::shared_ptr<edm_named_type>> m_types;
+	std::vector<uint32_t> m_type_schemas;
+	std::unordered_map<const edm_named_type*, uint32_t> m_type_ids;
+	std::vector<std::shared_ptr<edm_entity_container>> m_containers;
+	std::vector<uint32_t> m_container_schemas;
+	std::unordered_map<const edm_navigation_source*, std::pair<uint32_t, uint32_t>> m_navigation_source_ids;
+};
+
+/// <summary>
+/// Builds an edm_model from a snapshot written by edm_model_snapshot_writer.
+/// </summary>
+/// <remarks>
+/// The reader works directly on the snapshot bytes, typically a memory-mapped file, and copies nothing but the
+/// strings that end up in the model; the bytes may be released as soon as read_model returns.
+/// Malformed, truncated or incompatible snapshots throw std::invalid_argument.
+/// </remarks>
+class edm_model_snapshot_reader
+{
+public:
+	edm_model_snapshot_reader(const void* data, size_t size)
+		: m_data(static_cast<const unsigned char*>(data)), m_size(size), m_pos(0)
+	{
+	}
+
+	ODATACPP_API std::shared_ptr<edm_model> read_model();
+
+	/// <summary>
+	/// Memory-maps a snapshot file and builds the model from it.
+	/// </summary>
+	ODATACPP_API static std::shared_ptr<edm_model> read_file(const std::string& path);
+
+private:
+	edm_model_snapshot_reader(const edm_model_snapshot_reader&);
+	edm_model_snapshot_reader& operator=(const edm_model_snapshot_reader&);
+
+	void require(size_t count);
+	uint8_t read_u8();
+	uint32_t read_u32();
+	uint64_t read_u64();
+	bool read_bool() { return read_u8() != 0; }
+	const ::odata::utility::string_t& read_string();
+	uint32_t read_index(size_t count, bool optional = false);
+	std::shared_ptr<edm_named_type> read_type_reference();
+	std::shared_ptr<edm_navigation_source> read_navigation_source_reference();
+
+	void read_structured_type(std::shared_ptr<edm_structured_type> structured_type);
+	void read_navigation_source_bindings(std::shared_ptr<edm_navigation_source> navigation_source);
+
+	const unsigned char* m_data;
+	size_t m_size;
+	size_t m_pos;
+	std::shared_ptr<edm_model> m_model;
+	std::vector<::odata::utility::string_t> m_strings;
+	std::vector<std::shared_ptr<edm_named_type>> m_types;
+	std::vector<std::shared_ptr<edm_entity_container>> m_containers;
+};
+
+}}
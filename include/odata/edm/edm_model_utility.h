@@ -20,7 +20,15 @@ public:
 	ODATACPP_API static std::shared_ptr<edm_named_type> get_edm_primitive_type_from_name(const ::odata::utility::string_t& type_name);
     ODATACPP_API static ::odata::utility::string_t get_type_kind_name_from_edm_type(const std::shared_ptr<edm_named_type>& ptype);
     ODATACPP_API static bool get_primitive_kind_from_edm_type(const std::shared_ptr<edm_named_type>& edm_type, edm_primitive_type_kind_t& primitive_kind);
-	ODATACPP_API static void resolve_edm_types_after_parsing(const std::shared_ptr<edm_model>& model);
+	/// <summary>
+	/// Replaces the type names recorded while parsing with the types they refer to.
+	/// </summary>
+	/// <remarks>
+	/// Base types, entity sets, singletons, operation imports and navigation bindings are always resolved before this
+	/// returns, since they link parts of the model to each other; the mode only decides how and when the property types
+	/// of structured types are resolved. Lazily resolved models are safe to read from several threads.
+	/// </remarks>
+	ODATACPP_API static void resolve_edm_types_after_parsing(const std::shared_ptr<edm_model>& model, edm_type_resolution_t resolution = edm_type_resolution_t::Eager);
 	ODATACPP_API static std::shared_ptr<::odata::edm::edm_named_type> get_property_type_from_name(const std::shared_ptr<::odata::edm::edm_entity_type>& entity_type, const ::odata::utility::string_t& property_name);
 
 	ODATACPP_API static std::shared_ptr<edm_named_type> get_collection_element_type(const std::shared_ptr<edm_named_type>& input_type);
@@ -31,9 +39,16 @@ public:
 
 	ODATACPP_API static bool is_collection_of_entity(std::shared_ptr<::odata::edm::edm_named_type> type);
 
+	/// <summary>
+	/// Checks whether an annotation term is Org.OData.Core.V1.OptimisticConcurrency, by its namespace or the usual Core alias.
+	/// </summary>
+	ODATACPP_API static bool is_optimistic_concurrency_term(const ::odata::utility::string_t& term);
+
 private:
 	static std::shared_ptr<edm_named_type> resolve_type_from_name(const std::shared_ptr<edm_model>& model, ::odata::utility::string_t qualified_name);
-	static void resolve_type_under_structured_type(const std::shared_ptr<edm_model>& model, const std::shared_ptr<edm_structured_type>& structyred_type);
+	static void resolve_type_under_structured_type(const std::shared_ptr<edm_model>& model, edm_structured_type* structyred_type, std::vector<std::shared_ptr<edm_collection_type>>& collection_navigation_types);
+	static void resolve_types_in_parallel(const std::shared_ptr<edm_model>& model, const std::vector<std::shared_ptr<edm_structured_type>>& structured_types, const std::vector<std::shared_ptr<edm_operation_type>>& operation_types);
+	static void defer_type_resolution(const std::shared_ptr<edm_model>& model, const std::shared_ptr<edm_structured_type>& structured_type);
 	static void resolve_type_under_operation_type(const std::shared_ptr<edm_model>& model, const std::shared_ptr<edm_operation_type>& operationType);
 	static std::shared_ptr<edm_named_type> resolve_undetermined_type(const std::shared_ptr<edm_model>& model, const std::shared_ptr<edm_named_type>& undeterminedType);
 	static void resolve_type_under_entity_container(const std::shared_ptr<edm_model>& model, const std::shared_ptr<edm_entity_container>& entity_container);
@@ -42,6 +42,7 @@ protected:
     ODATACPP_API void write_operation_import(std::shared_ptr<edm_operation_import> operation_import);
 
 private:
+    void write_concurrency_annotation(std::shared_ptr<edm_navigation_source> navigation_source);
 };
 
 }}
\ No newline at end of file
@@ -21,7 +21,8 @@ enum container_resource_type
 class edm_navigation_source
 {
 public:
-	edm_navigation_source(const ::odata::utility::string_t& name, container_resource_type resource_type) : m_name(name), m_resource_type(resource_type)
+	edm_navigation_source(const ::odata::utility::string_t& name, container_resource_type resource_type)
+		: m_name(name), m_resource_type(resource_type), m_id(undefined_value), m_frozen(false)
 	{}
 
 	virtual ~edm_navigation_source()
@@ -29,6 +30,7 @@ public:
 
 	void add_navigation_source(const ::odata::utility::string_t& property_path_name, const ::odata::utility::string_t& target_name)
 	{
+		throw_if_frozen(m_frozen);
 		navigation_property_mapping[property_path_name] = target_name;
 	}
 
@@ -42,6 +44,23 @@ public:
 		return navigation_property_mapping;
 	}
 
+	/// <summary>
+	/// Adds a property to the concurrency tokens, which the Org.OData.Core.V1.OptimisticConcurrency annotation lists.
+	/// </summary>
+	void add_concurrency_property(const ::odata::utility::string_t& property_path)
+	{
+		throw_if_frozen(m_frozen);
+		m_concurrency_properties.push_back(property_path);
+	}
+
+	/// <summary>
+	/// Gets the properties whose values make up the ETag of the entities, in the order they were declared.
+	/// </summary>
+	const std::vector<::odata::utility::string_t>& get_concurrency_properties() const
+	{
+		return m_concurrency_properties;
+	}
+
 
     const ::odata::utility::string_t& get_name() const 
     {
@@ -53,10 +72,24 @@ public:
 		return m_resource_type;
 	}
 
+	/// <summary>
+	/// Gets the dense identifier of the entity set or singleton in a frozen model, an index into edm_model::get_navigation_sources().
+	/// </summary>
+	/// <returns>The identifier, or undefined_value if the model is not frozen.</returns>
+	unsigned int get_id() const
+	{
+		return m_id;
+	}
+
 protected:
+	friend class edm_model;
+
 	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t> navigation_property_mapping;
+	std::vector<::odata::utility::string_t> m_concurrency_properties;
     ::odata::utility::string_t m_name;
 	container_resource_type m_resource_type;
+	unsigned int m_id;
+	bool m_frozen;
 };
 
 }}
\ No newline at end of file
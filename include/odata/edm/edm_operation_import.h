@@ -69,6 +69,11 @@ public:
         return m_entity_set_path;
     }
 
+    bool is_in_service_document() const
+    {
+        return m_is_in_service_document;
+    }
+
 	void set_operation_type(std::shared_ptr<edm_operation_type> operationType)
 	{
 		m_operation_type = operationType;
@@ -23,7 +23,7 @@ public:
     /// <summary>
     /// 
     /// </summary>
-    edm_schema()
+    edm_schema() : m_frozen(false)
     {
     }
 
@@ -31,7 +31,7 @@ public:
     /// 
     /// </summary>
     edm_schema(::odata::utility::string_t namesp, ::odata::utility::string_t alias) :
-        m_namespace(namesp), m_alias(alias)
+        m_namespace(namesp), m_alias(alias), m_frozen(false)
     {
     }
 
@@ -47,6 +47,7 @@ public:
     /// </summary>
     void add_entity_type(std::shared_ptr<edm_entity_type> et)
     {
+        throw_if_frozen(m_frozen);
         m_entity_types[et->get_name()] = et;
     }
 
@@ -55,6 +56,7 @@ public:
     /// </summary>
     void add_complex_type(std::shared_ptr<edm_complex_type> et)
     {
+        throw_if_frozen(m_frozen);
         m_complex_types[et->get_name()] = et;
     }
 
@@ -63,6 +65,7 @@ public:
     /// </summary>
     void add_enum_type(std::shared_ptr<edm_enum_type> et)
     {
+        throw_if_frozen(m_frozen);
         m_enum_types[et->get_name()] = et;
     }
 
@@ -71,6 +74,7 @@ public:
     /// </summary>
 	void add_operation_type(std::shared_ptr<edm_operation_type> et)
     {
+        throw_if_frozen(m_frozen);
         m_operation_types[et->get_name()] = et;
     }	
 
@@ -79,6 +83,7 @@ public:
     /// </summary>
     void add_container(std::shared_ptr<edm_entity_container> et)
     {
+        throw_if_frozen(m_frozen);
         m_entity_containers[et->get_name()] = et;
     }
 
@@ -187,8 +192,16 @@ public:
         return m_namespace;
     }
 
+    const ::odata::utility::string_t& get_alias() const
+    {
+        return m_alias;
+    }
+
 private:
+	friend class edm_model;
 	friend class edm_model_utility;
+	friend class edm_model_snapshot_reader;
+	friend class edm_model_snapshot_writer;
 
     ::odata::utility::string_t m_namespace;
     ::odata::utility::string_t m_alias;
@@ -199,6 +212,7 @@ private:
 	std::unordered_map<::odata::utility::string_t, std::shared_ptr<edm_entity_container>> m_entity_containers;
 
 	std::vector<std::shared_ptr<edm_collection_type>> m_collection_navigation_types;
+	bool m_frozen;
 };
 
 }}
\ No newline at end of file
@@ -7,6 +7,10 @@
 #pragma once
 
 #include "odata/common/utility.h"
+#include <stdexcept>
+#include <atomic>
+#include <functional>
+#include <mutex>
 
 namespace odata { namespace edm 
 {
@@ -19,7 +23,21 @@ namespace odata { namespace edm
 #define PAYLOAD_ANNOTATION_ID  U("@odata.id")
 
 class edm_schema;
+class edm_model;
 class edm_model_reader;
+class edm_model_utility;
+class edm_operation_type;
+
+/// <summary>
+/// Throws when an element of a frozen model is about to be modified.
+/// </summary>
+inline void throw_if_frozen(bool frozen)
+{
+	if (frozen)
+	{
+		throw std::runtime_error("The edm model is frozen and cannot be modified.");
+	}
+}
 
 /// <summary>
 /// Defines EDM metatypes.
@@ -65,14 +83,14 @@ enum edm_primitive_type_kind_t
 class edm_named_type
 {
 public:
-	edm_named_type() :  m_type_kind(edm_type_kind_t::None), m_name(U("")), m_namespace(U(""))
+	edm_named_type() :  m_type_kind(edm_type_kind_t::None), m_name(U("")), m_namespace(U("")), m_id(undefined_value), m_frozen(false)
 	{
 #ifdef _MS_WINDOWS_DEBUG
 		std::wcout << U("create :") << m_namespace << U(".") << m_name << std::endl;
 #endif
 	}
 
-	edm_named_type(edm_type_kind_t type_kind) :  m_type_kind(type_kind), m_name(U("")), m_namespace(U(""))
+	edm_named_type(edm_type_kind_t type_kind) :  m_type_kind(type_kind), m_name(U("")), m_namespace(U("")), m_id(undefined_value), m_frozen(false)
 	{
 #ifdef _MS_WINDOWS_DEBUG
 		std::wcout << U("create :") << m_namespace << U(".") << m_name << std::endl;
@@ -80,7 +98,7 @@ public:
 	}
 
 	edm_named_type(::odata::utility::string_t name, ::odata::utility::string_t name_space, edm_type_kind_t type_kind)
-		: m_type_kind(type_kind), m_name(name), m_namespace(name_space)
+		: m_type_kind(type_kind), m_name(name), m_namespace(name_space), m_id(undefined_value), m_frozen(false)
 	{
 #ifdef _MS_WINDOWS_DEBUG
 		std::wcout << U("create :") << m_namespace << U(".") << m_name << std::endl;
@@ -99,7 +117,7 @@ public:
         return m_name;
     }
 
-	::odata::utility::string_t get_full_name()
+	::odata::utility::string_t get_full_name() const
 	{
 		if (m_namespace.empty())
 		{
@@ -136,19 +154,32 @@ public:
 		m_type_kind = kind;
 	}
 
-	ODATACPP_API static std::shared_ptr<edm_named_type> EDM_UNKNOWN();
+	/// <summary>
+	/// Gets the dense identifier of a type declared in a frozen model, an index into edm_model::get_types().
+	/// </summary>
+	/// <returns>The identifier, or undefined_value if the model is not frozen or the type is not declared in a schema.</returns>
+	unsigned int get_id() const
+	{
+		return m_id;
+	}
 
-protected:
-	static std::mutex &mutex();
+	ODATACPP_API static const std::shared_ptr<edm_named_type>& EDM_UNKNOWN();
+
+	/// <summary>
+	/// Gets the pointer that owns a process-wide type, one of the primitive types or EDM_UNKNOWN, for the lifetime of the process.
+	/// </summary>
+	/// <returns>The owning pointer, or nullptr if the type is owned by a model or by whoever created it.</returns>
+	ODATACPP_API static const std::shared_ptr<edm_named_type>* find_static_owner(const edm_named_type* type);
 
 protected:
     friend class edm_schema;
+	friend class edm_model;
 
 	::odata::utility::string_t m_name;
 	::odata::utility::string_t m_namespace;
 	edm_type_kind_t m_type_kind;
-
-	static std::shared_ptr<edm_named_type> _EDM_UNKNOWN;
+	unsigned int m_id;
+	bool m_frozen;
 };
 
 class edm_primitive_type : public edm_named_type
@@ -178,22 +209,22 @@ public:
 		return false;
     }
 
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> BINARY();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> BOOLEAN();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> BYTE();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> DATETIMEOFFSET();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> DURATION();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> DECIMAL();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> DOUBLE();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> GUID();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> INT16();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> INT32();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> INT64();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> SBYTE();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> SINGLE();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> STRING();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> STREAM();
-	ODATACPP_API static std::shared_ptr<edm_primitive_type> UNKNOWN();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& BINARY();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& BOOLEAN();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& BYTE();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& DATETIMEOFFSET();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& DURATION();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& DECIMAL();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& DOUBLE();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& GUID();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& INT16();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& INT32();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& INT64();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& SBYTE();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& SINGLE();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& STRING();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& STREAM();
+	ODATACPP_API static const std::shared_ptr<edm_primitive_type>& UNKNOWN();
 
 private:
 	edm_primitive_type(::odata::utility::string_t name, edm_primitive_type_kind_t primitive_kind)
@@ -201,27 +232,10 @@ private:
 	{
 	}
 
-	static std::mutex &mutex();
+	// Primitive types are process-wide singletons created on first use, indexed by primitive kind.
+	static const std::shared_ptr<edm_primitive_type>* singletons();
 
 	edm_primitive_type_kind_t m_primitive_kind;
-
-	static std::shared_ptr<edm_primitive_type> _BINARY;
-	static std::shared_ptr<edm_primitive_type> _BOOLEAN;
-	static std::shared_ptr<edm_primitive_type> _BYTE;
-	static std::shared_ptr<edm_primitive_type> _DATETIMEOFFSET;
-	static std::shared_ptr<edm_primitive_type> _DURATION;
-	static std::shared_ptr<edm_primitive_type> _DECIMAL;
-	static std::shared_ptr<edm_primitive_type> _DOUBLE;
-	static std::shared_ptr<edm_primitive_type> _GUID;
-	static std::shared_ptr<edm_primitive_type> _INT16;
-	static std::shared_ptr<edm_primitive_type> _INT32;
-	static std::shared_ptr<edm_primitive_type> _INT64;
-	static std::shared_ptr<edm_primitive_type> _SBYTE;
-	static std::shared_ptr<edm_primitive_type> _SINGLE;
-	static std::shared_ptr<edm_primitive_type> _STRING;
-	static std::shared_ptr<edm_primitive_type> _STREAM;
-	static std::shared_ptr<edm_primitive_type> _UNKNOWN;
-
 };
 
 /// <summary>
@@ -234,24 +248,28 @@ public:
     /// Constructor
     /// </summary>
     // nd change m_is_unicode(true)
-    edm_property_type() : m_is_nullable(true), m_is_unicode(true), m_maxLength(undefined_value), m_scale(0), m_precision(undefined_value)
+    edm_property_type() : m_is_nullable(true), m_is_unicode(true), m_maxLength(undefined_value), m_scale(0), m_precision(undefined_value),
+		m_id(undefined_value), m_navigation_id(undefined_value)
     {
     }
 
 	edm_property_type(const ::odata::utility::string_t& name) : m_name(name), 
     // nd change m_is_unicode(true)
-		m_is_nullable(true), m_is_unicode(true), m_maxLength(undefined_value), m_scale(0), m_precision(undefined_value)
+		m_is_nullable(true), m_is_unicode(true), m_maxLength(undefined_value), m_scale(0), m_precision(undefined_value),
+		m_id(undefined_value), m_navigation_id(undefined_value)
 	{
 	}
 
     edm_property_type(const ::odata::utility::string_t& name, bool is_nullable, unsigned int max_length, bool is_unicode, unsigned int scale) : 
-        m_name(name), m_is_nullable(is_nullable), m_is_unicode(is_unicode), m_maxLength(max_length), m_scale(scale), m_precision(undefined_value)
+        m_name(name), m_is_nullable(is_nullable), m_is_unicode(is_unicode), m_maxLength(max_length), m_scale(scale), m_precision(undefined_value),
+		m_id(undefined_value), m_navigation_id(undefined_value)
     {
     }
 
     edm_property_type(const ::odata::utility::string_t& name, bool is_nullable, std::shared_ptr<edm_named_type> type) : 
     // nd change m_is_unicode(true)
-        m_name(name), m_is_nullable(is_nullable), m_type(type), m_is_unicode(true), m_maxLength(undefined_value), m_scale(0), m_precision(undefined_value)
+        m_name(name), m_is_nullable(is_nullable), m_type(type), m_is_unicode(true), m_maxLength(undefined_value), m_scale(0), m_precision(undefined_value),
+		m_id(undefined_value), m_navigation_id(undefined_value)
     {
     }
 
@@ -314,8 +332,25 @@ public:
 	    return m_precision;
     }
 
+    /// <summary>
+    /// Gets the dense identifier of the property in a frozen model, an index into edm_model::get_properties().
+    /// </summary>
+    /// <returns>The identifier, or undefined_value if the model is not frozen.</returns>
+    unsigned int get_id() const {
+	    return m_id;
+    }
+
+    /// <summary>
+    /// Gets the dense identifier of a navigation property in a frozen model, an index into edm_model::get_navigation_properties().
+    /// </summary>
+    /// <returns>The identifier, or undefined_value if the model is not frozen or this is not a navigation property.</returns>
+    unsigned int get_navigation_id() const {
+	    return m_navigation_id;
+    }
+
 private:
     friend class edm_structured_type;
+    friend class edm_model;
 
     bool m_is_nullable;
 	bool m_is_unicode;
@@ -324,6 +359,8 @@ private:
 	unsigned int m_maxLength;
 	unsigned int m_scale;
 	unsigned int m_precision;
+	unsigned int m_id;
+	unsigned int m_navigation_id;
 
 	std::shared_ptr<edm_named_type> m_type;
 };
@@ -361,6 +398,19 @@ public:
 	}
 };
 
+/// <summary>
+/// What a URL path segment following a value of a structured type refers to; see edm_structured_type::find_symbol.
+/// </summary>
+struct edm_type_symbol
+{
+	// The declared or inherited property of that name, structural or navigation.
+	std::shared_ptr<edm_property_type> property;
+	// The operation of that name whose binding parameter is the type itself.
+	std::shared_ptr<edm_operation_type> operation;
+	// The operation of that name whose binding parameter is a collection of the type.
+	std::shared_ptr<edm_operation_type> collection_operation;
+};
+
 /// <summary>
 /// Represents what is shared between edm_complex_type and edm_entity_type.
 /// </summary>
@@ -372,24 +422,22 @@ public:
     /// </summary>
     /// <param name="name">The name of the type.</param>
     edm_structured_type(::odata::utility::string_t name, ::odata::utility::string_t name_space, edm_type_kind_t type_kind, ::odata::utility::string_t basetype, bool isAbstract, bool isOpenType)
-		: edm_named_type(name, name_space, type_kind) , m_baseTypeName(basetype), m_is_abstract(isAbstract), m_is_openType(isOpenType), m_base_type(nullptr)
+		: edm_named_type(name, name_space, type_kind) , m_baseTypeName(basetype), m_is_abstract(isAbstract), m_is_openType(isOpenType), m_base_type(nullptr), m_resolved(true)
     {
     }
 
     /// <summary>
-    /// Adds a property to the type.
+    /// Adds a property to the type; a property with the same name as an existing one replaces it in place.
     /// </summary>
     /// <param name="prop">A pointer to the property to add.</param>
-    void add_property(std::shared_ptr<edm_property_type> prop)
-    {
-		m_properties[prop->get_name()] = prop;
-    }
+    ODATACPP_API void add_property(std::shared_ptr<edm_property_type> prop);
 
     /// <summary>
     /// Gets the beginning iterator of the properties of the type
     /// </summary>
     std::unordered_map<::odata::utility::string_t, std::shared_ptr<edm_property_type>>::const_iterator begin() const
     {
+		ensure_resolved();
 		return m_properties.cbegin();
     }
 
@@ -398,17 +446,17 @@ public:
     /// </summary>
     std::unordered_map<::odata::utility::string_t, std::shared_ptr<edm_property_type>>::const_iterator end() const
     {
+		ensure_resolved();
         return m_properties.cend();
     }
 
-    std::vector<std::shared_ptr<edm_property_type>> get_properties_vector() const
+    /// <summary>
+    /// Gets the properties declared by the type itself, in declaration order.
+    /// </summary>
+    const std::vector<std::shared_ptr<edm_property_type>>& get_properties_vector() const
 	{
-		std::vector<std::shared_ptr<edm_property_type>> ret;
-		for (auto it = m_properties.cbegin(); it != m_properties.cend(); ++it)
-		{
-			ret.push_back(it->second);
-		}
-		return ret;
+		ensure_resolved();
+		return m_property_vector;
 	}
 
 	const ::odata::utility::string_t get_base_type_name() const
@@ -416,10 +464,11 @@ public:
 		return m_baseTypeName;
 	}
 
-	void set_base_type(const std::shared_ptr<edm_structured_type>& base_entity_type)
-	{
-		m_base_type = base_entity_type;
-	}
+    /// <summary>
+    /// Sets the base type and refreshes the flattened members of this type and of every type derived from it.
+    /// </summary>
+    /// <param name="base_entity_type">The base type; throws std::invalid_argument if it would create an inheritance cycle.</param>
+	ODATACPP_API void set_base_type(const std::shared_ptr<edm_structured_type>& base_entity_type);
 
 	const std::shared_ptr<edm_structured_type>& get_base_type()
 	{
@@ -431,6 +480,28 @@ public:
 		return m_is_openType;
 	}
 
+	bool is_abstract() const
+	{
+		return m_is_abstract;
+	}
+
+    /// <summary>
+    /// Gets the properties of the base types followed by the properties declared by the type itself, in declaration order.
+    /// </summary>
+    const std::vector<std::shared_ptr<edm_property_type>>& get_properties_with_parents() const
+	{
+		ensure_resolved();
+		return m_properties_with_parents;
+	}
+
+    /// <summary>
+    /// Gets every type that directly or indirectly derives from the type.
+    /// </summary>
+    const std::vector<edm_structured_type*>& get_derived_types() const
+	{
+		return m_derived_types;
+	}
+
     /// <summary>
     /// Looks up a property of the type by name.
     /// </summary>
@@ -438,8 +509,52 @@ public:
     /// <returns>A pointer to the property if found, an empty pointer otherwise.</returns>
     ODATACPP_API std::shared_ptr<edm_property_type> find_property(::odata::utility::string_t name) const;
 
+    /// <summary>
+    /// Looks up the property and the bound operations a path segment identifier refers to with a single probe.
+    /// Operations are found by qualified and by unqualified name.
+    /// </summary>
+    /// <param name="name">The segment identifier.</param>
+    /// <returns>The symbol if found, nullptr otherwise; always nullptr until the model is frozen, which builds the table.</returns>
+    const edm_type_symbol* find_symbol(const ::odata::utility::string_t& name) const
+	{
+		auto find_iter = m_symbols.find(name);
+		return find_iter == m_symbols.end() ? nullptr : &find_iter->second;
+	}
+
+	ODATACPP_API virtual ~edm_structured_type();
+
 protected:
     friend class edm_schema;
+	friend class edm_model_utility;
+	friend class edm_model;
+
+	/// <summary>
+	/// Resolves the types of the properties if the model deferred it, then does the same for the base types.
+	/// </summary>
+	void ensure_resolved() const
+	{
+		if (!m_resolved.load(std::memory_order_acquire))
+		{
+			resolve_deferred();
+		}
+	}
+
+	/// <summary>
+	/// Looks up a property, including inherited ones, without resolving its type.
+	/// </summary>
+	std::shared_ptr<edm_property_type> lookup_property(const ::odata::utility::string_t& name) const;
+
+	/// <summary>
+	/// Rebuilds the inherited members from the base type, then does the same for every directly derived type.
+	/// </summary>
+	void refresh_flattened_members();
+
+	/// <summary>
+	/// Hook for derived classes that flatten more than properties; called by refresh_flattened_members.
+	/// </summary>
+	virtual void refresh_flattened_key()
+	{
+	}
 
 	::odata::utility::string_t m_baseTypeName;	
 	std::shared_ptr<edm_structured_type> m_base_type;
@@ -448,6 +563,26 @@ protected:
 	bool m_is_openType;
 
 	std::unordered_map<::odata::utility::string_t, std::shared_ptr<edm_property_type>> m_properties;
+	std::vector<std::shared_ptr<edm_property_type>> m_property_vector;
+
+	// Only filled for types with a base type; root types look properties up in m_properties.
+	std::unordered_map<::odata::utility::string_t, std::shared_ptr<edm_property_type>> m_property_map_with_parents;
+	// Filled by edm_model::freeze.
+	std::unordered_map<::odata::utility::string_t, edm_type_symbol> m_symbols;
+	std::vector<std::shared_ptr<edm_property_type>> m_properties_with_parents;
+	std::vector<edm_structured_type*> m_derived_types;
+
+	// Set by edm_model_utility when a model resolves its types lazily; runs at most once.
+	std::function<void()> m_resolver;
+	mutable std::once_flag m_resolver_once;
+	mutable std::atomic<bool> m_resolved;
+
+private:
+	edm_structured_type(const edm_structured_type&);
+	edm_structured_type& operator=(const edm_structured_type&);
+
+	void detach_from_base_types();
+	ODATACPP_API void resolve_deferred() const;
 };
 
 class edm_enum_member
@@ -510,6 +645,7 @@ public:
     /// </summary>
     void add_enum_member(std::shared_ptr<edm_enum_member> member)
     {
+		throw_if_frozen(m_frozen);
         m_members.push_back(member);
     }
 
@@ -523,6 +659,11 @@ public:
 		return m_is_flag;
 	}
 
+	const ::odata::utility::string_t& get_underlying_type_name() const
+	{
+		return m_underlying_type;
+	}
+
 private:
     friend class edm_schema;
 
@@ -666,7 +807,8 @@ class edm_operation_type : public edm_named_type
 {
 public:
 	edm_operation_type(::odata::utility::string_t name, ::odata::utility::string_t name_space, bool is_bound, ::odata::utility::string_t path, EdmOperationKind operation_kind, bool is_composable) 
-		: edm_named_type(name, name_space, edm_type_kind_t::Operation), m_path(path), m_is_bound(is_bound), m_operation_kind(operation_kind), m_is_composable(is_composable)
+		: edm_named_type(name, name_space, edm_type_kind_t::Operation), m_path(path), m_is_bound(is_bound), m_operation_kind(operation_kind), m_is_composable(is_composable),
+		m_operation_id(undefined_value)
 	{
 		if (operation_kind == EdmOperationKind::Action)
 		{
@@ -676,6 +818,7 @@ public:
 
 	void add_operation_parameter(std::shared_ptr<edm_operation_parameter> parameter)
 	{
+		throw_if_frozen(m_frozen);
 		m_parameters.push_back(parameter);
 	}
 
@@ -723,6 +866,15 @@ public:
 		return m_path;
 	}
 
+	/// <summary>
+	/// Gets the dense identifier of the operation in a frozen model, an index into edm_model::get_operations().
+	/// </summary>
+	/// <returns>The identifier, or undefined_value if the model is not frozen.</returns>
+	unsigned int get_operation_id() const
+	{
+		return m_operation_id;
+	}
+
 private:
     friend class edm_schema;
 	friend class edm_model;
@@ -734,6 +886,7 @@ private:
 	::odata::utility::string_t m_return_type_name;
 	EdmOperationKind m_operation_kind;
 	bool m_is_composable;
+	unsigned int m_operation_id;
 };
 
 
@@ -756,10 +909,7 @@ public:
     /// <summary>
     /// Adds a property name to the key of the entity type
     /// </summary>
-    void add_key_property(const ::odata::utility::string_t& property_ref)
-    {
-        m_key.push_back(property_ref);
-    }
+    ODATACPP_API void add_key_property(const ::odata::utility::string_t& property_ref);
 
     /// <summary>
     /// Gets the key, a collection of names of properties in the entity.
@@ -769,26 +919,26 @@ public:
         return m_key;
     }
 
-	std::vector<::odata::utility::string_t> get_key_with_parents() const
+    /// <summary>
+    /// Gets the key of the entity type followed by the keys of its base types.
+    /// </summary>
+	const std::vector<::odata::utility::string_t>& get_key_with_parents() const
 	{
-		std::vector<::odata::utility::string_t> ret = m_key;
-
-		if (m_base_type && std::dynamic_pointer_cast<edm_entity_type>(m_base_type))
-		{
-			auto parent_keys = (std::dynamic_pointer_cast<edm_entity_type>(m_base_type))->get_key_with_parents();
-			if (parent_keys.size() > 0)
-			{
-				ret.insert(ret.end(), parent_keys.begin(), parent_keys.end());
-			}
-		}
+		return m_key_with_parents;
+	}
 
-		return ret;
+	bool has_stream() const
+	{
+		return m_HasStream;
 	}
 
 private:
     friend class edm_schema;
 
+	void refresh_flattened_key();
+
     std::vector<::odata::utility::string_t> m_key;
+	std::vector<::odata::utility::string_t> m_key_with_parents;
 	bool m_HasStream;
 };
 
@@ -8,39 +8,168 @@
 #include "odata/common/basic_types.h"
 #include "odata/common/asyncrt_utils.h"
 
+// The vector kernels read and write 8-bit text, so they are only built where string_t is a narrow string.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(_UTF16_STRINGS)
+#define _USE_SIMD_BASE64_
+#include <immintrin.h>
+#endif
+
 using namespace odata;
 using namespace odata::utility;
 
-#define _USE_INTERNAL_BASE64_
-std::vector<unsigned char> _from_base64(const utility::string_t& str);
-utility::string_t _to_base64(const unsigned char *ptr, size_t size);
+static void _to_base64(const unsigned char* ptr, size_t size, char_t* output);
+static size_t _from_base64(const char_t* ptr, size_t size, unsigned char* output);
 
 std::vector<unsigned char> __cdecl conversions::from_base64(const utility::string_t& str)
 {
-    return _from_base64(str);
+    std::vector<unsigned char> result;
+    if (str.empty())
+    {
+        return result;
+    }
+
+    result.resize(str.size() / 4 * 3 + 1);
+    result.resize(_from_base64(&str[0], str.size(), &result[0]));
+    return result;
+}
+
+size_t __cdecl conversions::from_base64(const utility::char_t* text, size_t size, unsigned char* output)
+{
+    return size == 0 ? 0 : _from_base64(text, size, output);
 }
 
 utility::string_t __cdecl conversions::to_base64(const std::vector<unsigned char>& input)
 {
-    if (input.size() == 0)
+    utility::string_t result;
+    if (!input.empty())
     {
-        // return empty string
-        return utility::string_t();
+        to_base64(&input[0], input.size(), result);
     }
-
-    return _to_base64(&input[0], input.size());
+    return result;
 }
 
 utility::string_t __cdecl conversions::to_base64(uint64_t input)
 {
-    return _to_base64(reinterpret_cast<const unsigned char*>(&input), sizeof(input));
+    utility::string_t result;
+    to_base64(reinterpret_cast<const unsigned char*>(&input), sizeof(input), result);
+    return result;
 }
 
+void __cdecl conversions::to_base64(const unsigned char* data, size_t size, utility::string_t& output)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    size_t offset = output.size();
+    output.resize(offset + (size + 2) / 3 * 4);
+    _to_base64(data, size, &output[offset]);
+}
+
+void conversions::base64_encoder::write(const unsigned char* data, size_t size)
+{
+    if (m_pending_size + size < 3)
+    {
+        while (size-- != 0)
+        {
+            m_pending[m_pending_size++] = *data++;
+        }
+        return;
+    }
+
+    if (m_pending_size != 0)
+    {
+        unsigned char group[3];
+        size_t taken = 3 - m_pending_size;
+        std::copy(m_pending, m_pending + m_pending_size, group);
+        std::copy(data, data + taken, group + m_pending_size);
+        to_base64(group, 3, m_output);
+        data += taken;
+        size -= taken;
+        m_pending_size = 0;
+    }
+
+    size_t whole = size / 3 * 3;
+    to_base64(data, whole, m_output);
+    std::copy(data + whole, data + size, m_pending);
+    m_pending_size = size - whole;
+}
+
+void conversions::base64_encoder::finish()
+{
+    to_base64(m_pending, m_pending_size, m_output);
+    m_pending_size = 0;
+}
+
+void conversions::base64_decoder::write(const utility::char_t* text, size_t size)
+{
+    if (m_pending_size + size < 4)
+    {
+        if (m_padded && size != 0)
+        {
+            throw std::runtime_error("invalid padding character found in base64 string");
+        }
+
+        std::copy(text, text + size, m_pending + m_pending_size);
+        m_pending_size += size;
+        return;
+    }
+
+    if (m_pending_size != 0)
+    {
+        size_t taken = 4 - m_pending_size;
+        std::copy(text, text + taken, m_pending + m_pending_size);
+        decode(m_pending, 4);
+        text += taken;
+        size -= taken;
+        m_pending_size = 0;
+    }
+
+    size_t whole = size / 4 * 4;
+    decode(text, whole);
+    if (m_padded && size != whole)
+    {
+        throw std::runtime_error("invalid padding character found in base64 string");
+    }
+
+    std::copy(text + whole, text + size, m_pending);
+    m_pending_size = size - whole;
+}
+
+void conversions::base64_decoder::finish()
+{
+    if (m_pending_size != 0)
+    {
+        throw std::runtime_error("length of base64 string is not an even multiple of 4");
+    }
+}
+
+void conversions::base64_decoder::decode(const utility::char_t* text, size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    if (m_padded)
+    {
+        throw std::runtime_error("invalid padding character found in base64 string");
+    }
+
+    size_t offset = m_output.size();
+    size_t capacity = size / 4 * 3;
+    m_output.resize(offset + capacity);
+    size_t written = _from_base64(text, size, &m_output[offset]);
+    m_output.resize(offset + written);
+    m_padded = written != capacity;
+}
 
-#if defined(_USE_INTERNAL_BASE64_)
 static const char* _base64_enctbl = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-unsigned char _base64_dectbl [] = 
-    { 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 
+
+// 254 marks the padding character, 255 anything that is not part of the alphabet.
+static const unsigned char _base64_dectbl [] =
+    { 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
       255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
       255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  62, 255, 255, 255,  63,
        52,  53,  54,  55,  56,  57,  58,  59,  60,  61, 255, 255, 255, 254, 255, 255,
@@ -49,199 +178,315 @@ unsigned char _base64_dectbl [] =
       255,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
        41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, 255, 255, 255, 255, 255 };
 
-struct _triple_byte
-{
-    unsigned char _1_1 : 2;
-    unsigned char _0   : 6;
-    unsigned char _2_1 : 4;
-    unsigned char _1_2 : 4;
-    unsigned char _3   : 6;
-    unsigned char _2_2 : 2;
-};
+static const unsigned char _base64_padding = 254;
+static const unsigned char _base64_invalid = 255;
 
 //
 // A note on the implementation of BASE64 encoding and decoding:
 //
-// This is a fairly basic and naive implementation; there is probably a lot of room for
-// performance improvement, as well as for adding options such as support for URI-safe base64,
-// ignoring CRLF, relaxed validation rules, etc. The decoder is currently pretty strict.
+// Both directions run a vector kernel over the bulk of the data when the processor has one (AVX2, then SSSE3) and
+// finish with the scalar code below, which also handles the padded last group. The decoder is strict: the kernels
+// stop at the first block that holds anything outside the alphabet and leave it to the scalar code to report it.
+// The kernels are the lookup-free formulations of Wojciech Mula and Daniel Lemire.
 //
 
-#ifdef __GNUC__
-// gcc is concerned about the bitfield uses in the code, something we simply need to ignore.
-#pragma GCC diagnostic ignored "-Wconversion"
-#endif
-std::vector<unsigned char> _from_base64(const utility::string_t& input)
-{
-    std::vector<unsigned char> result;
+#if defined(_USE_SIMD_BASE64_)
 
-    if ( input.empty() ) 
-        return result;
+// Each kernel returns how much of its input it has consumed, always a whole number of blocks.
+typedef size_t (*_base64_encode_kernel)(const unsigned char* ptr, size_t size, char* output);
+typedef size_t (*_base64_decode_kernel)(const char* ptr, size_t size, unsigned char* output);
 
-    size_t padding = 0;
+__attribute__((target("ssse3")))
+static __m128i _encode_block_ssse3(__m128i input)
+{
+    // Spread 12 bytes over 16 lanes as [b1 b0 b2 b1] and move each 6-bit group into its own byte.
+    __m128i in = _mm_shuffle_epi8(input, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    __m128i ac = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    __m128i bd = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(ac, bd);
+
+    // Map each 6-bit value to the offset that turns it into its character.
+    __m128i offsets = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    offsets = _mm_or_si128(offsets, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+    const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(indices, _mm_shuffle_epi8(shift, offsets));
+}
 
-    // Validation
+__attribute__((target("ssse3")))
+static size_t _encode_ssse3(const unsigned char* ptr, size_t size, char* output)
+{
+    size_t done = 0;
+    // Each step loads 16 bytes and consumes 12.
+    for (; size - done >= 16; done += 12, output += 16)
     {
-        auto size = input.size();
+        __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + done));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _encode_block_ssse3(input));
+    }
+    return done;
+}
 
-        if ( (size % 4) != 0 )
-        {
-            throw std::runtime_error("length of base64 string is not an even multiple of 4");
-        }
+__attribute__((target("avx2")))
+static size_t _encode_avx2(const unsigned char* ptr, size_t size, char* output)
+{
+    const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i shift = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    size_t done = 0;
+    // Each step loads 12 bytes into each half, reading 28 and consuming 24.
+    for (; size - done >= 28; done += 24, output += 32)
+    {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + done));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + done + 12));
+        __m256i in = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1), spread);
+
+        __m256i ac = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+        __m256i bd = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(ac, bd);
+
+        __m256i offsets = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        offsets = _mm256_or_si256(offsets, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+        __m256i text = _mm256_add_epi8(indices, _mm256_shuffle_epi8(shift, offsets));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), text);
+    }
+    return done + _encode_ssse3(ptr + done, size - done, output);
+}
 
-        for (auto iter = input.begin(); iter != input.end(); ++iter,--size)
+__attribute__((target("ssse3")))
+static size_t _decode_ssse3(const char* ptr, size_t size, unsigned char* output)
+{
+    const __m128i lut_low = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_high = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+
+    size_t done = 0;
+    // Each step consumes 16 characters and stores 16 bytes of which 12 are kept; staying 8 characters short of the
+    // end leaves the padded last group to the scalar code and guarantees the spare stores land inside the output.
+    for (; size - done >= 24; done += 16, output += 12)
+    {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + done));
+        __m128i high = _mm_and_si128(_mm_srli_epi32(in, 4), nibble);
+        __m128i low = _mm_and_si128(in, nibble);
+        __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lut_low, low), _mm_shuffle_epi8(lut_high, high));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xFFFF)
         {
-            auto ch = *iter;
-            if ( ch < 0 || _base64_dectbl[ch] == 255 )
-            {
-                throw std::runtime_error("invalid character found in base64 string");
-            }
-            if ( _base64_dectbl[ch] == 254 )
-            {
-                padding++;
-                // padding only at the end
-                if ( size > 2 || (size == 2 && _base64_dectbl[*(iter+1)] != 254) )
-                {
-                    throw std::runtime_error("invalid padding character found in base64 string");
-                }
-            }
+            break;
         }
+
+        __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(in, _mm_set1_epi8('/')), high));
+        __m128i values = _mm_add_epi8(in, roll);
+        __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        packed = _mm_shuffle_epi8(packed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), packed);
     }
+    return done;
+}
 
+__attribute__((target("avx2")))
+static size_t _decode_avx2(const char* ptr, size_t size, unsigned char* output)
+{
+    const __m256i lut_low = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_high = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+
+    size_t done = 0;
+    // Each step consumes 32 characters and stores 32 bytes of which 24 are kept.
+    for (; size - done >= 48; done += 32, output += 24)
+    {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + done));
+        __m256i high = _mm256_and_si256(_mm256_srli_epi32(in, 4), nibble);
+        __m256i low = _mm256_and_si256(in, nibble);
+        __m256i invalid = _mm256_and_si256(_mm256_shuffle_epi8(lut_low, low), _mm256_shuffle_epi8(lut_high, high));
+        if (!_mm256_testz_si256(invalid, invalid))
+        {
+            break;
+        }
 
-    auto size = input.size();
-    const char_t* ptr = &input[0];
+        __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(in, _mm256_set1_epi8('/')), high));
+        __m256i values = _mm256_add_epi8(in, roll);
+        __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        __m256i packed = _mm256_shuffle_epi8(_mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000)), pack);
+        packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), packed);
+    }
+    return done + _decode_ssse3(ptr + done, size - done, output);
+}
 
-    auto outsz = (size / 4)*3;
-    outsz -= padding;
+static size_t _encode_none(const unsigned char*, size_t, char*)
+{
+    return 0;
+}
 
-    result.resize(outsz);
+static size_t _decode_none(const char*, size_t, unsigned char*)
+{
+    return 0;
+}
 
-    size_t idx = 0;
-    for (; size > 4; ++idx )
+struct _base64_kernels
+{
+    _base64_kernels()
     {
-        unsigned char target[3];
-        memset(target, 0, sizeof(target));
-        _triple_byte* record = reinterpret_cast<_triple_byte*>(target);
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            encode = _encode_avx2;
+            decode = _decode_avx2;
+        }
+        else if (__builtin_cpu_supports("ssse3"))
+        {
+            encode = _encode_ssse3;
+            decode = _decode_ssse3;
+        }
+        else
+        {
+            encode = _encode_none;
+            decode = _decode_none;
+        }
+    }
 
-        unsigned char val0 = _base64_dectbl[ptr[0]];
-        unsigned char val1 = _base64_dectbl[ptr[1]];
-        unsigned char val2 = _base64_dectbl[ptr[2]];
-        unsigned char val3 = _base64_dectbl[ptr[3]];
+    _base64_encode_kernel encode;
+    _base64_decode_kernel decode;
+};
 
-        record->_0   = val0;
-        record->_1_1 = val1 >> 4;
-        result[idx] = target[0];
+// Resolved on first use, so that static initializers elsewhere can already encode and decode.
+static const _base64_kernels& _kernels()
+{
+    static const _base64_kernels kernels;
+    return kernels;
+}
 
-        record->_1_2 = val1 & 0xF;
-        record->_2_1 = val2 >> 2;
-        result[++idx] = target[1];
+#endif
 
-        record->_2_2 = val2 & 0x3;
-        record->_3   = val3 & 0x3F;
-        result[++idx] = target[2];
+static void _to_base64(const unsigned char* ptr, size_t size, char_t* output)
+{
+#if defined(_USE_SIMD_BASE64_)
+    size_t done = _kernels().encode(ptr, size, output);
+    ptr += done;
+    size -= done;
+    output += done / 3 * 4;
+#endif
 
-        ptr += 4;
-        size -= 4;
+    for (; size >= 3; size -= 3, ptr += 3, output += 4)
+    {
+        uint32_t bits = (uint32_t)ptr[0] << 16 | (uint32_t)ptr[1] << 8 | ptr[2];
+        output[0] = char_t(_base64_enctbl[bits >> 18]);
+        output[1] = char_t(_base64_enctbl[(bits >> 12) & 0x3F]);
+        output[2] = char_t(_base64_enctbl[(bits >> 6) & 0x3F]);
+        output[3] = char_t(_base64_enctbl[bits & 0x3F]);
     }
 
-    // Handle the last four bytes separately, to avoid having the conditional statements
-    // in all the iterations (a performance issue).
-
-    { 
-        unsigned char target[3];
-        memset(target, 0, sizeof(target));
-        _triple_byte* record = reinterpret_cast<_triple_byte*>(target);
-
-        unsigned char val0 = _base64_dectbl[ptr[0]];
-        unsigned char val1 = _base64_dectbl[ptr[1]];
-        unsigned char val2 = _base64_dectbl[ptr[2]];
-        unsigned char val3 = _base64_dectbl[ptr[3]];
+    if (size != 0)
+    {
+        uint32_t bits = (uint32_t)ptr[0] << 16 | (size == 2 ? (uint32_t)ptr[1] << 8 : 0);
+        output[0] = char_t(_base64_enctbl[bits >> 18]);
+        output[1] = char_t(_base64_enctbl[(bits >> 12) & 0x3F]);
+        output[2] = size == 2 ? char_t(_base64_enctbl[(bits >> 6) & 0x3F]) : char_t('=');
+        output[3] = char_t('=');
+    }
+}
 
-        record->_0   = val0;
-        record->_1_1 = val1 >> 4;
-        result[idx] = target[0];
+static unsigned char _decode_char(char_t ch)
+{
+    return (unsigned int)ch < 128 ? _base64_dectbl[(unsigned int)ch] : _base64_invalid;
+}
 
-        record->_1_2 = val1 & 0xF;
-        if ( val2 != 254 )
+static void _throw_invalid_group(const char_t* group)
+{
+    for (size_t i = 0; i < 4; i++)
+    {
+        unsigned char value = _decode_char(group[i]);
+        if (value == _base64_invalid)
         {
-            record->_2_1 = val2 >> 2;
-            result[++idx] = target[1];
+            throw std::runtime_error("invalid character found in base64 string");
         }
-        else
+        if (value == _base64_padding)
         {
-            // There shouldn't be any information (ones) in the unused bits,
-            if ( record->_1_2 != 0 )
-            {
-                throw std::runtime_error("Invalid end of base64 string");
-            }
-                return result;
+            throw std::runtime_error("invalid padding character found in base64 string");
         }
+    }
+}
 
-        record->_2_2 = val2 & 0x3;
-        if ( val3 != 254 )
-        {
-            record->_3   = val3 & 0x3F;
-            result[++idx] = target[2];
-        }
-        else
+static size_t _from_base64(const char_t* ptr, size_t size, unsigned char* output)
+{
+    if ((size % 4) != 0)
+    {
+        throw std::runtime_error("length of base64 string is not an even multiple of 4");
+    }
+
+    unsigned char* start = output;
+
+#if defined(_USE_SIMD_BASE64_)
+    size_t done = _kernels().decode(ptr, size, output);
+    ptr += done;
+    size -= done;
+    output += done / 4 * 3;
+#endif
+
+    // Every group but the last must be four characters of the alphabet.
+    for (; size > 4; size -= 4, ptr += 4, output += 3)
+    {
+        unsigned char val0 = _decode_char(ptr[0]);
+        unsigned char val1 = _decode_char(ptr[1]);
+        unsigned char val2 = _decode_char(ptr[2]);
+        unsigned char val3 = _decode_char(ptr[3]);
+        if ((val0 | val1 | val2 | val3) & 0x80)
         {
-            // There shouldn't be any information (ones) in the unused bits.
-            if ( record->_2_2 != 0 )
-            {
-                throw std::runtime_error("Invalid end of base64 string");
-            }
-                return result;
+            _throw_invalid_group(ptr);
         }
+
+        output[0] = (unsigned char)(val0 << 2 | val1 >> 4);
+        output[1] = (unsigned char)(val1 << 4 | val2 >> 2);
+        output[2] = (unsigned char)(val2 << 6 | val3);
     }
 
-    return result;
-}
+    // The last group may end with one or two padding characters, in which case the unused bits must be zero.
+    unsigned char val0 = _decode_char(ptr[0]);
+    unsigned char val1 = _decode_char(ptr[1]);
+    unsigned char val2 = _decode_char(ptr[2]);
+    unsigned char val3 = _decode_char(ptr[3]);
+    if ((val0 | val1) & 0x80 || val2 == _base64_invalid || (val2 == _base64_padding && val3 != _base64_padding) || val3 == _base64_invalid)
+    {
+        _throw_invalid_group(ptr);
+    }
 
-utility::string_t _to_base64(const unsigned char *ptr, size_t size)
-{
-    utility::string_t result;
-    
-    for (; size >= 3; )
-    {
-        const _triple_byte* record = reinterpret_cast<const _triple_byte*>(ptr);
-        unsigned char idx0 = record->_0;
-        unsigned char idx1 = (record->_1_1 << 4) | record->_1_2;
-        unsigned char idx2 = (record->_2_1 << 2) | record->_2_2;
-        unsigned char idx3 = record->_3;
-        result.push_back(char_t(_base64_enctbl[idx0]));
-        result.push_back(char_t(_base64_enctbl[idx1]));
-        result.push_back(char_t(_base64_enctbl[idx2]));
-        result.push_back(char_t(_base64_enctbl[idx3]));
-        size -= 3;
-        ptr += 3;
-    }
-    switch(size)
-    {
-        case 1:
+    *output++ = (unsigned char)(val0 << 2 | val1 >> 4);
+    if (val2 == _base64_padding)
+    {
+        if ((val1 & 0xF) != 0)
         {
-            const _triple_byte* record = reinterpret_cast<const _triple_byte*>(ptr);
-            unsigned char idx0 = record->_0;
-            unsigned char idx1 = (record->_1_1 << 4);
-            result.push_back(char_t(_base64_enctbl[idx0]));
-            result.push_back(char_t(_base64_enctbl[idx1]));
-            result.push_back('=');
-            result.push_back('=');
-            break;
+            throw std::runtime_error("Invalid end of base64 string");
         }
-        case 2:
+        return (size_t)(output - start);
+    }
+
+    *output++ = (unsigned char)(val1 << 4 | val2 >> 2);
+    if (val3 == _base64_padding)
+    {
+        if ((val2 & 0x3) != 0)
         {
-            const _triple_byte* record = reinterpret_cast<const _triple_byte*>(ptr);
-            unsigned char idx0 = record->_0;
-            unsigned char idx1 = (record->_1_1 << 4) | record->_1_2;
-            unsigned char idx2 = (record->_2_1 << 2);
-            result.push_back(char_t(_base64_enctbl[idx0]));
-            result.push_back(char_t(_base64_enctbl[idx1]));
-            result.push_back(char_t(_base64_enctbl[idx2]));
-            result.push_back('=');
-            break;
+            throw std::runtime_error("Invalid end of base64 string");
         }
+        return (size_t)(output - start);
     }
-    return result;
+
+    *output++ = (unsigned char)(val2 << 6 | val3);
+    return (size_t)(output - start);
 }
-#endif
@@ -970,6 +970,7 @@ done:
     if (!g_keep_json_object_unsorted) {
         ::std::sort(elems.begin(), elems.end(), json::object::compare_pairs);
     }
+    obj->m_object.index_fields();
 
     return obj;
 
@@ -15,93 +15,49 @@
 
 using namespace odata::utility::conversions;
 
-namespace odata { namespace utility { namespace details
-{
-utility::string_t _uri_components::join()
-{
-    // canonicalize components first
-
-    // convert scheme to lowercase
-    std::transform(m_scheme.begin(), m_scheme.end(), m_scheme.begin(), [](utility::char_t c) {
-        return (utility::char_t)tolower(c);
-    });
-
-    // convert host to lowercase
-    std::transform(m_host.begin(), m_host.end(), m_host.begin(), [](utility::char_t c) {
-        return (utility::char_t)tolower(c);
-    });
-
-    // canonicalize the path to have a leading slash if it's a full uri
-    if (!m_host.empty() && m_path.empty())
-    {
-        m_path = _XPLATSTR("/");
-    }
-    else if (!m_host.empty() && m_path[0] != _XPLATSTR('/'))
-    {
-        m_path.insert(m_path.begin(), 1, _XPLATSTR('/'));
-    }
+namespace odata { namespace utility {
 
-    utility::ostringstream_t os;
-
-    if (!m_scheme.empty())
-    {
-        os << m_scheme << _XPLATSTR(':');
-    }
-
-    if (!m_host.empty())
-    {
-        os << _XPLATSTR("//") << m_host;
-
-        if (m_port > 0)
-        {
-            os << _XPLATSTR(':') << m_port;
-        }
-    }
-
-    if (!m_path.empty())
-    {
-        // only add the leading slash when the host is present
-        if (!m_host.empty() && m_path.front() != _XPLATSTR('/'))
-        {
-            os << _XPLATSTR('/');
-        }
-        os << m_path;
-    }
-
-    if (!m_query.empty())
-    {
-        os << _XPLATSTR('?') << m_query;
-    }
+using namespace details;
 
-    if (!m_fragment.empty())
-    {
-        os << _XPLATSTR('#') << m_fragment;
-    }
+#pragma region constructor
 
-    return os.str();
-}
+uri::uri(const utility::string_t &uri_string) : m_uri(uri_string)
+{
+    parse();
 }
 
-using namespace details;
+uri::uri(const utility::char_t *uri_string) : m_uri(uri_string)
+{
+    parse();
+}
 
-#pragma region constructor
+uri::uri(utility::string_t &&uri_string) : m_uri(std::move(uri_string))
+{
+    parse();
+}
 
-uri::uri(const utility::string_t &uri_string)
+void uri::parse()
 {
-    if (!details::uri_parser().parse(uri_string, m_components))
+    bool canonical;
+    if (!details::uri_parser().parse(m_uri, m_offsets, canonical))
     {
-        throw uri_exception("provided uri is invalid: " + utility::conversions::to_utf8string(uri_string));
+        throw uri_exception("provided uri is invalid: " + utility::conversions::to_utf8string(m_uri));
     }
-    m_uri = m_components.join();
-}
 
-uri::uri(const utility::char_t *uri_string): m_uri(uri_string)
-{
-    if (!details::uri_parser().parse(uri_string, m_components))
+    if (!canonical)
     {
-        throw uri_exception("provided uri is invalid: " + utility::conversions::to_utf8string(uri_string));
+        // Rare enough to go the long way round: the builder writes the canonical text, which is parsed again.
+        *this = uri_builder(*this).to_uri();
+        return;
     }
-    m_uri = m_components.join();
+
+    // scheme and host are case insensitive, canonicalize them to lowercase
+    auto to_lower = [](utility::char_t c) -> utility::char_t
+    {
+        return c >= _XPLATSTR('A') && c <= _XPLATSTR('Z') ? (utility::char_t)(c - _XPLATSTR('A') + _XPLATSTR('a')) : c;
+    };
+    std::transform(m_uri.begin(), m_uri.begin() + m_offsets.m_scheme_end, m_uri.begin(), to_lower);
+    std::transform(m_uri.begin() + m_offsets.m_host_begin, m_uri.begin() + m_offsets.m_host_end, m_uri.begin() + m_offsets.m_host_begin, to_lower);
 }
 
 #pragma endregion
@@ -109,11 +65,28 @@ uri::uri(const utility::char_t *uri_string): m_uri(uri_string)
 
 #pragma region encoding
 
-utility::string_t uri::encode_impl(const utility::string_t &raw, const std::function<bool(int)>& should_encode)
+template <typename Predicate>
+utility::string_t uri::encode_impl(const utility::string_t &raw, Predicate should_encode)
 {
     const utility::char_t * const hex = _XPLATSTR("0123456789ABCDEF");
-    utility::string_t encoded;
+#ifdef _UTF16_STRINGS
     std::string utf8raw = to_utf8string(raw);
+#else
+    const std::string &utf8raw = raw;
+#endif
+
+    // size the result first so that it is allocated once
+    size_t length = utf8raw.size();
+    for (auto iter = utf8raw.begin(); iter != utf8raw.end(); ++iter)
+    {
+        if (should_encode(static_cast<unsigned char>(*iter)))
+        {
+            length += 2;
+        }
+    }
+
+    utility::string_t encoded;
+    encoded.reserve(length);
     for (auto iter = utf8raw.begin(); iter != utf8raw.end(); ++iter)
     {
         // for utf8 encoded string, char ASCII can be greater than 127.
@@ -221,6 +194,7 @@ static int hex_char_digit_to_decimal_char(int hex)
 utility::string_t uri::decode(const utility::string_t &encoded)
 {
     std::string utf8raw;
+    utf8raw.reserve(encoded.size());
     for(auto iter = encoded.begin(); iter != encoded.end(); ++iter)
     {
         if(*iter == _XPLATSTR('%'))
@@ -244,7 +218,7 @@ utility::string_t uri::decode(const utility::string_t &encoded)
             utf8raw.push_back(reinterpret_cast<const char &>(*iter));
         }
     }
-    return to_string_t(utf8raw);
+    return to_string_t(std::move(utf8raw));
 }
 
 #pragma endregion
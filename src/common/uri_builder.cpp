@@ -12,7 +12,30 @@
 namespace odata { namespace utility 
 {
 
-#pragma region Validation
+#pragma region Constructors
+
+uri_builder::uri_builder(const uri &uri_str) : m_port(uri_str.m_offsets.m_port)
+{
+    const auto &text = uri_str.m_uri;
+    const auto &offsets = uri_str.m_offsets;
+    const uint32_t bounds[part_count][2] =
+    {
+        { 0, offsets.m_scheme_end },
+        { offsets.m_user_info_begin, offsets.m_user_info_end },
+        { offsets.m_host_begin, offsets.m_host_end },
+        { offsets.m_path_begin, offsets.m_path_end },
+        { offsets.m_query_begin, offsets.m_query_end },
+        { offsets.m_fragment_begin, (uint32_t)text.size() },
+    };
+
+    // the delimiters are left out, so the components always fit in the length of the text
+    m_buffer.reserve(text.size());
+    for (int part = scheme_part; part < part_count; part++)
+    {
+        m_buffer.append(text, bounds[part][0], bounds[part][1] - bounds[part][0]);
+        m_ends[part] = m_buffer.size();
+    }
+}
 
 #pragma endregion
 
@@ -24,33 +47,35 @@ uri_builder &uri_builder::append_path(const utility::string_t &path, bool is_enc
     {
         return *this;
     }
-    
-    auto encoded_path = is_encode ? uri::encode_uri(path, uri::components::path) : path;
-    auto thisPath = this->path();
-    if(thisPath.empty() || thisPath == _XPLATSTR("/"))
+
+    if (is_encode)
     {
-        if(encoded_path.front() != _XPLATSTR('/'))
-        {
-            set_path(_XPLATSTR("/") + encoded_path);
-        }
-        else
-        {
-            set_path(encoded_path);
-        }
-    }   
-    else if(thisPath.back() == _XPLATSTR('/') && encoded_path.front() == _XPLATSTR('/'))
+        return append_path(uri::encode_uri(path, uri::components::path));
+    }
+
+    size_t begin = part_begin(path_part);
+    if (m_ends[path_part] == begin || (m_ends[path_part] == begin + 1 && m_buffer[begin] == _XPLATSTR('/')))
     {
-        thisPath.pop_back();
-        set_path(thisPath + encoded_path);
+        // An empty path becomes the root, so the result has a leading slash.
+        splice(path_part, begin, m_ends[path_part] - begin, _XPLATSTR("/"), 1);
     }
-    else if(thisPath.back() != _XPLATSTR('/') && encoded_path.front() != _XPLATSTR('/'))
+
+    size_t end = m_ends[path_part];
+    bool trailing_slash = m_buffer[end - 1] == _XPLATSTR('/');
+    bool leading_slash = path.front() == _XPLATSTR('/');
+    if (trailing_slash && leading_slash)
     {
-        set_path(thisPath + _XPLATSTR("/") + encoded_path);
+        splice(path_part, end, 0, path.data() + 1, path.size() - 1);
+    }
+    else if (!trailing_slash && !leading_slash)
+    {
+        splice(path_part, end, 0, _XPLATSTR("/"), 1);
+        splice(path_part, end + 1, 0, path.data(), path.size());
     }
     else
     {
         // Only one slash.
-        set_path(thisPath + encoded_path);
+        splice(path_part, end, 0, path.data(), path.size());
     }
     return *this;
 }
@@ -61,26 +86,34 @@ uri_builder &uri_builder::append_query(const utility::string_t &query, bool is_e
     {
         return *this;
     }
-    
-    auto encoded_query = is_encode ? uri::encode_uri(query, uri::components::path) : query;
-    auto thisQuery = this->query();
-    if (thisQuery.empty())
+
+    if (is_encode)
     {
-        this->set_query(encoded_query);
+        return append_query(uri::encode_uri(query, uri::components::path));
     }
-    else if(thisQuery.back() == _XPLATSTR('&') && encoded_query.front() == _XPLATSTR('&'))
+
+    size_t end = m_ends[query_part];
+    if (end == part_begin(query_part))
     {
-        thisQuery.pop_back();
-        this->set_query(thisQuery + encoded_query);
+        set_part(query_part, query);
+        return *this;
     }
-    else if(thisQuery.back() != _XPLATSTR('&') && encoded_query.front() != _XPLATSTR('&'))
+
+    bool trailing_ampersand = m_buffer[end - 1] == _XPLATSTR('&');
+    bool leading_ampersand = query.front() == _XPLATSTR('&');
+    if (trailing_ampersand && leading_ampersand)
     {
-        this->set_query(thisQuery + _XPLATSTR("&") + encoded_query);
+        splice(query_part, end, 0, query.data() + 1, query.size() - 1);
+    }
+    else if (!trailing_ampersand && !leading_ampersand)
+    {
+        splice(query_part, end, 0, _XPLATSTR("&"), 1);
+        splice(query_part, end + 1, 0, query.data(), query.size());
     }
     else
     {
         // Only one ampersand.
-        this->set_query(thisQuery + encoded_query);
+        splice(query_part, end, 0, query.data(), query.size());
     }
     return *this;
 }
@@ -89,7 +122,8 @@ uri_builder &uri_builder::append(const uri &relative_uri)
 {
     append_path(relative_uri.path());
     append_query(relative_uri.query());
-    this->set_fragment(this->fragment() + relative_uri.fragment());
+    auto fragment = relative_uri.fragment();
+    splice(fragment_part, m_ends[fragment_part], 0, fragment.data(), fragment.size());
     return *this;
 }
 
@@ -97,20 +131,89 @@ uri_builder &uri_builder::append(const uri &relative_uri)
 
 #pragma region URI Creation
 
+static void append_port(utility::string_t &text, int port)
+{
+    utility::char_t digits[16];
+    int count = 0;
+    do
+    {
+        digits[count++] = (utility::char_t)(_XPLATSTR('0') + port % 10);
+        port /= 10;
+    } while (port);
+
+    while (count)
+    {
+        text.push_back(digits[--count]);
+    }
+}
+
+utility::string_t uri_builder::join() const
+{
+    size_t host_length = m_ends[host_part] - part_begin(host_part);
+    size_t path_length = m_ends[path_part] - part_begin(path_part);
+
+    // scheme, user info and port delimiters, slashes around the host and the query and fragment delimiters
+    utility::string_t text;
+    text.reserve(m_buffer.size() + 20);
+
+    if (m_ends[scheme_part])
+    {
+        text.append(m_buffer, 0, m_ends[scheme_part]);
+        text.push_back(_XPLATSTR(':'));
+    }
+
+    if (host_length)
+    {
+        text.append(_XPLATSTR("//"));
+        if (m_ends[user_info_part] != part_begin(user_info_part))
+        {
+            text.append(m_buffer, part_begin(user_info_part), m_ends[user_info_part] - part_begin(user_info_part));
+            text.push_back(_XPLATSTR('@'));
+        }
+        text.append(m_buffer, part_begin(host_part), host_length);
+
+        if (m_port > 0)
+        {
+            text.push_back(_XPLATSTR(':'));
+            append_port(text, m_port);
+        }
+    }
+
+    // canonicalize the path to have a leading slash if it's a full uri, and to the root if it is empty
+    if (path_length == 0 || (host_length && m_buffer[part_begin(path_part)] != _XPLATSTR('/')))
+    {
+        text.push_back(_XPLATSTR('/'));
+    }
+    text.append(m_buffer, part_begin(path_part), path_length);
+
+    if (m_ends[query_part] != part_begin(query_part))
+    {
+        text.push_back(_XPLATSTR('?'));
+        text.append(m_buffer, part_begin(query_part), m_ends[query_part] - part_begin(query_part));
+    }
+
+    if (m_ends[fragment_part] != part_begin(fragment_part))
+    {
+        text.push_back(_XPLATSTR('#'));
+        text.append(m_buffer, part_begin(fragment_part), m_ends[fragment_part] - part_begin(fragment_part));
+    }
+
+    return text;
+}
 
 utility::string_t uri_builder::to_string()
 {
-    return to_uri().to_string();
+    return std::move(to_uri().m_uri);
 }
 
 uri uri_builder::to_uri()
 {
-    return uri(m_uri.join());
+    return uri(join());
 }
 
 bool uri_builder::is_valid()
 {
-    return uri::validate(m_uri.join());
+    return uri::validate(join());
 }
 
 #pragma endregion
@@ -11,6 +11,7 @@
 #include <locale>
 #include "odata/common/uri_parser.h"
 #include <algorithm>
+#include <climits>
 
 namespace odata { namespace utility { namespace details
 {
@@ -25,7 +26,8 @@ bool uri_parser::validate(const utility::string_t &encoded_string) const
     const utility::char_t *uinfo_end = nullptr;
     const utility::char_t *host_begin = nullptr;
     const utility::char_t *host_end = nullptr;
-    int port_ptr = 0;
+    const utility::char_t *port_begin = nullptr;
+    const utility::char_t *port_end = nullptr;
     const utility::char_t *path_begin = nullptr;
     const utility::char_t *path_end = nullptr;
     const utility::char_t *query_begin = nullptr;
@@ -42,7 +44,8 @@ bool uri_parser::validate(const utility::string_t &encoded_string) const
         &uinfo_end,
         &host_begin,
         &host_end,
-        &port_ptr,
+        &port_begin,
+        &port_end,
         &path_begin,
         &path_end,
         &query_begin,
@@ -53,7 +56,8 @@ bool uri_parser::validate(const utility::string_t &encoded_string) const
 
 bool uri_parser::parse(
             const utility::string_t &encoded_string,
-            _uri_components &components) const
+            _uri_offsets &offsets,
+            bool &canonical) const
 {
     const utility::char_t *scheme_begin = nullptr;
     const utility::char_t *scheme_end = nullptr;
@@ -61,7 +65,8 @@ bool uri_parser::parse(
     const utility::char_t *host_end = nullptr;
     const utility::char_t *uinfo_begin = nullptr;
     const utility::char_t *uinfo_end = nullptr;
-    int port_ptr = 0;
+    const utility::char_t *port_begin = nullptr;
+    const utility::char_t *port_end = nullptr;
     const utility::char_t *path_begin = nullptr;
     const utility::char_t *path_end = nullptr;
     const utility::char_t *query_begin = nullptr;
@@ -69,7 +74,8 @@ bool uri_parser::parse(
     const utility::char_t *fragment_begin = nullptr;
     const utility::char_t *fragment_end = nullptr;
 
-    if (inner_parse(
+    // offsets are 32 bits wide
+    if (encoded_string.size() > UINT32_MAX || !inner_parse(
         encoded_string.c_str(),
         &scheme_begin,
         &scheme_end,
@@ -77,7 +83,8 @@ bool uri_parser::parse(
         &uinfo_end,
         &host_begin,
         &host_end,
-        &port_ptr,
+        &port_begin,
+        &port_end,
         &path_begin,
         &path_end,
         &query_begin,
@@ -85,83 +92,79 @@ bool uri_parser::parse(
         &fragment_begin,
         &fragment_end))
     {
-        if (scheme_begin)
-        {
-            components.m_scheme.assign(scheme_begin, scheme_end);
-
-            // convert scheme to lowercase
-            std::transform(components.m_scheme.begin(), components.m_scheme.end(), components.m_scheme.begin(), [this](utility::char_t c) {
-                return std::tolower(c, this->loc);
-            });
-        }
-        else
-        {
-            components.m_scheme.clear();
-        }
-
-        if (uinfo_begin)
-        {
-            components.m_user_info.assign(uinfo_begin, uinfo_end);
-        }
+        return false;
+    }
 
-        if (host_begin)
-        {
-            components.m_host.assign(host_begin, host_end);
+    const utility::char_t *text = encoded_string.c_str();
+    canonical = true;
 
-            // convert host to lowercase
-            std::transform(components.m_host.begin(), components.m_host.end(), components.m_host.begin(), [this](utility::char_t c) {
-                return std::tolower(c, this->loc);
-            });
-        }
-        else
-        {
-            components.m_host.clear();
-        }
+    // absent components become empty ranges where they would start
+    const utility::char_t *p = scheme_begin ? scheme_end : text;
+    offsets.m_scheme_end = (uint32_t)(p - text);
+    if (scheme_begin)
+    {
+        p++;
+    }
 
-        if (port_ptr)
-        {
-            components.m_port = port_ptr;
-        }
-        else
-        {
-            components.m_port = 0;
-        }
+    if (host_begin == host_end && p[0] == _XPLATSTR('/') && p[1] == _XPLATSTR('/'))
+    {
+        // an empty authority is dropped
+        canonical = false;
+    }
 
-        if (path_begin)
-        {
-            components.m_path.assign(path_begin, path_end);
-        }
-        else
-        {
-            // default path to begin with a slash for easy comparison
-            components.m_path = _XPLATSTR("/");
-        }
+    offsets.m_user_info_begin = offsets.m_user_info_end = (uint32_t)(p - text);
+    if (uinfo_begin)
+    {
+        offsets.m_user_info_begin = (uint32_t)(uinfo_begin - text);
+        offsets.m_user_info_end = (uint32_t)(uinfo_end - text);
+    }
 
-        if (query_begin)
-        {
-            components.m_query.assign(query_begin, query_end);
-        }
-        else
-        {
-            components.m_query.clear();
-        }
+    offsets.m_host_begin = offsets.m_host_end = offsets.m_user_info_end;
+    if (host_begin)
+    {
+        offsets.m_host_begin = (uint32_t)(host_begin - text);
+        offsets.m_host_end = (uint32_t)(host_end - text);
+    }
 
-        if (fragment_begin)
-        {
-            components.m_fragment.assign(fragment_begin, fragment_end);
-        }
-        else
+    offsets.m_port = 0;
+    if (port_begin)
+    {
+        // only a positive port without leading zeros is kept as written
+        canonical = canonical && port_begin != port_end && *port_begin != _XPLATSTR('0') && port_end - port_begin < 10;
+        for (const utility::char_t *digit = port_begin; digit != port_end; digit++)
         {
-            components.m_fragment.clear();
+            offsets.m_port = offsets.m_port > (INT_MAX - 9) / 10 ? INT_MAX : offsets.m_port * 10 + (*digit - _XPLATSTR('0'));
         }
+    }
 
-        return true;
+    if (path_begin)
+    {
+        offsets.m_path_begin = (uint32_t)(path_begin - text);
+        offsets.m_path_end = (uint32_t)(path_end - text);
     }
     else
     {
-        return false;
+        // the path defaults to a slash for easy comparison
+        offsets.m_path_begin = offsets.m_path_end = (uint32_t)((port_end ? port_end : host_begin ? host_end : p) - text);
+        canonical = false;
+    }
+
+    offsets.m_query_begin = offsets.m_query_end = offsets.m_path_end;
+    if (query_begin)
+    {
+        offsets.m_query_begin = (uint32_t)(query_begin - text);
+        offsets.m_query_end = (uint32_t)(query_end - text);
+        canonical = canonical && query_begin != query_end;
     }
-            
+
+    offsets.m_fragment_begin = (uint32_t)encoded_string.size();
+    if (fragment_begin)
+    {
+        offsets.m_fragment_begin = (uint32_t)(fragment_begin - text);
+        canonical = canonical && fragment_begin != fragment_end;
+    }
+
+    return true;
 }
 
 bool uri_parser::inner_parse(
@@ -169,7 +172,7 @@ bool uri_parser::inner_parse(
             const utility::char_t **scheme_begin, const utility::char_t **scheme_end,
             const utility::char_t **uinfo_begin, const utility::char_t **uinfo_end,
             const utility::char_t **host_begin, const utility::char_t **host_end,
-            _Out_ int *port,
+            const utility::char_t **port_begin, const utility::char_t **port_end,
             const utility::char_t **path_begin, const utility::char_t **path_end,
             const utility::char_t **query_begin, const utility::char_t **query_end,
             const utility::char_t **fragment_begin, const utility::char_t **fragment_end) const
@@ -180,7 +183,8 @@ bool uri_parser::inner_parse(
     *uinfo_end = nullptr;
     *host_begin = nullptr;
     *host_end = nullptr;
-    *port = 0;
+    *port_begin = nullptr;
+    *port_end = nullptr;
     *path_begin = nullptr;
     *path_end = nullptr;
     *query_begin = nullptr;
@@ -256,23 +260,19 @@ bool uri_parser::inner_parse(
         if (authority_begin != authority_end)
         {
             // the port is made up of all digits
-            const utility::char_t *port_begin = authority_end - 1;
-            for (;isdigit(*port_begin) && port_begin != authority_begin; port_begin--)
+            const utility::char_t *port_colon = authority_end - 1;
+            for (;isdigit(*port_colon) && port_colon != authority_begin; port_colon--)
             { }
 
-            if (*port_begin == _XPLATSTR(':'))
+            if (*port_colon == _XPLATSTR(':'))
             {
                 // has a port
                 *host_begin = authority_begin;
-                *host_end = port_begin;
+                *host_end = port_colon;
 
                 //skip the colon
-                port_begin++;
-
-                utility::istringstream_t port_str(utility::string_t(port_begin, authority_end));
-                int port_num;
-                port_str >> port_num;
-                *port = port_num;
+                *port_begin = port_colon + 1;
+                *port_end = authority_end;
             }
             else
             {
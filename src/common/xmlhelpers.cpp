@@ -426,15 +426,19 @@ namespace odata { namespace edm {
                 xmlTextWriterStartElementNS(m_writer, valueXmlPrefix, valueXmlName, valueXmlNamespace);
             }
 #else
-        xmlChar* valueXmlName = convert_to_xmlchar(::odata::utility::conversions::to_utf8string(elementName).c_str());
+        // The UTF-8 copies must outlive the calls into libxml2 that read them.
+        std::string elementNameUtf8 = ::odata::utility::conversions::to_utf8string(elementName);
+        std::string elementPrefixUtf8 = ::odata::utility::conversions::to_utf8string(elementPrefix);
+        std::string namespaceNameUtf8 = ::odata::utility::conversions::to_utf8string(namespaceName);
+        xmlChar* valueXmlName = convert_to_xmlchar(elementNameUtf8.c_str());
         if (elementPrefix.empty() && namespaceName.empty())
         {
             xmlTextWriterStartElement(m_writer, valueXmlName);
         }
         else
         {
-            xmlChar* valueXmlPrefix = elementPrefix.empty() ? NULL : convert_to_xmlchar(::odata::utility::conversions::to_utf8string(elementPrefix).c_str());
-            xmlChar* valueXmlNamespace = namespaceName.empty() ? NULL : convert_to_xmlchar(::odata::utility::conversions::to_utf8string(namespaceName).c_str());
+            xmlChar* valueXmlPrefix = elementPrefix.empty() ? NULL : convert_to_xmlchar(elementPrefixUtf8.c_str());
+            xmlChar* valueXmlNamespace = namespaceName.empty() ? NULL : convert_to_xmlchar(namespaceNameUtf8.c_str());
             xmlTextWriterStartElementNS(m_writer, valueXmlPrefix, valueXmlName, valueXmlNamespace);
         }
 #endif
@@ -506,8 +510,9 @@ namespace odata { namespace edm {
             throw std::runtime_error(msg);
         }
 #else
-        UNREFERENCED_PARAMETER(str);
-        throw std::runtime_error("Not implemented");
+        std::string strUtf8 = ::odata::utility::conversions::to_utf8string(str);
+        xmlChar* strXml = convert_to_xmlchar(strUtf8.c_str());
+        xmlTextWriterWriteString(m_writer, strXml);
 #endif
     }
 
@@ -544,16 +549,20 @@ namespace odata { namespace edm {
                 xmlTextWriterWriteAttributeNS(m_writer, valueXmlPrefix, nameXml, valueXmlNamespace, valueXml);
             }
 #else
-        xmlChar* nameXml = convert_to_xmlchar(::odata::utility::conversions::to_utf8string(name).c_str());
-        xmlChar* valueXml = convert_to_xmlchar(::odata::utility::conversions::to_utf8string(value).c_str());
+        std::string nameUtf8 = ::odata::utility::conversions::to_utf8string(name);
+        std::string valueUtf8 = ::odata::utility::conversions::to_utf8string(value);
+        std::string prefixUtf8 = ::odata::utility::conversions::to_utf8string(prefix);
+        std::string namespaceUriUtf8 = ::odata::utility::conversions::to_utf8string(namespaceUri);
+        xmlChar* nameXml = convert_to_xmlchar(nameUtf8.c_str());
+        xmlChar* valueXml = convert_to_xmlchar(valueUtf8.c_str());
         if (prefix.empty() && namespaceUri.empty())
         {
             xmlTextWriterWriteAttribute(m_writer, nameXml, valueXml);
         }
         else
         {
-            xmlChar* valueXmlPrefix = prefix.empty() ? NULL : convert_to_xmlchar(::odata::utility::conversions::to_utf8string(prefix).c_str());
-            xmlChar* valueXmlNamespace = namespaceUri.empty() ? NULL : convert_to_xmlchar(::odata::utility::conversions::to_utf8string(namespaceUri).c_str());
+            xmlChar* valueXmlPrefix = prefix.empty() ? NULL : convert_to_xmlchar(prefixUtf8.c_str());
+            xmlChar* valueXmlNamespace = namespaceUri.empty() ? NULL : convert_to_xmlchar(namespaceUriUtf8.c_str());
             xmlTextWriterWriteAttributeNS(m_writer, valueXmlPrefix, nameXml, valueXmlNamespace, valueXml);
         }
 #endif
@@ -0,0 +1,439 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_apply_executor.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_apply_executor.h"
+#include "odata/core/odata_entity_set_index.h"
+#include "odata/core/odata_exception.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::utility;
+
+namespace odata { namespace core
+{
+
+namespace
+{
+
+// Rows handed to a transformation belong to the caller, results that add properties are built on copies.
+std::shared_ptr<odata_entity_value> copy_row(const std::shared_ptr<odata_entity_value>& row)
+{
+	// Copy the properties one by one, the property map copy constructor moves.
+	auto entity = std::make_shared<odata_entity_value>(std::dynamic_pointer_cast<edm_entity_type>(row->get_value_type()));
+	for (auto property = row->properties().cbegin(); property != row->properties().cend(); ++property)
+	{
+		entity->set_value(property->first, property->second);
+	}
+
+	return entity;
+}
+
+bool is_integral(const std::shared_ptr<odata_primitive_value>& value)
+{
+	auto type = value->get_value_type_pointer();
+	if (!type || type->get_type_kind() != edm_type_kind_t::Primitive)
+	{
+		return false;
+	}
+
+	switch (static_cast<const edm_primitive_type*>(type)->get_primitive_kind())
+	{
+	case edm_primitive_type_kind_t::Byte:
+	case edm_primitive_type_kind_t::SByte:
+	case edm_primitive_type_kind_t::Int16:
+	case edm_primitive_type_kind_t::Int32:
+	case edm_primitive_type_kind_t::Int64:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Running state of one aggregate expression within one group.
+class aggregate_accumulator
+{
+public:
+	aggregate_accumulator(std::shared_ptr<odata_aggregate_expression> expression)
+		: m_expression(expression), m_integral(true), m_int64_sum(0), m_double_sum(0), m_count(0) {}
+
+	void add(const std::shared_ptr<odata_primitive_value>& value)
+	{
+		if (m_expression->method() == odata_aggregate_method::Count)
+		{
+			m_count++;
+			return;
+		}
+
+		if (!value)
+		{
+			// Nulls do not take part in any aggregation method.
+			return;
+		}
+
+		switch (m_expression->method())
+		{
+		case odata_aggregate_method::Sum:
+		case odata_aggregate_method::Average:
+			if (!odata_filter_evaluator::is_numeric(value))
+			{
+				throw odata_exception(U("Aggregate ") + m_expression->alias() + U(" requires numeric values."));
+			}
+
+			if (m_integral && is_integral(value))
+			{
+				m_int64_sum += value->as<int64_t>();
+			}
+			else
+			{
+				if (m_integral)
+				{
+					m_double_sum = (double)m_int64_sum;
+					m_integral = false;
+				}
+				m_double_sum += value->as<double>();
+			}
+			m_count++;
+			break;
+
+		case odata_aggregate_method::Min:
+			if (!m_extreme || odata_filter_evaluator::compare(value, m_extreme) < 0)
+			{
+				m_extreme = value;
+			}
+			break;
+
+		case odata_aggregate_method::Max:
+			if (!m_extreme || odata_filter_evaluator::compare(value, m_extreme) > 0)
+			{
+				m_extreme = value;
+			}
+			break;
+
+		case odata_aggregate_method::CountDistinct:
+			m_distinct.insert(odata_entity_set_index::hash_key(value));
+			break;
+		}
+	}
+
+	std::shared_ptr<odata_value> result() const
+	{
+		switch (m_expression->method())
+		{
+		case odata_aggregate_method::Sum:
+			if (m_integral)
+			{
+				return odata_primitive_value::make_primitive_value(m_int64_sum);
+			}
+			return odata_primitive_value::make_primitive_value(m_double_sum);
+
+		case odata_aggregate_method::Average:
+			if (m_count == 0)
+			{
+				return nullptr;
+			}
+			return odata_primitive_value::make_primitive_value((m_integral ? (double)m_int64_sum : m_double_sum) / m_count);
+
+		case odata_aggregate_method::Min:
+		case odata_aggregate_method::Max:
+			return m_extreme;
+
+		case odata_aggregate_method::CountDistinct:
+			return odata_primitive_value::make_primitive_value((int64_t)m_distinct.size());
+
+		default:
+			return odata_primitive_value::make_primitive_value(m_count);
+		}
+	}
+
+private:
+	std::shared_ptr<odata_aggregate_expression> m_expression;
+	bool m_integral;
+	int64_t m_int64_sum;
+	double m_double_sum;
+	int64_t m_count;
+	std::shared_ptr<odata_primitive_value> m_extreme;
+	std::unordered_set<string_t> m_distinct;
+};
+
+struct group_state
+{
+	std::vector<std::shared_ptr<odata_primitive_value>> keys;
+	std::vector<aggregate_accumulator> accumulators;
+	std::vector<std::shared_ptr<odata_entity_value>> rows;
+};
+
+// The output name of a grouping property is its last path segment.
+string_t group_property_name(std::shared_ptr<odata_query_node> node)
+{
+	if (node && node->node_kind() == odata_query_node_kind::PropertyAccess)
+	{
+		return node->as<odata_property_access_node>()->property_name();
+	}
+
+	throw odata_exception(U("groupby only supports property paths."));
+}
+
+std::shared_ptr<edm_entity_type> aggregation_result_type()
+{
+	static auto type = std::make_shared<edm_entity_type>(U("AggregationResult"), U(""), U(""), false, true);
+	return type;
+}
+
+}
+
+std::vector<std::shared_ptr<::odata::core::odata_entity_value>> odata_apply_executor::execute(
+	std::shared_ptr<::odata::core::odata_apply_clause> apply_clause,
+	const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& entities)
+{
+	if (!apply_clause)
+	{
+		return entities;
+	}
+
+	std::shared_ptr<edm_entity_type> result_type;
+	if (!entities.empty() && entities[0])
+	{
+		result_type = std::dynamic_pointer_cast<edm_entity_type>(entities[0]->get_value_type());
+	}
+
+	return execute(apply_clause->transformations(), entities, result_type ? result_type : aggregation_result_type());
+}
+
+std::vector<std::shared_ptr<::odata::core::odata_entity_value>> odata_apply_executor::execute(
+	const std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>>& transformations,
+	std::vector<std::shared_ptr<::odata::core::odata_entity_value>> rows,
+	std::shared_ptr<::odata::edm::edm_entity_type> result_type)
+{
+	static const std::vector<std::shared_ptr<odata_query_node>> no_group_properties;
+	static const std::vector<std::shared_ptr<odata_apply_transformation>> no_transformations;
+
+	for (auto iter = transformations.cbegin(); iter != transformations.cend(); ++iter)
+	{
+		auto transformation = *iter;
+
+		switch (transformation->transformation_kind())
+		{
+		case odata_apply_transformation_kind::Aggregate:
+			// aggregate(...) is a groupby without grouping properties, it always yields exactly one row.
+			rows = group_by(no_group_properties, std::vector<std::shared_ptr<odata_apply_transformation>>(1, transformation), rows, result_type);
+			break;
+
+		case odata_apply_transformation_kind::GroupBy:
+		{
+			auto group_by_transformation = transformation->as<odata_groupby_transformation>();
+			rows = group_by(group_by_transformation->group_properties(), group_by_transformation->transformations(), rows, result_type);
+			break;
+		}
+
+		case odata_apply_transformation_kind::Filter:
+		{
+			auto expression = transformation->as<odata_filter_transformation>()->expression();
+			auto evaluator = m_evaluator;
+			rows.erase(std::remove_if(rows.begin(), rows.end(), [&](const std::shared_ptr<odata_entity_value>& row)
+			{
+				return !row || !evaluator->evaluate(expression, row);
+			}), rows.end());
+			break;
+		}
+
+		case odata_apply_transformation_kind::Compute:
+			rows = compute(transformation->as<odata_compute_transformation>(), rows);
+			break;
+
+		case odata_apply_transformation_kind::TopCount:
+		case odata_apply_transformation_kind::BottomCount:
+			rows = top_count(transformation->as<odata_topcount_transformation>(), rows);
+			break;
+
+		default:
+			throw odata_exception(U("Unsupported $apply transformation."));
+		}
+	}
+
+	return rows;
+}
+
+std::vector<std::shared_ptr<::odata::core::odata_entity_value>> odata_apply_executor::group_by(
+	const std::vector<std::shared_ptr<::odata::core::odata_query_node>>& group_properties,
+	const std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>>& transformations,
+	const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& rows,
+	std::shared_ptr<::odata::edm::edm_entity_type> result_type)
+{
+	// A single aggregate is folded into running accumulators while scanning; any other nested sequence needs the
+	// rows of each group.
+	std::shared_ptr<odata_aggregate_transformation> aggregate;
+	bool keep_rows = !transformations.empty();
+	if (transformations.size() == 1 && transformations[0]->transformation_kind() == odata_apply_transformation_kind::Aggregate)
+	{
+		aggregate = transformations[0]->as<odata_aggregate_transformation>();
+		keep_rows = false;
+	}
+
+	std::vector<group_state> groups;
+	std::unordered_map<string_t, size_t> group_index;
+
+	auto new_group = [&]() -> group_state&
+	{
+		groups.push_back(group_state());
+		if (aggregate)
+		{
+			const auto &expressions = aggregate->expressions();
+			for (auto expression = expressions.cbegin(); expression != expressions.cend(); ++expression)
+			{
+				groups.back().accumulators.push_back(aggregate_accumulator(*expression));
+			}
+		}
+		return groups.back();
+	};
+
+	if (group_properties.empty())
+	{
+		new_group();
+	}
+
+	std::vector<std::shared_ptr<odata_primitive_value>> keys(group_properties.size());
+	string_t key;
+	for (auto row = rows.cbegin(); row != rows.cend(); ++row)
+	{
+		key.clear();
+		for (size_t i = 0; i < group_properties.size(); i++)
+		{
+			keys[i] = m_evaluator->evaluate_value(group_properties[i], *row);
+
+			// Nulls get a marker that cannot collide with a hash key, values are separated by an unused char.
+			key += keys[i] ? odata_entity_set_index::hash_key(keys[i]) : string_t(1, U('\0'));
+			key += U('\x1f');
+		}
+
+		group_state *group;
+		if (group_properties.empty())
+		{
+			group = &groups[0];
+		}
+		else
+		{
+			auto found = group_index.find(key);
+			if (found == group_index.end())
+			{
+				group_index[key] = groups.size();
+				group = &new_group();
+				group->keys = keys;
+			}
+			else
+			{
+				group = &groups[found->second];
+			}
+		}
+
+		for (auto accumulator = group->accumulators.begin(); accumulator != group->accumulators.end(); ++accumulator)
+		{
+			auto expression = aggregate->expressions()[accumulator - group->accumulators.begin()]->expression();
+			accumulator->add(expression ? m_evaluator->evaluate_value(expression, *row) : nullptr);
+		}
+
+		if (keep_rows)
+		{
+			group->rows.push_back(*row);
+		}
+	}
+
+	std::vector<std::shared_ptr<odata_entity_value>> results;
+	for (auto group = groups.cbegin(); group != groups.cend(); ++group)
+	{
+		std::vector<std::shared_ptr<odata_entity_value>> group_results;
+		if (keep_rows)
+		{
+			group_results = execute(transformations, group->rows, result_type);
+		}
+		else
+		{
+			auto entity = std::make_shared<odata_entity_value>(result_type);
+			for (size_t i = 0; i < group->accumulators.size(); i++)
+			{
+				entity->set_value(aggregate->expressions()[i]->alias(), group->accumulators[i].result());
+			}
+			group_results.push_back(entity);
+		}
+
+		for (auto result = group_results.cbegin(); result != group_results.cend(); ++result)
+		{
+			// Kept rows may be the caller's own entities, the group keys go onto a copy.
+			auto entity = keep_rows ? copy_row(*result) : *result;
+			for (size_t i = 0; i < group_properties.size(); i++)
+			{
+				std::shared_ptr<odata_value> key_value;
+				if (group->keys[i])
+				{
+					key_value = std::make_shared<odata_primitive_value>(*group->keys[i]);
+				}
+				entity->set_value(group_property_name(group_properties[i]), key_value);
+			}
+			results.push_back(entity);
+		}
+	}
+
+	return results;
+}
+
+std::vector<std::shared_ptr<::odata::core::odata_entity_value>> odata_apply_executor::compute(
+	std::shared_ptr<::odata::core::odata_compute_transformation> transformation,
+	const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& rows)
+{
+	const auto &expressions = transformation->expressions();
+
+	std::vector<std::shared_ptr<odata_entity_value>> results;
+	results.reserve(rows.size());
+	for (auto row = rows.cbegin(); row != rows.cend(); ++row)
+	{
+		auto entity = copy_row(*row);
+		for (auto expression = expressions.cbegin(); expression != expressions.cend(); ++expression)
+		{
+			auto value = m_evaluator->evaluate_value((*expression)->expression(), *row);
+			entity->set_value((*expression)->alias(), std::static_pointer_cast<odata_value>(value));
+		}
+
+		results.push_back(entity);
+	}
+
+	return results;
+}
+
+std::vector<std::shared_ptr<::odata::core::odata_entity_value>> odata_apply_executor::top_count(
+	std::shared_ptr<::odata::core::odata_topcount_transformation> transformation,
+	const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& rows)
+{
+	std::vector<std::pair<std::shared_ptr<odata_primitive_value>, std::shared_ptr<odata_entity_value>>> ranked;
+	ranked.reserve(rows.size());
+	for (auto row = rows.cbegin(); row != rows.cend(); ++row)
+	{
+		ranked.push_back(std::make_pair(m_evaluator->evaluate_value(transformation->expression(), *row), *row));
+	}
+
+	bool is_top = transformation->is_top();
+	std::stable_sort(ranked.begin(), ranked.end(), [&](
+		const std::pair<std::shared_ptr<odata_primitive_value>, std::shared_ptr<odata_entity_value>>& left,
+		const std::pair<std::shared_ptr<odata_primitive_value>, std::shared_ptr<odata_entity_value>>& right)
+	{
+		// Nulls rank last in both directions.
+		if (!left.first || !right.first)
+		{
+			return left.first && !right.first;
+		}
+
+		int order = odata_filter_evaluator::compare(left.first, right.first);
+		return is_top ? order > 0 : order < 0;
+	});
+
+	size_t count = transformation->count() > 0 ? (size_t)transformation->count() : 0;
+	std::vector<std::shared_ptr<odata_entity_value>> results;
+	for (size_t i = 0; i < ranked.size() && i < count; i++)
+	{
+		results.push_back(ranked[i].second);
+	}
+
+	return results;
+}
+
+}}
@@ -0,0 +1,367 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_async_operation.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_async_operation.h"
+#include "odata/core/odata_exception.h"
+#include <algorithm>
+#include <random>
+
+using namespace ::odata::utility;
+
+namespace odata { namespace core
+{
+
+static const int16_t StatusOK = 200;
+static const int16_t StatusAccepted = 202;
+static const int16_t StatusNoContent = 204;
+static const int16_t StatusNotFound = 404;
+static const int16_t StatusInternalServerError = 500;
+
+static std::unordered_map<string_t, string_t> embedded_headers()
+{
+	std::unordered_map<string_t, string_t> headers;
+	headers[U("OData-Version")] = U("4.0");
+	headers[U("Content-Type")] = U("application/json;odata.metadata=minimal");
+	return headers;
+}
+
+odata_async_operation_manager::odata_async_operation_manager(uri monitor_root, size_t worker_count, size_t queue_capacity, std::chrono::milliseconds time_to_live)
+	: m_monitor_root(monitor_root), m_queue_capacity(queue_capacity), m_time_to_live(time_to_live), m_retry_after(1),
+	m_running(0), m_stopping(false), m_id_state(((uint64_t)std::random_device()() << 32) ^ (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count())
+{
+	worker_count = std::max<size_t>(worker_count, 1);
+	for (size_t i = 0; i < worker_count; i++)
+	{
+		try
+		{
+			m_workers.push_back(std::thread(&odata_async_operation_manager::work, this));
+		}
+		catch (const std::system_error&)
+		{
+			// Make do with the workers that could be started.
+			if (m_workers.empty())
+			{
+				throw;
+			}
+			break;
+		}
+	}
+}
+
+odata_async_operation_manager::~odata_async_operation_manager()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+		for (auto iter = m_queue.cbegin(); iter != m_queue.cend(); ++iter)
+		{
+			(*iter)->m_status.store(AsyncCancelled, std::memory_order_release);
+		}
+		m_queue.clear();
+	}
+	m_work_available.notify_all();
+
+	for (auto iter = m_workers.begin(); iter != m_workers.end(); ++iter)
+	{
+		iter->join();
+	}
+}
+
+bool odata_async_operation_manager::prefers_respond_async(const string_t& prefer_header)
+{
+	static const char expected[] = "respond-async";
+	const size_t expected_size = sizeof(expected) - 1;
+
+	size_t start = 0;
+	while (start <= prefer_header.size())
+	{
+		size_t end = prefer_header.find(U(','), start);
+		if (end == string_t::npos)
+		{
+			end = prefer_header.size();
+		}
+
+		// A preference is a token, optionally followed by =value and ;parameters.
+		size_t first = start;
+		while (first < end && (prefer_header[first] == U(' ') || prefer_header[first] == U('\t')))
+		{
+			first++;
+		}
+		size_t last = first;
+		while (last < end && prefer_header[last] != U(';') && prefer_header[last] != U('=') && prefer_header[last] != U(' ') && prefer_header[last] != U('\t'))
+		{
+			last++;
+		}
+
+		if (last - first == expected_size)
+		{
+			bool matches = true;
+			for (size_t i = 0; i < expected_size && matches; i++)
+			{
+				auto c = prefer_header[first + i];
+				matches = (c >= U('A') && c <= U('Z') ? c - U('A') + U('a') : c) == (char_t)expected[i];
+			}
+			if (matches)
+			{
+				return true;
+			}
+		}
+
+		start = end + 1;
+	}
+
+	return false;
+}
+
+string_t odata_async_operation_manager::new_id()
+{
+	// splitmix64 over a randomly seeded state, so monitor URLs are not simply counted up.
+	uint64_t z = (m_id_state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	z ^= z >> 31;
+
+	static const char hex[] = "0123456789abcdef";
+	string_t id;
+	for (int shift = 60; shift >= 0; shift -= 4)
+	{
+		id.push_back((char_t)hex[(z >> shift) & 0xF]);
+	}
+	return id;
+}
+
+std::shared_ptr<odata_async_operation> odata_async_operation_manager::submit(std::function<std::shared_ptr<odata_value>(const odata_async_operation&)> job)
+{
+	if (!job)
+	{
+		throw std::invalid_argument("job must not be empty");
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	evict_expired_locked(std::chrono::steady_clock::now());
+	if (m_stopping || m_queue.size() >= m_queue_capacity)
+	{
+		return nullptr;
+	}
+
+	string_t id;
+	do
+	{
+		id = new_id();
+	} while (m_operations.find(id) != m_operations.end());
+
+	auto operation = std::make_shared<odata_async_operation>(id);
+	operation->m_job = std::move(job);
+	m_operations[id] = operation;
+	m_queue.push_back(operation);
+	lock.unlock();
+
+	m_work_available.notify_one();
+	return operation;
+}
+
+void odata_async_operation_manager::work()
+{
+	for (;;)
+	{
+		std::shared_ptr<odata_async_operation> operation;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_work_available.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+			if (m_stopping)
+			{
+				return;
+			}
+
+			operation = m_queue.front();
+			m_queue.pop_front();
+
+			int expected = AsyncPending;
+			if (!operation->m_status.compare_exchange_strong(expected, AsyncRunning))
+			{
+				continue;
+			}
+			m_running++;
+		}
+
+		std::shared_ptr<odata_value> result;
+		string_t error_message;
+		bool failed = false;
+		try
+		{
+			result = operation->m_job(*operation);
+		}
+		catch (odata_exception& e)
+		{
+			failed = true;
+			error_message = e.what();
+		}
+		catch (const std::exception& e)
+		{
+			failed = true;
+			error_message = conversions::to_string_t(std::string(e.what()));
+		}
+		catch (...)
+		{
+			failed = true;
+			error_message = U("unknown error");
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(operation->m_mutex);
+			operation->m_result = std::move(result);
+			operation->m_error_message = std::move(error_message);
+			operation->m_job = nullptr;
+		}
+
+		finish(operation, failed ? AsyncFailed : AsyncCompleted);
+	}
+}
+
+void odata_async_operation_manager::finish(const std::shared_ptr<odata_async_operation>& operation, odata_async_status_t status)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	operation->m_done_at = std::chrono::steady_clock::now();
+
+	// A cancelled operation stays cancelled.
+	int expected = AsyncRunning;
+	operation->m_status.compare_exchange_strong(expected, status);
+
+	m_running--;
+	if (m_running == 0 && m_queue.empty())
+	{
+		m_idle.notify_all();
+	}
+}
+
+size_t odata_async_operation_manager::evict_expired_locked(std::chrono::steady_clock::time_point now)
+{
+	size_t evicted = 0;
+	for (auto iter = m_operations.begin(); iter != m_operations.end();)
+	{
+		const auto& operation = iter->second;
+		if (operation->is_done() && now - operation->m_done_at >= m_time_to_live)
+		{
+			iter = m_operations.erase(iter);
+			evicted++;
+		}
+		else
+		{
+			++iter;
+		}
+	}
+	return evicted;
+}
+
+size_t odata_async_operation_manager::evict_expired()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return evict_expired_locked(std::chrono::steady_clock::now());
+}
+
+std::shared_ptr<odata_async_operation> odata_async_operation_manager::find(const string_t& id)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	evict_expired_locked(std::chrono::steady_clock::now());
+	auto found = m_operations.find(id);
+	return found == m_operations.end() ? nullptr : found->second;
+}
+
+bool odata_async_operation_manager::cancel(const string_t& id)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto found = m_operations.find(id);
+	if (found == m_operations.end())
+	{
+		return false;
+	}
+
+	auto operation = found->second;
+	m_operations.erase(found);
+
+	int expected = AsyncPending;
+	if (operation->m_status.compare_exchange_strong(expected, AsyncCancelled))
+	{
+		// Frees its place in the queue right away.
+		m_queue.erase(std::remove(m_queue.begin(), m_queue.end(), operation), m_queue.end());
+		if (m_running == 0 && m_queue.empty())
+		{
+			m_idle.notify_all();
+		}
+		return true;
+	}
+
+	// A running job sees the cancellation through is_cancelled(), its result is dropped.
+	expected = AsyncRunning;
+	operation->m_status.compare_exchange_strong(expected, AsyncCancelled);
+	return true;
+}
+
+void odata_async_operation_manager::wait_idle()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idle.wait(lock, [this]() { return m_running == 0 && m_queue.empty(); });
+}
+
+uri odata_async_operation_manager::monitor_url(const std::shared_ptr<odata_async_operation>& operation) const
+{
+	uri_builder builder(m_monitor_root);
+	builder.append_path(operation->id());
+	return builder.to_uri();
+}
+
+odata_async_response odata_async_operation_manager::accepted(const std::shared_ptr<odata_async_operation>& operation) const
+{
+	odata_async_response response;
+	response.status_code = StatusAccepted;
+	response.status_message = U("Accepted");
+	response.headers[U("Location")] = monitor_url(operation).to_string();
+	response.headers[U("Preference-Applied")] = U("respond-async");
+	response.headers[U("Retry-After")] = conversions::print_string(m_retry_after.count());
+	return response;
+}
+
+odata_async_response odata_async_operation_manager::poll(const string_t& id, odata_message_writer& writer)
+{
+	auto operation = find(id);
+	if (!operation || operation->is_cancelled())
+	{
+		odata_async_response response;
+		response.status_code = StatusNotFound;
+		response.status_message = U("Not Found");
+		return response;
+	}
+
+	if (!operation->is_done())
+	{
+		return accepted(operation);
+	}
+
+	odata_async_response response;
+	response.status_code = StatusOK;
+	response.status_message = U("OK");
+	response.headers[U("Content-Type")] = U("application/http");
+	response.headers[U("Content-Transfer-Encoding")] = U("binary");
+
+	if (operation->status() == AsyncFailed)
+	{
+		auto error = std::make_shared<odata_error>(U("InternalServerError"), operation->error_message(), U(""));
+		response.body = writer.write_asynchronous_odata_error(error, StatusInternalServerError, U("Internal Server Error"), embedded_headers());
+	}
+	else if (auto result = operation->result())
+	{
+		response.body = writer.write_asynchronous_odata_value(result, StatusOK, U("OK"), embedded_headers());
+	}
+	else
+	{
+		std::unordered_map<string_t, string_t> headers;
+		headers[U("OData-Version")] = U("4.0");
+		response.body = writer.write_asynchronous_odata_value(nullptr, StatusNoContent, U("No Content"), headers);
+	}
+	return response;
+}
+
+}}
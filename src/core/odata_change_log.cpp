@@ -0,0 +1,173 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_change_log.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_change_log.h"
+#include <algorithm>
+
+using namespace ::odata::edm;
+using namespace ::odata::utility;
+
+namespace odata { namespace core
+{
+
+static string_t link_key(const uri& source, const string_t& relationship, const uri& target)
+{
+	return U("link\n") + source.to_string() + U("\n") + relationship + U("\n") + target.to_string();
+}
+
+static string_t entity_key(const uri& id)
+{
+	return U("entity\n") + id.to_string();
+}
+
+static bool parse_token(const string_t& token, uint64_t& sequence)
+{
+	if (token.empty() || token.size() > 19)
+	{
+		return false;
+	}
+
+	sequence = 0;
+	for (auto c : token)
+	{
+		if (c < U('0') || c > U('9'))
+		{
+			return false;
+		}
+		sequence = sequence * 10 + (uint64_t)(c - U('0'));
+	}
+	return true;
+}
+
+uri odata_change_log::delta_link(const uri& service_root, const string_t& entity_set_name, const string_t& token)
+{
+	uri_builder builder(service_root);
+	builder.append_path(entity_set_name);
+	builder.append_query(U("$deltatoken"), token);
+	return builder.to_uri();
+}
+
+void odata_in_memory_change_log::record(const std::shared_ptr<edm_entity_set>& entity_set, string_t key, std::shared_ptr<odata_delta_entry> entry)
+{
+	if (!entity_set)
+	{
+		throw std::invalid_argument("entity set must not be null");
+	}
+
+	change item;
+	item.entity_set = entity_set->get_name();
+	item.key = std::move(key);
+	item.entry = std::move(entry);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	item.sequence = ++m_sequence;
+	m_changes.push_back(std::move(item));
+
+	while (m_capacity && m_changes.size() > m_capacity)
+	{
+		m_expired_through = m_changes.front().sequence;
+		m_changes.pop_front();
+	}
+}
+
+void odata_in_memory_change_log::record_changed(const std::shared_ptr<edm_entity_set>& entity_set, const std::shared_ptr<odata_entity_value>& entity)
+{
+	if (!entity || !entity_set)
+	{
+		throw std::invalid_argument("entity set and entity must not be null");
+	}
+
+	record(entity_set, entity_key(entity_set->get_name() + entity->get_entity_key_string()), odata_delta_entry::changed_entity(entity));
+}
+
+void odata_in_memory_change_log::record_deleted(const std::shared_ptr<edm_entity_set>& entity_set, const std::shared_ptr<odata_entity_value>& entity, odata_deleted_reason_t reason)
+{
+	if (!entity || !entity_set)
+	{
+		throw std::invalid_argument("entity set and entity must not be null");
+	}
+
+	record_deleted(entity_set, uri(entity_set->get_name() + entity->get_entity_key_string()), reason);
+}
+
+void odata_in_memory_change_log::record_deleted(const std::shared_ptr<edm_entity_set>& entity_set, const uri& id, odata_deleted_reason_t reason)
+{
+	record(entity_set, entity_key(id), odata_delta_entry::deleted_entity(id, reason));
+}
+
+void odata_in_memory_change_log::record_link(const std::shared_ptr<edm_entity_set>& entity_set, const uri& source, const string_t& relationship, const uri& target)
+{
+	record(entity_set, link_key(source, relationship, target), odata_delta_entry::link(DeltaAddedLink, source, relationship, target));
+}
+
+void odata_in_memory_change_log::record_deleted_link(const std::shared_ptr<edm_entity_set>& entity_set, const uri& source, const string_t& relationship, const uri& target)
+{
+	record(entity_set, link_key(source, relationship, target), odata_delta_entry::link(DeltaDeletedLink, source, relationship, target));
+}
+
+string_t odata_in_memory_change_log::issue_token(const std::shared_ptr<edm_entity_set>&)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return conversions::print_string(m_sequence);
+}
+
+std::shared_ptr<odata_delta_value> odata_in_memory_change_log::read_changes(const std::shared_ptr<edm_entity_set>& entity_set, const string_t& token, string_t& next_token)
+{
+	uint64_t since;
+	if (!entity_set || !parse_token(token, since))
+	{
+		return nullptr;
+	}
+
+	const auto& name = entity_set->get_name();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (since > m_sequence || since < m_expired_through)
+	{
+		return nullptr;
+	}
+
+	// Sequences grow along the deque, so the changes after the token are found without walking the older ones.
+	auto first = std::upper_bound(m_changes.cbegin(), m_changes.cend(), since, [](uint64_t sequence, const change& item)
+	{
+		return sequence < item.sequence;
+	});
+
+	std::vector<const change*> changes;
+	std::unordered_map<string_t, size_t> last;
+	for (auto iter = first; iter != m_changes.cend(); ++iter)
+	{
+		if (iter->entity_set != name)
+		{
+			continue;
+		}
+
+		auto found = last.find(iter->key);
+		if (found != last.end())
+		{
+			changes[found->second] = nullptr;
+			found->second = changes.size();
+		}
+		else
+		{
+			last.emplace(iter->key, changes.size());
+		}
+		changes.push_back(&*iter);
+	}
+
+	auto delta = std::make_shared<odata_delta_value>(entity_set);
+	for (auto item : changes)
+	{
+		if (item)
+		{
+			delta->add_entry(item->entry);
+		}
+	}
+
+	next_token = conversions::print_string(m_sequence);
+	return delta;
+}
+
+}}
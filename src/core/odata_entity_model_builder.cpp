@@ -57,22 +57,20 @@ namespace odata { namespace core
 		return key_string;
 	}
 
-	std::vector<::odata::utility::string_t> keys;
-
-	auto parent_type = std::dynamic_pointer_cast<edm_entity_type>(entity_value->get_value_type());
-	while (parent_type)
+	auto entity_type = dynamic_cast<const edm_entity_type*>(entity_value->get_value_type_pointer());
+	if (!entity_type)
 	{
-		keys.insert(keys.end(), parent_type->key().cbegin(), parent_type->key().cend());
-		parent_type = std::dynamic_pointer_cast<edm_entity_type>(parent_type->get_base_type());
+		return key_string;
 	}
 
+	const auto &keys = entity_type->get_key_with_parents();
 	for (size_t i = 0; i < keys.size(); i++)
 	{
 		std::shared_ptr<odata_value> property_value;
 		entity_value->get_property_value(keys[i], property_value);
 		if (property_value)
 		{
-			std::shared_ptr<edm_named_type> property_type = property_value->get_value_type();
+			auto property_type = property_value->get_value_type_pointer();
 			if (property_type && property_type->get_type_kind() == edm_type_kind_t::Primitive)
 			{
 				auto primitive_property_value = std::dynamic_pointer_cast<odata_primitive_value>(property_value);
@@ -0,0 +1,581 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_entity_set_index.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_entity_set_index.h"
+#include "odata/core/odata_enum_value.h"
+#include "odata/core/odata_exception.h"
+#include <cmath>
+
+using namespace ::odata::edm;
+using namespace ::odata::utility;
+
+namespace odata { namespace core
+{
+
+namespace
+{
+
+std::shared_ptr<odata_primitive_value> get_index_key(std::shared_ptr<odata_entity_value> entity, const string_t& property_name)
+{
+	std::shared_ptr<odata_value> value;
+	if (!entity || !entity->get_property_value(property_name, value) || !value)
+	{
+		return nullptr;
+	}
+
+	auto primitive = std::dynamic_pointer_cast<odata_primitive_value>(value);
+	if (primitive)
+	{
+		return primitive;
+	}
+
+	auto enum_value = std::dynamic_pointer_cast<odata_enum_value>(value);
+	if (enum_value)
+	{
+		return std::make_shared<odata_primitive_value>(enum_value->get_value_type(), enum_value->to_string());
+	}
+
+	return nullptr;
+}
+
+edm_primitive_type_kind_t primitive_kind_of(const std::shared_ptr<odata_primitive_value>& value)
+{
+	auto type = value->get_value_type_pointer();
+	if (type && type->get_type_kind() == edm_type_kind_t::Primitive)
+	{
+		return static_cast<const edm_primitive_type*>(type)->get_primitive_kind();
+	}
+
+	return edm_primitive_type_kind_t::NoneVal;
+}
+
+bool is_integral_kind(edm_primitive_type_kind_t kind)
+{
+	switch (kind)
+	{
+	case edm_primitive_type_kind_t::Byte:
+	case edm_primitive_type_kind_t::SByte:
+	case edm_primitive_type_kind_t::Int16:
+	case edm_primitive_type_kind_t::Int32:
+	case edm_primitive_type_kind_t::Int64:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool is_top_level_property(std::shared_ptr<odata_query_node> node)
+{
+	return node && node->node_kind() == odata_query_node_kind::PropertyAccess && !node->as<odata_property_access_node>()->parent();
+}
+
+bool is_non_null_constant(std::shared_ptr<odata_query_node> node)
+{
+	return node && node->node_kind() == odata_query_node_kind::Constant && node->as<odata_constant_node>()->value();
+}
+
+// Matches "property op constant" or "constant op property", normalizing the operator so the property is on the left.
+bool match_comparison(
+	std::shared_ptr<odata_query_node> node,
+	string_t& property_name,
+	int& operator_kind,
+	std::shared_ptr<odata_primitive_value>& value)
+{
+	if (!node || node->node_kind() != odata_query_node_kind::BinaryOperator)
+	{
+		return false;
+	}
+
+	auto binary = node->as<odata_binary_operator_node>();
+	operator_kind = binary->operator_kind();
+	switch (operator_kind)
+	{
+	case binary_operator_kind::Equal:
+	case binary_operator_kind::GreaterThan:
+	case binary_operator_kind::GreaterThanOrEqual:
+	case binary_operator_kind::LessThan:
+	case binary_operator_kind::LessThanOrEqual:
+		break;
+	default:
+		return false;
+	}
+
+	if (is_top_level_property(binary->left()) && is_non_null_constant(binary->right()))
+	{
+		property_name = binary->left()->as<odata_property_access_node>()->property_name();
+		value = binary->right()->as<odata_constant_node>()->value();
+		return true;
+	}
+
+	if (is_non_null_constant(binary->left()) && is_top_level_property(binary->right()))
+	{
+		property_name = binary->right()->as<odata_property_access_node>()->property_name();
+		value = binary->left()->as<odata_constant_node>()->value();
+		switch (operator_kind)
+		{
+		case binary_operator_kind::GreaterThan: operator_kind = binary_operator_kind::LessThan; break;
+		case binary_operator_kind::GreaterThanOrEqual: operator_kind = binary_operator_kind::LessThanOrEqual; break;
+		case binary_operator_kind::LessThan: operator_kind = binary_operator_kind::GreaterThan; break;
+		case binary_operator_kind::LessThanOrEqual: operator_kind = binary_operator_kind::GreaterThanOrEqual; break;
+		default: break;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+// Matches an or-chain of equality comparisons on one property, i.e. the expansion of an "in" list.
+bool match_in_list(
+	std::shared_ptr<odata_query_node> node,
+	string_t& property_name,
+	std::vector<std::shared_ptr<odata_primitive_value>>& values)
+{
+	if (node && node->node_kind() == odata_query_node_kind::BinaryOperator
+		&& node->as<odata_binary_operator_node>()->operator_kind() == binary_operator_kind::Or)
+	{
+		auto binary = node->as<odata_binary_operator_node>();
+		return match_in_list(binary->left(), property_name, values) && match_in_list(binary->right(), property_name, values);
+	}
+
+	string_t name;
+	int operator_kind;
+	std::shared_ptr<odata_primitive_value> value;
+	if (!match_comparison(node, name, operator_kind, value) || operator_kind != binary_operator_kind::Equal)
+	{
+		return false;
+	}
+
+	if (property_name.empty())
+	{
+		property_name = name;
+	}
+	else if (property_name != name)
+	{
+		return false;
+	}
+
+	values.push_back(value);
+	return true;
+}
+
+void flatten_conjuncts(std::shared_ptr<odata_query_node> node, std::vector<std::shared_ptr<odata_query_node>>& conjuncts)
+{
+	if (node && node->node_kind() == odata_query_node_kind::BinaryOperator
+		&& node->as<odata_binary_operator_node>()->operator_kind() == binary_operator_kind::And)
+	{
+		auto binary = node->as<odata_binary_operator_node>();
+		flatten_conjuncts(binary->left(), conjuncts);
+		flatten_conjuncts(binary->right(), conjuncts);
+	}
+	else if (node)
+	{
+		conjuncts.push_back(node);
+	}
+}
+
+}
+
+// --BEGIN-- odata_entity_set_index
+
+::odata::utility::string_t odata_entity_set_index::hash_key(const std::shared_ptr<::odata::core::odata_primitive_value>& key)
+{
+	auto kind = primitive_kind_of(key);
+	if (is_integral_kind(kind))
+	{
+		// Integral keys hash exactly, a round trip through double would merge neighbours above 2^53.
+		return ::odata::utility::conversions::print_string(key->as<int64_t>());
+	}
+
+	if (odata_filter_evaluator::is_numeric(key))
+	{
+		// Normalize floating keys with an integral value so that 1, 1.0 and 1L hash alike, as they compare equal.
+		// Only values inside the int64 range are converted, the cast is undefined for NaN and beyond it.
+		// NaN and the infinities do not parse back, they keep their text so they never share a bucket with 0.
+		double number = 0;
+		if (!::odata::utility::bind(key->to_string(), number) || std::isnan(number))
+		{
+			return key->to_string();
+		}
+
+		if (number >= -9223372036854775808.0 && number < 9223372036854775808.0 && number == std::floor(number))
+		{
+			return ::odata::utility::conversions::print_string((int64_t)number);
+		}
+
+		return ::odata::utility::print_double(number);
+	}
+
+	if (kind == edm_primitive_type_kind_t::Boolean)
+	{
+		return odata_filter_evaluator::is_true(key) ? U("true") : U("false");
+	}
+
+	// Instants, time spans and Guids have several spellings that compare equal.
+	return odata_filter_evaluator::canonical_text(key);
+}
+
+void odata_entity_set_index::insert(size_t row, std::shared_ptr<::odata::core::odata_entity_value> entity)
+{
+	auto key = get_index_key(entity, m_property_name);
+	if (!key)
+	{
+		return;
+	}
+
+	m_row_keys[row] = key;
+	if (m_index_kind == odata_index_kind::Hash)
+	{
+		m_hash[hash_key(key)].push_back(row);
+	}
+	else
+	{
+		m_ordered.insert(std::make_pair(key, row));
+	}
+}
+
+void odata_entity_set_index::remove(size_t row)
+{
+	auto found = m_row_keys.find(row);
+	if (found == m_row_keys.end())
+	{
+		return;
+	}
+
+	if (m_index_kind == odata_index_kind::Hash)
+	{
+		auto bucket = m_hash.find(hash_key(found->second));
+		if (bucket != m_hash.end())
+		{
+			auto &rows = bucket->second;
+			rows.erase(std::remove(rows.begin(), rows.end(), row), rows.end());
+			if (rows.empty())
+			{
+				m_hash.erase(bucket);
+			}
+		}
+	}
+	else
+	{
+		auto range = m_ordered.equal_range(found->second);
+		for (auto iter = range.first; iter != range.second; ++iter)
+		{
+			if (iter->second == row)
+			{
+				m_ordered.erase(iter);
+				break;
+			}
+		}
+	}
+
+	m_row_keys.erase(found);
+}
+
+void odata_entity_set_index::find_equal(
+	const std::shared_ptr<::odata::core::odata_primitive_value>& key,
+	std::vector<size_t>& rows) const
+{
+	if (m_index_kind == odata_index_kind::Hash)
+	{
+		auto bucket = m_hash.find(hash_key(key));
+		if (bucket != m_hash.end())
+		{
+			rows.insert(rows.end(), bucket->second.begin(), bucket->second.end());
+		}
+	}
+	else
+	{
+		auto range = m_ordered.equal_range(key);
+		for (auto iter = range.first; iter != range.second; ++iter)
+		{
+			rows.push_back(iter->second);
+		}
+	}
+}
+
+void odata_entity_set_index::find_range(
+	const std::shared_ptr<::odata::core::odata_primitive_value>& lower, bool lower_inclusive,
+	const std::shared_ptr<::odata::core::odata_primitive_value>& upper, bool upper_inclusive,
+	std::vector<size_t>& rows) const
+{
+	if (m_index_kind != odata_index_kind::Ordered)
+	{
+		throw odata_exception(U("Range lookups require an ordered index on ") + m_property_name + U("."));
+	}
+
+	auto begin = m_ordered.begin();
+	if (lower)
+	{
+		begin = lower_inclusive ? m_ordered.lower_bound(lower) : m_ordered.upper_bound(lower);
+	}
+
+	auto end = m_ordered.end();
+	if (upper)
+	{
+		end = upper_inclusive ? m_ordered.upper_bound(upper) : m_ordered.lower_bound(upper);
+	}
+
+	for (auto iter = begin; iter != end && iter != m_ordered.end(); ++iter)
+	{
+		if (upper && odata_filter_evaluator::compare(iter->first, upper) > 0)
+		{
+			break;
+		}
+
+		rows.push_back(iter->second);
+	}
+}
+
+// --END-- odata_entity_set_index
+
+// --BEGIN-- odata_indexed_entity_set
+
+std::shared_ptr<odata_entity_set_index> odata_indexed_entity_set::create_index(const ::odata::utility::string_t& property_name, int index_kind)
+{
+	auto index = std::make_shared<odata_entity_set_index>(property_name, index_kind);
+	for (size_t row = 0; row < m_rows.size(); row++)
+	{
+		if (m_rows[row])
+		{
+			index->insert(row, m_rows[row]);
+		}
+	}
+
+	m_indexes[property_name] = index;
+	return index;
+}
+
+bool odata_indexed_entity_set::drop_index(const ::odata::utility::string_t& property_name)
+{
+	return m_indexes.erase(property_name) > 0;
+}
+
+std::shared_ptr<odata_entity_set_index> odata_indexed_entity_set::find_index(const ::odata::utility::string_t& property_name) const
+{
+	auto found = m_indexes.find(property_name);
+	return found != m_indexes.end() ? found->second : nullptr;
+}
+
+size_t odata_indexed_entity_set::insert(std::shared_ptr<::odata::core::odata_entity_value> entity)
+{
+	if (!entity)
+	{
+		throw std::invalid_argument("entity");
+	}
+
+	size_t row = m_rows.size();
+	m_rows.push_back(entity);
+	m_count++;
+
+	for (auto iter = m_indexes.begin(); iter != m_indexes.end(); ++iter)
+	{
+		iter->second->insert(row, entity);
+	}
+
+	return row;
+}
+
+void odata_indexed_entity_set::update(size_t row, std::shared_ptr<::odata::core::odata_entity_value> entity)
+{
+	if (!entity || row >= m_rows.size() || !m_rows[row])
+	{
+		throw odata_exception(U("Cannot update a row that does not exist."));
+	}
+
+	m_rows[row] = entity;
+	for (auto iter = m_indexes.begin(); iter != m_indexes.end(); ++iter)
+	{
+		iter->second->remove(row);
+		iter->second->insert(row, entity);
+	}
+}
+
+bool odata_indexed_entity_set::remove(size_t row)
+{
+	if (row >= m_rows.size() || !m_rows[row])
+	{
+		return false;
+	}
+
+	for (auto iter = m_indexes.begin(); iter != m_indexes.end(); ++iter)
+	{
+		iter->second->remove(row);
+	}
+
+	m_rows[row] = nullptr;
+	m_count--;
+	return true;
+}
+
+std::shared_ptr<odata_index_plan> odata_indexed_entity_set::plan(std::shared_ptr<::odata::core::odata_query_node> expression) const
+{
+	auto result = std::make_shared<odata_index_plan>();
+
+	std::vector<std::shared_ptr<odata_query_node>> conjuncts;
+	flatten_conjuncts(expression, conjuncts);
+
+	std::vector<bool> consumed(conjuncts.size(), false);
+	int best_score = 0;
+
+	// Score: equality probe (3) beats in-list probe (2) beats range scan (1) beats full scan (0).
+	for (size_t i = 0; i < conjuncts.size() && best_score < 3; i++)
+	{
+		string_t property_name;
+		int operator_kind;
+		std::shared_ptr<odata_primitive_value> value;
+		std::vector<std::shared_ptr<odata_primitive_value>> values;
+
+		if (match_comparison(conjuncts[i], property_name, operator_kind, value) && operator_kind == binary_operator_kind::Equal)
+		{
+			auto index = find_index(property_name);
+			if (index)
+			{
+				best_score = 3;
+				result->m_plan_kind = odata_index_plan_kind::Equal;
+				result->m_index = index;
+				result->m_values.assign(1, value);
+				consumed.assign(conjuncts.size(), false);
+				consumed[i] = true;
+			}
+		}
+		else if (best_score < 2 && match_in_list(conjuncts[i], property_name, values))
+		{
+			auto index = find_index(property_name);
+			if (index)
+			{
+				best_score = 2;
+				result->m_plan_kind = odata_index_plan_kind::In;
+				result->m_index = index;
+				result->m_values = values;
+				consumed.assign(conjuncts.size(), false);
+				consumed[i] = true;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < conjuncts.size() && best_score < 1; i++)
+	{
+		string_t property_name;
+		int operator_kind;
+		std::shared_ptr<odata_primitive_value> value;
+		if (!match_comparison(conjuncts[i], property_name, operator_kind, value) || operator_kind == binary_operator_kind::Equal)
+		{
+			continue;
+		}
+
+		auto index = find_index(property_name);
+		if (!index || index->index_kind() != odata_index_kind::Ordered)
+		{
+			continue;
+		}
+
+		// Merge every bound on this property into a single range.
+		best_score = 1;
+		result->m_plan_kind = odata_index_plan_kind::Range;
+		result->m_index = index;
+		for (size_t j = i; j < conjuncts.size(); j++)
+		{
+			string_t name;
+			if (!match_comparison(conjuncts[j], name, operator_kind, value) || name != property_name || operator_kind == binary_operator_kind::Equal)
+			{
+				continue;
+			}
+
+			bool inclusive = operator_kind == binary_operator_kind::GreaterThanOrEqual || operator_kind == binary_operator_kind::LessThanOrEqual;
+			if (operator_kind == binary_operator_kind::GreaterThan || operator_kind == binary_operator_kind::GreaterThanOrEqual)
+			{
+				int order = result->m_lower ? odata_filter_evaluator::compare(value, result->m_lower) : 1;
+				if (order > 0 || (order == 0 && !inclusive))
+				{
+					result->m_lower = value;
+					result->m_lower_inclusive = inclusive;
+				}
+			}
+			else
+			{
+				int order = result->m_upper ? odata_filter_evaluator::compare(value, result->m_upper) : -1;
+				if (order < 0 || (order == 0 && !inclusive))
+				{
+					result->m_upper = value;
+					result->m_upper_inclusive = inclusive;
+				}
+			}
+
+			consumed[j] = true;
+		}
+	}
+
+	if (std::find(consumed.begin(), consumed.end(), true) == consumed.end())
+	{
+		result->m_residual = expression;
+		return result;
+	}
+
+	for (size_t i = 0; i < conjuncts.size(); i++)
+	{
+		if (!consumed[i])
+		{
+			result->m_residual = result->m_residual ? odata_query_node::create_operator_and_node(result->m_residual, conjuncts[i]) : conjuncts[i];
+		}
+	}
+
+	return result;
+}
+
+std::vector<std::shared_ptr<::odata::core::odata_entity_value>> odata_indexed_entity_set::filter(std::shared_ptr<::odata::core::odata_query_node> expression) const
+{
+	std::vector<std::shared_ptr<odata_entity_value>> result;
+	auto access_plan = plan(expression);
+	auto residual = access_plan->residual();
+	auto evaluator = std::make_shared<odata_filter_evaluator>();
+
+	std::vector<size_t> rows;
+	switch (access_plan->plan_kind())
+	{
+	case odata_index_plan_kind::Equal:
+	case odata_index_plan_kind::In:
+		for (auto iter = access_plan->values().cbegin(); iter != access_plan->values().cend(); ++iter)
+		{
+			access_plan->index()->find_equal(*iter, rows);
+		}
+		break;
+
+	case odata_index_plan_kind::Range:
+		access_plan->index()->find_range(access_plan->lower(), access_plan->lower_inclusive(), access_plan->upper(), access_plan->upper_inclusive(), rows);
+		break;
+
+	default:
+		for (size_t row = 0; row < m_rows.size(); row++)
+		{
+			rows.push_back(row);
+		}
+		break;
+	}
+
+	// Keep results in insertion order regardless of the access path.
+	std::sort(rows.begin(), rows.end());
+	rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+	for (auto iter = rows.cbegin(); iter != rows.cend(); ++iter)
+	{
+		auto entity = m_rows[*iter];
+		if (entity && (!residual || evaluator->evaluate(residual, entity)))
+		{
+			result.push_back(entity);
+		}
+	}
+
+	return result;
+}
+
+std::vector<std::shared_ptr<::odata::core::odata_entity_value>> odata_indexed_entity_set::filter(std::shared_ptr<::odata::core::odata_filter_clause> filter_clause) const
+{
+	return filter(filter_clause ? filter_clause->expression() : nullptr);
+}
+
+// --END-- odata_indexed_entity_set
+
+}}
@@ -17,20 +17,20 @@ namespace odata { namespace core
 {
 	::odata::utility::string_t key;
 
-	auto entitytype = std::dynamic_pointer_cast<edm_entity_type>(get_value_type());
+	auto entitytype = dynamic_cast<const edm_entity_type*>(get_value_type_pointer());
 
 	if (entitytype)
 	{
 		key += U("(");
 
-		std::vector<::odata::utility::string_t> key_property_names = entitytype->get_key_with_parents();
+		const auto &key_property_names = entitytype->get_key_with_parents();
 		for (size_t i = 0; i < key_property_names.size(); i++)
 		{
 			std::shared_ptr<odata_value> property_value;
 			get_property_value(key_property_names[i], property_value);
 			if (property_value)
 			{
-				auto property_type = property_value->get_value_type();
+				auto property_type = property_value->get_value_type_pointer();
 				if (property_type && property_type->get_type_kind() == edm_type_kind_t::Primitive)
 				{
 					if (i != 0)
@@ -0,0 +1,478 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_etag.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_etag.h"
+#include "odata/core/odata_primitive_value.h"
+#include "odata/core/odata_enum_value.h"
+#include <algorithm>
+
+using namespace ::odata::edm;
+using namespace ::odata::utility;
+
+namespace odata { namespace core
+{
+
+namespace
+{
+
+struct entity_tag
+{
+	bool is_weak;
+	string_t opaque;
+};
+
+bool is_list_space(char_t c)
+{
+	return c == U(' ') || c == U('\t');
+}
+
+// Splits an If-Match or If-None-Match value into its tags. Returns true when the list is "*".
+// Malformed members are skipped up to the next comma so they simply never match.
+bool parse_entity_tags(const string_t& header, std::vector<entity_tag>& tags)
+{
+	size_t i = 0, n = header.size();
+	while (i < n)
+	{
+		while (i < n && (is_list_space(header[i]) || header[i] == U(',')))
+		{
+			i++;
+		}
+		if (i == n)
+		{
+			break;
+		}
+
+		if (header[i] == U('*'))
+		{
+			return true;
+		}
+
+		entity_tag tag;
+		tag.is_weak = false;
+		if (header[i] == U('W') && i + 1 < n && header[i + 1] == U('/'))
+		{
+			tag.is_weak = true;
+			i += 2;
+		}
+
+		size_t close = string_t::npos;
+		if (i < n && header[i] == U('"'))
+		{
+			close = header.find(U('"'), i + 1);
+		}
+
+		if (close == string_t::npos)
+		{
+			i = header.find(U(','), i);
+			if (i == string_t::npos)
+			{
+				break;
+			}
+			continue;
+		}
+
+		tag.opaque = header.substr(i + 1, close - i - 1);
+		tags.push_back(std::move(tag));
+		i = close + 1;
+	}
+
+	return false;
+}
+
+bool parse_etag(const string_t& etag, entity_tag& tag)
+{
+	std::vector<entity_tag> tags;
+	if (parse_entity_tags(etag, tags) || tags.size() != 1)
+	{
+		return false;
+	}
+	tag = std::move(tags[0]);
+	return true;
+}
+
+bool list_matches(const string_t& header, const string_t& etag, bool exists, bool weak_comparison)
+{
+	std::vector<entity_tag> tags;
+	if (parse_entity_tags(header, tags))
+	{
+		return exists;
+	}
+
+	entity_tag current;
+	if (!exists || !parse_etag(etag, current))
+	{
+		return false;
+	}
+
+	for (auto& tag : tags)
+	{
+		if (tag.opaque == current.opaque && (weak_comparison || tag.is_weak == current.is_weak))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Characters outside etagc (RFC 7232) and '%' itself are written as %XX of their UTF-8 bytes.
+void append_etag_chars(const string_t& text, string_t& out)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	std::string utf8 = conversions::to_utf8string(text);
+	for (unsigned char c : utf8)
+	{
+		if (c <= 0x20 || c >= 0x7F || c == '"' || c == '%')
+		{
+			out.push_back(U('%'));
+			out.push_back((char_t)hex[c >> 4]);
+			out.push_back((char_t)hex[c & 0xF]);
+		}
+		else
+		{
+			out.push_back((char_t)c);
+		}
+	}
+}
+
+void append_literal(const std::shared_ptr<odata_value>& value, string_t& out)
+{
+	if (!value)
+	{
+		out.append(U("null"));
+		return;
+	}
+
+	auto type = value->get_value_type_pointer();
+	string_t text;
+	bool quoted = false;
+	if (type && type->get_type_kind() == edm_type_kind_t::Primitive)
+	{
+		auto primitive = std::static_pointer_cast<odata_primitive_value>(value);
+		auto primitive_type = dynamic_cast<const edm_primitive_type*>(type);
+		text = primitive->to_string();
+		quoted = primitive_type && primitive_type->get_primitive_kind() == edm_primitive_type_kind_t::String;
+	}
+	else if (type && type->get_type_kind() == edm_type_kind_t::Enum)
+	{
+		text = std::static_pointer_cast<odata_enum_value>(value)->to_string();
+		quoted = true;
+	}
+	else
+	{
+		out.append(U("null"));
+		return;
+	}
+
+	if (quoted)
+	{
+		string_t escaped;
+		escaped.reserve(text.size() + 2);
+		escaped.push_back(U('\''));
+		for (auto c : text)
+		{
+			if (c == U('\''))
+			{
+				escaped.push_back(U('\''));
+			}
+			escaped.push_back(c);
+		}
+		escaped.push_back(U('\''));
+		append_etag_chars(escaped, out);
+	}
+	else
+	{
+		append_etag_chars(text, out);
+	}
+}
+
+std::shared_ptr<odata_value> find_property_path(const std::shared_ptr<odata_structured_value>& value, const string_t& path)
+{
+	std::shared_ptr<odata_structured_value> current = value;
+	size_t start = 0;
+	while (current)
+	{
+		size_t slash = path.find(U('/'), start);
+		std::shared_ptr<odata_value> property;
+		if (!current->properties().try_get(slash == string_t::npos ? path.substr(start) : path.substr(start, slash - start), property))
+		{
+			return nullptr;
+		}
+		if (slash == string_t::npos)
+		{
+			return property;
+		}
+		current = std::dynamic_pointer_cast<odata_structured_value>(property);
+		start = slash + 1;
+	}
+	return nullptr;
+}
+
+// FNV-1a over the UTF-8 bytes, with a final avalanche so that short inputs spread over all 64 bits.
+class content_hasher
+{
+public:
+	content_hasher() : m_hash(14695981039346656037ULL) {}
+
+	void add_byte(unsigned char b)
+	{
+		m_hash = (m_hash ^ b) * 1099511628211ULL;
+	}
+
+	void add_text(const string_t& text)
+	{
+		for (auto c : text)
+		{
+			uint32_t unit = (uint32_t)c;
+			do
+			{
+				add_byte((unsigned char)unit);
+				unit >>= 8;
+			} while (unit);
+		}
+		// Terminate each string so that adjacent values cannot run into each other.
+		add_byte(0);
+	}
+
+	void add_value(const std::shared_ptr<odata_value>& value)
+	{
+		if (!value)
+		{
+			add_byte('n');
+			return;
+		}
+
+		auto type = value->get_value_type_pointer();
+		switch (type ? type->get_type_kind() : edm_type_kind_t::None)
+		{
+		case edm_type_kind_t::Primitive:
+			add_byte('p');
+			add_text(type->get_name());
+			add_text(std::static_pointer_cast<odata_primitive_value>(value)->to_string());
+			break;
+		case edm_type_kind_t::Enum:
+			add_byte('e');
+			add_text(std::static_pointer_cast<odata_enum_value>(value)->to_string());
+			break;
+		case edm_type_kind_t::Complex:
+			add_byte('c');
+			add_structured(std::static_pointer_cast<odata_structured_value>(value));
+			break;
+		case edm_type_kind_t::Collection:
+		{
+			add_byte('[');
+			for (auto& element : std::static_pointer_cast<odata_collection_value>(value)->get_collection_values())
+			{
+				add_value(element);
+			}
+			add_byte(']');
+			break;
+		}
+		default:
+			// Entities and navigation targets carry their own ETags.
+			add_byte('x');
+			break;
+		}
+	}
+
+	void add_structured(const std::shared_ptr<odata_structured_value>& value)
+	{
+		const auto& properties = value->properties();
+		std::vector<std::pair<const string_t*, const std::shared_ptr<odata_value>*>> sorted;
+		sorted.reserve(properties.size());
+		for (auto it = properties.cbegin(); it != properties.cend(); ++it)
+		{
+			auto kind = it->second ? it->second->get_value_type_pointer()->get_type_kind() : edm_type_kind_t::Primitive;
+			if (kind == edm_type_kind_t::Entity || kind == edm_type_kind_t::Navigation)
+			{
+				continue;
+			}
+			sorted.push_back(std::make_pair(&it->first, &it->second));
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const std::pair<const string_t*, const std::shared_ptr<odata_value>*>& left, const std::pair<const string_t*, const std::shared_ptr<odata_value>*>& right)
+		{
+			return *left.first < *right.first;
+		});
+
+		add_byte('{');
+		for (auto& property : sorted)
+		{
+			add_text(*property.first);
+			add_value(*property.second);
+		}
+		add_byte('}');
+	}
+
+	uint64_t finish() const
+	{
+		uint64_t h = m_hash;
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+private:
+	uint64_t m_hash;
+};
+
+string_t hash_etag(uint64_t hash)
+{
+	static const char hex[] = "0123456789abcdef";
+	string_t etag(U("W/\""));
+	for (int shift = 60; shift >= 0; shift -= 4)
+	{
+		etag.push_back((char_t)hex[(hash >> shift) & 0xF]);
+	}
+	etag.push_back(U('"'));
+	return etag;
+}
+
+}
+
+bool odata_preconditions::if_match(const string_t& header, const string_t& etag, bool exists)
+{
+	return header.empty() || list_matches(header, etag, exists, false);
+}
+
+bool odata_preconditions::if_none_match(const string_t& header, const string_t& etag, bool exists)
+{
+	return header.empty() || !list_matches(header, etag, exists, true);
+}
+
+odata_precondition_result_t odata_preconditions::evaluate(
+	const string_t& if_match_header,
+	const string_t& if_none_match_header,
+	const string_t& etag,
+	bool is_read,
+	bool exists)
+{
+	if (!if_match(if_match_header, etag, exists))
+	{
+		return PreconditionFailed;
+	}
+
+	if (!if_none_match(if_none_match_header, etag, exists))
+	{
+		return is_read ? PreconditionNotModified : PreconditionFailed;
+	}
+
+	return PreconditionProceed;
+}
+
+string_t odata_etag_generator::concurrency_etag(const std::shared_ptr<odata_structured_value>& value, const std::vector<string_t>& property_paths)
+{
+	string_t etag(U("W/\""));
+	for (size_t i = 0; i < property_paths.size(); i++)
+	{
+		if (i > 0)
+		{
+			etag.push_back(U(','));
+		}
+		append_literal(find_property_path(value, property_paths[i]), etag);
+	}
+	etag.push_back(U('"'));
+	return etag;
+}
+
+string_t odata_etag_generator::content_hash_etag(const std::shared_ptr<odata_structured_value>& value)
+{
+	content_hasher hasher;
+	hasher.add_structured(value);
+	return hash_etag(hasher.finish());
+}
+
+string_t odata_etag_generator::generate(const std::shared_ptr<odata_entity_value>& entity, const std::shared_ptr<edm_navigation_source>& navigation_source) const
+{
+	if (!entity)
+	{
+		return string_t();
+	}
+
+	if (m_source != EtagFromContentHash && navigation_source && !navigation_source->get_concurrency_properties().empty())
+	{
+		return concurrency_etag(entity, navigation_source->get_concurrency_properties());
+	}
+
+	if (m_source == EtagFromConcurrencyProperties)
+	{
+		return string_t();
+	}
+
+	return content_hash_etag(entity);
+}
+
+string_t odata_etag_generator::generate(const std::shared_ptr<odata_collection_value>& collection, const std::shared_ptr<edm_navigation_source>& navigation_source) const
+{
+	if (!collection)
+	{
+		return string_t();
+	}
+
+	content_hasher hasher;
+	for (auto& element : collection->get_collection_values())
+	{
+		auto entity = std::dynamic_pointer_cast<odata_entity_value>(element);
+		if (!entity)
+		{
+			return string_t();
+		}
+
+		auto etag = entity->get_etag();
+		if (etag.empty())
+		{
+			etag = generate(entity, navigation_source);
+			if (etag.empty())
+			{
+				return string_t();
+			}
+		}
+		hasher.add_text(etag);
+	}
+	return hash_etag(hasher.finish());
+}
+
+odata_precondition_result_t odata_etag_generator::evaluate(
+	const string_t& if_match_header,
+	const string_t& if_none_match_header,
+	const std::shared_ptr<odata_entity_value>& entity,
+	const std::shared_ptr<edm_navigation_source>& navigation_source,
+	bool is_read) const
+{
+	if (if_match_header.empty() && if_none_match_header.empty())
+	{
+		return PreconditionProceed;
+	}
+
+	string_t etag;
+	if (entity)
+	{
+		etag = entity->get_etag();
+		if (etag.empty())
+		{
+			etag = generate(entity, navigation_source);
+		}
+	}
+	return odata_preconditions::evaluate(if_match_header, if_none_match_header, etag, is_read, entity != nullptr);
+}
+
+odata_precondition_result_t odata_etag_generator::evaluate(
+	const string_t& if_match_header,
+	const string_t& if_none_match_header,
+	const std::shared_ptr<odata_collection_value>& collection,
+	const std::shared_ptr<edm_navigation_source>& navigation_source,
+	bool is_read) const
+{
+	if (if_match_header.empty() && if_none_match_header.empty())
+	{
+		return PreconditionProceed;
+	}
+
+	return odata_preconditions::evaluate(if_match_header, if_none_match_header, generate(collection, navigation_source), is_read, collection != nullptr);
+}
+
+}}
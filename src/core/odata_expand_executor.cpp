@@ -0,0 +1,339 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_expand_executor.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_expand_executor.h"
+#include "odata/core/odata_collection_value.h"
+#include "odata/core/odata_orderby_clause.h"
+#include "odata/core/odata_filter_clause.h"
+#include "odata/core/odata_exception.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::utility;
+
+namespace odata { namespace core
+{
+
+namespace
+{
+
+std::shared_ptr<edm_navigation_type> navigation_type_of(std::shared_ptr<edm_property_type> property)
+{
+	return property ? std::dynamic_pointer_cast<edm_navigation_type>(property->get_property_type()) : nullptr;
+}
+
+bool is_collection_navigation(std::shared_ptr<edm_navigation_type> navigation_type)
+{
+	auto target = navigation_type->get_navigation_type();
+	return target && (target->get_type_kind() == edm_type_kind_t::Collection || target->get_name().compare(0, 11, U("Collection(")) == 0);
+}
+
+// Collects the navigation path of an expand item, e.g. Parent/Friends yields [Parent, Friends]; type casts are skipped.
+void collect_path(std::shared_ptr<odata_query_node> node, std::vector<string_t>& path)
+{
+	if (!node)
+	{
+		return;
+	}
+
+	if (node->node_kind() == odata_query_node_kind::PropertyAccess)
+	{
+		auto property_access = node->as<odata_property_access_node>();
+		collect_path(property_access->parent(), path);
+		path.push_back(property_access->property_name());
+	}
+	else if (node->node_kind() == odata_query_node_kind::TypeCast)
+	{
+		collect_path(node->as<odata_type_cast_node>()->parent(), path);
+	}
+	else
+	{
+		throw odata_exception(U("Unsupported expand path."));
+	}
+}
+
+struct orderby_row
+{
+	std::vector<std::shared_ptr<odata_primitive_value>> keys;
+	std::shared_ptr<odata_entity_value> entity;
+};
+
+}
+
+void odata_expand_executor::expand(
+	std::shared_ptr<::odata::core::odata_entity_value> parent,
+	std::shared_ptr<::odata::core::odata_select_expand_clause> select_expand_clause)
+{
+	expand(std::vector<std::shared_ptr<odata_entity_value>>(1, parent), select_expand_clause);
+}
+
+void odata_expand_executor::expand(
+	const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& parents,
+	std::shared_ptr<::odata::core::odata_select_expand_clause> select_expand_clause)
+{
+	if (!select_expand_clause || parents.empty())
+	{
+		return;
+	}
+
+	if (!m_evaluator)
+	{
+		m_evaluator = std::make_shared<odata_filter_evaluator>();
+	}
+
+	const auto &items = select_expand_clause->expand_items();
+	for (auto iter = items.cbegin(); iter != items.cend(); ++iter)
+	{
+		expand_item(parents, *iter);
+	}
+}
+
+void odata_expand_executor::expand_item(
+	const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& parents,
+	std::shared_ptr<::odata::core::odata_expand_item> item)
+{
+	std::vector<string_t> path;
+	collect_path(item->end(), path);
+	if (path.empty())
+	{
+		return;
+	}
+
+	// Intermediate segments are expanded without options, the options of the item belong to the last segment.
+	auto level = parents;
+	for (size_t i = 0; i + 1 < path.size(); i++)
+	{
+		level = expand_navigation(level, path[i], nullptr);
+	}
+
+	const auto &last = path.back();
+	if (last != U("*"))
+	{
+		level = expand_navigation(level, last, item);
+		expand(level, item->select_expand_clause());
+		return;
+	}
+
+	// Expand every navigation property declared on the parents' types.
+	std::vector<string_t> names;
+	for (auto parent = level.cbegin(); parent != level.cend(); ++parent)
+	{
+		auto type = dynamic_cast<const edm_structured_type*>((*parent)->get_value_type_pointer());
+		if (!type)
+		{
+			continue;
+		}
+
+		const auto &properties = type->get_properties_with_parents();
+		for (auto property = properties.cbegin(); property != properties.cend(); ++property)
+		{
+			if (navigation_type_of(*property) && std::find(names.begin(), names.end(), (*property)->get_name()) == names.end())
+			{
+				names.push_back((*property)->get_name());
+			}
+		}
+	}
+
+	for (auto name = names.cbegin(); name != names.cend(); ++name)
+	{
+		expand_navigation(level, *name, nullptr);
+	}
+}
+
+std::vector<std::shared_ptr<::odata::core::odata_entity_value>> odata_expand_executor::expand_navigation(
+	const std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& parents,
+	const ::odata::utility::string_t& navigation_property_name,
+	std::shared_ptr<::odata::core::odata_expand_item> options)
+{
+	// Parents of different derived types may share the same (inherited) property; group by property so that
+	// each distinct navigation costs one round trip.
+	std::vector<std::pair<std::shared_ptr<edm_property_type>, std::vector<std::shared_ptr<odata_entity_value>>>> groups;
+	for (auto parent = parents.cbegin(); parent != parents.cend(); ++parent)
+	{
+		auto type = dynamic_cast<const edm_structured_type*>((*parent)->get_value_type_pointer());
+		auto property = type ? type->find_property(navigation_property_name) : nullptr;
+		if (!navigation_type_of(property))
+		{
+			continue;
+		}
+
+		auto group = groups.begin();
+		while (group != groups.end() && group->first != property)
+		{
+			++group;
+		}
+
+		if (group == groups.end())
+		{
+			groups.push_back(std::make_pair(property, std::vector<std::shared_ptr<odata_entity_value>>()));
+			group = groups.end() - 1;
+		}
+
+		group->second.push_back(*parent);
+	}
+
+	if (groups.empty() && !parents.empty())
+	{
+		throw odata_exception(U("Navigation property ") + navigation_property_name + U(" cannot be expanded."));
+	}
+
+	std::vector<std::shared_ptr<odata_entity_value>> next_level;
+	std::unordered_set<odata_entity_value*> seen;
+
+	for (auto group = groups.begin(); group != groups.end(); ++group)
+	{
+		auto navigation_type = navigation_type_of(group->first);
+		bool is_collection = is_collection_navigation(navigation_type);
+
+		std::vector<string_t> keys;
+		std::vector<std::shared_ptr<odata_entity_value>> distinct;
+		std::unordered_set<string_t> distinct_keys;
+		for (auto parent = group->second.cbegin(); parent != group->second.cend(); ++parent)
+		{
+			keys.push_back((*parent)->get_entity_key_string());
+			if (distinct_keys.insert(keys.back()).second)
+			{
+				distinct.push_back(*parent);
+			}
+		}
+
+		std::unordered_map<string_t, std::vector<std::shared_ptr<odata_entity_value>>> related;
+		m_data_source->load_related(group->first, distinct, related);
+		m_round_trips++;
+
+		for (size_t i = 0; i < group->second.size(); i++)
+		{
+			auto parent = group->second[i];
+			std::vector<std::shared_ptr<odata_entity_value>> targets;
+			auto found = related.find(keys[i]);
+			if (found != related.end())
+			{
+				targets = found->second;
+			}
+
+			if (is_collection)
+			{
+				auto collection = std::make_shared<odata_collection_value>(navigation_type->get_navigation_type());
+				apply_options(targets, options, collection);
+				for (auto target = targets.cbegin(); target != targets.cend(); ++target)
+				{
+					collection->add_collection_value(*target);
+				}
+				parent->set_value(navigation_property_name, std::static_pointer_cast<odata_value>(collection));
+			}
+			else
+			{
+				apply_options(targets, options, nullptr);
+				if (targets.empty())
+				{
+					continue;
+				}
+
+				targets.resize(1);
+				parent->set_value(navigation_property_name, std::static_pointer_cast<odata_value>(targets[0]));
+			}
+
+			for (auto target = targets.cbegin(); target != targets.cend(); ++target)
+			{
+				if (*target && seen.insert(target->get()).second)
+				{
+					next_level.push_back(*target);
+				}
+			}
+		}
+	}
+
+	return next_level;
+}
+
+void odata_expand_executor::apply_options(
+	std::vector<std::shared_ptr<::odata::core::odata_entity_value>>& targets,
+	std::shared_ptr<::odata::core::odata_expand_item> options,
+	std::shared_ptr<::odata::core::odata_collection_value> collection)
+{
+	if (!options)
+	{
+		return;
+	}
+
+	auto filter_clause = options->filter_clause();
+	if (filter_clause && filter_clause->expression())
+	{
+		auto expression = filter_clause->expression();
+		auto evaluator = m_evaluator;
+		targets.erase(std::remove_if(targets.begin(), targets.end(), [&](const std::shared_ptr<odata_entity_value>& target)
+		{
+			return !target || !evaluator->evaluate(expression, target);
+		}), targets.end());
+	}
+
+	if (collection && options->count().has_value() && options->count().value())
+	{
+		// $count reports the filtered size before paging.
+		collection->set_count((int64_t)targets.size());
+	}
+
+	auto orderby_clause = options->orderby_clause();
+	if (orderby_clause && !orderby_clause->items().empty())
+	{
+		const auto &items = orderby_clause->items();
+		std::vector<orderby_row> rows;
+		for (auto target = targets.cbegin(); target != targets.cend(); ++target)
+		{
+			orderby_row row;
+			row.entity = *target;
+			for (auto item = items.cbegin(); item != items.cend(); ++item)
+			{
+				row.keys.push_back(m_evaluator->evaluate_value(item->first, *target));
+			}
+			rows.push_back(row);
+		}
+
+		std::stable_sort(rows.begin(), rows.end(), [&](const orderby_row& left, const orderby_row& right)
+		{
+			for (size_t i = 0; i < items.size(); i++)
+			{
+				int order;
+				if (!left.keys[i] || !right.keys[i])
+				{
+					// Nulls sort first in ascending order.
+					order = (left.keys[i] ? 1 : 0) - (right.keys[i] ? 1 : 0);
+				}
+				else
+				{
+					order = odata_filter_evaluator::compare(left.keys[i], right.keys[i]);
+				}
+
+				if (order != 0)
+				{
+					return items[i].second ? order < 0 : order > 0;
+				}
+			}
+			return false;
+		});
+
+		for (size_t i = 0; i < rows.size(); i++)
+		{
+			targets[i] = rows[i].entity;
+		}
+	}
+
+	if (options->skip().has_value())
+	{
+		size_t skip = options->skip().value() > 0 ? (size_t)options->skip().value() : 0;
+		targets.erase(targets.begin(), targets.begin() + std::min(skip, targets.size()));
+	}
+
+	if (options->top().has_value())
+	{
+		size_t top = options->top().value() > 0 ? (size_t)options->top().value() : 0;
+		if (targets.size() > top)
+		{
+			targets.resize(top);
+		}
+	}
+}
+
+}}
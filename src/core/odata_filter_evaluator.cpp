@@ -0,0 +1,823 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_filter_evaluator.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_filter_evaluator.h"
+#include "odata/core/odata_collection_value.h"
+#include "odata/core/odata_enum_value.h"
+#include "odata/core/odata_exception.h"
+#include <cmath>
+
+using namespace ::odata::edm;
+using namespace ::odata::utility;
+
+namespace odata { namespace core
+{
+
+namespace
+{
+
+edm_primitive_type_kind_t primitive_kind_of(const std::shared_ptr<odata_primitive_value>& value)
+{
+	auto type = value->get_value_type_pointer();
+	if (type && type->get_type_kind() == edm_type_kind_t::Primitive)
+	{
+		return static_cast<const edm_primitive_type*>(type)->get_primitive_kind();
+	}
+
+	return edm_primitive_type_kind_t::NoneVal;
+}
+
+bool is_integral_kind(edm_primitive_type_kind_t kind)
+{
+	switch (kind)
+	{
+	case edm_primitive_type_kind_t::Byte:
+	case edm_primitive_type_kind_t::SByte:
+	case edm_primitive_type_kind_t::Int16:
+	case edm_primitive_type_kind_t::Int32:
+	case edm_primitive_type_kind_t::Int64:
+		return true;
+	default:
+		return false;
+	}
+}
+
+double to_double(const std::shared_ptr<odata_primitive_value>& value)
+{
+	double result = 0;
+	::odata::utility::bind(value->to_string(), result);
+	return result;
+}
+
+int64_t to_int64(const std::shared_ptr<odata_primitive_value>& value)
+{
+	int64_t result = 0;
+	::odata::utility::bind(value->to_string(), result);
+	return result;
+}
+
+// A point in time as seconds since 1970-01-01T00:00:00Z, or a time span as signed seconds,
+// with the sub-second part kept apart in [0, 1e9) nanoseconds so that no precision is lost.
+struct temporal_value
+{
+	int64_t seconds;
+	int64_t nanoseconds;
+
+	int compare(const temporal_value& other) const
+	{
+		if (seconds != other.seconds)
+		{
+			return seconds < other.seconds ? -1 : 1;
+		}
+
+		return nanoseconds < other.nanoseconds ? -1 : (nanoseconds > other.nanoseconds ? 1 : 0);
+	}
+};
+
+class temporal_reader
+{
+public:
+	temporal_reader(const ::odata::utility::string_t& text) : m_text(&text), m_position(0)
+	{
+	}
+
+	bool at_end() const
+	{
+		return m_position == m_text->size();
+	}
+
+	bool eat(::odata::utility::char_t c)
+	{
+		if (at_end() || (*m_text)[m_position] != c)
+		{
+			return false;
+		}
+
+		++m_position;
+		return true;
+	}
+
+	bool peek_digit() const
+	{
+		return !at_end() && (*m_text)[m_position] >= U('0') && (*m_text)[m_position] <= U('9');
+	}
+
+	// Reads between min_digits and max_digits decimal digits.
+	bool read_number(size_t min_digits, size_t max_digits, int64_t& value)
+	{
+		size_t digits = 0;
+		value = 0;
+		while (digits < max_digits && peek_digit())
+		{
+			value = value * 10 + ((*m_text)[m_position++] - U('0'));
+			++digits;
+		}
+
+		return digits >= min_digits && !peek_digit();
+	}
+
+	// Reads the digits after a decimal point as nanoseconds, digits beyond the ninth are dropped.
+	bool read_fraction(int64_t& nanoseconds)
+	{
+		if (!peek_digit())
+		{
+			return false;
+		}
+
+		nanoseconds = 0;
+		int64_t scale = 100000000;
+		while (peek_digit())
+		{
+			nanoseconds += ((*m_text)[m_position++] - U('0')) * scale;
+			scale /= 10;
+		}
+
+		return true;
+	}
+
+private:
+	const ::odata::utility::string_t* m_text;
+	size_t m_position;
+};
+
+// Days since 1970-01-01 of a date in the proleptic Gregorian calendar.
+int64_t days_from_civil(int64_t year, int64_t month, int64_t day)
+{
+	year -= month <= 2 ? 1 : 0;
+	int64_t era = (year >= 0 ? year : year - 399) / 400;
+	int64_t year_of_era = year - era * 400;
+	int64_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+	return era * 146097 + day_of_era - 719468;
+}
+
+// Parses [-]yyyy-mm-ddThh:mm[:ss[.fffffffff]](Z|(+|-)hh:mm) into an instant in UTC.
+bool parse_date_time_offset(const ::odata::utility::string_t& text, temporal_value& result)
+{
+	temporal_reader reader(text);
+	bool negative_year = reader.eat(U('-'));
+	int64_t year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0, nanoseconds = 0;
+	if (!reader.read_number(4, 12, year) || !reader.eat(U('-'))
+		|| !reader.read_number(2, 2, month) || !reader.eat(U('-'))
+		|| !reader.read_number(2, 2, day) || !reader.eat(U('T'))
+		|| !reader.read_number(2, 2, hour) || !reader.eat(U(':'))
+		|| !reader.read_number(2, 2, minute))
+	{
+		return false;
+	}
+
+	if (reader.eat(U(':')))
+	{
+		if (!reader.read_number(2, 2, second) || (reader.eat(U('.')) && !reader.read_fraction(nanoseconds)))
+		{
+			return false;
+		}
+	}
+
+	int64_t offset = 0;
+	if (!reader.eat(U('Z')))
+	{
+		bool negative_offset = reader.eat(U('-'));
+		int64_t offset_hour = 0, offset_minute = 0;
+		if ((!negative_offset && !reader.eat(U('+')))
+			|| !reader.read_number(2, 2, offset_hour) || !reader.eat(U(':'))
+			|| !reader.read_number(2, 2, offset_minute)
+			|| offset_hour > 23 || offset_minute > 59)
+		{
+			return false;
+		}
+
+		offset = (offset_hour * 60 + offset_minute) * 60;
+		offset = negative_offset ? -offset : offset;
+	}
+
+	if (!reader.at_end() || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59)
+	{
+		return false;
+	}
+
+	int64_t days = days_from_civil(negative_year ? -year : year, month, day);
+	result.seconds = ((days * 24 + hour) * 60 + minute) * 60 + second - offset;
+	result.nanoseconds = nanoseconds;
+	return true;
+}
+
+// Parses [-]P[nD][T[nH][nM][n[.fffffffff]S]] into signed seconds.
+bool parse_duration(const ::odata::utility::string_t& text, temporal_value& result)
+{
+	temporal_reader reader(text);
+	bool negative = reader.eat(U('-'));
+	if (!reader.eat(U('P')))
+	{
+		return false;
+	}
+
+	int64_t seconds = 0, nanoseconds = 0, number = 0;
+	bool any_component = false;
+	if (reader.peek_digit())
+	{
+		if (!reader.read_number(1, 12, number) || !reader.eat(U('D')))
+		{
+			return false;
+		}
+
+		seconds += number * 86400;
+		any_component = true;
+	}
+
+	if (reader.eat(U('T')))
+	{
+		bool any_time_component = false;
+		const ::odata::utility::char_t designators[] = { U('H'), U('M') };
+		const int64_t scales[] = { 3600, 60 };
+		for (size_t i = 0; i < 2; ++i)
+		{
+			temporal_reader lookahead = reader;
+			if (lookahead.read_number(1, 15, number) && lookahead.eat(designators[i]))
+			{
+				reader = lookahead;
+				seconds += number * scales[i];
+				any_time_component = true;
+			}
+		}
+
+		if (reader.peek_digit())
+		{
+			if (!reader.read_number(1, 15, number)
+				|| (reader.eat(U('.')) && !reader.read_fraction(nanoseconds))
+				|| !reader.eat(U('S')))
+			{
+				return false;
+			}
+
+			seconds += number;
+			any_time_component = true;
+		}
+
+		if (!any_time_component)
+		{
+			return false;
+		}
+
+		any_component = true;
+	}
+
+	if (!any_component || !reader.at_end())
+	{
+		return false;
+	}
+
+	if (negative && (seconds != 0 || nanoseconds != 0))
+	{
+		// Keep the nanoseconds non-negative so that pairs order correctly: -1.25s is -2s + 0.75s.
+		result.seconds = nanoseconds == 0 ? -seconds : -seconds - 1;
+		result.nanoseconds = nanoseconds == 0 ? 0 : 1000000000 - nanoseconds;
+	}
+	else
+	{
+		result.seconds = seconds;
+		result.nanoseconds = nanoseconds;
+	}
+
+	return true;
+}
+
+bool parse_temporal(edm_primitive_type_kind_t kind, const ::odata::utility::string_t& text, temporal_value& result)
+{
+	switch (kind)
+	{
+	case edm_primitive_type_kind_t::DateTimeOffset:
+		return parse_date_time_offset(text, result);
+	case edm_primitive_type_kind_t::Duration:
+		return parse_duration(text, result);
+	default:
+		return false;
+	}
+}
+
+::odata::utility::string_t to_lower_ascii(::odata::utility::string_t text)
+{
+	for (auto& c : text)
+	{
+		if (c >= U('A') && c <= U('Z'))
+		{
+			c = c - U('A') + U('a');
+		}
+	}
+
+	return text;
+}
+
+std::shared_ptr<odata_primitive_value> make_boolean(bool value)
+{
+	return std::make_shared<odata_primitive_value>(edm_primitive_type::BOOLEAN(), value ? U("true") : U("false"));
+}
+
+std::shared_ptr<odata_primitive_value> to_primitive(const std::shared_ptr<odata_value>& value)
+{
+	if (!value)
+	{
+		return nullptr;
+	}
+
+	auto primitive = std::dynamic_pointer_cast<odata_primitive_value>(value);
+	if (primitive)
+	{
+		return primitive;
+	}
+
+	auto enum_value = std::dynamic_pointer_cast<odata_enum_value>(value);
+	if (enum_value)
+	{
+		return std::make_shared<odata_primitive_value>(enum_value->get_value_type(), enum_value->to_string());
+	}
+
+	throw odata_exception(U("Filter expression does not evaluate to a primitive value."));
+}
+
+std::shared_ptr<odata_primitive_value> string_parameter(
+	odata_filter_evaluator &evaluator,
+	std::shared_ptr<odata_function_call_node> node,
+	size_t index)
+{
+	if (node->parameters().size() <= index)
+	{
+		throw odata_exception(U("Too few parameters for function ") + node->name() + U("."));
+	}
+
+	return evaluator.evaluate_value(node->parameters()[index].second, nullptr);
+}
+
+}
+
+bool odata_filter_evaluator::evaluate(
+	std::shared_ptr<::odata::core::odata_query_node> expression,
+	std::shared_ptr<::odata::core::odata_structured_value> instance)
+{
+	return is_true(evaluate_value(expression, instance));
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::evaluate_value(
+	std::shared_ptr<::odata::core::odata_query_node> expression,
+	std::shared_ptr<::odata::core::odata_structured_value> instance)
+{
+	if (instance)
+	{
+		m_instance = instance;
+	}
+
+	return eval(expression);
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::eval(std::shared_ptr<::odata::core::odata_query_node> node)
+{
+	if (!node)
+	{
+		return nullptr;
+	}
+
+	auto self = std::static_pointer_cast<odata_query_node_visitor<std::shared_ptr<odata_primitive_value>>>(shared_from_this());
+	return node->accept(self);
+}
+
+std::shared_ptr<::odata::core::odata_value> odata_filter_evaluator::resolve_value(std::shared_ptr<::odata::core::odata_query_node> node)
+{
+	if (!node)
+	{
+		return m_instance;
+	}
+
+	switch (node->node_kind())
+	{
+	case odata_query_node_kind::RangeVariable:
+		{
+			auto range_variable = node->as<odata_range_variable_node>();
+			auto found = m_range_variables.find(range_variable->name());
+			if (found == m_range_variables.end())
+			{
+				throw odata_exception(U("Unknown range variable ") + range_variable->name() + U("."));
+			}
+
+			return found->second;
+		}
+
+	case odata_query_node_kind::TypeCast:
+		return resolve_value(node->as<odata_type_cast_node>()->parent());
+
+	case odata_query_node_kind::PropertyAccess:
+		{
+			auto property_access = node->as<odata_property_access_node>();
+			auto parent = std::dynamic_pointer_cast<odata_structured_value>(resolve_value(property_access->parent()));
+			if (!parent)
+			{
+				return nullptr;
+			}
+
+			std::shared_ptr<odata_value> value;
+			if (!parent->get_property_value(property_access->property_name(), value))
+			{
+				return nullptr;
+			}
+
+			return value;
+		}
+
+	default:
+		return eval(node);
+	}
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::visit(std::shared_ptr<::odata::core::odata_constant_node> node)
+{
+	return node->value();
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::visit(std::shared_ptr<::odata::core::odata_binary_operator_node> node)
+{
+	int kind = node->operator_kind();
+
+	if (kind == binary_operator_kind::And)
+	{
+		auto left = eval(node->left());
+		if (left && !is_true(left))
+		{
+			return make_boolean(false);
+		}
+
+		auto right = eval(node->right());
+		if (right && !is_true(right))
+		{
+			return make_boolean(false);
+		}
+
+		return left && right ? make_boolean(true) : nullptr;
+	}
+
+	if (kind == binary_operator_kind::Or)
+	{
+		auto left = eval(node->left());
+		if (is_true(left))
+		{
+			return make_boolean(true);
+		}
+
+		auto right = eval(node->right());
+		if (is_true(right))
+		{
+			return make_boolean(true);
+		}
+
+		return left && right ? make_boolean(false) : nullptr;
+	}
+
+	auto left = eval(node->left());
+	auto right = eval(node->right());
+
+	switch (kind)
+	{
+	case binary_operator_kind::Equal:
+		if (!left || !right)
+		{
+			return make_boolean(!left && !right);
+		}
+		return make_boolean(compare(left, right) == 0);
+
+	case binary_operator_kind::NotEqual:
+		if (!left || !right)
+		{
+			return make_boolean(!left != !right);
+		}
+		return make_boolean(compare(left, right) != 0);
+
+	case binary_operator_kind::GreaterThan:
+	case binary_operator_kind::GreaterThanOrEqual:
+	case binary_operator_kind::LessThan:
+	case binary_operator_kind::LessThanOrEqual:
+		{
+			if (!left || !right)
+			{
+				return make_boolean(false);
+			}
+
+			int result = compare(left, right);
+			switch (kind)
+			{
+			case binary_operator_kind::GreaterThan:
+				return make_boolean(result > 0);
+			case binary_operator_kind::GreaterThanOrEqual:
+				return make_boolean(result >= 0);
+			case binary_operator_kind::LessThan:
+				return make_boolean(result < 0);
+			default:
+				return make_boolean(result <= 0);
+			}
+		}
+
+	case binary_operator_kind::Add:
+	case binary_operator_kind::Sub:
+	case binary_operator_kind::Multiply:
+	case binary_operator_kind::Divide:
+	case binary_operator_kind::Modulo:
+		if (!left || !right)
+		{
+			return nullptr;
+		}
+		return arithmetic(kind, left, right);
+
+	default:
+		throw odata_exception(U("Binary operator is not supported by the filter evaluator."));
+	}
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::arithmetic(
+	int operator_kind,
+	const std::shared_ptr<::odata::core::odata_primitive_value>& left,
+	const std::shared_ptr<::odata::core::odata_primitive_value>& right)
+{
+	if (!is_numeric(left) || !is_numeric(right))
+	{
+		throw odata_exception(U("Arithmetic operators require numeric operands."));
+	}
+
+	if (is_integral_kind(primitive_kind_of(left)) && is_integral_kind(primitive_kind_of(right)))
+	{
+		int64_t l = to_int64(left);
+		int64_t r = to_int64(right);
+		if ((operator_kind == binary_operator_kind::Divide || operator_kind == binary_operator_kind::Modulo) && r == 0)
+		{
+			throw odata_exception(U("Division by zero in filter expression."));
+		}
+
+		int64_t result = 0;
+		switch (operator_kind)
+		{
+		case binary_operator_kind::Add: result = l + r; break;
+		case binary_operator_kind::Sub: result = l - r; break;
+		case binary_operator_kind::Multiply: result = l * r; break;
+		case binary_operator_kind::Divide: result = l / r; break;
+		default: result = l % r; break;
+		}
+
+		return odata_primitive_value::make_primitive_value(result);
+	}
+
+	double l = to_double(left);
+	double r = to_double(right);
+	double result = 0;
+	switch (operator_kind)
+	{
+	case binary_operator_kind::Add: result = l + r; break;
+	case binary_operator_kind::Sub: result = l - r; break;
+	case binary_operator_kind::Multiply: result = l * r; break;
+	case binary_operator_kind::Divide: result = l / r; break;
+	default: result = std::fmod(l, r); break;
+	}
+
+	return odata_primitive_value::make_primitive_value(result);
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::visit(std::shared_ptr<::odata::core::odata_unary_operator_node> node)
+{
+	auto operand = eval(node->operand());
+	if (!operand)
+	{
+		return nullptr;
+	}
+
+	if (node->operator_kind() == unary_operator_kind::Not)
+	{
+		return make_boolean(!is_true(operand));
+	}
+
+	if (!is_numeric(operand))
+	{
+		throw odata_exception(U("Negation requires a numeric operand."));
+	}
+
+	if (is_integral_kind(primitive_kind_of(operand)))
+	{
+		return odata_primitive_value::make_primitive_value(-to_int64(operand));
+	}
+
+	return odata_primitive_value::make_primitive_value(-to_double(operand));
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::visit(std::shared_ptr<::odata::core::odata_parameter_alias_node> node)
+{
+	throw odata_exception(U("Parameter alias ") + node->alias() + U(" is not supported by the filter evaluator."));
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::visit(std::shared_ptr<::odata::core::odata_property_access_node> node)
+{
+	return to_primitive(resolve_value(node));
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::visit(std::shared_ptr<::odata::core::odata_type_cast_node> node)
+{
+	return to_primitive(resolve_value(node));
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::visit(std::shared_ptr<::odata::core::odata_lambda_node> node)
+{
+	auto collection = std::dynamic_pointer_cast<odata_collection_value>(resolve_value(node->parent()));
+	if (!collection)
+	{
+		return make_boolean(!node->is_any());
+	}
+
+	if (!node->expression())
+	{
+		return make_boolean(!node->is_any() || !collection->get_collection_values().empty());
+	}
+
+	auto saved = m_range_variables.find(node->parameter()) != m_range_variables.end() ? m_range_variables[node->parameter()] : nullptr;
+
+	bool result = !node->is_any();
+	const auto &values = collection->get_collection_values();
+	for (auto iter = values.cbegin(); iter != values.cend(); ++iter)
+	{
+		m_range_variables[node->parameter()] = *iter;
+		bool matched = is_true(eval(node->expression()));
+		if (node->is_any() && matched)
+		{
+			result = true;
+			break;
+		}
+		if (!node->is_any() && !matched)
+		{
+			result = false;
+			break;
+		}
+	}
+
+	if (saved)
+	{
+		m_range_variables[node->parameter()] = saved;
+	}
+	else
+	{
+		m_range_variables.erase(node->parameter());
+	}
+
+	return make_boolean(result);
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::visit(std::shared_ptr<::odata::core::odata_range_variable_node> node)
+{
+	return to_primitive(resolve_value(node));
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::visit(std::shared_ptr<::odata::core::odata_function_call_node> node)
+{
+	const auto &name = node->name();
+
+	if (name == U("contains") || name == U("startswith") || name == U("endswith") || name == U("indexof") || name == U("concat"))
+	{
+		auto first = string_parameter(*this, node, 0);
+		auto second = string_parameter(*this, node, 1);
+		if (!first || !second)
+		{
+			return nullptr;
+		}
+
+		const auto &text = first->to_string();
+		const auto &pattern = second->to_string();
+		if (name == U("contains"))
+		{
+			return make_boolean(text.find(pattern) != string_t::npos);
+		}
+		if (name == U("startswith"))
+		{
+			return make_boolean(text.compare(0, pattern.size(), pattern) == 0);
+		}
+		if (name == U("endswith"))
+		{
+			return make_boolean(text.size() >= pattern.size() && text.compare(text.size() - pattern.size(), pattern.size(), pattern) == 0);
+		}
+		if (name == U("indexof"))
+		{
+			auto position = text.find(pattern);
+			return odata_primitive_value::make_primitive_value((int32_t)(position == string_t::npos ? -1 : (int32_t)position));
+		}
+		return odata_primitive_value::make_primitive_value(text + pattern);
+	}
+
+	if (name == U("length") || name == U("tolower") || name == U("toupper") || name == U("trim"))
+	{
+		auto first = string_parameter(*this, node, 0);
+		if (!first)
+		{
+			return nullptr;
+		}
+
+		string_t text = first->to_string();
+		if (name == U("length"))
+		{
+			return odata_primitive_value::make_primitive_value((int32_t)text.size());
+		}
+		if (name == U("tolower"))
+		{
+			std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+			return odata_primitive_value::make_primitive_value(text);
+		}
+		if (name == U("toupper"))
+		{
+			std::transform(text.begin(), text.end(), text.begin(), ::toupper);
+			return odata_primitive_value::make_primitive_value(text);
+		}
+
+		auto begin = text.find_first_not_of(U(" \t\r\n"));
+		auto end = text.find_last_not_of(U(" \t\r\n"));
+		return odata_primitive_value::make_primitive_value(begin == string_t::npos ? string_t() : text.substr(begin, end - begin + 1));
+	}
+
+	throw odata_exception(U("Function ") + name + U(" is not supported by the filter evaluator."));
+}
+
+std::shared_ptr<::odata::core::odata_primitive_value> odata_filter_evaluator::visit_any(std::shared_ptr<::odata::core::odata_query_node> node)
+{
+	return eval(node);
+}
+
+int odata_filter_evaluator::compare(
+	const std::shared_ptr<::odata::core::odata_primitive_value>& left,
+	const std::shared_ptr<::odata::core::odata_primitive_value>& right)
+{
+	if (is_numeric(left) && is_numeric(right))
+	{
+		if (is_integral_kind(primitive_kind_of(left)) && is_integral_kind(primitive_kind_of(right)))
+		{
+			int64_t l = to_int64(left);
+			int64_t r = to_int64(right);
+			return l < r ? -1 : (l > r ? 1 : 0);
+		}
+
+		double l = to_double(left);
+		double r = to_double(right);
+		return l < r ? -1 : (l > r ? 1 : 0);
+	}
+
+	if (primitive_kind_of(left) == edm_primitive_type_kind_t::Boolean && primitive_kind_of(right) == edm_primitive_type_kind_t::Boolean)
+	{
+		// make_primitive_value(bool) prints 1/0 while literals are true/false.
+		return (int)is_true(left) - (int)is_true(right);
+	}
+
+	auto kind = primitive_kind_of(left);
+	if (kind == primitive_kind_of(right))
+	{
+		temporal_value l, r;
+		if (parse_temporal(kind, left->to_string(), l) && parse_temporal(kind, right->to_string(), r))
+		{
+			return l.compare(r);
+		}
+
+		if (kind == edm_primitive_type_kind_t::Guid)
+		{
+			return to_lower_ascii(left->to_string()).compare(to_lower_ascii(right->to_string()));
+		}
+	}
+
+	return left->to_string().compare(right->to_string());
+}
+
+::odata::utility::string_t odata_filter_evaluator::canonical_text(const std::shared_ptr<::odata::core::odata_primitive_value>& value)
+{
+	auto kind = primitive_kind_of(value);
+	temporal_value parsed;
+	if (parse_temporal(kind, value->to_string(), parsed))
+	{
+		return ::odata::utility::conversions::print_string(parsed.seconds) + U(".") + ::odata::utility::conversions::print_string(parsed.nanoseconds);
+	}
+
+	if (kind == edm_primitive_type_kind_t::Guid)
+	{
+		return to_lower_ascii(value->to_string());
+	}
+
+	return value->to_string();
+}
+
+bool odata_filter_evaluator::is_numeric(const std::shared_ptr<::odata::core::odata_primitive_value>& value)
+{
+	if (!value)
+	{
+		return false;
+	}
+
+	auto kind = primitive_kind_of(value);
+	return is_integral_kind(kind)
+		|| kind == edm_primitive_type_kind_t::Single
+		|| kind == edm_primitive_type_kind_t::Double
+		|| kind == edm_primitive_type_kind_t::Decimal;
+}
+
+bool odata_filter_evaluator::is_true(const std::shared_ptr<::odata::core::odata_primitive_value>& value)
+{
+	return value && (value->to_string() == U("true") || value->to_string() == U("1"));
+}
+
+}}
@@ -7,6 +7,7 @@
 #include "odata/core/odata_context_url_parser.h"
 #include "odata/core/odata_entity_factory.h"
 #include "odata/core/odata_json_reader_minimal.h"
+#include "odata/core/odata_metrics.h"
 #include "odata/core/odata_uri_parser.h"
 
 using namespace ::odata::edm;
@@ -74,7 +75,7 @@ void odata_json_reader_minimal::set_edit_link_for_entity_collection_value(const
 		entity_value->set_edit_link(navigation_source + key_string);
 
 		// check to see if it is an derived type
-		if (expect_type_name != entity_value->get_value_type()->get_name())
+		if (expect_type_name != entity_value->get_value_type_pointer()->get_name())
 		{
 			::odata::utility::string_t derived_edit_link = navigation_source + key_string;
 			derived_edit_link += U("/");
@@ -145,7 +146,7 @@ void odata_json_reader_minimal::set_edit_link_for_entity_value(const std::shared
 	entity_value->set_edit_link(navigation_source + key_string);
 
 	// check to see if it is an derived type
-	if (expect_type_name != entity_value->get_value_type()->get_name())
+	if (expect_type_name != entity_value->get_value_type_pointer()->get_name())
 	{
 		::odata::utility::string_t derived_edit_link = navigation_source + key_string;
 		derived_edit_link += U("/");
@@ -214,6 +215,8 @@ std::shared_ptr<edm_named_type> odata_json_reader_minimal::prepare_for_reading(c
 
 std::shared_ptr<odata_collection_value> odata_json_reader_minimal::deserilize_entity_collection(const odata::utility::json::value& content, std::shared_ptr<edm_entity_set> entity_set)
 {
+	odata_stage_timer timer(Deserialize);
+
 	std::shared_ptr<edm_collection_type> collection_type;
 	if (entity_set)
 	{
@@ -257,11 +260,124 @@ std::shared_ptr<odata_collection_value> odata_json_reader_minimal::deserilize_en
 	}
 
 	collection_value->set_is_top_level(true);
+	odata_metrics::count(EntitiesRead, collection_value->get_collection_values().size());
 	return collection_value;
 }
 
+static ::odata::utility::string_t delta_string_field(const odata::utility::json::value& value, const ::odata::utility::string_t& name, const ::odata::utility::string_t& short_name)
+{
+	if (value.has_field(name) && value.at(name).is_string())
+	{
+		return value.at(name).as_string();
+	}
+	if (!short_name.empty() && value.has_field(short_name) && value.at(short_name).is_string())
+	{
+		return value.at(short_name).as_string();
+	}
+	return ::odata::utility::string_t();
+}
+
+static bool ends_with(const ::odata::utility::string_t& text, const ::odata::utility::string_t& suffix)
+{
+	return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::shared_ptr<odata_delta_value> odata_json_reader_minimal::deserilize_delta_value(const odata::utility::json::value& content, std::shared_ptr<edm_entity_set> entity_set)
+{
+	odata_stage_timer timer(Deserialize);
+
+	::odata::utility::string_t context_url = delta_string_field(content, U("@odata.context"), U("@context"));
+	if (!entity_set)
+	{
+		auto hash = context_url.find(U('#'));
+		if (hash == ::odata::utility::string_t::npos || !ends_with(context_url, U("/$delta")))
+		{
+			throw std::runtime_error("Failed to parse context url in payload");
+		}
+
+		auto entity_set_name = context_url.substr(hash + 1, context_url.size() - hash - 1 - 7);
+		auto container = m_model->find_container();
+		entity_set = container ? container->find_entity_set(entity_set_name) : nullptr;
+		if (!entity_set)
+		{
+			throw std::runtime_error("Failed to parse context url in payload");
+		}
+	}
+
+	if (!content.has_field(U("value")) || !content.at(U("value")).is_array())
+	{
+		throw std::runtime_error("invalid payload format");
+	}
+
+	auto delta_value = std::make_shared<odata_delta_value>(entity_set);
+	if (!context_url.empty())
+	{
+		delta_value->set_context_url(context_url);
+	}
+
+	size_t changed = 0;
+	const auto& entries = content.at(U("value")).as_array();
+	for (auto iter = entries.begin(); iter != entries.end(); ++iter)
+	{
+		const auto& entry = *iter;
+		if (!entry.is_object())
+		{
+			throw std::runtime_error("invalid payload format");
+		}
+
+		auto entry_context = delta_string_field(entry, U("@odata.context"), U("@context"));
+		if (entry.has_field(U("@odata.removed")) || entry.has_field(U("@removed")))
+		{
+			const auto& removed = entry.has_field(U("@odata.removed")) ? entry.at(U("@odata.removed")) : entry.at(U("@removed"));
+			auto reason = removed.is_object() ? delta_string_field(removed, U("reason"), U("")) : ::odata::utility::string_t();
+			delta_value->add_deleted_entity(delta_string_field(entry, U("@odata.id"), U("@id")), reason == U("changed") ? DeletedReasonChanged : DeletedReasonDeleted);
+		}
+		else if (ends_with(entry_context, U("/$deletedEntity")))
+		{
+			delta_value->add_deleted_entity(delta_string_field(entry, U("id"), U("")), delta_string_field(entry, U("reason"), U("")) == U("changed") ? DeletedReasonChanged : DeletedReasonDeleted);
+		}
+		else if (ends_with(entry_context, U("/$link")) || ends_with(entry_context, U("/$deletedLink")))
+		{
+			auto source = delta_string_field(entry, U("source"), U(""));
+			auto relationship = delta_string_field(entry, U("relationship"), U(""));
+			auto target = delta_string_field(entry, U("target"), U(""));
+			if (ends_with(entry_context, U("/$link")))
+			{
+				delta_value->add_link(source, relationship, target);
+			}
+			else
+			{
+				delta_value->add_deleted_link(source, relationship, target);
+			}
+		}
+		else
+		{
+			auto entity_type = entity_set->get_entity_type();
+			delta_value->add_changed_entity(handle_extract_entity_property(entry, entity_type));
+			changed++;
+		}
+	}
+
+	auto next_link = delta_string_field(content, U("@odata.nextLink"), U("@nextLink"));
+	if (!next_link.empty())
+	{
+		delta_value->set_next_link(next_link);
+	}
+
+	auto delta_link = delta_string_field(content, U("@odata.deltaLink"), U("@deltaLink"));
+	if (!delta_link.empty())
+	{
+		delta_value->set_delta_link(delta_link);
+	}
+
+	odata_metrics::count(EntitiesRead, changed);
+	return delta_value;
+}
+
 std::shared_ptr<odata_entity_value> odata_json_reader_minimal::deserilize_entity_value(const odata::utility::json::value& content, std::shared_ptr<edm_entity_type> entity_type)
 {
+	odata_stage_timer timer(Deserialize);
+
 	std::shared_ptr<edm_named_type> resolved_type = prepare_for_reading(content, entity_type);
 
 	auto resolved_entity_type = std::dynamic_pointer_cast<edm_entity_type>(resolved_type);
@@ -283,11 +399,14 @@ std::shared_ptr<odata_entity_value> odata_json_reader_minimal::deserilize_entity
 	}
 
 	entity_value->set_is_top_level(true);
+	odata_metrics::count(EntitiesRead, 1);
 	return entity_value;
 }
 
 std::shared_ptr<odata_value> odata_json_reader_minimal::deserilize_property(const odata::utility::json::value& content, std::shared_ptr<edm_named_type> edm_type)
 {
+	odata_stage_timer timer(Deserialize);
+
 	std::shared_ptr<edm_named_type> resolved_type = prepare_for_reading(content, edm_type);
 	if (!resolved_type)
 	{
@@ -360,6 +479,8 @@ std::shared_ptr<odata_value> odata_json_reader_minimal::deserilize_property(cons
 
 std::shared_ptr<odata_value> odata_json_reader_minimal::deserilize(const odata::utility::json::value& content)
 {
+	odata_stage_timer timer(Deserialize);
+
 	auto return_type = prepare_for_reading(content);
 	::odata::utility::string_t context_url = content.at(U("@odata.context")).as_string();
 
@@ -435,6 +556,7 @@ std::shared_ptr<odata_value> odata_json_reader_minimal::deserilize(const odata::
 	}
 
 	return_value->set_is_top_level(true);
+	odata_metrics::count_entities(EntitiesRead, return_value);
 	return return_value;
 }
 
@@ -551,21 +673,21 @@ std::shared_ptr<odata_entity_value> odata_json_reader_minimal::handle_extract_en
 
 
                     // set edit_link
-					if (navigation_value->get_value_type()->get_type_kind() == edm_type_kind_t::Collection)
+					if (navigation_value->get_value_type_pointer()->get_type_kind() == edm_type_kind_t::Collection)
 					{
 						auto collection_value = std::dynamic_pointer_cast<odata_collection_value>(navigation_value);
 						
 						if (collection_value)
 						{
-							set_edit_link_for_entity_collection_value(collection_value, collection_value->get_value_type()->get_name(), edit_link);
+							set_edit_link_for_entity_collection_value(collection_value, collection_value->get_value_type_pointer()->get_name(), edit_link);
 						}
 					}
-					else if (navigation_value->get_value_type()->get_type_kind() == edm_type_kind_t::Entity)
+					else if (navigation_value->get_value_type_pointer()->get_type_kind() == edm_type_kind_t::Entity)
 					{
 						auto element_value = std::dynamic_pointer_cast<odata_entity_value>(navigation_value);
 						if (element_value)
 						{
-							set_edit_link_for_entity_value(element_value, element_value->get_value_type()->get_name(), edit_link);
+							set_edit_link_for_entity_value(element_value, element_value->get_value_type_pointer()->get_name(), edit_link);
 						}
 					}
 				}
@@ -5,6 +5,7 @@
 //---------------------------------------------------------------------
 
 #include "odata/core/odata_json_writer.h"
+#include "odata/core/odata_metrics.h"
 
 using namespace ::odata::utility;
 using namespace ::odata::edm;
@@ -35,7 +36,9 @@ namespace odata { namespace core
     {
         if (value_object)
         {
-            return serialize_odata_value(value_object->get_value_type(), value_object);
+            odata_stage_timer timer(Serialize);
+            odata_metrics::count_entities(EntitiesWritten, value_object);
+            return serialize_odata_value(value_object->get_value_type_pointer(), value_object);
         }
 
         return odata::utility::json::value::null();
@@ -57,7 +60,7 @@ namespace odata { namespace core
         return result;
     }
 
-    ::odata::utility::json::value odata_json_writer::serialize_odata_value(const std::shared_ptr<edm_named_type>& property_type, const std::shared_ptr<odata_value>& property_value)
+    ::odata::utility::json::value odata_json_writer::serialize_odata_value(const edm_named_type* property_type, const std::shared_ptr<odata_value>& property_value)
     {
         odata::utility::json::value result = odata::utility::json::value::object();
 
@@ -71,7 +74,7 @@ namespace odata { namespace core
         case edm_type_kind_t::Primitive:
             {
                 auto p_value = std::dynamic_pointer_cast<odata_primitive_value>(property_value);
-                auto p_primitive_type = std::dynamic_pointer_cast<edm_primitive_type>(property_type);
+                auto p_primitive_type = dynamic_cast<const edm_primitive_type*>(property_type);
                 return serialize_primitive_value(p_primitive_type, p_value);
             }
             break;
@@ -108,7 +111,7 @@ namespace odata { namespace core
         }
     }
 
-    ::odata::utility::json::value odata_json_writer::serialize_primitive_value(const std::shared_ptr<edm_primitive_type>& p_primitive_type, const std::shared_ptr<odata_primitive_value>& p_value)
+    ::odata::utility::json::value odata_json_writer::serialize_primitive_value(const edm_primitive_type* p_primitive_type, const std::shared_ptr<odata_primitive_value>& p_value)
     {
         odata::utility::json::value result = odata::utility::json::value::object();
         if (!p_primitive_type || !p_value)
@@ -200,7 +203,7 @@ namespace odata { namespace core
             }
             else
             {
-                auto property_type = iter->second->get_value_type();
+                auto property_type = iter->second->get_value_type_pointer();
 
                 if (!is_type_serializable(property_type))
                 {
@@ -272,12 +275,12 @@ namespace odata { namespace core
 
         for (auto iter = p_value->get_collection_values().cbegin(); iter != p_value->get_collection_values().cend(); iter++)
         {
-            if (!is_type_serializable(element_type))
+            if (!is_type_serializable(element_type.get()))
             {
                 continue;
             }
 
-            values.push_back(serialize_odata_value(element_type, *iter));
+            values.push_back(serialize_odata_value(element_type.get(), *iter));
         }
 
         odata::utility::json::value collection_json = odata::utility::json::value::array(values);
@@ -303,7 +306,7 @@ namespace odata { namespace core
         }
     }
 
-    bool odata_json_writer::is_type_serializable(const std::shared_ptr<edm_named_type>& property_type)
+    bool odata_json_writer::is_type_serializable(const edm_named_type* property_type)
     {
         if (property_type)
         {
@@ -410,4 +413,71 @@ namespace odata { namespace core
         return result;
 
     }
+
+    odata::utility::json::value odata_json_writer::serialize(std::shared_ptr<odata_delta_value> delta_value)
+    {
+        odata_stage_timer timer(Serialize);
+
+        odata::utility::json::value result = odata::utility::json::value::object();
+        const auto& entity_set = delta_value->get_entity_set();
+        ::odata::utility::string_t entity_set_name = entity_set ? entity_set->get_name() : U("");
+
+        if (!delta_value->get_context_url().is_empty())
+        {
+            result[ANNOTATION_ODATA_CONTEXT] = odata::utility::json::value::string(delta_value->get_context_url().to_string());
+        }
+        else if (!m_metadata_document_uri.is_empty() && entity_set)
+        {
+            result[ANNOTATION_ODATA_CONTEXT] = odata::utility::json::value::string(m_metadata_document_uri.to_string() + U("#") + entity_set_name + CONTEXT_DELTA);
+        }
+
+        odata::utility::json::value value_json = odata::utility::json::value::array(delta_value->size());
+        size_t index = 0;
+        size_t changed = 0;
+        for (auto iter = delta_value->cbegin(); iter != delta_value->cend(); iter++)
+        {
+            const auto& entry = *iter;
+            odata::utility::json::value entry_json = odata::utility::json::value::object();
+
+            switch (entry->kind())
+            {
+            case DeltaChangedEntity:
+                entry_json = seriliaze_structured_value(entry->entity());
+                changed++;
+                break;
+            case DeltaDeletedEntity:
+                {
+                    odata::utility::json::value removed = odata::utility::json::value::object();
+                    removed[JSON_REASON] = odata::utility::json::value::string(entry->reason() == DeletedReasonChanged ? U("changed") : U("deleted"));
+                    entry_json[ANNOTATION_ODATA_REMOVED] = removed;
+                    entry_json[ANNOTATION_ODATA_ID] = odata::utility::json::value::string(entry->id().to_string());
+                }
+                break;
+            case DeltaAddedLink:
+            case DeltaDeletedLink:
+                entry_json[ANNOTATION_ODATA_CONTEXT] = odata::utility::json::value::string(U("#") + entity_set_name + (entry->kind() == DeltaAddedLink ? CONTEXT_LINK : CONTEXT_DELETED_LINK));
+                entry_json[JSON_SOURCE] = odata::utility::json::value::string(entry->source().to_string());
+                entry_json[JSON_RELATIONSHIP] = odata::utility::json::value::string(entry->relationship());
+                entry_json[JSON_TARGET] = odata::utility::json::value::string(entry->target().to_string());
+                break;
+            }
+
+            value_json[index++] = entry_json;
+        }
+
+        result[JSON_VALUE] = value_json;
+
+        if (!delta_value->get_next_link().is_empty())
+        {
+            result[ANNOTATION_ODATA_NEXT_LINK] = odata::utility::json::value::string(delta_value->get_next_link().to_string());
+        }
+
+        if (!delta_value->get_delta_link().is_empty())
+        {
+            result[ANNOTATION_ODATA_DELTA_LINK] = odata::utility::json::value::string(delta_value->get_delta_link().to_string());
+        }
+
+        odata_metrics::count(EntitiesWritten, changed);
+        return result;
+    }
 }}
\ No newline at end of file
@@ -5,29 +5,36 @@
 //---------------------------------------------------------------------
 
 #include "odata/core/odata_message_writer.h"
+#include "odata/core/odata_metrics.h"
 
 using namespace odata::utility::json;
 using namespace odata::edm;
 
 namespace odata { namespace core
 {
+    static void write_embedded_response_head(::odata::utility::ostringstream_t& stream, int16_t status_code, const ::odata::utility::string_t& status_message, const std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>& headers)
+    {
+        stream << U("HTTP/1.1 ") << status_code << U(" ") << status_message << U("\n");
+        for(auto header = headers.cbegin(); header != headers.cend(); header++)
+        {
+            stream << header->first << U(": ") <<header->second << U("\n");
+        }
+
+        stream << U("\n");
+    }
+
 	::odata::utility::string_t odata_message_writer::write_service_document(const std::shared_ptr<odata_service_document> service_document)
 	{
         auto writer = std::make_shared<::odata::core::odata_json_writer>(m_model, m_service_root);
 		return writer->serialize(service_document).to_string();
 	}
 
-	::odata::utility::string_t odata_message_writer::write_metadata_document()
+	::odata::utility::string_t odata_message_writer::write_metadata_document(edm_csdl_format_t format)
 	{
-        std::ostringstream outstream;;
-        std::shared_ptr<edm_model_writer> writer = std::make_shared<edm_model_writer>(outstream);
-        writer->write_model(m_model);
-        std::string str = outstream.str();
-
-        ::odata::utility::string_t str_t;
-        str_t.assign(str.begin(), str.end());
-
-        return str_t;
+        odata_stage_timer timer(MetadataRender);
+        auto document = edm_csdl_writer::write_model_to_string(m_model, format);
+        odata_metrics::count(PayloadBytesWritten, document.size());
+        return document;
 	}
 
     ::odata::utility::string_t odata_message_writer::write_odata_value(std::shared_ptr<::odata::core::odata_value> value)
@@ -35,21 +42,28 @@ namespace odata { namespace core
         auto writer = std::make_shared<::odata::core::odata_json_writer>(m_model);
         auto value_context = writer->serialize(value);
         auto ss = value_context.serialize();
+        odata_metrics::count(PayloadBytesWritten, ss.size());
         return ss;
     }
 
     ::odata::utility::string_t odata_message_writer::write_asynchronous_odata_value(std::shared_ptr<::odata::core::odata_value> value, int16_t status_code, ::odata::utility::string_t status_message, std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t> headers)
     {
         ::odata::utility::ostringstream_t stream;
-        stream << U("HTTP/1.1 ") << status_code << U(" ") << status_message << U("\n");
-        for(auto header = headers.cbegin(); header != headers.cend(); header++)
+        write_embedded_response_head(stream, status_code, status_message, headers);
+
+        // A response without a value, such as 204 No Content, has no body.
+        if (value)
         {
-            stream << header->first << U(": ") <<header->second << U("\n");
+            stream << write_odata_value(value);
         }
+        return stream.str();
+    }
 
-
-        stream << U("\n");
-        stream << write_odata_value(value);
+    ::odata::utility::string_t odata_message_writer::write_asynchronous_odata_error(std::shared_ptr<::odata::core::odata_error> error, int16_t status_code, ::odata::utility::string_t status_message, std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t> headers)
+    {
+        ::odata::utility::ostringstream_t stream;
+        write_embedded_response_head(stream, status_code, status_message, headers);
+        stream << write_odata_error(error);
         return stream.str();
     }
 
@@ -102,4 +116,13 @@ namespace odata { namespace core
         return ss;
     }
 
+    ::odata::utility::string_t odata_message_writer::write_odata_delta_value(std::shared_ptr<::odata::core::odata_delta_value> delta_value)
+    {
+        auto writer = std::make_shared<::odata::core::odata_json_writer>(m_model, m_service_root);
+        auto value_context = writer->serialize(delta_value);
+        auto ss = value_context.serialize();
+        odata_metrics::count(PayloadBytesWritten, ss.size());
+        return ss;
+    }
+
 }}
\ No newline at end of file
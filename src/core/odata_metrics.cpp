@@ -0,0 +1,293 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_metrics.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_metrics.h"
+#include "odata/core/odata_collection_value.h"
+#include "odata/core/odata_entity_value.h"
+#include <algorithm>
+
+namespace odata { namespace core
+{
+
+std::atomic<bool> odata_metrics::s_enabled(false);
+
+static std::shared_ptr<odata_metrics_sink> s_sink;
+
+void odata_metrics::set_sink(std::shared_ptr<odata_metrics_sink> sink)
+{
+	std::atomic_store(&s_sink, sink);
+	s_enabled.store(sink != nullptr, std::memory_order_relaxed);
+}
+
+std::shared_ptr<odata_metrics_sink> odata_metrics::get_sink()
+{
+	return std::atomic_load(&s_sink);
+}
+
+const char* odata_metrics::stage_name(odata_metrics_stage_t stage)
+{
+	static const char* const names[] = { "uri_split", "path_bind", "expression_parse", "json_parse", "deserialize", "serialize", "metadata_render" };
+	return stage < StageCount ? names[stage] : "unknown";
+}
+
+const char* odata_metrics::counter_name(odata_metrics_counter_t counter)
+{
+	static const char* const names[] = { "payload_bytes_read", "payload_bytes_written", "entities_read", "entities_written" };
+	return counter < CounterCount ? names[counter] : "unknown";
+}
+
+void odata_metrics::report_stage(odata_metrics_stage_t stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::duration duration)
+{
+	auto sink = std::atomic_load(&s_sink);
+	if (sink)
+	{
+		sink->on_stage(stage, start, duration);
+	}
+}
+
+void odata_metrics::report_counter(odata_metrics_counter_t counter, uint64_t value)
+{
+	auto sink = std::atomic_load(&s_sink);
+	if (sink)
+	{
+		sink->on_counter(counter, value);
+	}
+}
+
+void odata_metrics::report_entities(odata_metrics_counter_t counter, const std::shared_ptr<odata_value>& value)
+{
+	if (std::dynamic_pointer_cast<odata_entity_value>(value))
+	{
+		report_counter(counter, 1);
+		return;
+	}
+
+	auto collection = std::dynamic_pointer_cast<odata_collection_value>(value);
+	if (collection && !collection->get_collection_values().empty() && std::dynamic_pointer_cast<odata_entity_value>(collection->get_collection_values()[0]))
+	{
+		report_counter(counter, collection->get_collection_values().size());
+	}
+}
+
+odata_histogram_metrics_sink::odata_histogram_metrics_sink()
+{
+	reset();
+}
+
+void odata_histogram_metrics_sink::on_stage(odata_metrics_stage_t stage, std::chrono::steady_clock::time_point, std::chrono::steady_clock::duration duration)
+{
+	if (stage >= StageCount)
+	{
+		return;
+	}
+
+	uint64_t ns = (uint64_t)std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+	size_t index = 0;
+	while (index + 1 < bucket_count && (ns >> (index + 1)) != 0)
+	{
+		index++;
+	}
+
+	auto &histogram = m_stages[stage];
+	histogram.count.fetch_add(1, std::memory_order_relaxed);
+	histogram.total_ns.fetch_add(ns, std::memory_order_relaxed);
+	histogram.buckets[index].fetch_add(1, std::memory_order_relaxed);
+
+	uint64_t max_ns = histogram.max_ns.load(std::memory_order_relaxed);
+	while (ns > max_ns && !histogram.max_ns.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed))
+	{
+	}
+}
+
+void odata_histogram_metrics_sink::on_counter(odata_metrics_counter_t counter, uint64_t value)
+{
+	if (counter < CounterCount)
+	{
+		m_counters[counter].fetch_add(value, std::memory_order_relaxed);
+	}
+}
+
+uint64_t odata_histogram_metrics_sink::stage_percentile_ns(odata_metrics_stage_t stage, double percentile) const
+{
+	uint64_t count = stage_count(stage);
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	// The rank of the run at the percentile, counting from 1.
+	uint64_t rank = (uint64_t)(percentile / 100.0 * count + 0.5);
+	rank = std::min(std::max<uint64_t>(rank, 1), count);
+
+	uint64_t seen = 0;
+	for (size_t index = 0; index < bucket_count; index++)
+	{
+		seen += bucket(stage, index);
+		if (seen >= rank)
+		{
+			return std::min(((uint64_t)2 << index) - 1, stage_max_ns(stage));
+		}
+	}
+
+	return stage_max_ns(stage);
+}
+
+void odata_histogram_metrics_sink::reset()
+{
+	for (size_t stage = 0; stage < StageCount; stage++)
+	{
+		m_stages[stage].count.store(0, std::memory_order_relaxed);
+		m_stages[stage].total_ns.store(0, std::memory_order_relaxed);
+		m_stages[stage].max_ns.store(0, std::memory_order_relaxed);
+		for (size_t index = 0; index < bucket_count; index++)
+		{
+			m_stages[stage].buckets[index].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	for (size_t counter = 0; counter < CounterCount; counter++)
+	{
+		m_counters[counter].store(0, std::memory_order_relaxed);
+	}
+}
+
+void odata_histogram_metrics_sink::write_summary(std::ostream& stream) const
+{
+	for (int stage = 0; stage < StageCount; stage++)
+	{
+		auto current = (odata_metrics_stage_t)stage;
+		if (stage_count(current) == 0)
+		{
+			continue;
+		}
+
+		stream << odata_metrics::stage_name(current) << ": count " << stage_count(current)
+			<< ", total " << stage_total_ns(current) << " ns"
+			<< ", p50 " << stage_percentile_ns(current, 50) << " ns"
+			<< ", p99 " << stage_percentile_ns(current, 99) << " ns"
+			<< ", max " << stage_max_ns(current) << " ns" << std::endl;
+	}
+
+	for (int counter = 0; counter < CounterCount; counter++)
+	{
+		auto current = (odata_metrics_counter_t)counter;
+		if (this->counter(current) != 0)
+		{
+			stream << odata_metrics::counter_name(current) << ": " << this->counter(current) << std::endl;
+		}
+	}
+}
+
+// Numbers threads in the order they first report, which keeps trace documents small and readable.
+static uint64_t current_thread_number()
+{
+	static std::atomic<uint64_t> s_next_thread(1);
+	static thread_local uint64_t t_thread = 0;
+	if (t_thread == 0)
+	{
+		t_thread = s_next_thread.fetch_add(1, std::memory_order_relaxed);
+	}
+	return t_thread;
+}
+
+odata_trace_event_metrics_sink::odata_trace_event_metrics_sink(size_t max_events)
+	: m_origin(std::chrono::steady_clock::now()), m_max_events(max_events)
+{
+	clear();
+}
+
+void odata_trace_event_metrics_sink::on_stage(odata_metrics_stage_t stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::duration duration)
+{
+	trace_event event;
+	event.kind = stage;
+	event.thread = current_thread_number();
+	event.start = start;
+	event.value = (uint64_t)std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_events.size() < m_max_events)
+	{
+		m_events.push_back(event);
+	}
+}
+
+void odata_trace_event_metrics_sink::on_counter(odata_metrics_counter_t counter, uint64_t value)
+{
+	if (counter >= CounterCount)
+	{
+		return;
+	}
+
+	trace_event event;
+	event.kind = StageCount + counter;
+	event.thread = current_thread_number();
+	event.start = std::chrono::steady_clock::now();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_counter_totals[counter] += value;
+	event.value = m_counter_totals[counter];
+	if (m_events.size() < m_max_events)
+	{
+		m_events.push_back(event);
+	}
+}
+
+size_t odata_trace_event_metrics_sink::event_count() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_events.size();
+}
+
+void odata_trace_event_metrics_sink::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_events.clear();
+	for (size_t counter = 0; counter < CounterCount; counter++)
+	{
+		m_counter_totals[counter] = 0;
+	}
+}
+
+void odata_trace_event_metrics_sink::write(std::ostream& stream) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Timestamps are microseconds since the sink was created; durations keep nanosecond precision.
+	auto microseconds = [this](std::chrono::steady_clock::time_point time) -> double
+	{
+		return std::chrono::duration<double, std::micro>(time - m_origin).count();
+	};
+
+	auto flags = stream.flags();
+	stream.setf(std::ios::fixed);
+	auto precision = stream.precision(3);
+
+	stream << "{\"traceEvents\":[";
+	for (size_t i = 0; i < m_events.size(); i++)
+	{
+		const auto &event = m_events[i];
+		stream << (i ? ",\n" : "\n");
+		if (event.kind < StageCount)
+		{
+			stream << "{\"name\":\"" << odata_metrics::stage_name((odata_metrics_stage_t)event.kind) << "\",\"cat\":\"odata\",\"ph\":\"X\""
+				<< ",\"ts\":" << microseconds(event.start) << ",\"dur\":" << event.value / 1000.0
+				<< ",\"pid\":1,\"tid\":" << event.thread << "}";
+		}
+		else
+		{
+			const char* name = odata_metrics::counter_name((odata_metrics_counter_t)(event.kind - StageCount));
+			stream << "{\"name\":\"" << name << "\",\"cat\":\"odata\",\"ph\":\"C\""
+				<< ",\"ts\":" << microseconds(event.start)
+				<< ",\"pid\":1,\"tid\":" << event.thread << ",\"args\":{\"" << name << "\":" << event.value << "}}";
+		}
+	}
+	stream << "\n],\"displayTimeUnit\":\"ns\"}" << std::endl;
+
+	stream.precision(precision);
+	stream.flags(flags);
+}
+
+}}
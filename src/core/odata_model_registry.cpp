@@ -0,0 +1,131 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_model_registry.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_model_registry.h"
+#include "odata/core/odata_metrics.h"
+#include "odata/edm/edm_model_snapshot.h"
+
+using namespace ::odata::edm;
+
+namespace odata { namespace core
+{
+
+odata_model_version::~odata_model_version()
+{
+	if (m_on_retired)
+	{
+		m_on_retired(m_version);
+	}
+}
+
+std::shared_ptr<odata_uri> odata_model_version::parse_uri(const ::odata::utility::uri& uri) const
+{
+	if (m_uri_cache_capacity == 0)
+	{
+		return m_uri_parser.parse_uri(uri);
+	}
+
+	auto key = uri.to_string();
+	{
+		std::lock_guard<std::mutex> lock(m_cache_mutex);
+		auto found = m_parsed_uris.find(key);
+		if (found != m_parsed_uris.end())
+		{
+			return found->second;
+		}
+	}
+
+	// The parser is stateless, so parsing needs no lock; failed parses throw and are not cached.
+	auto parsed = m_uri_parser.parse_uri(uri);
+
+	std::lock_guard<std::mutex> lock(m_cache_mutex);
+	if (m_parsed_uris.size() >= m_uri_cache_capacity)
+	{
+		// Services see a small set of hot URIs; starting over is cheaper than tracking recency on every hit.
+		m_parsed_uris.clear();
+	}
+	return m_parsed_uris.insert(std::make_pair(key, parsed)).first->second;
+}
+
+const ::odata::utility::string_t& odata_model_version::metadata_document(edm_csdl_format_t format) const
+{
+	size_t index = format == edm_csdl_format_t::Json ? 1 : 0;
+	std::call_once(m_metadata_once[index], [this, format, index]()
+	{
+		odata_stage_timer timer(MetadataRender);
+		m_metadata_document[index] = edm_csdl_writer::write_model_to_string(m_model, format);
+	});
+
+	return m_metadata_document[index];
+}
+
+std::shared_ptr<const odata_model_version> odata_model_registry::publish(std::shared_ptr<edm_model> model)
+{
+	if (!model)
+	{
+		throw std::invalid_argument("Cannot publish a null model.");
+	}
+
+	std::lock_guard<std::mutex> lock(m_writer_mutex);
+	return publish_locked(model);
+}
+
+std::shared_ptr<const odata_model_version> odata_model_registry::update(const std::function<void(std::shared_ptr<edm_model>)>& change)
+{
+	std::lock_guard<std::mutex> lock(m_writer_mutex);
+
+	auto current = std::atomic_load(&m_current);
+	if (!current)
+	{
+		throw std::runtime_error("No model has been published yet.");
+	}
+
+	// Published models are frozen and shared with readers; a snapshot round trip gives an unfrozen deep copy.
+	std::ostringstream snapshot;
+	edm_model_snapshot_writer writer(snapshot);
+	writer.write_model(current->model());
+
+	auto bytes = snapshot.str();
+	edm_model_snapshot_reader reader(bytes.data(), bytes.size());
+	auto model = reader.read_model();
+
+	change(model);
+	return publish_locked(model);
+}
+
+size_t odata_model_registry::live_version_count() const
+{
+	std::lock_guard<std::mutex> lock(m_writer_mutex);
+
+	size_t count = 0;
+	for (auto iter = m_published.cbegin(); iter != m_published.cend(); ++iter)
+	{
+		if (!iter->expired())
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+std::shared_ptr<const odata_model_version> odata_model_registry::publish_locked(std::shared_ptr<edm_model> model)
+{
+	model->freeze();
+
+	std::shared_ptr<const odata_model_version> version(new odata_model_version(m_last_version + 1, model, m_uri_cache_capacity, m_on_retired));
+	m_last_version++;
+
+	m_published.erase(std::remove_if(m_published.begin(), m_published.end(), [](const std::weak_ptr<const odata_model_version>& published)
+	{
+		return published.expired();
+	}), m_published.end());
+	m_published.push_back(version);
+
+	std::atomic_store(&m_current, version);
+	return version;
+}
+
+}}
@@ -0,0 +1,825 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_sql_translator.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_sql_translator.h"
+#include "odata/core/odata_uri_parser.h"
+#include "odata/core/odata_exception.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::utility;
+
+namespace odata { namespace core
+{
+
+namespace
+{
+
+string_t function_key(const string_t& name, size_t arity)
+{
+	return name + U("/") + ::odata::utility::conversions::print_string(arity);
+}
+
+// Whether the node is already a predicate rather than a value that has to be tested for true.
+bool is_predicate(std::shared_ptr<odata_query_node> node)
+{
+	switch (node->node_kind())
+	{
+	case odata_query_node_kind::BinaryOperator:
+		return node->as<odata_binary_operator_node>()->operator_kind() <= binary_operator_kind::Has;
+	case odata_query_node_kind::UnaryOperator:
+		return node->as<odata_unary_operator_node>()->operator_kind() == unary_operator_kind::Not;
+	case odata_query_node_kind::Lambda:
+		return true;
+	case odata_query_node_kind::FunctionCall:
+	{
+		const auto &name = node->as<odata_function_call_node>()->name();
+		return name == U("contains") || name == U("startswith") || name == U("endswith");
+	}
+	default:
+		return false;
+	}
+}
+
+bool is_null_constant(std::shared_ptr<odata_query_node> node)
+{
+	return node->node_kind() == odata_query_node_kind::Constant && !node->as<odata_constant_node>()->value();
+}
+
+bool is_constant(std::shared_ptr<odata_query_node> node)
+{
+	return node->node_kind() == odata_query_node_kind::Constant;
+}
+
+string_t operator_name(int operator_kind)
+{
+	switch (operator_kind)
+	{
+	case binary_operator_kind::Or: return U("or");
+	case binary_operator_kind::And: return U("and");
+	case binary_operator_kind::Equal: return U("eq");
+	case binary_operator_kind::NotEqual: return U("ne");
+	case binary_operator_kind::GreaterThan: return U("gt");
+	case binary_operator_kind::GreaterThanOrEqual: return U("ge");
+	case binary_operator_kind::LessThan: return U("lt");
+	case binary_operator_kind::LessThanOrEqual: return U("le");
+	case binary_operator_kind::Has: return U("has");
+	case binary_operator_kind::Add: return U("add");
+	case binary_operator_kind::Sub: return U("sub");
+	case binary_operator_kind::Multiply: return U("mul");
+	case binary_operator_kind::Divide: return U("div");
+	case binary_operator_kind::Modulo: return U("mod");
+	default: return U("#") + ::odata::utility::conversions::print_string(operator_kind);
+	}
+}
+
+}
+
+// --BEGIN-- odata_sql_dialect
+
+std::shared_ptr<odata_sql_dialect> odata_sql_dialect::create_sqlite_dialect()
+{
+	auto dialect = std::shared_ptr<odata_sql_dialect>(new odata_sql_dialect());
+	dialect->m_quote_open = U("\"");
+	dialect->m_quote_close = U("\"");
+	dialect->m_parameter_prefix = U("?");
+	dialect->m_true_literal = U("1");
+	dialect->m_false_literal = U("0");
+	dialect->m_not_distinct_template = U("({0} IS {1})");
+	dialect->m_distinct_template = U("({0} IS NOT {1})");
+	dialect->m_unbounded_limit = U("-1");
+
+	dialect->set_function_template(U("contains"), 2, U("(instr({0}, {1}) > 0)"));
+	dialect->set_function_template(U("startswith"), 2, U("(substr({0}, 1, length({1})) = {1})"));
+	dialect->set_function_template(U("endswith"), 2, U("(length({1}) = 0 OR substr({0}, -length({1})) = {1})"));
+	dialect->set_function_template(U("indexof"), 2, U("(instr({0}, {1}) - 1)"));
+	dialect->set_function_template(U("length"), 1, U("length({0})"));
+	dialect->set_function_template(U("tolower"), 1, U("lower({0})"));
+	dialect->set_function_template(U("toupper"), 1, U("upper({0})"));
+	dialect->set_function_template(U("trim"), 1, U("trim({0})"));
+	dialect->set_function_template(U("concat"), 2, U("({0} || {1})"));
+	dialect->set_function_template(U("substring"), 2, U("substr({0}, ({1}) + 1)"));
+	dialect->set_function_template(U("substring"), 3, U("substr({0}, ({1}) + 1, {2})"));
+	dialect->set_function_template(U("year"), 1, U("CAST(strftime('%Y', {0}) AS INTEGER)"));
+	dialect->set_function_template(U("month"), 1, U("CAST(strftime('%m', {0}) AS INTEGER)"));
+	dialect->set_function_template(U("day"), 1, U("CAST(strftime('%d', {0}) AS INTEGER)"));
+	dialect->set_function_template(U("hour"), 1, U("CAST(strftime('%H', {0}) AS INTEGER)"));
+	dialect->set_function_template(U("minute"), 1, U("CAST(strftime('%M', {0}) AS INTEGER)"));
+	dialect->set_function_template(U("second"), 1, U("CAST(strftime('%S', {0}) AS INTEGER)"));
+	dialect->set_function_template(U("round"), 1, U("round({0})"));
+	dialect->set_function_template(U("floor"), 1, U("(CASE WHEN {0} < CAST({0} AS INTEGER) THEN CAST({0} AS INTEGER) - 1 ELSE CAST({0} AS INTEGER) END)"));
+	dialect->set_function_template(U("ceiling"), 1, U("(CASE WHEN {0} > CAST({0} AS INTEGER) THEN CAST({0} AS INTEGER) + 1 ELSE CAST({0} AS INTEGER) END)"));
+
+	return dialect;
+}
+
+std::shared_ptr<odata_sql_dialect> odata_sql_dialect::create_postgresql_dialect()
+{
+	auto dialect = std::shared_ptr<odata_sql_dialect>(new odata_sql_dialect());
+	dialect->m_quote_open = U("\"");
+	dialect->m_quote_close = U("\"");
+	dialect->m_parameter_prefix = U("$");
+	dialect->m_true_literal = U("TRUE");
+	dialect->m_false_literal = U("FALSE");
+	dialect->m_not_distinct_template = U("({0} IS NOT DISTINCT FROM {1})");
+	dialect->m_distinct_template = U("({0} IS DISTINCT FROM {1})");
+
+	dialect->set_function_template(U("contains"), 2, U("(STRPOS({0}, {1}) > 0)"));
+	dialect->set_function_template(U("startswith"), 2, U("(LEFT({0}, LENGTH({1})) = {1})"));
+	dialect->set_function_template(U("endswith"), 2, U("(RIGHT({0}, LENGTH({1})) = {1})"));
+	dialect->set_function_template(U("indexof"), 2, U("(STRPOS({0}, {1}) - 1)"));
+	dialect->set_function_template(U("length"), 1, U("LENGTH({0})"));
+	dialect->set_function_template(U("tolower"), 1, U("LOWER({0})"));
+	dialect->set_function_template(U("toupper"), 1, U("UPPER({0})"));
+	dialect->set_function_template(U("trim"), 1, U("TRIM({0})"));
+	dialect->set_function_template(U("concat"), 2, U("({0} || {1})"));
+	dialect->set_function_template(U("substring"), 2, U("SUBSTRING({0} FROM ({1}) + 1)"));
+	dialect->set_function_template(U("substring"), 3, U("SUBSTRING({0} FROM ({1}) + 1 FOR {2})"));
+	dialect->set_function_template(U("year"), 1, U("CAST(EXTRACT(YEAR FROM {0}) AS INTEGER)"));
+	dialect->set_function_template(U("month"), 1, U("CAST(EXTRACT(MONTH FROM {0}) AS INTEGER)"));
+	dialect->set_function_template(U("day"), 1, U("CAST(EXTRACT(DAY FROM {0}) AS INTEGER)"));
+	dialect->set_function_template(U("hour"), 1, U("CAST(EXTRACT(HOUR FROM {0}) AS INTEGER)"));
+	dialect->set_function_template(U("minute"), 1, U("CAST(EXTRACT(MINUTE FROM {0}) AS INTEGER)"));
+	dialect->set_function_template(U("second"), 1, U("CAST(FLOOR(EXTRACT(SECOND FROM {0})) AS INTEGER)"));
+	dialect->set_function_template(U("round"), 1, U("ROUND({0})"));
+	dialect->set_function_template(U("floor"), 1, U("FLOOR({0})"));
+	dialect->set_function_template(U("ceiling"), 1, U("CEILING({0})"));
+
+	return dialect;
+}
+
+std::shared_ptr<odata_sql_dialect> odata_sql_dialect::create_sql_server_dialect()
+{
+	auto dialect = std::shared_ptr<odata_sql_dialect>(new odata_sql_dialect());
+	dialect->m_quote_open = U("[");
+	dialect->m_quote_close = U("]");
+	dialect->m_parameter_prefix = U("@p");
+	dialect->m_true_literal = U("1");
+	dialect->m_false_literal = U("0");
+	dialect->m_not_distinct_template = U("({0} = {1} OR ({0} IS NULL AND {1} IS NULL))");
+	dialect->m_distinct_template = U("({0} <> {1} OR ({0} IS NULL AND {1} IS NOT NULL) OR ({0} IS NOT NULL AND {1} IS NULL))");
+	dialect->m_offset_fetch = true;
+
+	dialect->set_function_template(U("contains"), 2, U("(CHARINDEX({1}, {0}) > 0)"));
+	dialect->set_function_template(U("startswith"), 2, U("(LEFT({0}, LEN({1})) = {1})"));
+	dialect->set_function_template(U("endswith"), 2, U("(RIGHT({0}, LEN({1})) = {1})"));
+	dialect->set_function_template(U("indexof"), 2, U("(CHARINDEX({1}, {0}) - 1)"));
+	dialect->set_function_template(U("length"), 1, U("LEN({0})"));
+	dialect->set_function_template(U("tolower"), 1, U("LOWER({0})"));
+	dialect->set_function_template(U("toupper"), 1, U("UPPER({0})"));
+	dialect->set_function_template(U("trim"), 1, U("LTRIM(RTRIM({0}))"));
+	dialect->set_function_template(U("concat"), 2, U("({0} + {1})"));
+	dialect->set_function_template(U("substring"), 2, U("SUBSTRING({0}, ({1}) + 1, LEN({0}))"));
+	dialect->set_function_template(U("substring"), 3, U("SUBSTRING({0}, ({1}) + 1, {2})"));
+	dialect->set_function_template(U("year"), 1, U("DATEPART(year, {0})"));
+	dialect->set_function_template(U("month"), 1, U("DATEPART(month, {0})"));
+	dialect->set_function_template(U("day"), 1, U("DATEPART(day, {0})"));
+	dialect->set_function_template(U("hour"), 1, U("DATEPART(hour, {0})"));
+	dialect->set_function_template(U("minute"), 1, U("DATEPART(minute, {0})"));
+	dialect->set_function_template(U("second"), 1, U("DATEPART(second, {0})"));
+	dialect->set_function_template(U("round"), 1, U("ROUND({0}, 0)"));
+	dialect->set_function_template(U("floor"), 1, U("FLOOR({0})"));
+	dialect->set_function_template(U("ceiling"), 1, U("CEILING({0})"));
+
+	return dialect;
+}
+
+string_t odata_sql_dialect::quote_identifier(const string_t& name) const
+{
+	string_t quoted = m_quote_open;
+	for (auto iter = name.cbegin(); iter != name.cend(); ++iter)
+	{
+		quoted.push_back(*iter);
+		if (m_quote_close.size() == 1 && *iter == m_quote_close[0])
+		{
+			// Closing quotes are escaped by doubling them.
+			quoted.push_back(*iter);
+		}
+	}
+	quoted += m_quote_close;
+
+	return quoted;
+}
+
+string_t odata_sql_dialect::function_call(const string_t& name, const std::vector<string_t>& arguments) const
+{
+	auto found = m_functions.find(function_key(name, arguments.size()));
+	if (found == m_functions.end())
+	{
+		throw odata_exception(U("Function ") + name + U(" with ") + ::odata::utility::conversions::print_string(arguments.size()) + U(" arguments cannot be translated to SQL."));
+	}
+
+	return render(found->second, arguments);
+}
+
+void odata_sql_dialect::set_function_template(const string_t& name, size_t arity, const string_t& sql_template)
+{
+	m_functions[function_key(name, arity)] = sql_template;
+}
+
+string_t odata_sql_dialect::not_distinct(const string_t& left, const string_t& right) const
+{
+	std::vector<string_t> arguments;
+	arguments.push_back(left);
+	arguments.push_back(right);
+	return render(m_not_distinct_template, arguments);
+}
+
+string_t odata_sql_dialect::distinct(const string_t& left, const string_t& right) const
+{
+	std::vector<string_t> arguments;
+	arguments.push_back(left);
+	arguments.push_back(right);
+	return render(m_distinct_template, arguments);
+}
+
+string_t odata_sql_dialect::is_true(const string_t& value) const
+{
+	return U("(") + value + U(" = ") + m_true_literal + U(")");
+}
+
+string_t odata_sql_dialect::is_false(const string_t& value) const
+{
+	return U("(") + value + U(" = ") + m_false_literal + U(")");
+}
+
+void odata_sql_dialect::append_paging(string_t& sql, const string_t& top, const string_t& skip, bool has_orderby) const
+{
+	if (top.empty() && skip.empty())
+	{
+		return;
+	}
+
+	if (m_offset_fetch)
+	{
+		if (!has_orderby)
+		{
+			// OFFSET ... FETCH requires an ORDER BY.
+			sql += U(" ORDER BY (SELECT NULL)");
+		}
+
+		sql += U(" OFFSET ") + (skip.empty() ? string_t(U("0")) : skip) + U(" ROWS");
+		if (!top.empty())
+		{
+			sql += U(" FETCH NEXT ") + top + U(" ROWS ONLY");
+		}
+		return;
+	}
+
+	if (!top.empty())
+	{
+		sql += U(" LIMIT ") + top;
+	}
+	else if (!m_unbounded_limit.empty())
+	{
+		sql += U(" LIMIT ") + m_unbounded_limit;
+	}
+
+	if (!skip.empty())
+	{
+		sql += U(" OFFSET ") + skip;
+	}
+}
+
+string_t odata_sql_dialect::render(const string_t& sql_template, const std::vector<string_t>& arguments)
+{
+	string_t result;
+	result.reserve(sql_template.size() * 2);
+
+	for (size_t i = 0; i < sql_template.size(); i++)
+	{
+		if (sql_template[i] == U('{') && i + 2 < sql_template.size()
+			&& ::odata::utility::is_digit(sql_template[i + 1]) && sql_template[i + 2] == U('}'))
+		{
+			size_t index = sql_template[i + 1] - U('0');
+			if (index >= arguments.size())
+			{
+				throw odata_exception(U("SQL template argument out of range: ") + sql_template);
+			}
+
+			result += arguments[index];
+			i += 2;
+		}
+		else
+		{
+			result.push_back(sql_template[i]);
+		}
+	}
+
+	return result;
+}
+
+// --END-- odata_sql_dialect
+
+// --BEGIN-- odata_sql_table_mapping
+
+string_t odata_sql_table_mapping::column(const string_t& property_path) const
+{
+	auto found = m_columns.find(property_path);
+	if (found != m_columns.end())
+	{
+		return found->second;
+	}
+
+	string_t column = property_path;
+	std::replace(column.begin(), column.end(), U('/'), U('_'));
+	return column;
+}
+
+void odata_sql_table_mapping::map_navigation(
+	const string_t& navigation_property,
+	std::shared_ptr<odata_sql_table_mapping> target,
+	const string_t& source_column,
+	const string_t& target_column,
+	bool is_collection)
+{
+	navigation mapping;
+	mapping.target = target;
+	mapping.source_column = source_column;
+	mapping.target_column = target_column;
+	mapping.is_collection = is_collection;
+	m_navigations[navigation_property] = mapping;
+}
+
+// --END-- odata_sql_table_mapping
+
+// --BEGIN-- odata_sql_translator
+
+void odata_sql_translator::reset()
+{
+	m_scopes.clear();
+	m_parameters.clear();
+	m_alias_count = 0;
+
+	scope root;
+	root.alias = new_alias();
+	root.mapping = m_mapping;
+	m_scopes.push_back(root);
+}
+
+string_t odata_sql_translator::new_alias()
+{
+	return U("t") + ::odata::utility::conversions::print_string(m_alias_count++);
+}
+
+string_t odata_sql_translator::add_parameter(std::shared_ptr<::odata::core::odata_primitive_value> value)
+{
+	m_parameters.push_back(value);
+	return m_dialect->parameter(m_parameters.size());
+}
+
+string_t odata_sql_translator::translate_value(std::shared_ptr<::odata::core::odata_query_node> node)
+{
+	if (!node)
+	{
+		throw odata_exception(U("Unexpected null expression."));
+	}
+
+	return node->accept(shared_from_this());
+}
+
+string_t odata_sql_translator::translate_predicate(std::shared_ptr<::odata::core::odata_query_node> node)
+{
+	auto value = translate_value(node);
+	return is_predicate(node) ? value : m_dialect->is_true(value);
+}
+
+string_t odata_sql_translator::translate_where(std::shared_ptr<::odata::core::odata_uri> uri)
+{
+	auto filter_clause = uri->filter_clause();
+	if (!filter_clause || !filter_clause->expression())
+	{
+		return string_t();
+	}
+
+	return U(" WHERE ") + translate_predicate(filter_clause->expression());
+}
+
+std::shared_ptr<odata_sql_statement> odata_sql_translator::translate(std::shared_ptr<::odata::core::odata_uri> uri)
+{
+	reset();
+	auto root = m_scopes[0];
+
+	string_t columns;
+	auto select_expand_clause = uri->select_expand_clause();
+	if (select_expand_clause)
+	{
+		const auto &items = select_expand_clause->select_items();
+		for (auto item = items.cbegin(); item != items.cend(); ++item)
+		{
+			auto end = (*item)->end();
+			if (end->node_kind() == odata_query_node_kind::PropertyAccess && end->as<odata_property_access_node>()->property_name() == U("*"))
+			{
+				columns.clear();
+				break;
+			}
+
+			std::vector<string_t> from;
+			std::vector<string_t> conditions;
+			std::vector<string_t> segments;
+			size_t next = 0;
+			resolve_path(end, segments, next, false, from, conditions);
+			if (!from.empty() || next >= segments.size())
+			{
+				// Navigation properties are left to $expand.
+				continue;
+			}
+
+			string_t path;
+			for (size_t i = next; i < segments.size(); i++)
+			{
+				path += (i > next ? U("/") : U("")) + segments[i];
+			}
+
+			columns += (columns.empty() ? U("") : U(", ")) + root.alias + U(".") + m_dialect->quote_identifier(m_mapping->column(path));
+		}
+	}
+
+	string_t sql = U("SELECT ") + (columns.empty() ? root.alias + U(".*") : columns)
+		+ U(" FROM ") + m_dialect->quote_identifier(m_mapping->table_name()) + U(" AS ") + root.alias;
+
+	sql += translate_where(uri);
+
+	auto orderby_clause = uri->orderby_clause();
+	bool has_orderby = orderby_clause && !orderby_clause->items().empty();
+	if (has_orderby)
+	{
+		sql += U(" ORDER BY ");
+		const auto &items = orderby_clause->items();
+		for (auto item = items.cbegin(); item != items.cend(); ++item)
+		{
+			if (item != items.cbegin())
+			{
+				sql += U(", ");
+			}
+			sql += translate_value(item->first) + (item->second ? U(" ASC") : U(" DESC"));
+		}
+	}
+
+	string_t top;
+	string_t skip;
+	if (uri->top().has_value())
+	{
+		top = add_parameter(odata_primitive_value::make_primitive_value(uri->top().value()));
+	}
+	if (uri->skip().has_value())
+	{
+		skip = add_parameter(odata_primitive_value::make_primitive_value(uri->skip().value()));
+	}
+	m_dialect->append_paging(sql, top, skip, has_orderby);
+
+	return std::make_shared<odata_sql_statement>(sql, std::move(m_parameters));
+}
+
+std::shared_ptr<odata_sql_statement> odata_sql_translator::translate_count(std::shared_ptr<::odata::core::odata_uri> uri)
+{
+	reset();
+	auto root = m_scopes[0];
+
+	string_t sql = U("SELECT COUNT(*) FROM ") + m_dialect->quote_identifier(m_mapping->table_name()) + U(" AS ") + root.alias;
+	sql += translate_where(uri);
+
+	return std::make_shared<odata_sql_statement>(sql, std::move(m_parameters));
+}
+
+std::shared_ptr<odata_sql_statement> odata_sql_translator::translate_filter(std::shared_ptr<::odata::core::odata_query_node> expression)
+{
+	reset();
+
+	auto sql = translate_predicate(expression);
+
+	return std::make_shared<odata_sql_statement>(sql, std::move(m_parameters));
+}
+
+odata_sql_translator::scope odata_sql_translator::resolve_path(
+	std::shared_ptr<::odata::core::odata_query_node> node,
+	std::vector<::odata::utility::string_t>& segments,
+	::size_t& next,
+	bool stop_before_collection,
+	std::vector<::odata::utility::string_t>& from,
+	std::vector<::odata::utility::string_t>& conditions)
+{
+	// Collect the segments down to the root; type casts do not change the table.
+	string_t range_variable;
+	for (auto current = node; current; )
+	{
+		if (current->node_kind() == odata_query_node_kind::PropertyAccess)
+		{
+			auto property_access = current->as<odata_property_access_node>();
+			segments.insert(segments.begin(), property_access->property_name());
+			current = property_access->parent();
+		}
+		else if (current->node_kind() == odata_query_node_kind::TypeCast)
+		{
+			current = current->as<odata_type_cast_node>()->parent();
+		}
+		else if (current->node_kind() == odata_query_node_kind::RangeVariable)
+		{
+			range_variable = current->as<odata_range_variable_node>()->name();
+			break;
+		}
+		else
+		{
+			throw odata_exception(U("Unsupported property path in SQL translation."));
+		}
+	}
+
+	// Unqualified paths and $it refer to the root, lambda parameters to their own scope.
+	scope current = m_scopes[0];
+	if (!range_variable.empty())
+	{
+		auto found = std::find_if(m_scopes.rbegin(), m_scopes.rend(), [&](const scope& s) { return s.range_variable == range_variable; });
+		if (found != m_scopes.rend())
+		{
+			current = *found;
+		}
+	}
+
+	for (next = 0; next < segments.size(); next++)
+	{
+		auto navigation = current.mapping->find_navigation(segments[next]);
+		if (!navigation)
+		{
+			break;
+		}
+
+		if (navigation->is_collection && stop_before_collection)
+		{
+			break;
+		}
+
+		if (navigation->is_collection && next + 1 < segments.size())
+		{
+			throw odata_exception(U("Collection navigation ") + segments[next] + U(" can only be used with any or all."));
+		}
+
+		scope target;
+		target.alias = new_alias();
+		target.mapping = navigation->target.lock();
+		if (!target.mapping)
+		{
+			throw odata_exception(U("Mapping of navigation property ") + segments[next] + U(" has expired."));
+		}
+		from.push_back(m_dialect->quote_identifier(target.mapping->table_name()) + U(" AS ") + target.alias);
+		conditions.push_back(target.alias + U(".") + m_dialect->quote_identifier(navigation->target_column)
+			+ U(" = ") + current.alias + U(".") + m_dialect->quote_identifier(navigation->source_column));
+		current = target;
+	}
+
+	return current;
+}
+
+string_t odata_sql_translator::visit(std::shared_ptr<::odata::core::odata_constant_node> node)
+{
+	if (!node->value())
+	{
+		return U("NULL");
+	}
+
+	return add_parameter(node->value());
+}
+
+string_t odata_sql_translator::visit(std::shared_ptr<::odata::core::odata_binary_operator_node> node)
+{
+	auto left = node->left();
+	auto right = node->right();
+	auto kind = node->operator_kind();
+
+	if (kind == binary_operator_kind::Or || kind == binary_operator_kind::And)
+	{
+		// Translate in order so that placeholders are numbered left to right.
+		auto l = translate_predicate(left);
+		auto r = translate_predicate(right);
+		return U("(") + l + (kind == binary_operator_kind::Or ? U(" OR ") : U(" AND ")) + r + U(")");
+	}
+
+	if (kind == binary_operator_kind::Equal || kind == binary_operator_kind::NotEqual)
+	{
+		bool equal = kind == binary_operator_kind::Equal;
+		if (is_null_constant(left) || is_null_constant(right))
+		{
+			auto operand = is_null_constant(left) ? right : left;
+			if (is_null_constant(operand))
+			{
+				return equal ? U("(1 = 1)") : U("(1 = 0)");
+			}
+			return U("(") + translate_value(operand) + (equal ? U(" IS NULL)") : U(" IS NOT NULL)"));
+		}
+
+		auto l = translate_value(left);
+		auto r = translate_value(right);
+		if (equal && (is_constant(left) || is_constant(right)))
+		{
+			// A non-null constant never equals null, the plain comparison is already null-safe.
+			return U("(") + l + U(" = ") + r + U(")");
+		}
+
+		return equal ? m_dialect->not_distinct(l, r) : m_dialect->distinct(l, r);
+	}
+
+	if (kind == binary_operator_kind::Has)
+	{
+		// Enum columns hold the underlying integer, the flags are all set when masking keeps every one of them.
+		// The flag value binds once and its placeholder is repeated, a null operand leaves the predicate false.
+		if (is_null_constant(right))
+		{
+			throw odata_exception(U("Operator has needs the integer value of the flags to be translated to SQL."));
+		}
+
+		auto l = translate_value(left);
+		auto r = translate_value(right);
+		return U("((") + l + U(" & ") + r + U(") = ") + r + U(")");
+	}
+
+	const ::odata::utility::char_t *sql_operator;
+	switch (kind)
+	{
+	case binary_operator_kind::GreaterThan:
+		sql_operator = U(" > ");
+		break;
+	case binary_operator_kind::GreaterThanOrEqual:
+		sql_operator = U(" >= ");
+		break;
+	case binary_operator_kind::LessThan:
+		sql_operator = U(" < ");
+		break;
+	case binary_operator_kind::LessThanOrEqual:
+		sql_operator = U(" <= ");
+		break;
+	case binary_operator_kind::Add:
+		sql_operator = U(" + ");
+		break;
+	case binary_operator_kind::Sub:
+		sql_operator = U(" - ");
+		break;
+	case binary_operator_kind::Multiply:
+		sql_operator = U(" * ");
+		break;
+	case binary_operator_kind::Divide:
+		sql_operator = U(" / ");
+		break;
+	case binary_operator_kind::Modulo:
+		sql_operator = U(" % ");
+		break;
+	default:
+		throw odata_exception(U("Operator ") + operator_name(kind) + U(" cannot be translated to SQL."));
+	}
+
+	auto l = translate_value(left);
+	auto r = translate_value(right);
+	return U("(") + l + sql_operator + r + U(")");
+}
+
+string_t odata_sql_translator::visit(std::shared_ptr<::odata::core::odata_unary_operator_node> node)
+{
+	if (node->operator_kind() == unary_operator_kind::Negate)
+	{
+		return U("(-") + translate_value(node->operand()) + U(")");
+	}
+
+	auto operand = node->operand();
+	if (!is_predicate(operand))
+	{
+		// not of a null boolean value stays null.
+		return m_dialect->is_false(translate_value(operand));
+	}
+
+	// A comparison with null is false in OData but unknown in SQL; treat unknown as false before negating.
+	return U("(CASE WHEN ") + translate_value(operand) + U(" THEN 0 ELSE 1 END = 1)");
+}
+
+string_t odata_sql_translator::visit(std::shared_ptr<::odata::core::odata_parameter_alias_node> node)
+{
+	throw odata_exception(U("Parameter alias ") + node->alias() + U(" cannot be translated to SQL."));
+}
+
+string_t odata_sql_translator::visit(std::shared_ptr<::odata::core::odata_property_access_node> node)
+{
+	std::vector<string_t> segments;
+	std::vector<string_t> from;
+	std::vector<string_t> conditions;
+	size_t next = 0;
+
+	auto target = resolve_path(node, segments, next, false, from, conditions);
+	if (next >= segments.size())
+	{
+		throw odata_exception(U("Navigation property ") + segments.back() + U(" cannot be used as a value."));
+	}
+
+	string_t path;
+	for (size_t i = next; i < segments.size(); i++)
+	{
+		path += (i > next ? U("/") : U("")) + segments[i];
+	}
+
+	auto column = target.alias + U(".") + m_dialect->quote_identifier(target.mapping->column(path));
+	if (from.empty())
+	{
+		return column;
+	}
+
+	// Single-valued navigations are read through a correlated scalar subquery.
+	string_t sql = U("(SELECT ") + column + U(" FROM ");
+	for (size_t i = 0; i < from.size(); i++)
+	{
+		sql += (i > 0 ? U(", ") : U("")) + from[i];
+	}
+	sql += U(" WHERE ");
+	for (size_t i = 0; i < conditions.size(); i++)
+	{
+		sql += (i > 0 ? U(" AND ") : U("")) + conditions[i];
+	}
+	sql += U(")");
+
+	return sql;
+}
+
+string_t odata_sql_translator::visit(std::shared_ptr<::odata::core::odata_type_cast_node> node)
+{
+	// A trailing type cast does not change the value.
+	return translate_value(node->parent());
+}
+
+string_t odata_sql_translator::visit(std::shared_ptr<::odata::core::odata_lambda_node> node)
+{
+	std::vector<string_t> segments;
+	std::vector<string_t> from;
+	std::vector<string_t> conditions;
+	size_t next = 0;
+
+	auto owner = resolve_path(node->parent(), segments, next, true, from, conditions);
+	if (next + 1 != segments.size() || !owner.mapping->find_navigation(segments[next]))
+	{
+		throw odata_exception(U("any and all are only supported on collection navigation properties."));
+	}
+
+	auto navigation = owner.mapping->find_navigation(segments[next]);
+
+	scope element;
+	element.range_variable = node->parameter();
+	element.alias = new_alias();
+	element.mapping = navigation->target.lock();
+	if (!element.mapping)
+	{
+		throw odata_exception(U("Mapping of navigation property ") + segments[next] + U(" has expired."));
+	}
+	from.push_back(m_dialect->quote_identifier(element.mapping->table_name()) + U(" AS ") + element.alias);
+	conditions.push_back(element.alias + U(".") + m_dialect->quote_identifier(navigation->target_column)
+		+ U(" = ") + owner.alias + U(".") + m_dialect->quote_identifier(navigation->source_column));
+
+	if (node->expression())
+	{
+		m_scopes.push_back(element);
+		auto predicate = translate_predicate(node->expression());
+		m_scopes.pop_back();
+
+		// all(p) holds when no element fails p; an unknown p counts as a failure.
+		conditions.push_back(node->is_any() ? predicate : U("(CASE WHEN ") + predicate + U(" THEN 1 ELSE 0 END = 0)"));
+	}
+	else if (!node->is_any())
+	{
+		return U("(1 = 1)");
+	}
+
+	string_t sql = node->is_any() ? U("EXISTS (SELECT 1 FROM ") : U("NOT EXISTS (SELECT 1 FROM ");
+	for (size_t i = 0; i < from.size(); i++)
+	{
+		sql += (i > 0 ? U(", ") : U("")) + from[i];
+	}
+	sql += U(" WHERE ");
+	for (size_t i = 0; i < conditions.size(); i++)
+	{
+		sql += (i > 0 ? U(" AND ") : U("")) + conditions[i];
+	}
+	sql += U(")");
+
+	return sql;
+}
+
+string_t odata_sql_translator::visit(std::shared_ptr<::odata::core::odata_range_variable_node> node)
+{
+	throw odata_exception(U("Range variable ") + node->name() + U(" cannot be used as a value in SQL."));
+}
+
+string_t odata_sql_translator::visit(std::shared_ptr<::odata::core::odata_function_call_node> node)
+{
+	std::vector<string_t> arguments;
+	const auto &parameters = node->parameters();
+	for (auto parameter = parameters.cbegin(); parameter != parameters.cend(); ++parameter)
+	{
+		arguments.push_back(translate_value(parameter->second));
+	}
+
+	return m_dialect->function_call(node->name(), arguments);
+}
+
+string_t odata_sql_translator::visit_any(std::shared_ptr<::odata::core::odata_query_node> node)
+{
+	throw odata_exception(U("Unsupported node kind in SQL translation."));
+}
+
+// --END-- odata_sql_translator
+
+}}
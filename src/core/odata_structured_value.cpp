@@ -23,11 +23,11 @@ void odata_structured_value::set_value(const ::odata::utility::string_t& propert
 	std::shared_ptr<odata_value> property_value;
 	if (get_property_value(property_name, property_value))
 	{
-		std::shared_ptr<edm_named_type> property_type = property_value->get_value_type();
+		auto property_type = property_value->get_value_type_pointer();
 		if (property_type && (property_type->get_type_kind() == edm_type_kind_t::Primitive))
 		{
 			setted = true;
-			m_properties[property_name] = std::make_shared<odata_primitive_value>(std::dynamic_pointer_cast<edm_primitive_type>(property_type), string_value);
+			m_properties[property_name] = std::make_shared<odata_primitive_value>(std::dynamic_pointer_cast<edm_primitive_type>(property_value->get_value_type()), string_value);
 		}
 	}
 		
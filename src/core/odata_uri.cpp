@@ -17,7 +17,8 @@ std::shared_ptr<odata_uri> odata_uri::create_uri(
 	std::shared_ptr<::odata::core::odata_search_clause> search_clause,
 	::odata::common::nullable<int64_t> top,
 	::odata::common::nullable<int64_t> skip,
-	::odata::common::nullable<bool> count)
+	::odata::common::nullable<bool> count,
+	std::shared_ptr<::odata::core::odata_apply_clause> apply_clause)
 {
 	return std::shared_ptr<odata_uri>(new odata_uri(
 		path,
@@ -27,7 +28,8 @@ std::shared_ptr<odata_uri> odata_uri::create_uri(
 		search_clause,
 		top,
 		skip,
-		count));
+		count,
+		apply_clause));
 }
 
 }}
\ No newline at end of file
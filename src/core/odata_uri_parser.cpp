@@ -5,6 +5,7 @@
 //---------------------------------------------------------------------
 
 #include "odata/core/odata_uri_parser.h"
+#include "odata/core/odata_metrics.h"
 
 #define ERROR_MESSAGE_NOT_RELATIVE_URI() (U("not relative uri"))
 #define ERROR_MESSAGE_UNSUPPORTED_SEGMENT(IDENTIFIER) ((IDENTIFIER) + U(" unsupported"))
@@ -39,6 +40,10 @@
 #define ERROR_MESSAGE_FILTER_ON_NONCOLLECTION() (U("$filter on non-collection resource"))
 #define ERROR_MESSAGE_ORDERBY_ON_NONCOLLECTION() (U("$orderby on non-collection resource"))
 #define ERROR_MESSAGE_SELECT_OR_EXPAND_ON_NONSTRUCTURED_TYPE() (U("$select or $expand on non-structured type"))
+#define ERROR_MESSAGE_APPLY_ON_NONCOLLECTION() (U("$apply on non-collection resource"))
+#define ERROR_MESSAGE_QUERY_OPTION_WITHOUT_TARGET(NAME) (::odata::utility::string_t(NAME) + U(" requires a target type, bind it against a path"))
+#define ERROR_MESSAGE_UNSUPPORTED_TRANSFORMATION(NAME) (U("transformation ") + (NAME) + U(" unsupported"))
+#define ERROR_MESSAGE_UNSUPPORTED_AGGREGATE_METHOD(NAME) (U("aggregate method ") + (NAME) + U(" unsupported"))
 
 static const ::odata::utility::string_t SegmentIdentifierMetadata = U("$metadata");
 static const ::odata::utility::string_t SegmentIdentifierBatch = U("$batch");
@@ -57,6 +62,8 @@ static const ::odata::utility::string_t QueryOptionSearch = U("$search");
 static const ::odata::utility::string_t QueryOptionTop = U("$top");
 static const ::odata::utility::string_t QueryOptionSkip = U("$skip");
 static const ::odata::utility::string_t QueryOptionCount = U("$count");
+static const ::odata::utility::string_t QueryOptionApply = U("$apply");
+static const ::odata::utility::string_t QueryOptionDeltaToken = U("$deltatoken");
 
 static const ::odata::utility::string_t KeywordTrue = U("true");
 static const ::odata::utility::string_t KeywordFalse = U("false");
@@ -80,6 +87,21 @@ static const ::odata::utility::string_t KeywordAll = U("all");
 static const ::odata::utility::string_t KeywordAny = U("any");
 static const ::odata::utility::string_t KeywordAsc = U("asc");
 static const ::odata::utility::string_t KeywordDesc = U("desc");
+static const ::odata::utility::string_t KeywordWith = U("with");
+static const ::odata::utility::string_t KeywordAs = U("as");
+
+static const ::odata::utility::string_t TransformationAggregate = U("aggregate");
+static const ::odata::utility::string_t TransformationGroupBy = U("groupby");
+static const ::odata::utility::string_t TransformationFilter = U("filter");
+static const ::odata::utility::string_t TransformationCompute = U("compute");
+static const ::odata::utility::string_t TransformationTopCount = U("topcount");
+static const ::odata::utility::string_t TransformationBottomCount = U("bottomcount");
+
+static const ::odata::utility::string_t AggregateMethodSum = U("sum");
+static const ::odata::utility::string_t AggregateMethodMin = U("min");
+static const ::odata::utility::string_t AggregateMethodMax = U("max");
+static const ::odata::utility::string_t AggregateMethodAverage = U("average");
+static const ::odata::utility::string_t AggregateMethodCountDistinct = U("countdistinct");
 
 static const ::odata::utility::string_t TokenNone = U("");
 static const ::odata::utility::string_t TokenLeftParen = U("(");
@@ -125,6 +147,7 @@ void odata_path_parser::validate_is_nonempty_relative_uri(const ::odata::utility
 
 std::shared_ptr<::odata::core::odata_path> odata_path_parser::parse_path(const ::odata::utility::string_t& path)
 {
+	odata_stage_timer timer(PathBind);
 	validate_is_nonempty_relative_uri(path);
 
 	auto raw_segments = ::odata::utility::uri::split_path(path);
@@ -265,15 +288,23 @@ void odata_path_parser::bind_first_segment(const ::odata::utility::string_t &seg
 	{
 		throw odata_exception(ERROR_MESSAGE_UNSUPPORTED_SEGMENT(identifier));
 	}
-	else if (try_bind_as_navigation_source(identifier, parenthesis_exp))
-	{
-		return;
-	}
-	else if (try_bind_as_operation_import(identifier, parenthesis_exp))
+
+	// Entity sets, singletons and operation imports share one symbol table, so a single probe finds any of them.
+	auto container = model()->find_container();
+	auto symbol = container ? container->find_symbol(identifier) : nullptr;
+	if (symbol != nullptr)
 	{
-		return;
+		if (try_bind_as_navigation_source(*symbol, identifier, parenthesis_exp))
+		{
+			return;
+		}
+
+		if (try_bind_as_operation_import(*symbol, identifier, parenthesis_exp))
+		{
+			return;
+		}
 	}
-	
+
 	throw odata_exception(ERROR_MESSAGE_RESOURCE_NOT_FOUND(identifier));
 }
 
@@ -298,7 +329,22 @@ void odata_path_parser::bind_next_segment(const ::odata::utility::string_t &segm
         return;
     }
     
-    if (try_bind_as_declared_property(identifier, parenthesis_exp))
+    // A frozen model has a symbol table per structured type that finds declared properties and bound operations
+    // with one probe; a miss there means neither exists, so only unfrozen models search property by property.
+    auto previous_type = target_type();
+    auto owning_type = previous_type ? ::odata::edm::edm_model_utility::get_structured_type(previous_type) : nullptr;
+    bool has_symbols = owning_type != nullptr && model()->is_frozen();
+    auto symbol = has_symbols ? owning_type->find_symbol(identifier) : nullptr;
+
+    if (has_symbols)
+    {
+        if (symbol != nullptr && symbol->property != nullptr)
+        {
+            bind_as_declared_property(owning_type, symbol->property, identifier, parenthesis_exp);
+            return;
+        }
+    }
+    else if (try_bind_as_declared_property(identifier, parenthesis_exp))
     {
         return;
     }
@@ -307,7 +353,19 @@ void odata_path_parser::bind_next_segment(const ::odata::utility::string_t &segm
     {
         return;
     }
+
+    if (symbol != nullptr)
+    {
+        bool is_collection = previous_type->get_type_kind() == ::odata::edm::edm_type_kind_t::Collection;
+        const auto &operation = is_collection ? symbol->collection_operation : symbol->operation;
+        if (operation != nullptr)
+        {
+            bind_as_operation(operation, parenthesis_exp);
+            return;
+        }
+    }
     
+    // Also reports unbound operations and binding type mismatches.
     if (try_bind_as_operation(identifier, parenthesis_exp))
     {
         return;
@@ -316,15 +374,9 @@ void odata_path_parser::bind_next_segment(const ::odata::utility::string_t &segm
     bind_as_dynamic_property(identifier, parenthesis_exp);
 }
 
-bool odata_path_parser::try_bind_as_navigation_source(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &key_exp)
+bool odata_path_parser::try_bind_as_navigation_source(const ::odata::edm::edm_container_symbol &symbol, const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &key_exp)
 {
-	auto container = model()->find_container();
-	if (container == nullptr)
-	{
-		return false;
-	}
-
-	auto entity_set = container->find_entity_set(identifier);
+	const auto &entity_set = symbol.entity_set;
 	if (entity_set != nullptr)
 	{
 		auto entity_set_segment = odata_path_segment::create_entity_set_segment(entity_set);
@@ -336,7 +388,7 @@ bool odata_path_parser::try_bind_as_navigation_source(const ::odata::utility::st
 	}
 	else
 	{
-		auto singleton = container->find_singleton(identifier);
+		const auto &singleton = symbol.singleton;
 		if (singleton != nullptr)
 		{
 			auto singleton_segment = odata_path_segment::create_singleton_segment(singleton);
@@ -502,7 +554,7 @@ void odata_path_parser::bind_as_key(const ::odata::utility::string_t &key_exp)
 	auto target_entity_type = ::odata::edm::edm_model_utility::get_entity_type(target_type());
     
     auto keys = parse_named_values(key_exp);
-	auto keys_from_model = target_entity_type->get_key_with_parents();
+	const auto &keys_from_model = target_entity_type->get_key_with_parents();
 	if (keys_from_model.size() != keys.size())
 	{
 		throw odata_exception(ERROR_MESSAGE_KEY_COUNT_MISMATCH());
@@ -597,7 +649,14 @@ bool odata_path_parser::try_bind_as_declared_property(const ::odata::utility::st
         // Property not declared.
         return false;
     }
-    
+
+    bind_as_declared_property(owning_type, property, identifier, key_exp);
+    return true;
+}
+
+void odata_path_parser::bind_as_declared_property(const std::shared_ptr<::odata::edm::edm_structured_type> &owning_type, const std::shared_ptr<::odata::edm::edm_property_type> &property,
+    const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &key_exp)
+{
     if (property->get_property_type()->get_type_kind() == ::odata::edm::edm_type_kind_t::Navigation)
     {
         // Navigation property should have binded navigation source.
@@ -628,22 +687,15 @@ bool odata_path_parser::try_bind_as_declared_property(const ::odata::utility::st
             throw odata_exception(ERROR_MESSAGE_UNEXPECTED_PARENTHESIS_EXPRESSION(identifier));
         }
     }
-    
-    return true;
 }
 
 bool odata_path_parser::try_bind_as_type(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &empty_exp)
 {
-    std::shared_ptr<::odata::edm::edm_named_type> type = model()->find_entity_type(identifier);
+    std::shared_ptr<::odata::edm::edm_named_type> type = model()->find_structured_type(identifier);
     if (type == nullptr)
     {
-        type = model()->find_complex_type(identifier);
-        
-        if (type == nullptr)
-        {
-            // Not a type segment.
-            return false;
-        }
+        // Not a type segment.
+        return false;
     }
     
     if (!empty_exp.empty())
@@ -684,15 +736,9 @@ void odata_path_parser::validate_parameters_match(
 	}
 }
 
-bool odata_path_parser::try_bind_as_operation_import(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &parameters_exp)
+bool odata_path_parser::try_bind_as_operation_import(const ::odata::edm::edm_container_symbol &symbol, const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &parameters_exp)
 {
-	auto container = model()->find_container();
-	if (container == nullptr)
-	{
-		return false;
-	}
-
-	auto operation_import = container->find_operation_import(identifier);
+	const auto &operation_import = symbol.operation_import;
 	if (operation_import == nullptr)
 	{
 		// Operation import not found.
@@ -730,8 +776,7 @@ bool odata_path_parser::try_bind_as_operation(const ::odata::utility::string_t &
 		throw odata_exception(ERROR_MESSAGE_UNBOUND_OPERATION_FOUND(identifier));
 	}
 
-	auto parameters = parse_named_values(parameters_exp);
-	auto parameters_from_model = operation->get_operation_parameters();
+	const auto &parameters_from_model = operation->get_operation_parameters();
 
 	// Validate the binding parameter.
 	if (parameters_from_model.size() < 1)
@@ -747,12 +792,18 @@ bool odata_path_parser::try_bind_as_operation(const ::odata::utility::string_t &
 		throw odata_exception(ERROR_MESSAGE_BINDING_TYPE_MISMATCH(identifier));
 	}
 
-	// Validate the remaining parameters.
-	validate_parameters_match(parameters, parameters_from_model, /*has_binding_parameter*/true);
+	bind_as_operation(operation, parameters_exp);
+	return true;
+}
+
+void odata_path_parser::bind_as_operation(const std::shared_ptr<::odata::edm::edm_operation_type> &operation, const ::odata::utility::string_t &parameters_exp)
+{
+	auto parameters = parse_named_values(parameters_exp);
+
+	// Validate the parameters other than the binding parameter.
+	validate_parameters_match(parameters, operation->get_operation_parameters(), /*has_binding_parameter*/true);
 
 	m_bound_segments.push_back(odata_path_segment::create_operation_segment(operation, std::move(parameters)));
-    
-	return true;
 }
 
 void odata_path_parser::bind_as_dynamic_property(const ::odata::utility::string_t &identifier, const ::odata::utility::string_t &empty_exp)
@@ -845,6 +896,11 @@ std::shared_ptr<::odata::core::odata_select_expand_clause> odata_query_option_pa
         return null_value;
     }
     
+	if (!target_type())
+	{
+		throw odata_exception(ERROR_MESSAGE_QUERY_OPTION_WITHOUT_TARGET(U("$select or $expand")));
+	}
+
 	// Should be EntityType, ComplexType, Collection(EntityType) or Collection(ComplexType).
 	if (::odata::edm::edm_model_utility::get_structured_type(target_type()) == nullptr)
     {
@@ -868,6 +924,11 @@ std::shared_ptr<::odata::core::odata_filter_clause> odata_query_option_parser::p
         return null_value;
     }
 
+	if (!target_type())
+	{
+		throw odata_exception(ERROR_MESSAGE_QUERY_OPTION_WITHOUT_TARGET(QueryOptionFilter));
+	}
+
 	if (target_type()->get_type_kind() != ::odata::edm::edm_type_kind_t::Collection)
 	{
 		throw odata_exception(ERROR_MESSAGE_FILTER_ON_NONCOLLECTION());
@@ -887,6 +948,11 @@ std::shared_ptr<::odata::core::odata_orderby_clause> odata_query_option_parser::
         return null_value;
     }
 
+	if (!target_type())
+	{
+		throw odata_exception(ERROR_MESSAGE_QUERY_OPTION_WITHOUT_TARGET(QueryOptionOrderBy));
+	}
+
 	if (target_type()->get_type_kind() != ::odata::edm::edm_type_kind_t::Collection)
 	{
 		throw odata_exception(ERROR_MESSAGE_ORDERBY_ON_NONCOLLECTION());
@@ -979,6 +1045,215 @@ std::shared_ptr<::odata::core::odata_search_clause> odata_query_option_parser::p
 	}
 }
 
+std::shared_ptr<::odata::core::odata_apply_clause> odata_query_option_parser::parse_apply(const ::odata::utility::string_t& apply_query)
+{
+	if (apply_query.empty())
+	{
+		return null_value;
+	}
+
+	if (!target_type())
+	{
+		throw odata_exception(ERROR_MESSAGE_QUERY_OPTION_WITHOUT_TARGET(QueryOptionApply));
+	}
+
+	if (target_type()->get_type_kind() != ::odata::edm::edm_type_kind_t::Collection)
+	{
+		throw odata_exception(ERROR_MESSAGE_APPLY_ON_NONCOLLECTION());
+	}
+
+	auto lexer = odata_expression_lexer::create_lexer(apply_query);
+
+	auto transformations = parse_apply_transformations(lexer);
+
+	if (lexer->current_token()->token_kind() != odata_expression_token_kind::End)
+	{
+		throw odata_exception(ERROR_MESSAGE_UNEXPECTED_TOKEN(lexer->current_token()->text()));
+	}
+
+	return std::make_shared<::odata::core::odata_apply_clause>(std::move(transformations));
+}
+
+std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>> odata_query_option_parser::parse_apply_transformations(
+	std::shared_ptr<odata_expression_lexer> lexer)
+{
+	std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>> transformations;
+
+	transformations.push_back(parse_apply_transformation(lexer));
+
+	while (lexer->current_token()->token_kind() == odata_expression_token_kind::Slash)
+	{
+		// Skip '/'
+		lexer->next_token();
+
+		transformations.push_back(parse_apply_transformation(lexer));
+	}
+
+	return transformations;
+}
+
+std::shared_ptr<::odata::core::odata_apply_transformation> odata_query_option_parser::parse_apply_transformation(
+	std::shared_ptr<odata_expression_lexer> lexer)
+{
+	auto name = lexer->eat_identifier();
+
+	lexer->eat_token(odata_expression_token_kind::LeftParen, TokenLeftParen);
+
+	std::shared_ptr<::odata::core::odata_apply_transformation> transformation;
+
+	if (name == TransformationAggregate)
+	{
+		std::vector<std::shared_ptr<::odata::core::odata_aggregate_expression>> expressions;
+
+		expressions.push_back(parse_aggregate_expression(lexer));
+		while (lexer->current_token()->token_kind() == odata_expression_token_kind::Comma)
+		{
+			lexer->next_token();
+			expressions.push_back(parse_aggregate_expression(lexer));
+		}
+
+		transformation = std::make_shared<::odata::core::odata_aggregate_transformation>(std::move(expressions));
+	}
+	else if (name == TransformationGroupBy)
+	{
+		std::vector<std::shared_ptr<::odata::core::odata_query_node>> group_properties;
+		std::vector<std::shared_ptr<::odata::core::odata_apply_transformation>> transformations;
+
+		// groupby((path, ...)[, transformations])
+		lexer->eat_token(odata_expression_token_kind::LeftParen, TokenLeftParen);
+
+		group_properties.push_back(odata_expression_parser::parse_expression(lexer));
+		while (lexer->current_token()->token_kind() == odata_expression_token_kind::Comma)
+		{
+			lexer->next_token();
+			group_properties.push_back(odata_expression_parser::parse_expression(lexer));
+		}
+
+		lexer->eat_token(odata_expression_token_kind::RightParen, TokenRightParen);
+
+		if (lexer->current_token()->token_kind() == odata_expression_token_kind::Comma)
+		{
+			lexer->next_token();
+			transformations = parse_apply_transformations(lexer);
+		}
+
+		transformation = std::make_shared<::odata::core::odata_groupby_transformation>(std::move(group_properties), std::move(transformations));
+	}
+	else if (name == TransformationFilter)
+	{
+		auto expression = odata_expression_parser::parse_expression(lexer, odata_expression_parser_subject::FilterClause);
+
+		transformation = std::make_shared<::odata::core::odata_filter_transformation>(expression);
+	}
+	else if (name == TransformationCompute)
+	{
+		std::vector<std::shared_ptr<::odata::core::odata_compute_expression>> expressions;
+
+		do
+		{
+			if (!expressions.empty())
+			{
+				// Skip comma.
+				lexer->next_token();
+			}
+
+			auto expression = odata_expression_parser::parse_expression(lexer);
+
+			if (!lexer->current_token()->is_identifier(KeywordAs))
+			{
+				throw odata_exception(ERROR_MESSAGE_TOKEN_KIND_EXPECTED(KeywordAs));
+			}
+			lexer->next_token();
+
+			expressions.push_back(std::make_shared<::odata::core::odata_compute_expression>(expression, lexer->eat_identifier()));
+		}
+		while (lexer->current_token()->token_kind() == odata_expression_token_kind::Comma);
+
+		transformation = std::make_shared<::odata::core::odata_compute_transformation>(std::move(expressions));
+	}
+	else if (name == TransformationTopCount || name == TransformationBottomCount)
+	{
+		auto count_kind = lexer->current_token()->token_kind();
+		if (count_kind != odata_expression_token_kind::Int32Literal && count_kind != odata_expression_token_kind::Int64Literal)
+		{
+			throw odata_exception(ERROR_MESSAGE_INVALID_VALUE(lexer->current_token()->text()));
+		}
+
+		auto n = lexer->eat_literal()->as<int64_t>();
+
+		lexer->eat_token(odata_expression_token_kind::Comma, TokenComma);
+
+		auto expression = odata_expression_parser::parse_expression(lexer);
+
+		transformation = std::make_shared<::odata::core::odata_topcount_transformation>(name == TransformationTopCount, n, expression);
+	}
+	else
+	{
+		throw odata_exception(ERROR_MESSAGE_UNSUPPORTED_TRANSFORMATION(name));
+	}
+
+	lexer->eat_token(odata_expression_token_kind::RightParen, TokenRightParen);
+
+	return transformation;
+}
+
+std::shared_ptr<::odata::core::odata_aggregate_expression> odata_query_option_parser::parse_aggregate_expression(
+	std::shared_ptr<odata_expression_lexer> lexer)
+{
+	std::shared_ptr<::odata::core::odata_query_node> expression;
+	int method = odata_aggregate_method::Count;
+
+	if (lexer->current_token()->is_identifier(QueryOptionCount))
+	{
+		// $count as alias
+		lexer->next_token();
+	}
+	else
+	{
+		expression = odata_expression_parser::parse_expression(lexer);
+
+		if (!lexer->current_token()->is_identifier(KeywordWith))
+		{
+			throw odata_exception(ERROR_MESSAGE_TOKEN_KIND_EXPECTED(KeywordWith));
+		}
+		lexer->next_token();
+
+		auto method_name = lexer->eat_identifier();
+		if (method_name == AggregateMethodSum)
+		{
+			method = odata_aggregate_method::Sum;
+		}
+		else if (method_name == AggregateMethodMin)
+		{
+			method = odata_aggregate_method::Min;
+		}
+		else if (method_name == AggregateMethodMax)
+		{
+			method = odata_aggregate_method::Max;
+		}
+		else if (method_name == AggregateMethodAverage)
+		{
+			method = odata_aggregate_method::Average;
+		}
+		else if (method_name == AggregateMethodCountDistinct)
+		{
+			method = odata_aggregate_method::CountDistinct;
+		}
+		else
+		{
+			throw odata_exception(ERROR_MESSAGE_UNSUPPORTED_AGGREGATE_METHOD(method_name));
+		}
+	}
+
+	if (!lexer->current_token()->is_identifier(KeywordAs))
+	{
+		throw odata_exception(ERROR_MESSAGE_TOKEN_KIND_EXPECTED(KeywordAs));
+	}
+	lexer->next_token();
+
+	return std::make_shared<::odata::core::odata_aggregate_expression>(expression, method, lexer->eat_identifier());
+}
+
 std::shared_ptr<odata_range_variable> odata_query_option_parser::create_implicit_range_variable() const
 {
     auto _target_type = ::odata::edm::edm_model_utility::get_collection_element_type(target_type());
@@ -1162,6 +1437,21 @@ std::shared_ptr<::odata::core::odata_primitive_value> odata_expression_token::to
 	case odata_expression_token_kind::Int32Literal:
 		return std::make_shared<odata_primitive_value>(::odata::edm::edm_primitive_type::INT32(), m_text);
 
+	case odata_expression_token_kind::Int64Literal:
+		return std::make_shared<odata_primitive_value>(::odata::edm::edm_primitive_type::INT64(), m_text);
+
+	case odata_expression_token_kind::DecimalLiteral:
+		return std::make_shared<odata_primitive_value>(::odata::edm::edm_primitive_type::DECIMAL(), m_text);
+
+	case odata_expression_token_kind::SingleLiteral:
+		return std::make_shared<odata_primitive_value>(::odata::edm::edm_primitive_type::SINGLE(), m_text);
+
+	case odata_expression_token_kind::DateTimeOffsetLiteral:
+		return std::make_shared<odata_primitive_value>(::odata::edm::edm_primitive_type::DATETIMEOFFSET(), m_text);
+
+	case odata_expression_token_kind::GuidLiteral:
+		return std::make_shared<odata_primitive_value>(::odata::edm::edm_primitive_type::GUID(), m_text);
+
 	case odata_expression_token_kind::StringLiteral:
 		if (m_text.size() > 1)
 		{
@@ -1291,6 +1581,12 @@ void odata_expression_lexer::next_token()
 
 	if (is_valid_start_of_identifier())
 	{
+		if (current_char() == U('$') || current_char() == U('_'))
+		{
+			// Leading char of names like $it or $count.
+			next_char();
+		}
+
 		scan_identifier();
 
 		if (current_char() == U('-'))
@@ -1428,6 +1724,9 @@ std::shared_ptr<::odata::core::odata_primitive_value> odata_expression_lexer::ea
 {
 	eat_token(odata_expression_token_kind::LeftParen, TokenLeftParen);
 
+	// Rewind over the token scanned after '(', the text is taken raw.
+	m_pos = current_token()->position();
+
 	::odata::utility::string_t text;
 	auto start = m_pos;
 
@@ -2126,6 +2425,13 @@ std::shared_ptr<::odata::core::odata_query_node> odata_expression_parser::parse_
     bool is_any = identifier == KeywordAny;
     
     lexer()->eat_token(odata_expression_token_kind::LeftParen, TokenLeftParen);
+
+    if (is_any && lexer()->current_token()->token_kind() == odata_expression_token_kind::RightParen)
+    {
+        // any() without a lambda tests for a non-empty collection.
+        lexer()->next_token();
+        return odata_query_node::create_lambda_node(is_any, nullptr, ::odata::utility::string_t(), parent);
+    }
     
     auto parameter = lexer()->eat_identifier();
 
@@ -2232,52 +2538,99 @@ odata_expression_parser::parse_named_value()
 
 // --BEGIN-- odata_uri_parser
 
-std::shared_ptr<::odata::core::odata_path> odata_uri_parser::parse_path(const ::odata::utility::string_t& path)
+std::shared_ptr<::odata::core::odata_path> odata_uri_parser::parse_path(const ::odata::utility::string_t& path) const
+{
+	odata_path_parser path_parser(model());
+	return path_parser.parse_path(path);
+}
+
+std::shared_ptr<::odata::core::odata_select_expand_clause> odata_uri_parser::parse_select_and_expand(
+    const ::odata::utility::string_t& select_query, const ::odata::utility::string_t& expand_query) const
 {
-    return path_parser()->parse_path(path);
+	return unbound_query_option_parser()->parse_select_and_expand(select_query, expand_query);
 }
 
 std::shared_ptr<::odata::core::odata_select_expand_clause> odata_uri_parser::parse_select_and_expand(
-    const ::odata::utility::string_t& select_query, const ::odata::utility::string_t& expand_query)
+    const ::odata::utility::string_t& select_query, const ::odata::utility::string_t& expand_query,
+    std::shared_ptr<::odata::edm::edm_named_type> target_type,
+    std::shared_ptr<::odata::edm::edm_navigation_source> target_navigation_source) const
+{
+	odata_query_option_parser query_option_parser(model(), target_type, target_navigation_source);
+	return query_option_parser.parse_select_and_expand(select_query, expand_query);
+}
+
+std::shared_ptr<::odata::core::odata_filter_clause> odata_uri_parser::parse_filter(const ::odata::utility::string_t& filter_query) const
 {
-	return query_option_parser()->parse_select_and_expand(select_query, expand_query);
+	return unbound_query_option_parser()->parse_filter(filter_query);
 }
 
-std::shared_ptr<::odata::core::odata_filter_clause> odata_uri_parser::parse_filter(const ::odata::utility::string_t& filter_query)
+std::shared_ptr<::odata::core::odata_filter_clause> odata_uri_parser::parse_filter(
+    const ::odata::utility::string_t& filter_query,
+    std::shared_ptr<::odata::edm::edm_named_type> target_type,
+    std::shared_ptr<::odata::edm::edm_navigation_source> target_navigation_source) const
 {
-	return query_option_parser()->parse_filter(filter_query);
+	odata_query_option_parser query_option_parser(model(), target_type, target_navigation_source);
+	return query_option_parser.parse_filter(filter_query);
 }
 
 std::shared_ptr<::odata::core::odata_orderby_clause> odata_uri_parser::parse_orderby(
-    const ::odata::utility::string_t& orderby_query)
+    const ::odata::utility::string_t& orderby_query) const
+{
+	return unbound_query_option_parser()->parse_orderby(orderby_query);
+}
+
+std::shared_ptr<::odata::core::odata_orderby_clause> odata_uri_parser::parse_orderby(
+    const ::odata::utility::string_t& orderby_query,
+    std::shared_ptr<::odata::edm::edm_named_type> target_type,
+    std::shared_ptr<::odata::edm::edm_navigation_source> target_navigation_source) const
+{
+	odata_query_option_parser query_option_parser(model(), target_type, target_navigation_source);
+	return query_option_parser.parse_orderby(orderby_query);
+}
+
+std::shared_ptr<::odata::core::odata_search_clause> odata_uri_parser::parse_search(const ::odata::utility::string_t& search_query) const
+{
+	return unbound_query_option_parser()->parse_search(search_query);
+}
+
+::odata::common::nullable<int64_t> odata_uri_parser::parse_top(const ::odata::utility::string_t& top_query) const
 {
-	return query_option_parser()->parse_orderby(orderby_query);
+	return unbound_query_option_parser()->parse_top(top_query);
 }
 
-std::shared_ptr<::odata::core::odata_search_clause> odata_uri_parser::parse_search(const ::odata::utility::string_t& search_query)
+::odata::common::nullable<int64_t> odata_uri_parser::parse_skip(const ::odata::utility::string_t& skip_query) const
 {
-	return query_option_parser()->parse_search(search_query);
+	return unbound_query_option_parser()->parse_skip(skip_query);
 }
 
-::odata::common::nullable<int64_t> odata_uri_parser::parse_top(const ::odata::utility::string_t& top_query)
+::odata::common::nullable<bool> odata_uri_parser::parse_count(const ::odata::utility::string_t& count_query) const
 {
-	return query_option_parser()->parse_top(top_query);
+	return unbound_query_option_parser()->parse_count(count_query);
 }
 
-::odata::common::nullable<int64_t> odata_uri_parser::parse_skip(const ::odata::utility::string_t& skip_query)
+std::shared_ptr<::odata::core::odata_apply_clause> odata_uri_parser::parse_apply(const ::odata::utility::string_t& apply_query) const
 {
-	return query_option_parser()->parse_skip(skip_query);
+	return unbound_query_option_parser()->parse_apply(apply_query);
 }
 
-::odata::common::nullable<bool> odata_uri_parser::parse_count(const ::odata::utility::string_t& count_query)
+std::shared_ptr<::odata::core::odata_apply_clause> odata_uri_parser::parse_apply(
+    const ::odata::utility::string_t& apply_query,
+    std::shared_ptr<::odata::edm::edm_named_type> target_type,
+    std::shared_ptr<::odata::edm::edm_navigation_source> target_navigation_source) const
 {
-	return query_option_parser()->parse_count(count_query);
+	odata_query_option_parser query_option_parser(model(), target_type, target_navigation_source);
+	return query_option_parser.parse_apply(apply_query);
 }
 
-std::shared_ptr<::odata::core::odata_uri> odata_uri_parser::parse_uri(const ::odata::utility::uri &uri)
+std::shared_ptr<::odata::core::odata_uri> odata_uri_parser::parse_uri(const ::odata::utility::uri &uri) const
 {
-	auto path = parse_path(::odata::utility::uri::decode(uri.path()));
+	// Both parsers live on this stack frame only, the query options are bound against the target of this path.
+	auto edm_model = model();
+	odata_path_parser path_parser(edm_model);
+	auto path = path_parser.parse_path(::odata::utility::uri::decode(uri.path()));
+	odata_query_option_parser query_option_parser(edm_model, path_parser.target_type(), path_parser.target_navigation_source());
 
+	odata_stage_timer split_timer(UriSplit);
 	auto query_options = split_query_options(uri.query());
 
 	::odata::utility::string_t select_query;
@@ -2288,6 +2641,8 @@ std::shared_ptr<::odata::core::odata_uri> odata_uri_parser::parse_uri(const ::od
 	::odata::utility::string_t top_query;
 	::odata::utility::string_t skip_query;
 	::odata::utility::string_t count_query;
+	::odata::utility::string_t apply_query;
+	::odata::utility::string_t delta_token;
 
 	for (auto iter = query_options.begin(); iter != query_options.end(); ++iter)
 	{
@@ -2325,17 +2680,28 @@ std::shared_ptr<::odata::core::odata_uri> odata_uri_parser::parse_uri(const ::od
 		{
 			count_query = ::odata::utility::uri::decode(option.second);
 		}
+		else if (option.first == QueryOptionApply)
+		{
+			apply_query = ::odata::utility::uri::decode(option.second);
+		}
+		else if (option.first == QueryOptionDeltaToken)
+		{
+			delta_token = ::odata::utility::uri::decode(option.second);
+		}
 	}
+	split_timer.stop();
 
-	auto select_expand_clause = parse_select_and_expand(select_query, expand_query);
-	auto filter_clause = parse_filter(filter_query);
-	auto orderby_clause = parse_orderby(orderby_query);
-	auto search_clause = parse_search(search_query);
-	auto top = parse_top(top_query);
-	auto skip = parse_skip(skip_query);
-	auto count = parse_count(count_query);
+	odata_stage_timer expression_timer(ExpressionParse);
+	auto select_expand_clause = query_option_parser.parse_select_and_expand(select_query, expand_query);
+	auto filter_clause = query_option_parser.parse_filter(filter_query);
+	auto orderby_clause = query_option_parser.parse_orderby(orderby_query);
+	auto search_clause = query_option_parser.parse_search(search_query);
+	auto top = query_option_parser.parse_top(top_query);
+	auto skip = query_option_parser.parse_skip(skip_query);
+	auto count = query_option_parser.parse_count(count_query);
+	auto apply_clause = query_option_parser.parse_apply(apply_query);
 
-	return ::odata::core::odata_uri::create_uri(
+	auto result = ::odata::core::odata_uri::create_uri(
 		path,
 		select_expand_clause,
 		filter_clause,
@@ -2343,7 +2709,10 @@ std::shared_ptr<::odata::core::odata_uri> odata_uri_parser::parse_uri(const ::od
 		search_clause,
 		top,
 		skip,
-		count);
+		count,
+		apply_clause);
+	result->set_delta_token(std::move(delta_token));
+	return result;
 }
 
 ::size_t odata_uri_parser::advance_through_string_literal(const ::odata::utility::string_t &query, ::size_t start)
@@ -2463,27 +2832,9 @@ std::map<::odata::utility::string_t, ::odata::utility::string_t> odata_uri_parse
 	return options;
 }
 
-std::shared_ptr<odata_path_parser> odata_uri_parser::path_parser()
-{
-    if (m_path_parser == nullptr)
-    {
-        m_path_parser = std::make_shared<odata_path_parser>(model());
-    }
-    
-    return m_path_parser;
-}
-
-std::shared_ptr<odata_query_option_parser> odata_uri_parser::query_option_parser()
+std::shared_ptr<odata_query_option_parser> odata_uri_parser::unbound_query_option_parser() const
 {
-    if (m_query_option_parser == nullptr)
-    {
-        m_query_option_parser = std::make_shared<odata_query_option_parser>(
-            model(),
-            path_parser()->target_type(),
-            path_parser()->target_navigation_source());
-    }
-    
-    return m_query_option_parser;
+	return std::make_shared<odata_query_option_parser>(model(), nullptr, nullptr);
 }
 
 // --END-- odata_uri_parser
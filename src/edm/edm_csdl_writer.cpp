@@ -0,0 +1,915 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_csdl_writer.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/edm/edm_csdl_writer.h"
+#include <algorithm>
+
+namespace odata { namespace edm
+{
+
+void edm_csdl_writer::write_model(std::shared_ptr<edm_model> model)
+{
+	if (!model)
+	{
+		throw std::invalid_argument("Cannot write a null model.");
+	}
+
+	if (m_format == edm_csdl_format_t::Xml)
+	{
+		put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+		start_element("edmx:Edmx");
+		attribute("xmlns:edmx", "http://docs.oasis-open.org/odata/ns/edmx");
+		attribute("Version", model->get_version());
+		start_element("edmx:DataServices");
+		for (auto iter = model->get_schema().cbegin(); iter != model->get_schema().cend(); ++iter)
+		{
+			write_xml_schema(*iter);
+		}
+		end_element();
+		end_element();
+		put('\n');
+	}
+	else
+	{
+		begin_object();
+		member("$Version");
+		value(model->get_version());
+
+		for (auto iter = model->get_schema().cbegin(); iter != model->get_schema().cend(); ++iter)
+		{
+			if (!(*iter)->get_containers().empty())
+			{
+				// Written piecewise so the qualified name is never materialized.
+				member("$EntityContainer");
+				put('"');
+				put_escaped((*iter)->get_name());
+				put('.');
+				put_escaped((*iter)->get_containers().cbegin()->second->get_name());
+				put('"');
+				m_need_comma = true;
+				break;
+			}
+		}
+
+		for (auto iter = model->get_schema().cbegin(); iter != model->get_schema().cend(); ++iter)
+		{
+			write_json_schema(*iter);
+		}
+		end_object();
+		put('\n');
+	}
+
+	flush();
+	if (m_stream)
+	{
+		m_stream->flush();
+	}
+}
+
+::odata::utility::string_t edm_csdl_writer::write_model_to_string(std::shared_ptr<edm_model> model, edm_csdl_format_t format)
+{
+	std::string output;
+	edm_csdl_writer writer(output, format);
+	writer.write_model(model);
+	return ::odata::utility::conversions::to_string_t(std::move(output));
+}
+
+void edm_csdl_writer::put(const char* data, size_t size)
+{
+	if (size > sizeof(m_buffer) - m_used)
+	{
+		flush();
+		if (size > sizeof(m_buffer))
+		{
+			if (m_stream)
+			{
+				m_stream->write(data, size);
+			}
+			else
+			{
+				m_output->append(data, size);
+			}
+			return;
+		}
+	}
+
+	std::memcpy(m_buffer + m_used, data, size);
+	m_used += size;
+}
+
+void edm_csdl_writer::flush()
+{
+	if (m_used == 0)
+	{
+		return;
+	}
+
+	if (m_stream)
+	{
+		m_stream->write(m_buffer, m_used);
+	}
+	else
+	{
+		m_output->append(m_buffer, m_used);
+	}
+	m_used = 0;
+}
+
+void edm_csdl_writer::put_escaped(const ::odata::utility::string_t& text)
+{
+#ifdef _UTF16_STRINGS
+	const std::string utf8 = ::odata::utility::conversions::to_utf8string(text);
+#else
+	const std::string& utf8 = text;
+#endif
+
+	// Runs of characters that need no escaping are copied in one go.
+	const char* run = utf8.data();
+	const char* end = run + utf8.size();
+	for (const char* current = run; current != end; ++current)
+	{
+		unsigned char c = static_cast<unsigned char>(*current);
+		const char* replacement = nullptr;
+		char control[7];
+
+		if (m_format == edm_csdl_format_t::Xml)
+		{
+			// The same escapes libxml2 applies to attribute values.
+			switch (c)
+			{
+			case '&': replacement = "&amp;"; break;
+			case '<': replacement = "&lt;"; break;
+			case '>': replacement = "&gt;"; break;
+			case '"': replacement = "&quot;"; break;
+			case '\r': replacement = "&#13;"; break;
+			case '\n': replacement = "&#10;"; break;
+			case '\t': replacement = "&#9;"; break;
+			default: break;
+			}
+		}
+		else
+		{
+			switch (c)
+			{
+			case '"': replacement = "\\\""; break;
+			case '\\': replacement = "\\\\"; break;
+			case '\r': replacement = "\\r"; break;
+			case '\n': replacement = "\\n"; break;
+			case '\t': replacement = "\\t"; break;
+			default:
+				if (c < 0x20)
+				{
+					static const char hex[] = "0123456789abcdef";
+					control[0] = '\\'; control[1] = 'u'; control[2] = '0'; control[3] = '0';
+					control[4] = hex[c >> 4]; control[5] = hex[c & 0xF]; control[6] = '\0';
+					replacement = control;
+				}
+				break;
+			}
+		}
+
+		if (replacement)
+		{
+			put(run, current - run);
+			put(replacement);
+			run = current + 1;
+		}
+	}
+	put(run, end - run);
+}
+
+void edm_csdl_writer::put_number(uint64_t value)
+{
+	char digits[20];
+	size_t count = 0;
+	do
+	{
+		digits[sizeof(digits) - ++count] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	put(digits + sizeof(digits) - count, count);
+}
+
+void edm_csdl_writer::start_element(const char* name)
+{
+	if (m_start_tag_open)
+	{
+		put('>');
+	}
+	put('<');
+	put(name);
+	m_elements.push_back(name);
+	m_start_tag_open = true;
+}
+
+void edm_csdl_writer::attribute(const char* name, const ::odata::utility::string_t& value)
+{
+	put(' ');
+	put(name);
+	put("=\"", 2);
+	put_escaped(value);
+	put('"');
+}
+
+void edm_csdl_writer::attribute(const char* name, const char* value)
+{
+	put(' ');
+	put(name);
+	put("=\"", 2);
+	put(value);
+	put('"');
+}
+
+void edm_csdl_writer::attribute(const char* name, uint64_t value)
+{
+	put(' ');
+	put(name);
+	put("=\"", 2);
+	put_number(value);
+	put('"');
+}
+
+void edm_csdl_writer::text(const ::odata::utility::string_t& value)
+{
+	if (m_start_tag_open)
+	{
+		put('>');
+		m_start_tag_open = false;
+	}
+	put_escaped(value);
+}
+
+void edm_csdl_writer::end_element()
+{
+	// Elements without children are closed in the start tag, as libxml2 does.
+	if (m_start_tag_open)
+	{
+		put("/>", 2);
+		m_start_tag_open = false;
+	}
+	else
+	{
+		put("</", 2);
+		put(m_elements.back());
+		put('>');
+	}
+	m_elements.pop_back();
+}
+
+void edm_csdl_writer::write_xml_schema(const std::shared_ptr<edm_schema>& schema)
+{
+	start_element("Schema");
+	attribute("xmlns", "http://docs.oasis-open.org/odata/ns/edm");
+	attribute("Namespace", schema->get_name());
+
+	for (auto iter = schema->get_enum_types().cbegin(); iter != schema->get_enum_types().cend(); ++iter)
+	{
+		const auto& enum_type = iter->second;
+		start_element("EnumType");
+		attribute("Name", enum_type->get_name());
+		if (enum_type->is_flag())
+		{
+			attribute("IsFlags", "true");
+		}
+
+		for (auto member = enum_type->get_enum_members().cbegin(); member != enum_type->get_enum_members().cend(); ++member)
+		{
+			start_element("Member");
+			attribute("Name", (*member)->get_enum_member_name());
+			attribute("Value", static_cast<uint64_t>((*member)->get_enum_member_value()));
+			end_element();
+		}
+		end_element();
+	}
+
+	for (auto iter = schema->get_complex_types().cbegin(); iter != schema->get_complex_types().cend(); ++iter)
+	{
+		start_element("ComplexType");
+		attribute("Name", iter->second->get_name());
+		for (auto property = iter->second->begin(); property != iter->second->end(); ++property)
+		{
+			write_xml_property(property->second, true);
+		}
+		end_element();
+	}
+
+	for (auto iter = schema->get_entity_types().cbegin(); iter != schema->get_entity_types().cend(); ++iter)
+	{
+		write_xml_entity_type(iter->second);
+	}
+
+	for (auto iter = schema->get_operation_types().cbegin(); iter != schema->get_operation_types().cend(); ++iter)
+	{
+		write_xml_operation(iter->second);
+	}
+
+	for (auto iter = schema->get_containers().cbegin(); iter != schema->get_containers().cend(); ++iter)
+	{
+		write_xml_entity_container(iter->second);
+	}
+
+	end_element();
+}
+
+void edm_csdl_writer::write_xml_property(const std::shared_ptr<edm_property_type>& property, bool write_facets)
+{
+	start_element(write_facets ? "Property" : "NavigationProperty");
+	attribute("Name", property->get_name());
+	attribute("Type", property->get_property_type()->get_name());
+	if (!property->is_nullable())
+	{
+		attribute("Nullable", "false");
+	}
+
+	if (write_facets)
+	{
+		if (!property->is_unicode())
+		{
+			attribute("Unicode", "false");
+		}
+		if (property->get_max_length() != undefined_value)
+		{
+			attribute("MaxLength", static_cast<uint64_t>(property->get_max_length()));
+		}
+		if (property->get_precision() != undefined_value)
+		{
+			attribute("Precision", static_cast<uint64_t>(property->get_precision()));
+		}
+		if (property->get_scale() != 0)
+		{
+			attribute("Scale", static_cast<uint64_t>(property->get_scale()));
+		}
+		if (!property->default_value().empty())
+		{
+			attribute("DefaultValue", property->default_value());
+		}
+	}
+	else if (static_cast<const edm_navigation_type*>(property->get_property_type().get())->is_contained())
+	{
+		attribute("ContainsTarget", "true");
+	}
+
+	end_element();
+}
+
+void edm_csdl_writer::write_xml_entity_type(const std::shared_ptr<edm_entity_type>& entity_type)
+{
+	start_element("EntityType");
+	attribute("Name", entity_type->get_name());
+
+	const auto& key = entity_type->key();
+	start_element("Key");
+	for (auto iter = key.cbegin(); iter != key.cend(); ++iter)
+	{
+		start_element("PropertyRef");
+		attribute("Name", *iter);
+		end_element();
+	}
+	end_element();
+
+	// Key properties come first in declaration order, then the other structural and the navigation properties,
+	// each in reverse order, matching edm_model_writer.
+	auto& properties = m_deferred_properties;
+	auto& navigation_properties = m_deferred_navigation_properties;
+	properties.clear();
+	navigation_properties.clear();
+	for (auto iter = entity_type->begin(); iter != entity_type->end(); ++iter)
+	{
+		if (std::find(key.cbegin(), key.cend(), iter->first) != key.cend())
+		{
+			write_xml_property(iter->second, true);
+		}
+		else if (iter->second->get_property_type()->get_type_kind() == edm_type_kind_t::Navigation)
+		{
+			navigation_properties.push_back(&iter->second);
+		}
+		else
+		{
+			properties.push_back(&iter->second);
+		}
+	}
+
+	for (auto iter = properties.crbegin(); iter != properties.crend(); ++iter)
+	{
+		write_xml_property(**iter, true);
+	}
+	for (auto iter = navigation_properties.crbegin(); iter != navigation_properties.crend(); ++iter)
+	{
+		write_xml_property(**iter, false);
+	}
+
+	end_element();
+}
+
+void edm_csdl_writer::write_xml_operation(const std::shared_ptr<edm_operation_type>& operation)
+{
+	start_element(operation->is_function() ? "Function" : "Action");
+	attribute("Name", operation->get_name());
+	if (operation->is_bound())
+	{
+		attribute("IsBound", "true");
+	}
+	if (operation->is_composable())
+	{
+		attribute("IsComposable", "true");
+	}
+	if (!operation->get_path().empty())
+	{
+		attribute("EntitySetPath", operation->get_path());
+	}
+
+	for (auto iter = operation->get_operation_parameters().cbegin(); iter != operation->get_operation_parameters().cend(); ++iter)
+	{
+		start_element("Parameter");
+		attribute("Name", (*iter)->get_param_name());
+		attribute("Type", (*iter)->get_param_type()->get_name());
+		if (!(*iter)->is_nullable())
+		{
+			attribute("Nullable", "false");
+		}
+		end_element();
+	}
+
+	const auto return_type = operation->get_operation_return_type();
+	if (return_type)
+	{
+		start_element("ReturnType");
+		attribute("Type", return_type->get_name());
+		end_element();
+	}
+
+	end_element();
+}
+
+void edm_csdl_writer::write_xml_navigation_source(const char* element, const std::shared_ptr<edm_navigation_source>& navigation_source, const ::odata::utility::string_t& entity_type_name)
+{
+	start_element(element);
+	attribute("Name", navigation_source->get_name());
+	attribute("EntityType", entity_type_name);
+
+	const auto& bindings = navigation_source->get_navigation_sources();
+	for (auto iter = bindings.cbegin(); iter != bindings.cend(); ++iter)
+	{
+		start_element("NavigationPropertyBinding");
+		attribute("Path", iter->first);
+		attribute("Target", iter->second);
+		end_element();
+	}
+
+	const auto& concurrency_properties = navigation_source->get_concurrency_properties();
+	if (!concurrency_properties.empty())
+	{
+		start_element("Annotation");
+		attribute("Term", "Org.OData.Core.V1.OptimisticConcurrency");
+		start_element("Collection");
+		for (auto iter = concurrency_properties.cbegin(); iter != concurrency_properties.cend(); ++iter)
+		{
+			start_element("PropertyPath");
+			text(*iter);
+			end_element();
+		}
+		end_element();
+		end_element();
+	}
+
+	end_element();
+}
+
+void edm_csdl_writer::write_xml_entity_container(const std::shared_ptr<edm_entity_container>& entity_container)
+{
+	start_element("EntityContainer");
+	attribute("Name", entity_container->get_name());
+
+	for (auto iter = entity_container->begin(); iter != entity_container->end(); ++iter)
+	{
+		write_xml_navigation_source("EntitySet", iter->second, iter->second->get_entity_type_name());
+	}
+
+	for (auto iter = entity_container->get_singletons().cbegin(); iter != entity_container->get_singletons().cend(); ++iter)
+	{
+		write_xml_navigation_source("Singleton", iter->second, iter->second->get_entity_type_name());
+	}
+
+	for (auto iter = entity_container->get_operation_imports().cbegin(); iter != entity_container->get_operation_imports().cend(); ++iter)
+	{
+		const auto& operation_import = iter->second;
+		bool is_function = operation_import->get_operation_import_kind() == OperationImportKind::FunctionImport;
+		start_element(is_function ? "FunctionImport" : "ActionImport");
+		attribute("Name", operation_import->get_name());
+		attribute(is_function ? "Function" : "Action", operation_import->get_operation_name());
+		if (!operation_import->get_entity_set_name().empty())
+		{
+			attribute("EntitySet", operation_import->get_entity_set_name());
+		}
+		end_element();
+	}
+
+	end_element();
+}
+
+void edm_csdl_writer::begin_object()
+{
+	put('{');
+	m_need_comma = false;
+}
+
+void edm_csdl_writer::end_object()
+{
+	put('}');
+	m_need_comma = true;
+}
+
+void edm_csdl_writer::begin_array()
+{
+	put('[');
+	m_need_comma = false;
+}
+
+void edm_csdl_writer::end_array()
+{
+	put(']');
+	m_need_comma = true;
+}
+
+void edm_csdl_writer::member(const char* name)
+{
+	if (m_need_comma)
+	{
+		put(',');
+	}
+	put('"');
+	put(name);
+	put("\":", 2);
+	m_need_comma = false;
+}
+
+void edm_csdl_writer::member(const ::odata::utility::string_t& name)
+{
+	if (m_need_comma)
+	{
+		put(',');
+	}
+	put('"');
+	put_escaped(name);
+	put("\":", 2);
+	m_need_comma = false;
+}
+
+void edm_csdl_writer::kind(const char* kind)
+{
+	member("$Kind");
+	put('"');
+	put(kind);
+	put('"');
+	m_need_comma = true;
+}
+
+void edm_csdl_writer::value(const ::odata::utility::string_t& text)
+{
+	if (m_need_comma)
+	{
+		put(',');
+	}
+	put('"');
+	put_escaped(text);
+	put('"');
+	m_need_comma = true;
+}
+
+void edm_csdl_writer::value(bool flag)
+{
+	if (flag)
+	{
+		put("true", 4);
+	}
+	else
+	{
+		put("false", 5);
+	}
+	m_need_comma = true;
+}
+
+void edm_csdl_writer::value(uint64_t number)
+{
+	put_number(number);
+	m_need_comma = true;
+}
+
+void edm_csdl_writer::json_type(const std::shared_ptr<edm_named_type>& type)
+{
+	const edm_named_type* target = type.get();
+	std::shared_ptr<edm_named_type> navigation_target;
+	if (target->get_type_kind() == edm_type_kind_t::Navigation)
+	{
+		navigation_target = static_cast<const edm_navigation_type*>(target)->get_navigation_type();
+		if (navigation_target)
+		{
+			target = navigation_target.get();
+		}
+	}
+
+	if (target->get_type_kind() == edm_type_kind_t::Collection)
+	{
+		member("$Collection");
+		value(true);
+		auto element_type = static_cast<const edm_collection_type*>(target)->get_element_type();
+		if (element_type)
+		{
+			// The collection owns its element type, so the pointer outlives this call.
+			target = element_type.get();
+		}
+	}
+
+	member("$Type");
+	put('"');
+	auto type_kind = target->get_type_kind();
+	if (!target->get_namespace().empty()
+		&& (type_kind == edm_type_kind_t::Entity || type_kind == edm_type_kind_t::Complex || type_kind == edm_type_kind_t::Enum))
+	{
+		put_escaped(target->get_namespace());
+		put('.');
+	}
+	put_escaped(target->get_name());
+	put('"');
+	m_need_comma = true;
+}
+
+void edm_csdl_writer::write_json_schema(const std::shared_ptr<edm_schema>& schema)
+{
+	member(schema->get_name());
+	begin_object();
+
+	for (auto iter = schema->get_enum_types().cbegin(); iter != schema->get_enum_types().cend(); ++iter)
+	{
+		const auto& enum_type = iter->second;
+		member(enum_type->get_name());
+		begin_object();
+		kind("EnumType");
+		if (enum_type->is_flag())
+		{
+			member("$IsFlags");
+			value(true);
+		}
+		for (auto member_iter = enum_type->get_enum_members().cbegin(); member_iter != enum_type->get_enum_members().cend(); ++member_iter)
+		{
+			member((*member_iter)->get_enum_member_name());
+			value(static_cast<uint64_t>((*member_iter)->get_enum_member_value()));
+		}
+		end_object();
+	}
+
+	for (auto iter = schema->get_complex_types().cbegin(); iter != schema->get_complex_types().cend(); ++iter)
+	{
+		member(iter->second->get_name());
+		begin_object();
+		kind("ComplexType");
+		for (auto property = iter->second->begin(); property != iter->second->end(); ++property)
+		{
+			write_json_property(property->second);
+		}
+		end_object();
+	}
+
+	for (auto iter = schema->get_entity_types().cbegin(); iter != schema->get_entity_types().cend(); ++iter)
+	{
+		write_json_entity_type(iter->second);
+	}
+
+	// Operations are overloadable, so CSDL JSON lists them in an array per name.
+	for (auto iter = schema->get_operation_types().cbegin(); iter != schema->get_operation_types().cend(); ++iter)
+	{
+		member(iter->second->get_name());
+		begin_array();
+		write_json_operation(iter->second);
+		end_array();
+	}
+
+	for (auto iter = schema->get_containers().cbegin(); iter != schema->get_containers().cend(); ++iter)
+	{
+		write_json_entity_container(iter->second);
+	}
+
+	end_object();
+}
+
+void edm_csdl_writer::write_json_property(const std::shared_ptr<edm_property_type>& property)
+{
+	const auto& type = property->get_property_type();
+	bool is_navigation = type->get_type_kind() == edm_type_kind_t::Navigation;
+
+	member(property->get_name());
+	begin_object();
+	if (is_navigation)
+	{
+		kind("NavigationProperty");
+	}
+	json_type(type);
+
+	// Unlike CSDL XML, CSDL JSON defaults to non-nullable.
+	if (property->is_nullable())
+	{
+		member("$Nullable");
+		value(true);
+	}
+
+	if (is_navigation)
+	{
+		if (static_cast<const edm_navigation_type*>(type.get())->is_contained())
+		{
+			member("$ContainsTarget");
+			value(true);
+		}
+	}
+	else
+	{
+		if (!property->is_unicode())
+		{
+			member("$Unicode");
+			value(false);
+		}
+		if (property->get_max_length() != undefined_value)
+		{
+			member("$MaxLength");
+			value(static_cast<uint64_t>(property->get_max_length()));
+		}
+		if (property->get_precision() != undefined_value)
+		{
+			member("$Precision");
+			value(static_cast<uint64_t>(property->get_precision()));
+		}
+		if (property->get_scale() != 0)
+		{
+			member("$Scale");
+			value(static_cast<uint64_t>(property->get_scale()));
+		}
+		if (!property->default_value().empty())
+		{
+			member("$DefaultValue");
+			value(property->default_value());
+		}
+	}
+
+	end_object();
+}
+
+void edm_csdl_writer::write_json_entity_type(const std::shared_ptr<edm_entity_type>& entity_type)
+{
+	member(entity_type->get_name());
+	begin_object();
+	kind("EntityType");
+
+	const auto& key = entity_type->key();
+	if (!key.empty())
+	{
+		member("$Key");
+		begin_array();
+		for (auto iter = key.cbegin(); iter != key.cend(); ++iter)
+		{
+			value(*iter);
+		}
+		end_array();
+	}
+
+	for (auto iter = entity_type->begin(); iter != entity_type->end(); ++iter)
+	{
+		write_json_property(iter->second);
+	}
+
+	end_object();
+}
+
+void edm_csdl_writer::write_json_operation(const std::shared_ptr<edm_operation_type>& operation)
+{
+	begin_object();
+	kind(operation->is_function() ? "Function" : "Action");
+	if (operation->is_bound())
+	{
+		member("$IsBound");
+		value(true);
+	}
+	if (operation->is_composable())
+	{
+		member("$IsComposable");
+		value(true);
+	}
+	if (!operation->get_path().empty())
+	{
+		member("$EntitySetPath");
+		value(operation->get_path());
+	}
+
+	const auto& parameters = operation->get_operation_parameters();
+	if (!parameters.empty())
+	{
+		member("$Parameter");
+		begin_array();
+		for (auto iter = parameters.cbegin(); iter != parameters.cend(); ++iter)
+		{
+			if (m_need_comma)
+			{
+				put(',');
+			}
+			begin_object();
+			member("$Name");
+			value((*iter)->get_param_name());
+			json_type((*iter)->get_param_type());
+			if ((*iter)->is_nullable())
+			{
+				member("$Nullable");
+				value(true);
+			}
+			end_object();
+		}
+		end_array();
+	}
+
+	const auto return_type = operation->get_operation_return_type();
+	if (return_type)
+	{
+		member("$ReturnType");
+		begin_object();
+		json_type(return_type);
+		end_object();
+	}
+
+	end_object();
+}
+
+void edm_csdl_writer::write_json_navigation_source(const std::shared_ptr<edm_navigation_source>& navigation_source, const ::odata::utility::string_t& entity_type_name, bool collection)
+{
+	member(navigation_source->get_name());
+	begin_object();
+	if (collection)
+	{
+		member("$Collection");
+		value(true);
+	}
+	member("$Type");
+	value(entity_type_name);
+
+	const auto& bindings = navigation_source->get_navigation_sources();
+	if (!bindings.empty())
+	{
+		member("$NavigationPropertyBinding");
+		begin_object();
+		for (auto iter = bindings.cbegin(); iter != bindings.cend(); ++iter)
+		{
+			member(iter->first);
+			value(iter->second);
+		}
+		end_object();
+	}
+
+	const auto& concurrency_properties = navigation_source->get_concurrency_properties();
+	if (!concurrency_properties.empty())
+	{
+		member("@Org.OData.Core.V1.OptimisticConcurrency");
+		begin_array();
+		for (auto iter = concurrency_properties.cbegin(); iter != concurrency_properties.cend(); ++iter)
+		{
+			value(*iter);
+		}
+		end_array();
+	}
+
+	end_object();
+}
+
+void edm_csdl_writer::write_json_entity_container(const std::shared_ptr<edm_entity_container>& entity_container)
+{
+	member(entity_container->get_name());
+	begin_object();
+	kind("EntityContainer");
+
+	for (auto iter = entity_container->begin(); iter != entity_container->end(); ++iter)
+	{
+		write_json_navigation_source(iter->second, iter->second->get_entity_type_name(), true);
+	}
+
+	for (auto iter = entity_container->get_singletons().cbegin(); iter != entity_container->get_singletons().cend(); ++iter)
+	{
+		write_json_navigation_source(iter->second, iter->second->get_entity_type_name(), false);
+	}
+
+	for (auto iter = entity_container->get_operation_imports().cbegin(); iter != entity_container->get_operation_imports().cend(); ++iter)
+	{
+		const auto& operation_import = iter->second;
+		member(operation_import->get_name());
+		begin_object();
+		member(operation_import->get_operation_import_kind() == OperationImportKind::FunctionImport ? "$Function" : "$Action");
+		value(operation_import->get_operation_name());
+		if (!operation_import->get_entity_set_name().empty())
+		{
+			member("$EntitySet");
+			value(operation_import->get_entity_set_name());
+		}
+		end_object();
+	}
+
+	end_object();
+}
+
+}}
@@ -63,6 +63,22 @@ std::shared_ptr<edm_complex_type> edm_model::find_complex_type(::odata::utility:
     return nullptr;
 }
 
+std::shared_ptr<edm_structured_type> edm_model::find_structured_type(const ::odata::utility::string_t& name) const
+{
+	if (m_frozen)
+	{
+		auto find_iter = m_structured_types_by_name.find(name);
+		return find_iter == m_structured_types_by_name.end() ? nullptr : find_iter->second;
+	}
+
+	std::shared_ptr<edm_structured_type> type = find_entity_type(name);
+	if (!type)
+	{
+		type = find_complex_type(name);
+	}
+	return type;
+}
+
 std::shared_ptr<edm_enum_type> edm_model::find_enum_type(::odata::utility::string_t name) const
 {
     for (auto sc = m_schemata.cbegin(); sc != m_schemata.cend(); ++sc)
@@ -93,6 +109,11 @@ std::shared_ptr<edm_operation_type> edm_model::find_operation_type(::odata::util
 
 std::shared_ptr<edm_entity_container> edm_model::find_container(::odata::utility::string_t name) const
 {
+    if (m_frozen && name.empty())
+    {
+        return m_default_container;
+    }
+
     for (auto sc = m_schemata.cbegin(); sc != m_schemata.cend(); ++sc)
     {
         auto cn_ptr = (*sc)->find_container(name);
@@ -105,4 +126,179 @@ std::shared_ptr<edm_entity_container> edm_model::find_container(::odata::utility
     return nullptr;
 }
 
-}}
\ No newline at end of file
+// Returns the values of a name-keyed map ordered by name, so that identifiers do not depend on hashing.
+template <typename T>
+static std::vector<std::shared_ptr<T>> sorted_by_name(const std::unordered_map<::odata::utility::string_t, std::shared_ptr<T>>& map)
+{
+	std::vector<std::shared_ptr<T>> ret;
+	ret.reserve(map.size());
+	for (auto iter = map.cbegin(); iter != map.cend(); ++iter)
+	{
+		ret.push_back(iter->second);
+	}
+
+	std::sort(ret.begin(), ret.end(), [](const std::shared_ptr<T>& left, const std::shared_ptr<T>& right)
+	{
+		return left->get_name() < right->get_name();
+	});
+	return ret;
+}
+
+void edm_model::freeze()
+{
+	if (m_frozen)
+	{
+		return;
+	}
+
+	for (auto sc = m_schemata.cbegin(); sc != m_schemata.cend(); ++sc)
+	{
+		auto schema = *sc;
+
+		auto enum_types = sorted_by_name(schema->m_enum_types);
+		for (auto iter = enum_types.cbegin(); iter != enum_types.cend(); ++iter)
+		{
+			(*iter)->m_id = (unsigned int)m_types.size();
+			(*iter)->m_frozen = true;
+			m_types.push_back(*iter);
+		}
+
+		auto complex_types = sorted_by_name(schema->m_complex_types);
+		for (auto iter = complex_types.cbegin(); iter != complex_types.cend(); ++iter)
+		{
+			freeze_structured_type(*iter);
+		}
+
+		auto entity_types = sorted_by_name(schema->m_entity_types);
+		for (auto iter = entity_types.cbegin(); iter != entity_types.cend(); ++iter)
+		{
+			freeze_structured_type(*iter);
+		}
+
+		auto operation_types = sorted_by_name(schema->m_operation_types);
+		for (auto iter = operation_types.cbegin(); iter != operation_types.cend(); ++iter)
+		{
+			(*iter)->m_id = (unsigned int)m_types.size();
+			(*iter)->m_operation_id = (unsigned int)m_operations.size();
+			(*iter)->m_frozen = true;
+			m_types.push_back(*iter);
+			m_operations.push_back(*iter);
+		}
+
+		auto containers = sorted_by_name(schema->m_entity_containers);
+		for (auto iter = containers.cbegin(); iter != containers.cend(); ++iter)
+		{
+			auto container = *iter;
+			for (auto entity_set = container->m_entity_set_vector.cbegin(); entity_set != container->m_entity_set_vector.cend(); ++entity_set)
+			{
+				(*entity_set)->m_id = (unsigned int)m_navigation_sources.size();
+				(*entity_set)->m_frozen = true;
+				m_navigation_sources.push_back(*entity_set);
+			}
+
+			for (auto singleton = container->m_singleton_vector.cbegin(); singleton != container->m_singleton_vector.cend(); ++singleton)
+			{
+				(*singleton)->m_id = (unsigned int)m_navigation_sources.size();
+				(*singleton)->m_frozen = true;
+				m_navigation_sources.push_back(*singleton);
+			}
+
+			container->m_frozen = true;
+		}
+
+		schema->m_frozen = true;
+	}
+
+	build_symbol_tables();
+	m_default_container = find_container();
+	m_frozen = true;
+}
+
+void edm_model::freeze_structured_type(const std::shared_ptr<edm_structured_type>& structured_type)
+{
+	structured_type->m_id = (unsigned int)m_types.size();
+	structured_type->m_frozen = true;
+	m_types.push_back(structured_type);
+
+	const auto &properties = structured_type->get_properties_vector();
+	for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter)
+	{
+		auto property = *iter;
+		property->m_id = (unsigned int)m_properties.size();
+		m_properties.push_back(property);
+
+		auto property_type = property->get_property_type();
+		if (property_type && property_type->get_type_kind() == edm_type_kind_t::Navigation)
+		{
+			property->m_navigation_id = (unsigned int)m_navigation_properties.size();
+			m_navigation_properties.push_back(property);
+		}
+	}
+}
+
+void edm_model::build_symbol_tables()
+{
+	// Entity types take precedence over complex types and earlier schemas over later ones, as in find_structured_type.
+	const edm_type_kind_t kinds[] = { edm_type_kind_t::Entity, edm_type_kind_t::Complex };
+	for (size_t k = 0; k < 2; ++k)
+	{
+		for (auto iter = m_types.cbegin(); iter != m_types.cend(); ++iter)
+		{
+			if ((*iter)->get_type_kind() != kinds[k])
+			{
+				continue;
+			}
+
+			auto structured_type = std::static_pointer_cast<edm_structured_type>(*iter);
+			m_structured_types_by_name.insert(std::make_pair(structured_type->get_name(), structured_type));
+			m_structured_types_by_name.insert(std::make_pair(structured_type->get_full_name(), structured_type));
+
+			const auto &properties = structured_type->m_base_type ? structured_type->m_property_map_with_parents : structured_type->m_properties;
+			for (auto property = properties.cbegin(); property != properties.cend(); ++property)
+			{
+				structured_type->m_symbols[property->first].property = property->second;
+			}
+		}
+	}
+
+	for (auto iter = m_operations.cbegin(); iter != m_operations.cend(); ++iter)
+	{
+		auto operation = *iter;
+		const auto &parameters = operation->get_operation_parameters();
+		if (!operation->is_bound() || parameters.empty() || !parameters[0]->get_param_type())
+		{
+			continue;
+		}
+
+		// Binding parameters are matched by name, like odata_path_parser does for operations the table misses.
+		auto binding_type = parameters[0]->get_param_type();
+		bool is_collection = binding_type->get_type_kind() == edm_type_kind_t::Collection;
+		if (is_collection)
+		{
+			binding_type = std::static_pointer_cast<edm_collection_type>(binding_type)->get_element_type();
+			if (!binding_type)
+			{
+				continue;
+			}
+		}
+
+		auto binding_type_iter = m_structured_types_by_name.find(binding_type->get_full_name());
+		if (binding_type_iter == m_structured_types_by_name.end())
+		{
+			continue;
+		}
+
+		const ::odata::utility::string_t names[] = { operation->get_name(), operation->get_full_name() };
+		for (size_t n = 0; n < 2; ++n)
+		{
+			auto &symbol = binding_type_iter->second->m_symbols[names[n]];
+			auto &slot = is_collection ? symbol.collection_operation : symbol.operation;
+			if (!slot)
+			{
+				slot = operation;
+			}
+		}
+	}
+}
+
+}}
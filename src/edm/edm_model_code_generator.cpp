@@ -0,0 +1,639 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_model_code_generator.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/edm/edm_model_code_generator.h"
+#include "odata/edm/edm_model_utility.h"
+#include <set>
+
+namespace odata { namespace edm
+{
+
+namespace
+{
+
+const char* const reserved_identifiers[] =
+{
+	"alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch", "char",
+	"char16_t", "char32_t", "class", "compl", "const", "constexpr", "const_cast", "continue", "decltype", "default",
+	"delete", "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float", "for",
+	"friend", "goto", "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+	"nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register", "reinterpret_cast", "return",
+	"short", "signed", "sizeof", "static", "static_assert", "static_cast", "struct", "switch", "template", "this",
+	"thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual",
+	"void", "volatile", "wchar_t", "while", "xor", "xor_eq",
+	// Members every generated struct declares.
+	"odata_type_name", "odata_properties", "odata_property_count"
+};
+
+const std::set<std::string> reserved_identifier_set(reserved_identifiers, reserved_identifiers + sizeof(reserved_identifiers) / sizeof(reserved_identifiers[0]));
+
+// CSDL names are already valid C++ identifiers unless they collide with a keyword or a generated member.
+std::string identifier(const ::odata::utility::string_t& name)
+{
+	auto ret = ::odata::utility::conversions::to_utf8string(name);
+	if (reserved_identifier_set.count(ret))
+	{
+		ret += "_";
+	}
+	return ret;
+}
+
+std::string literal(const ::odata::utility::string_t& value)
+{
+	std::string ret = "U(\"";
+	auto utf8 = ::odata::utility::conversions::to_utf8string(value);
+	for (auto iter = utf8.cbegin(); iter != utf8.cend(); ++iter)
+	{
+		if (*iter == '"' || *iter == '\\')
+		{
+			ret += '\\';
+		}
+		ret += *iter;
+	}
+	return ret + "\")";
+}
+
+std::string edm_type_name(const std::shared_ptr<edm_named_type>& type)
+{
+	switch (type->get_type_kind())
+	{
+	case edm_type_kind_t::Primitive:
+		return ::odata::utility::conversions::to_utf8string(type->get_name());
+	case edm_type_kind_t::Collection:
+		{
+			auto element_type = std::static_pointer_cast<edm_collection_type>(type)->get_element_type();
+			return "Collection(" + (element_type ? edm_type_name(element_type) : std::string()) + ")";
+		}
+	default:
+		if (type->get_namespace().empty())
+		{
+			// Types the model could not resolve carry no name at all.
+			return ::odata::utility::conversions::to_utf8string(type->get_name());
+		}
+		return ::odata::utility::conversions::to_utf8string(type->get_namespace() + U(".") + type->get_name());
+	}
+}
+
+bool is_arithmetic(const std::shared_ptr<edm_primitive_type>& primitive_type)
+{
+	switch (primitive_type->get_primitive_kind())
+	{
+	case edm_primitive_type_kind_t::Boolean:
+	case edm_primitive_type_kind_t::Byte:
+	case edm_primitive_type_kind_t::SByte:
+	case edm_primitive_type_kind_t::Int16:
+	case edm_primitive_type_kind_t::Int32:
+	case edm_primitive_type_kind_t::Int64:
+	case edm_primitive_type_kind_t::Single:
+	case edm_primitive_type_kind_t::Double:
+	case edm_primitive_type_kind_t::Decimal:
+		return true;
+	default:
+		return false;
+	}
+}
+
+std::string enum_underlying_type(const ::odata::utility::string_t& edm_type)
+{
+	if (edm_type == U("Edm.Byte"))
+	{
+		return "uint8_t";
+	}
+	if (edm_type == U("Edm.SByte"))
+	{
+		return "int8_t";
+	}
+	if (edm_type == U("Edm.Int16"))
+	{
+		return "int16_t";
+	}
+	if (edm_type == U("Edm.Int64"))
+	{
+		return "int64_t";
+	}
+	return "int32_t";
+}
+
+template <typename T>
+std::vector<std::shared_ptr<T>> sorted_by_name(const std::unordered_map<::odata::utility::string_t, std::shared_ptr<T>>& items)
+{
+	// Sorting keeps the generated header of a given model byte-for-byte reproducible.
+	std::vector<std::shared_ptr<T>> ret;
+	ret.reserve(items.size());
+	for (auto iter = items.cbegin(); iter != items.cend(); ++iter)
+	{
+		ret.push_back(iter->second);
+	}
+
+	std::sort(ret.begin(), ret.end(), [](const std::shared_ptr<T>& left, const std::shared_ptr<T>& right)
+	{
+		return left->get_name() < right->get_name();
+	});
+	return ret;
+}
+
+}
+
+void edm_model_code_generator::write_model(std::shared_ptr<edm_model> model)
+{
+	if (!model)
+	{
+		throw std::invalid_argument("Cannot generate code for a null model.");
+	}
+
+	collect(model);
+
+	m_stream << "// Generated from an OData CSDL document by odata-csdl-codegen; do not edit.\n\n"
+		<< "#pragma once\n\n"
+		<< "#include \"odata/core/odata_json_codegen.h\"\n";
+
+	for (auto iter = m_enum_types.cbegin(); iter != m_enum_types.cend(); ++iter)
+	{
+		write_enum_type(*iter);
+	}
+
+	for (auto iter = m_structured_types.cbegin(); iter != m_structured_types.cend(); ++iter)
+	{
+		open_namespace(*iter);
+		m_stream << "struct " << m_identifiers[*iter] << ";\n";
+	}
+	m_stream << "\n";
+
+	for (auto iter = m_structured_types.cbegin(); iter != m_structured_types.cend(); ++iter)
+	{
+		write_structured_type(*iter);
+	}
+
+	// Declaring every function first lets serializers of types that refer to each other call one another.
+	for (auto iter = m_enum_types.cbegin(); iter != m_enum_types.cend(); ++iter)
+	{
+		open_namespace(iter->get());
+		const auto &name = m_identifiers[iter->get()];
+		m_stream << "inline void write_json(::odata::utility::string_t& out, " << name << " value);\n"
+			<< "inline void read_json(::odata::core::odata_json_codegen_reader& reader, " << name << "& value);\n";
+	}
+
+	for (auto iter = m_structured_types.cbegin(); iter != m_structured_types.cend(); ++iter)
+	{
+		open_namespace(*iter);
+		const auto &name = m_identifiers[*iter];
+		m_stream << "inline void write_json(::odata::utility::string_t& out, const " << name << "& value);\n"
+			<< "inline void read_json(::odata::core::odata_json_codegen_reader& reader, " << name << "& value);\n";
+	}
+
+	for (auto iter = m_enum_types.cbegin(); iter != m_enum_types.cend(); ++iter)
+	{
+		write_enum_functions(*iter);
+	}
+
+	for (auto iter = m_structured_types.cbegin(); iter != m_structured_types.cend(); ++iter)
+	{
+		write_structured_functions(*iter);
+	}
+
+	close_namespace();
+}
+
+void edm_model_code_generator::collect(std::shared_ptr<edm_model> model)
+{
+	m_enum_types.clear();
+	m_structured_types.clear();
+	m_schema_namespaces.clear();
+	m_identifiers.clear();
+	m_open_namespace.clear();
+
+	std::vector<edm_structured_type*> declared;
+	const auto &schemata = model->get_schema();
+	for (auto schema = schemata.cbegin(); schema != schemata.cend(); ++schema)
+	{
+		std::string name_space = m_root_namespace;
+		std::list<::odata::utility::string_t> parts;
+		::odata::utility::string_t schema_name = (*schema)->get_name();
+		::odata::utility::split_string(schema_name, U("."), parts);
+		for (auto part = parts.cbegin(); part != parts.cend(); ++part)
+		{
+			name_space += "::" + identifier(*part);
+		}
+
+		auto enum_types = sorted_by_name((*schema)->get_enum_types());
+		for (auto iter = enum_types.cbegin(); iter != enum_types.cend(); ++iter)
+		{
+			m_enum_types.push_back(*iter);
+			m_schema_namespaces[iter->get()] = name_space;
+			m_identifiers[iter->get()] = identifier((*iter)->get_name());
+		}
+
+		auto complex_types = sorted_by_name((*schema)->get_complex_types());
+		for (auto iter = complex_types.cbegin(); iter != complex_types.cend(); ++iter)
+		{
+			declared.push_back(iter->get());
+			m_schema_namespaces[iter->get()] = name_space;
+			m_identifiers[iter->get()] = identifier((*iter)->get_name());
+		}
+
+		auto entity_types = sorted_by_name((*schema)->get_entity_types());
+		for (auto iter = entity_types.cbegin(); iter != entity_types.cend(); ++iter)
+		{
+			declared.push_back(iter->get());
+			m_schema_namespaces[iter->get()] = name_space;
+			m_identifiers[iter->get()] = identifier((*iter)->get_name());
+		}
+	}
+
+	// Structs come after their base types and after the types they hold by value.
+	std::unordered_map<const edm_structured_type*, int> states;
+	for (auto iter = declared.cbegin(); iter != declared.cend(); ++iter)
+	{
+		order_structured_type(*iter, states);
+	}
+}
+
+void edm_model_code_generator::order_structured_type(edm_structured_type* structured_type, std::unordered_map<const edm_structured_type*, int>& states)
+{
+	auto &state = states[structured_type];
+	if (state == 2)
+	{
+		return;
+	}
+
+	if (state == 1)
+	{
+		throw std::runtime_error("The type " + ::odata::utility::conversions::to_utf8string(structured_type->get_name()) + " contains itself by value.");
+	}
+
+	state = 1;
+
+	std::vector<edm_structured_type*> dependencies;
+	if (structured_type->get_base_type())
+	{
+		dependencies.push_back(structured_type->get_base_type().get());
+	}
+
+	const auto &properties = structured_type->get_properties_vector();
+	for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter)
+	{
+		if ((*iter)->get_property_type())
+		{
+			cpp_type_of((*iter)->get_property_type(), (*iter)->is_nullable(), &dependencies);
+		}
+	}
+
+	for (auto iter = dependencies.cbegin(); iter != dependencies.cend(); ++iter)
+	{
+		if (m_identifiers.count(*iter))
+		{
+			order_structured_type(*iter, states);
+		}
+	}
+
+	states[structured_type] = 2;
+	m_structured_types.push_back(structured_type);
+}
+
+std::string edm_model_code_generator::cpp_type_of(const std::shared_ptr<edm_named_type>& type, bool is_nullable, std::vector<edm_structured_type*>* dependencies) const
+{
+	switch (type->get_type_kind())
+	{
+	case edm_type_kind_t::Primitive:
+		{
+			auto primitive_type = std::static_pointer_cast<edm_primitive_type>(type);
+			auto strong_type = ::odata::utility::conversions::to_utf8string(edm_model_utility::get_strong_type_name_from_edm_type_name(primitive_type));
+			if (!strong_type.empty() && is_nullable && is_arithmetic(primitive_type))
+			{
+				return "::odata::common::nullable<" + strong_type + ">";
+			}
+			return strong_type;
+		}
+	case edm_type_kind_t::Enum:
+		{
+			auto found = m_identifiers.find(type.get());
+			if (found == m_identifiers.end())
+			{
+				return std::string();
+			}
+
+			auto qualified = "::" + m_schema_namespaces.find(type.get())->second + "::" + found->second;
+			return is_nullable ? "::odata::common::nullable<" + qualified + ">" : qualified;
+		}
+	case edm_type_kind_t::Complex:
+		{
+			auto found = m_identifiers.find(type.get());
+			if (found == m_identifiers.end())
+			{
+				return std::string();
+			}
+
+			auto qualified = "::" + m_schema_namespaces.find(type.get())->second + "::" + found->second;
+			if (is_nullable)
+			{
+				return "std::shared_ptr<" + qualified + ">";
+			}
+
+			if (dependencies)
+			{
+				dependencies->push_back(static_cast<edm_structured_type*>(type.get()));
+			}
+			return qualified;
+		}
+	case edm_type_kind_t::Collection:
+		{
+			auto element_type = std::static_pointer_cast<edm_collection_type>(type)->get_element_type();
+			auto element = element_type ? cpp_type_of(element_type, false, dependencies) : std::string();
+			return element.empty() ? element : "std::vector<" + element + ">";
+		}
+	default:
+		return std::string();
+	}
+}
+
+std::vector<edm_model_code_generator::generated_member> edm_model_code_generator::members_of(const std::vector<std::shared_ptr<edm_property_type>>& properties, const std::string& owner) const
+{
+	std::vector<generated_member> ret;
+	for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter)
+	{
+		auto property_type = (*iter)->get_property_type();
+		if (!property_type || property_type->get_type_kind() == edm_type_kind_t::Navigation)
+		{
+			continue;
+		}
+
+		generated_member member;
+		member.property = *iter;
+		member.cpp_type = cpp_type_of(property_type, (*iter)->is_nullable(), nullptr);
+		member.identifier = identifier((*iter)->get_name());
+		if (member.identifier == owner)
+		{
+			// A member may not have the name of its struct.
+			member.identifier += "_";
+		}
+		ret.push_back(member);
+	}
+	return ret;
+}
+
+void edm_model_code_generator::open_namespace(const edm_named_type* type)
+{
+	const auto &name_space = m_schema_namespaces[type];
+	if (name_space == m_open_namespace)
+	{
+		return;
+	}
+
+	close_namespace();
+
+	std::list<::odata::utility::string_t> parts;
+	::odata::utility::string_t remaining = name_space;
+	::odata::utility::split_string(remaining, U("::"), parts);
+
+	m_stream << "\n";
+	for (auto part = parts.cbegin(); part != parts.cend(); ++part)
+	{
+		if (!part->empty())
+		{
+			m_stream << "namespace " << *part << " { ";
+		}
+	}
+	m_stream << "\n\n"
+		<< "using ::odata::core::write_json;\n"
+		<< "using ::odata::core::read_json;\n\n";
+	m_open_namespace = name_space;
+}
+
+void edm_model_code_generator::close_namespace()
+{
+	if (m_open_namespace.empty())
+	{
+		return;
+	}
+
+	std::list<::odata::utility::string_t> parts;
+	::odata::utility::string_t remaining = m_open_namespace;
+	::odata::utility::split_string(remaining, U("::"), parts);
+
+	m_stream << "\n";
+	for (auto part = parts.cbegin(); part != parts.cend(); ++part)
+	{
+		if (!part->empty())
+		{
+			m_stream << "}";
+		}
+	}
+	m_stream << "\n";
+	m_open_namespace.clear();
+}
+
+void edm_model_code_generator::write_enum_type(const std::shared_ptr<edm_enum_type>& enum_type)
+{
+	open_namespace(enum_type.get());
+	const auto &name = m_identifiers[enum_type.get()];
+	const auto &members = enum_type->get_enum_members();
+
+	m_stream << "enum class " << name << " : " << enum_underlying_type(enum_type->get_underlying_type_name()) << "\n{\n";
+	for (auto iter = members.cbegin(); iter != members.cend(); ++iter)
+	{
+		m_stream << "\t" << identifier((*iter)->get_enum_member_name()) << " = " << (*iter)->get_enum_member_value() << ",\n";
+	}
+	m_stream << "};\n\n";
+
+	if (!members.empty())
+	{
+		m_stream << "static const ::odata::core::odata_codegen_enum_member " << name << "_odata_members[] =\n{\n";
+		for (auto iter = members.cbegin(); iter != members.cend(); ++iter)
+		{
+			m_stream << "\t{ " << literal((*iter)->get_enum_member_name()) << ", " << (*iter)->get_enum_member_value() << " },\n";
+		}
+		m_stream << "};\n\n";
+	}
+}
+
+void edm_model_code_generator::write_structured_type(edm_structured_type* structured_type)
+{
+	open_namespace(structured_type);
+	const auto &name = m_identifiers[structured_type];
+	auto own_members = members_of(structured_type->get_properties_vector(), name);
+	auto all_members = members_of(structured_type->get_properties_with_parents(), name);
+
+	std::vector<::odata::utility::string_t> keys;
+	auto entity_type = dynamic_cast<edm_entity_type*>(structured_type);
+	if (entity_type)
+	{
+		keys = entity_type->get_key_with_parents();
+	}
+
+	m_stream << "struct " << name;
+	auto base_type = structured_type->get_base_type();
+	if (base_type && m_identifiers.count(base_type.get()))
+	{
+		m_stream << " : public ::" << m_schema_namespaces[base_type.get()] << "::" << m_identifiers[base_type.get()];
+	}
+	m_stream << "\n{\n";
+
+	// Members left out of the struct are listed so that their absence is not a surprise.
+	for (auto iter = own_members.cbegin(); iter != own_members.cend(); ++iter)
+	{
+		if (iter->cpp_type.empty())
+		{
+			auto type_name = edm_type_name(iter->property->get_property_type());
+			m_stream << "\t// " << ::odata::utility::conversions::to_utf8string(iter->property->get_name())
+				<< (type_name.empty() ? std::string() : " (" + type_name + ")") << " has no C++ type and is not generated.\n";
+		}
+	}
+
+	m_stream << "\t" << name << "()";
+	bool first = true;
+	for (auto iter = own_members.cbegin(); iter != own_members.cend(); ++iter)
+	{
+		if (!iter->cpp_type.empty())
+		{
+			m_stream << (first ? " : " : ", ") << iter->identifier << "(";
+
+			// Enums start out as their first member rather than as a value that may not be one.
+			auto property_type = iter->property->get_property_type();
+			if (property_type->get_type_kind() == edm_type_kind_t::Enum && !iter->property->is_nullable())
+			{
+				const auto &enum_members = std::static_pointer_cast<edm_enum_type>(property_type)->get_enum_members();
+				if (!enum_members.empty())
+				{
+					m_stream << iter->cpp_type << "::" << identifier(enum_members[0]->get_enum_member_name());
+				}
+			}
+			m_stream << ")";
+			first = false;
+		}
+	}
+	m_stream << "\n\t{\n\t}\n\n";
+
+	size_t property_count = 0;
+	std::ostringstream table;
+	for (auto iter = all_members.cbegin(); iter != all_members.cend(); ++iter)
+	{
+		if (!iter->cpp_type.empty())
+		{
+			bool is_key = std::find(keys.begin(), keys.end(), iter->property->get_name()) != keys.end();
+			table << "\t\t\t{ " << literal(iter->property->get_name()) << ", U(\"" << edm_type_name(iter->property->get_property_type()) << "\"), "
+				<< (is_key ? "true" : "false") << ", " << (iter->property->is_nullable() ? "true" : "false") << " },\n";
+			property_count++;
+		}
+	}
+
+	m_stream << "\tstatic const ::odata::utility::char_t* odata_type_name()\n\t{\n\t\treturn "
+		<< literal(structured_type->get_namespace() + U(".") + structured_type->get_name()) << ";\n\t}\n\n"
+		<< "\tenum { odata_property_count = " << property_count << " };\n\n"
+		<< "\t// Properties, inherited ones first, in the order read_json numbers them.\n"
+		<< "\tstatic const ::odata::core::odata_codegen_property* odata_properties()\n\t{\n";
+	if (property_count)
+	{
+		m_stream << "\t\tstatic const ::odata::core::odata_codegen_property properties[] =\n\t\t{\n" << table.str() << "\t\t};\n"
+			<< "\t\treturn properties;\n";
+	}
+	else
+	{
+		m_stream << "\t\treturn nullptr;\n";
+	}
+	m_stream << "\t}\n";
+
+	if (!own_members.empty())
+	{
+		m_stream << "\n";
+	}
+	for (auto iter = own_members.cbegin(); iter != own_members.cend(); ++iter)
+	{
+		if (!iter->cpp_type.empty())
+		{
+			m_stream << "\t" << iter->cpp_type << " " << iter->identifier << ";\n";
+		}
+	}
+	m_stream << "};\n\n";
+}
+
+void edm_model_code_generator::write_enum_functions(const std::shared_ptr<edm_enum_type>& enum_type)
+{
+	open_namespace(enum_type.get());
+	const auto &name = m_identifiers[enum_type.get()];
+	auto count = enum_type->get_enum_members().size();
+	std::string table = count ? name + "_odata_members" : "nullptr";
+	std::string flags = enum_type->is_flag() ? "true" : "false";
+
+	m_stream << "\ninline void write_json(::odata::utility::string_t& out, " << name << " value)\n{\n"
+		<< "\t::odata::core::odata_codegen_write_enum(out, (int64_t)value, " << table << ", " << count << ", " << flags << ");\n}\n\n"
+		<< "inline void read_json(::odata::core::odata_json_codegen_reader& reader, " << name << "& value)\n{\n"
+		<< "\tvalue = (" << name << ")::odata::core::odata_codegen_read_enum(reader, " << table << ", " << count << ", " << flags << ");\n}\n";
+}
+
+void edm_model_code_generator::write_structured_functions(edm_structured_type* structured_type)
+{
+	open_namespace(structured_type);
+	const auto &name = m_identifiers[structured_type];
+
+	std::vector<generated_member> members;
+	auto all_members = members_of(structured_type->get_properties_with_parents(), name);
+	for (auto iter = all_members.cbegin(); iter != all_members.cend(); ++iter)
+	{
+		if (!iter->cpp_type.empty())
+		{
+			members.push_back(*iter);
+		}
+	}
+
+	m_stream << "\ninline void write_json(::odata::utility::string_t& out, const " << name << "& value)\n{\n";
+	if (members.empty())
+	{
+		m_stream << "\t(void)value;\n\tout += U(\"{}\");\n";
+	}
+	for (size_t i = 0; i < members.size(); i++)
+	{
+		m_stream << "\tout += U(\"" << (i == 0 ? "{" : ",") << "\\\"" << ::odata::utility::conversions::to_utf8string(members[i].property->get_name()) << "\\\":\");\n"
+			<< "\twrite_json(out, value." << members[i].identifier << ");\n";
+	}
+	if (!members.empty())
+	{
+		m_stream << "\tout += U('}');\n";
+	}
+	m_stream << "}\n\n";
+
+	// The name index is sorted the way odata_codegen_find_property searches it.
+	std::vector<std::pair<std::string, size_t>> names;
+	for (size_t i = 0; i < members.size(); i++)
+	{
+		names.push_back(std::make_pair(::odata::utility::conversions::to_utf8string(members[i].property->get_name()), i));
+	}
+	std::sort(names.begin(), names.end());
+
+	m_stream << "inline void read_json(::odata::core::odata_json_codegen_reader& reader, " << name << "& value)\n{\n";
+	if (!members.empty())
+	{
+		m_stream << "\tstatic const ::odata::core::odata_codegen_property_index names[] =\n\t{\n";
+		for (auto iter = names.cbegin(); iter != names.cend(); ++iter)
+		{
+			m_stream << "\t\t{ U(\"" << iter->first << "\"), " << iter->second << " },\n";
+		}
+		m_stream << "\t};\n\n";
+	}
+	else
+	{
+		m_stream << "\t(void)value;\n";
+	}
+
+	m_stream << "\treader.begin_object();\n"
+		<< "\t::odata::utility::string_t name;\n"
+		<< "\tfor (bool first = true; reader.next_member(name, first); first = false)\n\t{\n";
+	if (members.empty())
+	{
+		m_stream << "\t\treader.skip_value();\n";
+	}
+	else
+	{
+		m_stream << "\t\tswitch (::odata::core::odata_codegen_find_property(names, " << members.size() << ", name))\n\t\t{\n";
+		for (size_t i = 0; i < members.size(); i++)
+		{
+			m_stream << "\t\tcase " << i << ":\n\t\t\tread_json(reader, value." << members[i].identifier << ");\n\t\t\tbreak;\n";
+		}
+		m_stream << "\t\tdefault:\n\t\t\treader.skip_value();\n\t\t\tbreak;\n\t\t}\n";
+	}
+	m_stream << "\t}\n}\n";
+}
+
+}}
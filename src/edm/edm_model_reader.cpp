@@ -13,7 +13,7 @@ bool edm_model_reader::parse()
 {
 	bool ret = ::odata::edm::xml_reader::parse();
 
-	edm_model_utility::resolve_edm_types_after_parsing(m_model);
+	edm_model_utility::resolve_edm_types_after_parsing(m_model, m_resolution);
 
 	return ret;
 }
@@ -294,6 +294,16 @@ void edm_model_reader::handle_begin_element(const ::odata::utility::string_t& el
     {
         m_parsing_key = true;
     }
+    else if (elementName == U("Annotation") && (m_current_entity_set || m_current_singleton))
+    {
+        while (move_to_next_attribute())
+        {
+            if (get_current_element_name() == U("Term"))
+            {
+                m_parsing_concurrency = edm_model_utility::is_optimistic_concurrency_term(get_current_element_text());
+            }
+        }
+    }
 #ifdef WIN32
     m_reader->MoveToElement();
 #endif
@@ -325,6 +335,11 @@ void edm_model_reader::handle_end_element(const ::odata::utility::string_t& elem
         m_parsing_key = false;
     }
 
+    if (elementName == U("Annotation"))
+    {
+        m_parsing_concurrency = false;
+    }
+
 	if (elementName == U("EnumType"))
 	{
 		m_current_schema->add_enum_type(std::shared_ptr<edm_enum_type>(static_cast<edm_enum_type*>(m_current_enum)));
@@ -358,8 +373,17 @@ void edm_model_reader::handle_end_element(const ::odata::utility::string_t& elem
 	}
 }
 
-void edm_model_reader::handle_element(const ::odata::utility::string_t&)
+void edm_model_reader::handle_element(const ::odata::utility::string_t& elementName)
 {
+	if (m_parsing_concurrency && elementName == U("PropertyPath"))
+	{
+		std::shared_ptr<edm_navigation_source> navigation_source = m_current_entity_set;
+		if (!navigation_source)
+		{
+			navigation_source = m_current_singleton;
+		}
+		navigation_source->add_concurrency_property(get_current_element_text());
+	}
 }
 
 void edm_model_reader::_process_property()
@@ -0,0 +1,1004 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_model_sax_reader.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/edm/edm_model_sax_reader.h"
+#include "odata/edm/edm_model_reader.h"
+#include "odata/edm/edm_model_utility.h"
+#include "odata/common/asyncrt_utils.h"
+#include <cstring>
+
+namespace odata { namespace edm
+{
+
+std::shared_ptr<edm_model> edm_model_sax_reader::parse(std::istream& stream, size_t chunk_size, edm_type_resolution_t resolution)
+{
+	if (chunk_size == 0)
+	{
+		throw std::invalid_argument("Chunk size must be positive.");
+	}
+
+	edm_model_sax_reader reader(resolution);
+	std::vector<char> chunk(chunk_size);
+	while (stream.read(chunk.data(), chunk.size()) || stream.gcount() > 0)
+	{
+		reader.parse_chunk(chunk.data(), (size_t)stream.gcount());
+	}
+
+	return reader.finish();
+}
+
+#ifdef WIN32
+
+// xmllite has no push interface, so chunks are collected and handed to the pull reader at the end.
+edm_model_sax_reader::edm_model_sax_reader(edm_type_resolution_t resolution) : m_resolution(resolution)
+{
+}
+
+edm_model_sax_reader::~edm_model_sax_reader()
+{
+}
+
+void edm_model_sax_reader::parse_chunk(const char* data, size_t size)
+{
+	m_buffer.append(data, size);
+}
+
+std::shared_ptr<edm_model> edm_model_sax_reader::finish()
+{
+	std::istringstream stream(m_buffer);
+	edm_model_reader reader(stream, m_resolution);
+	reader.parse();
+	m_buffer.clear();
+	return reader.get_model();
+}
+
+#else
+
+namespace
+{
+
+// Every element and attribute name the reader acts on; element and attribute names share identifiers.
+namespace csdl_name
+{
+	enum
+	{
+		Unknown = 0,
+		Edmx,
+		Schema,
+		EntityContainer,
+		EntitySet,
+		Singleton,
+		FunctionImport,
+		ActionImport,
+		EntityType,
+		ComplexType,
+		EnumType,
+		Function,
+		Action,
+		Property,
+		Member,
+		NavigationPropertyBinding,
+		NavigationProperty,
+		Parameter,
+		ReturnType,
+		Key,
+		PropertyRef,
+		Version,
+		Namespace,
+		Alias,
+		Name,
+		Extends,
+		Type,
+		IncludeInServiceDocument,
+		BaseType,
+		Abstract,
+		OpenType,
+		HasStream,
+		UnderlyingType,
+		IsFlags,
+		EntitySetPath,
+		IsBound,
+		IsComposable,
+		Nullable,
+		MaxLength,
+		Unicode,
+		Scale,
+		Precision,
+		Partner,
+		ContainsTarget,
+		Value,
+		Path,
+		Target,
+		Annotation,
+		PropertyPath,
+		Term,
+		Count
+	};
+}
+
+const char* const csdl_names[csdl_name::Count] =
+{
+	"",
+	"Edmx",
+	"Schema",
+	"EntityContainer",
+	"EntitySet",
+	"Singleton",
+	"FunctionImport",
+	"ActionImport",
+	"EntityType",
+	"ComplexType",
+	"EnumType",
+	"Function",
+	"Action",
+	"Property",
+	"Member",
+	"NavigationPropertyBinding",
+	"NavigationProperty",
+	"Parameter",
+	"ReturnType",
+	"Key",
+	"PropertyRef",
+	"Version",
+	"Namespace",
+	"Alias",
+	"Name",
+	"Extends",
+	"Type",
+	"IncludeInServiceDocument",
+	"BaseType",
+	"Abstract",
+	"OpenType",
+	"HasStream",
+	"UnderlyingType",
+	"IsFlags",
+	"EntitySetPath",
+	"IsBound",
+	"IsComposable",
+	"Nullable",
+	"MaxLength",
+	"Unicode",
+	"Scale",
+	"Precision",
+	"Partner",
+	"ContainsTarget",
+	"Value",
+	"Path",
+	"Target",
+	"Annotation",
+	"PropertyPath",
+	"Term",
+};
+
+// SAX2 reports each attribute as five pointers: local name, prefix, namespace, value begin and value end.
+const int attribute_stride = 5;
+
+::odata::utility::string_t attribute_text(const xmlChar** attribute)
+{
+	return ::odata::utility::conversions::to_string_t(std::string(reinterpret_cast<const char*>(attribute[3]), reinterpret_cast<const char*>(attribute[4])));
+}
+
+bool attribute_is_true(const xmlChar** attribute)
+{
+	return attribute[4] - attribute[3] == 4 && std::memcmp(attribute[3], "true", 4) == 0;
+}
+
+// Matches the stream extraction the pull reader uses: anything that is not a number reads as 0.
+template <typename T>
+T attribute_unsigned(const xmlChar** attribute)
+{
+	const xmlChar* current = attribute[3];
+	const xmlChar* end = attribute[4];
+	bool negative = current != end && *current == '-';
+	if (current != end && (*current == '-' || *current == '+'))
+	{
+		++current;
+	}
+
+	if (current == end)
+	{
+		return 0;
+	}
+
+	T value = 0;
+	for (; current != end; ++current)
+	{
+		if (*current < '0' || *current > '9')
+		{
+			return 0;
+		}
+		value = value * 10 + (*current - '0');
+	}
+
+	return negative ? (T)(0 - value) : value;
+}
+
+void ignore_message(void*, const char*, ...)
+{
+}
+
+}
+
+edm_model_sax_reader::edm_model_sax_reader(edm_type_resolution_t resolution)
+	: m_context(nullptr), m_parsing_key(false), m_parsing_concurrency(false), m_parsing_property_path(false), m_resolution(resolution), m_model(std::make_shared<edm_model>())
+{
+	xmlInitParser();
+
+	xmlSAXHandler handler;
+	std::memset(&handler, 0, sizeof(handler));
+	handler.initialized = XML_SAX2_MAGIC;
+	handler.startElementNs = &edm_model_sax_reader::on_start_element;
+	handler.endElementNs = &edm_model_sax_reader::on_end_element;
+	handler.characters = &edm_model_sax_reader::on_characters;
+	handler.warning = &ignore_message;
+	handler.error = &ignore_message;
+
+	m_context = xmlCreatePushParserCtxt(&handler, this, nullptr, 0, nullptr);
+	if (!m_context)
+	{
+		throw std::runtime_error("Failed to create the CSDL parser.");
+	}
+	xmlCtxtUseOptions(m_context, XML_PARSE_NONET);
+}
+
+edm_model_sax_reader::~edm_model_sax_reader()
+{
+	if (m_context)
+	{
+		xmlFreeParserCtxt(m_context);
+	}
+}
+
+void edm_model_sax_reader::parse_chunk(const char* data, size_t size)
+{
+	if (!m_context)
+	{
+		throw std::runtime_error("The CSDL document has already been finished.");
+	}
+
+	// xmlParseChunk takes an int length, so very large chunks are split.
+	const size_t max_chunk = 1 << 30;
+	while (size > 0)
+	{
+		auto length = size < max_chunk ? size : max_chunk;
+		check_result(xmlParseChunk(m_context, data, (int)length, 0));
+		data += length;
+		size -= length;
+	}
+}
+
+std::shared_ptr<edm_model> edm_model_sax_reader::finish()
+{
+	if (!m_context)
+	{
+		throw std::runtime_error("The CSDL document has already been finished.");
+	}
+
+	check_result(xmlParseChunk(m_context, nullptr, 0, 1));
+
+	xmlFreeParserCtxt(m_context);
+	m_context = nullptr;
+	m_names.clear();
+	m_type_placeholders.clear();
+	m_property_types.clear();
+
+	edm_model_utility::resolve_edm_types_after_parsing(m_model, m_resolution);
+
+	return m_model;
+}
+
+void edm_model_sax_reader::check_result(int result)
+{
+	if (m_error)
+	{
+		auto error = m_error;
+		m_error = nullptr;
+		std::rethrow_exception(error);
+	}
+
+	if (result != 0)
+	{
+		std::string message = "Invalid CSDL document";
+		auto last_error = xmlCtxtGetLastError(m_context);
+		if (last_error && last_error->message)
+		{
+			message += ": ";
+			message += last_error->message;
+			while (!message.empty() && message.back() == '\n')
+			{
+				message.pop_back();
+			}
+		}
+
+		xmlFreeParserCtxt(m_context);
+		m_context = nullptr;
+		throw std::runtime_error(message);
+	}
+}
+
+void edm_model_sax_reader::on_start_element(void* context, const xmlChar* local_name, const xmlChar*, const xmlChar*,
+	int, const xmlChar**, int attribute_count, int, const xmlChar** attributes)
+{
+	auto reader = static_cast<edm_model_sax_reader*>(context);
+
+	// Exceptions must not unwind through the parser; they are rethrown once it returns.
+	try
+	{
+		reader->start_element(reader->lookup_name(local_name), attribute_count, attributes);
+	}
+	catch (...)
+	{
+		reader->m_error = std::current_exception();
+		xmlStopParser(reader->m_context);
+	}
+}
+
+void edm_model_sax_reader::on_end_element(void* context, const xmlChar* local_name, const xmlChar*, const xmlChar*)
+{
+	auto reader = static_cast<edm_model_sax_reader*>(context);
+
+	try
+	{
+		reader->end_element(reader->lookup_name(local_name));
+	}
+	catch (...)
+	{
+		reader->m_error = std::current_exception();
+		xmlStopParser(reader->m_context);
+	}
+}
+
+void edm_model_sax_reader::on_characters(void* context, const xmlChar* text, int length)
+{
+	auto reader = static_cast<edm_model_sax_reader*>(context);
+
+	// Only the text of the elements the reader collects is kept; everything else is whitespace between elements.
+	if (reader->m_parsing_property_path)
+	{
+		try
+		{
+			reader->m_text.append(reinterpret_cast<const char*>(text), (size_t)length);
+		}
+		catch (...)
+		{
+			reader->m_error = std::current_exception();
+			xmlStopParser(reader->m_context);
+		}
+	}
+}
+
+int edm_model_sax_reader::lookup_name(const xmlChar* name)
+{
+	// Names reported by the parser live in its dictionary, so each distinct name is compared against the
+	// known names once and afterwards identified by its address.
+	auto found = m_names.find(name);
+	if (found != m_names.end())
+	{
+		return found->second;
+	}
+
+	int id = csdl_name::Unknown;
+	for (int i = csdl_name::Unknown + 1; i < csdl_name::Count; i++)
+	{
+		if (xmlStrEqual(name, reinterpret_cast<const xmlChar*>(csdl_names[i])))
+		{
+			id = i;
+			break;
+		}
+	}
+
+	if (xmlDictOwns(m_context->dict, name) == 1)
+	{
+		m_names[name] = id;
+	}
+
+	return id;
+}
+
+std::shared_ptr<edm_named_type> edm_model_sax_reader::type_reference(const xmlChar** attribute, bool resolve_primitive)
+{
+	auto length = attribute[4] - attribute[3];
+
+	// Collection types get their element type set in place during resolution, so they cannot be shared.
+	if (length >= 10 && std::memcmp(attribute[3], "Collection", 10) == 0)
+	{
+		auto name = attribute_text(attribute);
+		if (resolve_primitive)
+		{
+			return edm_model_utility::get_edm_type_from_name(name);
+		}
+		return std::make_shared<edm_named_type>(name, U(""), edm_type_kind_t::Unknown);
+	}
+
+	auto interned = xmlDictLookup(m_context->dict, attribute[3], (int)length);
+	if (!interned)
+	{
+		throw std::bad_alloc();
+	}
+
+	if (resolve_primitive)
+	{
+		auto found = m_property_types.find(interned);
+		if (found != m_property_types.end())
+		{
+			return found->second;
+		}
+	}
+
+	// Placeholders are only read and replaced by the resolver, so one instance serves every reference to a name.
+	auto &placeholder = m_type_placeholders[interned];
+	if (!placeholder)
+	{
+		auto name = ::odata::utility::conversions::to_string_t(std::string(reinterpret_cast<const char*>(interned), length));
+		placeholder = std::make_shared<edm_named_type>(name, U(""), edm_type_kind_t::Unknown);
+	}
+
+	if (!resolve_primitive)
+	{
+		return placeholder;
+	}
+
+	auto type = edm_model_utility::get_edm_primitive_type_from_name(placeholder->get_name());
+	if (!type)
+	{
+		type = placeholder;
+	}
+	m_property_types[interned] = type;
+	return type;
+}
+
+void edm_model_sax_reader::start_element(int element, int attribute_count, const xmlChar** attributes)
+{
+	const xmlChar** attributes_end = attributes + attribute_count * attribute_stride;
+
+	switch (element)
+	{
+	case csdl_name::Edmx:
+		for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+		{
+			if (lookup_name(attribute[0]) == csdl_name::Version)
+			{
+				m_model->set_version(attribute_text(attribute));
+			}
+		}
+		break;
+	case csdl_name::Schema:
+		{
+			::odata::utility::string_t namesp;
+			::odata::utility::string_t alias;
+
+			for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+			{
+				switch (lookup_name(attribute[0]))
+				{
+				case csdl_name::Namespace:
+					namesp = attribute_text(attribute);
+					break;
+				case csdl_name::Alias:
+					alias = attribute_text(attribute);
+					break;
+				}
+			}
+
+			m_current_schema = m_model->add_schema(namesp, alias);
+		}
+		break;
+	case csdl_name::EntityContainer:
+		{
+			::odata::utility::string_t name;
+
+			for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+			{
+				if (lookup_name(attribute[0]) == csdl_name::Name)
+				{
+					name = attribute_text(attribute);
+				}
+			}
+
+			m_current_container = std::make_shared<edm_entity_container>(name, true);
+		}
+		break;
+	case csdl_name::EntitySet:
+	case csdl_name::Singleton:
+		{
+			::odata::utility::string_t name;
+			::odata::utility::string_t type;
+			int type_attribute = element == csdl_name::EntitySet ? csdl_name::EntityType : csdl_name::Type;
+
+			for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+			{
+				auto attribute_name = lookup_name(attribute[0]);
+				if (attribute_name == csdl_name::Name)
+				{
+					name = attribute_text(attribute);
+				}
+				else if (attribute_name == type_attribute)
+				{
+					type = attribute_text(attribute);
+				}
+			}
+
+			if (element == csdl_name::EntitySet)
+			{
+				m_current_entity_set = std::make_shared<edm_entity_set>(name, type);
+			}
+			else
+			{
+				m_current_singleton = std::make_shared<edm_singleton>(name, type);
+			}
+		}
+		break;
+	case csdl_name::FunctionImport:
+	case csdl_name::ActionImport:
+		{
+			::odata::utility::string_t name;
+			::odata::utility::string_t entity_set_path;
+			::odata::utility::string_t operation_name;
+			bool is_in_service_document = false;
+
+			for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+			{
+				switch (lookup_name(attribute[0]))
+				{
+				case csdl_name::Name:
+					name = attribute_text(attribute);
+					break;
+				case csdl_name::EntitySet:
+					entity_set_path = attribute_text(attribute);
+					break;
+				case csdl_name::IncludeInServiceDocument:
+					is_in_service_document = attribute_is_true(attribute);
+					break;
+				case csdl_name::Function:
+				case csdl_name::Action:
+					operation_name = attribute_text(attribute);
+					break;
+				}
+			}
+
+			if (m_current_container)
+			{
+				auto kind = element == csdl_name::FunctionImport ? OperationImportKind::FunctionImport : OperationImportKind::ActionImport;
+				m_current_container->add_operation_import(std::make_shared<edm_operation_import>(name, operation_name, entity_set_path, is_in_service_document, kind));
+			}
+		}
+		break;
+	case csdl_name::EntityType:
+	case csdl_name::ComplexType:
+		{
+			::odata::utility::string_t name;
+			::odata::utility::string_t base_type;
+			bool is_abstract = false;
+			bool is_open_type = false;
+			bool has_stream = false;
+
+			for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+			{
+				switch (lookup_name(attribute[0]))
+				{
+				case csdl_name::Name:
+					name = attribute_text(attribute);
+					break;
+				case csdl_name::BaseType:
+					base_type = attribute_text(attribute);
+					break;
+				case csdl_name::Abstract:
+					is_abstract = attribute_is_true(attribute);
+					break;
+				case csdl_name::OpenType:
+					is_open_type = attribute_is_true(attribute);
+					break;
+				case csdl_name::HasStream:
+					has_stream = element == csdl_name::EntityType && attribute_is_true(attribute);
+					break;
+				}
+			}
+
+			if (!m_current_schema)
+			{
+				throw std::runtime_error("Invalid CSDL document: type declared outside of a schema.");
+			}
+
+			if (element == csdl_name::EntityType)
+			{
+				m_current_st = std::make_shared<edm_entity_type>(name, m_current_schema->get_name(), base_type, is_abstract, is_open_type, has_stream);
+			}
+			else
+			{
+				m_current_st = std::make_shared<edm_complex_type>(name, m_current_schema->get_name(), base_type, is_abstract, is_open_type);
+			}
+		}
+		break;
+	case csdl_name::EnumType:
+		{
+			::odata::utility::string_t name;
+			::odata::utility::string_t underlying_type = U("Edm.Int32");
+			bool is_flags = false;
+
+			for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+			{
+				switch (lookup_name(attribute[0]))
+				{
+				case csdl_name::Name:
+					name = attribute_text(attribute);
+					break;
+				case csdl_name::UnderlyingType:
+					underlying_type = attribute_text(attribute);
+					break;
+				case csdl_name::IsFlags:
+					is_flags = attribute_is_true(attribute);
+					break;
+				}
+			}
+
+			if (!m_current_schema)
+			{
+				throw std::runtime_error("Invalid CSDL document: type declared outside of a schema.");
+			}
+
+			m_current_enum = std::make_shared<edm_enum_type>(name, m_current_schema->get_name(), underlying_type, is_flags);
+		}
+		break;
+	case csdl_name::Function:
+	case csdl_name::Action:
+		{
+			::odata::utility::string_t name;
+			::odata::utility::string_t path;
+			bool is_bound = false;
+			bool is_composable = false;
+
+			for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+			{
+				switch (lookup_name(attribute[0]))
+				{
+				case csdl_name::Name:
+					name = attribute_text(attribute);
+					break;
+				case csdl_name::EntitySetPath:
+					path = attribute_text(attribute);
+					break;
+				case csdl_name::IsBound:
+					is_bound = attribute_is_true(attribute);
+					break;
+				case csdl_name::IsComposable:
+					is_composable = attribute_is_true(attribute);
+					break;
+				}
+			}
+
+			if (!m_current_schema)
+			{
+				throw std::runtime_error("Invalid CSDL document: operation declared outside of a schema.");
+			}
+
+			auto kind = element == csdl_name::Function ? EdmOperationKind::Function : EdmOperationKind::Action;
+			m_current_operation = std::make_shared<edm_operation_type>(name, m_current_schema->get_name(), is_bound, path, kind, is_composable);
+		}
+		break;
+	case csdl_name::Property:
+	case csdl_name::Member:
+		if (m_current_st)
+		{
+			process_property(attribute_count, attributes);
+		}
+		else if (m_current_enum)
+		{
+			process_enum_member(attribute_count, attributes);
+		}
+		break;
+	case csdl_name::NavigationPropertyBinding:
+		process_navigation_property_binding(attribute_count, attributes);
+		break;
+	case csdl_name::NavigationProperty:
+		process_navigation_property(attribute_count, attributes);
+		break;
+	case csdl_name::Parameter:
+		process_operation_parameter(attribute_count, attributes);
+		break;
+	case csdl_name::ReturnType:
+		process_operation_return_type(attribute_count, attributes);
+		break;
+	case csdl_name::Key:
+		m_parsing_key = true;
+		break;
+	case csdl_name::Annotation:
+		if (m_current_entity_set || m_current_singleton)
+		{
+			for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+			{
+				if (lookup_name(attribute[0]) == csdl_name::Term)
+				{
+					m_parsing_concurrency = edm_model_utility::is_optimistic_concurrency_term(attribute_text(attribute));
+				}
+			}
+		}
+		break;
+	case csdl_name::PropertyPath:
+		if (m_parsing_concurrency)
+		{
+			m_parsing_property_path = true;
+			m_text.clear();
+		}
+		break;
+	case csdl_name::PropertyRef:
+		if (m_parsing_key && m_current_st && m_current_st->get_type_kind() == edm_type_kind_t::Entity)
+		{
+			for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+			{
+				if (lookup_name(attribute[0]) == csdl_name::Name)
+				{
+					std::static_pointer_cast<edm_entity_type>(m_current_st)->add_key_property(attribute_text(attribute));
+					break;
+				}
+			}
+		}
+		break;
+	}
+}
+
+void edm_model_sax_reader::end_element(int element)
+{
+	switch (element)
+	{
+	case csdl_name::EntityContainer:
+		if (m_current_container)
+		{
+			m_current_schema->add_container(m_current_container);
+			m_current_container.reset();
+		}
+		break;
+	case csdl_name::EntityType:
+		if (m_current_st)
+		{
+			m_current_schema->add_entity_type(std::static_pointer_cast<edm_entity_type>(m_current_st));
+			m_current_st.reset();
+		}
+		break;
+	case csdl_name::ComplexType:
+		if (m_current_st)
+		{
+			m_current_schema->add_complex_type(std::static_pointer_cast<edm_complex_type>(m_current_st));
+			m_current_st.reset();
+		}
+		break;
+	case csdl_name::Key:
+		m_parsing_key = false;
+		break;
+	case csdl_name::Annotation:
+		m_parsing_concurrency = false;
+		break;
+	case csdl_name::PropertyPath:
+		if (m_parsing_property_path)
+		{
+			std::shared_ptr<edm_navigation_source> navigation_source = m_current_entity_set;
+			if (!navigation_source)
+			{
+				navigation_source = m_current_singleton;
+			}
+			navigation_source->add_concurrency_property(::odata::utility::conversions::to_string_t(m_text));
+			m_parsing_property_path = false;
+		}
+		break;
+	case csdl_name::EnumType:
+		if (m_current_enum)
+		{
+			m_current_schema->add_enum_type(m_current_enum);
+			m_current_enum.reset();
+		}
+		break;
+	case csdl_name::Function:
+	case csdl_name::Action:
+		if (m_current_operation)
+		{
+			m_current_schema->add_operation_type(m_current_operation);
+			m_current_operation.reset();
+		}
+		break;
+	case csdl_name::EntitySet:
+		if (m_current_container && m_current_entity_set)
+		{
+			m_current_container->add_entity_set(m_current_entity_set);
+		}
+		m_current_entity_set.reset();
+		break;
+	case csdl_name::Singleton:
+		if (m_current_container && m_current_singleton)
+		{
+			m_current_container->add_singleton(m_current_singleton);
+		}
+		m_current_singleton.reset();
+		break;
+	}
+}
+
+void edm_model_sax_reader::process_property(int attribute_count, const xmlChar** attributes)
+{
+	::odata::utility::string_t property_name;
+	bool is_nullable = false;
+	std::shared_ptr<edm_named_type> type;
+	unsigned int max_length = undefined_value;
+	bool is_unicode = true;
+	unsigned int scale = 0;
+	unsigned int precision = undefined_value;
+
+	const xmlChar** attributes_end = attributes + attribute_count * attribute_stride;
+	for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+	{
+		switch (lookup_name(attribute[0]))
+		{
+		case csdl_name::Name:
+			property_name = attribute_text(attribute);
+			break;
+		case csdl_name::Nullable:
+			is_nullable = attribute_is_true(attribute);
+			break;
+		case csdl_name::Type:
+			type = type_reference(attribute, true);
+			break;
+		case csdl_name::MaxLength:
+			max_length = attribute_unsigned<unsigned int>(attribute);
+			break;
+		case csdl_name::Unicode:
+			is_unicode = attribute_is_true(attribute);
+			break;
+		case csdl_name::Scale:
+			scale = attribute_unsigned<unsigned int>(attribute);
+			break;
+		case csdl_name::Precision:
+			precision = attribute_unsigned<unsigned int>(attribute);
+			break;
+		}
+	}
+
+	auto prop = std::make_shared<edm_property_type>(property_name, is_nullable, max_length, is_unicode, scale);
+	prop->set_property_type(type);
+	prop->set_precision(precision);
+	m_current_st->add_property(prop);
+}
+
+void edm_model_sax_reader::process_enum_member(int attribute_count, const xmlChar** attributes)
+{
+	::odata::utility::string_t member_name;
+	unsigned long member_value = 0;
+
+	const xmlChar** attributes_end = attributes + attribute_count * attribute_stride;
+	for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+	{
+		switch (lookup_name(attribute[0]))
+		{
+		case csdl_name::Name:
+			member_name = attribute_text(attribute);
+			break;
+		case csdl_name::Value:
+			member_value = attribute_unsigned<unsigned long>(attribute);
+			break;
+		}
+	}
+
+	m_current_enum->add_enum_member(std::make_shared<edm_enum_member>(member_name, member_value));
+}
+
+void edm_model_sax_reader::process_navigation_property(int attribute_count, const xmlChar** attributes)
+{
+	if (!m_current_st)
+	{
+		return;
+	}
+
+	::odata::utility::string_t property_name;
+	::odata::utility::string_t partner_name;
+	::odata::utility::string_t type_name;
+	bool is_contained = false;
+	bool is_nullable = false;
+
+	const xmlChar** attributes_end = attributes + attribute_count * attribute_stride;
+	for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+	{
+		switch (lookup_name(attribute[0]))
+		{
+		case csdl_name::Name:
+			property_name = attribute_text(attribute);
+			break;
+		case csdl_name::Nullable:
+			is_nullable = attribute_is_true(attribute);
+			break;
+		case csdl_name::Partner:
+			partner_name = attribute_text(attribute);
+			break;
+		case csdl_name::Type:
+			type_name = attribute_text(attribute);
+			break;
+		case csdl_name::ContainsTarget:
+			is_contained = attribute_is_true(attribute);
+			break;
+		}
+	}
+
+	// Navigation types are completed in place during resolution, so each property gets its own.
+	auto type = std::make_shared<edm_navigation_type>(type_name, partner_name, is_contained);
+	m_current_st->add_property(std::make_shared<edm_property_type>(property_name, is_nullable, type));
+}
+
+void edm_model_sax_reader::process_navigation_property_binding(int attribute_count, const xmlChar** attributes)
+{
+	::odata::utility::string_t path;
+	::odata::utility::string_t target;
+
+	const xmlChar** attributes_end = attributes + attribute_count * attribute_stride;
+	for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+	{
+		switch (lookup_name(attribute[0]))
+		{
+		case csdl_name::Path:
+			path = attribute_text(attribute);
+			break;
+		case csdl_name::Target:
+			target = attribute_text(attribute);
+			break;
+		}
+	}
+
+	if (m_current_entity_set)
+	{
+		m_current_entity_set->add_navigation_source(path, target);
+	}
+	else if (m_current_singleton)
+	{
+		m_current_singleton->add_navigation_source(path, target);
+	}
+}
+
+void edm_model_sax_reader::process_operation_parameter(int attribute_count, const xmlChar** attributes)
+{
+	if (!m_current_operation)
+	{
+		return;
+	}
+
+	::odata::utility::string_t name;
+	std::shared_ptr<edm_named_type> type;
+
+	const xmlChar** attributes_end = attributes + attribute_count * attribute_stride;
+	for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+	{
+		switch (lookup_name(attribute[0]))
+		{
+		case csdl_name::Name:
+			name = attribute_text(attribute);
+			break;
+		case csdl_name::Type:
+			type = type_reference(attribute, false);
+			break;
+		}
+	}
+
+	m_current_operation->add_operation_parameter(std::make_shared<edm_operation_parameter>(name, type));
+}
+
+void edm_model_sax_reader::process_operation_return_type(int attribute_count, const xmlChar** attributes)
+{
+	if (!m_current_operation)
+	{
+		return;
+	}
+
+	std::shared_ptr<edm_named_type> return_type;
+
+	const xmlChar** attributes_end = attributes + attribute_count * attribute_stride;
+	for (auto attribute = attributes; attribute != attributes_end; attribute += attribute_stride)
+	{
+		if (lookup_name(attribute[0]) == csdl_name::Type)
+		{
+			return_type = type_reference(attribute, false);
+		}
+	}
+
+	m_current_operation->set_return_type(return_type ? return_type : std::make_shared<edm_named_type>());
+}
+
+#endif
+
+}}
@@ -0,0 +1,971 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_model_snapshot.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/edm/edm_model_snapshot.h"
+#include <fstream>
+#include <iterator>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace odata { namespace edm
+{
+
+namespace
+{
+
+const unsigned char snapshot_magic[4] = { 'O', 'D', 'M', 'S' };
+const size_t snapshot_header_size = 20;
+const uint32_t no_index = 0xffffffff;
+
+namespace snapshot_type_reference {
+enum {
+	Null,
+	Primitive,
+	Declared,
+	Collection,
+	Navigation,
+	Named,
+	EdmUnknown
+};
+}
+
+std::shared_ptr<edm_primitive_type> primitive_type_from_kind(uint8_t kind)
+{
+	switch (kind)
+	{
+	case edm_primitive_type_kind_t::Binary: return edm_primitive_type::BINARY();
+	case edm_primitive_type_kind_t::Boolean: return edm_primitive_type::BOOLEAN();
+	case edm_primitive_type_kind_t::Byte: return edm_primitive_type::BYTE();
+	case edm_primitive_type_kind_t::DateTimeOffset: return edm_primitive_type::DATETIMEOFFSET();
+	case edm_primitive_type_kind_t::Duration: return edm_primitive_type::DURATION();
+	case edm_primitive_type_kind_t::Decimal: return edm_primitive_type::DECIMAL();
+	case edm_primitive_type_kind_t::Double: return edm_primitive_type::DOUBLE();
+	case edm_primitive_type_kind_t::Guid: return edm_primitive_type::GUID();
+	case edm_primitive_type_kind_t::Int16: return edm_primitive_type::INT16();
+	case edm_primitive_type_kind_t::Int32: return edm_primitive_type::INT32();
+	case edm_primitive_type_kind_t::Int64: return edm_primitive_type::INT64();
+	case edm_primitive_type_kind_t::SByte: return edm_primitive_type::SBYTE();
+	case edm_primitive_type_kind_t::Single: return edm_primitive_type::SINGLE();
+	case edm_primitive_type_kind_t::String: return edm_primitive_type::STRING();
+	case edm_primitive_type_kind_t::Stream: return edm_primitive_type::STREAM();
+	case edm_primitive_type_kind_t::NoneVal: return edm_primitive_type::UNKNOWN();
+	default:
+		throw std::invalid_argument("Invalid model snapshot: unknown primitive type kind.");
+	}
+}
+
+template <typename T>
+std::vector<std::shared_ptr<T>> sorted_by_name(const std::unordered_map<::odata::utility::string_t, std::shared_ptr<T>>& items)
+{
+	// Sorting keeps the snapshot of a given model byte-for-byte reproducible.
+	std::vector<std::shared_ptr<T>> ret;
+	ret.reserve(items.size());
+	for (auto iter = items.cbegin(); iter != items.cend(); ++iter)
+	{
+		ret.push_back(iter->second);
+	}
+
+	std::sort(ret.begin(), ret.end(), [](const std::shared_ptr<T>& left, const std::shared_ptr<T>& right)
+	{
+		return left->get_name() < right->get_name();
+	});
+	return ret;
+}
+
+}
+
+// --BEGIN-- edm_model_snapshot_writer
+
+void edm_model_snapshot_writer::write_model(std::shared_ptr<edm_model> model)
+{
+	if (!model)
+	{
+		throw std::invalid_argument("Cannot write a snapshot of a null model.");
+	}
+
+	collect(model);
+
+	const auto &schemata = model->get_schema();
+
+	write_string(model->get_version());
+	write_u32((uint32_t)schemata.size());
+	for (auto schema = schemata.cbegin(); schema != schemata.cend(); ++schema)
+	{
+		write_string((*schema)->get_name());
+		write_string((*schema)->get_alias());
+	}
+
+	// Declarations: every type and navigation source is created before anything refers to it.
+	write_u32((uint32_t)m_types.size());
+	for (size_t i = 0; i < m_types.size(); i++)
+	{
+		auto type = m_types[i];
+		write_u32(m_type_schemas[i]);
+		write_u8((uint8_t)type->get_type_kind());
+		write_string(type->get_name());
+
+		switch (type->get_type_kind())
+		{
+		case edm_type_kind_t::Enum:
+			{
+				auto enum_type = std::static_pointer_cast<edm_enum_type>(type);
+				write_string(enum_type->get_underlying_type_name());
+				write_u8(enum_type->is_flag() ? 1 : 0);
+			}
+			break;
+		case edm_type_kind_t::Complex:
+		case edm_type_kind_t::Entity:
+			{
+				auto structured_type = std::static_pointer_cast<edm_structured_type>(type);
+				write_string(structured_type->get_base_type_name());
+				write_u8(structured_type->is_abstract() ? 1 : 0);
+				write_u8(structured_type->is_open_type() ? 1 : 0);
+				auto entity_type = std::dynamic_pointer_cast<edm_entity_type>(type);
+				write_u8(entity_type && entity_type->has_stream() ? 1 : 0);
+			}
+			break;
+		case edm_type_kind_t::Operation:
+			{
+				auto operation_type = std::static_pointer_cast<edm_operation_type>(type);
+				write_u8(operation_type->is_bound() ? 1 : 0);
+				write_string(operation_type->get_path());
+				write_u8(operation_type->is_function() ? 1 : 0);
+				write_u8(operation_type->is_composable() ? 1 : 0);
+				write_string(operation_type->get_return_type_name());
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	write_u32((uint32_t)m_containers.size());
+	for (size_t i = 0; i < m_containers.size(); i++)
+	{
+		auto container = m_containers[i];
+		write_u32(m_container_schemas[i]);
+		write_string(container->get_name());
+		write_u8(container->is_default_container() ? 1 : 0);
+
+		const auto &entity_sets = container->get_entity_set_vector();
+		write_u32((uint32_t)entity_sets.size());
+		for (auto entity_set = entity_sets.cbegin(); entity_set != entity_sets.cend(); ++entity_set)
+		{
+			write_string((*entity_set)->get_name());
+			write_string((*entity_set)->get_entity_type_name());
+		}
+
+		const auto &singletons = container->get_singleton_vector();
+		write_u32((uint32_t)singletons.size());
+		for (auto singleton = singletons.cbegin(); singleton != singletons.cend(); ++singleton)
+		{
+			write_string((*singleton)->get_name());
+			write_string((*singleton)->get_entity_type_name());
+		}
+
+		const auto &operation_imports = container->get_operation_import_vector();
+		write_u32((uint32_t)operation_imports.size());
+		for (auto operation_import = operation_imports.cbegin(); operation_import != operation_imports.cend(); ++operation_import)
+		{
+			write_string((*operation_import)->get_name());
+			write_string((*operation_import)->get_operation_name());
+			write_string((*operation_import)->get_entity_set_name());
+			write_u8((*operation_import)->is_in_service_document() ? 1 : 0);
+			write_u8((uint8_t)(*operation_import)->get_operation_import_kind());
+		}
+	}
+
+	// Definitions: members and resolved references, in declaration order.
+	for (auto iter = m_types.cbegin(); iter != m_types.cend(); ++iter)
+	{
+		auto type = *iter;
+		switch (type->get_type_kind())
+		{
+		case edm_type_kind_t::Enum:
+			{
+				const auto &members = std::static_pointer_cast<edm_enum_type>(type)->get_enum_members();
+				write_u32((uint32_t)members.size());
+				for (auto member = members.cbegin(); member != members.cend(); ++member)
+				{
+					write_string((*member)->get_enum_member_name());
+					write_u64((uint64_t)(*member)->get_enum_member_value());
+				}
+			}
+			break;
+		case edm_type_kind_t::Complex:
+		case edm_type_kind_t::Entity:
+			write_structured_type(std::static_pointer_cast<edm_structured_type>(type));
+			break;
+		case edm_type_kind_t::Operation:
+			{
+				auto operation_type = std::static_pointer_cast<edm_operation_type>(type);
+				const auto &parameters = operation_type->get_operation_parameters();
+				write_u32((uint32_t)parameters.size());
+				for (auto parameter = parameters.cbegin(); parameter != parameters.cend(); ++parameter)
+				{
+					write_string((*parameter)->get_param_name());
+					write_type_reference((*parameter)->get_param_type());
+				}
+				write_type_reference(operation_type->get_operation_return_type());
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	for (auto iter = m_containers.cbegin(); iter != m_containers.cend(); ++iter)
+	{
+		const auto &entity_sets = (*iter)->get_entity_set_vector();
+		for (auto entity_set = entity_sets.cbegin(); entity_set != entity_sets.cend(); ++entity_set)
+		{
+			write_type_reference((*entity_set)->get_entity_type());
+			write_navigation_source_bindings(*entity_set);
+		}
+
+		const auto &singletons = (*iter)->get_singleton_vector();
+		for (auto singleton = singletons.cbegin(); singleton != singletons.cend(); ++singleton)
+		{
+			write_type_reference((*singleton)->get_entity_type());
+			write_navigation_source_bindings(*singleton);
+		}
+
+		const auto &operation_imports = (*iter)->get_operation_import_vector();
+		for (auto operation_import = operation_imports.cbegin(); operation_import != operation_imports.cend(); ++operation_import)
+		{
+			write_type_reference((*operation_import)->get_operation_type());
+		}
+	}
+
+	// The string table is only complete now, so it is emitted in front of the body at the very end.
+	std::vector<unsigned char> body;
+	body.swap(m_body);
+	write_u32((uint32_t)m_strings.size());
+	for (auto iter = m_strings.cbegin(); iter != m_strings.cend(); ++iter)
+	{
+		auto utf8 = ::odata::utility::conversions::to_utf8string(*iter);
+		write_u32((uint32_t)utf8.size());
+		m_body.insert(m_body.end(), utf8.begin(), utf8.end());
+	}
+	m_body.insert(m_body.end(), body.begin(), body.end());
+	body.swap(m_body);
+
+	m_body.assign(snapshot_magic, snapshot_magic + sizeof(snapshot_magic));
+	write_u32(EDM_MODEL_SNAPSHOT_FORMAT_VERSION);
+	write_u32(0);
+	write_u64(body.size());
+
+	m_stream.write(reinterpret_cast<const char*>(m_body.data()), m_body.size());
+	m_stream.write(reinterpret_cast<const char*>(body.data()), body.size());
+	m_body.clear();
+}
+
+void edm_model_snapshot_writer::collect(std::shared_ptr<edm_model> model)
+{
+	m_body.clear();
+	m_strings.clear();
+	m_string_ids.clear();
+	m_types.clear();
+	m_type_schemas.clear();
+	m_type_ids.clear();
+	m_containers.clear();
+	m_container_schemas.clear();
+	m_navigation_source_ids.clear();
+
+	const auto &schemata = model->get_schema();
+	for (uint32_t schema_index = 0; schema_index < schemata.size(); schema_index++)
+	{
+		auto schema = schemata[schema_index];
+		std::vector<std::shared_ptr<edm_named_type>> types;
+
+		auto enum_types = sorted_by_name(schema->get_enum_types());
+		types.insert(types.end(), enum_types.begin(), enum_types.end());
+		auto complex_types = sorted_by_name(schema->get_complex_types());
+		types.insert(types.end(), complex_types.begin(), complex_types.end());
+		auto entity_types = sorted_by_name(schema->get_entity_types());
+		types.insert(types.end(), entity_types.begin(), entity_types.end());
+		auto operation_types = sorted_by_name(schema->get_operation_types());
+		types.insert(types.end(), operation_types.begin(), operation_types.end());
+
+		for (auto type = types.cbegin(); type != types.cend(); ++type)
+		{
+			m_type_ids[type->get()] = (uint32_t)m_types.size();
+			m_types.push_back(*type);
+			m_type_schemas.push_back(schema_index);
+		}
+
+		auto containers = sorted_by_name(schema->get_containers());
+		for (auto container = containers.cbegin(); container != containers.cend(); ++container)
+		{
+			auto container_index = (uint32_t)m_containers.size();
+			m_containers.push_back(*container);
+			m_container_schemas.push_back(schema_index);
+
+			// Singletons are numbered after the entity sets of the same container.
+			const auto &entity_sets = (*container)->get_entity_set_vector();
+			const auto &singletons = (*container)->get_singleton_vector();
+			for (uint32_t i = 0; i < entity_sets.size(); i++)
+			{
+				m_navigation_source_ids[entity_sets[i].get()] = std::make_pair(container_index, i);
+			}
+			for (uint32_t i = 0; i < singletons.size(); i++)
+			{
+				m_navigation_source_ids[singletons[i].get()] = std::make_pair(container_index, (uint32_t)entity_sets.size() + i);
+			}
+		}
+	}
+}
+
+void edm_model_snapshot_writer::write_structured_type(std::shared_ptr<edm_structured_type> structured_type)
+{
+	auto base_type = structured_type->get_base_type();
+	auto base = base_type ? m_type_ids.find(base_type.get()) : m_type_ids.end();
+	write_u32(base != m_type_ids.end() ? base->second : no_index);
+
+	auto entity_type = std::dynamic_pointer_cast<edm_entity_type>(structured_type);
+	if (entity_type)
+	{
+		const auto &key = entity_type->key();
+		write_u32((uint32_t)key.size());
+		for (auto iter = key.cbegin(); iter != key.cend(); ++iter)
+		{
+			write_string(*iter);
+		}
+	}
+
+	const auto &properties = structured_type->get_properties_vector();
+	write_u32((uint32_t)properties.size());
+	for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter)
+	{
+		auto property = *iter;
+		write_string(property->get_name());
+		write_u8(property->is_nullable() ? 1 : 0);
+		write_u8(property->is_unicode() ? 1 : 0);
+		write_u32(property->get_max_length());
+		write_u32(property->get_scale());
+		write_u32(property->get_precision());
+		write_type_reference(property->get_property_type());
+	}
+}
+
+void edm_model_snapshot_writer::write_navigation_source_bindings(std::shared_ptr<edm_navigation_source> navigation_source)
+{
+	std::map<::odata::utility::string_t, ::odata::utility::string_t> bindings(
+		navigation_source->get_navigation_sources().cbegin(), navigation_source->get_navigation_sources().cend());
+	write_u32((uint32_t)bindings.size());
+	for (auto iter = bindings.cbegin(); iter != bindings.cend(); ++iter)
+	{
+		write_string(iter->first);
+		write_string(iter->second);
+	}
+
+	const auto& concurrency_properties = navigation_source->get_concurrency_properties();
+	write_u32((uint32_t)concurrency_properties.size());
+	for (auto iter = concurrency_properties.cbegin(); iter != concurrency_properties.cend(); ++iter)
+	{
+		write_string(*iter);
+	}
+}
+
+void edm_model_snapshot_writer::write_type_reference(std::shared_ptr<edm_named_type> type)
+{
+	if (!type)
+	{
+		write_u8(snapshot_type_reference::Null);
+		return;
+	}
+
+	auto declared = m_type_ids.find(type.get());
+	if (declared != m_type_ids.end())
+	{
+		write_u8(snapshot_type_reference::Declared);
+		write_u32(declared->second);
+		return;
+	}
+
+	if (type == edm_named_type::EDM_UNKNOWN())
+	{
+		write_u8(snapshot_type_reference::EdmUnknown);
+		return;
+	}
+
+	auto primitive_type = std::dynamic_pointer_cast<edm_primitive_type>(type);
+	if (primitive_type)
+	{
+		write_u8(snapshot_type_reference::Primitive);
+		write_u8((uint8_t)primitive_type->get_primitive_kind());
+		return;
+	}
+
+	auto collection_type = std::dynamic_pointer_cast<edm_collection_type>(type);
+	if (collection_type)
+	{
+		write_u8(snapshot_type_reference::Collection);
+		write_string(collection_type->get_name());
+		write_string(collection_type->get_namespace());
+		write_type_reference(collection_type->get_element_type());
+		return;
+	}
+
+	auto navigation_type = std::dynamic_pointer_cast<edm_navigation_type>(type);
+	if (navigation_type)
+	{
+		write_u8(snapshot_type_reference::Navigation);
+		write_string(navigation_type->get_name());
+		write_string(navigation_type->get_navigation_partner_name());
+		write_u8(navigation_type->is_contained() ? 1 : 0);
+		write_type_reference(navigation_type->get_navigation_type());
+		write_navigation_source_reference(navigation_type->get_binded_navigation_source());
+		return;
+	}
+
+	write_u8(snapshot_type_reference::Named);
+	write_string(type->get_name());
+	write_string(type->get_namespace());
+	write_u8((uint8_t)type->get_type_kind());
+}
+
+void edm_model_snapshot_writer::write_navigation_source_reference(std::shared_ptr<edm_navigation_source> navigation_source)
+{
+	auto found = navigation_source ? m_navigation_source_ids.find(navigation_source.get()) : m_navigation_source_ids.end();
+	if (found == m_navigation_source_ids.end())
+	{
+		write_u32(no_index);
+		return;
+	}
+
+	write_u32(found->second.first);
+	write_u32(found->second.second);
+}
+
+uint32_t edm_model_snapshot_writer::intern(const ::odata::utility::string_t& value)
+{
+	auto found = m_string_ids.find(value);
+	if (found != m_string_ids.end())
+	{
+		return found->second;
+	}
+
+	auto id = (uint32_t)m_strings.size();
+	m_strings.push_back(value);
+	m_string_ids[value] = id;
+	return id;
+}
+
+void edm_model_snapshot_writer::write_u8(uint8_t value)
+{
+	m_body.push_back(value);
+}
+
+void edm_model_snapshot_writer::write_u32(uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		m_body.push_back((unsigned char)(value >> (8 * i)));
+	}
+}
+
+void edm_model_snapshot_writer::write_u64(uint64_t value)
+{
+	for (int i = 0; i < 8; i++)
+	{
+		m_body.push_back((unsigned char)(value >> (8 * i)));
+	}
+}
+
+void edm_model_snapshot_writer::write_string(const ::odata::utility::string_t& value)
+{
+	write_u32(intern(value));
+}
+
+// --END-- edm_model_snapshot_writer
+
+// --BEGIN-- edm_model_snapshot_reader
+
+std::shared_ptr<edm_model> edm_model_snapshot_reader::read_model()
+{
+	m_pos = 0;
+	m_strings.clear();
+	m_types.clear();
+	m_containers.clear();
+	m_model = std::make_shared<edm_model>();
+
+	require(snapshot_header_size);
+	if (!std::equal(snapshot_magic, snapshot_magic + sizeof(snapshot_magic), m_data))
+	{
+		throw std::invalid_argument("Invalid model snapshot: bad magic.");
+	}
+	m_pos += sizeof(snapshot_magic);
+
+	if (read_u32() != EDM_MODEL_SNAPSHOT_FORMAT_VERSION)
+	{
+		throw std::invalid_argument("Unsupported model snapshot format version.");
+	}
+	read_u32();
+
+	auto body_size = read_u64();
+	if (body_size != m_size - m_pos)
+	{
+		throw std::invalid_argument("Invalid model snapshot: size mismatch.");
+	}
+
+	auto string_count = read_u32();
+	require(string_count * (size_t)4);
+	m_strings.reserve(string_count);
+	for (uint32_t i = 0; i < string_count; i++)
+	{
+		auto length = read_u32();
+		require(length);
+		m_strings.push_back(::odata::utility::conversions::to_string_t(std::string(reinterpret_cast<const char*>(m_data + m_pos), length)));
+		m_pos += length;
+	}
+
+	m_model->set_version(read_string());
+
+	auto schema_count = read_u32();
+	std::vector<std::shared_ptr<edm_schema>> schemata;
+	for (uint32_t i = 0; i < schema_count; i++)
+	{
+		auto &name = read_string();
+		auto &alias = read_string();
+		schemata.push_back(m_model->add_schema(name, alias));
+	}
+
+	auto type_count = read_u32();
+	require(type_count * (size_t)9);
+	m_types.reserve(type_count);
+	for (uint32_t i = 0; i < type_count; i++)
+	{
+		auto schema = schemata[read_index(schemata.size())];
+		auto kind = read_u8();
+		auto &name = read_string();
+
+		switch (kind)
+		{
+		case edm_type_kind_t::Enum:
+			{
+				auto &underlying_type = read_string();
+				auto enum_type = std::make_shared<edm_enum_type>(name, schema->get_name(), underlying_type, read_bool());
+				schema->add_enum_type(enum_type);
+				m_types.push_back(enum_type);
+			}
+			break;
+		case edm_type_kind_t::Complex:
+			{
+				auto &base_type = read_string();
+				auto is_abstract = read_bool();
+				auto is_open_type = read_bool();
+				read_bool();
+				auto complex_type = std::make_shared<edm_complex_type>(name, schema->get_name(), base_type, is_abstract, is_open_type);
+				schema->add_complex_type(complex_type);
+				m_types.push_back(complex_type);
+			}
+			break;
+		case edm_type_kind_t::Entity:
+			{
+				auto &base_type = read_string();
+				auto is_abstract = read_bool();
+				auto is_open_type = read_bool();
+				auto has_stream = read_bool();
+				auto entity_type = std::make_shared<edm_entity_type>(name, schema->get_name(), base_type, is_abstract, is_open_type, has_stream);
+				schema->add_entity_type(entity_type);
+				m_types.push_back(entity_type);
+			}
+			break;
+		case edm_type_kind_t::Operation:
+			{
+				auto is_bound = read_bool();
+				auto &path = read_string();
+				auto operation_kind = read_bool() ? EdmOperationKind::Function : EdmOperationKind::Action;
+				auto is_composable = read_bool();
+				auto operation_type = std::make_shared<edm_operation_type>(name, schema->get_name(), is_bound, path, operation_kind, is_composable);
+				operation_type->set_return_type_name(read_string());
+				schema->add_operation_type(operation_type);
+				m_types.push_back(operation_type);
+			}
+			break;
+		default:
+			throw std::invalid_argument("Invalid model snapshot: unexpected declared type kind.");
+		}
+	}
+
+	auto container_count = read_u32();
+	m_containers.reserve(container_count);
+	for (uint32_t i = 0; i < container_count; i++)
+	{
+		auto schema = schemata[read_index(schemata.size())];
+		auto &name = read_string();
+		auto container = std::make_shared<edm_entity_container>(name, read_bool());
+
+		auto entity_set_count = read_u32();
+		for (uint32_t j = 0; j < entity_set_count; j++)
+		{
+			auto &entity_set_name = read_string();
+			container->add_entity_set(std::make_shared<edm_entity_set>(entity_set_name, read_string()));
+		}
+
+		auto singleton_count = read_u32();
+		for (uint32_t j = 0; j < singleton_count; j++)
+		{
+			auto &singleton_name = read_string();
+			container->add_singleton(std::make_shared<edm_singleton>(singleton_name, read_string()));
+		}
+
+		auto operation_import_count = read_u32();
+		for (uint32_t j = 0; j < operation_import_count; j++)
+		{
+			auto &operation_import_name = read_string();
+			auto &operation_name = read_string();
+			auto &entity_set_path = read_string();
+			auto is_in_service_document = read_bool();
+			auto operation_import_kind = read_u8() == OperationImportKind::FunctionImport ? OperationImportKind::FunctionImport : OperationImportKind::ActionImport;
+			container->add_operation_import(std::make_shared<edm_operation_import>(
+				operation_import_name, operation_name, entity_set_path, is_in_service_document, operation_import_kind));
+		}
+
+		schema->add_container(container);
+		m_containers.push_back(container);
+	}
+
+	for (auto iter = m_types.cbegin(); iter != m_types.cend(); ++iter)
+	{
+		auto type = *iter;
+		switch (type->get_type_kind())
+		{
+		case edm_type_kind_t::Enum:
+			{
+				auto enum_type = std::static_pointer_cast<edm_enum_type>(type);
+				auto member_count = read_u32();
+				for (uint32_t i = 0; i < member_count; i++)
+				{
+					auto &member_name = read_string();
+					enum_type->add_enum_member(std::make_shared<edm_enum_member>(member_name, (unsigned long)read_u64()));
+				}
+			}
+			break;
+		case edm_type_kind_t::Complex:
+		case edm_type_kind_t::Entity:
+			read_structured_type(std::static_pointer_cast<edm_structured_type>(type));
+			break;
+		case edm_type_kind_t::Operation:
+			{
+				auto operation_type = std::static_pointer_cast<edm_operation_type>(type);
+				auto parameter_count = read_u32();
+				for (uint32_t i = 0; i < parameter_count; i++)
+				{
+					auto &parameter_name = read_string();
+					operation_type->add_operation_parameter(std::make_shared<edm_operation_parameter>(parameter_name, read_type_reference()));
+				}
+				operation_type->set_return_type(read_type_reference());
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	for (auto iter = m_containers.cbegin(); iter != m_containers.cend(); ++iter)
+	{
+		const auto &entity_sets = (*iter)->get_entity_set_vector();
+		for (auto entity_set = entity_sets.cbegin(); entity_set != entity_sets.cend(); ++entity_set)
+		{
+			(*entity_set)->set_entity_type(std::dynamic_pointer_cast<edm_entity_type>(read_type_reference()));
+			read_navigation_source_bindings(*entity_set);
+		}
+
+		const auto &singletons = (*iter)->get_singleton_vector();
+		for (auto singleton = singletons.cbegin(); singleton != singletons.cend(); ++singleton)
+		{
+			(*singleton)->set_entity_type(std::dynamic_pointer_cast<edm_entity_type>(read_type_reference()));
+			read_navigation_source_bindings(*singleton);
+		}
+
+		const auto &operation_imports = (*iter)->get_operation_import_vector();
+		for (auto operation_import = operation_imports.cbegin(); operation_import != operation_imports.cend(); ++operation_import)
+		{
+			(*operation_import)->set_operation_type(std::dynamic_pointer_cast<edm_operation_type>(read_type_reference()));
+		}
+	}
+
+	if (m_pos != m_size)
+	{
+		throw std::invalid_argument("Invalid model snapshot: trailing data.");
+	}
+
+	auto model = m_model;
+	m_model.reset();
+	m_types.clear();
+	m_containers.clear();
+	return model;
+}
+
+std::shared_ptr<edm_model> edm_model_snapshot_reader::read_file(const std::string& path)
+{
+#ifndef WIN32
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Cannot open model snapshot " + path);
+	}
+
+	struct stat info;
+	if (::fstat(fd, &info) != 0 || info.st_size <= 0)
+	{
+		::close(fd);
+		throw std::invalid_argument("Invalid model snapshot " + path);
+	}
+
+	auto size = (size_t)info.st_size;
+	void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		throw std::runtime_error("Cannot map model snapshot " + path);
+	}
+
+	try
+	{
+		edm_model_snapshot_reader reader(data, size);
+		auto model = reader.read_model();
+		::munmap(data, size);
+		return model;
+	}
+	catch (...)
+	{
+		::munmap(data, size);
+		throw;
+	}
+#else
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		throw std::runtime_error("Cannot open model snapshot " + path);
+	}
+
+	std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	edm_model_snapshot_reader reader(data.data(), data.size());
+	return reader.read_model();
+#endif
+}
+
+void edm_model_snapshot_reader::read_structured_type(std::shared_ptr<edm_structured_type> structured_type)
+{
+	auto base_index = read_index(m_types.size(), true);
+	if (base_index != no_index)
+	{
+		auto base_type = std::dynamic_pointer_cast<edm_structured_type>(m_types[base_index]);
+		if (!base_type)
+		{
+			throw std::invalid_argument("Invalid model snapshot: base type is not a structured type.");
+		}
+		structured_type->set_base_type(base_type);
+	}
+
+	auto entity_type = std::dynamic_pointer_cast<edm_entity_type>(structured_type);
+	if (entity_type)
+	{
+		auto key_count = read_u32();
+		for (uint32_t i = 0; i < key_count; i++)
+		{
+			entity_type->add_key_property(read_string());
+		}
+	}
+
+	auto property_count = read_u32();
+	for (uint32_t i = 0; i < property_count; i++)
+	{
+		auto &name = read_string();
+		auto is_nullable = read_bool();
+		auto is_unicode = read_bool();
+		auto max_length = read_u32();
+		auto scale = read_u32();
+		auto precision = read_u32();
+
+		auto property = std::make_shared<edm_property_type>(name, is_nullable, max_length, is_unicode, scale);
+		property->set_precision(precision);
+		property->set_property_type(read_type_reference());
+		structured_type->add_property(property);
+	}
+}
+
+void edm_model_snapshot_reader::read_navigation_source_bindings(std::shared_ptr<edm_navigation_source> navigation_source)
+{
+	auto binding_count = read_u32();
+	for (uint32_t i = 0; i < binding_count; i++)
+	{
+		auto &path = read_string();
+		navigation_source->add_navigation_source(path, read_string());
+	}
+
+	auto concurrency_property_count = read_u32();
+	for (uint32_t i = 0; i < concurrency_property_count; i++)
+	{
+		navigation_source->add_concurrency_property(read_string());
+	}
+}
+
+std::shared_ptr<edm_named_type> edm_model_snapshot_reader::read_type_reference()
+{
+	switch (read_u8())
+	{
+	case snapshot_type_reference::Null:
+		return nullptr;
+
+	case snapshot_type_reference::Primitive:
+		return primitive_type_from_kind(read_u8());
+
+	case snapshot_type_reference::Declared:
+		{
+			return m_types[read_index(m_types.size())];
+		}
+
+	case snapshot_type_reference::EdmUnknown:
+		return edm_named_type::EDM_UNKNOWN();
+
+	case snapshot_type_reference::Collection:
+		{
+			auto &name = read_string();
+			auto &name_space = read_string();
+			auto element_type = read_type_reference();
+
+			std::shared_ptr<edm_collection_type> collection_type;
+			if (element_type)
+			{
+				collection_type = std::make_shared<edm_collection_type>(element_type);
+			}
+			else
+			{
+				// The element type of this collection was never resolved; keep the collection with its name only.
+				collection_type = std::make_shared<edm_collection_type>(std::make_shared<edm_named_type>(name, name_space, edm_type_kind_t::Unknown));
+			}
+			collection_type->set_name(name);
+			collection_type->set_namespace(name_space);
+			return collection_type;
+		}
+
+	case snapshot_type_reference::Navigation:
+		{
+			auto &name = read_string();
+			auto &partner_name = read_string();
+			auto is_contained = read_bool();
+			auto navigation_type = std::make_shared<edm_navigation_type>(name, partner_name, is_contained);
+
+			auto target_type = read_type_reference();
+			if (target_type && target_type->get_type_kind() == edm_type_kind_t::Collection && !m_model->get_schema().empty())
+			{
+				// The navigation type only holds a weak reference, the first schema owns collection targets.
+				m_model->get_schema()[0]->m_collection_navigation_types.push_back(std::static_pointer_cast<edm_collection_type>(target_type));
+			}
+			navigation_type->set_navigation_type(target_type);
+
+			auto navigation_source = read_navigation_source_reference();
+			if (navigation_source)
+			{
+				navigation_type->set_binded_navigation_source(navigation_source);
+			}
+			return navigation_type;
+		}
+
+	case snapshot_type_reference::Named:
+		{
+			auto &name = read_string();
+			auto &name_space = read_string();
+			auto kind = read_u8();
+			if (kind > edm_type_kind_t::Unknown)
+			{
+				throw std::invalid_argument("Invalid model snapshot: unknown type kind.");
+			}
+			return std::make_shared<edm_named_type>(name, name_space, (edm_type_kind_t)kind);
+		}
+
+	default:
+		throw std::invalid_argument("Invalid model snapshot: unknown type reference.");
+	}
+}
+
+std::shared_ptr<edm_navigation_source> edm_model_snapshot_reader::read_navigation_source_reference()
+{
+	auto container_index = read_index(m_containers.size(), true);
+	if (container_index == no_index)
+	{
+		return nullptr;
+	}
+
+	auto container = m_containers[container_index];
+	const auto &entity_sets = container->get_entity_set_vector();
+	const auto &singletons = container->get_singleton_vector();
+	auto index = read_index(entity_sets.size() + singletons.size());
+	if (index < entity_sets.size())
+	{
+		return entity_sets[index];
+	}
+	return singletons[index - entity_sets.size()];
+}
+
+void edm_model_snapshot_reader::require(size_t count)
+{
+	if (count > m_size - m_pos)
+	{
+		throw std::invalid_argument("Invalid model snapshot: unexpected end of data.");
+	}
+}
+
+uint8_t edm_model_snapshot_reader::read_u8()
+{
+	require(1);
+	return m_data[m_pos++];
+}
+
+uint32_t edm_model_snapshot_reader::read_u32()
+{
+	require(4);
+	uint32_t value = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		value |= (uint32_t)m_data[m_pos++] << (8 * i);
+	}
+	return value;
+}
+
+uint64_t edm_model_snapshot_reader::read_u64()
+{
+	require(8);
+	uint64_t value = 0;
+	for (int i = 0; i < 8; i++)
+	{
+		value |= (uint64_t)m_data[m_pos++] << (8 * i);
+	}
+	return value;
+}
+
+const ::odata::utility::string_t& edm_model_snapshot_reader::read_string()
+{
+	auto index = read_u32();
+	if (index >= m_strings.size())
+	{
+		throw std::invalid_argument("Invalid model snapshot: string index out of range.");
+	}
+	return m_strings[index];
+}
+
+uint32_t edm_model_snapshot_reader::read_index(size_t count, bool optional)
+{
+	auto index = read_u32();
+	if (index == no_index ? !optional : index >= count)
+	{
+		throw std::invalid_argument("Invalid model snapshot: index out of range.");
+	}
+	return index;
+}
+
+// --END-- edm_model_snapshot_reader
+
+}}
@@ -5,6 +5,7 @@
 //---------------------------------------------------------------------
 
 #include "odata/edm/edm_model_utility.h"
+#include <thread>
 
 namespace odata { namespace edm
 {
@@ -36,8 +37,8 @@ const std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>
 	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>::value_type(U("Edm.Binary"), U("std::vector<unsigned char>")),
 	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>::value_type(U("Edm.Boolean"), U("bool")),
 	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>::value_type(U("Edm.Byte"), U("uint8_t")),
-	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>::value_type(U("Edm.Duration"), U("::utility::seconds")),
-	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>::value_type(U("Edm.DateTimeOffset"), U("::utility::datetime")),
+	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>::value_type(U("Edm.Duration"), U("::odata::utility::seconds")),
+	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>::value_type(U("Edm.DateTimeOffset"), U("::odata::utility::datetime")),
 	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>::value_type(U("Edm.Double"), U("double")),
 	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>::value_type(U("Edm.Decimal"), U("long double")),
 	std::unordered_map<::odata::utility::string_t, ::odata::utility::string_t>::value_type(U("Edm.Guid"), U("::odata::utility::string_t")),
@@ -177,38 +178,100 @@ bool edm_model_utility::get_primitive_kind_from_edm_type(const std::shared_ptr<e
 	return false;
 }
 
-void edm_model_utility::resolve_edm_types_after_parsing(const std::shared_ptr<edm_model>& model)
+void edm_model_utility::resolve_edm_types_after_parsing(const std::shared_ptr<edm_model>& model, edm_type_resolution_t resolution)
 {
 	if (!model)
 	{
 		return ;
 	}
 
+	if (resolution == edm_type_resolution_t::Eager)
+	{
+		for (auto sc = model->get_schema().cbegin(); sc != model->get_schema().cend(); ++sc)
+		{
+			auto &collection_navigation_types = model->get_schema()[0]->m_collection_navigation_types;
+
+			const auto &entity_types = (*sc)->get_entity_types();
+			for (auto entity_type_iter = entity_types.cbegin(); entity_type_iter != entity_types.cend(); ++entity_type_iter)
+			{
+				resolve_type_under_structured_type(model, entity_type_iter->second.get(), collection_navigation_types);
+
+				resovle_entity_base_type(model, entity_type_iter->second);
+			}
+
+			const auto &complex_types = (*sc)->get_complex_types();
+			for (auto complex_type_iter = complex_types.cbegin(); complex_type_iter != complex_types.cend(); ++complex_type_iter)
+			{
+				resolve_type_under_structured_type(model, complex_type_iter->second.get(), collection_navigation_types);
+
+				resovle_complex_base_type(model, complex_type_iter->second);
+			}
+
+			const auto &operation_types = (*sc)->get_operation_types();
+			for (auto operation_type_iter = operation_types.cbegin(); operation_type_iter != operation_types.cend(); ++operation_type_iter)
+			{
+				resolve_type_under_operation_type(model, operation_type_iter->second);
+			}
+
+			const auto &entity_containers = (*sc)->get_containers();
+			for (auto entity_container_iter = entity_containers.cbegin(); entity_container_iter != entity_containers.cend(); ++entity_container_iter)
+			{
+				resolve_type_under_entity_container(model, entity_container_iter->second);
+
+				resolve_navigation_path_for_non_contained_navigation(model, entity_container_iter->second);
+			}
+		}
+
+		return;
+	}
+
+	// Base types link types to each other, so they are set up front and on this thread in every mode.
+	std::vector<std::shared_ptr<edm_structured_type>> structured_types;
+	std::vector<std::shared_ptr<edm_operation_type>> operation_types;
 	for (auto sc = model->get_schema().cbegin(); sc != model->get_schema().cend(); ++sc)
 	{
-		std::unordered_map<::odata::utility::string_t, std::shared_ptr<edm_entity_type>> entity_types = (*sc)->get_entity_types();
+		const auto &entity_types = (*sc)->get_entity_types();
 		for (auto entity_type_iter = entity_types.cbegin(); entity_type_iter != entity_types.cend(); ++entity_type_iter)
 		{
-			resolve_type_under_structured_type(model, entity_type_iter->second);
-
 			resovle_entity_base_type(model, entity_type_iter->second);
+			structured_types.push_back(entity_type_iter->second);
 		}
 
-		std::unordered_map<::odata::utility::string_t, std::shared_ptr<edm_complex_type>> complex_types = (*sc)->get_complex_types();
+		const auto &complex_types = (*sc)->get_complex_types();
 		for (auto complex_type_iter = complex_types.cbegin(); complex_type_iter != complex_types.cend(); ++complex_type_iter)
 		{
-			resolve_type_under_structured_type(model, complex_type_iter->second);
-
 			resovle_complex_base_type(model, complex_type_iter->second);
+			structured_types.push_back(complex_type_iter->second);
 		}
 
-		std::unordered_map<::odata::utility::string_t, std::shared_ptr<edm_operation_type>> operation_types = (*sc)->get_operation_types();
-		for (auto operation_type_iter = operation_types.cbegin(); operation_type_iter != operation_types.cend(); ++operation_type_iter)
+		const auto &schema_operation_types = (*sc)->get_operation_types();
+		for (auto operation_type_iter = schema_operation_types.cbegin(); operation_type_iter != schema_operation_types.cend(); ++operation_type_iter)
 		{
-			resolve_type_under_operation_type(model, operation_type_iter->second);
+			operation_types.push_back(operation_type_iter->second);
 		}
+	}
+
+	if (resolution == edm_type_resolution_t::Parallel)
+	{
+		resolve_types_in_parallel(model, structured_types, operation_types);
+	}
+	else
+	{
+		for (auto iter = structured_types.cbegin(); iter != structured_types.cend(); ++iter)
+		{
+			defer_type_resolution(model, *iter);
+		}
+
+		for (auto iter = operation_types.cbegin(); iter != operation_types.cend(); ++iter)
+		{
+			resolve_type_under_operation_type(model, *iter);
+		}
+	}
 
-		std::unordered_map<::odata::utility::string_t, std::shared_ptr<edm_entity_container>> entity_containers = (*sc)->get_containers();
+	// Bindings only look at navigation properties, which exist before their target types are resolved.
+	for (auto sc = model->get_schema().cbegin(); sc != model->get_schema().cend(); ++sc)
+	{
+		const auto &entity_containers = (*sc)->get_containers();
 		for (auto entity_container_iter = entity_containers.cbegin(); entity_container_iter != entity_containers.cend(); ++entity_container_iter)
 		{
 			resolve_type_under_entity_container(model, entity_container_iter->second);
@@ -218,6 +281,118 @@ void edm_model_utility::resolve_edm_types_after_parsing(const std::shared_ptr<ed
 	}
 }
 
+void edm_model_utility::resolve_types_in_parallel(const std::shared_ptr<edm_model>& model, 
+	const std::vector<std::shared_ptr<edm_structured_type>>& structured_types, const std::vector<std::shared_ptr<edm_operation_type>>& operation_types)
+{
+	// Workers claim batches of tasks; structured types come first, then operations.
+	const size_t batch_size = 64;
+	const size_t task_count = structured_types.size() + operation_types.size();
+
+	// Every task keeps what it would have added to the model, so merging in task order gives the same model on every run.
+	std::vector<std::vector<std::shared_ptr<edm_collection_type>>> collection_navigation_types(structured_types.size());
+	std::vector<std::exception_ptr> errors(task_count);
+	std::atomic<size_t> next_task(0);
+
+	auto worker = [&]()
+	{
+		for (;;)
+		{
+			size_t first = next_task.fetch_add(batch_size);
+			if (first >= task_count)
+			{
+				return;
+			}
+
+			size_t last = std::min(first + batch_size, task_count);
+			for (size_t task = first; task < last; task++)
+			{
+				try
+				{
+					if (task < structured_types.size())
+					{
+						resolve_type_under_structured_type(model, structured_types[task].get(), collection_navigation_types[task]);
+					}
+					else
+					{
+						resolve_type_under_operation_type(model, operation_types[task - structured_types.size()]);
+					}
+				}
+				catch (...)
+				{
+					errors[task] = std::current_exception();
+				}
+			}
+		}
+	};
+
+	size_t thread_count = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), (task_count + batch_size - 1) / batch_size);
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < thread_count; i++)
+	{
+		try
+		{
+			threads.push_back(std::thread(worker));
+		}
+		catch (const std::system_error&)
+		{
+			// Make do with the threads that could be started; this thread works through the tasks as well.
+			break;
+		}
+	}
+
+	worker();
+	for (auto iter = threads.begin(); iter != threads.end(); ++iter)
+	{
+		iter->join();
+	}
+
+	for (auto iter = errors.cbegin(); iter != errors.cend(); ++iter)
+	{
+		if (*iter)
+		{
+			std::rethrow_exception(*iter);
+		}
+	}
+
+	auto &model_collection_navigation_types = model->get_schema()[0]->m_collection_navigation_types;
+	for (auto iter = collection_navigation_types.cbegin(); iter != collection_navigation_types.cend(); ++iter)
+	{
+		model_collection_navigation_types.insert(model_collection_navigation_types.end(), iter->begin(), iter->end());
+	}
+}
+
+static std::mutex& deferred_resolution_mutex()
+{
+	static std::mutex _mutex;
+	return _mutex;
+}
+
+void edm_model_utility::defer_type_resolution(const std::shared_ptr<edm_model>& model, const std::shared_ptr<edm_structured_type>& structured_type)
+{
+	// The type lives inside the model, so it must not keep the model alive.
+	std::weak_ptr<edm_model> weak_model = model;
+	auto type = structured_type.get();
+
+	type->m_resolver = [weak_model, type]()
+	{
+		auto model = weak_model.lock();
+		if (!model)
+		{
+			return;
+		}
+
+		std::vector<std::shared_ptr<edm_collection_type>> collection_navigation_types;
+		resolve_type_under_structured_type(model, type, collection_navigation_types);
+		if (!collection_navigation_types.empty())
+		{
+			std::lock_guard<std::mutex> lock(deferred_resolution_mutex());
+			auto &model_collection_navigation_types = model->get_schema()[0]->m_collection_navigation_types;
+			model_collection_navigation_types.insert(model_collection_navigation_types.end(), collection_navigation_types.begin(), collection_navigation_types.end());
+		}
+	};
+	type->m_resolved.store(false, std::memory_order_release);
+}
+
 
 std::shared_ptr<edm_named_type> edm_model_utility::resolve_type_from_name(const std::shared_ptr<edm_model>& model, ::odata::utility::string_t qualified_name)
 {
@@ -302,7 +477,7 @@ std::shared_ptr<edm_named_type> edm_model_utility::resolve_type_from_name(const
 	return element_name;
 }
 
-void edm_model_utility::resolve_type_under_structured_type(const std::shared_ptr<edm_model>& model, const std::shared_ptr<edm_structured_type>& structyred_type)
+void edm_model_utility::resolve_type_under_structured_type(const std::shared_ptr<edm_model>& model, edm_structured_type* structyred_type, std::vector<std::shared_ptr<edm_collection_type>>& collection_navigation_types)
 {
 	if (!model)
 	{
@@ -311,9 +486,10 @@ void edm_model_utility::resolve_type_under_structured_type(const std::shared_ptr
 
 	if (structyred_type)
 	{
-		for (auto propery_iter = structyred_type->begin(); propery_iter != structyred_type->end(); ++propery_iter)
+		// Reads the members directly, as the public accessors would start a deferred resolution of this very type.
+		for (auto propery_iter = structyred_type->m_property_vector.cbegin(); propery_iter != structyred_type->m_property_vector.cend(); ++propery_iter)
 		{
-			auto prop = propery_iter->second;
+			auto prop = *propery_iter;
 
 			auto property_type = prop->get_property_type();
 			if (!property_type)
@@ -353,7 +529,7 @@ void edm_model_utility::resolve_type_under_structured_type(const std::shared_ptr
 					auto resolved_type = resolve_type_from_name(model, navigation_type->get_name());
 					if (resolved_type->get_type_kind() == edm_type_kind_t::Collection)
 					{
-						model->get_schema()[0]->m_collection_navigation_types.push_back(std::dynamic_pointer_cast<edm_collection_type>(resolved_type));
+						collection_navigation_types.push_back(std::dynamic_pointer_cast<edm_collection_type>(resolved_type));
 					}
 					navigation_type->set_navigation_type(resolved_type);
 				}
@@ -536,7 +712,7 @@ std::shared_ptr<edm_navigation_type> edm_model_utility::get_navigation_property_
 		// property name
 		if (entity_type)
 		{
-			auto navigation_property = entity_type->find_property(paths.front());
+			auto navigation_property = entity_type->lookup_property(paths.front());
 
 			if (navigation_property)
 			{
@@ -556,7 +732,7 @@ std::shared_ptr<edm_navigation_type> edm_model_utility::get_navigation_property_
 
 			if (entity_type)
 			{
-				auto navigation_property = entity_type->find_property(property_name);
+				auto navigation_property = entity_type->lookup_property(property_name);
 
 				if (navigation_property)
 				{
@@ -745,4 +921,9 @@ bool edm_model_utility::is_collection_of_entity(std::shared_ptr<::odata::edm::ed
 	return true;
 }
 
+bool edm_model_utility::is_optimistic_concurrency_term(const ::odata::utility::string_t& term)
+{
+	return term == U("Org.OData.Core.V1.OptimisticConcurrency") || term == U("Core.OptimisticConcurrency");
+}
+
 }}
\ No newline at end of file
@@ -372,6 +372,7 @@ namespace odata {
                 write_end_element();
             }
 
+            write_concurrency_annotation(entity_set);
             write_end_element();
         }
 
@@ -387,6 +388,23 @@ namespace odata {
                 write_end_element();
             }
 
+            write_concurrency_annotation(singleton);
+            write_end_element();
+        }
+
+        void edm_model_writer::write_concurrency_annotation(std::shared_ptr<edm_navigation_source> navigation_source) {
+            const auto& concurrency_properties = navigation_source->get_concurrency_properties();
+            if (concurrency_properties.empty()) {
+                return;
+            }
+
+            write_start_element(U("Annotation"));
+            write_attribute_string(U(""), U("Term"), U(""), U("Org.OData.Core.V1.OptimisticConcurrency"));
+            write_start_element(U("Collection"));
+            for (auto iter = concurrency_properties.cbegin(); iter != concurrency_properties.cend(); iter++) {
+                write_element(U("PropertyPath"), *iter);
+            }
+            write_end_element();
             write_end_element();
         }
 
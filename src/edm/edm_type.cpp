@@ -10,256 +10,319 @@ namespace odata { namespace edm
 {
 
 
-std::shared_ptr<edm_named_type> edm_named_type::_EDM_UNKNOWN = nullptr;
+// The process-wide types are function-local statics: after the first call, getting one neither locks nor touches
+// a reference count, so concurrent requests do not contend on them.
+const std::shared_ptr<edm_named_type>& edm_named_type::EDM_UNKNOWN()
+{
+	static const std::shared_ptr<edm_named_type> unknown(new edm_named_type(edm_type_kind_t::Unknown));
+	return unknown;
+}
 
-std::shared_ptr<edm_named_type> edm_named_type::EDM_UNKNOWN()
+const std::shared_ptr<edm_named_type>* edm_named_type::find_static_owner(const edm_named_type* type)
 {
-	std::lock_guard<std::mutex> lock(mutex());
+	if (!type)
+	{
+		return nullptr;
+	}
 
-	if (!_EDM_UNKNOWN)
+	if (type->m_type_kind == edm_type_kind_t::Primitive)
 	{
-		_EDM_UNKNOWN.reset(new edm_named_type(edm_type_kind_t::Unknown));
+		static const std::shared_ptr<edm_named_type> primitive_owners[] =
+		{
+			edm_primitive_type::UNKNOWN(),
+			edm_primitive_type::BINARY(),
+			edm_primitive_type::BOOLEAN(),
+			edm_primitive_type::BYTE(),
+			edm_primitive_type::DATETIMEOFFSET(),
+			edm_primitive_type::DURATION(),
+			edm_primitive_type::DECIMAL(),
+			edm_primitive_type::DOUBLE(),
+			edm_primitive_type::GUID(),
+			edm_primitive_type::INT16(),
+			edm_primitive_type::INT32(),
+			edm_primitive_type::INT64(),
+			edm_primitive_type::SBYTE(),
+			edm_primitive_type::SINGLE(),
+			edm_primitive_type::STRING(),
+			edm_primitive_type::STREAM(),
+		};
+
+		auto kind = static_cast<const edm_primitive_type*>(type)->get_primitive_kind();
+		if ((size_t)kind < sizeof(primitive_owners) / sizeof(primitive_owners[0]) && primitive_owners[kind].get() == type)
+		{
+			return &primitive_owners[kind];
+		}
+		return nullptr;
 	}
 
-	return _EDM_UNKNOWN;
+	return type == EDM_UNKNOWN().get() ? &EDM_UNKNOWN() : nullptr;
 }
 
-std::mutex &edm_named_type::mutex()
+const std::shared_ptr<edm_primitive_type>* edm_primitive_type::singletons()
 {
-	static std::mutex _mutex;
-	return _mutex;
+	static const std::shared_ptr<edm_primitive_type> types[] =
+	{
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("UNKNOWN"), edm_primitive_type_kind_t::NoneVal)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Binary"), edm_primitive_type_kind_t::Binary)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Boolean"), edm_primitive_type_kind_t::Boolean)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Byte"), edm_primitive_type_kind_t::Byte)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.DateTimeOffset"), edm_primitive_type_kind_t::DateTimeOffset)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Duration"), edm_primitive_type_kind_t::Duration)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Decimal"), edm_primitive_type_kind_t::Decimal)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Double"), edm_primitive_type_kind_t::Double)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Guid"), edm_primitive_type_kind_t::Guid)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Int16"), edm_primitive_type_kind_t::Int16)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Int32"), edm_primitive_type_kind_t::Int32)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Int64"), edm_primitive_type_kind_t::Int64)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.SByte"), edm_primitive_type_kind_t::SByte)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Single"), edm_primitive_type_kind_t::Single)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.String"), edm_primitive_type_kind_t::String)),
+		std::shared_ptr<edm_primitive_type>(new edm_primitive_type(U("Edm.Stream"), edm_primitive_type_kind_t::Stream)),
+	};
+
+	return types;
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_BINARY = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_BOOLEAN = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_BYTE = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_DATETIMEOFFSET = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_DURATION = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_DECIMAL = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_DOUBLE = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_GUID = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_INT16 = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_INT32 = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_INT64 = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_SBYTE = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_SINGLE = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_STRING = nullptr;
-std::shared_ptr<edm_primitive_type> edm_primitive_type::_STREAM = nullptr;
-std::shared_ptr<edm_primitive_type>edm_primitive_type:: _UNKNOWN = nullptr;
-
-std::shared_ptr<edm_primitive_type> edm_primitive_type::BINARY() 
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::BINARY()
 {
-	std::lock_guard<std::mutex> lock(mutex());
-
-	if (!_BINARY)
-	{
-		_BINARY.reset(new edm_primitive_type(U("Edm.Binary"), edm_primitive_type_kind_t::Binary));
-	}
+	return singletons()[edm_primitive_type_kind_t::Binary];
+}
 
-	return _BINARY;
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::BOOLEAN()
+{
+	return singletons()[edm_primitive_type_kind_t::Boolean];
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::BOOLEAN() 
-{ 
-	std::lock_guard<std::mutex> lock(mutex());
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::BYTE()
+{
+	return singletons()[edm_primitive_type_kind_t::Byte];
+}
 
-	if (!_BOOLEAN)
-	{
-		_BOOLEAN.reset(new edm_primitive_type(U("Edm.Boolean"), edm_primitive_type_kind_t::Boolean));
-	}
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::DATETIMEOFFSET()
+{
+	return singletons()[edm_primitive_type_kind_t::DateTimeOffset];
+}
 
-	return _BOOLEAN;
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::DURATION()
+{
+	return singletons()[edm_primitive_type_kind_t::Duration];
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::BYTE() 
-{ 
-	std::lock_guard<std::mutex> lock(mutex());
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::DECIMAL()
+{
+	return singletons()[edm_primitive_type_kind_t::Decimal];
+}
 
-	if (!_BYTE)
-	{
-		_BYTE.reset(new edm_primitive_type(U("Edm.Byte"), edm_primitive_type_kind_t::Byte));
-	}
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::DOUBLE()
+{
+	return singletons()[edm_primitive_type_kind_t::Double];
+}
 
-	return _BYTE;
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::GUID()
+{
+	return singletons()[edm_primitive_type_kind_t::Guid];
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::DATETIMEOFFSET() 
-{ 
-	std::lock_guard<std::mutex> lock(mutex());
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::INT16()
+{
+	return singletons()[edm_primitive_type_kind_t::Int16];
+}
 
-	if (!_DATETIMEOFFSET)
-	{
-		_DATETIMEOFFSET.reset(new edm_primitive_type(U("Edm.DateTimeOffset"), edm_primitive_type_kind_t::DateTimeOffset));
-	}
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::INT32()
+{
+	return singletons()[edm_primitive_type_kind_t::Int32];
+}
 
-	return _DATETIMEOFFSET;
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::INT64()
+{
+	return singletons()[edm_primitive_type_kind_t::Int64];
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::DURATION() 
-{ 
-	std::lock_guard<std::mutex> lock(mutex());
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::SBYTE()
+{
+	return singletons()[edm_primitive_type_kind_t::SByte];
+}
 
-	if (!_DURATION)
-	{
-		_DURATION.reset(new edm_primitive_type(U("Edm.Duration"), edm_primitive_type_kind_t::Duration));
-	}
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::SINGLE()
+{
+	return singletons()[edm_primitive_type_kind_t::Single];
+}
 
-	return _DURATION;
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::STRING()
+{
+	return singletons()[edm_primitive_type_kind_t::String];
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::DECIMAL() 
-{ 
-	std::lock_guard<std::mutex> lock(mutex());
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::STREAM()
+{
+	return singletons()[edm_primitive_type_kind_t::Stream];
+}
 
-	if (!_DECIMAL)
-	{
-		_DECIMAL.reset(new edm_primitive_type(U("Edm.Decimal"), edm_primitive_type_kind_t::Decimal));
-	}
+const std::shared_ptr<edm_primitive_type>& edm_primitive_type::UNKNOWN()
+{
+	return singletons()[edm_primitive_type_kind_t::NoneVal];
+}
 
-	return _DECIMAL;
+edm_structured_type::~edm_structured_type()
+{
+	detach_from_base_types();
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::DOUBLE() 
-{ 
-	std::lock_guard<std::mutex> lock(mutex());
+void edm_structured_type::add_property(std::shared_ptr<edm_property_type> prop)
+{
+	throw_if_frozen(m_frozen);
 
-	if (!_DOUBLE)
+	auto &existing = m_properties[prop->get_name()];
+	if (existing)
 	{
-		_DOUBLE.reset(new edm_primitive_type(U("Edm.Double"), edm_primitive_type_kind_t::Double));
+		std::replace(m_property_vector.begin(), m_property_vector.end(), existing, prop);
+		existing = prop;
+		refresh_flattened_members();
+		return;
 	}
 
-	return _DOUBLE;
-}
+	m_property_vector.push_back(prop);
+	existing = prop;
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::GUID()
-{ 
-	std::lock_guard<std::mutex> lock(mutex());
-
-	if (!_GUID)
+	if (m_base_type || !m_derived_types.empty())
 	{
-		_GUID.reset(new edm_primitive_type(U("Edm.Guid"), edm_primitive_type_kind_t::Guid));
+		refresh_flattened_members();
+	}
+	else
+	{
+		// A root type nobody derives from yet, which is every type while a model is being read.
+		m_properties_with_parents.push_back(prop);
 	}
-
-	return _GUID;
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::INT16()
-{ 
-	std::lock_guard<std::mutex> lock(mutex());
+void edm_structured_type::set_base_type(const std::shared_ptr<edm_structured_type>& base_entity_type)
+{
+	throw_if_frozen(m_frozen);
 
-	if (!_INT16)
+	for (auto base = base_entity_type.get(); base; base = base->m_base_type.get())
 	{
-		_INT16.reset(new edm_primitive_type(U("Edm.Int16"), edm_primitive_type_kind_t::Int16));
+		if (base == this)
+		{
+			throw std::invalid_argument("The base type of " + get_full_name() + " would make it derive from itself.");
+		}
 	}
 
-	return _INT16;
-}
-
-std::shared_ptr<edm_primitive_type> edm_primitive_type::INT32() 
-{ 
-	std::lock_guard<std::mutex> lock(mutex());
+	detach_from_base_types();
+	m_base_type = base_entity_type;
 
-	if (!_INT32)
+	for (auto base = m_base_type.get(); base; base = base->m_base_type.get())
 	{
-		_INT32.reset(new edm_primitive_type(U("Edm.Int32"), edm_primitive_type_kind_t::Int32));
+		base->m_derived_types.push_back(this);
+		base->m_derived_types.insert(base->m_derived_types.end(), m_derived_types.begin(), m_derived_types.end());
 	}
 
-	return _INT32;
+	refresh_flattened_members();
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::INT64() 
+void edm_structured_type::detach_from_base_types()
 {
-	std::lock_guard<std::mutex> lock(mutex());
-
-	if (!_INT64)
+	for (auto base = m_base_type.get(); base; base = base->m_base_type.get())
 	{
-		_INT64.reset(new edm_primitive_type(U("Edm.Int64"), edm_primitive_type_kind_t::Int64));
+		auto &derived = base->m_derived_types;
+		derived.erase(std::remove_if(derived.begin(), derived.end(), [this](edm_structured_type* type) -> bool
+		{
+			return type == this || std::find(m_derived_types.begin(), m_derived_types.end(), type) != m_derived_types.end();
+		}), derived.end());
 	}
-
-	return _INT64;
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::SBYTE() 
+void edm_structured_type::refresh_flattened_members()
 {
-	std::lock_guard<std::mutex> lock(mutex());
+	m_properties_with_parents.clear();
+	m_property_map_with_parents.clear();
 
-	if (!_SBYTE)
+	if (m_base_type)
 	{
-		_SBYTE.reset(new edm_primitive_type(U("Edm.SByte"), edm_primitive_type_kind_t::SByte));
+		m_properties_with_parents = m_base_type->m_properties_with_parents;
+		for (auto iter = m_properties_with_parents.cbegin(); iter != m_properties_with_parents.cend(); ++iter)
+		{
+			m_property_map_with_parents[(*iter)->get_name()] = *iter;
+		}
+
+		for (auto iter = m_property_vector.cbegin(); iter != m_property_vector.cend(); ++iter)
+		{
+			m_property_map_with_parents[(*iter)->get_name()] = *iter;
+		}
 	}
+	m_properties_with_parents.insert(m_properties_with_parents.end(), m_property_vector.begin(), m_property_vector.end());
 
-	return _SBYTE;
-}
-
-std::shared_ptr<edm_primitive_type> edm_primitive_type::SINGLE() 
-{ 
-	std::lock_guard<std::mutex> lock(mutex());
+	refresh_flattened_key();
 
-	if (!_SINGLE)
+	for (auto iter = m_derived_types.cbegin(); iter != m_derived_types.cend(); ++iter)
 	{
-		_SINGLE.reset(new edm_primitive_type(U("Edm.Single"), edm_primitive_type_kind_t::Single));
+		if ((*iter)->m_base_type.get() == this)
+		{
+			(*iter)->refresh_flattened_members();
+		}
 	}
-
-	return _SINGLE;
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::STRING() 
+std::shared_ptr<edm_property_type> edm_structured_type::find_property(::odata::utility::string_t name) const
 {
-	std::lock_guard<std::mutex> lock(mutex());
+	ensure_resolved();
+	return lookup_property(name);
+}
 
-	if (!_STRING)
+std::shared_ptr<edm_property_type> edm_structured_type::lookup_property(const ::odata::utility::string_t& name) const
+{
+	const auto &properties = m_base_type ? m_property_map_with_parents : m_properties;
+    auto find_iter = properties.find(name);
+	if (find_iter != properties.end())
 	{
-		_STRING.reset(new edm_primitive_type(U("Edm.String"), edm_primitive_type_kind_t::String));
+		return find_iter->second;
 	}
 
-	return _STRING;
+    return nullptr;
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::STREAM() 
+void edm_structured_type::resolve_deferred() const
 {
-	std::lock_guard<std::mutex> lock(mutex());
-
-	if (!_STREAM)
+	std::call_once(m_resolver_once, [this]()
+	{
+		if (m_resolver)
+		{
+			m_resolver();
+		}
+	});
+
+	// Inherited properties belong to the base types, so they have to be resolved as well.
+	if (m_base_type)
 	{
-		_STREAM.reset(new edm_primitive_type(U("Edm.Stream"), edm_primitive_type_kind_t::Stream));
+		m_base_type->ensure_resolved();
 	}
 
-	return _STREAM;
+	m_resolved.store(true, std::memory_order_release);
 }
 
-std::shared_ptr<edm_primitive_type> edm_primitive_type::UNKNOWN() 
+void edm_entity_type::add_key_property(const ::odata::utility::string_t& property_ref)
 {
-	std::lock_guard<std::mutex> lock(mutex());
+	throw_if_frozen(m_frozen);
+	m_key.push_back(property_ref);
 
-	if (!_UNKNOWN)
+	if (m_base_type || !m_derived_types.empty())
 	{
-		_UNKNOWN.reset(new edm_primitive_type(U("UNKNOWN"), edm_primitive_type_kind_t::NoneVal));
+		refresh_flattened_members();
+	}
+	else
+	{
+		m_key_with_parents.push_back(property_ref);
 	}
-
-	return _UNKNOWN;
 }
 
-std::mutex &edm_primitive_type::mutex()
+void edm_entity_type::refresh_flattened_key()
 {
-	static std::mutex _mutex;
-	return _mutex;
-}
+	m_key_with_parents = m_key;
 
-std::shared_ptr<edm_property_type> edm_structured_type::find_property(::odata::utility::string_t name) const
-{
-	// todo find property type in base type...
-    auto find_iter = m_properties.find(name);
-	if (find_iter != m_properties.end())
+	auto base = dynamic_cast<const edm_entity_type*>(m_base_type.get());
+	if (base)
 	{
-		return find_iter->second;
+		m_key_with_parents.insert(m_key_with_parents.end(), base->m_key_with_parents.begin(), base->m_key_with_parents.end());
 	}
-	else if (m_base_type)
-	{
-		// find property type in base type 
-		return m_base_type->find_property(name);
-	}
-
-    return nullptr;
 }
 
 }}
\ No newline at end of file
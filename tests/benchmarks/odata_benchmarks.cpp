@@ -0,0 +1,694 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_benchmarks.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_core.h"
+#include "odata/core/odata_json_reader_minimal.h"
+#include "odata/core/odata_message_writer.h"
+#include "odata/core/odata_metadata_builder.h"
+#include "odata/core/odata_uri_parser.h"
+#include "odata/edm/edm_model_reader.h"
+#include "odata/edm/edm_model_sax_reader.h"
+#include "allocation_tracker.h"
+#include "synthetic_generator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+// The benchmark suite for the hot paths of the library: URI parsing, JSON reading and writing of entities and
+// entity collections (reading includes parsing the JSON text), CSDL loading, primitive conversions and $metadata rendering. Every workload is generated
+// from fixed inputs, so two runs on the same build and hardware measure the same work. Results are written as
+// JSON with the median time, the bytes allocated and the allocation count per operation of every benchmark, and
+// the peak heap usage of a single operation.
+// The scale/ series run on seeded synthetic models and chart how costs grow from 10 to max-types types and from
+// 1 to max-entities entities per payload, in steps of ten.
+// Usage: odata-benchmarks [--filter=<substring>] [--min-time=<ms per sample>] [--repetitions=<samples>] [--output=<file>]
+//                         [--max-types=<types, default 10000>] [--max-entities=<entities, default 10000>]
+
+using namespace ::odata::core;
+using namespace ::odata::edm;
+using namespace ::odata::utility;
+using ::tests::common::utilities::allocation_scope;
+using ::tests::common::utilities::synthetic_model;
+using ::tests::common::utilities::synthetic_model_options;
+
+struct benchmark_result
+{
+	std::string name;
+	size_t iterations;
+	double ns_per_op;
+	double bytes_per_op;
+	double allocations_per_op;
+	size_t peak_live_bytes;
+};
+
+// Runs each operation often enough to fill min_time per sample and reports the median of the samples.
+// An operation returns a value derived from its work so that the work cannot be optimized away.
+class benchmark_runner
+{
+public:
+	benchmark_runner(const std::string& filter, double min_time_ns, int repetitions)
+		: m_filter(filter), m_min_time_ns(min_time_ns), m_repetitions(repetitions), m_sink(0)
+	{
+	}
+
+	bool selected(const std::string& name) const
+	{
+		return name.find(m_filter) != std::string::npos;
+	}
+
+	void run(const std::string& name, const std::function<size_t()>& operation)
+	{
+		if (!selected(name))
+		{
+			return;
+		}
+
+		// One untimed run warms caches and lazily built state and sizes the samples.
+		auto warm_up_start = std::chrono::steady_clock::now();
+		m_sink += operation();
+		double warm_up_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - warm_up_start).count();
+
+		size_t peak_live_bytes;
+		{
+			allocation_scope scope;
+			m_sink += operation();
+			peak_live_bytes = scope.counts().peak_live_bytes;
+		}
+		size_t iterations = (size_t)std::max(1.0, m_min_time_ns / std::max(warm_up_ns, 1.0));
+
+		std::vector<double> samples;
+		samples.reserve(m_repetitions);
+		size_t allocations = SIZE_MAX;
+		size_t allocated_bytes = SIZE_MAX;
+		for (int repetition = 0; repetition < m_repetitions; repetition++)
+		{
+			allocation_scope scope;
+			auto start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < iterations; i++)
+			{
+				m_sink += operation();
+			}
+			auto end = std::chrono::steady_clock::now();
+			allocations = std::min(allocations, scope.counts().allocations);
+			allocated_bytes = std::min(allocated_bytes, scope.counts().bytes);
+			samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / iterations);
+		}
+		std::sort(samples.begin(), samples.end());
+
+		benchmark_result result;
+		result.name = name;
+		result.iterations = iterations;
+		result.ns_per_op = samples[samples.size() / 2];
+		result.bytes_per_op = (double)allocated_bytes / iterations;
+		result.allocations_per_op = (double)allocations / iterations;
+		result.peak_live_bytes = peak_live_bytes;
+		m_results.push_back(result);
+
+		std::cerr << name << ": " << result.ns_per_op << " ns/op, " << result.bytes_per_op << " B/op, "
+			<< result.allocations_per_op << " allocs/op" << std::endl;
+	}
+
+	void write_json(std::ostream& stream) const
+	{
+		stream << std::setprecision(12) << "{\"suite\":\"odata-benchmarks\",\"context\":{";
+#if defined(__clang__)
+		stream << "\"compiler\":\"clang " << __clang_major__ << "." << __clang_minor__ << "\",";
+#elif defined(__GNUC__)
+		stream << "\"compiler\":\"gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "\",";
+#elif defined(_MSC_VER)
+		stream << "\"compiler\":\"msvc " << _MSC_VER << "\",";
+#endif
+#ifdef NDEBUG
+		stream << "\"assertions\":false,";
+#else
+		stream << "\"assertions\":true,";
+#endif
+		stream << "\"hardware_threads\":" << std::thread::hardware_concurrency()
+			<< ",\"min_time_ns\":" << m_min_time_ns << ",\"repetitions\":" << m_repetitions << "},\"benchmarks\":[";
+		for (size_t i = 0; i < m_results.size(); i++)
+		{
+			const auto &result = m_results[i];
+			stream << (i ? "," : "") << "\n{\"name\":\"" << result.name << "\",\"iterations\":" << result.iterations
+				<< ",\"ns_per_op\":" << result.ns_per_op << ",\"bytes_per_op\":" << result.bytes_per_op
+				<< ",\"allocations_per_op\":" << result.allocations_per_op << ",\"peak_live_bytes\":" << result.peak_live_bytes << "}";
+		}
+		stream << "\n]}" << std::endl;
+	}
+
+private:
+	std::string m_filter;
+	double m_min_time_ns;
+	int m_repetitions;
+	volatile size_t m_sink;
+	std::vector<benchmark_result> m_results;
+};
+
+static const string_t g_service_root = U("http://benchmark/");
+
+static const char* const g_sales_csdl =
+	"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+	"<edmx:Edmx xmlns:edmx=\"http://docs.oasis-open.org/odata/ns/edmx\" Version=\"4.0\"><edmx:DataServices>"
+	"<Schema xmlns=\"http://docs.oasis-open.org/odata/ns/edm\" Namespace=\"Benchmark.Sales\">"
+	"<ComplexType Name=\"Address\">"
+	"<Property Name=\"Street\" Type=\"Edm.String\"/><Property Name=\"City\" Type=\"Edm.String\"/>"
+	"<Property Name=\"PostalCode\" Type=\"Edm.String\"/>"
+	"</ComplexType>"
+	"<EntityType Name=\"Customer\"><Key><PropertyRef Name=\"CustomerID\"/></Key>"
+	"<Property Name=\"CustomerID\" Type=\"Edm.Int32\" Nullable=\"false\"/><Property Name=\"Name\" Type=\"Edm.String\"/>"
+	"<Property Name=\"Address\" Type=\"Benchmark.Sales.Address\"/>"
+	"<NavigationProperty Name=\"Orders\" Type=\"Collection(Benchmark.Sales.Order)\" Partner=\"Customer\"/>"
+	"</EntityType>"
+	"<EntityType Name=\"Order\"><Key><PropertyRef Name=\"OrderID\"/></Key>"
+	"<Property Name=\"OrderID\" Type=\"Edm.Int64\" Nullable=\"false\"/><Property Name=\"Name\" Type=\"Edm.String\"/>"
+	"<Property Name=\"Created\" Type=\"Edm.DateTimeOffset\"/><Property Name=\"Amount\" Type=\"Edm.Double\"/>"
+	"<Property Name=\"Quantity\" Type=\"Edm.Int32\"/><Property Name=\"Shipped\" Type=\"Edm.Boolean\"/>"
+	"<Property Name=\"Signature\" Type=\"Edm.Binary\"/><Property Name=\"ShipTo\" Type=\"Benchmark.Sales.Address\"/>"
+	"<Property Name=\"Tags\" Type=\"Collection(Edm.String)\"/>"
+	"<NavigationProperty Name=\"Customer\" Type=\"Benchmark.Sales.Customer\" Partner=\"Orders\"/>"
+	"<NavigationProperty Name=\"Lines\" Type=\"Collection(Benchmark.Sales.OrderLine)\"/>"
+	"</EntityType>"
+	"<EntityType Name=\"OrderLine\"><Key><PropertyRef Name=\"LineID\"/></Key>"
+	"<Property Name=\"LineID\" Type=\"Edm.Int32\" Nullable=\"false\"/><Property Name=\"Product\" Type=\"Edm.String\"/>"
+	"<Property Name=\"Price\" Type=\"Edm.Double\"/>"
+	"</EntityType>"
+	"<EntityContainer Name=\"Container\">"
+	"<EntitySet Name=\"Customers\" EntityType=\"Benchmark.Sales.Customer\"><NavigationPropertyBinding Path=\"Orders\" Target=\"Orders\"/></EntitySet>"
+	"<EntitySet Name=\"Orders\" EntityType=\"Benchmark.Sales.Order\">"
+	"<NavigationPropertyBinding Path=\"Customer\" Target=\"Customers\"/><NavigationPropertyBinding Path=\"Lines\" Target=\"OrderLines\"/>"
+	"</EntitySet>"
+	"<EntitySet Name=\"OrderLines\" EntityType=\"Benchmark.Sales.OrderLine\"/>"
+	"</EntityContainer>"
+	"</Schema></edmx:DataServices></edmx:Edmx>";
+
+static std::shared_ptr<edm_model> load_model(const std::string& csdl)
+{
+	std::istringstream stream(csdl);
+	edm_model_reader reader(stream);
+	reader.parse();
+	return reader.get_model();
+}
+
+static synthetic_model_options generated_options(int type_count, int schema_count)
+{
+	synthetic_model_options options;
+	options.type_count = type_count;
+	options.schema_count = schema_count;
+	return options;
+}
+
+// Builds the order with the given id; every property value is derived from the id.
+static std::shared_ptr<odata_entity_value> make_order(std::shared_ptr<edm_model> model, int64_t id)
+{
+	auto order_type = model->find_entity_type(U("Order"));
+	auto address_type = model->find_complex_type(U("Address"));
+
+	auto order = std::make_shared<odata_entity_value>(order_type);
+	order->set_value(U("OrderID"), id);
+	order->set_value(U("Name"), U("Order ") + conversions::print_string(id));
+	order->set_value(U("Created"), datetime::from_string(U("2015-01-01T00:00:00Z"), datetime::ISO_8601) + datetime::from_seconds((unsigned int)(id * 7919 % 31536000)));
+	order->set_value(U("Amount"), (double)(id % 100000) / 100.0);
+	order->set_value(U("Quantity"), (int32_t)(id % 50));
+	order->set_value(U("Shipped"), id % 3 == 0);
+	std::vector<unsigned char> signature(24);
+	for (size_t i = 0; i < signature.size(); i++)
+	{
+		signature[i] = (unsigned char)((id * 31 + i * 17) & 0xff);
+	}
+	order->set_value(U("Signature"), signature);
+
+	auto ship_to = std::make_shared<odata_complex_value>(address_type);
+	ship_to->set_value(U("Street"), conversions::print_string(id % 997) + U(" Main Street"));
+	ship_to->set_value(U("City"), id % 2 ? U("Redmond") : U("Shanghai"));
+	ship_to->set_value(U("PostalCode"), conversions::print_string(98000 + id % 100));
+	order->set_value(U("ShipTo"), ship_to);
+
+	auto tags = std::make_shared<odata_collection_value>(std::make_shared<edm_collection_type>(edm_primitive_type::STRING()));
+	for (int64_t i = 0; i < id % 4; i++)
+	{
+		tags->add_collection_value(odata_primitive_value::make_primitive_value(U("tag") + conversions::print_string(i)));
+	}
+	order->set_value(U("Tags"), tags);
+
+	return order;
+}
+
+static std::shared_ptr<odata_collection_value> make_orders(std::shared_ptr<edm_model> model, int64_t count)
+{
+	auto orders = std::make_shared<odata_collection_value>(std::make_shared<edm_collection_type>(model->find_entity_type(U("Order"))));
+	for (int64_t id = 1; id <= count; id++)
+	{
+		orders->add_collection_value(make_order(model, id));
+	}
+	return orders;
+}
+
+static void run_uri_benchmarks(benchmark_runner& runner, std::shared_ptr<edm_model> model)
+{
+	odata_uri_parser parser(model);
+
+	const char* const uris[][2] =
+	{
+		{ "uri/parse/path", "Customers(1)/Orders(2)/ShipTo/City" },
+		{ "uri/parse/filter", "Orders?$filter=Amount gt 10.5 and (contains(Name,'7') or Created lt 2016-01-01T00:00:00Z) and Quantity mod 3 eq 1&$orderby=Created desc&$top=50&$skip=100" },
+		{ "uri/parse/expand", "Customers?$select=Name,Address&$expand=Orders($filter=Shipped eq true;$select=OrderID,Amount;$expand=Lines($orderby=Price desc);$top=5)" },
+	};
+
+	for (size_t i = 0; i < sizeof(uris) / sizeof(uris[0]); i++)
+	{
+		if (!runner.selected(uris[i][0]))
+		{
+			continue;
+		}
+
+		auto encoded = uri::encode_uri(g_service_root + conversions::to_string_t(uris[i][1]));
+		runner.run(uris[i][0], [&]() -> size_t
+		{
+			return parser.parse_uri(uri(encoded))->path()->size();
+		});
+	}
+
+	auto filter = U("Orders?$filter=Name eq 'Order #42' and contains(ShipTo/City,'Red mond')&$orderby=Created desc");
+	auto encoded_filter = uri::encode_uri(g_service_root + filter);
+	runner.run("uri/construct", [&]() -> size_t
+	{
+		return uri(encoded_filter).query().size();
+	});
+
+	runner.run("uri/encode", [&]() -> size_t
+	{
+		return uri::encode_uri(filter, uri::components::query).size();
+	});
+
+	runner.run("uri/decode", [&]() -> size_t
+	{
+		return uri::decode(encoded_filter).size();
+	});
+
+	// Every entity in a response gets an id and an edit link, so building them is a per-entity cost.
+	if (runner.selected("uri/edit_link/100000"))
+	{
+		std::vector<std::shared_ptr<odata_entity_value>> orders;
+		for (int64_t id = 1; id <= 100000; id++)
+		{
+			orders.push_back(make_order(model, id));
+		}
+		auto orders_set = model->find_container()->find_entity_set(U("Orders"));
+		odata_metadata_builder builder(model, uri(g_service_root));
+		runner.run("uri/edit_link/100000", [&]() -> size_t
+		{
+			size_t size = 0;
+			for (auto iter = orders.cbegin(); iter != orders.cend(); ++iter)
+			{
+				size += builder.get_edit_link(*iter, orders_set).to_string().size();
+			}
+			return size;
+		});
+	}
+}
+
+static void run_json_benchmarks(benchmark_runner& runner, std::shared_ptr<edm_model> model)
+{
+	odata_message_writer writer(model, uri(g_service_root));
+	auto order_type = model->find_entity_type(U("Order"));
+	auto orders_set = model->find_container()->find_entity_set(U("Orders"));
+
+	if (runner.selected("json/write/entity") || runner.selected("json/read/entity"))
+	{
+		auto order = make_order(model, 42);
+		runner.run("json/write/entity", [&]() -> size_t
+		{
+			return writer.write_odata_value(order).size();
+		});
+
+		auto payload = writer.write_odata_value(order);
+		payload.insert(1, U("\"@odata.context\":\"") + g_service_root + U("$metadata#Orders/$entity\","));
+		odata_json_reader_minimal reader(model, g_service_root, true);
+		runner.run("json/read/entity", [&]() -> size_t
+		{
+			return reader.deserilize_entity_value(json::value::parse(payload), order_type)->properties().size();
+		});
+	}
+
+	const int64_t row_counts[] = { 10, 1000, 100000 };
+	for (size_t i = 0; i < sizeof(row_counts) / sizeof(row_counts[0]); i++)
+	{
+		auto suffix = "/" + std::to_string(row_counts[i]);
+		if (!runner.selected("json/write/collection" + suffix) && !runner.selected("json/read/collection" + suffix))
+		{
+			continue;
+		}
+
+		auto orders = make_orders(model, row_counts[i]);
+		runner.run("json/write/collection" + suffix, [&]() -> size_t
+		{
+			return writer.write_odata_value(orders).size();
+		});
+
+		auto payload = U("{\"@odata.context\":\"") + g_service_root + U("$metadata#Orders\",\"value\":") + writer.write_odata_value(orders) + U("}");
+		orders.reset();
+		odata_json_reader_minimal reader(model, g_service_root, true);
+		runner.run("json/read/collection" + suffix, [&]() -> size_t
+		{
+			return reader.deserilize_entity_collection(json::value::parse(payload), orders_set)->get_collection_values().size();
+		});
+	}
+}
+
+static void run_json_object_benchmarks(benchmark_runner& runner)
+{
+	// Builds objects field by field and then looks every field up once, both in objects that keep the order of
+	// their fields and in sorted ones, for narrow entities up to wide and open ones.
+	const size_t widths[] = { 8, 64, 512 };
+	for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); i++)
+	{
+		for (int keep_order = 1; keep_order >= 0; keep_order--)
+		{
+			auto suffix = std::string(keep_order ? "ordered/" : "sorted/") + std::to_string(widths[i]);
+			if (!runner.selected("json/object/build/" + suffix) && !runner.selected("json/object/find/" + suffix))
+			{
+				continue;
+			}
+
+			std::vector<string_t> keys;
+			for (size_t field = 0; field < widths[i]; field++)
+			{
+				keys.push_back(U("Property") + conversions::print_string(field * 7919 % 100000));
+			}
+
+			runner.run("json/object/build/" + suffix, [&]() -> size_t
+			{
+				auto object = json::value::object(keep_order != 0);
+				for (size_t field = 0; field < keys.size(); field++)
+				{
+					object[keys[field]] = json::value((int32_t)field);
+				}
+				return object.size();
+			});
+
+			auto object = json::value::object(keep_order != 0);
+			for (size_t field = 0; field < keys.size(); field++)
+			{
+				object[keys[field]] = json::value((int32_t)field);
+			}
+			runner.run("json/object/find/" + suffix, [&]() -> size_t
+			{
+				size_t found = 0;
+				for (size_t field = 0; field < keys.size(); field++)
+				{
+					found += object.has_field(keys[field]) ? 1 : 0;
+				}
+				return found;
+			});
+		}
+	}
+}
+
+static void run_csdl_benchmarks(benchmark_runner& runner)
+{
+	const struct { const char* size; int type_count; int schema_count; } schemas[] =
+	{
+		{ "small", 20, 1 },
+		{ "huge", 10000, 4 },
+	};
+
+	for (size_t i = 0; i < sizeof(schemas) / sizeof(schemas[0]); i++)
+	{
+		std::string size = schemas[i].size;
+		if (!runner.selected("csdl/load/" + size) && !runner.selected("csdl/load_sax/" + size)
+			&& !runner.selected("metadata/xml/" + size) && !runner.selected("metadata/json/" + size))
+		{
+			continue;
+		}
+
+		auto csdl = synthetic_model(generated_options(schemas[i].type_count, schemas[i].schema_count)).csdl();
+		runner.run("csdl/load/" + size, [&]() -> size_t
+		{
+			return load_model(csdl)->get_schema().size();
+		});
+
+		runner.run("csdl/load_sax/" + size, [&]() -> size_t
+		{
+			std::istringstream stream(csdl);
+			return edm_model_sax_reader::parse(stream)->get_schema().size();
+		});
+
+		auto model = load_model(csdl);
+		odata_message_writer writer(model, uri(g_service_root));
+		runner.run("metadata/xml/" + size, [&]() -> size_t
+		{
+			return writer.write_metadata_document(edm_csdl_format_t::Xml).size();
+		});
+
+		runner.run("metadata/json/" + size, [&]() -> size_t
+		{
+			return writer.write_metadata_document(edm_csdl_format_t::Json).size();
+		});
+	}
+}
+
+static void run_scaling_benchmarks(benchmark_runner& runner, int max_types, int64_t max_entities)
+{
+	for (int type_count = 10; type_count <= max_types; type_count *= 10)
+	{
+		auto prefix = "scale/types/" + std::to_string(type_count);
+		if (!runner.selected(prefix + "/csdl_load") && !runner.selected(prefix + "/uri_parse"))
+		{
+			continue;
+		}
+
+		synthetic_model generator(generated_options(type_count, std::max(1, type_count / 2500)));
+		auto csdl = generator.csdl();
+		runner.run(prefix + "/csdl_load", [&]() -> size_t
+		{
+			return load_model(csdl)->get_schema().size();
+		});
+
+		auto model = load_model(csdl);
+		odata_uri_parser parser(model);
+		std::vector<uri> uris;
+		for (uint64_t i = 0; i < 64; i++)
+		{
+			uris.push_back(uri(uri::encode_uri(g_service_root + conversions::to_string_t(generator.query_url(i)))));
+		}
+		size_t next = 0;
+		runner.run(prefix + "/uri_parse", [&]() -> size_t
+		{
+			return parser.parse_uri(uris[next++ % uris.size()])->path()->size();
+		});
+	}
+
+	// Set1 holds a derived type, so payloads carry inherited properties as well.
+	synthetic_model generator(generated_options(20, 1));
+	auto model = load_model(generator.csdl());
+	auto entity_set = model->find_container()->find_entity_set(conversions::to_string_t(generator.entity_set_name(1)));
+	odata_message_writer writer(model, uri(g_service_root));
+	for (int64_t entity_count = 1; entity_count <= max_entities; entity_count *= 10)
+	{
+		auto prefix = "scale/entities/" + std::to_string(entity_count);
+		if (!runner.selected(prefix + "/json_read") && !runner.selected(prefix + "/json_write"))
+		{
+			continue;
+		}
+
+		auto payload = conversions::to_string_t(generator.collection_payload(conversions::to_utf8string(g_service_root), 1, entity_count));
+		odata_json_reader_minimal reader(model, g_service_root, true);
+		runner.run(prefix + "/json_read", [&]() -> size_t
+		{
+			return reader.deserilize_entity_collection(json::value::parse(payload), entity_set)->get_collection_values().size();
+		});
+
+		auto entities = reader.deserilize_entity_collection(json::value::parse(payload), entity_set);
+		payload.clear();
+		runner.run(prefix + "/json_write", [&]() -> size_t
+		{
+			return writer.write_odata_value(entities).size();
+		});
+	}
+}
+
+static void run_primitive_benchmarks(benchmark_runner& runner)
+{
+	// Inputs cycle through a fixed table so that no single value is parsed from a hot cache line only.
+	const size_t input_count = 64;
+	std::vector<string_t> datetimes;
+	std::vector<datetime> datetime_values;
+	std::vector<string_t> doubles;
+	std::vector<double> double_values;
+	for (size_t i = 0; i < input_count; i++)
+	{
+		datetime_values.push_back(datetime::from_string(U("2000-01-01T00:00:00Z"), datetime::ISO_8601) + datetime::from_seconds((unsigned int)(i * 104729 * 97)));
+		datetimes.push_back(datetime_values.back().to_string(datetime::ISO_8601));
+		double_values.push_back((double)(i * 7919) / 113.0 - 1000.0);
+		doubles.push_back(odata_primitive_value::make_primitive_value(double_values.back())->to_string());
+	}
+
+	std::vector<unsigned char> binary(1024);
+	for (size_t i = 0; i < binary.size(); i++)
+	{
+		binary[i] = (unsigned char)((i * 131 + 7) & 0xff);
+	}
+	auto base64 = conversions::to_base64(binary);
+
+	size_t next = 0;
+	runner.run("primitive/datetime/parse", [&]() -> size_t
+	{
+		return (size_t)datetime::from_string(datetimes[next++ % input_count], datetime::ISO_8601).to_interval();
+	});
+
+	runner.run("primitive/datetime/format", [&]() -> size_t
+	{
+		return datetime_values[next++ % input_count].to_string(datetime::ISO_8601).size();
+	});
+
+	runner.run("primitive/double/parse", [&]() -> size_t
+	{
+		odata_primitive_value value(edm_primitive_type::DOUBLE(), doubles[next++ % input_count]);
+		return (size_t)value.as<double>();
+	});
+
+	runner.run("primitive/double/format", [&]() -> size_t
+	{
+		return odata_primitive_value::make_primitive_value(double_values[next++ % input_count])->to_string().size();
+	});
+
+	runner.run("primitive/base64/encode_1k", [&]() -> size_t
+	{
+		return conversions::to_base64(binary).size();
+	});
+
+	runner.run("primitive/base64/decode_1k", [&]() -> size_t
+	{
+		return conversions::from_base64(base64).size();
+	});
+
+	// A document-sized Edm.Binary value.
+	std::vector<unsigned char> document(4 * 1024 * 1024);
+	for (size_t i = 0; i < document.size(); i++)
+	{
+		document[i] = (unsigned char)((i * 131 + (i >> 12)) & 0xff);
+	}
+	auto document_base64 = conversions::to_base64(document);
+
+	runner.run("primitive/base64/encode_4m", [&]() -> size_t
+	{
+		return conversions::to_base64(document).size();
+	});
+
+	runner.run("primitive/base64/decode_4m", [&]() -> size_t
+	{
+		return conversions::from_base64(document_base64).size();
+	});
+
+	// The streaming forms, as a writer and a parser use them: 64 KiB chunks into an output that is reused.
+	string_t encoded;
+	runner.run("primitive/base64/encode_4m_chunked", [&]() -> size_t
+	{
+		encoded.clear();
+		conversions::base64_encoder encoder(encoded);
+		for (size_t offset = 0; offset < document.size(); offset += 65536)
+		{
+			encoder.write(document.data() + offset, std::min<size_t>(65536, document.size() - offset));
+		}
+		encoder.finish();
+		return encoded.size();
+	});
+
+	std::vector<unsigned char> decoded(document_base64.size() / 4 * 3);
+	runner.run("primitive/base64/decode_4m_into", [&]() -> size_t
+	{
+		return conversions::from_base64(document_base64.data(), document_base64.size(), decoded.data());
+	});
+}
+
+int main(int argc, char* argv[])
+{
+	std::string filter;
+	double min_time_ms = 200;
+	int repetitions = 5;
+	std::string output;
+	int max_types = 10000;
+	int64_t max_entities = 10000;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument.compare(0, 9, "--filter=") == 0)
+		{
+			filter = argument.substr(9);
+		}
+		else if (argument.compare(0, 11, "--min-time=") == 0)
+		{
+			min_time_ms = std::atof(argument.c_str() + 11);
+		}
+		else if (argument.compare(0, 14, "--repetitions=") == 0)
+		{
+			repetitions = std::atoi(argument.c_str() + 14);
+		}
+		else if (argument.compare(0, 9, "--output=") == 0)
+		{
+			output = argument.substr(9);
+		}
+		else if (argument.compare(0, 12, "--max-types=") == 0)
+		{
+			max_types = std::atoi(argument.c_str() + 12);
+		}
+		else if (argument.compare(0, 15, "--max-entities=") == 0)
+		{
+			max_entities = std::atoll(argument.c_str() + 15);
+		}
+		else
+		{
+			repetitions = 0;
+		}
+	}
+
+	if (repetitions < 1 || min_time_ms < 0)
+	{
+		std::cerr << "usage: " << argv[0] << " [--filter=<substring>] [--min-time=<ms per sample>] [--repetitions=<samples >= 1>] [--output=<file>]"
+			<< " [--max-types=<types>] [--max-entities=<entities>]" << std::endl;
+		return 2;
+	}
+
+	if (!allocation_scope::is_hooked())
+	{
+		std::cerr << "the allocation hook is not installed, allocation counts will be zero" << std::endl;
+	}
+
+	benchmark_runner runner(filter, min_time_ms * 1000000, repetitions);
+	try
+	{
+		auto model = load_model(g_sales_csdl);
+		run_uri_benchmarks(runner, model);
+		run_json_benchmarks(runner, model);
+		run_json_object_benchmarks(runner);
+		run_csdl_benchmarks(runner);
+		run_scaling_benchmarks(runner, max_types, max_entities);
+		run_primitive_benchmarks(runner);
+	}
+	catch (odata_exception& e)
+	{
+		std::cerr << "benchmark failed: " << conversions::to_utf8string(e.what()) << std::endl;
+		return 1;
+	}
+
+	if (output.empty())
+	{
+		runner.write_json(std::cout);
+	}
+	else
+	{
+		std::ofstream file(output);
+		runner.write_json(file);
+	}
+
+	return 0;
+}
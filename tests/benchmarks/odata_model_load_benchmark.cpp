@@ -0,0 +1,287 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_model_load_benchmark.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/edm/edm_model_reader.h"
+#include "odata/edm/edm_model_sax_reader.h"
+#include "odata/edm/edm_model_snapshot.h"
+#include "odata/edm/edm_model_writer.h"
+#include "odata/edm/edm_csdl_writer.h"
+#include "allocation_tracker.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+// Compares service startup from CSDL (parse and resolve, with the pull and the SAX reader, and with
+// eager, parallel and lazy type resolution) with loading a binary model snapshot, and writing
+// $metadata through libxml2 with the streaming CSDL XML and JSON writers.
+// Usage: odata-benchmark-model-load [type count] [iterations] [schema count]
+
+using namespace ::odata::edm;
+using ::tests::common::utilities::allocation_scope;
+
+static std::string schema_namespace(int schema)
+{
+	// No namespace may be a prefix of another one, schemas strip qualifications by prefix.
+	return "Benchmark.S" + std::to_string(schema) + ".Generated";
+}
+
+// Generates schema_count schemas sharing type_count types: a fifth enums, two fifths complex types
+// and two fifths entity types. Every entity type derives from its schema's base, has a complex and
+// an enum property and navigates to entity types of the next schema, and every entity type gets a
+// bound entity set in the one container.
+static std::string generate_csdl(int type_count, int schema_count)
+{
+	int schema_type_count = type_count / schema_count;
+	int enum_count = schema_type_count / 5;
+	int complex_count = (schema_type_count - enum_count) / 2;
+	int entity_count = schema_type_count - enum_count - complex_count;
+
+	std::ostringstream csdl;
+	csdl << "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		<< "<edmx:Edmx xmlns:edmx=\"http://docs.oasis-open.org/odata/ns/edmx\" Version=\"4.0\"><edmx:DataServices>";
+
+	for (int schema = 0; schema < schema_count; schema++)
+	{
+		auto name_space = schema_namespace(schema);
+		auto next_name_space = schema_namespace((schema + 1) % schema_count);
+		csdl << "<Schema xmlns=\"http://docs.oasis-open.org/odata/ns/edm\" Namespace=\"" << name_space << "\">";
+
+		for (int i = 0; i < enum_count; i++)
+		{
+			csdl << "<EnumType Name=\"Enum" << i << "\">"
+				<< "<Member Name=\"A\" Value=\"0\"/><Member Name=\"B\" Value=\"1\"/><Member Name=\"C\" Value=\"2\"/>"
+				<< "</EnumType>";
+		}
+
+		for (int i = 0; i < complex_count; i++)
+		{
+			csdl << "<ComplexType Name=\"Complex" << i << "\">"
+				<< "<Property Name=\"Text\" Type=\"Edm.String\"/>"
+				<< "<Property Name=\"Number\" Type=\"Edm.Int32\" Nullable=\"false\"/>"
+				<< "<Property Name=\"Values\" Type=\"Collection(Edm.Double)\"/>"
+				<< "</ComplexType>";
+		}
+
+		csdl << "<EntityType Name=\"EntityBase\" Abstract=\"true\"><Key><PropertyRef Name=\"Id\"/></Key>"
+			<< "<Property Name=\"Id\" Type=\"Edm.Int64\" Nullable=\"false\"/></EntityType>";
+		for (int i = 0; i < entity_count - 1; i++)
+		{
+			int next = (i + 1) % (entity_count - 1);
+			csdl << "<EntityType Name=\"Entity" << i << "\" BaseType=\"" << name_space << ".EntityBase\">"
+				<< "<Property Name=\"Name\" Type=\"Edm.String\"/>"
+				<< "<Property Name=\"Created\" Type=\"Edm.DateTimeOffset\"/>"
+				<< "<Property Name=\"Detail\" Type=\"" << name_space << ".Complex" << i % complex_count << "\"/>"
+				<< "<Property Name=\"State\" Type=\"" << name_space << ".Enum" << i % enum_count << "\"/>"
+				<< "<NavigationProperty Name=\"Next\" Type=\"" << next_name_space << ".Entity" << i << "\"/>"
+				<< "<NavigationProperty Name=\"Related\" Type=\"Collection(" << next_name_space << ".Entity" << next << ")\"/>"
+				<< "</EntityType>";
+		}
+
+		if (schema == schema_count - 1)
+		{
+			csdl << "<EntityContainer Name=\"Container\">";
+			for (int set_schema = 0; set_schema < schema_count; set_schema++)
+			{
+				int next_schema = (set_schema + 1) % schema_count;
+				for (int i = 0; i < entity_count - 1; i++)
+				{
+					int next = (i + 1) % (entity_count - 1);
+					csdl << "<EntitySet Name=\"Set" << set_schema << "_" << i << "\" EntityType=\"" << schema_namespace(set_schema) << ".Entity" << i << "\">"
+						<< "<NavigationPropertyBinding Path=\"Next\" Target=\"Set" << next_schema << "_" << i << "\"/>"
+						<< "<NavigationPropertyBinding Path=\"Related\" Target=\"Set" << next_schema << "_" << next << "\"/>"
+						<< "</EntitySet>";
+				}
+			}
+			csdl << "</EntityContainer>";
+		}
+
+		csdl << "</Schema>";
+	}
+	csdl << "</edmx:DataServices></edmx:Edmx>";
+
+	return csdl.str();
+}
+
+// Returns the median wall time of the given number of runs in milliseconds and optionally the
+// allocations made by one run on the calling thread. Models built by a run are kept alive until all
+// runs finish so that tearing them down is not part of the time.
+static double measure(int iterations, const std::function<std::shared_ptr<edm_model>()>& run, size_t* allocations = nullptr)
+{
+	std::vector<double> samples;
+	std::vector<std::shared_ptr<edm_model>> retained;
+	retained.reserve(iterations);
+	for (int i = 0; i < iterations; i++)
+	{
+		allocation_scope scope;
+		auto start = std::chrono::steady_clock::now();
+		retained.push_back(run());
+		auto end = std::chrono::steady_clock::now();
+		samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+		if (allocations)
+		{
+			*allocations = scope.counts().allocations;
+		}
+	}
+
+	std::sort(samples.begin(), samples.end());
+	return samples[samples.size() / 2];
+}
+
+int main(int argc, char* argv[])
+{
+	int type_count = argc > 1 ? std::atoi(argv[1]) : 5000;
+	int iterations = argc > 2 ? std::atoi(argv[2]) : 5;
+	int schema_count = argc > 3 ? std::atoi(argv[3]) : 4;
+	if (schema_count < 1 || type_count < 10 * schema_count || iterations < 1)
+	{
+		std::cerr << "usage: " << argv[0] << " [type count >= 10 * schema count] [iterations >= 1] [schema count >= 1]" << std::endl;
+		return 2;
+	}
+
+	if (!allocation_scope::is_hooked())
+	{
+		std::cerr << "the allocation hook is not installed, allocation counts will be zero" << std::endl;
+	}
+
+	std::string csdl = generate_csdl(type_count, schema_count);
+
+	std::shared_ptr<edm_model> model;
+	size_t parse_allocations = 0;
+	double parse_ms = measure(iterations, [&]() -> std::shared_ptr<edm_model>
+	{
+		std::istringstream stream(csdl);
+		edm_model_reader reader(stream);
+		reader.parse();
+		model = reader.get_model();
+		return model;
+	}, &parse_allocations);
+
+	size_t sax_allocations = 0;
+	double sax_ms = measure(iterations, [&]() -> std::shared_ptr<edm_model>
+	{
+		std::istringstream stream(csdl);
+		return edm_model_sax_reader::parse(stream);
+	}, &sax_allocations);
+
+	double parallel_ms = measure(iterations, [&]() -> std::shared_ptr<edm_model>
+	{
+		std::istringstream stream(csdl);
+		return edm_model_sax_reader::parse(stream, 64 * 1024, edm_type_resolution_t::Parallel);
+	});
+
+	double lazy_ms = measure(iterations, [&]() -> std::shared_ptr<edm_model>
+	{
+		std::istringstream stream(csdl);
+		return edm_model_sax_reader::parse(stream, 64 * 1024, edm_type_resolution_t::Lazy);
+	});
+
+	// What a service pays on top of a lazy load before it can answer a request for one entity set.
+	std::shared_ptr<edm_model> lazy_model;
+	{
+		std::istringstream stream(csdl);
+		lazy_model = edm_model_sax_reader::parse(stream, 64 * 1024, edm_type_resolution_t::Lazy);
+	}
+	auto first_set = lazy_model->find_container()->find_entity_set(U("Set0_0"));
+	auto first_touch_start = std::chrono::steady_clock::now();
+	first_set->get_entity_type()->find_property(U("Detail"));
+	double first_touch_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - first_touch_start).count();
+
+	// Touching every type afterwards shows the total cost of lazy resolution.
+	double lazy_full_ms = measure(iterations, [&]() -> std::shared_ptr<edm_model>
+	{
+		std::istringstream stream(csdl);
+		auto lazy = edm_model_sax_reader::parse(stream, 64 * 1024, edm_type_resolution_t::Lazy);
+		const auto &schemas = lazy->get_schema();
+		for (auto schema = schemas.cbegin(); schema != schemas.cend(); ++schema)
+		{
+			const auto &entity_types = (*schema)->get_entity_types();
+			for (auto iter = entity_types.cbegin(); iter != entity_types.cend(); ++iter)
+			{
+				iter->second->get_properties_vector();
+			}
+
+			const auto &complex_types = (*schema)->get_complex_types();
+			for (auto iter = complex_types.cbegin(); iter != complex_types.cend(); ++iter)
+			{
+				iter->second->get_properties_vector();
+			}
+		}
+		return lazy;
+	});
+
+	std::string snapshot;
+	double write_ms = measure(iterations, [&]() -> std::shared_ptr<edm_model>
+	{
+		std::ostringstream stream;
+		edm_model_snapshot_writer writer(stream);
+		writer.write_model(model);
+		snapshot = stream.str();
+		return std::shared_ptr<edm_model>();
+	});
+
+	size_t read_allocations = 0;
+	double read_ms = measure(iterations, [&]() -> std::shared_ptr<edm_model>
+	{
+		edm_model_snapshot_reader reader(snapshot.data(), snapshot.size());
+		return reader.read_model();
+	}, &read_allocations);
+
+	std::string path = "odata_model_load_benchmark.odms";
+	{
+		std::ofstream file(path, std::ios::binary);
+		file.write(snapshot.data(), snapshot.size());
+	}
+	double read_file_ms = measure(iterations, [&]() -> std::shared_ptr<edm_model>
+	{
+		return edm_model_snapshot_reader::read_file(path);
+	});
+	std::remove(path.c_str());
+
+	size_t libxml2_allocations = 0;
+	double libxml2_ms = measure(iterations, [&]() -> std::shared_ptr<edm_model>
+	{
+		std::ostringstream stream;
+		edm_model_writer writer(stream);
+		writer.write_model(model);
+		return std::shared_ptr<edm_model>();
+	}, &libxml2_allocations);
+
+	size_t csdl_xml_allocations = 0;
+	double csdl_xml_ms = measure(iterations, [&]() -> std::shared_ptr<edm_model>
+	{
+		edm_csdl_writer::write_model_to_string(model, edm_csdl_format_t::Xml);
+		return std::shared_ptr<edm_model>();
+	}, &csdl_xml_allocations);
+
+	size_t csdl_json_allocations = 0;
+	double csdl_json_ms = measure(iterations, [&]() -> std::shared_ptr<edm_model>
+	{
+		edm_csdl_writer::write_model_to_string(model, edm_csdl_format_t::Json);
+		return std::shared_ptr<edm_model>();
+	}, &csdl_json_allocations);
+
+	std::cout << "types:                  " << type_count << " in " << schema_count << " schemas" << std::endl;
+	std::cout << "csdl bytes:             " << csdl.size() << std::endl;
+	std::cout << "snapshot bytes:         " << snapshot.size() << std::endl;
+	std::cout << "csdl parse + resolve:   " << parse_ms << " ms, " << parse_allocations << " allocations" << std::endl;
+	std::cout << "csdl sax + resolve:     " << sax_ms << " ms, " << sax_allocations << " allocations" << std::endl;
+	std::cout << "csdl sax + parallel:    " << parallel_ms << " ms" << std::endl;
+	std::cout << "csdl sax + lazy:        " << lazy_ms << " ms, first entity set " << first_touch_ms << " ms, all types " << lazy_full_ms << " ms" << std::endl;
+	std::cout << "snapshot write:         " << write_ms << " ms" << std::endl;
+	std::cout << "snapshot read (memory): " << read_ms << " ms, " << read_allocations << " allocations" << std::endl;
+	std::cout << "snapshot read (mmap):   " << read_file_ms << " ms" << std::endl;
+	std::cout << "metadata (libxml2):     " << libxml2_ms << " ms, " << libxml2_allocations << " allocations" << std::endl;
+	std::cout << "metadata (csdl xml):    " << csdl_xml_ms << " ms, " << csdl_xml_allocations << " allocations" << std::endl;
+	std::cout << "metadata (csdl json):   " << csdl_json_ms << " ms, " << csdl_json_allocations << " allocations" << std::endl;
+	std::cout << "startup speedup:        " << parse_ms / read_file_ms << "x" << std::endl;
+
+	return 0;
+}
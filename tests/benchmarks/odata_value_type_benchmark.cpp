@@ -0,0 +1,96 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_value_type_benchmark.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/core/odata_core.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Measures how creating primitive values and reading their types scales with the number of threads.
+// "shared owner" reproduces what every value used to cost: locking the singleton accessor, copying the
+// singleton's shared pointer into the value and copying it again on each get_value_type(), all on one
+// reference count shared by every thread. "static owner" is the current code path.
+// Usage: odata-benchmark-value-type [operations per thread] [max threads]
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+
+static std::mutex g_accessor_mutex;
+static std::shared_ptr<edm_named_type> g_shared_type;
+
+static size_t shared_owner_operation(int32_t i)
+{
+	std::shared_ptr<edm_named_type> type;
+	{
+		std::lock_guard<std::mutex> lock(g_accessor_mutex);
+		type = g_shared_type;
+	}
+
+	auto value = std::make_shared<odata_primitive_value>(type, ::odata::utility::conversions::print_string(i));
+	std::shared_ptr<edm_named_type> value_type = value->get_value_type();
+	return value_type ? value->to_string().size() : 0;
+}
+
+static size_t static_owner_operation(int32_t i)
+{
+	auto value = odata_primitive_value::make_primitive_value(i);
+	const auto &value_type = value->get_value_type();
+	return value_type ? value->to_string().size() : 0;
+}
+
+// Returns the throughput of all threads together in operations per microsecond.
+static double run(int thread_count, int operations, size_t (*operation)(int32_t))
+{
+	std::vector<std::thread> threads;
+	std::vector<size_t> sinks(thread_count * 16);
+
+	auto start = std::chrono::steady_clock::now();
+	for (int t = 0; t < thread_count; t++)
+	{
+		threads.push_back(std::thread([t, operations, operation, &sinks]()
+		{
+			size_t sink = 0;
+			for (int i = 0; i < operations; i++)
+			{
+				sink += operation(i);
+			}
+			sinks[t * 16] = sink;
+		}));
+	}
+
+	for (auto iter = threads.begin(); iter != threads.end(); ++iter)
+	{
+		iter->join();
+	}
+	auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	return (double)operations * thread_count / elapsed;
+}
+
+int main(int argc, char* argv[])
+{
+	int operations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+	int max_threads = argc > 2 ? std::atoi(argv[2]) : (int)std::max(4u, std::thread::hardware_concurrency());
+
+	// Any type that is not process-wide is owned by the values that use it, as every type used to be.
+	g_shared_type = std::make_shared<edm_named_type>(U("Int32"), U("Edm"), edm_type_kind_t::Unknown);
+
+	std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+	std::cout << "threads   shared owner (ops/us)   static owner (ops/us)   speedup" << std::endl;
+	for (int threads = 1; threads <= max_threads; threads *= 2)
+	{
+		auto shared_owner = run(threads, operations, shared_owner_operation);
+		auto static_owner = run(threads, operations, static_owner_operation);
+		std::cout << threads << "\t  " << shared_owner << "\t\t\t  " << static_owner << "\t\t\t  " << static_owner / shared_owner << "x" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,154 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="allocation_tracker.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include "allocation_tracker.h"
+#include "config.h"
+#include "src/CurrentTest.h"
+#include "src/TestDetails.h"
+#include "src/TestResults.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#define usable_size(memory) _msize(memory)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define usable_size(memory) malloc_size(memory)
+#else
+#include <malloc.h>
+#define usable_size(memory) malloc_usable_size(memory)
+#endif
+
+namespace tests { namespace common { namespace utilities {
+
+static std::atomic<bool> g_hooked(false);
+
+// The innermost open scope of each thread. A plain pointer so that reading it never allocates.
+static thread_local allocation_scope *t_current_scope = nullptr;
+
+void record_allocation(size_t bytes, size_t usable_bytes)
+{
+    for (auto scope = t_current_scope; scope; scope = scope->m_parent)
+    {
+        scope->m_allocations++;
+        scope->m_bytes += bytes;
+        scope->m_live_bytes += (int64_t)usable_bytes;
+        if (scope->m_live_bytes > scope->m_peak_live_bytes)
+        {
+            scope->m_peak_live_bytes = scope->m_live_bytes;
+        }
+    }
+}
+
+void record_deallocation(size_t usable_bytes)
+{
+    for (auto scope = t_current_scope; scope; scope = scope->m_parent)
+    {
+        scope->m_live_bytes -= (int64_t)usable_bytes;
+    }
+}
+
+allocation_scope::allocation_scope()
+    : m_parent(t_current_scope), m_allocations(0), m_bytes(0), m_live_bytes(0), m_peak_live_bytes(0)
+{
+    t_current_scope = this;
+}
+
+allocation_scope::~allocation_scope()
+{
+    t_current_scope = m_parent;
+}
+
+allocation_counts allocation_scope::counts() const
+{
+    allocation_counts counts;
+    counts.allocations = m_allocations;
+    counts.bytes = m_bytes;
+    counts.peak_live_bytes = (size_t)m_peak_live_bytes;
+    return counts;
+}
+
+bool allocation_scope::is_hooked()
+{
+    // Any allocation goes through the replacement once it is in effect.
+    int *volatile probe = new int(0);
+    delete probe;
+    return g_hooked;
+}
+
+allocation_budget::allocation_budget(measure what, size_t budget, const char *budget_text, int line)
+    : m_what(what), m_budget(budget), m_budget_text(budget_text), m_line(line), m_entered(false)
+{
+}
+
+allocation_budget::~allocation_budget()
+{
+}
+
+bool allocation_budget::enter()
+{
+    if (!m_entered)
+    {
+        m_entered = true;
+        return true;
+    }
+
+    auto counts = m_scope.counts();
+
+    static const char *const names[] = { "allocations", "allocated bytes", "peak live bytes" };
+    size_t actual = m_what == allocations ? counts.allocations : m_what == bytes ? counts.bytes : counts.peak_live_bytes;
+
+    std::ostringstream failure;
+    if (!allocation_scope::is_hooked())
+    {
+        failure << "allocation hook is not installed, cannot check " << names[m_what];
+    }
+    else if (actual > m_budget)
+    {
+        failure << "expected at most " << m_budget_text << " " << names[m_what] << " but was " << actual;
+    }
+
+    if (!failure.str().empty())
+    {
+        UnitTest::CurrentTest::Results()->OnTestFailure(UnitTest::TestDetails(*UnitTest::CurrentTest::Details(), m_line), failure.str().c_str());
+    }
+
+    return false;
+}
+
+}}}
+
+using namespace tests::common::utilities;
+
+void* operator new(size_t size)
+{
+    void *memory = std::malloc(size ? size : 1);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+
+    g_hooked.store(true, std::memory_order_relaxed);
+    if (t_current_scope)
+    {
+        record_allocation(size, usable_size(memory));
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    if (memory && t_current_scope)
+    {
+        record_deallocation(usable_size(memory));
+    }
+    std::free(memory);
+}
@@ -0,0 +1,90 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="allocation_tracker.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "common_utilities_public.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace tests { namespace common { namespace utilities {
+
+struct allocation_counts
+{
+    size_t allocations;
+    size_t bytes;
+    size_t peak_live_bytes;
+};
+
+// Counts the heap allocations the current thread makes while the scope is alive.
+//
+// The utilities library replaces the global operator new and operator delete, so every binary linked
+// against it is instrumented; the replacements only count while the calling thread has an open scope.
+// Scopes nest and an inner scope's allocations count towards all enclosing ones. Allocations made by
+// other threads are not counted. peak_live_bytes is the highest number of bytes the scope's allocations
+// held at any one time, net of what the scope freed, measured in usable block sizes.
+class allocation_scope
+{
+public:
+    TEST_UTILITY_API allocation_scope();
+    TEST_UTILITY_API ~allocation_scope();
+
+    TEST_UTILITY_API allocation_counts counts() const;
+
+    // False when another operator new took precedence over the replacement, in which case nothing is counted.
+    static TEST_UTILITY_API bool is_hooked();
+
+private:
+    friend void record_allocation(size_t, size_t);
+    friend void record_deallocation(size_t);
+
+    allocation_scope(const allocation_scope &);
+    allocation_scope & operator=(const allocation_scope &);
+
+    allocation_scope *m_parent;
+    size_t m_allocations;
+    size_t m_bytes;
+    int64_t m_live_bytes;
+    int64_t m_peak_live_bytes;
+};
+
+// Backs the CHECK_MAX_* macros: runs the body once inside an allocation_scope and reports a test failure
+// when the chosen count exceeds the budget.
+class allocation_budget
+{
+public:
+    enum measure { allocations, bytes, peak_live_bytes };
+
+    TEST_UTILITY_API allocation_budget(measure what, size_t budget, const char *budget_text, int line);
+    TEST_UTILITY_API ~allocation_budget();
+
+    // True before the body runs and false, after checking the budget, once it has run.
+    TEST_UTILITY_API bool enter();
+
+private:
+    allocation_budget(const allocation_budget &);
+    allocation_budget & operator=(const allocation_budget &);
+
+    measure m_what;
+    size_t m_budget;
+    const char *m_budget_text;
+    int m_line;
+    bool m_entered;
+    allocation_scope m_scope;
+};
+
+}}}
+
+// Usage: CHECK_MAX_ALLOCATIONS(12) { parser.parse_uri(uri); }
+// The budget is only checked when the body completes; an exception leaving the body skips the check.
+#define CHECK_MAX_ALLOCATIONS(budget) \
+    for (::tests::common::utilities::allocation_budget _allocation_budget(::tests::common::utilities::allocation_budget::allocations, (budget), #budget, __LINE__); _allocation_budget.enter(); )
+
+#define CHECK_MAX_ALLOCATED_BYTES(budget) \
+    for (::tests::common::utilities::allocation_budget _allocation_budget(::tests::common::utilities::allocation_budget::bytes, (budget), #budget, __LINE__); _allocation_budget.enter(); )
+
+#define CHECK_MAX_PEAK_LIVE_BYTES(budget) \
+    for (::tests::common::utilities::allocation_budget _allocation_budget(::tests::common::utilities::allocation_budget::peak_live_bytes, (budget), #budget, __LINE__); _allocation_budget.enter(); )
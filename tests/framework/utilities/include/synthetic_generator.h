@@ -0,0 +1,106 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="synthetic_generator.h" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#pragma once
+
+#include "common_utilities_public.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tests { namespace common { namespace utilities {
+
+struct synthetic_model_options
+{
+    TEST_UTILITY_API synthetic_model_options();
+
+    // Everything generated is a function of the options, the seed included.
+    uint64_t seed;
+    int schema_count;
+    // Enum, complex and entity types over all schemas; roughly a tenth are enums, a fifth complex types.
+    int type_count;
+    // Structural properties declared by each complex and entity type.
+    int properties_per_type;
+    // How many levels of derived entity types sit below each entity type with a key.
+    int inheritance_depth;
+    // Navigation properties declared by each entity type, alternately single and collection valued.
+    int navigation_fan_out;
+};
+
+// Generates a CSDL model of configurable size and shape together with JSON payloads and request URLs that
+// match it, for exercising the library at scales that hand-written fixtures never reach.
+//
+// Every entity type gets an entity set named Set<n> in one container, bound along every navigation property.
+// Payloads and URLs are deterministic: the same options, set, id or index always produce the same text.
+// All strings are UTF-8; URLs are relative to the service root and not percent-encoded.
+class synthetic_model
+{
+public:
+    TEST_UTILITY_API explicit synthetic_model(const synthetic_model_options &options);
+
+    const synthetic_model_options & options() const { return m_options; }
+
+    TEST_UTILITY_API std::string csdl() const;
+
+    size_t entity_set_count() const { return m_entity_types.size(); }
+    TEST_UTILITY_API std::string entity_set_name(size_t set) const;
+
+    // An entity of the set's type as a response payload, @odata.context included.
+    TEST_UTILITY_API std::string entity_payload(const std::string &service_root, size_t set, uint64_t id) const;
+
+    // Entities with ids 1 to count of the set as a response payload.
+    TEST_UTILITY_API std::string collection_payload(const std::string &service_root, size_t set, uint64_t count) const;
+    TEST_UTILITY_API void write_collection_payload(std::ostream &stream, const std::string &service_root, size_t set, uint64_t count) const;
+
+    // A request URL with a path into one of the sets and a mix of $filter, $expand, $select, $orderby and $top.
+    TEST_UTILITY_API std::string query_url(uint64_t index) const;
+
+private:
+    enum property_kind { String, Int32, Int64, Double, Boolean, DateTimeOffset, Enum, Complex, StringCollection, KindCount };
+
+    struct property
+    {
+        std::string name;
+        property_kind kind;
+        // The enum or complex type of the property.
+        size_t type;
+    };
+
+    struct navigation
+    {
+        std::string name;
+        size_t target;
+        bool collection;
+    };
+
+    struct structured_type
+    {
+        std::string name;
+        int schema;
+        // The base entity type plus one, or zero.
+        size_t base;
+        std::vector<property> properties;
+        std::vector<navigation> navigations;
+    };
+
+    std::string name_space(int schema) const;
+    std::string qualified_name(int schema, const std::string &name) const;
+    std::string context_url(const std::string &service_root, size_t set) const;
+    void collect_properties(size_t entity_type, std::vector<const property *> &properties) const;
+    void collect_navigations(size_t entity_type, std::vector<const navigation *> &navigations) const;
+    void write_properties(std::ostream &stream, const std::vector<property> &properties) const;
+    void write_entity(std::ostream &stream, size_t set, uint64_t id) const;
+    void write_value(std::ostream &stream, const property &property, uint64_t &state) const;
+
+    synthetic_model_options m_options;
+    std::vector<std::string> m_enum_types;
+    std::vector<int> m_enum_schemas;
+    std::vector<structured_type> m_complex_types;
+    std::vector<structured_type> m_entity_types;
+};
+
+}}}
@@ -0,0 +1,509 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="synthetic_generator.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include "synthetic_generator.h"
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+namespace tests { namespace common { namespace utilities {
+
+// splitmix64: tiny, fast and, unlike the standard distributions, identical on every platform.
+static uint64_t next_random(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static size_t pick(uint64_t &state, size_t count)
+{
+    return (size_t)(next_random(state) % count);
+}
+
+static const char *const g_property_words[] = { "Name", "Count", "Number", "Amount", "Active", "Created", "State", "Detail", "Tags" };
+static const char *const g_comparisons[] = { "eq", "ne", "gt", "ge", "lt", "le" };
+
+synthetic_model_options::synthetic_model_options()
+    : seed(1), schema_count(1), type_count(10), properties_per_type(8), inheritance_depth(1), navigation_fan_out(2)
+{
+}
+
+synthetic_model::synthetic_model(const synthetic_model_options &options) : m_options(options)
+{
+    if (options.schema_count < 1 || options.type_count < 1 || options.properties_per_type < 0
+        || options.inheritance_depth < 0 || options.navigation_fan_out < 0)
+    {
+        throw std::invalid_argument("invalid synthetic model options");
+    }
+
+    uint64_t state = options.seed;
+    size_t enum_count = options.type_count / 10;
+    size_t complex_count = options.type_count / 5;
+    size_t entity_count = std::max<size_t>(1, options.type_count - enum_count - complex_count);
+
+    for (size_t i = 0; i < enum_count; i++)
+    {
+        m_enum_types.push_back("Enum" + std::to_string(i));
+        m_enum_schemas.push_back((int)(i % options.schema_count));
+    }
+
+    static const property_kind complex_kinds[] = { String, Int32, Double, Boolean };
+    for (size_t i = 0; i < complex_count; i++)
+    {
+        structured_type complex_type;
+        complex_type.name = "Complex" + std::to_string(i);
+        complex_type.schema = (int)(i % options.schema_count);
+        complex_type.base = 0;
+        for (int j = 0; j < options.properties_per_type; j++)
+        {
+            property field = { "Field" + std::to_string(j), complex_kinds[j % 4], 0 };
+            complex_type.properties.push_back(field);
+        }
+        m_complex_types.push_back(complex_type);
+    }
+
+    // Entity types come in chains of inheritance_depth + 1 that share a schema; the first of a chain has the key.
+    size_t chain_length = options.inheritance_depth + 1;
+    for (size_t i = 0; i < entity_count; i++)
+    {
+        size_t level = i % chain_length;
+        // Derived types tag their members with the level so that names stay unique along the chain.
+        std::string suffix = level ? "D" + std::to_string(level) : "";
+
+        structured_type entity_type;
+        entity_type.name = "Entity" + std::to_string(i);
+        entity_type.schema = (int)((i / chain_length) % options.schema_count);
+        entity_type.base = level ? i : 0;
+
+        size_t first_kind = pick(state, KindCount);
+        for (int j = 0; j < options.properties_per_type; j++)
+        {
+            auto kind = (property_kind)((first_kind + j) % KindCount);
+            if (kind == Enum && m_enum_types.empty())
+            {
+                kind = String;
+            }
+            else if (kind == Complex && m_complex_types.empty())
+            {
+                kind = Int32;
+            }
+
+            property field = { g_property_words[kind] + std::to_string(j) + suffix, kind, 0 };
+            if (kind == Enum)
+            {
+                field.type = pick(state, m_enum_types.size());
+            }
+            else if (kind == Complex)
+            {
+                field.type = pick(state, m_complex_types.size());
+            }
+            entity_type.properties.push_back(field);
+        }
+
+        for (int k = 0; k < options.navigation_fan_out; k++)
+        {
+            navigation link = { "Nav" + std::to_string(k) + suffix, pick(state, entity_count), k % 2 == 1 };
+            entity_type.navigations.push_back(link);
+        }
+
+        m_entity_types.push_back(entity_type);
+    }
+}
+
+std::string synthetic_model::name_space(int schema) const
+{
+    return "Synthetic.S" + std::to_string(schema);
+}
+
+std::string synthetic_model::qualified_name(int schema, const std::string &name) const
+{
+    return name_space(schema) + "." + name;
+}
+
+void synthetic_model::collect_properties(size_t entity_type, std::vector<const property *> &properties) const
+{
+    const auto &type = m_entity_types[entity_type];
+    if (type.base)
+    {
+        collect_properties(type.base - 1, properties);
+    }
+    for (auto iter = type.properties.cbegin(); iter != type.properties.cend(); ++iter)
+    {
+        properties.push_back(&*iter);
+    }
+}
+
+void synthetic_model::collect_navigations(size_t entity_type, std::vector<const navigation *> &navigations) const
+{
+    const auto &type = m_entity_types[entity_type];
+    if (type.base)
+    {
+        collect_navigations(type.base - 1, navigations);
+    }
+    for (auto iter = type.navigations.cbegin(); iter != type.navigations.cend(); ++iter)
+    {
+        navigations.push_back(&*iter);
+    }
+}
+
+void synthetic_model::write_properties(std::ostream &stream, const std::vector<property> &properties) const
+{
+    static const char *const primitive_types[] = { "Edm.String", "Edm.Int32", "Edm.Int64", "Edm.Double", "Edm.Boolean", "Edm.DateTimeOffset" };
+    for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter)
+    {
+        stream << "<Property Name=\"" << iter->name << "\" Type=\"";
+        if (iter->kind == Enum)
+        {
+            stream << qualified_name(m_enum_schemas[iter->type], m_enum_types[iter->type]);
+        }
+        else if (iter->kind == Complex)
+        {
+            stream << qualified_name(m_complex_types[iter->type].schema, m_complex_types[iter->type].name);
+        }
+        else if (iter->kind == StringCollection)
+        {
+            stream << "Collection(Edm.String)";
+        }
+        else
+        {
+            stream << primitive_types[iter->kind];
+        }
+        stream << "\"/>";
+    }
+}
+
+std::string synthetic_model::csdl() const
+{
+    std::ostringstream stream;
+    stream << "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+        << "<edmx:Edmx xmlns:edmx=\"http://docs.oasis-open.org/odata/ns/edmx\" Version=\"4.0\"><edmx:DataServices>";
+
+    for (int schema = 0; schema < m_options.schema_count; schema++)
+    {
+        stream << "<Schema xmlns=\"http://docs.oasis-open.org/odata/ns/edm\" Namespace=\"" << name_space(schema) << "\">";
+
+        for (size_t i = 0; i < m_enum_types.size(); i++)
+        {
+            if (m_enum_schemas[i] == schema)
+            {
+                stream << "<EnumType Name=\"" << m_enum_types[i] << "\">"
+                    << "<Member Name=\"M0\" Value=\"0\"/><Member Name=\"M1\" Value=\"1\"/><Member Name=\"M2\" Value=\"2\"/><Member Name=\"M3\" Value=\"3\"/>"
+                    << "</EnumType>";
+            }
+        }
+
+        for (auto iter = m_complex_types.cbegin(); iter != m_complex_types.cend(); ++iter)
+        {
+            if (iter->schema == schema)
+            {
+                stream << "<ComplexType Name=\"" << iter->name << "\">";
+                write_properties(stream, iter->properties);
+                stream << "</ComplexType>";
+            }
+        }
+
+        for (auto iter = m_entity_types.cbegin(); iter != m_entity_types.cend(); ++iter)
+        {
+            if (iter->schema != schema)
+            {
+                continue;
+            }
+
+            stream << "<EntityType Name=\"" << iter->name << "\"";
+            if (iter->base)
+            {
+                const auto &base = m_entity_types[iter->base - 1];
+                stream << " BaseType=\"" << qualified_name(base.schema, base.name) << "\">";
+            }
+            else
+            {
+                stream << "><Key><PropertyRef Name=\"Id\"/></Key><Property Name=\"Id\" Type=\"Edm.Int64\" Nullable=\"false\"/>";
+            }
+            write_properties(stream, iter->properties);
+            for (auto link = iter->navigations.cbegin(); link != iter->navigations.cend(); ++link)
+            {
+                const auto &target = m_entity_types[link->target];
+                stream << "<NavigationProperty Name=\"" << link->name << "\" Type=\""
+                    << (link->collection ? "Collection(" : "") << qualified_name(target.schema, target.name) << (link->collection ? ")" : "")
+                    << "\"/>";
+            }
+            stream << "</EntityType>";
+        }
+
+        if (schema == m_options.schema_count - 1)
+        {
+            stream << "<EntityContainer Name=\"Container\">";
+            for (size_t i = 0; i < m_entity_types.size(); i++)
+            {
+                stream << "<EntitySet Name=\"" << entity_set_name(i) << "\" EntityType=\"" << qualified_name(m_entity_types[i].schema, m_entity_types[i].name) << "\">";
+                std::vector<const navigation *> navigations;
+                collect_navigations(i, navigations);
+                for (auto link = navigations.cbegin(); link != navigations.cend(); ++link)
+                {
+                    stream << "<NavigationPropertyBinding Path=\"" << (*link)->name << "\" Target=\"" << entity_set_name((*link)->target) << "\"/>";
+                }
+                stream << "</EntitySet>";
+            }
+            stream << "</EntityContainer>";
+        }
+
+        stream << "</Schema>";
+    }
+
+    stream << "</edmx:DataServices></edmx:Edmx>";
+    return stream.str();
+}
+
+std::string synthetic_model::entity_set_name(size_t set) const
+{
+    return "Set" + std::to_string(set);
+}
+
+std::string synthetic_model::context_url(const std::string &service_root, size_t set) const
+{
+    bool slash = !service_root.empty() && service_root.back() == '/';
+    return service_root + (slash ? "$metadata#" : "/$metadata#") + entity_set_name(set);
+}
+
+void synthetic_model::write_value(std::ostream &stream, const property &property, uint64_t &state) const
+{
+    char buffer[64];
+    switch (property.kind)
+    {
+    case String:
+        {
+            size_t length = 4 + pick(state, 20);
+            stream << '"';
+            for (size_t i = 0; i < length; i++)
+            {
+                stream << (char)('a' + pick(state, 26));
+            }
+            stream << '"';
+        }
+        break;
+    case Int32:
+        stream << pick(state, 100000);
+        break;
+    case Int64:
+        stream << next_random(state) % 1000000000000ULL;
+        break;
+    case Double:
+        std::snprintf(buffer, sizeof(buffer), "%.2f", (double)pick(state, 10000000) / 100.0);
+        stream << buffer;
+        break;
+    case Boolean:
+        stream << (pick(state, 2) ? "true" : "false");
+        break;
+    case DateTimeOffset:
+        std::snprintf(buffer, sizeof(buffer), "\"%04d-%02d-%02dT%02d:%02d:%02dZ\"", 2010 + (int)pick(state, 15), 1 + (int)pick(state, 12),
+            1 + (int)pick(state, 28), (int)pick(state, 24), (int)pick(state, 60), (int)pick(state, 60));
+        stream << buffer;
+        break;
+    case Enum:
+        stream << "\"M" << pick(state, 4) << '"';
+        break;
+    case Complex:
+        {
+            const auto &fields = m_complex_types[property.type].properties;
+            stream << '{';
+            for (size_t i = 0; i < fields.size(); i++)
+            {
+                stream << (i ? "," : "") << '"' << fields[i].name << "\":";
+                write_value(stream, fields[i], state);
+            }
+            stream << '}';
+        }
+        break;
+    case StringCollection:
+        {
+            size_t count = pick(state, 4);
+            stream << '[';
+            for (size_t i = 0; i < count; i++)
+            {
+                stream << (i ? ",\"tag" : "\"tag") << pick(state, 1000) << '"';
+            }
+            stream << ']';
+        }
+        break;
+    default:
+        stream << "null";
+        break;
+    }
+}
+
+void synthetic_model::write_entity(std::ostream &stream, size_t set, uint64_t id) const
+{
+    uint64_t state = m_options.seed ^ ((uint64_t)(set + 1) * 0xD1B54A32D192ED03ULL) ^ (id * 0x8CB92BA72F3D8DD7ULL);
+
+    std::vector<const property *> properties;
+    collect_properties(set, properties);
+
+    stream << "{\"Id\":" << id;
+    for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter)
+    {
+        stream << ",\"" << (*iter)->name << "\":";
+        write_value(stream, **iter, state);
+    }
+    stream << '}';
+}
+
+std::string synthetic_model::entity_payload(const std::string &service_root, size_t set, uint64_t id) const
+{
+    std::ostringstream stream;
+    std::ostringstream entity;
+    write_entity(entity, set, id);
+
+    // The entity's own braces enclose the context annotation too.
+    auto body = entity.str();
+    stream << "{\"@odata.context\":\"" << context_url(service_root, set) << "/$entity\"," << body.substr(1);
+    return stream.str();
+}
+
+std::string synthetic_model::collection_payload(const std::string &service_root, size_t set, uint64_t count) const
+{
+    std::ostringstream stream;
+    write_collection_payload(stream, service_root, set, count);
+    return stream.str();
+}
+
+void synthetic_model::write_collection_payload(std::ostream &stream, const std::string &service_root, size_t set, uint64_t count) const
+{
+    stream << "{\"@odata.context\":\"" << context_url(service_root, set) << "\",\"value\":[";
+    for (uint64_t id = 1; id <= count; id++)
+    {
+        if (id > 1)
+        {
+            stream << ',';
+        }
+        write_entity(stream, set, id);
+    }
+    stream << "]}";
+}
+
+std::string synthetic_model::query_url(uint64_t index) const
+{
+    uint64_t state = m_options.seed ^ ((index + 1) * 0x5851F42D4C957F2DULL);
+    size_t set = pick(state, m_entity_types.size());
+
+    std::vector<const property *> properties;
+    collect_properties(set, properties);
+    std::vector<const navigation *> navigations;
+    collect_navigations(set, navigations);
+
+    // Properties $filter and $orderby can compare, by kind.
+    std::vector<const property *> comparable;
+    for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter)
+    {
+        auto kind = (*iter)->kind;
+        if (kind == String || kind == Int32 || kind == Double || kind == Boolean || kind == DateTimeOffset)
+        {
+            comparable.push_back(*iter);
+        }
+    }
+
+    std::ostringstream url;
+    std::vector<std::string> options;
+    bool single = pick(state, 4) == 0;
+    url << entity_set_name(set);
+    if (single)
+    {
+        url << '(' << 1 + pick(state, 100000) << ')';
+    }
+
+    if (!single && !comparable.empty())
+    {
+        std::ostringstream filter;
+        size_t terms = 1 + pick(state, 3);
+        for (size_t i = 0; i < terms; i++)
+        {
+            const auto &target = *comparable[pick(state, comparable.size())];
+            if (i)
+            {
+                filter << (pick(state, 3) ? " and " : " or ");
+            }
+
+            switch (target.kind)
+            {
+            case String:
+                if (pick(state, 2))
+                {
+                    filter << "contains(" << target.name << ",'" << (char)('a' + pick(state, 26)) << (char)('a' + pick(state, 26)) << "')";
+                }
+                else
+                {
+                    filter << target.name << " eq 'abc'";
+                }
+                break;
+            case Boolean:
+                filter << target.name << " eq " << (pick(state, 2) ? "true" : "false");
+                break;
+            case DateTimeOffset:
+                filter << target.name << ' ' << g_comparisons[pick(state, 6)] << ' ' << 2010 + pick(state, 15) << "-06-01T00:00:00Z";
+                break;
+            case Double:
+                filter << target.name << ' ' << g_comparisons[pick(state, 6)] << ' ' << pick(state, 100000) << ".5";
+                break;
+            default:
+                filter << target.name << ' ' << g_comparisons[pick(state, 6)] << ' ' << pick(state, 100000);
+                break;
+            }
+        }
+        options.push_back("$filter=" + filter.str());
+    }
+
+    if (!properties.empty() && pick(state, 2))
+    {
+        std::string select = "$select=Id";
+        size_t count = 1 + pick(state, 3);
+        for (size_t i = 0; i < count; i++)
+        {
+            select += "," + properties[pick(state, properties.size())]->name;
+        }
+        options.push_back(select);
+    }
+
+    if (!navigations.empty() && pick(state, 3))
+    {
+        const auto &link = *navigations[pick(state, navigations.size())];
+        std::string expand = "$expand=" + link.name;
+
+        std::vector<const property *> target_properties;
+        collect_properties(link.target, target_properties);
+        if (!target_properties.empty())
+        {
+            expand += "($select=Id," + target_properties[pick(state, target_properties.size())]->name;
+            if (link.collection)
+            {
+                expand += ";$top=" + std::to_string(1 + pick(state, 10));
+            }
+            expand += ")";
+        }
+        options.push_back(expand);
+    }
+
+    if (!single && !comparable.empty() && pick(state, 2))
+    {
+        options.push_back("$orderby=" + comparable[pick(state, comparable.size())]->name + (pick(state, 2) ? " desc" : ""));
+    }
+
+    if (!single)
+    {
+        options.push_back("$top=" + std::to_string(10 + pick(state, 91)));
+    }
+
+    for (size_t i = 0; i < options.size(); i++)
+    {
+        url << (i ? '&' : '?') << options[i];
+    }
+    return url.str();
+}
+
+}}}
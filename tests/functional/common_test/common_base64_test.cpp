@@ -0,0 +1,169 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="common_base64_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/common/utility.h"
+#include "odata/core/odata_json_codegen.h"
+
+using namespace ::odata::utility;
+
+namespace tests { namespace functional { namespace _odata {
+
+// Sizes around every block boundary of the vector kernels, and a few long ones that run them for many blocks.
+static const size_t base64_sizes[] = { 0, 1, 2, 3, 4, 11, 12, 13, 15, 16, 17, 23, 24, 25, 27, 28, 29, 35, 36, 37, 47, 48, 49, 100, 1000, 4097, 65539 };
+
+static std::vector<unsigned char> base64_bytes(size_t size)
+{
+	std::vector<unsigned char> bytes(size);
+	uint32_t state = 2463534242u;
+	for (size_t i = 0; i < size; i++)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		bytes[i] = (unsigned char)state;
+	}
+	return bytes;
+}
+
+static string_t base64_reference(const std::vector<unsigned char>& bytes)
+{
+	static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	string_t text;
+	for (size_t i = 0; i < bytes.size(); i += 3)
+	{
+		uint32_t bits = (uint32_t)bytes[i] << 16;
+		if (i + 1 < bytes.size()) bits |= (uint32_t)bytes[i + 1] << 8;
+		if (i + 2 < bytes.size()) bits |= bytes[i + 2];
+		text += (char_t)alphabet[bits >> 18];
+		text += (char_t)alphabet[(bits >> 12) & 0x3F];
+		text += i + 1 < bytes.size() ? (char_t)alphabet[(bits >> 6) & 0x3F] : U('=');
+		text += i + 2 < bytes.size() ? (char_t)alphabet[bits & 0x3F] : U('=');
+	}
+	return text;
+}
+
+SUITE(common_base64_test)
+{
+
+TEST(encode_and_decode_match_reference)
+{
+	for (size_t i = 0; i < sizeof(base64_sizes) / sizeof(base64_sizes[0]); i++)
+	{
+		auto bytes = base64_bytes(base64_sizes[i]);
+		auto text = conversions::to_base64(bytes);
+		VERIFY_IS_TRUE(text == base64_reference(bytes));
+		VERIFY_IS_TRUE(conversions::from_base64(text) == bytes);
+	}
+
+	VERIFY_ARE_EQUAL(conversions::to_base64((uint64_t)0), U("AAAAAAAAAAA="));
+	VERIFY_ARE_EQUAL(conversions::to_base64(std::vector<unsigned char>(1, 0xFF)), U("/w=="));
+	VERIFY_IS_TRUE(conversions::from_base64(U("+/+/")) == std::vector<unsigned char>({ 0xFB, 0xFF, 0xBF }));
+}
+
+TEST(decode_into_caller_buffer)
+{
+	auto bytes = base64_bytes(1000);
+	auto text = conversions::to_base64(bytes);
+	std::vector<unsigned char> buffer(text.size() / 4 * 3);
+	VERIFY_ARE_EQUAL(conversions::from_base64(text.data(), text.size(), buffer.data()), 1000);
+	buffer.resize(1000);
+	VERIFY_IS_TRUE(buffer == bytes);
+
+	string_t appended = U("prefix:");
+	conversions::to_base64(bytes.data(), bytes.size(), appended);
+	VERIFY_IS_TRUE(appended == U("prefix:") + text);
+}
+
+TEST(decode_rejects_invalid_text)
+{
+	VERIFY_THROWS(conversions::from_base64(U("AAA")), std::runtime_error);
+	VERIFY_THROWS(conversions::from_base64(U("AA=A")), std::runtime_error);
+	VERIFY_THROWS(conversions::from_base64(U("A===")), std::runtime_error);
+	VERIFY_THROWS(conversions::from_base64(U("AA==AAAA")), std::runtime_error);
+	VERIFY_THROWS(conversions::from_base64(U("AB==")), std::runtime_error);
+	VERIFY_THROWS(conversions::from_base64(U("AAB=")), std::runtime_error);
+	VERIFY_IS_TRUE(conversions::from_base64(U("AA==")) == std::vector<unsigned char>(1, 0));
+
+	// Corrupt long text at positions that the vector kernels and the scalar code each get to check.
+	auto text = conversions::to_base64(base64_bytes(300));
+	const size_t positions[] = { 0, 5, 17, 31, 63, 100, 350, text.size() - 5 };
+	for (size_t i = 0; i < sizeof(positions) / sizeof(positions[0]); i++)
+	{
+		auto invalid = text;
+		invalid[positions[i]] = U('.');
+		VERIFY_THROWS(conversions::from_base64(invalid), std::runtime_error);
+		invalid[positions[i]] = (char_t)0xC3;
+		VERIFY_THROWS(conversions::from_base64(invalid), std::runtime_error);
+		invalid[positions[i]] = U('=');
+		VERIFY_THROWS(conversions::from_base64(invalid), std::runtime_error);
+	}
+}
+
+TEST(streaming_encoder_and_decoder_ignore_chunking)
+{
+	auto bytes = base64_bytes(4097);
+	auto text = conversions::to_base64(bytes);
+	const size_t chunk_sizes[] = { 1, 2, 3, 5, 16, 100, 4097 };
+	for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); i++)
+	{
+		string_t encoded;
+		conversions::base64_encoder encoder(encoded);
+		for (size_t offset = 0; offset < bytes.size(); offset += chunk_sizes[i])
+		{
+			encoder.write(bytes.data() + offset, std::min(chunk_sizes[i], bytes.size() - offset));
+		}
+		encoder.finish();
+		VERIFY_IS_TRUE(encoded == text);
+
+		std::vector<unsigned char> decoded;
+		conversions::base64_decoder decoder(decoded);
+		for (size_t offset = 0; offset < text.size(); offset += chunk_sizes[i])
+		{
+			decoder.write(text.data() + offset, std::min(chunk_sizes[i], text.size() - offset));
+		}
+		decoder.finish();
+		VERIFY_IS_TRUE(decoded == bytes);
+	}
+}
+
+TEST(streaming_decoder_rejects_invalid_text)
+{
+	std::vector<unsigned char> decoded;
+	conversions::base64_decoder truncated(decoded);
+	truncated.write(U("AAAAA"), 5);
+	VERIFY_THROWS(truncated.finish(), std::runtime_error);
+
+	conversions::base64_decoder after_padding(decoded);
+	after_padding.write(U("AA=="), 4);
+	VERIFY_THROWS(after_padding.write(U("A"), 1), std::runtime_error);
+
+	conversions::base64_decoder invalid(decoded);
+	invalid.write(U("AA"), 2);
+	VERIFY_THROWS(invalid.write(U("A!"), 2), std::runtime_error);
+}
+
+TEST(generated_json_binary_round_trip)
+{
+	auto bytes = base64_bytes(100);
+	string_t json;
+	::odata::core::write_json(json, bytes);
+	VERIFY_IS_TRUE(json == U("\"") + conversions::to_base64(bytes) + U("\""));
+
+	std::vector<unsigned char> read;
+	::odata::core::odata_json_codegen_reader reader(json);
+	::odata::core::read_json(reader, read);
+	VERIFY_IS_TRUE(read == bytes);
+
+	// Escape sequences are valid JSON even where base64 never needs them.
+	::odata::core::odata_json_codegen_reader escaped(U("\"AQ\\u0049D\""));
+	::odata::core::read_json(escaped, read);
+	VERIFY_IS_TRUE(read == std::vector<unsigned char>({ 1, 2, 3 }));
+}
+
+}
+
+}}}
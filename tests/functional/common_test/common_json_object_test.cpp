@@ -0,0 +1,143 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="common_json_object_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/common/json.h"
+
+using namespace ::odata::utility;
+
+namespace tests { namespace functional { namespace _odata {
+
+static string_t field_name(size_t index)
+{
+	// Keys that share long prefixes, as property names of wide entities do.
+	return U("Property") + conversions::print_string(index * 7919 % 100003);
+}
+
+static string_t wide_object_text(size_t width)
+{
+	string_t text = U("{");
+	for (size_t i = 0; i < width; i++)
+	{
+		text += (i ? U(",\"") : U("\"")) + field_name(i) + U("\":") + conversions::print_string(i);
+	}
+	return text + U("}");
+}
+
+// Parses with the order of object fields kept, restoring the default afterwards.
+static json::value parse_keeping_order(const string_t& text)
+{
+	json::keep_object_element_order(true);
+	try
+	{
+		auto result = json::value::parse(text);
+		json::keep_object_element_order(false);
+		return result;
+	}
+	catch (...)
+	{
+		json::keep_object_element_order(false);
+		throw;
+	}
+}
+
+SUITE(common_json_object_test)
+{
+
+TEST(ordered_object_finds_fields_past_index_threshold)
+{
+	const size_t width = 300;
+	VERIFY_IS_TRUE(width > json::object::index_threshold);
+
+	auto value = parse_keeping_order(wide_object_text(width));
+	const auto& object = value.as_object();
+	VERIFY_ARE_EQUAL(object.size(), width);
+
+	size_t position = 0;
+	for (auto iter = object.begin(); iter != object.end(); ++iter, ++position)
+	{
+		VERIFY_ARE_EQUAL(iter->first, field_name(position));
+	}
+
+	for (size_t i = 0; i < width; i++)
+	{
+		VERIFY_IS_TRUE(value.has_field(field_name(i)));
+		VERIFY_ARE_EQUAL(value.at(field_name(i)).as_integer(), (int)i);
+		VERIFY_IS_TRUE(object.find(field_name(i)) == object.begin() + i);
+	}
+
+	VERIFY_IS_FALSE(value.has_field(U("Property")));
+	VERIFY_IS_TRUE(object.find(U("Missing")) == object.end());
+	VERIFY_THROWS(object.at(U("Missing")), json::json_exception);
+
+	// Serialization keeps the order the fields were read in.
+	VERIFY_ARE_EQUAL(value.serialize(), wide_object_text(width));
+}
+
+TEST(ordered_object_indexes_fields_as_they_are_added)
+{
+	auto value = json::value::object(true);
+	for (size_t i = 0; i < 1000; i++)
+	{
+		value[field_name(i)] = json::value((int32_t)i);
+
+		// Probe around every growth of the index.
+		if (i == json::object::index_threshold || i == 31 || i == 32 || i == 999)
+		{
+			for (size_t j = 0; j <= i; j++)
+			{
+				VERIFY_ARE_EQUAL(value.at(field_name(j)).as_integer(), (int)j);
+			}
+			VERIFY_IS_FALSE(value.has_field(field_name(i + 1)));
+		}
+	}
+
+	value[field_name(500)] = json::value(U("replaced"));
+	VERIFY_ARE_EQUAL(value.size(), 1000);
+	VERIFY_ARE_EQUAL(value.as_object().begin()[500].second.as_string(), U("replaced"));
+	VERIFY_ARE_EQUAL(value.as_object().begin()[999].first, field_name(999));
+
+	// A copy carries its own index.
+	json::value copy = value;
+	value[field_name(1000)] = json::value(1000);
+	VERIFY_IS_TRUE(copy.has_field(field_name(999)));
+	VERIFY_IS_FALSE(copy.has_field(field_name(1000)));
+	VERIFY_IS_TRUE(value.has_field(field_name(1000)));
+}
+
+TEST(ordered_object_finds_first_of_repeated_keys)
+{
+	string_t text = wide_object_text(40);
+	text.back() = U(',');
+	text += U("\"") + field_name(3) + U("\":-1}");
+
+	auto wide = parse_keeping_order(text);
+	VERIFY_ARE_EQUAL(wide.size(), 41);
+	VERIFY_ARE_EQUAL(wide.at(field_name(3)).as_integer(), 3);
+
+	auto narrow = parse_keeping_order(U("{\"a\":1,\"b\":2,\"a\":3}"));
+	VERIFY_ARE_EQUAL(narrow.at(U("a")).as_integer(), 1);
+}
+
+TEST(sorted_object_is_unchanged)
+{
+	auto value = json::value::parse(wide_object_text(100));
+	const auto& object = value.as_object();
+	for (auto iter = object.begin(); iter + 1 != object.end(); ++iter)
+	{
+		VERIFY_IS_TRUE(iter->first < (iter + 1)->first);
+	}
+
+	for (size_t i = 0; i < 100; i++)
+	{
+		VERIFY_ARE_EQUAL(value.at(field_name(i)).as_integer(), (int)i);
+	}
+	VERIFY_IS_FALSE(value.has_field(U("Missing")));
+}
+
+}
+
+}}}
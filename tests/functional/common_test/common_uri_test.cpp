@@ -0,0 +1,145 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="common_uri_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/common/uri.h"
+
+using namespace ::odata::utility;
+
+namespace tests { namespace functional { namespace _odata {
+
+SUITE(common_uri_test)
+{
+
+TEST(uri_components)
+{
+	uri value(U("http://user@Example.COM:8080/Root/Set(1)?$top=1&$skip=2#frag"));
+	VERIFY_ARE_EQUAL(value.scheme(), U("http"));
+	VERIFY_ARE_EQUAL(value.user_info(), U("user"));
+	VERIFY_ARE_EQUAL(value.host(), U("example.com"));
+	VERIFY_ARE_EQUAL(value.port(), 8080);
+	VERIFY_ARE_EQUAL(value.path(), U("/Root/Set(1)"));
+	VERIFY_ARE_EQUAL(value.query(), U("$top=1&$skip=2"));
+	VERIFY_ARE_EQUAL(value.fragment(), U("frag"));
+	VERIFY_ARE_EQUAL(value.to_string(), U("http://user@example.com:8080/Root/Set(1)?$top=1&$skip=2#frag"));
+	VERIFY_IS_FALSE(value.is_path_empty());
+}
+
+TEST(uri_relative_reference)
+{
+	uri value(U("Customers(1)/Orders?$top=5"));
+	VERIFY_ARE_EQUAL(value.scheme(), U(""));
+	VERIFY_ARE_EQUAL(value.host(), U(""));
+	VERIFY_ARE_EQUAL(value.port(), 0);
+	VERIFY_ARE_EQUAL(value.path(), U("Customers(1)/Orders"));
+	VERIFY_ARE_EQUAL(value.query(), U("$top=5"));
+	VERIFY_ARE_EQUAL(value.to_string(), U("Customers(1)/Orders?$top=5"));
+}
+
+TEST(uri_empty)
+{
+	uri value;
+	VERIFY_IS_TRUE(value.is_empty());
+	VERIFY_ARE_EQUAL(value.path(), U("/"));
+	VERIFY_ARE_EQUAL(value.port(), -1);
+	VERIFY_IS_TRUE(uri(U("")).is_empty());
+	VERIFY_IS_TRUE(uri(U("")) == value);
+}
+
+TEST(uri_is_canonicalized)
+{
+	VERIFY_ARE_EQUAL(uri(U("HTTP://Host")).to_string(), U("http://host/"));
+	VERIFY_ARE_EQUAL(uri(U("http://host:080/path?")).to_string(), U("http://host:80/path"));
+	VERIFY_ARE_EQUAL(uri(U("http://host:080/path?")).port(), 80);
+	VERIFY_ARE_EQUAL(uri(U("http://host:0/path#")).to_string(), U("http://host/path"));
+	VERIFY_ARE_EQUAL(uri(U("http://host?a=1")).to_string(), U("http://host/?a=1"));
+	VERIFY_ARE_EQUAL(uri(U("http://host?a=1")).query(), U("a=1"));
+	VERIFY_ARE_EQUAL(uri(U("?a=1")).to_string(), U("/?a=1"));
+	VERIFY_ARE_EQUAL(uri(U("file:///tmp/file")).to_string(), U("file:/tmp/file"));
+	VERIFY_ARE_EQUAL(uri(U("file:///tmp/file")).path(), U("/tmp/file"));
+
+	auto text = U("http://host/path");
+	VERIFY_ARE_EQUAL(uri(std::move(text)).to_string(), U("http://host/path"));
+}
+
+TEST(uri_invalid_throws)
+{
+	VERIFY_THROWS(uri(U("http://ho st/")), uri_exception);
+	VERIFY_THROWS(uri(U("1http://host/")), uri_exception);
+	VERIFY_IS_FALSE(uri::validate(U("http://host/a b")));
+	VERIFY_IS_TRUE(uri::validate(U("http://host/a%20b")));
+}
+
+TEST(uri_equality_decodes_components)
+{
+	VERIFY_IS_TRUE(uri(U("http://Host/%61?%62")) == uri(U("http://host/a?b")));
+	VERIFY_IS_TRUE(uri(U("http://host/a")) != uri(U("http://host/b")));
+	VERIFY_IS_TRUE(uri(U("http://host:80/a")) != uri(U("http://host/a")));
+	VERIFY_IS_TRUE(uri(U("http://host:80/a?b")).has_same_authority(uri(U("http://HOST:80/c"))));
+	VERIFY_ARE_EQUAL(uri(U("http://user@host:80/a?b#c")).authority().to_string(), U("http://user@host:80/"));
+	VERIFY_ARE_EQUAL(uri(U("http://host:80/a?b#c")).resource().to_string(), U("/a?b#c"));
+}
+
+TEST(uri_encode_and_decode)
+{
+	VERIFY_ARE_EQUAL(uri::encode_uri(U("Name eq 'a b'&$top=1"), uri::components::query), U("Name%20eq%20'a%20b'&$top=1"));
+	VERIFY_ARE_EQUAL(uri::encode_uri(U("a+b/c"), uri::components::path), U("a%2Bb/c"));
+	VERIFY_ARE_EQUAL(uri::encode_uri(U("http://host/a b?c=\"d\"")), U("http://host/a%20b?c=%22d%22"));
+	VERIFY_ARE_EQUAL(uri::encode_data_string(U("a/b c")), U("a%2Fb%20c"));
+	auto e_acute = conversions::to_string_t("\xc3\xa9");
+	VERIFY_ARE_EQUAL(uri::encode_uri(e_acute, uri::components::path), U("%C3%A9"));
+
+	VERIFY_ARE_EQUAL(uri::decode(U("a%2Fb%20c%c3%A9")), U("a/b c") + e_acute);
+	VERIFY_ARE_EQUAL(uri::decode(U("plain")), U("plain"));
+	VERIFY_THROWS(uri::decode(U("a%2")), uri_exception);
+	VERIFY_THROWS(uri::decode(U("a%2G")), uri_exception);
+}
+
+TEST(uri_builder_appends_in_place)
+{
+	uri_builder builder(uri(U("http://host/Root")));
+	builder.append_path(U("Set(1)")).append_path(U("/Nav/")).append_path(U("/Property"));
+	builder.append_query(U("$top=1")).append_query(U("&$skip=2")).append_query(U("$count=true"));
+	VERIFY_ARE_EQUAL(builder.path(), U("/Root/Set(1)/Nav/Property"));
+	VERIFY_ARE_EQUAL(builder.query(), U("$top=1&$skip=2&$count=true"));
+	VERIFY_ARE_EQUAL(builder.to_string(), U("http://host/Root/Set(1)/Nav/Property?$top=1&$skip=2&$count=true"));
+
+	builder.set_fragment(U("frag")).set_port(8080).set_host(U("Other")).set_scheme(U("HTTPS"));
+	VERIFY_ARE_EQUAL(builder.host(), U("Other"));
+	VERIFY_ARE_EQUAL(builder.to_uri().to_string(), U("https://other:8080/Root/Set(1)/Nav/Property?$top=1&$skip=2&$count=true#frag"));
+	VERIFY_IS_TRUE(builder.is_valid());
+
+	builder.append(uri(U("/More?$format=json#tail")));
+	VERIFY_ARE_EQUAL(builder.to_string(), U("https://other:8080/Root/Set(1)/Nav/Property/More?$top=1&$skip=2&$count=true&$format=json#fragtail"));
+}
+
+TEST(uri_builder_reuse_and_encoding)
+{
+	uri_builder builder;
+	VERIFY_ARE_EQUAL(builder.to_string(), U("/"));
+	VERIFY_ARE_EQUAL(builder.port(), -1);
+
+	builder.append_path(U("a b"), true).append_query(U("x=a b"), true);
+	VERIFY_ARE_EQUAL(builder.to_string(), U("/a%20b?x=a%20b"));
+
+	builder.clear();
+	VERIFY_ARE_EQUAL(builder.path(), U("/"));
+	VERIFY_ARE_EQUAL(builder.query(), U(""));
+	builder.set_scheme(U("http")).set_host(U("host")).set_path(U("relative"));
+	VERIFY_ARE_EQUAL(builder.to_string(), U("http://host/relative"));
+
+	builder.set_path(U("a b"));
+	VERIFY_IS_FALSE(builder.is_valid());
+	VERIFY_THROWS(builder.to_uri(), uri_exception);
+
+	auto original = uri(U("http://user@host:81/a/b?c=d#e"));
+	VERIFY_ARE_EQUAL(uri_builder(original).to_uri().to_string(), original.to_string());
+	VERIFY_ARE_EQUAL(uri_builder(original).user_info(), U("user"));
+}
+
+}
+
+}}}
@@ -0,0 +1,170 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_allocation_budget_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "allocation_tracker.h"
+#include "odata/core/odata_core.h"
+#include "odata/core/odata_json_reader_minimal.h"
+#include "odata/core/odata_json_writer.h"
+#include "odata/core/odata_uri_parser.h"
+
+using namespace ::odata::core;
+using namespace ::odata::edm;
+using namespace ::tests::common::utilities;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::shared_ptr<odata_entity_value> make_account()
+{
+	auto model = get_test_model();
+	auto account_info = std::make_shared<odata_complex_value>(model->find_complex_type(U("AccountInfo")));
+	account_info->set_value(U("FirstName"), U("Leo"));
+	account_info->set_value(U("LastName"), U("Hu"));
+
+	auto account = std::make_shared<odata_entity_value>(model->find_entity_type(U("Account")));
+	account->set_value(U("AccountID"), (int32_t)100);
+	account->set_value(U("AccountInfo"), account_info);
+	account->set_value(U("Country"), U("China"));
+	return account;
+}
+
+// Budgets for the per-request hot paths, a little above what they cost today. Lower them when a change
+// makes a path cheaper; raising one needs a reason.
+SUITE(odata_allocation_budget_tests)
+{
+
+TEST(scopes_count_allocations_bytes_and_peak)
+{
+	VERIFY_IS_TRUE(allocation_scope::is_hooked());
+
+	allocation_scope outer;
+	std::vector<char> *kept;
+	{
+		allocation_scope inner;
+		kept = new std::vector<char>(1000);
+		auto counts = inner.counts();
+		VERIFY_ARE_EQUAL(counts.allocations, 2);
+		VERIFY_ARE_EQUAL(counts.bytes, sizeof(std::vector<char>) + 1000);
+		VERIFY_IS_TRUE(counts.peak_live_bytes >= counts.bytes);
+	}
+	delete kept;
+	{
+		std::vector<char> transient(5000);
+	}
+
+	auto counts = outer.counts();
+	VERIFY_ARE_EQUAL(counts.allocations, 3);
+	VERIFY_ARE_EQUAL(counts.bytes, sizeof(std::vector<char>) + 6000);
+	VERIFY_IS_TRUE(counts.peak_live_bytes >= 5000);
+	VERIFY_IS_TRUE(counts.peak_live_bytes < 6000);
+}
+
+TEST(exceeded_budget_is_reported)
+{
+	UnitTest::TestResults results;
+	auto previous_results = UnitTest::CurrentTest::Results();
+	UnitTest::CurrentTest::Results() = &results;
+
+	CHECK_MAX_ALLOCATIONS(1)
+	{
+		std::vector<char> data(16);
+	}
+	CHECK_MAX_ALLOCATIONS(0)
+	{
+		std::vector<char> data(16);
+	}
+	CHECK_MAX_ALLOCATED_BYTES(8)
+	{
+		std::vector<char> data(16);
+	}
+	CHECK_MAX_PEAK_LIVE_BYTES(64)
+	{
+		for (int i = 0; i < 10; i++)
+		{
+			std::vector<char> data(16);
+		}
+	}
+
+	UnitTest::CurrentTest::Results() = previous_results;
+	VERIFY_ARE_EQUAL(results.GetFailureCount(), 2);
+}
+
+TEST(parse_uri_budget)
+{
+	odata_uri_parser parser(get_test_model());
+	auto uri = ::odata::utility::uri(::odata::utility::uri::encode_uri(U("http://service-root/Customers(1)/Orders?$filter=OrderID gt 1&$expand=OrderDetails&$top=5")));
+	// The first call builds state that is shared by later ones.
+	parser.parse_uri(uri);
+
+	CHECK_MAX_ALLOCATIONS(64)
+	{
+		parser.parse_uri(uri);
+	}
+	CHECK_MAX_ALLOCATED_BYTES(5 * 1024)
+	{
+		parser.parse_uri(uri);
+	}
+}
+
+TEST(uri_budget)
+{
+	::odata::utility::string_t text = U("http://service-root/Customers(1)/Orders?$top=5");
+	CHECK_MAX_ALLOCATIONS(1)
+	{
+		::odata::utility::uri uri(text);
+	}
+
+	::odata::utility::uri service_root(U("http://service-root/"));
+	::odata::utility::uri_builder builder(service_root);
+	builder.append_path(U("Customers(1)")).append_path(U("Orders"));
+	builder.clear();
+	CHECK_MAX_ALLOCATIONS(0)
+	{
+		builder.append_path(U("Customers(1)")).append_path(U("Orders")).append_query(U("$top=5"));
+	}
+	CHECK_MAX_ALLOCATIONS(1)
+	{
+		builder.to_uri();
+	}
+}
+
+TEST(serialize_entity_budget)
+{
+	odata_json_writer writer(get_test_model());
+	auto account = make_account();
+	writer.serialize(account);
+
+	CHECK_MAX_ALLOCATIONS(36)
+	{
+		writer.serialize(account);
+	}
+	CHECK_MAX_ALLOCATED_BYTES(1600)
+	{
+		writer.serialize(account);
+	}
+}
+
+TEST(read_entity_value_budget)
+{
+	auto model = get_test_model();
+	odata_json_reader_minimal reader(model, g_service_root_url);
+	auto payload = ::odata::utility::json::value::parse(U("{\"@odata.context\":\"") + g_service_root_url + U("$metadata#Accounts/$entity\",\"AccountID\":100,\"AccountInfo\":{\"FirstName\":\"Leo\",\"LastName\":\"Hu\"},\"Country\":\"China\"}"));
+	auto account_type = model->find_entity_type(U("Account"));
+	reader.deserilize_entity_value(payload, account_type);
+
+	CHECK_MAX_ALLOCATIONS(84)
+	{
+		reader.deserilize_entity_value(payload, account_type);
+	}
+	CHECK_MAX_ALLOCATED_BYTES(9 * 1024)
+	{
+		reader.deserilize_entity_value(payload, account_type);
+	}
+}
+
+}
+
+}}}
@@ -0,0 +1,212 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_apply_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/core/odata_apply_executor.h"
+#include "odata/core/odata_uri_parser.h"
+#include "odata/core/odata_json_writer.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::shared_ptr<odata_apply_clause> parse_apply(const ::odata::utility::string_t& apply)
+{
+	odata_uri_parser parser(get_test_model());
+	auto uri = ::odata::utility::uri::encode_uri(U("http://service-root/Orders?$apply=") + apply);
+	return parser.parse_uri(uri)->apply_clause();
+}
+
+static std::shared_ptr<odata_entity_value> make_detail(int32_t order_id, int32_t product_id, int32_t quantity)
+{
+	auto entity = std::make_shared<odata_entity_value>(get_test_model()->find_entity_type(U("OrderDetail")));
+	entity->set_value(U("OrderID"), order_id);
+	entity->set_value(U("ProductID"), product_id);
+	entity->set_value(U("Quantity"), quantity);
+	return entity;
+}
+
+static std::vector<std::shared_ptr<odata_entity_value>> make_details()
+{
+	std::vector<std::shared_ptr<odata_entity_value>> details;
+	details.push_back(make_detail(1, 10, 2));
+	details.push_back(make_detail(1, 20, 5));
+	details.push_back(make_detail(2, 10, 3));
+	details.push_back(make_detail(3, 30, 1));
+	details.push_back(make_detail(3, 10, 2));
+	return details;
+}
+
+static ::odata::utility::string_t value_of(std::shared_ptr<odata_entity_value> entity, const ::odata::utility::string_t& name)
+{
+	std::shared_ptr<odata_value> value;
+	if (!entity->get_property_value(name, value) || !value)
+	{
+		return U("null");
+	}
+	return std::dynamic_pointer_cast<odata_primitive_value>(value)->to_string();
+}
+
+SUITE(odata_apply_tests)
+{
+
+TEST(parse_transformation_sequence)
+{
+	auto apply_clause = parse_apply(U("filter(Quantity gt 1)/groupby((ProductID,AssociatedOrder/OrderID),aggregate(Quantity with sum as Total,$count as Count))"));
+	VERIFY_IS_NOT_NULL(apply_clause);
+	VERIFY_ARE_EQUAL(apply_clause->transformations().size(), 2);
+	VERIFY_ARE_EQUAL(apply_clause->transformation_at(0)->transformation_kind(), odata_apply_transformation_kind::Filter);
+	VERIFY_IS_NOT_NULL(apply_clause->transformation_at(0)->as<odata_filter_transformation>()->expression());
+
+	auto group_by = apply_clause->transformation_at(1)->as<odata_groupby_transformation>();
+	VERIFY_ARE_EQUAL(group_by->transformation_kind(), odata_apply_transformation_kind::GroupBy);
+	VERIFY_ARE_EQUAL(group_by->group_properties().size(), 2);
+	auto path = group_by->group_properties()[1]->as<odata_property_access_node>();
+	VERIFY_ARE_EQUAL(path->property_name(), U("OrderID"));
+	VERIFY_ARE_EQUAL(path->parent()->as<odata_property_access_node>()->property_name(), U("AssociatedOrder"));
+
+	VERIFY_ARE_EQUAL(group_by->transformations().size(), 1);
+	auto aggregate = group_by->transformations()[0]->as<odata_aggregate_transformation>();
+	VERIFY_ARE_EQUAL(aggregate->expressions().size(), 2);
+	VERIFY_ARE_EQUAL(aggregate->expressions()[0]->method(), odata_aggregate_method::Sum);
+	VERIFY_ARE_EQUAL(aggregate->expressions()[0]->alias(), U("Total"));
+	VERIFY_ARE_EQUAL(aggregate->expressions()[1]->method(), odata_aggregate_method::Count);
+	VERIFY_IS_NULL(aggregate->expressions()[1]->expression());
+	VERIFY_ARE_EQUAL(aggregate->expressions()[1]->alias(), U("Count"));
+}
+
+TEST(parse_compute_and_topcount)
+{
+	auto apply_clause = parse_apply(U("compute(Quantity mul 2 as Doubled)/bottomcount(3,Doubled)"));
+	VERIFY_ARE_EQUAL(apply_clause->transformations().size(), 2);
+
+	auto compute = apply_clause->transformation_at(0)->as<odata_compute_transformation>();
+	VERIFY_ARE_EQUAL(compute->expressions().size(), 1);
+	VERIFY_ARE_EQUAL(compute->expressions()[0]->alias(), U("Doubled"));
+	VERIFY_ARE_EQUAL(compute->expressions()[0]->expression()->node_kind(), odata_query_node_kind::BinaryOperator);
+
+	auto bottom = apply_clause->transformation_at(1)->as<odata_topcount_transformation>();
+	VERIFY_IS_FALSE(bottom->is_top());
+	VERIFY_ARE_EQUAL(bottom->count(), 3);
+
+	VERIFY_IS_NULL(parse_apply(U("")));
+}
+
+TEST(parse_invalid_apply_throws)
+{
+	VERIFY_THROWS(parse_apply(U("aggregate(Quantity with median as M)")), odata_exception);
+	VERIFY_THROWS(parse_apply(U("aggregate(Quantity as M)")), odata_exception);
+	VERIFY_THROWS(parse_apply(U("pivot(Quantity)")), odata_exception);
+	VERIFY_THROWS(parse_apply(U("topcount(Quantity,2)")), odata_exception);
+}
+
+TEST(groupby_aggregates_in_one_pass)
+{
+	odata_apply_executor executor;
+	auto results = executor.execute(
+		parse_apply(U("groupby((ProductID),aggregate(Quantity with sum as Total,Quantity with average as Mean,Quantity with min as Low,Quantity with max as High,OrderID with countdistinct as Orders,$count as Count))")),
+		make_details());
+
+	// Groups come out in the order they were first seen.
+	VERIFY_ARE_EQUAL(results.size(), 3);
+	VERIFY_ARE_EQUAL(value_of(results[0], U("ProductID")), U("10"));
+	VERIFY_ARE_EQUAL(value_of(results[0], U("Total")), U("7"));
+	VERIFY_ARE_EQUAL(value_of(results[0], U("Low")), U("2"));
+	VERIFY_ARE_EQUAL(value_of(results[0], U("High")), U("3"));
+	VERIFY_ARE_EQUAL(value_of(results[0], U("Orders")), U("3"));
+	VERIFY_ARE_EQUAL(value_of(results[0], U("Count")), U("3"));
+	double mean = 0;
+	VERIFY_IS_TRUE(results[0]->try_get(U("Mean"), mean));
+	VERIFY_IS_TRUE(mean > 2.33 && mean < 2.34);
+
+	VERIFY_ARE_EQUAL(value_of(results[1], U("ProductID")), U("20"));
+	VERIFY_ARE_EQUAL(value_of(results[1], U("Total")), U("5"));
+	VERIFY_ARE_EQUAL(value_of(results[2], U("ProductID")), U("30"));
+	VERIFY_ARE_EQUAL(value_of(results[2], U("Count")), U("1"));
+
+	// Only the grouping properties and the aliases are projected.
+	VERIFY_IS_FALSE(results[0]->has_property(U("Quantity")));
+}
+
+TEST(nested_transformations_and_empty_input)
+{
+	odata_apply_executor executor;
+	auto results = executor.execute(
+		parse_apply(U("filter(Quantity ge 3)/groupby((OrderID),filter(ProductID ne 20)/aggregate($count as Count))")),
+		make_details());
+
+	// The nested filter runs per group, a group it empties still aggregates to one row.
+	VERIFY_ARE_EQUAL(results.size(), 2);
+	VERIFY_ARE_EQUAL(value_of(results[0], U("OrderID")), U("1"));
+	VERIFY_ARE_EQUAL(value_of(results[0], U("Count")), U("0"));
+	VERIFY_ARE_EQUAL(value_of(results[1], U("OrderID")), U("2"));
+	VERIFY_ARE_EQUAL(value_of(results[1], U("Count")), U("1"));
+
+	results = executor.execute(parse_apply(U("aggregate($count as Count,Quantity with sum as Total,Quantity with max as High)")), std::vector<std::shared_ptr<odata_entity_value>>());
+	VERIFY_ARE_EQUAL(results.size(), 1);
+	VERIFY_ARE_EQUAL(value_of(results[0], U("Count")), U("0"));
+	VERIFY_ARE_EQUAL(value_of(results[0], U("Total")), U("0"));
+	VERIFY_ARE_EQUAL(value_of(results[0], U("High")), U("null"));
+}
+
+TEST(groupby_keeping_rows_leaves_input_unchanged)
+{
+	auto details = make_details();
+	std::vector<std::shared_ptr<odata_value>> product_ids;
+	for (auto detail = details.cbegin(); detail != details.cend(); ++detail)
+	{
+		std::shared_ptr<odata_value> value;
+		(*detail)->get_property_value(U("ProductID"), value);
+		product_ids.push_back(value);
+	}
+
+	odata_apply_executor executor;
+	auto results = executor.execute(parse_apply(U("groupby((ProductID),filter(Quantity gt 1))")), details);
+	VERIFY_ARE_EQUAL(results.size(), 4);
+	VERIFY_ARE_EQUAL(value_of(results[0], U("ProductID")), U("10"));
+	VERIFY_ARE_EQUAL(value_of(results[3], U("ProductID")), U("20"));
+
+	// The path grouping resolves to null on these rows, the rows must keep their own OrderID.
+	results = executor.execute(parse_apply(U("groupby((AssociatedOrder/OrderID),topcount(2,Quantity))")), details);
+	VERIFY_ARE_EQUAL(results.size(), 2);
+	VERIFY_ARE_EQUAL(value_of(results[0], U("OrderID")), U("null"));
+
+	for (size_t i = 0; i < details.size(); i++)
+	{
+		VERIFY_ARE_EQUAL(details[i]->properties().size(), 3);
+		std::shared_ptr<odata_value> value;
+		VERIFY_IS_TRUE(details[i]->get_property_value(U("ProductID"), value));
+		VERIFY_IS_TRUE(value == product_ids[i]);
+		VERIFY_ARE_NOT_EQUAL(value_of(details[i], U("OrderID")), U("null"));
+		for (auto result = results.cbegin(); result != results.cend(); ++result)
+		{
+			VERIFY_IS_TRUE(*result != details[i]);
+		}
+	}
+}
+
+TEST(compute_topcount_and_serialize)
+{
+	auto details = make_details();
+	odata_apply_executor executor;
+	auto results = executor.execute(parse_apply(U("compute(Quantity mul 10 as Scaled)/topcount(2,Scaled)")), details);
+
+	VERIFY_ARE_EQUAL(results.size(), 2);
+	VERIFY_ARE_EQUAL(value_of(results[0], U("Scaled")), U("50"));
+	VERIFY_ARE_EQUAL(value_of(results[1], U("Scaled")), U("30"));
+	VERIFY_IS_FALSE(details[1]->has_property(U("Scaled")));
+
+	results = executor.execute(parse_apply(U("groupby((ProductID),aggregate(Quantity with sum as Total))")), details);
+	auto json_writer = std::make_shared<::odata::core::odata_json_writer>(get_test_model());
+	auto json = json_writer->serialize(results[0]);
+	VERIFY_ARE_EQUAL(json[U("ProductID")].as_integer(), 10);
+	VERIFY_ARE_EQUAL(json[U("Total")].as_integer(), 7);
+}
+
+}
+
+}}}
@@ -0,0 +1,187 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_async_operation_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/core/odata_async_operation.h"
+#include <future>
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+using namespace ::odata::utility;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::shared_ptr<odata_value> make_result()
+{
+	auto entity = std::make_shared<odata_entity_value>(get_test_model()->find_entity_type(U("Product")));
+	entity->set_value(U("ProductID"), (int32_t)7);
+	entity->set_value(U("Name"), U("Export"));
+	return entity;
+}
+
+static bool contains(const string_t& text, const string_t& part)
+{
+	return text.find(part) != string_t::npos;
+}
+
+SUITE(odata_async_operation_tests)
+{
+
+TEST(prefer_header_is_parsed)
+{
+	VERIFY_IS_TRUE(odata_async_operation_manager::prefers_respond_async(U("respond-async")));
+	VERIFY_IS_TRUE(odata_async_operation_manager::prefers_respond_async(U("odata.maxpagesize=10, Respond-Async; wait=10")));
+	VERIFY_IS_TRUE(odata_async_operation_manager::prefers_respond_async(U("return=minimal,respond-async")));
+	VERIFY_IS_FALSE(odata_async_operation_manager::prefers_respond_async(U("")));
+	VERIFY_IS_FALSE(odata_async_operation_manager::prefers_respond_async(U("respond-asynchronously")));
+	VERIFY_IS_FALSE(odata_async_operation_manager::prefers_respond_async(U("wait=respond-async")));
+}
+
+TEST(completed_operation_is_embedded_in_poll)
+{
+	odata_async_operation_manager manager(U("http://service-root/$async"));
+	odata_message_writer writer(get_test_model(), U("http://service-root"));
+
+	auto operation = manager.submit([](const odata_async_operation&) { return make_result(); });
+	VERIFY_IS_NOT_NULL(operation);
+
+	auto accepted = manager.accepted(operation);
+	VERIFY_ARE_EQUAL(accepted.status_code, 202);
+	VERIFY_ARE_EQUAL(accepted.headers[U("Location")], U("http://service-root/$async/") + operation->id());
+	VERIFY_ARE_EQUAL(accepted.headers[U("Preference-Applied")], U("respond-async"));
+	VERIFY_ARE_EQUAL(accepted.headers[U("Retry-After")], U("1"));
+
+	manager.wait_idle();
+	VERIFY_ARE_EQUAL(operation->status(), AsyncCompleted);
+
+	auto response = manager.poll(operation->id(), writer);
+	VERIFY_ARE_EQUAL(response.status_code, 200);
+	VERIFY_ARE_EQUAL(response.headers[U("Content-Type")], U("application/http"));
+	VERIFY_ARE_EQUAL(response.body.find(U("HTTP/1.1 200 OK\n")), 0);
+	VERIFY_IS_TRUE(contains(response.body, U("\"Name\":\"Export\"")));
+
+	// Polling again returns the same response until the monitor expires.
+	VERIFY_ARE_EQUAL(manager.poll(operation->id(), writer).body, response.body);
+	VERIFY_ARE_EQUAL(manager.poll(U("unknown"), writer).status_code, 404);
+}
+
+TEST(running_operation_polls_as_accepted)
+{
+	odata_async_operation_manager manager(U("http://service-root/$async"), 1);
+	odata_message_writer writer(get_test_model(), U("http://service-root"));
+
+	std::promise<void> release;
+	auto released = release.get_future().share();
+	auto operation = manager.submit([released](const odata_async_operation&) { released.wait(); return make_result(); });
+
+	auto response = manager.poll(operation->id(), writer);
+	VERIFY_ARE_EQUAL(response.status_code, 202);
+	VERIFY_IS_TRUE(response.body.empty());
+
+	release.set_value();
+	manager.wait_idle();
+	VERIFY_ARE_EQUAL(manager.poll(operation->id(), writer).status_code, 200);
+}
+
+TEST(queue_is_bounded)
+{
+	odata_async_operation_manager manager(U("http://service-root/$async"), 1, 1);
+
+	std::promise<void> started;
+	std::promise<void> release;
+	auto released = release.get_future().share();
+	auto first = manager.submit([&started, released](const odata_async_operation&) { started.set_value(); released.wait(); return make_result(); });
+	started.get_future().wait();
+
+	auto second = manager.submit([](const odata_async_operation&) { return make_result(); });
+	VERIFY_IS_NOT_NULL(second);
+	VERIFY_ARE_EQUAL(manager.queued_count(), 1);
+	VERIFY_IS_NULL(manager.submit([](const odata_async_operation&) { return make_result(); }));
+
+	release.set_value();
+	manager.wait_idle();
+	VERIFY_ARE_EQUAL(first->status(), AsyncCompleted);
+	VERIFY_ARE_EQUAL(second->status(), AsyncCompleted);
+	VERIFY_IS_NOT_NULL(manager.submit([](const odata_async_operation&) { return make_result(); }));
+}
+
+TEST(failed_and_empty_results_are_embedded)
+{
+	odata_async_operation_manager manager(U("http://service-root/$async"));
+	odata_message_writer writer(get_test_model(), U("http://service-root"));
+
+	auto failed = manager.submit([](const odata_async_operation&) -> std::shared_ptr<odata_value> { throw std::runtime_error("export failed"); });
+	auto empty = manager.submit([](const odata_async_operation&) { return std::shared_ptr<odata_value>(); });
+	manager.wait_idle();
+
+	VERIFY_ARE_EQUAL(failed->status(), AsyncFailed);
+	VERIFY_ARE_EQUAL(failed->error_message(), U("export failed"));
+	auto response = manager.poll(failed->id(), writer);
+	VERIFY_ARE_EQUAL(response.status_code, 200);
+	VERIFY_ARE_EQUAL(response.body.find(U("HTTP/1.1 500 Internal Server Error\n")), 0);
+	VERIFY_IS_TRUE(contains(response.body, U("export failed")));
+
+	response = manager.poll(empty->id(), writer);
+	VERIFY_ARE_EQUAL(response.body.find(U("HTTP/1.1 204 No Content\n")), 0);
+	VERIFY_IS_FALSE(contains(response.body, U("null")));
+}
+
+TEST(cancel_removes_monitor)
+{
+	odata_async_operation_manager manager(U("http://service-root/$async"), 1);
+	odata_message_writer writer(get_test_model(), U("http://service-root"));
+
+	std::promise<void> started;
+	std::promise<void> release;
+	auto released = release.get_future().share();
+	auto running = manager.submit([&started, released](const odata_async_operation& self) -> std::shared_ptr<odata_value>
+	{
+		started.set_value();
+		released.wait();
+		return self.is_cancelled() ? nullptr : make_result();
+	});
+	started.get_future().wait();
+
+	std::atomic<bool> ran(false);
+	auto queued = manager.submit([&ran](const odata_async_operation&) { ran = true; return make_result(); });
+
+	VERIFY_IS_TRUE(manager.cancel(queued->id()));
+	VERIFY_IS_TRUE(manager.cancel(running->id()));
+	VERIFY_IS_FALSE(manager.cancel(running->id()));
+	VERIFY_IS_TRUE(running->is_cancelled());
+	VERIFY_ARE_EQUAL(manager.queued_count(), 0);
+
+	release.set_value();
+	manager.wait_idle();
+	VERIFY_IS_FALSE(ran.load());
+	VERIFY_ARE_EQUAL(running->status(), AsyncCancelled);
+	VERIFY_ARE_EQUAL(manager.poll(running->id(), writer).status_code, 404);
+	VERIFY_ARE_EQUAL(manager.monitor_count(), 0);
+}
+
+TEST(finished_monitors_expire)
+{
+	odata_async_operation_manager manager(U("http://service-root/$async"), 1, 4, std::chrono::milliseconds(0));
+
+	std::promise<void> release;
+	auto released = release.get_future().share();
+	auto done = manager.submit([](const odata_async_operation&) { return make_result(); });
+	manager.wait_idle();
+	auto running = manager.submit([released](const odata_async_operation&) { released.wait(); return make_result(); });
+
+	VERIFY_IS_NULL(manager.find(done->id()));
+	VERIFY_IS_NOT_NULL(manager.find(running->id()));
+	VERIFY_ARE_EQUAL(manager.evict_expired(), 0);
+
+	release.set_value();
+	manager.wait_idle();
+	VERIFY_ARE_EQUAL(manager.evict_expired(), 1);
+	VERIFY_ARE_EQUAL(manager.monitor_count(), 0);
+}
+
+}
+
+}}}
@@ -0,0 +1,201 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_delta_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/core/odata_change_log.h"
+#include "odata/core/odata_message_writer.h"
+#include "odata/core/odata_message_reader.h"
+#include "odata/core/odata_uri_parser.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+using namespace ::odata::utility;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::shared_ptr<edm_entity_set> entity_set_of(const string_t& name)
+{
+	return get_test_model()->find_container()->find_entity_set(name);
+}
+
+static std::shared_ptr<odata_entity_value> make_product(int32_t id, const string_t& name)
+{
+	auto entity = std::make_shared<odata_entity_value>(get_test_model()->find_entity_type(U("Product")));
+	entity->set_value(U("ProductID"), id);
+	entity->set_value(U("Name"), name);
+	return entity;
+}
+
+static std::shared_ptr<odata_delta_value> make_delta()
+{
+	auto delta = std::make_shared<odata_delta_value>(entity_set_of(U("Products")));
+	delta->add_changed_entity(make_product(1, U("Milk")));
+	delta->add_deleted_entity(U("Products(2)"));
+	delta->add_deleted_entity(U("Products(3)"), DeletedReasonChanged);
+	delta->add_link(U("Products(1)"), U("Details"), U("ProductDetails(ProductID=1,ProductDetailID=1)"));
+	delta->add_deleted_link(U("Products(1)"), U("Details"), U("ProductDetails(ProductID=1,ProductDetailID=2)"));
+	delta->set_delta_link(odata_change_log::delta_link(g_service_root_url, U("Products"), U("42")));
+	return delta;
+}
+
+static int32_t product_id(const std::shared_ptr<odata_delta_entry>& entry)
+{
+	int32_t id = 0;
+	entry->entity()->try_get(U("ProductID"), id);
+	return id;
+}
+
+SUITE(odata_delta_tests)
+{
+
+TEST(writer_writes_delta_payload)
+{
+	odata_message_writer writer(get_test_model(), g_service_root_url);
+	auto json = json::value::parse(writer.write_odata_delta_value(make_delta()));
+
+	VERIFY_ARE_EQUAL(json.at(U("@odata.context")).as_string(), g_service_root_url + U("/$metadata#Products/$delta"));
+	VERIFY_ARE_EQUAL(json.at(U("@odata.deltaLink")).as_string(), g_service_root_url + U("/Products?$deltatoken=42"));
+
+	auto value = json.at(U("value"));
+	VERIFY_ARE_EQUAL(value.size(), 5);
+	VERIFY_ARE_EQUAL(value[0].at(U("Name")).as_string(), U("Milk"));
+	VERIFY_ARE_EQUAL(value[1].at(U("@odata.removed")).at(U("reason")).as_string(), U("deleted"));
+	VERIFY_ARE_EQUAL(value[1].at(U("@odata.id")).as_string(), U("Products(2)"));
+	VERIFY_ARE_EQUAL(value[2].at(U("@odata.removed")).at(U("reason")).as_string(), U("changed"));
+	VERIFY_ARE_EQUAL(value[3].at(U("@odata.context")).as_string(), U("#Products/$link"));
+	VERIFY_ARE_EQUAL(value[3].at(U("relationship")).as_string(), U("Details"));
+	VERIFY_ARE_EQUAL(value[4].at(U("@odata.context")).as_string(), U("#Products/$deletedLink"));
+	VERIFY_ARE_EQUAL(value[4].at(U("target")).as_string(), U("ProductDetails(ProductID=1,ProductDetailID=2)"));
+}
+
+TEST(reader_reads_back_written_payload)
+{
+	odata_message_writer writer(get_test_model(), g_service_root_url);
+	odata_message_reader reader(get_test_model(), g_service_root_url, writer.write_odata_delta_value(make_delta()), true);
+	auto delta = reader.read_delta_value();
+
+	VERIFY_ARE_EQUAL(delta->get_entity_set(), entity_set_of(U("Products")));
+	VERIFY_ARE_EQUAL(delta->size(), 5);
+	VERIFY_ARE_EQUAL(delta->get_entries()[0]->kind(), DeltaChangedEntity);
+	VERIFY_ARE_EQUAL(product_id(delta->get_entries()[0]), 1);
+	VERIFY_ARE_EQUAL(delta->get_entries()[1]->kind(), DeltaDeletedEntity);
+	VERIFY_ARE_EQUAL(delta->get_entries()[1]->id().to_string(), U("Products(2)"));
+	VERIFY_ARE_EQUAL(delta->get_entries()[1]->reason(), DeletedReasonDeleted);
+	VERIFY_ARE_EQUAL(delta->get_entries()[2]->reason(), DeletedReasonChanged);
+	VERIFY_ARE_EQUAL(delta->get_entries()[3]->kind(), DeltaAddedLink);
+	VERIFY_ARE_EQUAL(delta->get_entries()[3]->source().to_string(), U("Products(1)"));
+	VERIFY_ARE_EQUAL(delta->get_entries()[4]->kind(), DeltaDeletedLink);
+	VERIFY_ARE_EQUAL(delta->get_delta_link().to_string(), g_service_root_url + U("/Products?$deltatoken=42"));
+}
+
+TEST(reader_accepts_odata_40_deleted_entities)
+{
+	string_t payload = U("{\"@odata.context\":\"http://e/$metadata#Products/$delta\",\"value\":[")
+		U("{\"@odata.context\":\"#Products/$deletedEntity\",\"id\":\"Products(7)\",\"reason\":\"changed\"},")
+		U("{\"@removed\":{},\"@id\":\"Products(8)\"}]}");
+	odata_message_reader reader(get_test_model(), g_service_root_url, payload, true);
+	auto delta = reader.read_delta_value();
+
+	VERIFY_ARE_EQUAL(delta->size(), 2);
+	VERIFY_ARE_EQUAL(delta->get_entries()[0]->id().to_string(), U("Products(7)"));
+	VERIFY_ARE_EQUAL(delta->get_entries()[0]->reason(), DeletedReasonChanged);
+	VERIFY_ARE_EQUAL(delta->get_entries()[1]->id().to_string(), U("Products(8)"));
+	VERIFY_ARE_EQUAL(delta->get_entries()[1]->reason(), DeletedReasonDeleted);
+
+	odata_message_reader no_context(get_test_model(), g_service_root_url, U("{\"value\":[]}"), true);
+	VERIFY_THROWS(no_context.read_delta_value(), std::runtime_error);
+	odata_message_reader with_set(get_test_model(), g_service_root_url, U("{\"value\":[]}"), true);
+	VERIFY_ARE_EQUAL(with_set.read_delta_value(entity_set_of(U("Products")))->size(), 0);
+}
+
+TEST(change_log_returns_changes_since_token)
+{
+	odata_in_memory_change_log log;
+	auto products = entity_set_of(U("Products"));
+	auto orders = entity_set_of(U("Orders"));
+
+	log.record_changed(products, make_product(1, U("Milk")));
+	auto token = log.issue_token(products);
+
+	log.record_changed(products, make_product(2, U("Tea")));
+	log.record_changed(products, make_product(1, U("Skimmed milk")));
+	log.record_changed(products, make_product(2, U("Green tea")));
+	log.record_deleted(products, make_product(3, U("Coffee")));
+	log.record_link(products, U("Products(1)"), U("Details"), U("ProductDetails(ProductID=1,ProductDetailID=1)"));
+	log.record_deleted(orders, U("Orders(1)"));
+
+	string_t next_token;
+	auto delta = log.read_changes(products, token, next_token);
+	VERIFY_IS_NOT_NULL(delta);
+	VERIFY_ARE_EQUAL(delta->size(), 4);
+
+	// Each entity appears once, where it last changed, with its latest values.
+	VERIFY_ARE_EQUAL(product_id(delta->get_entries()[0]), 1);
+	string_t name;
+	delta->get_entries()[0]->entity()->try_get(U("Name"), name);
+	VERIFY_ARE_EQUAL(name, U("Skimmed milk"));
+	VERIFY_ARE_EQUAL(product_id(delta->get_entries()[1]), 2);
+	VERIFY_ARE_EQUAL(delta->get_entries()[2]->kind(), DeltaDeletedEntity);
+	VERIFY_ARE_EQUAL(delta->get_entries()[2]->id().to_string(), U("Products(3)"));
+	VERIFY_ARE_EQUAL(delta->get_entries()[3]->kind(), DeltaAddedLink);
+
+	VERIFY_ARE_EQUAL(next_token, log.issue_token(products));
+	VERIFY_ARE_EQUAL(log.read_changes(products, next_token, next_token)->size(), 0);
+	VERIFY_ARE_EQUAL(log.read_changes(orders, token, next_token)->size(), 1);
+}
+
+TEST(change_log_folds_add_then_delete)
+{
+	odata_in_memory_change_log log;
+	auto products = entity_set_of(U("Products"));
+	auto token = log.issue_token(products);
+
+	log.record_changed(products, make_product(5, U("Juice")));
+	log.record_link(products, U("Products(5)"), U("Details"), U("ProductDetails(ProductID=5,ProductDetailID=1)"));
+	log.record_deleted_link(products, U("Products(5)"), U("Details"), U("ProductDetails(ProductID=5,ProductDetailID=1)"));
+	log.record_deleted(products, make_product(5, U("Juice")));
+
+	string_t next_token;
+	auto delta = log.read_changes(products, token, next_token);
+	VERIFY_ARE_EQUAL(delta->size(), 2);
+	VERIFY_ARE_EQUAL(delta->get_entries()[0]->kind(), DeltaDeletedLink);
+	VERIFY_ARE_EQUAL(delta->get_entries()[1]->kind(), DeltaDeletedEntity);
+	VERIFY_ARE_EQUAL(delta->get_entries()[1]->id().to_string(), U("Products(5)"));
+}
+
+TEST(change_log_rejects_unknown_and_expired_tokens)
+{
+	odata_in_memory_change_log log(2);
+	auto products = entity_set_of(U("Products"));
+	string_t next_token;
+
+	auto token = log.issue_token(products);
+	VERIFY_IS_NULL(log.read_changes(products, U(""), next_token));
+	VERIFY_IS_NULL(log.read_changes(products, U("abc"), next_token));
+	VERIFY_IS_NULL(log.read_changes(products, U("1"), next_token));
+
+	log.record_changed(products, make_product(1, U("Milk")));
+	auto after_first = log.issue_token(products);
+	log.record_changed(products, make_product(2, U("Tea")));
+	VERIFY_IS_NOT_NULL(log.read_changes(products, token, next_token));
+
+	log.record_changed(products, make_product(3, U("Coffee")));
+	VERIFY_ARE_EQUAL(log.size(), 2);
+	VERIFY_IS_NULL(log.read_changes(products, token, next_token));
+	VERIFY_ARE_EQUAL(log.read_changes(products, after_first, next_token)->size(), 2);
+}
+
+TEST(uri_parser_reads_delta_token)
+{
+	odata_uri_parser parser(get_test_model());
+	auto uri = parser.parse_uri(U("http://service-root/Products?$deltatoken=12%2034"));
+	VERIFY_ARE_EQUAL(uri->delta_token(), U("12 34"));
+	VERIFY_IS_TRUE(parser.parse_uri(U("http://service-root/Products"))->delta_token().empty());
+}
+
+}
+
+}}}
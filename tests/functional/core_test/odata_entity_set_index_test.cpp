@@ -0,0 +1,281 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_entity_set_index_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/core/odata_entity_set_index.h"
+#include "odata/core/odata_uri_parser.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::shared_ptr<odata_entity_value> make_ticket(int32_t id, const ::odata::utility::string_t& status, const ::odata::utility::string_t& region, int32_t priority)
+{
+	auto entity = std::make_shared<odata_entity_value>(get_test_model()->find_entity_type(U("Product")));
+	entity->set_value(U("ID"), id);
+	entity->set_value(U("Status"), status);
+	entity->set_value(U("Region"), region);
+	entity->set_value(U("Priority"), priority);
+	return entity;
+}
+
+static std::shared_ptr<odata_indexed_entity_set> make_tickets()
+{
+	auto tickets = std::make_shared<odata_indexed_entity_set>();
+	tickets->insert(make_ticket(1, U("Open"), U("EU"), 3));
+	tickets->insert(make_ticket(2, U("Closed"), U("EU"), 1));
+	tickets->insert(make_ticket(3, U("Open"), U("US"), 5));
+	tickets->insert(make_ticket(4, U("Open"), U("EU"), 2));
+	tickets->insert(make_ticket(5, U("Pending"), U("APAC"), 4));
+	return tickets;
+}
+
+static std::vector<int32_t> ids_of(const std::vector<std::shared_ptr<odata_entity_value>>& entities)
+{
+	std::vector<int32_t> ids;
+	for (auto iter = entities.cbegin(); iter != entities.cend(); ++iter)
+	{
+		int32_t id = 0;
+		(*iter)->try_get(U("ID"), id);
+		ids.push_back(id);
+	}
+	return ids;
+}
+
+static std::shared_ptr<odata_primitive_value> typed(const std::shared_ptr<edm_primitive_type>& type, const ::odata::utility::string_t& text)
+{
+	return std::make_shared<odata_primitive_value>(type, text);
+}
+
+static std::shared_ptr<odata_query_node> parse(const ::odata::utility::string_t& filter)
+{
+	return odata_expression_parser::parse_expression(filter);
+}
+
+SUITE(odata_entity_set_index_tests)
+{
+
+TEST(filter_evaluator_basic)
+{
+	auto ticket = make_ticket(1, U("Open"), U("EU"), 3);
+	auto evaluator = std::make_shared<odata_filter_evaluator>();
+
+	VERIFY_IS_TRUE(evaluator->evaluate(parse(U("Status eq 'Open' and Priority ge 3")), ticket));
+	VERIFY_IS_FALSE(evaluator->evaluate(parse(U("Status eq 'Open' and Priority gt 3")), ticket));
+	VERIFY_IS_TRUE(evaluator->evaluate(parse(U("Priority add 1 eq 4")), ticket));
+	VERIFY_IS_TRUE(evaluator->evaluate(parse(U("startswith(Region, 'E') and not contains(Status, 'x')")), ticket));
+	VERIFY_IS_TRUE(evaluator->evaluate(parse(U("Missing eq null")), ticket));
+	VERIFY_IS_FALSE(evaluator->evaluate(parse(U("Missing gt 1")), ticket));
+}
+
+TEST(full_scan_without_index)
+{
+	auto tickets = make_tickets();
+	auto expression = parse(U("Status eq 'Open' and Region eq 'EU'"));
+
+	auto plan = tickets->plan(expression);
+	VERIFY_ARE_EQUAL(plan->plan_kind(), odata_index_plan_kind::FullScan);
+	VERIFY_ARE_EQUAL(plan->residual(), expression);
+
+	auto ids = ids_of(tickets->filter(expression));
+	VERIFY_ARE_EQUAL(ids.size(), 2);
+	VERIFY_ARE_EQUAL(ids[0], 1);
+	VERIFY_ARE_EQUAL(ids[1], 4);
+}
+
+TEST(hash_index_equality_with_residual)
+{
+	auto tickets = make_tickets();
+	tickets->create_index(U("Status"), odata_index_kind::Hash);
+
+	auto expression = parse(U("Status eq 'Open' and Region eq 'EU'"));
+	auto plan = tickets->plan(expression);
+	VERIFY_ARE_EQUAL(plan->plan_kind(), odata_index_plan_kind::Equal);
+	VERIFY_ARE_EQUAL(plan->index()->property_name(), U("Status"));
+	VERIFY_IS_NOT_NULL(plan->residual());
+	VERIFY_ARE_EQUAL(plan->residual()->node_kind(), odata_query_node_kind::BinaryOperator);
+
+	auto ids = ids_of(tickets->filter(expression));
+	VERIFY_ARE_EQUAL(ids.size(), 2);
+	VERIFY_ARE_EQUAL(ids[0], 1);
+	VERIFY_ARE_EQUAL(ids[1], 4);
+}
+
+TEST(constant_on_left_side)
+{
+	auto tickets = make_tickets();
+	tickets->create_index(U("Priority"), odata_index_kind::Ordered);
+
+	auto plan = tickets->plan(parse(U("3 lt Priority")));
+	VERIFY_ARE_EQUAL(plan->plan_kind(), odata_index_plan_kind::Range);
+	VERIFY_IS_NOT_NULL(plan->lower());
+	VERIFY_IS_FALSE(plan->lower_inclusive());
+	VERIFY_IS_NULL(plan->upper());
+
+	auto ids = ids_of(tickets->filter(parse(U("3 lt Priority"))));
+	VERIFY_ARE_EQUAL(ids.size(), 2);
+	VERIFY_ARE_EQUAL(ids[0], 3);
+	VERIFY_ARE_EQUAL(ids[1], 5);
+}
+
+TEST(ordered_index_range_merges_bounds)
+{
+	auto tickets = make_tickets();
+	tickets->create_index(U("Priority"), odata_index_kind::Ordered);
+
+	auto expression = parse(U("Priority ge 2 and Region ne 'US' and Priority lt 4 and Priority gt 1"));
+	auto plan = tickets->plan(expression);
+	VERIFY_ARE_EQUAL(plan->plan_kind(), odata_index_plan_kind::Range);
+	VERIFY_ARE_EQUAL(plan->lower()->to_string(), U("2"));
+	VERIFY_IS_TRUE(plan->lower_inclusive());
+	VERIFY_ARE_EQUAL(plan->upper()->to_string(), U("4"));
+	VERIFY_IS_FALSE(plan->upper_inclusive());
+	VERIFY_ARE_EQUAL(plan->residual()->node_kind(), odata_query_node_kind::BinaryOperator);
+	VERIFY_ARE_EQUAL(plan->residual()->as<odata_binary_operator_node>()->operator_kind(), binary_operator_kind::NotEqual);
+
+	auto ids = ids_of(tickets->filter(expression));
+	VERIFY_ARE_EQUAL(ids.size(), 2);
+	VERIFY_ARE_EQUAL(ids[0], 1);
+	VERIFY_ARE_EQUAL(ids[1], 4);
+}
+
+TEST(or_chain_uses_in_probe)
+{
+	auto tickets = make_tickets();
+	tickets->create_index(U("Region"), odata_index_kind::Hash);
+
+	auto expression = parse(U("(Region eq 'US' or Region eq 'APAC' or Region eq 'XX') and Priority gt 4"));
+	auto plan = tickets->plan(expression);
+	VERIFY_ARE_EQUAL(plan->plan_kind(), odata_index_plan_kind::In);
+	VERIFY_ARE_EQUAL(plan->values().size(), 3);
+
+	auto ids = ids_of(tickets->filter(expression));
+	VERIFY_ARE_EQUAL(ids.size(), 1);
+	VERIFY_ARE_EQUAL(ids[0], 3);
+
+	// Or-chains over different properties cannot be answered by one index.
+	plan = tickets->plan(parse(U("Region eq 'US' or Status eq 'Open'")));
+	VERIFY_ARE_EQUAL(plan->plan_kind(), odata_index_plan_kind::FullScan);
+}
+
+TEST(equality_preferred_over_range)
+{
+	auto tickets = make_tickets();
+	tickets->create_index(U("Priority"), odata_index_kind::Ordered);
+	tickets->create_index(U("Region"), odata_index_kind::Hash);
+
+	auto plan = tickets->plan(parse(U("Priority gt 1 and Region eq 'EU'")));
+	VERIFY_ARE_EQUAL(plan->plan_kind(), odata_index_plan_kind::Equal);
+	VERIFY_ARE_EQUAL(plan->index()->property_name(), U("Region"));
+}
+
+TEST(index_maintained_on_update_and_remove)
+{
+	auto tickets = make_tickets();
+	auto index = tickets->create_index(U("Status"), odata_index_kind::Hash);
+	VERIFY_ARE_EQUAL(index->size(), 5);
+
+	auto expression = parse(U("Status eq 'Open'"));
+	VERIFY_ARE_EQUAL(tickets->filter(expression).size(), 3);
+
+	// Change an indexed property in place, then notify the set.
+	auto entity = tickets->get(1);
+	entity->set_value(U("Status"), U("Open"));
+	tickets->update(1, entity);
+	VERIFY_ARE_EQUAL(tickets->filter(expression).size(), 4);
+
+	VERIFY_IS_TRUE(tickets->remove(0));
+	VERIFY_IS_FALSE(tickets->remove(0));
+	VERIFY_ARE_EQUAL(tickets->size(), 4);
+	VERIFY_ARE_EQUAL(index->size(), 4);
+
+	auto ids = ids_of(tickets->filter(expression));
+	VERIFY_ARE_EQUAL(ids.size(), 3);
+	VERIFY_ARE_EQUAL(ids[0], 2);
+
+	tickets->insert(make_ticket(6, U("Open"), U("EU"), 1));
+	VERIFY_ARE_EQUAL(tickets->filter(expression).size(), 4);
+
+	VERIFY_THROWS(tickets->update(0, entity), odata_exception);
+}
+
+TEST(numeric_keys_hash_alike)
+{
+	auto tickets = make_tickets();
+	tickets->create_index(U("Priority"), odata_index_kind::Hash);
+
+	auto ids = ids_of(tickets->filter(parse(U("Priority eq 5.0"))));
+	VERIFY_ARE_EQUAL(ids.size(), 1);
+	VERIFY_ARE_EQUAL(ids[0], 3);
+}
+
+TEST(int64_keys_above_2_pow_53_hash_exactly)
+{
+	auto tickets = std::make_shared<odata_indexed_entity_set>();
+	auto first = make_ticket(1, U("Open"), U("EU"), 3);
+	first->set_value(U("Serial"), (int64_t)9007199254740992LL);
+	tickets->insert(first);
+	auto second = make_ticket(2, U("Open"), U("EU"), 3);
+	second->set_value(U("Serial"), (int64_t)9007199254740993LL);
+	tickets->insert(second);
+	tickets->create_index(U("Serial"), odata_index_kind::Hash);
+
+	auto ids = ids_of(tickets->filter(parse(U("Serial eq 9007199254740993"))));
+	VERIFY_ARE_EQUAL(ids.size(), 1);
+	VERIFY_ARE_EQUAL(ids[0], 2);
+
+	ids = ids_of(tickets->filter(parse(U("Serial eq 9007199254740992"))));
+	VERIFY_ARE_EQUAL(ids.size(), 1);
+	VERIFY_ARE_EQUAL(ids[0], 1);
+}
+
+TEST(floating_keys_outside_int64_range_hash_safely)
+{
+	VERIFY_ARE_EQUAL(odata_entity_set_index::hash_key(odata_primitive_value::make_primitive_value(1e300)), odata_entity_set_index::hash_key(odata_primitive_value::make_primitive_value(1e300)));
+	VERIFY_ARE_NOT_EQUAL(odata_entity_set_index::hash_key(odata_primitive_value::make_primitive_value(1e300)), odata_entity_set_index::hash_key(odata_primitive_value::make_primitive_value(-1e300)));
+	VERIFY_ARE_NOT_EQUAL(odata_entity_set_index::hash_key(odata_primitive_value::make_primitive_value(std::numeric_limits<double>::quiet_NaN())), odata_entity_set_index::hash_key(odata_primitive_value::make_primitive_value(0.0)));
+	VERIFY_ARE_NOT_EQUAL(odata_entity_set_index::hash_key(odata_primitive_value::make_primitive_value(std::numeric_limits<double>::infinity())), odata_entity_set_index::hash_key(odata_primitive_value::make_primitive_value(0.0)));
+	VERIFY_ARE_EQUAL(odata_entity_set_index::hash_key(odata_primitive_value::make_primitive_value(2.0)), odata_entity_set_index::hash_key(odata_primitive_value::make_primitive_value((int64_t)2)));
+}
+
+TEST(date_time_offset_values_compare_as_instants)
+{
+	auto dto = edm_primitive_type::DATETIMEOFFSET();
+	VERIFY_ARE_EQUAL(odata_filter_evaluator::compare(typed(dto, U("2020-01-01T10:00:00+02:00")), typed(dto, U("2020-01-01T08:00:00Z"))), 0);
+	VERIFY_ARE_EQUAL(odata_filter_evaluator::compare(typed(dto, U("2020-01-01T08:00:00.5Z")), typed(dto, U("2020-01-01T08:00:00.50Z"))), 0);
+	VERIFY_ARE_EQUAL(odata_filter_evaluator::compare(typed(dto, U("2020-01-01T08:00Z")), typed(dto, U("2020-01-01T08:00:00Z"))), 0);
+	VERIFY_IS_TRUE(odata_filter_evaluator::compare(typed(dto, U("2020-01-01T09:00:00+02:00")), typed(dto, U("2020-01-01T08:00:00Z"))) < 0);
+	VERIFY_IS_TRUE(odata_filter_evaluator::compare(typed(dto, U("2020-01-01T08:00:00.09Z")), typed(dto, U("2020-01-01T08:00:00.1Z"))) < 0);
+	VERIFY_IS_TRUE(odata_filter_evaluator::compare(typed(dto, U("1999-12-31T23:59:59Z")), typed(dto, U("2000-01-01T00:00:00Z"))) < 0);
+	VERIFY_IS_TRUE(odata_filter_evaluator::compare(typed(dto, U("2020-01-02T00:00:00Z")), typed(dto, U("2020-01-01T23:00:00-02:00"))) < 0);
+	VERIFY_ARE_EQUAL(odata_entity_set_index::hash_key(typed(dto, U("2020-01-01T10:00:00+02:00"))), odata_entity_set_index::hash_key(typed(dto, U("2020-01-01T08:00:00.000Z"))));
+}
+
+TEST(duration_values_compare_as_time_spans)
+{
+	auto duration = edm_primitive_type::DURATION();
+	VERIFY_ARE_EQUAL(odata_filter_evaluator::compare(typed(duration, U("PT1H")), typed(duration, U("PT60M"))), 0);
+	VERIFY_ARE_EQUAL(odata_filter_evaluator::compare(typed(duration, U("P1DT0.5S")), typed(duration, U("PT24H0.50S"))), 0);
+	VERIFY_IS_TRUE(odata_filter_evaluator::compare(typed(duration, U("PT9S")), typed(duration, U("PT10S"))) < 0);
+	VERIFY_IS_TRUE(odata_filter_evaluator::compare(typed(duration, U("PT59M")), typed(duration, U("PT1H"))) < 0);
+	VERIFY_IS_TRUE(odata_filter_evaluator::compare(typed(duration, U("-PT1.5S")), typed(duration, U("-PT1.25S"))) < 0);
+	VERIFY_IS_TRUE(odata_filter_evaluator::compare(typed(duration, U("-PT1S")), typed(duration, U("PT0S"))) < 0);
+	VERIFY_ARE_EQUAL(odata_entity_set_index::hash_key(typed(duration, U("PT1H"))), odata_entity_set_index::hash_key(typed(duration, U("PT3600S"))));
+}
+
+TEST(guid_values_compare_case_insensitively)
+{
+	auto guid = edm_primitive_type::GUID();
+	VERIFY_ARE_EQUAL(odata_filter_evaluator::compare(typed(guid, U("0A1B2C3D-0000-0000-0000-00000000000F")), typed(guid, U("0a1b2c3d-0000-0000-0000-00000000000f"))), 0);
+	VERIFY_IS_TRUE(odata_filter_evaluator::compare(typed(guid, U("0A1B2C3D-0000-0000-0000-00000000000E")), typed(guid, U("0a1b2c3d-0000-0000-0000-00000000000f"))) < 0);
+	VERIFY_IS_TRUE(odata_filter_evaluator::compare(typed(guid, U("0a1b2c3d-0000-0000-0000-00000000000f")), typed(guid, U("0A1B2C3E-0000-0000-0000-000000000000"))) < 0);
+	VERIFY_ARE_EQUAL(odata_entity_set_index::hash_key(typed(guid, U("0A1B2C3D-0000-0000-0000-00000000000F"))), odata_entity_set_index::hash_key(typed(guid, U("0a1b2c3d-0000-0000-0000-00000000000f"))));
+}
+
+}
+
+}}}
@@ -0,0 +1,227 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_etag_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/core/odata_etag.h"
+#include "odata/edm/edm_model_reader.h"
+#include "odata/edm/edm_model_sax_reader.h"
+#include "odata/edm/edm_model_snapshot.h"
+#include "odata/edm/edm_model_writer.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+
+namespace tests { namespace functional { namespace _odata {
+
+// The test model with Name and UnitPrice declared as the concurrency properties of Products.
+static std::string etag_model_string()
+{
+	std::string csdl(test_model_string);
+	const std::string binding = "<NavigationPropertyBinding Path=\"Details\" Target=\"ProductDetails\"/>";
+	csdl.insert(csdl.find(binding) + binding.size(),
+		"<Annotation Term=\"Org.OData.Core.V1.OptimisticConcurrency\"><Collection>"
+		"<PropertyPath>Name</PropertyPath><PropertyPath>UnitPrice</PropertyPath>"
+		"</Collection></Annotation>");
+	return csdl;
+}
+
+static std::shared_ptr<edm_model> get_etag_model()
+{
+	static std::shared_ptr<edm_model> model;
+	if (!model)
+	{
+		std::istringstream stream(etag_model_string());
+		edm_model_reader reader(stream);
+		reader.parse();
+		model = reader.get_model();
+	}
+
+	return model;
+}
+
+static std::shared_ptr<edm_entity_set> products_of(std::shared_ptr<edm_model> model)
+{
+	return model->find_container()->find_entity_set(U("Products"));
+}
+
+static std::shared_ptr<odata_entity_value> make_product(int32_t id, const ::odata::utility::string_t& name, float unit_price)
+{
+	auto entity = std::make_shared<odata_entity_value>(get_etag_model()->find_entity_type(U("Product")));
+	entity->set_value(U("ProductID"), id);
+	entity->set_value(U("Name"), name);
+	entity->set_value(U("UnitPrice"), unit_price);
+	entity->set_value(U("QuantityPerUnit"), U("Each"));
+	return entity;
+}
+
+SUITE(odata_etag_tests)
+{
+
+TEST(concurrency_properties_are_read_from_csdl)
+{
+	std::vector<::odata::utility::string_t> expected;
+	expected.push_back(U("Name"));
+	expected.push_back(U("UnitPrice"));
+
+	VERIFY_IS_TRUE(products_of(get_etag_model())->get_concurrency_properties() == expected);
+
+	std::istringstream stream(etag_model_string());
+	VERIFY_IS_TRUE(products_of(edm_model_sax_reader::parse(stream, 4096, edm_type_resolution_t::Parallel))->get_concurrency_properties() == expected);
+
+	VERIFY_IS_TRUE(get_etag_model()->find_container()->find_entity_set(U("Orders"))->get_concurrency_properties().empty());
+	VERIFY_IS_TRUE(products_of(get_test_model())->get_concurrency_properties().empty());
+}
+
+TEST(concurrency_properties_survive_snapshot_and_writer)
+{
+	std::ostringstream stream;
+	edm_model_snapshot_writer(stream).write_model(get_etag_model());
+	auto snapshot = stream.str();
+	auto loaded = edm_model_snapshot_reader(snapshot.data(), snapshot.size()).read_model();
+	VERIFY_ARE_EQUAL(products_of(loaded)->get_concurrency_properties().size(), 2);
+	VERIFY_ARE_EQUAL(products_of(loaded)->get_concurrency_properties()[1], U("UnitPrice"));
+
+	std::ostringstream csdl;
+	edm_model_writer writer(csdl);
+	writer.write_model(get_etag_model());
+	std::istringstream written(csdl.str());
+	edm_model_reader reader(written);
+	reader.parse();
+	VERIFY_IS_TRUE(products_of(reader.get_model())->get_concurrency_properties() == products_of(get_etag_model())->get_concurrency_properties());
+}
+
+TEST(concurrency_etag_lists_property_values)
+{
+	auto products = products_of(get_etag_model());
+	odata_etag_generator generator;
+
+	VERIFY_ARE_EQUAL(generator.generate(make_product(1, U("Milk"), 2.5f), products), U("W/\"'Milk',2.5\""));
+	VERIFY_ARE_EQUAL(generator.generate(make_product(1, U("Bob's \"tea\""), 1.0f), products), U("W/\"'Bob''s%20%22tea%22',1.0\""));
+
+	// The other properties do not take part.
+	auto product = make_product(1, U("Milk"), 2.5f);
+	product->set_value(U("QuantityPerUnit"), U("Crate"));
+	VERIFY_ARE_EQUAL(generator.generate(product, products), U("W/\"'Milk',2.5\""));
+
+	auto missing = std::make_shared<odata_entity_value>(get_etag_model()->find_entity_type(U("Product")));
+	VERIFY_ARE_EQUAL(generator.generate(missing, products), U("W/\"null,null\""));
+}
+
+TEST(content_hash_etag_depends_on_values_only)
+{
+	odata_etag_generator generator(EtagFromContentHash);
+	auto products = products_of(get_etag_model());
+
+	auto etag = generator.generate(make_product(1, U("Milk"), 2.5f), products);
+	VERIFY_ARE_EQUAL(etag.size(), 20);
+	VERIFY_ARE_EQUAL(etag.substr(0, 3), U("W/\""));
+	VERIFY_ARE_EQUAL(etag, generator.generate(make_product(1, U("Milk"), 2.5f), products));
+	VERIFY_ARE_NOT_EQUAL(etag, generator.generate(make_product(2, U("Milk"), 2.5f), products));
+	VERIFY_ARE_NOT_EQUAL(etag, generator.generate(make_product(1, U("Milk"), 2.75f), products));
+
+	// The order in which the properties were set does not matter.
+	auto reordered = std::make_shared<odata_entity_value>(get_etag_model()->find_entity_type(U("Product")));
+	reordered->set_value(U("QuantityPerUnit"), U("Each"));
+	reordered->set_value(U("UnitPrice"), 2.5f);
+	reordered->set_value(U("Name"), U("Milk"));
+	reordered->set_value(U("ProductID"), (int32_t)1);
+	VERIFY_ARE_EQUAL(etag, generator.generate(reordered, products));
+
+	// Without concurrency properties the default source falls back to the hash, the concurrency source gives none.
+	auto orders = get_etag_model()->find_container()->find_entity_set(U("Orders"));
+	VERIFY_ARE_EQUAL(odata_etag_generator().generate(make_product(1, U("Milk"), 2.5f), orders), etag);
+	VERIFY_IS_TRUE(odata_etag_generator(EtagFromConcurrencyProperties).generate(make_product(1, U("Milk"), 2.5f), orders).empty());
+}
+
+TEST(collection_etag_follows_members)
+{
+	odata_etag_generator generator;
+	auto products = products_of(get_etag_model());
+	auto type = std::make_shared<edm_collection_type>(get_etag_model()->find_entity_type(U("Product")));
+
+	auto first = std::make_shared<odata_collection_value>(type);
+	first->add_collection_value(make_product(1, U("Milk"), 2.5f));
+	first->add_collection_value(make_product(2, U("Tea"), 4.0f));
+
+	auto same = std::make_shared<odata_collection_value>(type);
+	same->add_collection_value(make_product(1, U("Milk"), 2.5f));
+	same->add_collection_value(make_product(2, U("Tea"), 4.0f));
+
+	auto changed = std::make_shared<odata_collection_value>(type);
+	changed->add_collection_value(make_product(1, U("Milk"), 2.5f));
+	changed->add_collection_value(make_product(2, U("Tea"), 4.5f));
+
+	auto etag = generator.generate(first, products);
+	VERIFY_IS_FALSE(etag.empty());
+	VERIFY_ARE_EQUAL(etag, generator.generate(same, products));
+	VERIFY_ARE_NOT_EQUAL(etag, generator.generate(changed, products));
+
+	auto orders = get_etag_model()->find_container()->find_entity_set(U("Orders"));
+	VERIFY_IS_TRUE(odata_etag_generator(EtagFromConcurrencyProperties).generate(first, orders).empty());
+
+	VERIFY_ARE_EQUAL(generator.evaluate(U(""), etag, same, products, true), PreconditionNotModified);
+	VERIFY_ARE_EQUAL(generator.evaluate(U(""), etag, changed, products, true), PreconditionProceed);
+}
+
+TEST(if_none_match_uses_weak_comparison)
+{
+	auto etag = U("W/\"'Milk',2.5\"");
+	VERIFY_IS_TRUE(odata_preconditions::if_none_match(U(""), etag));
+	VERIFY_IS_FALSE(odata_preconditions::if_none_match(etag, etag));
+	VERIFY_IS_FALSE(odata_preconditions::if_none_match(U("\"'Milk',2.5\""), etag));
+	VERIFY_IS_FALSE(odata_preconditions::if_none_match(U("W/\"other\" , W/\"'Milk',2.5\""), etag));
+	VERIFY_IS_TRUE(odata_preconditions::if_none_match(U("W/\"other\", \"x\""), etag));
+	VERIFY_IS_FALSE(odata_preconditions::if_none_match(U("*"), etag));
+	VERIFY_IS_TRUE(odata_preconditions::if_none_match(U("*"), U(""), false));
+	VERIFY_IS_TRUE(odata_preconditions::if_none_match(U("garbage, W/\"other\""), etag));
+}
+
+TEST(if_match_requires_identical_tags)
+{
+	auto etag = U("W/\"'Milk',2.5\"");
+	VERIFY_IS_TRUE(odata_preconditions::if_match(U(""), etag));
+	VERIFY_IS_TRUE(odata_preconditions::if_match(etag, etag));
+	VERIFY_IS_FALSE(odata_preconditions::if_match(U("\"'Milk',2.5\""), etag));
+	VERIFY_IS_TRUE(odata_preconditions::if_match(U("\"a\", W/\"'Milk',2.5\""), etag));
+	VERIFY_IS_TRUE(odata_preconditions::if_match(U("*"), etag));
+	VERIFY_IS_FALSE(odata_preconditions::if_match(U("*"), U(""), false));
+	VERIFY_IS_FALSE(odata_preconditions::if_match(etag, U("")));
+}
+
+TEST(evaluate_orders_the_preconditions)
+{
+	auto etag = U("W/\"1\"");
+	VERIFY_ARE_EQUAL(odata_preconditions::evaluate(U(""), U(""), etag, true), PreconditionProceed);
+	VERIFY_ARE_EQUAL(odata_preconditions::evaluate(U(""), etag, etag, true), PreconditionNotModified);
+	VERIFY_ARE_EQUAL(odata_preconditions::evaluate(U(""), etag, etag, false), PreconditionFailed);
+	VERIFY_ARE_EQUAL(odata_preconditions::evaluate(U(""), U("W/\"2\""), etag, true), PreconditionProceed);
+	VERIFY_ARE_EQUAL(odata_preconditions::evaluate(U("W/\"2\""), etag, etag, true), PreconditionFailed);
+	VERIFY_ARE_EQUAL(odata_preconditions::evaluate(etag, U(""), etag, false), PreconditionProceed);
+
+	// Creating a resource only when it does not exist yet.
+	VERIFY_ARE_EQUAL(odata_preconditions::evaluate(U(""), U("*"), U(""), false, false), PreconditionProceed);
+	VERIFY_ARE_EQUAL(odata_preconditions::evaluate(U(""), U("*"), etag, false, true), PreconditionFailed);
+}
+
+TEST(evaluate_against_entity)
+{
+	odata_etag_generator generator;
+	auto products = products_of(get_etag_model());
+	auto product = make_product(1, U("Milk"), 2.5f);
+
+	VERIFY_ARE_EQUAL(generator.evaluate(U(""), U("W/\"'Milk',2.5\""), product, products, true), PreconditionNotModified);
+	VERIFY_ARE_EQUAL(generator.evaluate(U("W/\"'Milk',2\""), U(""), product, products, false), PreconditionFailed);
+	VERIFY_ARE_EQUAL(generator.evaluate(U("*"), U(""), std::shared_ptr<odata_entity_value>(), products, false), PreconditionFailed);
+
+	// An ETag set by the service wins over the computed one.
+	product->set_etag(U("W/\"v7\""));
+	VERIFY_ARE_EQUAL(generator.evaluate(U(""), U("W/\"v7\""), product, products, true), PreconditionNotModified);
+	VERIFY_ARE_EQUAL(generator.evaluate(U(""), U("W/\"'Milk',2.5\""), product, products, true), PreconditionProceed);
+}
+
+}
+
+}}}
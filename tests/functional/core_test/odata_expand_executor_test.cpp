@@ -0,0 +1,207 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_expand_executor_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/core/odata_expand_executor.h"
+#include "odata/core/odata_uri_parser.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+
+namespace tests { namespace functional { namespace _odata {
+
+// Serves navigation targets from an in-memory table and records every round trip.
+class in_memory_expand_data_source : public odata_expand_data_source
+{
+public:
+	void add(const ::odata::utility::string_t& navigation, std::shared_ptr<odata_entity_value> parent, std::shared_ptr<odata_entity_value> target)
+	{
+		m_targets[navigation][parent->get_entity_key_string()].push_back(target);
+	}
+
+	void load_related(
+		std::shared_ptr<edm_property_type> navigation_property,
+		const std::vector<std::shared_ptr<odata_entity_value>>& parents,
+		std::unordered_map<::odata::utility::string_t, std::vector<std::shared_ptr<odata_entity_value>>>& related)
+	{
+		calls.push_back(std::make_pair(navigation_property->get_name(), parents.size()));
+		auto &table = m_targets[navigation_property->get_name()];
+		for (auto iter = parents.cbegin(); iter != parents.cend(); ++iter)
+		{
+			auto key = (*iter)->get_entity_key_string();
+			auto found = table.find(key);
+			if (found != table.end())
+			{
+				related[key] = found->second;
+			}
+		}
+	}
+
+	std::vector<std::pair<::odata::utility::string_t, size_t>> calls;
+
+private:
+	std::unordered_map<::odata::utility::string_t, std::unordered_map<::odata::utility::string_t, std::vector<std::shared_ptr<odata_entity_value>>>> m_targets;
+};
+
+static std::shared_ptr<odata_entity_value> make_customer(int32_t id)
+{
+	auto entity = std::make_shared<odata_entity_value>(get_test_model()->find_entity_type(U("Customer")));
+	entity->set_value(U("PersonID"), id);
+	return entity;
+}
+
+static std::shared_ptr<odata_entity_value> make_order(int32_t id, double amount)
+{
+	auto entity = std::make_shared<odata_entity_value>(get_test_model()->find_entity_type(U("Order")));
+	entity->set_value(U("OrderID"), id);
+	entity->set_value(U("Amount"), amount);
+	return entity;
+}
+
+static std::shared_ptr<odata_entity_value> make_order_detail(int32_t order_id, int32_t product_id)
+{
+	auto entity = std::make_shared<odata_entity_value>(get_test_model()->find_entity_type(U("OrderDetail")));
+	entity->set_value(U("OrderID"), order_id);
+	entity->set_value(U("ProductID"), product_id);
+	return entity;
+}
+
+static std::shared_ptr<odata_select_expand_clause> parse_expand(const ::odata::utility::string_t& entity_set, const ::odata::utility::string_t& expand)
+{
+	odata_uri_parser parser(get_test_model());
+	auto uri = ::odata::utility::uri::encode_uri(U("http://service-root/") + entity_set + U("?$expand=") + expand);
+	return parser.parse_uri(uri)->select_expand_clause();
+}
+
+static std::shared_ptr<odata_collection_value> get_collection(std::shared_ptr<odata_entity_value> entity, const ::odata::utility::string_t& name)
+{
+	std::shared_ptr<odata_value> value;
+	entity->get_property_value(name, value);
+	return std::dynamic_pointer_cast<odata_collection_value>(value);
+}
+
+static int32_t id_of(std::shared_ptr<odata_value> value, const ::odata::utility::string_t& key = U("OrderID"))
+{
+	int32_t id = 0;
+	std::dynamic_pointer_cast<odata_entity_value>(value)->try_get(key, id);
+	return id;
+}
+
+SUITE(odata_expand_executor_tests)
+{
+
+TEST(one_round_trip_per_level)
+{
+	auto source = std::make_shared<in_memory_expand_data_source>();
+	std::vector<std::shared_ptr<odata_entity_value>> customers;
+	int32_t order_id = 100;
+	for (int32_t i = 1; i <= 10; i++)
+	{
+		auto customer = make_customer(i);
+		customers.push_back(customer);
+		for (int j = 0; j < 3; j++)
+		{
+			auto order = make_order(order_id, 10.0 * j);
+			source->add(U("Orders"), customer, order);
+			source->add(U("OrderDetails"), order, make_order_detail(order_id, 1));
+			source->add(U("OrderDetails"), order, make_order_detail(order_id, 2));
+			order_id++;
+		}
+	}
+
+	odata_expand_executor executor(source);
+	executor.expand(customers, parse_expand(U("Customers"), U("Orders($expand=OrderDetails)")));
+
+	VERIFY_ARE_EQUAL(executor.round_trips(), 2);
+	VERIFY_ARE_EQUAL(source->calls.size(), 2);
+	VERIFY_ARE_EQUAL(source->calls[0].first, U("Orders"));
+	VERIFY_ARE_EQUAL(source->calls[0].second, 10);
+	VERIFY_ARE_EQUAL(source->calls[1].first, U("OrderDetails"));
+	VERIFY_ARE_EQUAL(source->calls[1].second, 30);
+
+	auto orders = get_collection(customers[4], U("Orders"));
+	VERIFY_IS_NOT_NULL(orders);
+	VERIFY_ARE_EQUAL(orders->get_collection_values().size(), 3);
+	VERIFY_ARE_EQUAL(id_of(orders->get_collection_values()[0]), 112);
+
+	auto details = get_collection(std::dynamic_pointer_cast<odata_entity_value>(orders->get_collection_values()[2]), U("OrderDetails"));
+	VERIFY_IS_NOT_NULL(details);
+	VERIFY_ARE_EQUAL(details->get_collection_values().size(), 2);
+	VERIFY_ARE_EQUAL(id_of(details->get_collection_values()[1], U("ProductID")), 2);
+}
+
+TEST(nested_options_applied_per_parent)
+{
+	auto source = std::make_shared<in_memory_expand_data_source>();
+	auto first = make_customer(1);
+	auto second = make_customer(2);
+	source->add(U("Orders"), first, make_order(1, 5));
+	source->add(U("Orders"), first, make_order(2, 50));
+	source->add(U("Orders"), first, make_order(3, 30));
+	source->add(U("Orders"), first, make_order(4, 40));
+	source->add(U("Orders"), second, make_order(5, 1));
+	source->add(U("Orders"), second, make_order(6, 60));
+
+	std::vector<std::shared_ptr<odata_entity_value>> customers;
+	customers.push_back(first);
+	customers.push_back(second);
+
+	odata_expand_executor executor(source);
+	executor.expand(customers, parse_expand(U("Customers"), U("Orders($filter=Amount gt 10;$orderby=Amount desc;$top=2;$count=true)")));
+	VERIFY_ARE_EQUAL(executor.round_trips(), 1);
+
+	auto orders = get_collection(first, U("Orders"));
+	VERIFY_ARE_EQUAL(orders->get_collection_values().size(), 2);
+	VERIFY_ARE_EQUAL(id_of(orders->get_collection_values()[0]), 2);
+	VERIFY_ARE_EQUAL(id_of(orders->get_collection_values()[1]), 4);
+	VERIFY_ARE_EQUAL(orders->get_count().value(), 3);
+
+	orders = get_collection(second, U("Orders"));
+	VERIFY_ARE_EQUAL(orders->get_collection_values().size(), 1);
+	VERIFY_ARE_EQUAL(id_of(orders->get_collection_values()[0]), 6);
+	VERIFY_ARE_EQUAL(orders->get_count().value(), 1);
+}
+
+TEST(single_valued_navigation_and_duplicate_parents)
+{
+	auto source = std::make_shared<in_memory_expand_data_source>();
+	auto customer = make_customer(7);
+	auto first = make_order(1, 1);
+	auto second = make_order(2, 2);
+	auto same_as_first = make_order(1, 1);
+	source->add(U("CustomerForOrder"), first, customer);
+	source->add(U("CustomerForOrder"), second, customer);
+
+	std::vector<std::shared_ptr<odata_entity_value>> orders;
+	orders.push_back(first);
+	orders.push_back(second);
+	orders.push_back(same_as_first);
+
+	odata_expand_executor executor(source);
+	executor.expand(orders, parse_expand(U("Orders"), U("CustomerForOrder")));
+
+	VERIFY_ARE_EQUAL(source->calls.size(), 1);
+	VERIFY_ARE_EQUAL(source->calls[0].second, 2);
+
+	std::shared_ptr<odata_value> value;
+	VERIFY_IS_TRUE(same_as_first->get_property_value(U("CustomerForOrder"), value));
+	VERIFY_ARE_EQUAL(value, customer);
+	VERIFY_IS_TRUE(second->get_property_value(U("CustomerForOrder"), value));
+	VERIFY_ARE_EQUAL(value, customer);
+}
+
+TEST(unknown_navigation_throws)
+{
+	auto source = std::make_shared<in_memory_expand_data_source>();
+	odata_expand_executor executor(source);
+
+	VERIFY_THROWS(executor.expand(make_customer(1), parse_expand(U("Customers"), U("OrderDetails"))), odata_exception);
+	VERIFY_ARE_EQUAL(executor.round_trips(), 0);
+}
+
+}
+
+}}}
@@ -0,0 +1,173 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_metrics_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/core/odata_core.h"
+#include "odata/core/odata_message_reader.h"
+#include "odata/core/odata_message_writer.h"
+#include "odata/core/odata_metrics.h"
+#include "odata/core/odata_uri_parser.h"
+
+using namespace ::odata::core;
+using namespace ::odata::edm;
+
+namespace tests { namespace functional { namespace _odata {
+
+// Installs a sink for the duration of a test; the sink is process-wide.
+class scoped_metrics_sink
+{
+public:
+	scoped_metrics_sink(std::shared_ptr<odata_metrics_sink> sink)
+	{
+		odata_metrics::set_sink(sink);
+	}
+
+	~scoped_metrics_sink()
+	{
+		odata_metrics::set_sink(nullptr);
+	}
+};
+
+SUITE(odata_metrics_tests)
+{
+
+TEST(no_sink_means_disabled)
+{
+	VERIFY_IS_FALSE(odata_metrics::enabled());
+	VERIFY_IS_NULL(odata_metrics::get_sink());
+
+	auto sink = std::make_shared<odata_histogram_metrics_sink>();
+	{
+		scoped_metrics_sink scope(sink);
+		VERIFY_IS_TRUE(odata_metrics::enabled());
+		VERIFY_ARE_EQUAL(odata_metrics::get_sink(), std::static_pointer_cast<odata_metrics_sink>(sink));
+	}
+	VERIFY_IS_FALSE(odata_metrics::enabled());
+
+	odata_uri_parser(get_test_model()).parse_path(U("/People"));
+	VERIFY_ARE_EQUAL(sink->stage_count(PathBind), 0);
+}
+
+TEST(uri_parse_reports_split_bind_and_expressions)
+{
+	auto sink = std::make_shared<odata_histogram_metrics_sink>();
+	scoped_metrics_sink scope(sink);
+
+	odata_uri_parser parser(get_test_model());
+	parser.parse_uri(::odata::utility::uri(::odata::utility::uri::encode_uri(U("http://service-root/Customers(1)/Orders?$filter=OrderID gt 1&$expand=OrderDetails"))));
+
+	VERIFY_ARE_EQUAL(sink->stage_count(UriSplit), 1);
+	VERIFY_ARE_EQUAL(sink->stage_count(PathBind), 1);
+	VERIFY_ARE_EQUAL(sink->stage_count(ExpressionParse), 1);
+	VERIFY_ARE_EQUAL(sink->stage_count(Serialize), 0);
+}
+
+TEST(payloads_report_stages_bytes_and_entities)
+{
+	auto sink = std::make_shared<odata_histogram_metrics_sink>();
+	scoped_metrics_sink scope(sink);
+	auto model = get_test_model();
+
+	auto account = std::make_shared<odata_entity_value>(model->find_entity_type(U("Account")));
+	account->set_value(U("AccountID"), (int32_t)100);
+	account->set_value(U("Country"), U("China"));
+	odata_message_writer writer(model, ::odata::utility::uri(g_service_root_url));
+	auto written = writer.write_odata_value(account);
+
+	VERIFY_ARE_EQUAL(sink->stage_count(Serialize), 1);
+	VERIFY_ARE_EQUAL(sink->counter(EntitiesWritten), 1);
+	VERIFY_ARE_EQUAL(sink->counter(PayloadBytesWritten), written.size());
+
+	::odata::utility::string_t payload = U("{\"@odata.context\":\"") + g_service_root_url + U("/$metadata#Accounts\",\"value\":[{\"AccountID\":100,\"Country\":\"China\"},{\"AccountID\":200,\"Country\":\"USA\"}]}");
+	odata_message_reader reader(model, ::odata::utility::uri(g_service_root_url), payload, true);
+	auto accounts = reader.read_entity_collection(model->find_container()->find_entity_set(U("Accounts")));
+	VERIFY_ARE_EQUAL(accounts->get_collection_values().size(), 2);
+
+	VERIFY_ARE_EQUAL(sink->stage_count(JsonParse), 1);
+	VERIFY_ARE_EQUAL(sink->stage_count(Deserialize), 1);
+	VERIFY_ARE_EQUAL(sink->counter(EntitiesRead), 2);
+	VERIFY_ARE_EQUAL(sink->counter(PayloadBytesRead), payload.size());
+
+	auto metadata = writer.write_metadata_document();
+	VERIFY_ARE_EQUAL(sink->stage_count(MetadataRender), 1);
+	VERIFY_ARE_EQUAL(sink->counter(PayloadBytesWritten), written.size() + metadata.size());
+}
+
+TEST(histogram_percentiles)
+{
+	odata_histogram_metrics_sink sink;
+	auto now = std::chrono::steady_clock::now();
+	for (int i = 0; i < 99; i++)
+	{
+		sink.on_stage(Serialize, now, std::chrono::nanoseconds(1000));
+	}
+	sink.on_stage(Serialize, now, std::chrono::nanoseconds(1000000));
+
+	VERIFY_ARE_EQUAL(sink.stage_count(Serialize), 100);
+	VERIFY_ARE_EQUAL(sink.stage_total_ns(Serialize), 99 * 1000 + 1000000);
+	VERIFY_ARE_EQUAL(sink.stage_max_ns(Serialize), 1000000);
+	VERIFY_ARE_EQUAL(sink.bucket(Serialize, 9), 99);
+
+	// 1000 ns falls in [512, 1024).
+	VERIFY_ARE_EQUAL(sink.stage_percentile_ns(Serialize, 50), 1023);
+	VERIFY_ARE_EQUAL(sink.stage_percentile_ns(Serialize, 99), 1023);
+	VERIFY_ARE_EQUAL(sink.stage_percentile_ns(Serialize, 100), 1000000);
+	VERIFY_ARE_EQUAL(sink.stage_percentile_ns(Deserialize, 50), 0);
+
+	std::ostringstream summary;
+	sink.write_summary(summary);
+	VERIFY_IS_TRUE(summary.str().find("serialize: count 100") != std::string::npos);
+	VERIFY_IS_TRUE(summary.str().find("deserialize") == std::string::npos);
+
+	sink.reset();
+	VERIFY_ARE_EQUAL(sink.stage_count(Serialize), 0);
+}
+
+TEST(stopped_timer_reports_once)
+{
+	auto sink = std::make_shared<odata_histogram_metrics_sink>();
+	scoped_metrics_sink scope(sink);
+	{
+		odata_stage_timer timer(UriSplit);
+		timer.stop();
+		timer.stop();
+	}
+	VERIFY_ARE_EQUAL(sink->stage_count(UriSplit), 1);
+}
+
+TEST(trace_events_are_chrome_trace_json)
+{
+	auto sink = std::make_shared<odata_trace_event_metrics_sink>(3);
+	scoped_metrics_sink scope(sink);
+
+	{
+		odata_stage_timer timer(MetadataRender);
+	}
+	odata_metrics::count(PayloadBytesWritten, 10);
+	odata_metrics::count(PayloadBytesWritten, 5);
+	odata_metrics::count(PayloadBytesWritten, 1);
+	VERIFY_ARE_EQUAL(sink->event_count(), 3);
+
+	std::ostringstream stream;
+	sink->write(stream);
+	auto trace = ::odata::utility::json::value::parse(::odata::utility::conversions::to_string_t(stream.str()));
+	auto events = trace.at(U("traceEvents"));
+	VERIFY_ARE_EQUAL(events.size(), 3);
+
+	VERIFY_ARE_EQUAL(events.at(0).at(U("name")).as_string(), U("metadata_render"));
+	VERIFY_ARE_EQUAL(events.at(0).at(U("ph")).as_string(), U("X"));
+	VERIFY_IS_TRUE(events.at(0).has_field(U("dur")));
+
+	VERIFY_ARE_EQUAL(events.at(2).at(U("ph")).as_string(), U("C"));
+	VERIFY_ARE_EQUAL(events.at(2).at(U("args")).at(U("payload_bytes_written")).as_integer(), 15);
+
+	sink->clear();
+	VERIFY_ARE_EQUAL(sink->event_count(), 0);
+}
+
+}
+
+}}}
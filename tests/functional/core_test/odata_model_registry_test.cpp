@@ -0,0 +1,194 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_model_registry_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/core/odata_model_registry.h"
+#include "odata/edm/edm_model_reader.h"
+#include <atomic>
+#include <thread>
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::shared_ptr<edm_model> load_registry_test_model()
+{
+	std::istringstream stream(test_model_string);
+	edm_model_reader reader(stream);
+	reader.parse();
+	return reader.get_model();
+}
+
+static std::function<void(std::shared_ptr<edm_model>)> add_customer_set(const ::odata::utility::string_t& name)
+{
+	return [name](std::shared_ptr<edm_model> model)
+	{
+		auto container = model->find_container();
+		container->add_entity_set(std::make_shared<edm_entity_set>(name, model->find_entity_type(U("Customer"))));
+	};
+}
+
+static ::odata::utility::uri registry_test_uri(const ::odata::utility::string_t& path)
+{
+	return ::odata::utility::uri(::odata::utility::uri::encode_uri(U("http://service-root/") + path));
+}
+
+SUITE(odata_model_registry_tests)
+{
+
+TEST(publish_freezes_and_numbers_versions)
+{
+	odata_model_registry registry;
+	VERIFY_IS_NULL(registry.current());
+
+	auto model = load_registry_test_model();
+	auto first = registry.publish(model);
+	VERIFY_ARE_EQUAL(first->version(), 1);
+	VERIFY_IS_TRUE(model->is_frozen());
+	VERIFY_ARE_EQUAL(registry.current(), first);
+	VERIFY_ARE_EQUAL(first->uri_parser().model(), model);
+
+	auto second = registry.publish(load_registry_test_model());
+	VERIFY_ARE_EQUAL(second->version(), 2);
+	VERIFY_ARE_EQUAL(registry.current(), second);
+
+	VERIFY_THROWS(registry.publish(nullptr), std::invalid_argument);
+}
+
+TEST(pinned_version_survives_update)
+{
+	std::vector<uint64_t> retired;
+	odata_model_registry registry;
+	registry.set_retired_callback([&retired](uint64_t version) { retired.push_back(version); });
+	VERIFY_THROWS(registry.update(add_customer_set(U("VipCustomers"))), std::runtime_error);
+
+	registry.publish(load_registry_test_model());
+	auto pinned = registry.current();
+	auto parsed = pinned->parse_uri(registry_test_uri(U("Customers?$filter=City eq 'Seattle'")));
+
+	auto updated = registry.update(add_customer_set(U("VipCustomers")));
+	VERIFY_ARE_EQUAL(updated->version(), 2);
+	VERIFY_ARE_EQUAL(registry.current(), updated);
+	VERIFY_ARE_NOT_EQUAL(updated->model(), pinned->model());
+	VERIFY_IS_TRUE(updated->model()->is_frozen());
+
+	// The pinned version still answers with the model it was published with.
+	VERIFY_IS_NULL(pinned->model()->find_container()->find_entity_set(U("VipCustomers")));
+	VERIFY_THROWS(pinned->parse_uri(registry_test_uri(U("VipCustomers"))), odata_exception);
+	VERIFY_ARE_EQUAL(pinned->parse_uri(registry_test_uri(U("Customers?$filter=City eq 'Seattle'"))), parsed);
+	VERIFY_ARE_EQUAL(parsed->filter_clause()->range_variable()->target_type()->get_name(), U("Customer"));
+
+	auto vip = updated->parse_uri(registry_test_uri(U("VipCustomers(1)/Orders?$expand=OrderDetails")));
+	VERIFY_ARE_EQUAL(vip->path()->size(), 3);
+	VERIFY_IS_TRUE(updated->metadata_document().find(U("VipCustomers")) != ::odata::utility::string_t::npos);
+	VERIFY_IS_TRUE(pinned->metadata_document().find(U("VipCustomers")) == ::odata::utility::string_t::npos);
+
+	VERIFY_ARE_EQUAL(registry.live_version_count(), 2);
+	VERIFY_IS_TRUE(retired.empty());
+
+	// Retiring happens when the last reader lets go, not when the newer version is published.
+	auto pinned_model = pinned->model();
+	pinned.reset();
+	VERIFY_ARE_EQUAL(registry.live_version_count(), 1);
+	VERIFY_ARE_EQUAL(retired.size(), 1);
+	VERIFY_ARE_EQUAL(retired[0], 1);
+	VERIFY_IS_NOT_NULL(pinned_model->find_container()->find_entity_set(U("Customers")));
+}
+
+TEST(derived_data_is_cached_per_version)
+{
+	odata_model_registry registry(2);
+	auto first = registry.publish(load_registry_test_model());
+
+	int created = 0;
+	std::function<std::shared_ptr<size_t>(const odata_model_version&)> count_entity_sets = [&created](const odata_model_version& version)
+	{
+		created++;
+		return std::make_shared<size_t>(version.model()->find_container()->get_entity_set_vector().size());
+	};
+
+	auto sets = first->get_or_create(U("entity-set-count"), count_entity_sets);
+	VERIFY_ARE_EQUAL(first->get_or_create(U("entity-set-count"), count_entity_sets), sets);
+	VERIFY_ARE_EQUAL(created, 1);
+
+	auto second = registry.update(add_customer_set(U("VipCustomers")));
+	VERIFY_ARE_EQUAL(*second->get_or_create(U("entity-set-count"), count_entity_sets), *sets + 1);
+	VERIFY_ARE_EQUAL(created, 2);
+
+	VERIFY_ARE_EQUAL(&first->metadata_document(), &first->metadata_document());
+
+	// The URI cache is bounded by the capacity given to the registry.
+	auto people = first->parse_uri(registry_test_uri(U("People")));
+	VERIFY_ARE_EQUAL(first->parse_uri(registry_test_uri(U("People"))), people);
+	first->parse_uri(registry_test_uri(U("Orders")));
+	VERIFY_ARE_EQUAL(first->parsed_uri_count(), 2);
+	first->parse_uri(registry_test_uri(U("Products")));
+	VERIFY_ARE_EQUAL(first->parsed_uri_count(), 1);
+	VERIFY_ARE_EQUAL(second->parsed_uri_count(), 0);
+
+	odata_model_registry uncached(0);
+	auto version = uncached.publish(load_registry_test_model());
+	VERIFY_ARE_NOT_EQUAL(version->parse_uri(registry_test_uri(U("People"))), version->parse_uri(registry_test_uri(U("People"))));
+	VERIFY_ARE_EQUAL(version->parsed_uri_count(), 0);
+}
+
+TEST(readers_keep_running_during_updates)
+{
+	odata_model_registry registry(16);
+	registry.publish(load_registry_test_model());
+
+	const int update_count = 20;
+	std::atomic<bool> done(false);
+	std::atomic<int> failures(0);
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; t++)
+	{
+		readers.push_back(std::thread([&registry, &done, &failures]()
+		{
+			uint64_t last_version = 0;
+			while (!done)
+			{
+				auto version = registry.current();
+				try
+				{
+					// Every version a reader sees is at least as new as the one before.
+					auto uri = version->parse_uri(registry_test_uri(U("Customers(1)/Orders?$filter=OrderID gt 1")));
+					auto sets = version->model()->find_container()->get_entity_set_vector().size();
+					if (version->version() < last_version || uri->path()->size() != 3 || sets < version->version())
+					{
+						failures++;
+					}
+					last_version = version->version();
+				}
+				catch (...)
+				{
+					failures++;
+				}
+			}
+		}));
+	}
+
+	for (int i = 0; i < update_count; i++)
+	{
+		registry.update(add_customer_set(U("Customers") + ::odata::utility::conversions::print_string(i)));
+	}
+
+	done = true;
+	for (auto iter = readers.begin(); iter != readers.end(); ++iter)
+	{
+		iter->join();
+	}
+
+	VERIFY_ARE_EQUAL(failures.load(), 0);
+	VERIFY_ARE_EQUAL(registry.current()->version(), update_count + 1);
+	VERIFY_IS_NOT_NULL(registry.current()->model()->find_container()->find_entity_set(U("Customers19")));
+	VERIFY_ARE_EQUAL(registry.live_version_count(), 1);
+}
+
+}
+
+}}}
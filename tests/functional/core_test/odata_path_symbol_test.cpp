@@ -0,0 +1,164 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_path_symbol_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/edm/edm_model_reader.h"
+#include "odata/core/odata_uri_parser.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::shared_ptr<edm_model> load_frozen_test_model()
+{
+	std::istringstream stream(test_model_string);
+	edm_model_reader reader(stream);
+	reader.parse();
+	auto model = reader.get_model();
+	model->freeze();
+	return model;
+}
+
+// Names each bound segment so paths bound against different models can be compared.
+static ::odata::utility::string_t describe(std::shared_ptr<odata_path> path)
+{
+	::odata::utility::string_t description;
+	for (auto iter = path->segments().cbegin(); iter != path->segments().cend(); ++iter)
+	{
+		auto segment = *iter;
+		description += U("/");
+		switch (segment->segment_type())
+		{
+		case odata_path_segment_type::EntitySet:
+			description += U("set:") + segment->as<odata_entity_set_segment>()->entity_set()->get_name();
+			break;
+		case odata_path_segment_type::Singleton:
+			description += U("singleton:") + segment->as<odata_singleton_segment>()->singleton()->get_name();
+			break;
+		case odata_path_segment_type::Key:
+			description += U("key");
+			break;
+		case odata_path_segment_type::StructuralProperty:
+			description += U("property:") + segment->as<odata_structural_property_segment>()->property()->get_name();
+			break;
+		case odata_path_segment_type::NavigationProperty:
+			description += U("navigation:") + segment->as<odata_navigation_property_segment>()->property()->get_name();
+			break;
+		case odata_path_segment_type::Type:
+			description += U("type:") + segment->as<odata_type_segment>()->type()->get_name();
+			break;
+		case odata_path_segment_type::Operation:
+			description += U("operation:") + segment->as<odata_operation_segment>()->operation()->get_name();
+			break;
+		case odata_path_segment_type::OperationImport:
+			description += U("import:") + segment->as<odata_operation_import_segment>()->operation_import()->get_name();
+			break;
+		default:
+			description += U("other");
+			break;
+		}
+	}
+	return description;
+}
+
+SUITE(odata_path_symbol_tests)
+{
+
+TEST(container_symbols_cover_every_kind)
+{
+	auto container = get_test_model()->find_container();
+
+	auto people = container->find_symbol(U("People"));
+	VERIFY_IS_NOT_NULL(people);
+	VERIFY_ARE_EQUAL(people->entity_set, container->find_entity_set(U("People")));
+	VERIFY_IS_NULL(people->singleton);
+
+	auto company = container->find_symbol(U("Company"));
+	VERIFY_IS_NOT_NULL(company);
+	VERIFY_ARE_EQUAL(company->singleton, container->find_singleton(U("Company")));
+	VERIFY_IS_NULL(company->entity_set);
+
+	auto import = container->find_symbol(U("GetDefaultColor"));
+	VERIFY_IS_NOT_NULL(import);
+	VERIFY_ARE_EQUAL(import->operation_import, container->find_operation_import(U("GetDefaultColor")));
+
+	VERIFY_IS_NULL(container->find_symbol(U("Nothing")));
+}
+
+TEST(type_symbols_are_built_on_freeze)
+{
+	VERIFY_IS_NULL(get_test_model()->find_entity_type(U("Company"))->find_symbol(U("CompanyID")));
+
+	auto model = load_frozen_test_model();
+	auto company = model->find_entity_type(U("Company"));
+	VERIFY_ARE_EQUAL(company->find_symbol(U("CompanyID"))->property, company->find_property(U("CompanyID")));
+	VERIFY_ARE_EQUAL(company->find_symbol(U("Employees"))->property, company->find_property(U("Employees")));
+
+	auto count = model->find_operation_type(U("GetEmployeesCount"));
+	VERIFY_ARE_EQUAL(company->find_symbol(U("GetEmployeesCount"))->operation, count);
+	VERIFY_ARE_EQUAL(company->find_symbol(U("Microsoft.Test.OData.Services.ODataWCFService.GetEmployeesCount"))->operation, count);
+	VERIFY_IS_NULL(company->find_symbol(U("GetEmployeesCount"))->collection_operation);
+	VERIFY_IS_NULL(company->find_symbol(U("GetDefaultColor")));
+
+	// Inherited properties are in the table of the derived type.
+	auto customer = model->find_entity_type(U("Customer"));
+	VERIFY_ARE_EQUAL(customer->find_symbol(U("PersonID"))->property, customer->find_property(U("PersonID")));
+
+	VERIFY_ARE_EQUAL(model->find_structured_type(U("Microsoft.Test.OData.Services.ODataWCFService.Customer")), std::static_pointer_cast<edm_structured_type>(customer));
+	VERIFY_ARE_EQUAL(model->find_structured_type(U("Address")), std::static_pointer_cast<edm_structured_type>(model->find_complex_type(U("Address"))));
+	VERIFY_IS_NULL(model->find_structured_type(U("Color")));
+}
+
+TEST(frozen_model_binds_paths_like_unfrozen_one)
+{
+	auto model = load_frozen_test_model();
+	odata_path_parser unfrozen(get_test_model());
+	odata_path_parser frozen(model);
+
+	const ::odata::utility::string_t paths[] =
+	{
+		U("/People(1)/Parent/HomeAddress/City"),
+		U("/Customers(1)/Orders(2)/OrderDetails"),
+		U("/People/Microsoft.Test.OData.Services.ODataWCFService.Customer"),
+		U("/Company/Microsoft.Test.OData.Services.ODataWCFService.GetEmployeesCount"),
+		U("/Company/GetEmployeesCount"),
+		U("/Company/Microsoft.Test.OData.Services.ODataWCFService.IncreaseRevenue(IncreaseValue=1)"),
+		U("/GetDefaultColor()"),
+		U("/LabourUnion"),
+	};
+
+	for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i)
+	{
+		VERIFY_ARE_EQUAL(describe(unfrozen.parse_path(paths[i])), describe(frozen.parse_path(paths[i])));
+	}
+
+	VERIFY_ARE_EQUAL(describe(frozen.parse_path(U("/Company/GetEmployeesCount"))), U("/singleton:Company/operation:GetEmployeesCount"));
+	VERIFY_ARE_EQUAL(describe(frozen.parse_path(U("/People(1)/Parent/HomeAddress/City"))), U("/set:People/key/navigation:Parent/property:HomeAddress/property:City"));
+}
+
+TEST(frozen_model_reports_the_same_errors)
+{
+	auto model = load_frozen_test_model();
+	odata_path_parser frozen(model);
+
+	// Not in the container.
+	VERIFY_THROWS(frozen.parse_path(U("/Nothing")), odata_exception);
+	// Neither a property, a type nor an operation, and Person is not open.
+	VERIFY_THROWS(frozen.parse_path(U("/People(1)/Nothing")), odata_exception);
+	// Bound to Company, not Person.
+	VERIFY_THROWS(frozen.parse_path(U("/People(1)/Microsoft.Test.OData.Services.ODataWCFService.GetEmployeesCount")), odata_exception);
+	// Bound to a single Company, not a collection.
+	VERIFY_THROWS(frozen.parse_path(U("/Employees/Microsoft.Test.OData.Services.ODataWCFService.GetEmployeesCount")), odata_exception);
+	// Unbound.
+	VERIFY_THROWS(frozen.parse_path(U("/Company/Microsoft.Test.OData.Services.ODataWCFService.GetDefaultColor")), odata_exception);
+	// Missing parameter.
+	VERIFY_THROWS(frozen.parse_path(U("/Company/Microsoft.Test.OData.Services.ODataWCFService.IncreaseRevenue")), odata_exception);
+}
+
+}
+
+}}}
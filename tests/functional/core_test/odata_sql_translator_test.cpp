@@ -0,0 +1,286 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_sql_translator_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/core/odata_sql_translator.h"
+#include "odata/core/odata_uri_parser.h"
+
+#if defined(ODATACPP_TESTS_HAVE_SQLITE3)
+#include <sqlite3.h>
+#endif
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::shared_ptr<odata_uri> parse_customers_uri(const ::odata::utility::string_t& query)
+{
+	odata_uri_parser parser(get_test_model());
+	return parser.parse_uri(::odata::utility::uri::encode_uri(U("http://service-root/Customers?") + query));
+}
+
+// Owns the mappings of the Customers and Orders tables, Customers refers to itself through Parent.
+struct sql_test_mappings
+{
+	sql_test_mappings()
+	{
+		customers = std::make_shared<odata_sql_table_mapping>(U("Customers"));
+		orders = std::make_shared<odata_sql_table_mapping>(U("Orders"));
+		customers->map_navigation(U("Orders"), orders, U("PersonID"), U("CustomerID"), true);
+		customers->map_navigation(U("Parent"), customers, U("ParentID"), U("PersonID"), false);
+		customers->map_property(U("IsVip"), U("vip"));
+		customers->map_property(U("UserAccess"), U("access"));
+	}
+
+	std::shared_ptr<odata_sql_table_mapping> customers;
+	std::shared_ptr<odata_sql_table_mapping> orders;
+};
+
+static std::shared_ptr<odata_sql_statement> translate(std::shared_ptr<odata_sql_dialect> dialect, const ::odata::utility::string_t& query)
+{
+	sql_test_mappings mappings;
+	auto translator = std::make_shared<odata_sql_translator>(dialect, mappings.customers);
+	return translator->translate(parse_customers_uri(query));
+}
+
+#if defined(ODATACPP_TESTS_HAVE_SQLITE3)
+
+class sqlite_customers_database
+{
+public:
+	sqlite_customers_database()
+	{
+		sqlite3_open(":memory:", &m_db);
+		exec("CREATE TABLE Customers (PersonID INTEGER, FirstName TEXT, LastName TEXT, MiddleName TEXT, City TEXT, Birthday TEXT, HomeAddress_Street TEXT, vip INTEGER, ParentID INTEGER, access INTEGER)");
+		exec("CREATE TABLE Orders (OrderID INTEGER, CustomerID INTEGER, Amount REAL)");
+		exec("INSERT INTO Customers VALUES (1, 'Alice', 'Smith', NULL, 'Seattle', '1990-05-10T08:30:00Z', 'Main', 1, NULL, 3)");
+		exec("INSERT INTO Customers VALUES (2, 'Bob', 'Jones', 'Q', 'Redmond', '1985-12-01T00:00:00Z', 'Pine', 0, 1, 1)");
+		exec("INSERT INTO Customers VALUES (3, 'Carol', 'Smith', NULL, 'Seattle', '2000-01-20T23:15:45Z', NULL, NULL, 1, NULL)");
+		exec("INSERT INTO Customers VALUES (4, 'Dave', 'Brown', 'X', 'Tacoma', '1975-07-04T12:00:00Z', 'Oak', 1, 2, 6)");
+		exec("INSERT INTO Orders VALUES (1, 1, 50.0), (2, 1, 150.0), (3, 2, 20.0), (4, 3, 300.0), (5, 3, 400.0)");
+	}
+
+	~sqlite_customers_database()
+	{
+		sqlite3_close(m_db);
+	}
+
+	// Runs the statement and returns the first column of every row.
+	std::vector<int64_t> query(std::shared_ptr<odata_sql_statement> statement)
+	{
+		sqlite3_stmt *stmt = nullptr;
+		auto sql = ::odata::utility::conversions::to_utf8string(statement->sql());
+		if (sqlite3_prepare_v2(m_db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+		{
+			throw std::runtime_error(std::string(sqlite3_errmsg(m_db)) + ": " + sql);
+		}
+
+		const auto &parameters = statement->parameters();
+		for (size_t i = 0; i < parameters.size(); i++)
+		{
+			auto type = std::dynamic_pointer_cast<edm_primitive_type>(parameters[i]->get_value_type());
+			switch (type->get_primitive_kind())
+			{
+			case edm_primitive_type_kind_t::Boolean:
+				sqlite3_bind_int(stmt, (int)i + 1, parameters[i]->to_string() == U("true") || parameters[i]->to_string() == U("1"));
+				break;
+			case edm_primitive_type_kind_t::Int16:
+			case edm_primitive_type_kind_t::Int32:
+			case edm_primitive_type_kind_t::Int64:
+				sqlite3_bind_int64(stmt, (int)i + 1, parameters[i]->as<int64_t>());
+				break;
+			case edm_primitive_type_kind_t::Double:
+			case edm_primitive_type_kind_t::Single:
+			case edm_primitive_type_kind_t::Decimal:
+				sqlite3_bind_double(stmt, (int)i + 1, parameters[i]->as<double>());
+				break;
+			default:
+				sqlite3_bind_text(stmt, (int)i + 1, ::odata::utility::conversions::to_utf8string(parameters[i]->to_string()).c_str(), -1, SQLITE_TRANSIENT);
+				break;
+			}
+		}
+
+		std::vector<int64_t> rows;
+		while (sqlite3_step(stmt) == SQLITE_ROW)
+		{
+			rows.push_back(sqlite3_column_int64(stmt, 0));
+		}
+		sqlite3_finalize(stmt);
+
+		return rows;
+	}
+
+	std::vector<int64_t> query(const ::odata::utility::string_t& query_options)
+	{
+		return query(translate(odata_sql_dialect::create_sqlite_dialect(), query_options));
+	}
+
+private:
+	void exec(const char *sql)
+	{
+		sqlite3_exec(m_db, sql, nullptr, nullptr, nullptr);
+	}
+
+	sqlite3 *m_db;
+};
+
+static ::odata::utility::string_t ids(const std::vector<int64_t>& rows)
+{
+	::odata::utility::string_t result;
+	for (size_t i = 0; i < rows.size(); i++)
+	{
+		result += (i > 0 ? U(",") : U("")) + ::odata::utility::conversions::print_string(rows[i]);
+	}
+	return result;
+}
+
+#endif
+
+SUITE(odata_sql_translator_tests)
+{
+
+TEST(sqlite_statement_text)
+{
+	auto statement = translate(odata_sql_dialect::create_sqlite_dialect(),
+		U("$filter=City eq 'Seattle' and MiddleName eq null&$orderby=LastName desc,PersonID&$top=10&$skip=20&$select=PersonID,City"));
+
+	VERIFY_ARE_EQUAL(statement->sql(),
+		U("SELECT t0.\"PersonID\", t0.\"City\" FROM \"Customers\" AS t0 WHERE ((t0.\"City\" = ?1) AND (t0.\"MiddleName\" IS NULL)) ")
+		U("ORDER BY t0.\"LastName\" DESC, t0.\"PersonID\" ASC LIMIT ?2 OFFSET ?3"));
+	VERIFY_ARE_EQUAL(statement->parameters().size(), 3);
+	VERIFY_ARE_EQUAL(statement->parameters()[0]->to_string(), U("Seattle"));
+	VERIFY_ARE_EQUAL(statement->parameters()[1]->to_string(), U("10"));
+	VERIFY_ARE_EQUAL(statement->parameters()[2]->to_string(), U("20"));
+}
+
+TEST(postgresql_and_sql_server_dialects)
+{
+	auto query = U("$filter=contains(FirstName,'a') and MiddleName ne LastName&$top=5&$skip=10");
+
+	auto statement = translate(odata_sql_dialect::create_postgresql_dialect(), query);
+	VERIFY_ARE_EQUAL(statement->sql(),
+		U("SELECT t0.* FROM \"Customers\" AS t0 WHERE ((STRPOS(t0.\"FirstName\", $1) > 0) AND (t0.\"MiddleName\" IS DISTINCT FROM t0.\"LastName\")) LIMIT $2 OFFSET $3"));
+
+	statement = translate(odata_sql_dialect::create_sql_server_dialect(), query);
+	VERIFY_ARE_EQUAL(statement->sql(),
+		U("SELECT t0.* FROM [Customers] AS t0 WHERE ((CHARINDEX(@p1, t0.[FirstName]) > 0) AND ")
+		U("(t0.[MiddleName] <> t0.[LastName] OR (t0.[MiddleName] IS NULL AND t0.[LastName] IS NOT NULL) OR (t0.[MiddleName] IS NOT NULL AND t0.[LastName] IS NULL))) ")
+		U("ORDER BY (SELECT NULL) OFFSET @p3 ROWS FETCH NEXT @p2 ROWS ONLY"));
+}
+
+TEST(lambda_and_navigation_subqueries)
+{
+	auto statement = translate(odata_sql_dialect::create_sqlite_dialect(), U("$filter=Orders/all(o:o/Amount gt 100) and Parent/FirstName eq 'Alice'"));
+	VERIFY_ARE_EQUAL(statement->sql(),
+		U("SELECT t0.* FROM \"Customers\" AS t0 WHERE (")
+		U("NOT EXISTS (SELECT 1 FROM \"Orders\" AS t1 WHERE t1.\"CustomerID\" = t0.\"PersonID\" AND (CASE WHEN (t1.\"Amount\" > ?1) THEN 1 ELSE 0 END = 0)) AND ")
+		U("((SELECT t2.\"FirstName\" FROM \"Customers\" AS t2 WHERE t2.\"PersonID\" = t0.\"ParentID\") = ?2))"));
+}
+
+TEST(has_masks_enum_flags_in_every_dialect)
+{
+	auto query = U("$filter=UserAccess has 3");
+
+	auto statement = translate(odata_sql_dialect::create_sqlite_dialect(), query);
+	VERIFY_ARE_EQUAL(statement->sql(), U("SELECT t0.* FROM \"Customers\" AS t0 WHERE ((t0.\"access\" & ?1) = ?1)"));
+	VERIFY_ARE_EQUAL(statement->parameters().size(), 1);
+	VERIFY_ARE_EQUAL(statement->parameters()[0]->to_string(), U("3"));
+
+	statement = translate(odata_sql_dialect::create_postgresql_dialect(), query);
+	VERIFY_ARE_EQUAL(statement->sql(), U("SELECT t0.* FROM \"Customers\" AS t0 WHERE ((t0.\"access\" & $1) = $1)"));
+
+	statement = translate(odata_sql_dialect::create_sql_server_dialect(), query);
+	VERIFY_ARE_EQUAL(statement->sql(), U("SELECT t0.* FROM [Customers] AS t0 WHERE ((t0.[access] & @p1) = @p1)"));
+
+	// Enum literals are not resolved by the parser and reach the translator as null.
+	VERIFY_THROWS(translate(odata_sql_dialect::create_sqlite_dialect(), U("$filter=UserAccess has AccessLevel'Read'")), odata_exception);
+}
+
+TEST(untranslatable_expressions_throw)
+{
+	auto dialect = odata_sql_dialect::create_sqlite_dialect();
+	VERIFY_THROWS(translate(dialect, U("$filter=geo.distance(Home,Home) lt 10")), odata_exception);
+	VERIFY_THROWS(translate(dialect, U("$filter=Orders/Amount gt 10")), odata_exception);
+	VERIFY_THROWS(translate(dialect, U("$filter=Parent eq null")), odata_exception);
+}
+
+#if defined(ODATACPP_TESTS_HAVE_SQLITE3)
+
+TEST(sqlite_filter_order_and_page)
+{
+	sqlite_customers_database db;
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=City eq 'Seattle'&$orderby=PersonID desc"))), U("3,1"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$orderby=FirstName&$top=2&$skip=1"))), U("2,3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$orderby=PersonID&$skip=3"))), U("4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$orderby=LastName,FirstName desc&$top=3"))), U("4,2,3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=PersonID mod 2 eq 0 or PersonID add 1 gt 4&$orderby=PersonID"))), U("2,4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=-PersonID lt -3"))), U("4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=HomeAddress/Street eq 'Main'"))), U("1"));
+
+	sql_test_mappings mappings;
+	auto translator = std::make_shared<odata_sql_translator>(odata_sql_dialect::create_sqlite_dialect(), mappings.customers);
+	VERIFY_ARE_EQUAL(ids(db.query(translator->translate_count(parse_customers_uri(U("$filter=City eq 'Seattle'&$top=1"))))), U("2"));
+}
+
+TEST(sqlite_null_semantics)
+{
+	sqlite_customers_database db;
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=MiddleName eq null&$orderby=PersonID"))), U("1,3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=MiddleName ne null&$orderby=PersonID"))), U("2,4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=MiddleName ne 'Q'&$orderby=PersonID"))), U("1,3,4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=not (MiddleName eq 'Q')&$orderby=PersonID"))), U("1,3,4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=not (HomeAddress/Street gt 'Oak')&$orderby=PersonID"))), U("1,3,4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=MiddleName eq HomeAddress/Street&$orderby=PersonID"))), U("3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=IsVip&$orderby=PersonID"))), U("1,4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=not IsVip"))), U("2"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=IsVip eq true&$orderby=PersonID"))), U("1,4"));
+}
+
+TEST(sqlite_has_enum_flags)
+{
+	sqlite_customers_database db;
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=UserAccess has 1&$orderby=PersonID"))), U("1,2"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=UserAccess has 2&$orderby=PersonID"))), U("1,4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=UserAccess has 3"))), U("1"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=UserAccess has 0&$orderby=PersonID"))), U("1,2,4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=not (UserAccess has 2)&$orderby=PersonID"))), U("2,3"));
+}
+
+TEST(sqlite_string_and_date_functions)
+{
+	sqlite_customers_database db;
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=contains(FirstName,'a') and startswith(LastName,'S')"))), U("3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=endswith(City,'ma')"))), U("4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=tolower(FirstName) eq 'bob'"))), U("2"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=toupper(trim(City)) eq 'TACOMA'"))), U("4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=indexof(FirstName,'o') eq 1"))), U("2"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=substring(City,1,3) eq 'eat'&$orderby=PersonID"))), U("1,3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=substring(City,4) eq 'tle'&$orderby=PersonID"))), U("1,3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=concat(FirstName,LastName) eq 'BobJones'"))), U("2"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=length(FirstName) eq 3"))), U("2"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=year(Birthday) lt 1986&$orderby=PersonID"))), U("2,4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=month(Birthday) eq 7 and day(Birthday) eq 4"))), U("4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=hour(Birthday) eq 23 and minute(Birthday) eq 15 and second(Birthday) eq 45"))), U("3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=floor(PersonID div 2.0) eq 1 and ceiling(PersonID div 2.0) eq 2"))), U("3"));
+}
+
+TEST(sqlite_lambda_and_navigation)
+{
+	sqlite_customers_database db;
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=Orders/any(o:o/Amount gt 100)&$orderby=PersonID"))), U("1,3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=Orders/all(o:o/Amount gt 100)&$orderby=PersonID"))), U("3,4"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=Orders/any()&$orderby=PersonID"))), U("1,2,3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=Orders/any(o:o/Amount gt 100 and City eq 'Seattle')&$orderby=PersonID"))), U("1,3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=Parent/FirstName eq 'Alice'&$orderby=PersonID"))), U("2,3"));
+	VERIFY_ARE_EQUAL(ids(db.query(U("$filter=Parent/Orders/any(o:o/Amount lt 30)"))), U("4"));
+}
+
+#endif
+
+}
+
+}}}
@@ -0,0 +1,150 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_synthetic_generator_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "synthetic_generator.h"
+#include "odata/core/odata_core.h"
+#include "odata/core/odata_json_reader_minimal.h"
+#include "odata/core/odata_uri_parser.h"
+#include "odata/edm/edm_model_reader.h"
+
+using namespace ::odata::core;
+using namespace ::odata::edm;
+using namespace ::odata::utility;
+using namespace ::tests::common::utilities;
+
+namespace tests { namespace functional { namespace _odata {
+
+static const char* const g_synthetic_root = "http://synthetic/";
+
+static std::shared_ptr<edm_model> load_synthetic_model(const synthetic_model& generator)
+{
+	std::istringstream stream(generator.csdl());
+	edm_model_reader reader(stream);
+	reader.parse();
+	return reader.get_model();
+}
+
+static synthetic_model_options make_options(uint64_t seed)
+{
+	synthetic_model_options options;
+	options.seed = seed;
+	options.schema_count = 3;
+	options.type_count = 60;
+	options.properties_per_type = 9;
+	options.inheritance_depth = 2;
+	options.navigation_fan_out = 3;
+	return options;
+}
+
+SUITE(odata_synthetic_generator_tests)
+{
+
+TEST(output_depends_only_on_options)
+{
+	synthetic_model first(make_options(7)), second(make_options(7)), other(make_options(8));
+
+	VERIFY_IS_TRUE(first.csdl() == second.csdl());
+	VERIFY_IS_TRUE(first.collection_payload(g_synthetic_root, 4, 20) == second.collection_payload(g_synthetic_root, 4, 20));
+	VERIFY_IS_TRUE(first.query_url(11) == second.query_url(11));
+
+	VERIFY_IS_TRUE(first.csdl() != other.csdl());
+	VERIFY_IS_TRUE(first.collection_payload(g_synthetic_root, 4, 20) != other.collection_payload(g_synthetic_root, 4, 20));
+	VERIFY_IS_TRUE(first.entity_payload(g_synthetic_root, 4, 1) != first.entity_payload(g_synthetic_root, 4, 2));
+}
+
+TEST(model_has_requested_shape)
+{
+	synthetic_model generator(make_options(7));
+	auto model = load_synthetic_model(generator);
+
+	size_t enum_count = 0, complex_count = 0, entity_count = 0;
+	auto schemas = model->get_schema();
+	VERIFY_ARE_EQUAL(schemas.size(), 3);
+	for (auto iter = schemas.cbegin(); iter != schemas.cend(); ++iter)
+	{
+		enum_count += (*iter)->get_enum_types().size();
+		complex_count += (*iter)->get_complex_types().size();
+		entity_count += (*iter)->get_entity_types().size();
+	}
+	VERIFY_ARE_EQUAL(enum_count, 6);
+	VERIFY_ARE_EQUAL(complex_count, 12);
+	VERIFY_ARE_EQUAL(entity_count, 42);
+	VERIFY_ARE_EQUAL(generator.entity_set_count(), 42);
+
+	auto container = model->find_container();
+	VERIFY_IS_NOT_NULL(container);
+	VERIFY_ARE_EQUAL(container->get_entity_set_vector().size(), 42);
+
+	// Entity2 is the bottom of the first chain: two bases, with their properties and navigations inherited.
+	auto deepest = container->find_entity_set(U("Set2"))->get_entity_type();
+	VERIFY_IS_NOT_NULL(deepest->get_base_type());
+	VERIFY_IS_NOT_NULL(deepest->get_base_type()->get_base_type());
+	VERIFY_IS_NULL(deepest->get_base_type()->get_base_type()->get_base_type());
+	VERIFY_ARE_EQUAL(deepest->get_key_with_parents().size(), 1);
+	VERIFY_IS_NOT_NULL(deepest->find_property(U("Nav0")));
+	VERIFY_IS_NOT_NULL(deepest->find_property(U("Nav2D2")));
+
+	auto collection_navigation = std::dynamic_pointer_cast<edm_navigation_type>(deepest->find_property(U("Nav1D1"))->get_property_type());
+	VERIFY_IS_NOT_NULL(collection_navigation);
+	VERIFY_IS_NOT_NULL(std::dynamic_pointer_cast<edm_collection_type>(collection_navigation->get_navigation_type()));
+	VERIFY_IS_NOT_NULL(collection_navigation->get_binded_navigation_source());
+}
+
+TEST(payloads_deserialize_against_model)
+{
+	synthetic_model generator(make_options(7));
+	auto model = load_synthetic_model(generator);
+	auto container = model->find_container();
+	odata_json_reader_minimal reader(model, U("http://synthetic/"), true);
+
+	for (size_t set = 0; set < generator.entity_set_count(); set++)
+	{
+		auto entity_set = container->find_entity_set(conversions::to_string_t(generator.entity_set_name(set)));
+		auto collection = reader.deserilize_entity_collection(json::value::parse(conversions::to_string_t(generator.collection_payload(g_synthetic_root, set, 5))), entity_set);
+		VERIFY_ARE_EQUAL(collection->get_collection_values().size(), 5);
+
+		auto entity = reader.deserilize_entity_value(json::value::parse(conversions::to_string_t(generator.entity_payload(g_synthetic_root, set, 3))), entity_set->get_entity_type());
+		int64_t id = 0;
+		VERIFY_IS_TRUE(entity->try_get(U("Id"), id));
+		VERIFY_ARE_EQUAL(id, 3);
+	}
+}
+
+TEST(urls_parse_against_model)
+{
+	synthetic_model generator(make_options(7));
+	auto model = load_synthetic_model(generator);
+	odata_uri_parser parser(model);
+
+	size_t filters = 0, expands = 0;
+	for (uint64_t index = 0; index < 200; index++)
+	{
+		auto url = generator.query_url(index);
+		auto parsed = parser.parse_uri(uri::encode_uri(U("http://synthetic/") + conversions::to_string_t(url)));
+		VERIFY_IS_NOT_NULL(parsed->path());
+		filters += parsed->filter_clause() ? 1 : 0;
+		expands += parsed->select_expand_clause() && url.find("$expand=") != std::string::npos ? 1 : 0;
+	}
+
+	VERIFY_IS_TRUE(filters > 50);
+	VERIFY_IS_TRUE(expands > 50);
+}
+
+TEST(invalid_options_throw)
+{
+	auto options = make_options(1);
+	options.schema_count = 0;
+	VERIFY_THROWS(synthetic_model generator(options), std::invalid_argument);
+
+	options = make_options(1);
+	options.type_count = 0;
+	VERIFY_THROWS(synthetic_model generator(options), std::invalid_argument);
+}
+
+}
+
+}}}
@@ -0,0 +1,209 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_uri_parser_concurrency_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/core/odata_uri_parser.h"
+#include <atomic>
+#include <thread>
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+
+namespace tests { namespace functional { namespace _odata {
+
+static const ::odata::utility::char_t *concurrency_test_uris[] =
+{
+	U("http://service-root/Customers?$filter=City eq 'Seattle' and PersonID gt 3&$orderby=LastName desc&$top=5&$skip=2"),
+	U("http://service-root/Orders?$filter=OrderDetails/any(d: d/Quantity gt 2)&$expand=OrderDetails($filter=Quantity gt 1;$orderby=UnitPrice;$top=3)"),
+	U("http://service-root/Products(5)/Details?$select=Description&$count=true"),
+	U("http://service-root/People(1)/Parent"),
+	U("http://service-root/OrderDetails?$apply=groupby((OrderID),aggregate(Quantity with sum as Total))"),
+	U("http://service-root/Customers?$expand=Orders($expand=OrderDetails),Parent&$search=blue or green"),
+	U("http://service-root/Orders?$filter=year(OrderDate) eq 2014 or not (OrderID lt 10)&$orderby=OrderDate,OrderID desc"),
+	U("http://service-root/NotAnEntitySet?$filter=ID eq 1"),
+};
+
+static const size_t concurrency_test_uri_count = sizeof(concurrency_test_uris) / sizeof(concurrency_test_uris[0]);
+
+// Reduces a parse result to a string so that results produced on different threads can be compared.
+static ::odata::utility::string_t describe(std::shared_ptr<odata_uri> uri)
+{
+	::odata::utility::ostringstream_t out;
+	out << uri->path()->size() << U('|');
+
+	auto filter_clause = uri->filter_clause();
+	if (filter_clause)
+	{
+		out << filter_clause->expression()->node_kind() << U(':') << filter_clause->range_variable()->target_type()->get_name();
+	}
+	out << U('|');
+
+	if (uri->orderby_clause())
+	{
+		out << uri->orderby_clause()->items().size();
+	}
+	out << U('|');
+
+	auto select_expand_clause = uri->select_expand_clause();
+	if (select_expand_clause)
+	{
+		out << select_expand_clause->select_items().size() << U(',') << select_expand_clause->expand_items().size();
+		for (size_t i = 0; i < select_expand_clause->expand_items().size(); i++)
+		{
+			auto item = select_expand_clause->expand_item_at(i);
+			out << U(',') << item->end()->as<odata_property_access_node>()->property_name();
+			if (item->filter_clause())
+			{
+				out << U(':') << item->filter_clause()->range_variable()->target_type()->get_name();
+			}
+		}
+	}
+	out << U('|');
+
+	out << (uri->top().has_value() ? uri->top().value() : -1) << U(',') << (uri->skip().has_value() ? uri->skip().value() : -1) << U('|');
+	out << (uri->search_clause() ? 1 : 0) << (uri->apply_clause() ? uri->apply_clause()->transformations().size() : 0);
+
+	return out.str();
+}
+
+static ::odata::utility::string_t parse_and_describe(const odata_uri_parser& parser, size_t index)
+{
+	try
+	{
+		return describe(parser.parse_uri(::odata::utility::uri::encode_uri(concurrency_test_uris[index])));
+	}
+	catch (odata_exception &e)
+	{
+		return U("error: ") + e.what();
+	}
+}
+
+SUITE(odata_uri_parser_concurrency_tests)
+{
+
+TEST(each_uri_binds_against_its_own_path)
+{
+	odata_uri_parser parser(get_test_model());
+
+	auto customers = parser.parse_uri(::odata::utility::uri::encode_uri(U("http://service-root/Customers?$filter=City eq 'Seattle'")));
+	auto orders = parser.parse_uri(::odata::utility::uri::encode_uri(U("http://service-root/Orders?$filter=OrderID gt 1")));
+
+	VERIFY_ARE_EQUAL(customers->filter_clause()->range_variable()->target_type()->get_name(), U("Customer"));
+	VERIFY_ARE_EQUAL(orders->filter_clause()->range_variable()->target_type()->get_name(), U("Order"));
+	VERIFY_ARE_EQUAL(orders->filter_clause()->range_variable()->target_navigation_source()->get_name(), U("Orders"));
+}
+
+TEST(failed_parse_leaves_no_state_behind)
+{
+	odata_uri_parser parser(get_test_model());
+
+	VERIFY_THROWS(parser.parse_uri(::odata::utility::uri::encode_uri(U("http://service-root/Orders(1)/NotDeclared"))), odata_exception);
+
+	auto customers = parser.parse_uri(::odata::utility::uri::encode_uri(U("http://service-root/Customers?$filter=City eq 'Seattle'")));
+	VERIFY_ARE_EQUAL(customers->path()->size(), 1);
+	VERIFY_ARE_EQUAL(customers->filter_clause()->range_variable()->target_type()->get_name(), U("Customer"));
+}
+
+TEST(standalone_query_options_without_target_throw)
+{
+	const odata_uri_parser parser(get_test_model());
+
+	VERIFY_THROWS(parser.parse_filter(U("City eq 'Seattle'")), odata_exception);
+	VERIFY_THROWS(parser.parse_orderby(U("LastName desc")), odata_exception);
+	VERIFY_THROWS(parser.parse_select_and_expand(U("City"), U("")), odata_exception);
+	VERIFY_THROWS(parser.parse_select_and_expand(U(""), U("Orders")), odata_exception);
+	VERIFY_THROWS(parser.parse_apply(U("aggregate($count as Count)")), odata_exception);
+
+	VERIFY_IS_NOT_NULL(parser.parse_search(U("blue")));
+	VERIFY_ARE_EQUAL(parser.parse_top(U("5")).value(), 5);
+	VERIFY_ARE_EQUAL(parser.parse_skip(U("2")).value(), 2);
+	VERIFY_IS_TRUE(parser.parse_count(U("true")).value());
+}
+
+TEST(standalone_query_options_bind_against_given_target)
+{
+	auto model = get_test_model();
+	const odata_uri_parser parser(model);
+
+	auto customers = model->find_container()->find_entity_set(U("Customers"));
+	std::shared_ptr<edm_named_type> customer_collection = std::make_shared<edm_collection_type>(customers->get_entity_type());
+
+	auto filter_clause = parser.parse_filter(U("City eq 'Seattle'"), customer_collection, customers);
+	VERIFY_ARE_EQUAL(filter_clause->range_variable()->target_type()->get_name(), U("Customer"));
+	VERIFY_ARE_EQUAL(filter_clause->range_variable()->target_navigation_source()->get_name(), U("Customers"));
+
+	auto orderby_clause = parser.parse_orderby(U("LastName desc,City"), customer_collection, customers);
+	VERIFY_ARE_EQUAL(orderby_clause->items().size(), 2);
+	VERIFY_ARE_EQUAL(orderby_clause->range_variable()->target_type()->get_name(), U("Customer"));
+
+	auto select_expand_clause = parser.parse_select_and_expand(U("City"), U("Orders"), customer_collection, customers);
+	VERIFY_ARE_EQUAL(select_expand_clause->select_items().size(), 1);
+	VERIFY_ARE_EQUAL(select_expand_clause->expand_items().size(), 1);
+
+	auto apply_clause = parser.parse_apply(U("groupby((City),aggregate($count as Count))"), customer_collection, customers);
+	VERIFY_ARE_EQUAL(apply_clause->transformations().size(), 1);
+
+	// A single entity is not a collection, so only $select and $expand bind against it.
+	std::shared_ptr<edm_named_type> customer = customers->get_entity_type();
+	VERIFY_THROWS(parser.parse_filter(U("City eq 'Seattle'"), customer, customers), odata_exception);
+	VERIFY_THROWS(parser.parse_orderby(U("City"), customer, customers), odata_exception);
+	VERIFY_IS_NOT_NULL(parser.parse_select_and_expand(U("City"), U(""), customer, customers));
+}
+
+TEST(shared_parser_from_32_threads)
+{
+	const size_t thread_count = 32;
+	const size_t iterations = 200;
+
+	auto model = get_test_model();
+	const odata_uri_parser parser(model);
+
+	std::vector<::odata::utility::string_t> expected;
+	for (size_t i = 0; i < concurrency_test_uri_count; i++)
+	{
+		expected.push_back(parse_and_describe(parser, i));
+		VERIFY_ARE_EQUAL(expected.back().compare(0, 6, U("error:")) == 0, i + 1 == concurrency_test_uri_count);
+	}
+
+	std::atomic<size_t> parsed(0);
+	std::atomic<size_t> mismatches(0);
+	std::atomic<bool> start(false);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < thread_count; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			while (!start.load())
+			{
+				std::this_thread::yield();
+			}
+
+			for (size_t i = 0; i < iterations; i++)
+			{
+				// Every thread walks the URIs from a different offset so that different parses overlap.
+				size_t index = (t + i) % concurrency_test_uri_count;
+				if (parse_and_describe(parser, index) != expected[index])
+				{
+					mismatches++;
+				}
+				parsed++;
+			}
+		}));
+	}
+
+	start = true;
+	for (auto iter = threads.begin(); iter != threads.end(); ++iter)
+	{
+		iter->join();
+	}
+
+	VERIFY_ARE_EQUAL(parsed.load(), thread_count * iterations);
+	VERIFY_ARE_EQUAL(mismatches.load(), 0);
+}
+
+}
+
+}}}
@@ -441,6 +441,52 @@ TEST(entity_collection_value)
 	VERIFY_ARE_EQUAL(str, U("UK"));
 }
 
+
+TEST(primitive_value_does_not_own_static_type)
+{
+	auto owners = edm_primitive_type::INT32().use_count();
+	auto value = odata_primitive_value::make_primitive_value((int32_t)7);
+	auto copy = std::make_shared<odata_primitive_value>(*value);
+	std::shared_ptr<odata_value> named = std::make_shared<odata_primitive_value>(std::static_pointer_cast<edm_named_type>(edm_primitive_type::INT32()), U("8"));
+
+	VERIFY_ARE_EQUAL(edm_primitive_type::INT32().use_count(), owners);
+	VERIFY_ARE_EQUAL(value->get_value_type(), std::static_pointer_cast<edm_named_type>(edm_primitive_type::INT32()));
+	VERIFY_ARE_EQUAL(copy->get_value_type(), value->get_value_type());
+	VERIFY_ARE_EQUAL(named->get_value_type(), value->get_value_type());
+	VERIFY_IS_TRUE(edm_named_type::find_static_owner(edm_named_type::EDM_UNKNOWN().get()) == &edm_named_type::EDM_UNKNOWN());
+
+	// Types owned by a model are still owned by the values that use them.
+	auto model_type = std::make_shared<edm_enum_type>(U("Color"), U("Test"), U("Edm.Int32"), false);
+	VERIFY_IS_NULL(edm_named_type::find_static_owner(model_type.get()));
+	auto enum_value = std::make_shared<odata_enum_value>(model_type, U("Red"));
+	VERIFY_ARE_EQUAL(model_type.use_count(), 2);
+
+	enum_value->set_value_type(edm_primitive_type::STRING());
+	VERIFY_ARE_EQUAL(model_type.use_count(), 1);
+	VERIFY_ARE_EQUAL(enum_value->get_value_type(), std::static_pointer_cast<edm_named_type>(edm_primitive_type::STRING()));
+}
+
+TEST(null_type_constructs_and_value_type_outlives_change)
+{
+	odata_value untyped(nullptr);
+	VERIFY_IS_NULL(untyped.get_value_type());
+	VERIFY_IS_TRUE(untyped.get_value_type_pointer() == nullptr);
+
+	odata_primitive_value primitive(nullptr, U("1"));
+	VERIFY_IS_NULL(primitive.get_value_type());
+
+	auto model_type = std::make_shared<edm_enum_type>(U("Color"), U("Test"), U("Edm.Int32"), false);
+	auto enum_value = std::make_shared<odata_enum_value>(model_type, U("Red"));
+	VERIFY_IS_TRUE(enum_value->get_value_type_pointer() == model_type.get());
+
+	// The type returned before set_value_type stays valid after it.
+	auto type = enum_value->get_value_type();
+	model_type.reset();
+	enum_value->set_value_type(edm_primitive_type::STRING());
+	VERIFY_ARE_EQUAL(type->get_name(), U("Color"));
+	VERIFY_IS_TRUE(enum_value->get_value_type_pointer() == edm_primitive_type::STRING().get());
+}
+
 }
 
 }}}
\ No newline at end of file
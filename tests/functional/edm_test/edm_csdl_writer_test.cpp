@@ -0,0 +1,178 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_csdl_writer_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/edm/edm_model_reader.h"
+#include "odata/edm/edm_model_writer.h"
+#include "odata/edm/edm_csdl_writer.h"
+#include "odata/core/odata_message_writer.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::utility;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::shared_ptr<edm_model> load_test_model()
+{
+	std::istringstream stream(test_model_string);
+	edm_model_reader reader(stream);
+	reader.parse();
+	return reader.get_model();
+}
+
+static std::string write_with_libxml2(std::shared_ptr<edm_model> model)
+{
+	std::ostringstream stream;
+	edm_model_writer writer(stream);
+	writer.write_model(model);
+	return stream.str();
+}
+
+static std::string write_csdl(std::shared_ptr<edm_model> model, edm_csdl_format_t format)
+{
+	std::string output;
+	edm_csdl_writer writer(output, format);
+	writer.write_model(model);
+	return output;
+}
+
+SUITE(edm_csdl_writer_tests)
+{
+
+TEST(xml_matches_edm_model_writer)
+{
+	auto expected = write_with_libxml2(get_test_model());
+	auto actual = write_csdl(get_test_model(), edm_csdl_format_t::Xml);
+	VERIFY_IS_TRUE(actual.size() > 4096);
+	VERIFY_IS_TRUE(actual == expected);
+
+	std::ostringstream stream;
+	edm_csdl_writer writer(stream);
+	writer.write_model(get_test_model());
+	VERIFY_IS_TRUE(stream.str() == expected);
+}
+
+TEST(xml_escapes_attribute_values)
+{
+	auto model = load_test_model();
+	model->find_enum_type(U("Color"))->add_enum_member(std::make_shared<edm_enum_member>(U("Fish & \"Chips\" <Blue>\n\tTab"), 8));
+
+	auto actual = write_csdl(model, edm_csdl_format_t::Xml);
+	VERIFY_IS_TRUE(actual.find("Name=\"Fish &amp; &quot;Chips&quot; &lt;Blue&gt;&#10;&#9;Tab\" Value=\"8\"") != std::string::npos);
+	VERIFY_IS_TRUE(actual == write_with_libxml2(model));
+}
+
+TEST(xml_reads_back_into_the_same_model)
+{
+	std::istringstream stream(write_csdl(get_test_model(), edm_csdl_format_t::Xml));
+	edm_model_reader reader(stream);
+	reader.parse();
+	auto model = reader.get_model();
+
+	auto customer = model->find_entity_type(U("Customer"));
+	VERIFY_IS_NOT_NULL(customer);
+	VERIFY_ARE_EQUAL(customer->key(), get_test_model()->find_entity_type(U("Customer"))->key());
+	VERIFY_IS_NOT_NULL(customer->find_property(U("Orders")));
+	VERIFY_IS_TRUE(model->find_enum_type(U("AccessLevel"))->is_flag());
+	VERIFY_ARE_EQUAL(model->find_container()->get_entity_set_vector().size(), get_test_model()->find_container()->get_entity_set_vector().size());
+	VERIFY_IS_NOT_NULL(model->find_container()->find_operation_import(U("GetDefaultColor")));
+}
+
+TEST(json_describes_the_same_model)
+{
+	auto json = json::value::parse(edm_csdl_writer::write_model_to_string(get_test_model(), edm_csdl_format_t::Json));
+	const string_t ns = U("Microsoft.Test.OData.Services.ODataWCFService");
+
+	VERIFY_ARE_EQUAL(json[U("$Version")].as_string(), U("4.0"));
+	VERIFY_ARE_EQUAL(json[U("$EntityContainer")].as_string(), ns + U(".InMemoryEntities"));
+
+	auto schema = json[ns];
+	auto person = schema[U("Person")];
+	VERIFY_ARE_EQUAL(person[U("$Kind")].as_string(), U("EntityType"));
+	VERIFY_ARE_EQUAL(person[U("$Key")].size(), 1);
+	VERIFY_ARE_EQUAL(person[U("$Key")][0].as_string(), U("PersonID"));
+	VERIFY_ARE_EQUAL(person[U("FirstName")][U("$Type")].as_string(), U("Edm.String"));
+	VERIFY_IS_FALSE(person[U("FirstName")].has_field(U("$Nullable")));
+	VERIFY_ARE_EQUAL(person[U("HomeAddress")][U("$Type")].as_string(), ns + U(".Address"));
+	VERIFY_IS_TRUE(person[U("Numbers")][U("$Collection")].as_bool());
+	VERIFY_ARE_EQUAL(person[U("Numbers")][U("$Type")].as_string(), U("Edm.String"));
+	VERIFY_ARE_EQUAL(person[U("Parent")][U("$Kind")].as_string(), U("NavigationProperty"));
+	VERIFY_ARE_EQUAL(person[U("Parent")][U("$Type")].as_string(), ns + U(".Person"));
+
+	VERIFY_IS_TRUE(schema[U("Product")][U("NullPicture")][U("$Nullable")].as_bool());
+
+	// Derived types inherit their key.
+	auto customer = schema[U("Customer")];
+	VERIFY_IS_FALSE(customer.has_field(U("$Key")));
+	VERIFY_ARE_EQUAL(customer[U("Orders")][U("$Kind")].as_string(), U("NavigationProperty"));
+	VERIFY_IS_TRUE(customer[U("Orders")][U("$Collection")].as_bool());
+	VERIFY_ARE_EQUAL(customer[U("Orders")][U("$Type")].as_string(), ns + U(".Order"));
+
+	auto access_level = schema[U("AccessLevel")];
+	VERIFY_ARE_EQUAL(access_level[U("$Kind")].as_string(), U("EnumType"));
+	VERIFY_IS_TRUE(access_level[U("$IsFlags")].as_bool());
+	VERIFY_ARE_EQUAL(access_level[U("ReadWrite")].as_integer(), 3);
+
+	auto function = schema[U("GetDefaultColor")];
+	VERIFY_ARE_EQUAL(function.size(), 1);
+	VERIFY_ARE_EQUAL(function[0][U("$Kind")].as_string(), U("Function"));
+	VERIFY_IS_TRUE(function[0][U("$IsComposable")].as_bool());
+	VERIFY_ARE_EQUAL(function[0][U("$ReturnType")][U("$Type")].as_string(), ns + U(".Color"));
+
+	auto container = schema[U("InMemoryEntities")];
+	VERIFY_ARE_EQUAL(container[U("$Kind")].as_string(), U("EntityContainer"));
+	VERIFY_IS_TRUE(container[U("Customers")][U("$Collection")].as_bool());
+	VERIFY_ARE_EQUAL(container[U("Customers")][U("$Type")].as_string(), ns + U(".Customer"));
+	VERIFY_ARE_EQUAL(container[U("Customers")][U("$NavigationPropertyBinding")][U("Orders")].as_string(), U("Orders"));
+	VERIFY_IS_FALSE(container[U("Boss")].has_field(U("$Collection")));
+	VERIFY_ARE_EQUAL(container[U("GetDefaultColor")][U("$Function")].as_string(), ns + U(".GetDefaultColor"));
+}
+
+TEST(concurrency_annotation_round_trips)
+{
+	auto model = load_test_model();
+	auto products = model->find_container()->find_entity_set(U("Products"));
+	products->add_concurrency_property(U("Name"));
+	products->add_concurrency_property(U("UnitPrice"));
+
+	auto xml = write_csdl(model, edm_csdl_format_t::Xml);
+	VERIFY_IS_TRUE(xml.find("<Annotation Term=\"Org.OData.Core.V1.OptimisticConcurrency\">") != std::string::npos);
+	VERIFY_IS_TRUE(xml == write_with_libxml2(model));
+
+	std::istringstream stream(xml);
+	edm_model_reader reader(stream);
+	reader.parse();
+	VERIFY_IS_TRUE(reader.get_model()->find_container()->find_entity_set(U("Products"))->get_concurrency_properties() == products->get_concurrency_properties());
+	VERIFY_IS_TRUE(reader.get_model()->find_container()->find_entity_set(U("Orders"))->get_concurrency_properties().empty());
+
+	auto json = json::value::parse(edm_csdl_writer::write_model_to_string(model, edm_csdl_format_t::Json));
+	auto annotation = json[U("Microsoft.Test.OData.Services.ODataWCFService")][U("InMemoryEntities")][U("Products")][U("@Org.OData.Core.V1.OptimisticConcurrency")];
+	VERIFY_ARE_EQUAL(annotation.size(), 2);
+	VERIFY_ARE_EQUAL(annotation[0].as_string(), U("Name"));
+	VERIFY_ARE_EQUAL(annotation[1].as_string(), U("UnitPrice"));
+}
+
+TEST(json_escapes_strings)
+{
+	auto model = load_test_model();
+	model->find_enum_type(U("Color"))->add_enum_member(std::make_shared<edm_enum_member>(U("Back\\slash \"quoted\"\n\x01"), 8));
+
+	auto json = json::value::parse(edm_csdl_writer::write_model_to_string(model, edm_csdl_format_t::Json));
+	auto color = json[U("Microsoft.Test.OData.Services.ODataWCFService")][U("Color")];
+	VERIFY_ARE_EQUAL(color[U("Back\\slash \"quoted\"\n\x01")].as_integer(), 8);
+}
+
+TEST(message_writer_writes_both_formats)
+{
+	::odata::core::odata_message_writer writer(get_test_model(), uri(U("http://service-root/")));
+	VERIFY_IS_TRUE(conversions::to_utf8string(writer.write_metadata_document()) == write_with_libxml2(get_test_model()));
+	VERIFY_IS_TRUE(json::value::parse(writer.write_metadata_document(edm_csdl_format_t::Json)).has_field(U("$EntityContainer")));
+}
+
+}
+
+}}}
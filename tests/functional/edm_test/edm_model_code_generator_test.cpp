@@ -0,0 +1,178 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_model_code_generator_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/edm/edm_model_code_generator.h"
+#include "edm_model_code_generator_test_model.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+using namespace ::codegen_test::CodeGen::Test;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::string generate(std::shared_ptr<edm_model> model)
+{
+	std::ostringstream stream;
+	edm_model_code_generator generator(stream);
+	generator.write_model(model);
+	return stream.str();
+}
+
+static Product make_product()
+{
+	Product product;
+	product.Id = 7;
+	product.Name = U("Desk \"Oak\"");
+	product.Price = 12.5;
+	product.Tags.push_back(U("wood"));
+	product.Tags.push_back(U("été"));
+	product.class_ = U("furniture");
+	product.Weight = 3.25;
+	product.Enabled = true;
+	product.Size = (int64_t)1 << 40;
+	product.Color = Color::Green;
+	product.Access = (Access)((int)Access::Read | (int)Access::Write);
+	product.Shipping.Street = U("Main St");
+	product.Billing = std::make_shared<CompanyAddress>();
+	product.Billing->Street = U("Second St");
+	product.Billing->CompanyName = U("Contoso");
+	product.Warehouses.resize(2);
+	product.Warehouses[1].Street = U("Dock");
+	product.Created = ::odata::utility::datetime::from_string(U("2014-03-01T10:20:30Z"), ::odata::utility::datetime::ISO_8601);
+	product.Warranty = ::odata::utility::seconds(3600);
+	product.Thumbnail.push_back(0x01);
+	product.Thumbnail.push_back(0xff);
+	return product;
+}
+
+SUITE(edm_model_code_generator_tests)
+{
+
+TEST(generated_types_describe_their_properties)
+{
+	VERIFY_ARE_EQUAL(::odata::utility::string_t(Product::odata_type_name()), U("CodeGen.Test.Product"));
+	VERIFY_ARE_EQUAL((int)Item::odata_property_count, 4);
+	VERIFY_ARE_EQUAL((int)Product::odata_property_count, 16);
+
+	// Inherited properties come first; the geography property has no C++ type and is left out.
+	auto properties = Product::odata_properties();
+	VERIFY_ARE_EQUAL(::odata::utility::string_t(properties[0].name), U("Id"));
+	VERIFY_IS_TRUE(properties[0].is_key);
+	VERIFY_IS_FALSE(properties[0].is_nullable);
+	VERIFY_ARE_EQUAL(::odata::utility::string_t(properties[3].edm_type), U("Collection(Edm.String)"));
+	VERIFY_ARE_EQUAL(::odata::utility::string_t(properties[4].name), U("class"));
+	VERIFY_IS_FALSE(properties[4].is_key);
+	VERIFY_IS_TRUE(properties[2].is_nullable);
+	VERIFY_ARE_EQUAL(::odata::utility::string_t(properties[10].edm_type), U("CodeGen.Test.Address"));
+	VERIFY_ARE_EQUAL((int)Address::odata_property_count, 1);
+	VERIFY_ARE_EQUAL((int)CompanyAddress::odata_property_count, 2);
+
+	Item* item = new Product();
+	delete static_cast<Product*>(item);
+}
+
+TEST(round_trip_entity)
+{
+	auto product = make_product();
+	auto json = odata_codegen_to_json(product);
+	VERIFY_IS_TRUE(json.find(U("{\"Id\":7,\"Name\":\"Desk \\\"Oak\\\"\",\"Price\":12.5,")) == 0);
+	VERIFY_IS_TRUE(json.find(U("\"Color\":\"Green\",\"Access\":\"Read,Write\"")) != ::odata::utility::string_t::npos);
+	VERIFY_IS_TRUE(json.find(U("\"Related\"")) == ::odata::utility::string_t::npos);
+
+	Product read;
+	odata_codegen_from_json(json, read);
+	VERIFY_ARE_EQUAL(read.Id, 7);
+	VERIFY_ARE_EQUAL(read.Name, product.Name);
+	VERIFY_ARE_EQUAL(read.Price.value(), 12.5);
+	VERIFY_ARE_EQUAL(read.Tags.size(), 2);
+	VERIFY_ARE_EQUAL(read.Tags[1], product.Tags[1]);
+	VERIFY_ARE_EQUAL(read.class_, U("furniture"));
+	VERIFY_IS_TRUE(read.Weight == product.Weight);
+	VERIFY_IS_TRUE(read.Enabled);
+	VERIFY_ARE_EQUAL(read.Size.value(), product.Size.value());
+	VERIFY_IS_TRUE(read.Color == Color::Green);
+	VERIFY_IS_TRUE(read.Access.value() == product.Access.value());
+	VERIFY_ARE_EQUAL(read.Shipping.Street, U("Main St"));
+	VERIFY_IS_NOT_NULL(read.Billing);
+	VERIFY_ARE_EQUAL(read.Billing->CompanyName, U("Contoso"));
+	VERIFY_ARE_EQUAL(read.Warehouses.size(), 2);
+	VERIFY_ARE_EQUAL(read.Warehouses[1].Street, U("Dock"));
+	VERIFY_IS_TRUE(read.Created == product.Created);
+	VERIFY_IS_TRUE(read.Warranty == product.Warranty);
+	VERIFY_IS_TRUE(read.Thumbnail == product.Thumbnail);
+
+	VERIFY_ARE_EQUAL(odata_codegen_to_json(read), json);
+}
+
+TEST(nulls_and_unknown_members)
+{
+	Product product;
+	auto json = odata_codegen_to_json(product);
+	VERIFY_IS_TRUE(json.find(U("\"Price\":null")) != ::odata::utility::string_t::npos);
+	VERIFY_IS_TRUE(json.find(U("\"Billing\":null")) != ::odata::utility::string_t::npos);
+	VERIFY_IS_TRUE(json.find(U("\"Color\":\"Red\"")) != ::odata::utility::string_t::npos);
+
+	Product read;
+	read.Price = 1.0;
+	odata_codegen_from_json(U("{\"@odata.etag\":\"W/\\\"1\\\"\",\"Id\":3,\"Price\":null,\"Extra\":{\"a\":[1,{\"b\":null}],\"c\":\"}\"},\"Related@odata.navigationLink\":\"Products(3)/Related\",\"Color\":\"Blue\"}"), read);
+	VERIFY_ARE_EQUAL(read.Id, 3);
+	VERIFY_IS_FALSE(read.Price.has_value());
+	VERIFY_IS_TRUE(read.Color == Color::Blue);
+	VERIFY_IS_NULL(read.Billing);
+}
+
+TEST(invalid_payloads_throw)
+{
+	Product product;
+	VERIFY_THROWS(odata_codegen_from_json(U("{\"Id\":\"x\"}"), product), odata_exception);
+	VERIFY_THROWS(odata_codegen_from_json(U("{\"Id\":1"), product), odata_exception);
+	VERIFY_THROWS(odata_codegen_from_json(U("{\"Color\":\"Purple\"}"), product), odata_exception);
+	VERIFY_THROWS(odata_codegen_from_json(U("{\"Access\":\"Read\"} x"), product), odata_exception);
+	VERIFY_THROWS(odata_codegen_from_json(U("{\"Tags\":[1]}"), product), odata_exception);
+
+	product.Color = (Color)3;
+	VERIFY_THROWS(odata_codegen_to_json(product), odata_exception);
+}
+
+TEST(entity_set_response)
+{
+	std::vector<Item> items(2);
+	items[0].Id = 1;
+	items[1].Id = 2;
+
+	::odata::utility::string_t out;
+	odata_codegen_write_entity_set(out, U("http://host/service/$metadata#Items"), items);
+	VERIFY_IS_TRUE(out.find(U("{\"@odata.context\":\"http://host/service/$metadata#Items\",\"value\":[{\"Id\":1,")) == 0);
+
+	std::vector<Item> read;
+	odata_codegen_from_json(out.substr(out.find(U("["))).substr(0, out.size() - out.find(U("[")) - 1), read);
+	VERIFY_ARE_EQUAL(read.size(), 2);
+	VERIFY_ARE_EQUAL(read[1].Id, 2);
+}
+
+TEST(generator_output_is_deterministic)
+{
+	auto header = generate(get_test_model());
+	VERIFY_IS_TRUE(header == generate(get_test_model()));
+	VERIFY_IS_TRUE(header.find("namespace odata_model { namespace Microsoft { namespace Test { namespace OData { namespace Services { namespace ODataWCFService {") != std::string::npos);
+	VERIFY_IS_TRUE(header.find("struct Customer : public ::odata_model::Microsoft::Test::OData::Services::ODataWCFService::Person") != std::string::npos);
+	VERIFY_IS_TRUE(header.find("enum class AccessLevel : int32_t") != std::string::npos);
+
+	// Base types are defined before the types deriving from them.
+	VERIFY_IS_TRUE(header.find("struct Person\n") < header.find("struct Customer :"));
+	VERIFY_IS_TRUE(header.find("struct Address\n") < header.find("struct HomeAddress :"));
+}
+
+TEST(null_model_throws)
+{
+	VERIFY_THROWS(generate(nullptr), std::invalid_argument);
+}
+
+}
+
+}}}
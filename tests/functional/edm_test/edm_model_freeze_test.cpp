@@ -0,0 +1,150 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_model_freeze_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/edm/edm_model_reader.h"
+
+using namespace ::odata::edm;
+
+namespace tests { namespace functional { namespace _odata {
+
+// The shared test model stays mutable; every test freezes its own copy.
+static std::shared_ptr<edm_model> load_test_model()
+{
+	std::istringstream stream(test_model_string);
+	edm_model_reader reader(stream);
+	reader.parse();
+	return reader.get_model();
+}
+
+SUITE(edm_model_freeze_tests)
+{
+
+TEST(unfrozen_model_has_no_ids)
+{
+	auto model = load_test_model();
+	VERIFY_IS_FALSE(model->is_frozen());
+	VERIFY_ARE_EQUAL(model->get_types().size(), 0);
+	VERIFY_ARE_EQUAL(model->find_entity_type(U("Customer"))->get_id(), undefined_value);
+	VERIFY_ARE_EQUAL(model->find_entity_type(U("Customer"))->find_property(U("City"))->get_id(), undefined_value);
+}
+
+TEST(ids_are_dense_indexes)
+{
+	auto model = load_test_model();
+	model->freeze();
+	VERIFY_IS_TRUE(model->is_frozen());
+
+	const auto &types = model->get_types();
+	VERIFY_IS_TRUE(types.size() > 0);
+	for (size_t i = 0; i < types.size(); i++)
+	{
+		VERIFY_ARE_EQUAL(types[i]->get_id(), i);
+	}
+
+	const auto &properties = model->get_properties();
+	for (size_t i = 0; i < properties.size(); i++)
+	{
+		VERIFY_ARE_EQUAL(properties[i]->get_id(), i);
+	}
+
+	const auto &navigation_properties = model->get_navigation_properties();
+	VERIFY_IS_TRUE(navigation_properties.size() > 0);
+	for (size_t i = 0; i < navigation_properties.size(); i++)
+	{
+		VERIFY_ARE_EQUAL(navigation_properties[i]->get_navigation_id(), i);
+		VERIFY_ARE_EQUAL(navigation_properties[i]->get_property_type()->get_type_kind(), edm_type_kind_t::Navigation);
+	}
+
+	const auto &navigation_sources = model->get_navigation_sources();
+	for (size_t i = 0; i < navigation_sources.size(); i++)
+	{
+		VERIFY_ARE_EQUAL(navigation_sources[i]->get_id(), i);
+	}
+
+	const auto &operations = model->get_operations();
+	VERIFY_IS_TRUE(operations.size() > 0);
+	for (size_t i = 0; i < operations.size(); i++)
+	{
+		VERIFY_ARE_EQUAL(operations[i]->get_operation_id(), i);
+		VERIFY_ARE_EQUAL(types[operations[i]->get_id()], std::static_pointer_cast<edm_named_type>(operations[i]));
+	}
+}
+
+TEST(ids_resolve_back_to_model_elements)
+{
+	auto model = load_test_model();
+	model->freeze();
+
+	auto customer = model->find_entity_type(U("Customer"));
+	VERIFY_ARE_EQUAL(model->get_types()[customer->get_id()], std::static_pointer_cast<edm_named_type>(customer));
+	VERIFY_ARE_EQUAL(model->get_types()[model->find_enum_type(U("AccessLevel"))->get_id()]->get_name(), U("AccessLevel"));
+
+	auto city = customer->find_property(U("City"));
+	VERIFY_ARE_EQUAL(model->get_properties()[city->get_id()], city);
+	VERIFY_ARE_EQUAL(city->get_navigation_id(), undefined_value);
+
+	auto orders = customer->find_property(U("Orders"));
+	VERIFY_ARE_EQUAL(model->get_navigation_properties()[orders->get_navigation_id()], orders);
+
+	auto customers = model->find_container()->find_entity_set(U("Customers"));
+	VERIFY_ARE_EQUAL(model->get_navigation_sources()[customers->get_id()], std::static_pointer_cast<edm_navigation_source>(customers));
+	auto company = model->find_container()->find_singleton(U("Company"));
+	VERIFY_ARE_EQUAL(model->get_navigation_sources()[company->get_id()], std::static_pointer_cast<edm_navigation_source>(company));
+
+	// Primitive types are shared by all models and never get an identifier.
+	VERIFY_ARE_EQUAL(city->get_property_type()->get_id(), undefined_value);
+}
+
+TEST(properties_keep_declaration_order)
+{
+	auto model = load_test_model();
+	const auto &person = model->find_entity_type(U("Person"))->get_properties_vector();
+	VERIFY_ARE_EQUAL(person.size(), 9);
+	VERIFY_ARE_EQUAL(person[0]->get_name(), U("PersonID"));
+	VERIFY_ARE_EQUAL(person[1]->get_name(), U("FirstName"));
+	VERIFY_ARE_EQUAL(person[4]->get_name(), U("HomeAddress"));
+	VERIFY_ARE_EQUAL(person[8]->get_name(), U("Parent"));
+
+	auto customer = model->find_entity_type(U("Customer"));
+	customer->add_property(std::make_shared<edm_property_type>(U("City"), true, edm_primitive_type::INT32()));
+	const auto &properties = customer->get_properties_vector();
+	VERIFY_ARE_EQUAL(properties.size(), 5);
+	VERIFY_ARE_EQUAL(properties[0]->get_name(), U("City"));
+	VERIFY_ARE_EQUAL(properties[0]->get_property_type(), std::static_pointer_cast<edm_named_type>(edm_primitive_type::INT32()));
+
+	model->freeze();
+	auto first = model->get_properties()[customer->get_properties_vector()[0]->get_id()];
+	auto second = model->get_properties()[customer->get_properties_vector()[1]->get_id()];
+	VERIFY_ARE_EQUAL(second->get_id(), first->get_id() + 1);
+}
+
+TEST(frozen_model_rejects_changes)
+{
+	auto model = load_test_model();
+	model->freeze();
+
+	auto customer = model->find_entity_type(U("Customer"));
+	auto schema = model->get_schema()[0];
+	auto container = model->find_container();
+
+	VERIFY_THROWS(model->add_schema(U("Other"), U("")), std::runtime_error);
+	VERIFY_THROWS(schema->add_entity_type(std::make_shared<edm_entity_type>(U("New"), schema->get_name())), std::runtime_error);
+	VERIFY_THROWS(customer->add_property(std::make_shared<edm_property_type>(U("New"))), std::runtime_error);
+	VERIFY_THROWS(customer->add_key_property(U("City")), std::runtime_error);
+	VERIFY_THROWS(container->add_entity_set(std::make_shared<edm_entity_set>(U("New"), customer)), std::runtime_error);
+	VERIFY_THROWS(container->find_entity_set(U("Customers"))->add_navigation_source(U("Orders"), U("Orders")), std::runtime_error);
+	VERIFY_ARE_EQUAL(customer->get_properties_vector().size(), 5);
+
+	auto type_count = model->get_types().size();
+	model->freeze();
+	VERIFY_ARE_EQUAL(model->get_types().size(), type_count);
+}
+
+}
+
+}}}
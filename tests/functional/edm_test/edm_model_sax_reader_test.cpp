@@ -0,0 +1,83 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_model_sax_reader_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/edm/edm_model_sax_reader.h"
+#include "odata/edm/edm_model_snapshot.h"
+
+using namespace ::odata::edm;
+
+namespace tests { namespace functional { namespace _odata {
+
+// Snapshots are deterministic, so two models are the same when their snapshots are.
+static std::string snapshot_of(std::shared_ptr<edm_model> model)
+{
+	std::ostringstream stream;
+	edm_model_snapshot_writer writer(stream);
+	writer.write_model(model);
+	return stream.str();
+}
+
+SUITE(edm_model_sax_reader_tests)
+{
+
+TEST(builds_same_model_as_pull_reader)
+{
+	std::istringstream stream(test_model_string);
+	auto model = edm_model_sax_reader::parse(stream);
+
+	VERIFY_IS_TRUE(snapshot_of(model) == snapshot_of(get_test_model()));
+
+	auto customer = model->find_entity_type(U("Customer"));
+	VERIFY_IS_NOT_NULL(customer);
+	VERIFY_ARE_EQUAL(customer->get_base_type(), model->find_entity_type(U("Person")));
+	VERIFY_ARE_EQUAL(customer->find_property(U("City"))->get_property_type(), std::static_pointer_cast<edm_named_type>(edm_primitive_type::STRING()));
+	VERIFY_ARE_EQUAL(model->find_container()->find_entity_set(U("Customers"))->get_entity_type(), customer);
+}
+
+TEST(chunk_boundaries_do_not_matter)
+{
+	std::string csdl(test_model_string);
+	auto expected = snapshot_of(get_test_model());
+
+	size_t chunk_sizes[] = { 1, 7, 4096 };
+	for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); i++)
+	{
+		edm_model_sax_reader reader;
+		for (size_t offset = 0; offset < csdl.size(); offset += chunk_sizes[i])
+		{
+			reader.parse_chunk(csdl.data() + offset, std::min(chunk_sizes[i], csdl.size() - offset));
+		}
+		VERIFY_IS_TRUE(snapshot_of(reader.finish()) == expected);
+	}
+}
+
+TEST(byte_order_mark_is_skipped)
+{
+	std::istringstream stream(std::string("\xEF\xBB\xBF") + test_model_string);
+	auto model = edm_model_sax_reader::parse(stream, 13);
+
+	VERIFY_IS_TRUE(snapshot_of(model) == snapshot_of(get_test_model()));
+}
+
+TEST(malformed_document_throws)
+{
+	std::istringstream mismatched("<edmx:Edmx xmlns:edmx=\"http://docs.oasis-open.org/odata/ns/edmx\" Version=\"4.0\"><edmx:DataServices></edmx:Edmx>");
+	VERIFY_THROWS(edm_model_sax_reader::parse(mismatched), std::runtime_error);
+
+	edm_model_sax_reader truncated;
+	truncated.parse_chunk("<edmx:Edmx Version=\"4.0\">", 25);
+	VERIFY_THROWS(truncated.finish(), std::runtime_error);
+	VERIFY_THROWS(truncated.finish(), std::runtime_error);
+
+	std::istringstream outside_schema("<Edmx><EntityType Name=\"Orphan\"/></Edmx>");
+	VERIFY_THROWS(edm_model_sax_reader::parse(outside_schema), std::runtime_error);
+}
+
+}
+
+}}}
@@ -0,0 +1,142 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_model_snapshot_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/edm/edm_model_snapshot.h"
+#include "odata/core/odata_uri_parser.h"
+#include <cstdio>
+
+using namespace ::odata::edm;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::string write_snapshot(std::shared_ptr<edm_model> model)
+{
+	std::ostringstream stream;
+	edm_model_snapshot_writer writer(stream);
+	writer.write_model(model);
+	return stream.str();
+}
+
+static std::shared_ptr<edm_model> read_snapshot(const std::string& snapshot)
+{
+	edm_model_snapshot_reader reader(snapshot.data(), snapshot.size());
+	return reader.read_model();
+}
+
+SUITE(edm_model_snapshot_tests)
+{
+
+TEST(round_trip_is_byte_identical)
+{
+	auto snapshot = write_snapshot(get_test_model());
+	VERIFY_ARE_EQUAL(snapshot.compare(0, 4, "ODMS"), 0);
+
+	auto loaded = read_snapshot(snapshot);
+	VERIFY_IS_NOT_NULL(loaded);
+	VERIFY_IS_TRUE(write_snapshot(loaded) == snapshot);
+	VERIFY_IS_TRUE(write_snapshot(get_test_model()) == snapshot);
+}
+
+TEST(loaded_model_is_resolved)
+{
+	auto model = read_snapshot(write_snapshot(get_test_model()));
+	VERIFY_ARE_EQUAL(model->get_version(), get_test_model()->get_version());
+
+	auto customer = model->find_entity_type(U("Customer"));
+	VERIFY_IS_NOT_NULL(customer);
+	VERIFY_ARE_EQUAL(customer->get_base_type(), model->find_entity_type(U("Person")));
+	VERIFY_ARE_EQUAL(customer->get_key_with_parents().size(), 1);
+	VERIFY_ARE_EQUAL(customer->get_key_with_parents()[0], U("PersonID"));
+
+	auto home_address = customer->find_property(U("HomeAddress"));
+	VERIFY_ARE_EQUAL(home_address->get_property_type(), std::static_pointer_cast<edm_named_type>(model->find_complex_type(U("Address"))));
+	VERIFY_ARE_EQUAL(customer->find_property(U("City"))->get_property_type(), std::static_pointer_cast<edm_named_type>(edm_primitive_type::STRING()));
+
+	auto numbers = std::dynamic_pointer_cast<edm_collection_type>(customer->find_property(U("Numbers"))->get_property_type());
+	VERIFY_IS_NOT_NULL(numbers);
+	VERIFY_ARE_EQUAL(numbers->get_element_type(), std::static_pointer_cast<edm_named_type>(edm_primitive_type::STRING()));
+
+	auto orders = std::dynamic_pointer_cast<edm_navigation_type>(customer->find_property(U("Orders"))->get_property_type());
+	VERIFY_IS_NOT_NULL(orders);
+	auto orders_target = std::dynamic_pointer_cast<edm_collection_type>(orders->get_navigation_type());
+	VERIFY_IS_NOT_NULL(orders_target);
+	VERIFY_ARE_EQUAL(orders_target->get_element_type(), std::static_pointer_cast<edm_named_type>(model->find_entity_type(U("Order"))));
+
+	auto container = model->find_container();
+	VERIFY_ARE_EQUAL(orders->get_binded_navigation_source(), std::static_pointer_cast<edm_navigation_source>(container->find_entity_set(U("Orders"))));
+	VERIFY_ARE_EQUAL(container->find_entity_set(U("Customers"))->get_entity_type(), customer);
+	VERIFY_ARE_EQUAL(container->find_singleton(U("Company"))->get_entity_type(), model->find_entity_type(U("Company")));
+	VERIFY_ARE_EQUAL(container->get_entity_set_vector().size(), get_test_model()->find_container()->get_entity_set_vector().size());
+
+	auto import = container->find_operation_import(U("GetDefaultColor"));
+	VERIFY_IS_NOT_NULL(import);
+	VERIFY_ARE_EQUAL(import->get_operation_type(), model->find_operation_type(U("GetDefaultColor")));
+	VERIFY_IS_TRUE(import->get_operation_type()->is_composable());
+
+	auto access_level = model->find_enum_type(U("AccessLevel"));
+	VERIFY_IS_NOT_NULL(access_level);
+	VERIFY_ARE_EQUAL(access_level->get_enum_members().size(), get_test_model()->find_enum_type(U("AccessLevel"))->get_enum_members().size());
+}
+
+TEST(loaded_model_parses_uris)
+{
+	auto model = read_snapshot(write_snapshot(get_test_model()));
+	::odata::core::odata_uri_parser parser(model);
+
+	auto uri = parser.parse_uri(::odata::utility::uri::encode_uri(U("http://service-root/Customers(1)/Orders?$filter=OrderID gt 1&$expand=OrderDetails")));
+	VERIFY_ARE_EQUAL(uri->path()->size(), 3);
+	VERIFY_ARE_EQUAL(uri->filter_clause()->range_variable()->target_type()->get_name(), U("Order"));
+	VERIFY_ARE_EQUAL(uri->filter_clause()->range_variable()->target_navigation_source()->get_name(), U("Orders"));
+}
+
+TEST(read_file_maps_snapshot)
+{
+	auto snapshot = write_snapshot(get_test_model());
+	std::string path = "edm_model_snapshot_test.odms";
+	{
+		std::ofstream file(path, std::ios::binary);
+		file.write(snapshot.data(), snapshot.size());
+	}
+
+	auto model = edm_model_snapshot_reader::read_file(path);
+	std::remove(path.c_str());
+
+	VERIFY_IS_NOT_NULL(model->find_entity_type(U("OrderDetail")));
+	VERIFY_IS_TRUE(write_snapshot(model) == snapshot);
+	VERIFY_THROWS(edm_model_snapshot_reader::read_file(path), std::runtime_error);
+}
+
+TEST(invalid_snapshots_throw)
+{
+	auto snapshot = write_snapshot(get_test_model());
+
+	auto bad_magic = snapshot;
+	bad_magic[0] = 'X';
+	VERIFY_THROWS(read_snapshot(bad_magic), std::invalid_argument);
+
+	auto bad_version = snapshot;
+	bad_version[4] = (char)(EDM_MODEL_SNAPSHOT_FORMAT_VERSION + 1);
+	VERIFY_THROWS(read_snapshot(bad_version), std::invalid_argument);
+
+	VERIFY_THROWS(read_snapshot(snapshot.substr(0, snapshot.size() - 1)), std::invalid_argument);
+	VERIFY_THROWS(read_snapshot(snapshot.substr(0, 10)), std::invalid_argument);
+	VERIFY_THROWS(read_snapshot(snapshot + "x"), std::invalid_argument);
+
+	// Truncating the body while keeping the declared size consistent must still be caught.
+	auto truncated = snapshot.substr(0, snapshot.size() - 7);
+	uint64_t body_size = truncated.size() - 20;
+	for (int i = 0; i < 8; i++)
+	{
+		truncated[12 + i] = (char)(body_size >> (8 * i));
+	}
+	VERIFY_THROWS(read_snapshot(truncated), std::invalid_argument);
+}
+
+}
+
+}}}
@@ -0,0 +1,128 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_structured_type_inheritance_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/core/odata_core.h"
+
+using namespace ::odata::edm;
+using namespace ::odata::core;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::vector<::odata::utility::string_t> property_names(const std::shared_ptr<edm_structured_type>& type)
+{
+	std::vector<::odata::utility::string_t> names;
+	const auto &properties = type->get_properties_with_parents();
+	for (auto iter = properties.cbegin(); iter != properties.cend(); ++iter)
+	{
+		names.push_back((*iter)->get_name());
+	}
+	return names;
+}
+
+static bool derives(const std::shared_ptr<edm_structured_type>& base, const std::shared_ptr<edm_structured_type>& type)
+{
+	const auto &derived = base->get_derived_types();
+	return std::find(derived.begin(), derived.end(), type.get()) != derived.end();
+}
+
+SUITE(edm_structured_type_inheritance_tests)
+{
+
+TEST(test_model_properties_are_flattened_base_first)
+{
+	auto model = get_test_model();
+	auto person = model->find_entity_type(U("Person"));
+	auto customer = model->find_entity_type(U("Customer"));
+
+	auto names = property_names(customer);
+	VERIFY_ARE_EQUAL(names.size(), 14);
+	VERIFY_ARE_EQUAL(names[0], U("PersonID"));
+	VERIFY_ARE_EQUAL(names[8], U("Parent"));
+	VERIFY_ARE_EQUAL(names[9], U("City"));
+	VERIFY_ARE_EQUAL(names[13], U("Company"));
+	VERIFY_ARE_EQUAL(property_names(person).size(), 9);
+
+	VERIFY_ARE_EQUAL(customer->find_property(U("HomeAddress")), person->find_property(U("HomeAddress")));
+	VERIFY_IS_NULL(person->find_property(U("City")));
+
+	VERIFY_ARE_EQUAL(customer->get_key_with_parents().size(), 1);
+	VERIFY_ARE_EQUAL(customer->get_key_with_parents()[0], U("PersonID"));
+
+	VERIFY_IS_TRUE(derives(person, customer));
+	VERIFY_IS_TRUE(derives(person, model->find_entity_type(U("Employee"))));
+	VERIFY_IS_TRUE(customer->get_derived_types().empty());
+}
+
+TEST(changes_to_base_types_reach_every_derived_type)
+{
+	auto root = std::make_shared<edm_entity_type>(U("Root"), U("NS"));
+	auto middle = std::make_shared<edm_entity_type>(U("Middle"), U("NS"));
+	auto leaf = std::make_shared<edm_entity_type>(U("Leaf"), U("NS"));
+	root->add_property(std::make_shared<edm_property_type>(U("Id")));
+	root->add_key_property(U("Id"));
+	middle->add_property(std::make_shared<edm_property_type>(U("Name")));
+	leaf->add_property(std::make_shared<edm_property_type>(U("Size")));
+	leaf->add_key_property(U("Size"));
+
+	leaf->set_base_type(middle);
+	middle->set_base_type(root);
+
+	VERIFY_IS_TRUE(derives(root, middle));
+	VERIFY_IS_TRUE(derives(root, leaf));
+	VERIFY_IS_TRUE(derives(middle, leaf));
+	VERIFY_ARE_EQUAL(property_names(leaf).size(), 3);
+	VERIFY_ARE_EQUAL(property_names(leaf)[0], U("Id"));
+	VERIFY_ARE_EQUAL(property_names(leaf)[2], U("Size"));
+	VERIFY_ARE_EQUAL(leaf->get_key_with_parents().size(), 2);
+	VERIFY_ARE_EQUAL(leaf->get_key_with_parents()[0], U("Size"));
+	VERIFY_ARE_EQUAL(leaf->get_key_with_parents()[1], U("Id"));
+
+	root->add_property(std::make_shared<edm_property_type>(U("Version")));
+	root->add_key_property(U("Version"));
+	VERIFY_ARE_EQUAL(property_names(leaf).size(), 4);
+	VERIFY_ARE_EQUAL(property_names(leaf)[1], U("Version"));
+	VERIFY_IS_NOT_NULL(leaf->find_property(U("Version")));
+	VERIFY_ARE_EQUAL(leaf->get_key_with_parents().size(), 3);
+
+	auto replacement = std::make_shared<edm_property_type>(U("Name"));
+	middle->add_property(replacement);
+	VERIFY_ARE_EQUAL(leaf->find_property(U("Name")), replacement);
+	VERIFY_ARE_EQUAL(property_names(leaf).size(), 4);
+
+	VERIFY_THROWS(root->set_base_type(leaf), std::invalid_argument);
+
+	leaf->set_base_type(nullptr);
+	VERIFY_IS_FALSE(derives(root, leaf));
+	VERIFY_IS_FALSE(derives(middle, leaf));
+	VERIFY_ARE_EQUAL(property_names(leaf).size(), 1);
+	VERIFY_IS_NULL(leaf->find_property(U("Id")));
+	VERIFY_ARE_EQUAL(leaf->get_key_with_parents().size(), 1);
+}
+
+TEST(destroyed_types_leave_the_derived_sets)
+{
+	auto root = std::make_shared<edm_complex_type>(U("Root"), U("NS"));
+	{
+		auto derived = std::make_shared<edm_complex_type>(U("Derived"), U("NS"));
+		derived->set_base_type(root);
+		VERIFY_ARE_EQUAL(root->get_derived_types().size(), 1);
+	}
+	VERIFY_IS_TRUE(root->get_derived_types().empty());
+}
+
+TEST(entity_key_strings_use_inherited_keys)
+{
+	auto entity = std::make_shared<odata_entity_value>(get_test_model()->find_entity_type(U("Customer")));
+	entity->set_value(U("PersonID"), (int32_t)42);
+	VERIFY_ARE_EQUAL(entity->get_entity_key_string(), U("(42)"));
+	VERIFY_ARE_EQUAL(odata_entity_model_builder::get_entity_key_value_string(entity), U("42"));
+}
+
+}
+
+}}}
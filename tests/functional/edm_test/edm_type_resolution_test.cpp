@@ -0,0 +1,167 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="edm_type_resolution_test.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "../odata_tests.h"
+#include "odata/edm/odata_edm.h"
+#include "odata/edm/edm_model_reader.h"
+#include "odata/edm/edm_model_sax_reader.h"
+#include "odata/edm/edm_model_snapshot.h"
+#include <thread>
+
+using namespace ::odata::edm;
+
+namespace tests { namespace functional { namespace _odata {
+
+static std::shared_ptr<edm_model> load_model(const std::string& csdl, edm_type_resolution_t resolution)
+{
+	std::istringstream stream(csdl);
+	edm_model_reader reader(stream, resolution);
+	reader.parse();
+	return reader.get_model();
+}
+
+// Snapshots are deterministic and read every property, so they also force lazy resolution.
+static std::string snapshot_of(std::shared_ptr<edm_model> model)
+{
+	std::ostringstream stream;
+	edm_model_snapshot_writer writer(stream);
+	writer.write_model(model);
+	return stream.str();
+}
+
+// Two schemas whose entity types derive and navigate across them, with enough types for several worker batches.
+static std::string generate_csdl(int entity_count)
+{
+	std::ostringstream csdl;
+	csdl << "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+		<< "<edmx:Edmx xmlns:edmx=\"http://docs.oasis-open.org/odata/ns/edmx\" Version=\"4.0\"><edmx:DataServices>"
+		<< "<Schema xmlns=\"http://docs.oasis-open.org/odata/ns/edm\" Namespace=\"Test.Base\">"
+		<< "<EntityType Name=\"Root\"><Key><PropertyRef Name=\"Id\"/></Key>"
+		<< "<Property Name=\"Id\" Type=\"Edm.Int32\" Nullable=\"false\"/>"
+		<< "<Property Name=\"Location\" Type=\"Test.Base.Point\"/></EntityType>"
+		<< "<ComplexType Name=\"Point\"><Property Name=\"X\" Type=\"Edm.Double\"/></ComplexType>"
+		<< "</Schema>"
+		<< "<Schema xmlns=\"http://docs.oasis-open.org/odata/ns/edm\" Namespace=\"Test.Derived\">";
+	for (int i = 0; i < entity_count; i++)
+	{
+		csdl << "<EntityType Name=\"Entity" << i << "\" BaseType=\"Test.Base.Root\">"
+			<< "<Property Name=\"Points\" Type=\"Collection(Test.Base.Point)\"/>"
+			<< "<NavigationProperty Name=\"Next\" Type=\"Test.Derived.Entity" << (i + 1) % entity_count << "\"/>"
+			<< "<NavigationProperty Name=\"All\" Type=\"Collection(Test.Derived.Entity" << i << ")\"/>"
+			<< "</EntityType>";
+	}
+	csdl << "<EntityContainer Name=\"Container\">";
+	for (int i = 0; i < entity_count; i++)
+	{
+		csdl << "<EntitySet Name=\"Set" << i << "\" EntityType=\"Test.Derived.Entity" << i << "\">"
+			<< "<NavigationPropertyBinding Path=\"Next\" Target=\"Set" << (i + 1) % entity_count << "\"/></EntitySet>";
+	}
+	csdl << "</EntityContainer></Schema></edmx:DataServices></edmx:Edmx>";
+	return csdl.str();
+}
+
+SUITE(edm_type_resolution_tests)
+{
+
+TEST(all_modes_build_the_same_test_model)
+{
+	auto expected = snapshot_of(get_test_model());
+	VERIFY_IS_TRUE(snapshot_of(load_model(test_model_string, edm_type_resolution_t::Parallel)) == expected);
+	VERIFY_IS_TRUE(snapshot_of(load_model(test_model_string, edm_type_resolution_t::Lazy)) == expected);
+
+	std::istringstream stream(test_model_string);
+	VERIFY_IS_TRUE(snapshot_of(edm_model_sax_reader::parse(stream, 4096, edm_type_resolution_t::Parallel)) == expected);
+}
+
+TEST(parallel_resolution_matches_eager_resolution)
+{
+	auto csdl = generate_csdl(500);
+	auto eager = load_model(csdl, edm_type_resolution_t::Eager);
+	auto expected = snapshot_of(eager);
+	for (int i = 0; i < 3; i++)
+	{
+		VERIFY_IS_TRUE(snapshot_of(load_model(csdl, edm_type_resolution_t::Parallel)) == expected);
+	}
+
+	auto model = load_model(csdl, edm_type_resolution_t::Parallel);
+	auto entity = model->find_entity_type(U("Test.Derived.Entity7"));
+	auto next = std::dynamic_pointer_cast<edm_navigation_type>(entity->find_property(U("Next"))->get_property_type());
+	VERIFY_ARE_EQUAL(next->get_navigation_type(), std::static_pointer_cast<edm_named_type>(model->find_entity_type(U("Test.Derived.Entity8"))));
+	VERIFY_ARE_EQUAL(next->get_binded_navigation_source(), std::static_pointer_cast<edm_navigation_source>(model->find_container()->find_entity_set(U("Set8"))));
+
+	// Collection navigation targets are only held weakly by the navigation type.
+	auto all = std::dynamic_pointer_cast<edm_navigation_type>(entity->find_property(U("All"))->get_property_type());
+	VERIFY_IS_NOT_NULL(all->get_navigation_type());
+}
+
+TEST(lazy_types_resolve_on_first_access)
+{
+	auto model = load_model(test_model_string, edm_type_resolution_t::Lazy);
+
+	// Bindings and base types are in place before any property is read.
+	auto customer = model->find_entity_type(U("Customer"));
+	VERIFY_ARE_EQUAL(customer->get_base_type(), model->find_entity_type(U("Person")));
+	VERIFY_ARE_EQUAL(model->find_container()->find_entity_set(U("Customers"))->get_entity_type(), customer);
+
+	// Inherited properties belong to the base type, which is resolved along with the derived one.
+	auto home_address = customer->find_property(U("HomeAddress"));
+	VERIFY_ARE_EQUAL(home_address->get_property_type(), std::static_pointer_cast<edm_named_type>(model->find_complex_type(U("Address"))));
+
+	auto orders = std::dynamic_pointer_cast<edm_navigation_type>(customer->find_property(U("Orders"))->get_property_type());
+	VERIFY_IS_NOT_NULL(orders);
+	VERIFY_ARE_EQUAL(orders->get_binded_navigation_source(), std::static_pointer_cast<edm_navigation_source>(model->find_container()->find_entity_set(U("Orders"))));
+	auto orders_target = std::dynamic_pointer_cast<edm_collection_type>(orders->get_navigation_type());
+	VERIFY_IS_NOT_NULL(orders_target);
+	VERIFY_ARE_EQUAL(orders_target->get_element_type(), std::static_pointer_cast<edm_named_type>(model->find_entity_type(U("Order"))));
+}
+
+TEST(lazy_resolution_is_safe_across_threads)
+{
+	const int entity_count = 200;
+	auto csdl = generate_csdl(entity_count);
+	auto expected = snapshot_of(load_model(csdl, edm_type_resolution_t::Eager));
+	auto model = load_model(csdl, edm_type_resolution_t::Lazy);
+
+	std::atomic<int> mismatches(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			for (int i = 0; i < entity_count; i++)
+			{
+				auto name = U("Test.Derived.Entity") + ::odata::utility::conversions::print_string((i * 7 + t * 13) % entity_count);
+				auto entity = model->find_entity_type(name);
+				auto location = entity->find_property(U("Location"));
+				if (!location || location->get_property_type() != std::static_pointer_cast<edm_named_type>(model->find_complex_type(U("Test.Base.Point"))))
+				{
+					mismatches++;
+				}
+			}
+		}));
+	}
+	for (auto iter = threads.begin(); iter != threads.end(); ++iter)
+	{
+		iter->join();
+	}
+
+	VERIFY_ARE_EQUAL(mismatches.load(), 0);
+	VERIFY_IS_TRUE(snapshot_of(model) == expected);
+}
+
+TEST(lazy_model_can_be_frozen)
+{
+	auto model = load_model(test_model_string, edm_type_resolution_t::Lazy);
+	model->freeze();
+
+	auto city = model->find_entity_type(U("Customer"))->find_property(U("City"));
+	VERIFY_ARE_EQUAL(city->get_property_type(), std::static_pointer_cast<edm_named_type>(edm_primitive_type::STRING()));
+	VERIFY_IS_TRUE(snapshot_of(model) == snapshot_of(get_test_model()));
+}
+
+}
+
+}}}
@@ -0,0 +1,65 @@
+﻿//---------------------------------------------------------------------
+// <copyright file="odata_csdl_snapshot.cpp" company="Microsoft">
+//      Copyright (C) Microsoft Corporation. All rights reserved. See License.txt in the project root for license information.
+// </copyright>
+//---------------------------------------------------------------------
+
+#include "odata/edm/edm_model_reader.h"
+#include "odata/edm/edm_model_snapshot.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+// Usage: odata-csdl-snapshot <csdl file> <snapshot file>
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		std::cerr << "usage: " << argv[0] << " <csdl file> <snapshot file>" << std::endl;
+		return 2;
+	}
+
+	try
+	{
+		std::ifstream csdl(argv[1]);
+		if (!csdl)
+		{
+			std::cerr << "cannot open " << argv[1] << std::endl;
+			return 1;
+		}
+
+		::odata::edm::edm_model_reader reader(csdl);
+		reader.parse();
+		if (reader.get_model()->get_schema().empty())
+		{
+			std::cerr << "no schema found in " << argv[1] << std::endl;
+			return 1;
+		}
+
+		// Write next to the destination first so a failed run never leaves a truncated snapshot behind.
+		std::string temporary = std::string(argv[2]) + ".tmp";
+		{
+			std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+			::odata::edm::edm_model_snapshot_writer writer(output);
+			writer.write_model(reader.get_model());
+			if (!output.flush())
+			{
+				std::cerr << "cannot write " << temporary << std::endl;
+				return 1;
+			}
+		}
+
+		if (std::rename(temporary.c_str(), argv[2]) != 0)
+		{
+			std::cerr << "cannot write " << argv[2] << std::endl;
+			return 1;
+		}
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << argv[1] << ": " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}